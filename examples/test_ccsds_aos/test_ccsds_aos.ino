@@ -0,0 +1,252 @@
+/*
+  Self test of the AOS transfer frames
+
+  Compares the headers of a frame with a known encoding, transfers
+  space packets in M_PDUs across several frames with an insert zone,
+  detects a lost frame and checks the bit count of B_PDUs and the
+  idle frames. Prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define PACKET_COUNT  60
+
+
+#if AOS_TF_TOTAL_SIZE > 0
+class TestPacketReceiver : public SpacePacketActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  uint16_t mu16_Wrong = 0;
+  uint16_t mu16_NextSequence = 0;
+
+  void onSpacePacketReceived(const uint8_t u8_PacketType, const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                             const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                             const uint8_t *pu8_Data, const uint16_t u16_DataSize)
+  {
+    bool b_Ok = (u16_APID==0x55) && (u16_SequenceCount==mu16_NextSequence);
+
+    for(uint16_t i=0; b_Ok && (i<u16_DataSize); i++)
+      b_Ok = (pu8_Data[i]==(uint8_t)(i+u16_SequenceCount));
+    mu16_NextSequence = u16_SequenceCount+1;
+    mu16_Count++;
+    if(!b_Ok)
+      mu16_Wrong++;
+  }
+};
+
+
+class TestFrameReceiver : public TransferframeAosActionInterface
+{
+public:
+  MpduExtractor *mp_Extractor = nullptr;
+  uint32_t mu32_DropFrame = 0xffffffff;
+  uint16_t mu16_Count = 0;
+  uint16_t mu16_Wrong = 0;
+  uint16_t mu16_IdleCount = 0;
+  uint32_t mu32_Bits = 0;
+
+  void onTransferframeAosReceived(const uint8_t u8_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                                  const uint32_t u32_VcFrameCount, const bool b_ReplayFlag,
+                                  const uint8_t *pu8_InsertZone, const uint8_t u8_InsertZoneSize,
+                                  const uint8_t *pu8_DataField, const uint16_t u16_DataFieldSize,
+                                  const uint32_t u32_OCF)
+  {
+    const uint8_t *pu8_Bits;
+    uint32_t u32_BitCount;
+
+    mu16_Count++;
+    if((u8_SpacecraftID!=0x9a) || (u8_InsertZoneSize!=2) || (pu8_InsertZone[0]!=0xab) || (pu8_InsertZone[1]!=0xcd))
+      mu16_Wrong++;
+    if(u8_VirtualChannelID==1)
+    {
+      if(u32_OCF!=0x11223344)
+        mu16_Wrong++;
+      if(u32_VcFrameCount!=mu32_DropFrame)
+        mp_Extractor->process(u32_VcFrameCount, pu8_DataField, u16_DataFieldSize);
+    }
+    else if(u8_VirtualChannelID==2)
+    {
+      if(TransferframeAos::getBitstream(pu8_DataField, u16_DataFieldSize, &pu8_Bits, &u32_BitCount)==0)
+        mu32_Bits += u32_BitCount;
+    }
+    else if(u8_VirtualChannelID==63)
+      mu16_IdleCount++;
+  }
+};
+#endif
+
+
+uint16_t g_Failed = 0;
+
+#if AOS_TF_TOTAL_SIZE > 0
+uint8_t g_Packets[PACKET_COUNT*(6+100)];
+uint8_t g_Stream[3*(4+AOS_TF_TOTAL_SIZE)];
+uint8_t g_Frame[AOS_TF_TOTAL_SIZE];
+#endif
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+#if AOS_TF_TOTAL_SIZE > 0
+/**
+ * @brief Sends the packets in M_PDUs of VC 1, each followed by a B_PDU of VC 2 and an idle frame
+ *
+ * The frames are fed to the receiver in chunks of 13 bytes.
+ */
+uint16_t transfer(TransferframeAos &aos, const uint32_t u32_PacketSize, const uint16_t u16_ZoneSize)
+{
+  const uint8_t au8_InsertZone[] = {0xab, 0xcd};
+  uint32_t u32_Pos = 0;
+  uint32_t u32_NextPacket = 0;
+  uint32_t u32_VcFrameCount = 0xfffffe;   // wraps around after two frames
+  uint16_t u16_Frames = 0;
+
+  while(u32_Pos<u32_PacketSize)
+  {
+    uint16_t u16_Size = (uint16_t)((u32_PacketSize-u32_Pos>u16_ZoneSize)?u16_ZoneSize:(u32_PacketSize-u32_Pos));
+    uint16_t u16_FirstHdr = TransferframeAos::NoFirstHdr;
+    uint32_t u32_Size = 0;
+
+    while(u32_NextPacket<u32_Pos)
+      u32_NextPacket += 7+((g_Packets[u32_NextPacket+4]<<8)|g_Packets[u32_NextPacket+5]);
+    if(u32_NextPacket<u32_Pos+u16_Size)
+      u16_FirstHdr = (uint16_t)(u32_NextPacket-u32_Pos);
+
+    for(uint8_t f=0; f<3; f++)
+    {
+      g_Stream[u32_Size++] = 0x1a; g_Stream[u32_Size++] = 0xcf; g_Stream[u32_Size++] = 0xfc; g_Stream[u32_Size++] = 0x1d;
+      if(f==0)
+        u32_Size += TransferframeAos::createMpdu(&g_Stream[u32_Size], sizeof(g_Stream)-u32_Size, 0x9a, 1, u32_VcFrameCount,
+                                                 u16_FirstHdr, &g_Packets[u32_Pos], u16_Size, 0x11223344, au8_InsertZone, 2);
+      else if(f==1)
+        u32_Size += TransferframeAos::createBpdu(&g_Stream[u32_Size], sizeof(g_Stream)-u32_Size, 0x9a, 2, u32_VcFrameCount,
+                                                 g_Packets, (uint16_t)(u16_Frames%u16_ZoneSize), 0, au8_InsertZone, 2);
+      else
+        u32_Size += TransferframeAos::createIdle(&g_Stream[u32_Size], sizeof(g_Stream)-u32_Size, 0x9a, u32_VcFrameCount,
+                                                 0, au8_InsertZone, 2);
+    }
+    for(uint32_t u32_Chunk=0; u32_Chunk<u32_Size; u32_Chunk+=13)
+      aos.process(&g_Stream[u32_Chunk], (uint16_t)((u32_Size-u32_Chunk<13)?(u32_Size-u32_Chunk):13));
+
+    u32_VcFrameCount = (u32_VcFrameCount+1)&0xffffff;
+    u32_Pos += u16_Size;
+    u16_Frames++;
+  }
+  return u16_Frames;
+}
+#endif
+
+
+void setup() {
+  Serial.begin(9600);
+
+#if AOS_TF_TOTAL_SIZE > 0
+  const uint16_t u16_ZoneSize = TransferframeAos::getDataZoneSize(2);
+  const uint8_t *pu8_Bits;
+  uint32_t u32_BitCount;
+  uint32_t u32_PacketSize = 0;
+  uint32_t u32_Size;
+  uint8_t au8_Data[100];
+
+  // known headers: SCID 0x9a, VC 2, VC frame count 0x123456, B_PDU with 10 bytes (bits 0..79 valid)
+  for(uint8_t i=0; i<10; i++)
+    au8_Data[i] = i;
+  u32_Size = TransferframeAos::createBpdu(g_Frame, sizeof(g_Frame), 0x9a, 2, 0x123456, au8_Data, 10);
+  check("frame size", u32_Size==AOS_TF_TOTAL_SIZE);
+  check("known primary header", (g_Frame[0]==0x66) && (g_Frame[1]==0x82) && (g_Frame[2]==0x12) && (g_Frame[3]==0x34)
+                                && (g_Frame[4]==0x56) && (g_Frame[5]==0x00));
+  check("known B_PDU header", (g_Frame[6]==0x00) && (g_Frame[7]==0x4f) && (g_Frame[8]==0x00) && (g_Frame[17]==0x09));
+  check("B_PDU bit count", (TransferframeAos::getBitstream(&g_Frame[6], (uint16_t)(TransferframeAos::getDataZoneSize()+2),
+                                                           &pu8_Bits, &u32_BitCount)==0)
+                           && (u32_BitCount==80) && (pu8_Bits==&g_Frame[8]));
+
+  // a full B_PDU is all valid, an empty one is idle
+  for(uint16_t i=0; i<sizeof(g_Packets); i++)
+    g_Packets[i] = (uint8_t)i;
+  TransferframeAos::createBpdu(g_Frame, sizeof(g_Frame), 0x9a, 2, 0, g_Packets, TransferframeAos::getDataZoneSize());
+  check("full B_PDU", ((((g_Frame[6]&0x3f)<<8)|g_Frame[7])==TransferframeAos::BitstreamAllValid)
+                      && (TransferframeAos::getBitstream(&g_Frame[6], (uint16_t)(TransferframeAos::getDataZoneSize()+2),
+                                                         &pu8_Bits, &u32_BitCount)==0)
+                      && (u32_BitCount==8UL*TransferframeAos::getDataZoneSize()));
+  TransferframeAos::createBpdu(g_Frame, sizeof(g_Frame), 0x9a, 2, 0, g_Packets, 0);
+  check("idle B_PDU", ((((g_Frame[6]&0x3f)<<8)|g_Frame[7])==TransferframeAos::BitstreamIdle)
+                      && (TransferframeAos::getBitstream(&g_Frame[6], (uint16_t)(TransferframeAos::getDataZoneSize()+2),
+                                                         &pu8_Bits, &u32_BitCount)==0)
+                      && (u32_BitCount==0));
+  check("B_PDU too large", TransferframeAos::createBpdu(g_Frame, sizeof(g_Frame), 0x9a, 2, 0, g_Packets,
+                                                        (uint16_t)(TransferframeAos::getDataZoneSize()+1))==0);
+
+  // space packets of 1..100 bytes, spanning several frames
+  for(uint16_t s=0; s<PACKET_COUNT; s++)
+  {
+    uint16_t u16_Size = (uint16_t)(1+(s*37)%100);
+
+    for(uint16_t i=0; i<u16_Size; i++)
+      au8_Data[i] = (uint8_t)(i+s);
+    u32_PacketSize += SpacePacket::create(&g_Packets[u32_PacketSize], sizeof(g_Packets)-u32_PacketSize,
+                                          SpacePacket::PacketType::TM, SpacePacket::SequenceFlags::Unsegmented,
+                                          0x55, s, au8_Data, u16_Size);
+  }
+
+  {
+    TestPacketReceiver packetReceiver;
+    SpacePacket sp(&packetReceiver);
+    MpduExtractor extractor(&sp);
+    TestFrameReceiver frameReceiver;
+    TransferframeAos aos(&frameReceiver);
+    uint16_t u16_Frames;
+
+    frameReceiver.mp_Extractor = &extractor;
+    aos.setInsertZoneSize(2);
+    u16_Frames = transfer(aos, u32_PacketSize, u16_ZoneSize);
+    check("frames received", (frameReceiver.mu16_Count==3*u16_Frames) && (frameReceiver.mu16_Wrong==0));
+    check("packets received", (packetReceiver.mu16_Count==PACKET_COUNT) && (packetReceiver.mu16_Wrong==0));
+    check("no lost frames across the wrap-around", extractor.getLostFrameCount()==0);
+    check("idle frames", frameReceiver.mu16_IdleCount==u16_Frames);
+    check("B_PDU bits", frameReceiver.mu32_Bits==8UL*(uint32_t)((u16_Frames-1)*u16_Frames/2));
+    check("no sync or checksum errors", (aos.getSyncErrorCount()==0) && (aos.getChecksumErrorCount()==0));
+  }
+
+  // the second M_PDU is lost: the packets in it are lost, the extraction resumes at the next first header
+  {
+    TestPacketReceiver packetReceiver;
+    SpacePacket sp(&packetReceiver);
+    MpduExtractor extractor(&sp);
+    TestFrameReceiver frameReceiver;
+    TransferframeAos aos(&frameReceiver);
+
+    frameReceiver.mp_Extractor = &extractor;
+    frameReceiver.mu32_DropFrame = 0xffffff;
+    aos.setInsertZoneSize(2);
+    transfer(aos, u32_PacketSize, u16_ZoneSize);
+    check("lost frame detected", extractor.getLostFrameCount()==1);
+    check("packets after the lost frame", (packetReceiver.mu16_Count>0) && (packetReceiver.mu16_Count<PACKET_COUNT)
+                                          && (packetReceiver.mu16_NextSequence==PACKET_COUNT));
+  }
+#else
+  check("AOS disabled (configAOS_TF_TOTAL_SIZE)", true);
+#endif
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
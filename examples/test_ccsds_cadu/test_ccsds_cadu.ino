@@ -0,0 +1,167 @@
+/*
+  Self test of the CADU production
+
+  Creates CADUs with and without Reed-Solomon coding and randomization,
+  compares them with the separate coding steps, receives them with a TM
+  transfer frame object and prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define FRAME_COUNT   4
+#define DATA_SIZE     20
+
+// the check symbols of the largest interleaving depth
+#define MAX_PARITY    (TF_RS_MAX_INTERLEAVE*32)
+
+
+class TestReceiver : public TransferframeTmActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  uint16_t mu16_Wrong = 0;
+
+  void onTransferframeTmReceived(const uint16_t u16_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                                 const uint8_t u8_MasterChannelFrameCount, const uint8_t u8_VirtualChannelFrameCount,
+                                 const bool b_SecondaryHeader, const uint16_t u16_FirstHdrPtr,
+                                 const uint8_t *pu8_Data, const uint16_t u16_DataSize, const uint32_t u32_OCF)
+  {
+    bool b_Ok = (u16_SpacecraftID==0x12) && (u8_VirtualChannelID==2) && (u32_OCF==0x01020304UL+u8_VirtualChannelFrameCount);
+
+    for(uint8_t i=0; b_Ok && (i<DATA_SIZE); i++)
+      b_Ok = (pu8_Data[i]==(uint8_t)(u8_VirtualChannelFrameCount*11+i));
+    mu16_Count++;
+    if(!b_Ok)
+      mu16_Wrong++;
+  }
+};
+
+
+uint16_t g_Failed = 0;
+
+uint8_t g_Data[FRAME_COUNT][DATA_SIZE];
+uint8_t g_Batch[FRAME_COUNT*(4+TM_TF_TOTAL_SIZE+MAX_PARITY)];
+uint8_t g_Reference[4+TM_TF_TOTAL_SIZE+MAX_PARITY];
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+// creates the CADUs in a batch and compares them with the separate coding steps and with single CADUs
+void checkCadus(const char *s_Name, const uint8_t u8_InterleaveDepth, const bool b_Randomize)
+{
+  const uint8_t au8_Asm[] = {0x1a, 0xcf, 0xfc, 0x1d};
+  Cadu::Frame aS_Frames[FRAME_COUNT];
+  uint32_t u32_CaduSize = Cadu::getSize(u8_InterleaveDepth);
+  uint32_t u32_Size;
+  bool b_Ok;
+
+  for(uint8_t f=0; f<FRAME_COUNT; f++)
+  {
+    aS_Frames[f].u8_VirtualChannelID = 2;
+    aS_Frames[f].u8_MasterChannelFrameCount = f;
+    aS_Frames[f].u8_VirtualChannelFrameCount = f;
+    aS_Frames[f].u16_FirstHdrPtr = 0;
+    aS_Frames[f].pu8_Data = g_Data[f];
+    aS_Frames[f].u16_DataSize = DATA_SIZE;
+    aS_Frames[f].u32_OCF = 0x01020304UL+f;
+  }
+
+  u32_Size = Cadu::createBatch(g_Batch, sizeof(g_Batch), 0x12, aS_Frames, FRAME_COUNT, u8_InterleaveDepth, b_Randomize);
+  b_Ok = (u32_CaduSize==4UL+TM_TF_TOTAL_SIZE+u8_InterleaveDepth*32UL) && (u32_Size==FRAME_COUNT*u32_CaduSize);
+
+  for(uint8_t f=0; b_Ok && (f<FRAME_COUNT); f++)
+  {
+    // separate steps: sync marker, frame, check symbols, randomization
+    memcpy(g_Reference, au8_Asm, 4);
+    TransferframeTm::create(&g_Reference[4], sizeof(g_Reference)-4, 0x12, 2, f, f, 0, g_Data[f], DATA_SIZE, 0x01020304UL+f);
+#if TF_RS_MAX_INTERLEAVE > 0
+    if(u8_InterleaveDepth)
+      ReedSolomon::encode(&g_Reference[4], sizeof(g_Reference)-4, TM_TF_TOTAL_SIZE, u8_InterleaveDepth);
+#endif
+#if TF_USE_RANDOMIZER == 1
+    if(b_Randomize)
+      Randomizer::apply(Randomizer::TmSequence, &g_Reference[4], u32_CaduSize-4);
+#endif
+    b_Ok = (memcmp(&g_Batch[f*u32_CaduSize], g_Reference, u32_CaduSize)==0);
+  }
+  check(s_Name, b_Ok);
+
+  // single CADU
+  u32_Size = Cadu::create(g_Reference, sizeof(g_Reference), 0x12, 2, 1, 1, 0, g_Data[1], DATA_SIZE, 0x01020305UL,
+                          u8_InterleaveDepth, b_Randomize);
+  check("single CADU matches the batch", (u32_Size==u32_CaduSize) && (memcmp(&g_Batch[u32_CaduSize], g_Reference, u32_CaduSize)==0));
+
+  // reception
+  {
+    TestReceiver receiver;
+    TransferframeTm tm(&receiver);
+
+#if TF_RS_MAX_INTERLEAVE > 0
+    tm.setReedSolomon(u8_InterleaveDepth);
+    // a few symbol errors in each CADU
+    for(uint8_t f=0; u8_InterleaveDepth && (f<FRAME_COUNT); f++)
+    {
+      g_Batch[f*u32_CaduSize+4+f*3] ^= 0x5a;
+      g_Batch[f*u32_CaduSize+20] ^= 0xff;
+    }
+#endif
+    if(b_Randomize)
+      tm.setRandomization(true);
+    tm.process(g_Batch, (uint16_t)(FRAME_COUNT*u32_CaduSize));
+    check("CADUs received", (receiver.mu16_Count==FRAME_COUNT) && (receiver.mu16_Wrong==0));
+  }
+}
+
+
+void setup() {
+  Serial.begin(9600);
+
+  for(uint8_t f=0; f<FRAME_COUNT; f++)
+  {
+    for(uint8_t i=0; i<DATA_SIZE; i++)
+      g_Data[f][i] = (uint8_t)(f*11+i);
+  }
+
+  checkCadus("plain CADUs", 0, false);
+#if TF_USE_RANDOMIZER == 1
+  checkCadus("randomized CADUs", 0, true);
+#endif
+#if TF_RS_MAX_INTERLEAVE > 0
+  {
+    // the smallest interleaving depth for the frame size
+    uint8_t u8_Depth = 1;
+    while((u8_Depth<TF_RS_MAX_INTERLEAVE) && ((TM_TF_TOTAL_SIZE>u8_Depth*223) || (TM_TF_TOTAL_SIZE%u8_Depth)))
+      u8_Depth++;
+    checkCadus("Reed-Solomon coded CADUs", u8_Depth, false);
+#if TF_USE_RANDOMIZER == 1
+    checkCadus("Reed-Solomon coded and randomized CADUs", u8_Depth, true);
+#endif
+  }
+#endif
+
+  // invalid parameters
+  check("buffer too small", Cadu::create(g_Reference, Cadu::getSize(0)-1, 0x12, 2, 0, 0, 0, g_Data[0], DATA_SIZE)==0);
+  check("empty batch rejected", Cadu::createBatch(g_Batch, sizeof(g_Batch), 0x12, nullptr, 1)==0);
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
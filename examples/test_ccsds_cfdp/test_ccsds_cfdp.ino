@@ -0,0 +1,257 @@
+/*
+  Self test of the CCSDS File Delivery Protocol
+
+  Transfers a file between two entities in the unacknowledged and in
+  the acknowledged mode with lost packets, cancels a transfer, checks
+  the checksum and the fault location of the EOF PDU and the fault of
+  an unacknowledged Finished PDU. Prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define FILE_SIZE     1000
+#define PACKET_SIZE   64
+#define APID          0x100
+#define ENTITY_A      0x000a
+#define ENTITY_B      0x000b
+
+
+class TestEntity : public CfdpActionInterface
+{
+public:
+  uint8_t *mpu8_File = nullptr;
+  uint16_t mu16_FinishedCount = 0;
+  uint8_t mu8_Condition = 0xff;
+  uint16_t mu16_FaultCount = 0;
+  uint8_t mu8_FaultCondition = 0xff;
+
+  uint8_t *onCfdpMetadataReceived(const uint16_t u16_SourceEntityID, const uint32_t u32_TransactionSeqNr,
+                                  const uint8_t *pu8_SourceFileName, const uint8_t u8_SourceFileNameLength,
+                                  const uint8_t *pu8_DestFileName, const uint8_t u8_DestFileNameLength,
+                                  const uint32_t u32_FileSize)
+  {
+    if((u16_SourceEntityID!=ENTITY_A) || (u32_FileSize>FILE_SIZE) || (u8_DestFileNameLength!=5)
+       || (memcmp(pu8_DestFileName, "b.bin", 5)!=0))
+      return nullptr;
+    return mpu8_File;
+  }
+
+  void onCfdpTransactionFinished(const bool b_Sender, const uint16_t u16_SourceEntityID,
+                                 const uint32_t u32_TransactionSeqNr, const uint8_t u8_ConditionCode,
+                                 const uint32_t u32_FileSize)
+  {
+    mu16_FinishedCount++;
+    mu8_Condition = u8_ConditionCode;
+  }
+
+  void onCfdpFault(const bool b_Sender, const uint16_t u16_SourceEntityID,
+                   const uint32_t u32_TransactionSeqNr, const uint8_t u8_ConditionCode)
+  {
+    mu16_FaultCount++;
+    mu8_FaultCondition = u8_ConditionCode;
+  }
+};
+
+
+uint16_t g_Failed = 0;
+uint16_t g_PacketCount = 0;
+
+uint8_t g_File[FILE_SIZE];
+uint8_t g_Received[FILE_SIZE];
+uint8_t g_Buffer[1024];
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+/**
+ * @brief Hands the space packets in the buffer over to the entity; every u16_DropEvery-th packet is lost
+ */
+void deliver(Cfdp &cfdp, const uint8_t *pu8_Buffer, const uint32_t u32_Size, const uint16_t u16_DropEvery)
+{
+  uint32_t u32_Pos = 0;
+
+  while(u32_Pos+SP_HEADER_SIZE<=u32_Size)
+  {
+    const uint8_t *pu8_Packet = &pu8_Buffer[u32_Pos];
+    uint16_t u16_DataLength = (uint16_t)(((pu8_Packet[4]<<8) | pu8_Packet[5])+1);
+
+    g_PacketCount++;
+    if((u16_DropEvery==0) || (g_PacketCount%u16_DropEvery!=0))
+      cfdp.onSpacePacketReceived(pu8_Packet[0]>>4, pu8_Packet[2]>>6, (uint16_t)(((pu8_Packet[0]&0x07)<<8) | pu8_Packet[1]),
+                                 (uint16_t)(((pu8_Packet[2]&0x3f)<<8) | pu8_Packet[3]), (pu8_Packet[0]&0x08)?true:false,
+                                 &pu8_Packet[SP_HEADER_SIZE], u16_DataLength);
+    u32_Pos += SP_HEADER_SIZE+u16_DataLength;
+  }
+}
+
+
+/**
+ * @brief Returns the PDU of the first packet in the buffer which holds the given directive
+ */
+const uint8_t *findDirective(const uint8_t *pu8_Buffer, const uint32_t u32_Size, const uint8_t u8_Directive)
+{
+  uint32_t u32_Pos = 0;
+
+  while(u32_Pos+SP_HEADER_SIZE<=u32_Size)
+  {
+    const uint8_t *pu8_Pdu = &pu8_Buffer[u32_Pos+SP_HEADER_SIZE];
+
+    if(!(pu8_Pdu[0]&0x10) && (pu8_Pdu[12]==u8_Directive))
+      return pu8_Pdu;
+    u32_Pos += SP_HEADER_SIZE+((pu8_Buffer[u32_Pos+4]<<8) | pu8_Buffer[u32_Pos+5])+1;
+  }
+  return nullptr;
+}
+
+
+/**
+ * @brief Runs both entities until the transfer is finished or the time is over
+ */
+uint32_t run(Cfdp &sender, Cfdp &receiver, const uint16_t u16_DropToReceiver, const uint16_t u16_DropToSender)
+{
+  uint32_t u32_Time;
+
+  for(u32_Time=0; u32_Time<500; u32_Time++)
+  {
+    deliver(receiver, g_Buffer, sender.generate(u32_Time, g_Buffer, sizeof(g_Buffer)), u16_DropToReceiver);
+    deliver(sender, g_Buffer, receiver.generate(u32_Time, g_Buffer, sizeof(g_Buffer)), u16_DropToSender);
+    if(!sender.isSending() && !receiver.isReceiving())
+      break;
+  }
+  return u32_Time;
+}
+
+
+void setup() {
+  Serial.begin(9600);
+
+  const uint8_t au8_Words[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+
+  for(uint16_t i=0; i<FILE_SIZE; i++)
+    g_File[i] = (uint8_t)(i*7+i/256);
+
+  // modular checksum: sum of the 32 bit words, aligned to the start of the file
+  check("checksum of words", Cfdp::calcChecksum(0, au8_Words, 8, 0)==0x06080a0cUL);
+  check("checksum at an offset", Cfdp::calcChecksum(0, au8_Words, 2, 3)==0x02000001UL);
+  check("checksum in pieces", Cfdp::calcChecksum(Cfdp::calcChecksum(Cfdp::calcChecksum(0, g_File, 13, 0), &g_File[13], 42, 13),
+                                                 &g_File[55], FILE_SIZE-55, 55)==Cfdp::calcChecksum(0, g_File, FILE_SIZE, 0));
+
+  // unacknowledged mode without losses
+  {
+    TestEntity entityA, entityB;
+    Cfdp cfdpA(ENTITY_A, APID, SpacePacket::TC, &entityA);
+    Cfdp cfdpB(ENTITY_B, APID, SpacePacket::TM, &entityB);
+
+    memset(g_Received, 0, sizeof(g_Received));
+    entityB.mpu8_File = g_Received;
+    cfdpA.setPacketSize(PACKET_SIZE);
+    cfdpB.setPacketSize(PACKET_SIZE);
+    check("put", (cfdpA.put(ENTITY_B, g_File, FILE_SIZE, "a.bin", "b.bin", false)==0) && cfdpA.isSending());
+    check("second put rejected", cfdpA.put(ENTITY_B, g_File, FILE_SIZE, "a.bin", "b.bin", false)==-1);
+    run(cfdpA, cfdpB, 0, 0);
+    check("class 1 transfer", (memcmp(g_File, g_Received, FILE_SIZE)==0)
+                              && (entityA.mu16_FinishedCount==1) && (entityA.mu8_Condition==Cfdp::NoError)
+                              && (entityB.mu16_FinishedCount==1) && (entityB.mu8_Condition==Cfdp::NoError));
+  }
+
+  // acknowledged mode with lost packets in both directions, with PDU CRC
+  {
+    TestEntity entityA, entityB;
+    Cfdp cfdpA(ENTITY_A, APID, SpacePacket::TC, &entityA);
+    Cfdp cfdpB(ENTITY_B, APID, SpacePacket::TM, &entityB);
+
+    memset(g_Received, 0, sizeof(g_Received));
+    entityB.mpu8_File = g_Received;
+    cfdpA.setPacketSize(PACKET_SIZE);
+    cfdpB.setPacketSize(PACKET_SIZE);
+    cfdpA.setPduCrc(true);
+    cfdpB.setPduCrc(true);
+    cfdpA.setTimers(3, 3, 20);
+    cfdpB.setTimers(3, 3, 20);
+    cfdpA.put(ENTITY_B, g_File, FILE_SIZE, "a.bin", "b.bin");
+    g_PacketCount = 0;
+    check("class 2 transfer finished", run(cfdpA, cfdpB, 5, 3)<500);
+    check("class 2 file", memcmp(g_File, g_Received, FILE_SIZE)==0);
+    check("class 2 conditions", (entityA.mu16_FinishedCount==1) && (entityA.mu8_Condition==Cfdp::NoError)
+                                && (entityB.mu16_FinishedCount==1) && (entityB.mu8_Condition==Cfdp::NoError)
+                                && (entityA.mu16_FaultCount==0) && (entityB.mu16_FaultCount==0));
+    check("no protocol or checksum errors", (cfdpA.getProtocolErrorCount()==0) && (cfdpB.getProtocolErrorCount()==0)
+                                            && (cfdpA.getChecksumErrorCount()==0) && (cfdpB.getChecksumErrorCount()==0));
+  }
+
+  // cancel: the EOF PDU holds the checksum of the data sent so far and the sender as fault location
+  {
+    TestEntity entityA, entityB;
+    Cfdp cfdpA(ENTITY_A, APID, SpacePacket::TC, &entityA);
+    Cfdp cfdpB(ENTITY_B, APID, SpacePacket::TM, &entityB);
+    uint16_t u16_Sent = (uint16_t)(2*cfdpA.getSegmentSize());   // packet size 256, the metadata and two segments fit
+    uint32_t u32_Size;
+    const uint8_t *pu8_Pdu;
+
+    entityB.mpu8_File = g_Received;
+    cfdpA.put(ENTITY_B, g_File, FILE_SIZE, "a.bin", "b.bin");
+    u32_Size = cfdpA.generate(0, g_Buffer, 3*256);
+    deliver(cfdpB, g_Buffer, u32_Size, 0);
+    check("cancel", (cfdpA.cancel()==0) && (cfdpB.cancel()==-1));
+    u32_Size = cfdpA.generate(1, g_Buffer, sizeof(g_Buffer));
+    pu8_Pdu = findDirective(g_Buffer, u32_Size, 0x04);
+    check("EOF with fault location", pu8_Pdu && (((pu8_Pdu[1]<<8) | pu8_Pdu[2])==14) && (pu8_Pdu[13]==0xf0)
+                                     && (pu8_Pdu[22]==0x06) && (pu8_Pdu[23]==0x02)
+                                     && (pu8_Pdu[24]==(ENTITY_A>>8)) && (pu8_Pdu[25]==(ENTITY_A&0xff)));
+    check("EOF checksum of the sent data", pu8_Pdu
+                                           && (((uint32_t)pu8_Pdu[14]<<24 | (uint32_t)pu8_Pdu[15]<<16
+                                                | (uint32_t)pu8_Pdu[16]<<8 | pu8_Pdu[17])
+                                               ==Cfdp::calcChecksum(0, g_File, u16_Sent, 0)));
+    deliver(cfdpB, g_Buffer, u32_Size, 0);
+    check("receiver cancelled", (entityB.mu16_FinishedCount==1) && (entityB.mu8_Condition==Cfdp::CancelRequestReceived));
+    u32_Size = cfdpB.generate(1, g_Buffer, sizeof(g_Buffer));
+    pu8_Pdu = findDirective(g_Buffer, u32_Size, 0x05);
+    check("Finished with fault location", pu8_Pdu && (((pu8_Pdu[1]<<8) | pu8_Pdu[2])==6)
+                                          && (pu8_Pdu[14]==0x06) && (pu8_Pdu[16]==(ENTITY_A>>8)) && (pu8_Pdu[17]==(ENTITY_A&0xff)));
+    deliver(cfdpA, g_Buffer, u32_Size, 0);
+    check("sender cancelled", !cfdpA.isSending() && (entityA.mu16_FinishedCount==1)
+                              && (entityA.mu8_Condition==Cfdp::CancelRequestReceived));
+  }
+
+  // the Finished PDU is never acknowledged: the receiver raises a fault
+  {
+    TestEntity entityA, entityB;
+    Cfdp cfdpA(ENTITY_A, APID, SpacePacket::TC, &entityA);
+    Cfdp cfdpB(ENTITY_B, APID, SpacePacket::TM, &entityB);
+    uint32_t u32_Time;
+
+    entityB.mpu8_File = g_Received;
+    cfdpB.setTimers(2, 2, 3);
+    cfdpA.put(ENTITY_B, g_File, FILE_SIZE, "a.bin", "b.bin");
+    for(u32_Time=0; (u32_Time==0) || ((u32_Time<100) && cfdpB.isReceiving()); u32_Time++)
+    {
+      deliver(cfdpB, g_Buffer, cfdpA.generate(u32_Time, g_Buffer, sizeof(g_Buffer)), 0);
+      cfdpB.generate(u32_Time, g_Buffer, sizeof(g_Buffer));
+    }
+    check("file received", (entityB.mu16_FinishedCount==1) && (entityB.mu8_Condition==Cfdp::NoError));
+    check("Finished ACK limit raises a fault", !cfdpB.isReceiving() && (entityB.mu16_FaultCount==1)
+                                               && (entityB.mu8_FaultCondition==Cfdp::PositiveAckLimitReached));
+  }
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
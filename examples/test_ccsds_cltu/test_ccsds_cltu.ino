@@ -0,0 +1,174 @@
+/*
+  Self test of the CLTU encoding with the BCH(63,56) code
+
+  Creates CLTUs, compares the parity with a bitwise reference, decodes
+  them with and without single bit errors and prints the result of each
+  check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define DATA_SIZE   30
+
+
+class TestReceiver : public CltuActionInterface
+{
+public:
+  uint16_t mu16_StartCount = 0;
+  uint16_t mu16_Size = 0;
+  uint8_t mau8_Data[64];
+
+  void onStartOfTransmission(void)
+  {
+    mu16_StartCount++;
+  }
+
+  void onCltuDataReceived(const uint8_t *pu8_Data, const uint16_t u16_DataSize)
+  {
+    if(mu16_Size+u16_DataSize<=sizeof(mau8_Data))
+      memcpy(&mau8_Data[mu16_Size], pu8_Data, u16_DataSize);
+    mu16_Size = (uint16_t)(mu16_Size+u16_DataSize);
+  }
+};
+
+
+uint16_t g_Failed = 0;
+uint32_t g_Random = 815;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+uint32_t nextRandom(void)
+{
+  g_Random = g_Random*1103515245UL+12345UL;
+  return g_Random>>8;
+}
+
+
+// bitwise BCH(63,56) encoder with g(x) = x^7 + x^6 + x^2 + 1, parity complemented, filler bit 0
+uint8_t referenceParity(const uint8_t *pu8_Block)
+{
+  uint8_t u8_Register = 0;
+
+  for(uint8_t i=0; i<7; i++)
+  {
+    for(uint8_t j=0; j<8; j++)
+    {
+      uint8_t u8_Feedback = (uint8_t)(((pu8_Block[i]>>(7-j))&1)^((u8_Register>>6)&1));
+      u8_Register = (uint8_t)(((u8_Register<<1)&0x7f)^((u8_Feedback<<6) | (u8_Feedback<<2) | u8_Feedback));
+    }
+  }
+  return (uint8_t)(((uint8_t)~u8_Register)<<1);
+}
+
+
+void setup() {
+  Serial.begin(9600);
+
+  const uint8_t au8_Start[] = {0xeb, 0x90};
+  const uint8_t au8_Tail[] = {0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x79};
+  const uint8_t au8_Zero[7] = {0};
+  TestReceiver receiver;
+  Cltu cltu(&receiver);
+  uint8_t au8_Data[DATA_SIZE];
+  uint8_t au8_Cltu[64];
+  uint8_t au8_Corrupted[64];
+  uint32_t u32_Size;
+  uint16_t u16_Bit;
+  bool b_Ok;
+
+  // known parity of the all-zero code block
+  check("reference parity of zero block", referenceParity(au8_Zero)==0xfe);
+
+  for(uint8_t i=0; i<DATA_SIZE; i++)
+    au8_Data[i] = (uint8_t)nextRandom();
+  u32_Size = Cltu::create(au8_Cltu, sizeof(au8_Cltu), au8_Data, DATA_SIZE);
+  check("size", (u32_Size==Cltu::getSize(DATA_SIZE)) && (u32_Size==2+5*8+8));
+  check("start and tail sequence", (memcmp(au8_Cltu, au8_Start, 2)==0) && (memcmp(&au8_Cltu[u32_Size-8], au8_Tail, 8)==0));
+  check("fill bytes", (au8_Cltu[2+4*8+2]==0x55) && (au8_Cltu[2+4*8+6]==0x55));
+  check("buffer too small", Cltu::create(au8_Cltu, u32_Size-1, au8_Data, DATA_SIZE)==0);
+  Cltu::create(au8_Cltu, sizeof(au8_Cltu), au8_Data, DATA_SIZE);
+
+  b_Ok = true;
+  for(uint32_t u32_Pos=2; u32_Pos<u32_Size-8; u32_Pos+=8)
+    b_Ok = b_Ok && (au8_Cltu[u32_Pos+7]==referenceParity(&au8_Cltu[u32_Pos]));
+  check("parity matches the reference", b_Ok);
+
+  // random blocks
+  b_Ok = true;
+  for(uint16_t i=0; i<200; i++)
+  {
+    uint8_t au8_Block[7];
+    uint8_t au8_Small[2+8+8];
+    for(uint8_t j=0; j<7; j++)
+      au8_Block[j] = (uint8_t)nextRandom();
+    Cltu::create(au8_Small, sizeof(au8_Small), au8_Block, 7);
+    b_Ok = b_Ok && (au8_Small[2+7]==referenceParity(au8_Block));
+  }
+  check("random parities match the reference", b_Ok);
+
+  // error-free decoding
+  cltu.process(au8_Cltu, (uint16_t)u32_Size);
+  check("decoded", (receiver.mu16_StartCount==1) && (receiver.mu16_Size>=DATA_SIZE) && (memcmp(receiver.mau8_Data, au8_Data, DATA_SIZE)==0));
+
+  // every single bit error is corrected in the error-correcting mode
+  cltu.setErrorCorrection(true);
+  b_Ok = true;
+  for(u16_Bit=0; u16_Bit<63; u16_Bit++)
+  {
+    memcpy(au8_Corrupted, au8_Cltu, u32_Size);
+    au8_Corrupted[2+8+(u16_Bit>>3)] ^= (uint8_t)(0x80>>(u16_Bit&7));
+    receiver.mu16_Size = 0;
+    cltu.process(au8_Corrupted, (uint16_t)u32_Size);
+    b_Ok = b_Ok && (receiver.mu16_Size>=DATA_SIZE) && (memcmp(receiver.mau8_Data, au8_Data, DATA_SIZE)==0);
+  }
+  check("single bit errors corrected", b_Ok);
+  check("corrected errors counted", cltu.getCorrectedErrorCount()==63);
+  cltu.clearErrorCounters();
+  check("error counter cleared", cltu.getCorrectedErrorCount()==0);
+
+  // a single bit error ends the CLTU in the error-detecting mode
+  cltu.setErrorCorrection(false);
+  memcpy(au8_Corrupted, au8_Cltu, u32_Size);
+  au8_Corrupted[2+2*8+3] ^= 0x10;
+  receiver.mu16_Size = 0;
+  cltu.process(au8_Corrupted, (uint16_t)u32_Size);
+  check("error detected", (receiver.mu16_Size==2*7) && (memcmp(receiver.mau8_Data, au8_Data, 2*7)==0));
+
+  // a double bit error ends the CLTU in the error-correcting mode
+  cltu.setErrorCorrection(true);
+  memcpy(au8_Corrupted, au8_Cltu, u32_Size);
+  au8_Corrupted[2+3*8+1] ^= 0x81;
+  receiver.mu16_Size = 0;
+  cltu.process(au8_Corrupted, (uint16_t)u32_Size);
+  check("double error not delivered", (receiver.mu16_Size==3*7) && (memcmp(receiver.mau8_Data, au8_Data, 3*7)==0));
+
+  // data split over several calls and garbage after the tail sequence
+  receiver.mu16_Size = 0;
+  for(uint32_t u32_Pos=0; u32_Pos<u32_Size; u32_Pos+=5)
+    cltu.process(&au8_Cltu[u32_Pos], (uint16_t)((u32_Size-u32_Pos<5)?(u32_Size-u32_Pos):5));
+  cltu.process(au8_Zero, sizeof(au8_Zero));
+  check("split input", (receiver.mu16_Size==5*7) && (memcmp(receiver.mau8_Data, au8_Data, DATA_SIZE)==0));
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
@@ -0,0 +1,161 @@
+/*
+  Self test of the CLTU decoding into the TC transfer frame buffer
+
+  Sends TC transfer frames within CLTUs, with random bytes between the
+  CLTUs and single bit errors in some code blocks, feeds them in chunks
+  of random size and prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define FRAME_COUNT   100
+#define MAX_DATA_SIZE (TC_TF_MAX_SIZE-5-1-2)
+
+
+class TestReceiver : public TransferframeTcActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  uint16_t mu16_Wrong = 0;
+  uint8_t mu8_LastFrame = 0;
+
+  void onTransferframeTcReceived(const bool b_BypassFlag, const bool b_CtrlCmdFlag,
+                                 const uint16_t u16_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                                 const uint8_t u8_FrameSeqNumber, const uint8_t u8_MAP,
+                                 const uint8_t *pu8_Data, const uint16_t u16_DataSize);
+};
+
+
+uint16_t g_Failed = 0;
+uint32_t g_Random = 2024;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+uint32_t nextRandom(void)
+{
+  g_Random = g_Random*1103515245UL+12345UL;
+  return g_Random>>8;
+}
+
+
+// the content of each frame is given by its frame sequence number
+uint16_t dataSize(const uint8_t u8_Frame)
+{
+  return (uint16_t)(1+(u8_Frame*37)%MAX_DATA_SIZE);
+}
+
+
+uint8_t dataByte(const uint8_t u8_Frame, const uint16_t u16_Pos)
+{
+  return (uint8_t)(u8_Frame*13+u16_Pos*7);
+}
+
+
+void TestReceiver::onTransferframeTcReceived(const bool b_BypassFlag, const bool b_CtrlCmdFlag,
+                                             const uint16_t u16_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                                             const uint8_t u8_FrameSeqNumber, const uint8_t u8_MAP,
+                                             const uint8_t *pu8_Data, const uint16_t u16_DataSize)
+{
+  bool b_Ok = (u16_SpacecraftID==0x25c) && (u8_VirtualChannelID==1) && (u16_DataSize==dataSize(u8_FrameSeqNumber));
+
+  for(uint16_t i=0; b_Ok && (i<u16_DataSize); i++)
+    b_Ok = (pu8_Data[i]==dataByte(u8_FrameSeqNumber, i));
+  mu16_Count++;
+  mu8_LastFrame = u8_FrameSeqNumber;
+  if(!b_Ok)
+    mu16_Wrong++;
+}
+
+
+#if TC_TF_USE_CLTU == 1
+// sends all frames within CLTUs; every third CLTU gets a single bit error in a code block
+void sendFrames(TransferframeTc &tc)
+{
+  uint8_t au8_Data[MAX_DATA_SIZE];
+  uint8_t au8_Frame[TC_TF_MAX_SIZE];
+  uint8_t au8_Cltu[2+((TC_TF_MAX_SIZE+6)/7)*8+8+4];
+
+  for(uint8_t u8_Frame=0; u8_Frame<FRAME_COUNT; u8_Frame++)
+  {
+    uint16_t u16_DataSize = dataSize(u8_Frame);
+    uint32_t u32_FrameSize;
+    uint32_t u32_Size;
+    uint32_t u32_Pos = 0;
+    uint32_t u32_Junk = nextRandom()%5;
+
+    for(uint16_t i=0; i<u16_DataSize; i++)
+      au8_Data[i] = dataByte(u8_Frame, i);
+    u32_FrameSize = TransferframeTc::create(au8_Frame, sizeof(au8_Frame), false, false, 0x25c, 1, u8_Frame, 0,
+                                            au8_Data, u16_DataSize);
+
+    // random bytes between the CLTUs
+    for(uint32_t i=0; i<u32_Junk; i++)
+      au8_Cltu[i] = (uint8_t)nextRandom();
+    u32_Size = u32_Junk+Cltu::create(&au8_Cltu[u32_Junk], sizeof(au8_Cltu)-u32_Junk, au8_Frame, (uint16_t)u32_FrameSize);
+    if(u8_Frame%3==0)
+    {
+      uint32_t u32_Block = nextRandom()%((u32_FrameSize+6)/7);
+      au8_Cltu[u32_Junk+2+u32_Block*8+nextRandom()%8] ^= (uint8_t)(1<<(nextRandom()%8));
+    }
+
+    while(u32_Pos<u32_Size)
+    {
+      uint16_t u16_Chunk = (uint16_t)(1+nextRandom()%20);
+      if(u32_Pos+u16_Chunk>u32_Size)
+        u16_Chunk = (uint16_t)(u32_Size-u32_Pos);
+      tc.processCltu(&au8_Cltu[u32_Pos], u16_Chunk);
+      u32_Pos += u16_Chunk;
+    }
+  }
+}
+#endif
+
+
+void setup() {
+  Serial.begin(9600);
+
+#if TC_TF_USE_CLTU == 1
+  TestReceiver receiver;
+  TransferframeTc tc(&receiver);
+
+  // error-correcting mode: all frames are delivered
+  tc.setCltuErrorCorrection(true);
+  sendFrames(tc);
+  check("all frames delivered", (receiver.mu16_Count==FRAME_COUNT) && (receiver.mu8_LastFrame==FRAME_COUNT-1));
+  check("frame content", receiver.mu16_Wrong==0);
+  check("no checksum errors", tc.getChecksumErrorCount()==0);
+
+  // error-detecting mode: the corrupted frames are dropped
+  receiver.mu16_Count = 0;
+  tc.setCltuErrorCorrection(false);
+  sendFrames(tc);
+  check("corrupted frames dropped", receiver.mu16_Count==FRAME_COUNT-(FRAME_COUNT+2)/3);
+  check("remaining frame content", receiver.mu16_Wrong==0);
+  check("dropped frames counted", tc.getSyncErrorCount()+tc.getChecksumErrorCount()>=(FRAME_COUNT+2)/3);
+#else
+  check("CLTU support disabled (configUSE_CLTU_SUPPORT)", true);
+#endif
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
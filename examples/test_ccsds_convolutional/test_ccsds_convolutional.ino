@@ -0,0 +1,155 @@
+/*
+  Self test of the convolutional code (rate 1/2, K=7)
+
+  Compares the encoder output with known symbols, decodes TM transfer
+  frames with symbol errors by the Viterbi decoder and prints the result
+  of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define FRAME_COUNT   10
+#define DATA_SIZE     20
+
+
+class TestReceiver : public TransferframeTmActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  uint16_t mu16_Wrong = 0;
+
+  void onTransferframeTmReceived(const uint16_t u16_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                                 const uint8_t u8_MasterChannelFrameCount, const uint8_t u8_VirtualChannelFrameCount,
+                                 const bool b_SecondaryHeader, const uint16_t u16_FirstHdrPtr,
+                                 const uint8_t *pu8_Data, const uint16_t u16_DataSize, const uint32_t u32_OCF)
+  {
+    bool b_Ok = (u16_SpacecraftID==0x25c) && (u16_DataSize>=DATA_SIZE);
+
+    for(uint8_t i=0; b_Ok && (i<DATA_SIZE); i++)
+      b_Ok = (pu8_Data[i]==(uint8_t)(u8_VirtualChannelFrameCount*7+i));
+    mu16_Count++;
+    if(!b_Ok)
+      mu16_Wrong++;
+  }
+};
+
+
+uint16_t g_Failed = 0;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+#if TF_VITERBI_TRACEBACK_DEPTH > 0
+// encodes the frames with the attached sync marker and feeds them as soft symbols into the decoder; every
+// u16_ErrorDistance-th symbol is received with the wrong sign
+void sendFrames(ViterbiDecoder &decoder, const uint16_t u16_ErrorDistance)
+{
+  const uint8_t au8_Asm[] = {0x1a, 0xcf, 0xfc, 0x1d};
+  ConvolutionalEncoder encoder;
+  uint8_t au8_Frame[TM_TF_TOTAL_SIZE];
+  uint8_t au8_Data[DATA_SIZE];
+  uint8_t au8_Coded[2*(4+TM_TF_TOTAL_SIZE)];
+  int8_t ai8_Symbols[16*8];
+  uint32_t u32_Symbol = 0;
+
+  for(uint8_t u8_Frame=0; u8_Frame<=FRAME_COUNT; u8_Frame++)
+  {
+    uint32_t u32_Size;
+
+    for(uint8_t i=0; i<DATA_SIZE; i++)
+      au8_Data[i] = (uint8_t)(u8_Frame*7+i);
+    TransferframeTm::create(au8_Frame, sizeof(au8_Frame), 0x25c, 0, u8_Frame, u8_Frame, 0, au8_Data, DATA_SIZE);
+
+    // the last pass only flushes the decoder
+    u32_Size = encoder.encode(au8_Coded, sizeof(au8_Coded), au8_Asm, sizeof(au8_Asm));
+    if(u8_Frame<FRAME_COUNT)
+      u32_Size += encoder.encode(&au8_Coded[u32_Size], sizeof(au8_Coded)-u32_Size, au8_Frame, sizeof(au8_Frame));
+
+    for(uint32_t u32_Pos=0; u32_Pos<u32_Size; u32_Pos+=16)
+    {
+      uint32_t u32_Count = (u32_Size-u32_Pos<16)?(u32_Size-u32_Pos)*8:16*8;
+      for(uint32_t i=0; i<u32_Count; i++, u32_Symbol++)
+      {
+        bool b_One = (au8_Coded[u32_Pos+i/8]>>(7-i%8))&1;
+        if(u16_ErrorDistance && (u32_Symbol%u16_ErrorDistance==0))
+          b_One = !b_One;
+        ai8_Symbols[i] = b_One?-100:100;
+      }
+      // odd symbol counts are allowed
+      decoder.process(ai8_Symbols, 3);
+      decoder.process(&ai8_Symbols[3], u32_Count-3);
+    }
+  }
+  decoder.flush();
+}
+#endif
+
+
+void setup() {
+  Serial.begin(9600);
+
+  // symbols of the attached sync marker and of a single bit, starting with the all-zero state
+  const uint8_t au8_Asm[] = {0x1a, 0xcf, 0xfc, 0x1d};
+  const uint8_t au8_AsmSymbols[] = {0x56, 0x08, 0x1c, 0x97, 0x1a, 0xa7, 0x3d, 0x3e};
+  const uint8_t au8_Impulse[] = {0x80, 0x00, 0x00};
+  const uint8_t au8_ImpulseSymbols[] = {0xba, 0x49, 0x55, 0x55, 0x55, 0x55};
+  ConvolutionalEncoder encoder;
+  uint8_t au8_Buffer[8];
+  uint32_t u32_Size;
+
+  u32_Size = encoder.encode(au8_Buffer, sizeof(au8_Buffer), au8_Impulse, sizeof(au8_Impulse));
+  check("impulse response", (u32_Size==sizeof(au8_ImpulseSymbols)) && (memcmp(au8_Buffer, au8_ImpulseSymbols, u32_Size)==0));
+  encoder.reset();
+  u32_Size = encoder.encode(au8_Buffer, sizeof(au8_Buffer), au8_Asm, sizeof(au8_Asm));
+  check("sync marker symbols", (u32_Size==sizeof(au8_AsmSymbols)) && (memcmp(au8_Buffer, au8_AsmSymbols, u32_Size)==0));
+
+  // the state is kept between the calls
+  encoder.reset();
+  encoder.encode(au8_Buffer, sizeof(au8_Buffer), au8_Asm, 1);
+  encoder.encode(&au8_Buffer[2], sizeof(au8_Buffer)-2, &au8_Asm[1], 3);
+  check("continuous encoding", memcmp(au8_Buffer, au8_AsmSymbols, sizeof(au8_AsmSymbols))==0);
+  check("buffer too small", encoder.encode(au8_Buffer, 7, au8_Asm, sizeof(au8_Asm))==0);
+
+#if TF_VITERBI_TRACEBACK_DEPTH > 0
+  {
+    TestReceiver receiver;
+    TransferframeTm tm(&receiver);
+    ViterbiDecoder decoder(&tm);
+
+    sendFrames(decoder, 0);
+    check("error-free frames decoded", (receiver.mu16_Count==FRAME_COUNT) && (receiver.mu16_Wrong==0));
+  }
+  {
+    TestReceiver receiver;
+    TransferframeTm tm(&receiver);
+    ViterbiDecoder decoder(&tm);
+
+    sendFrames(decoder, 21);
+    check("symbol errors corrected", (receiver.mu16_Count==FRAME_COUNT) && (receiver.mu16_Wrong==0));
+  }
+#else
+  check("Viterbi decoder disabled (configTF_VITERBI_TRACEBACK_DEPTH)", true);
+#endif
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
@@ -0,0 +1,170 @@
+/*
+  Self test of the telemetry decommutator
+
+  Extracts known bit fields (unsigned, signed, big and little endian,
+  float and double) with a linear calibration from packets of two APIDs,
+  including a parameter array which is merged into one operation. Checks
+  the counters for unknown APIDs, too short packets and full columns and
+  the rejection of invalid tables. Prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define COLUMN_SIZE  2
+
+#define APID_A  0x100
+#define APID_B  0x200
+
+
+uint16_t g_Failed = 0;
+
+double g_Byte[COLUMN_SIZE];
+double g_Unsigned12[COLUMN_SIZE];
+double g_Signed12[COLUMN_SIZE];
+double g_Signed16[COLUMN_SIZE];
+double g_LittleEndian16[COLUMN_SIZE];
+double g_Float[COLUMN_SIZE];
+double g_LittleEndianFloat[COLUMN_SIZE];
+double g_Array[3][COLUMN_SIZE];
+double g_Word[COLUMN_SIZE];
+double g_Double[COLUMN_SIZE];
+
+const Decommutator::Parameter g_Parameters[] =
+{
+  // APID    byte bit width type                    LE     scale offset column
+  { APID_A,   0,  0,  8, Decommutator::Unsigned, false, 1.0,   0.0, g_Byte },
+  { APID_A,   1,  4, 12, Decommutator::Unsigned, false, 0.5, -10.0, g_Unsigned12 },
+  { APID_A,   1,  4, 12, Decommutator::Signed,   false, 1.0,   0.0, g_Signed12 },
+  { APID_A,   3,  0, 16, Decommutator::Signed,   false, 1.0,   0.0, g_Signed16 },
+  { APID_A,   5,  0, 16, Decommutator::Unsigned, true,  1.0,   0.0, g_LittleEndian16 },
+  { APID_A,   7,  0, 32, Decommutator::Float,    false, 2.0,   0.0, g_Float },
+  { APID_A,  11,  0, 32, Decommutator::Float,    true,  1.0,   1.0, g_LittleEndianFloat },
+  { APID_A,  15,  2,  3, Decommutator::Unsigned, false, 1.0,   0.0, g_Array[0] },
+  { APID_A,  16,  2,  3, Decommutator::Unsigned, false, 1.0,   0.0, g_Array[1] },
+  { APID_A,  17,  2,  3, Decommutator::Unsigned, false, 1.0,   0.0, g_Array[2] },
+  { APID_B,   0,  0, 32, Decommutator::Unsigned, false, 1.0,   0.0, g_Word },
+  { APID_B,   4,  0, 64, Decommutator::Float,    false, 1.0,   0.0, g_Double }
+};
+
+const uint8_t g_PacketA[] =
+{
+  0xab,                     // 171
+  0x5c, 0xde,               // 12 bits at bit 4: 0xcde
+  0xff, 0x38,               // -200
+  0x34, 0x12,               // 0x1234, little endian
+  0x3f, 0xc0, 0x00, 0x00,   // 1.5
+  0x00, 0x00, 0x10, 0xc0,   // -2.25, little endian
+  0x28, 0x0c, 0x1c          // 5, 1, 3 at bit 2
+};
+
+const uint8_t g_PacketB[] =
+{
+  0xde, 0xad, 0xbe, 0xef,                           // 3735928559
+  0x41, 0x2e, 0x84, 0x80, 0x00, 0x00, 0x00, 0x00    // 1e6
+};
+
+Decommutator::Parameter g_TooManyApids[Decommutator::MaxApids+1];
+Decommutator g_Decommutator;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+/**
+ * @brief Loads a table with a single parameter and returns the result of load()
+ */
+int32_t loadSingle(const uint8_t u8_BitOffset, const uint8_t u8_Width, const enum Decommutator::ParameterType e_Type,
+                   const bool b_LittleEndian)
+{
+  const Decommutator::Parameter S_Parameter = { APID_A, 0, u8_BitOffset, u8_Width, e_Type, b_LittleEndian, 1.0, 0.0, g_Byte };
+
+  return g_Decommutator.load(&S_Parameter, 1, COLUMN_SIZE);
+}
+
+
+void setup()
+{
+  uint8_t au8_Packet[sizeof(g_PacketA)];
+
+  Serial.begin(115200);
+  while(!Serial);
+
+  // the double parameter is the last one, it can not be loaded where double has only 32 bits
+  check("load", g_Decommutator.load(g_Parameters, sizeof(g_Parameters)/sizeof(g_Parameters[0])-((sizeof(double)<8)?1:0), COLUMN_SIZE)==0);
+
+  check("process", g_Decommutator.process(APID_A, g_PacketA, sizeof(g_PacketA))==0);
+  check("byte", g_Byte[0]==171.0);
+  check("unsigned bit field with calibration", g_Unsigned12[0]==0xcde*0.5-10.0);
+  check("signed bit field", g_Signed12[0]==-802.0);
+  check("signed 16 bit", g_Signed16[0]==-200.0);
+  check("little endian 16 bit", g_LittleEndian16[0]==4660.0);
+  check("float with calibration", g_Float[0]==3.0);
+  check("little endian float with calibration", g_LittleEndianFloat[0]==-1.25);
+  check("array", (g_Array[0][0]==5.0) && (g_Array[1][0]==1.0) && (g_Array[2][0]==3.0));
+  check("row count", g_Decommutator.getRowCount(APID_A)==1);
+
+  // the second row must not touch the first one
+  memcpy(au8_Packet, g_PacketA, sizeof(au8_Packet));
+  au8_Packet[0] = 0x01;
+  au8_Packet[17] = 0x38;
+  check("second row", (g_Decommutator.process(APID_A, au8_Packet, sizeof(au8_Packet))==0) &&
+                      (g_Byte[1]==1.0) && (g_Array[2][1]==7.0) && (g_Byte[0]==171.0) && (g_Array[2][0]==3.0));
+
+  g_Decommutator.onSpacePacketReceived(0, 3, APID_B, 0, false, g_PacketB, sizeof(g_PacketB));
+  check("space packet interface", g_Decommutator.getRowCount(APID_B)==1);
+  check("32 bit unsigned", g_Word[0]==3735928559.0);
+  check("double", (sizeof(double)<8) || (g_Double[0]==1e6));
+
+  check("too short packet", g_Decommutator.process(APID_A, g_PacketA, sizeof(g_PacketA)-1)==-2);
+  check("length error count", g_Decommutator.getLengthErrorCount()==1);
+  check("unknown APID", g_Decommutator.process(0x300, g_PacketA, sizeof(g_PacketA))==-1);
+  check("unknown APID count", (g_Decommutator.getUnknownApidCount()==1) && (g_Decommutator.getRowCount(0x300)==0));
+  check("full columns", g_Decommutator.process(APID_A, g_PacketA, sizeof(g_PacketA))==-3);
+  check("overflow error count", (g_Decommutator.getOverflowErrorCount()==1) && (g_Decommutator.getRowCount(APID_A)==COLUMN_SIZE));
+
+  g_Decommutator.clearRows();
+  check("process after clearing the rows", (g_Decommutator.process(APID_A, au8_Packet, sizeof(au8_Packet))==0) &&
+                                           (g_Byte[0]==1.0) && (g_Decommutator.getRowCount(APID_A)==1) &&
+                                           (g_Decommutator.getRowCount(APID_B)==0));
+  g_Decommutator.clearErrorCounters();
+  check("error counters cleared", (g_Decommutator.getLengthErrorCount()==0) && (g_Decommutator.getUnknownApidCount()==0) &&
+                                  (g_Decommutator.getOverflowErrorCount()==0));
+
+  // invalid tables are rejected and leave the loaded table unchanged
+  check("unaligned float rejected", loadSingle(1, 32, Decommutator::Float, false)==-1);
+  check("float width rejected", loadSingle(0, 16, Decommutator::Float, false)==-1);
+  check("unaligned little endian rejected", loadSingle(0, 12, Decommutator::Unsigned, true)==-1);
+  check("too wide integer rejected", loadSingle(0, 33, Decommutator::Signed, false)==-1);
+  check("bit offset rejected", loadSingle(8, 8, Decommutator::Unsigned, false)==-1);
+  check("table kept", (g_Decommutator.process(APID_B, g_PacketB, sizeof(g_PacketB))==0) && (g_Decommutator.getRowCount(APID_B)==1));
+  for(uint16_t i=0; i<Decommutator::MaxApids+1; i++)
+  {
+    g_TooManyApids[i] = g_Parameters[0];
+    g_TooManyApids[i].u16_APID = i;
+  }
+  check("too many APIDs rejected", g_Decommutator.load(g_TooManyApids, Decommutator::MaxApids+1, COLUMN_SIZE)==-2);
+  check("maximum APIDs", g_Decommutator.load(g_TooManyApids, Decommutator::MaxApids, COLUMN_SIZE)==0);
+  check("table replaced", (g_Decommutator.process(APID_A, g_PacketA, sizeof(g_PacketA))==-1) &&
+                          (g_Decommutator.process(0, g_PacketA, 1)==0) && (g_Byte[0]==171.0));
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,190 @@
+/*
+  Self test of the Encapsulation Packets
+
+  Compares packets with known headers, parses a stream of mixed
+  encapsulation, idle and space packets in chunks of different sizes,
+  checks the handling of invalid headers and of packets which do not
+  fit into the internal buffer and prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define PACKET_COUNT  50
+
+
+class TestReceiver : public EncapsulationPacketActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  uint16_t mu16_Wrong = 0;
+  uint32_t mu32_LastLength = 0;
+
+  void onEncapsulationPacketReceived(const uint8_t u8_ProtocolID, const uint8_t u8_ProtocolIDExtension,
+                                     const uint8_t u8_UserDefinedField, const uint16_t u16_CcsdsDefinedField,
+                                     const uint8_t *pu8_PacketData, const uint32_t u32_PacketDataLength)
+  {
+    bool b_Ok = (u8_ProtocolID==1+mu16_Count%7) && (u8_ProtocolIDExtension==((mu16_Count%3)?mu16_Count%16:0))
+                && (u8_UserDefinedField==((mu16_Count%3)?(mu16_Count+1)%16:0))
+                && (u16_CcsdsDefinedField==((mu16_Count%3==2)?0x1234:0));
+
+    for(uint32_t i=0; b_Ok && (i<u32_PacketDataLength); i++)
+      b_Ok = (pu8_PacketData[i]==(uint8_t)(i+mu16_Count));
+    mu32_LastLength = u32_PacketDataLength;
+    mu16_Count++;
+    if(!b_Ok)
+      mu16_Wrong++;
+  }
+};
+
+
+class TestSpacePacketReceiver : public SpacePacketActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+
+  void onSpacePacketReceived(const uint8_t u8_PacketType, const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                             const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                             const uint8_t *pu8_Data, const uint16_t u16_DataSize)
+  {
+    if((u16_APID==0x123) && (u16_DataSize==4) && (pu8_Data[3]==3))
+      mu16_Count++;
+  }
+};
+
+
+uint16_t g_Failed = 0;
+
+uint8_t g_Stream[PACKET_COUNT*(EP_MAX_HEADER_SIZE+20+SP_HEADER_SIZE+4+3)];
+uint8_t g_Large[EP_MAX_HEADER_SIZE+EP_MAX_DATA_SIZE+1];
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+void feed(EncapsulationPacket &ep, const uint8_t *pu8_Data, const uint32_t u32_Size, const uint32_t u32_ChunkSize)
+{
+  for(uint32_t u32_Pos=0; u32_Pos<u32_Size; u32_Pos+=u32_ChunkSize)
+    ep.process(&pu8_Data[u32_Pos], (u32_Size-u32_Pos<u32_ChunkSize)?(u32_Size-u32_Pos):u32_ChunkSize);
+}
+
+
+void setup() {
+  Serial.begin(9600);
+
+  const uint8_t au8_Data[] = {0x00, 0x01, 0x02, 0x03};
+  uint8_t au8_Packet[16];
+  uint32_t u32_Size = 0;
+
+  // known headers
+  check("2 byte header", (EncapsulationPacket::create(au8_Packet, sizeof(au8_Packet), EncapsulationPacket::LtpProtocol, au8_Data, 3)==5)
+                         && (au8_Packet[0]==0xe5) && (au8_Packet[1]==0x05) && (au8_Packet[4]==0x02));
+  check("4 byte header", (EncapsulationPacket::create(au8_Packet, sizeof(au8_Packet), EncapsulationPacket::ExtendedProtocolID,
+                                                      au8_Data, 4, 3, 2)==8)
+                         && (au8_Packet[0]==0xfa) && (au8_Packet[1]==0x23) && (au8_Packet[2]==0x00) && (au8_Packet[3]==0x08));
+  check("8 byte header", (EncapsulationPacket::create(au8_Packet, sizeof(au8_Packet), EncapsulationPacket::IpeProtocol,
+                                                      au8_Data, 1, 0, 0, 0xabcd)==9)
+                         && (au8_Packet[0]==0xeb) && (au8_Packet[1]==0x00) && (au8_Packet[2]==0xab) && (au8_Packet[3]==0xcd)
+                         && (au8_Packet[4]==0x00) && (au8_Packet[5]==0x00) && (au8_Packet[6]==0x00) && (au8_Packet[7]==0x09));
+  check("1 byte idle packet", (EncapsulationPacket::createIdle(au8_Packet, sizeof(au8_Packet), 1)==1) && (au8_Packet[0]==0xe0));
+  check("idle protocol rejected", EncapsulationPacket::create(au8_Packet, sizeof(au8_Packet), EncapsulationPacket::Idle, au8_Data, 3)==0);
+  check("buffer too small", EncapsulationPacket::create(au8_Packet, 4, EncapsulationPacket::LtpProtocol, au8_Data, 3)==0);
+
+  // stream of encapsulation packets with all header sizes, idle packets and space packets
+  for(uint16_t p=0; p<PACKET_COUNT; p++)
+  {
+    uint8_t au8_PacketData[20];
+    uint16_t u16_Length = (uint16_t)((p*7)%20);
+
+    for(uint16_t i=0; i<u16_Length; i++)
+      au8_PacketData[i] = (uint8_t)(i+p);
+    u32_Size += EncapsulationPacket::create(&g_Stream[u32_Size], sizeof(g_Stream)-u32_Size, (uint8_t)(1+p%7),
+                                            au8_PacketData, u16_Length, (uint8_t)((p%3)?p%16:0),
+                                            (uint8_t)((p%3)?(p+1)%16:0), (uint16_t)((p%3==2)?0x1234:0));
+    u32_Size += EncapsulationPacket::createIdle(&g_Stream[u32_Size], sizeof(g_Stream)-u32_Size, 1+p%3);
+    if(p%5==0)
+      u32_Size += SpacePacket::create(&g_Stream[u32_Size], sizeof(g_Stream)-u32_Size, SpacePacket::PacketType::TM,
+                                      SpacePacket::SequenceFlags::Unsegmented, 0x123, p, au8_Data, sizeof(au8_Data));
+  }
+
+  for(uint32_t u32_ChunkSize=1; u32_ChunkSize<=u32_Size; u32_ChunkSize=u32_ChunkSize*3+1)
+  {
+    TestReceiver receiver;
+    TestSpacePacketReceiver spReceiver;
+    SpacePacket sp(&spReceiver);
+    EncapsulationPacket ep(&receiver, &sp);
+
+    feed(ep, g_Stream, u32_Size, u32_ChunkSize);
+    if((receiver.mu16_Count!=PACKET_COUNT) || (receiver.mu16_Wrong!=0) || (spReceiver.mu16_Count!=PACKET_COUNT/5)
+       || (ep.getSyncErrorCount()!=0) || (ep.getOverflowErrorCount()!=0))
+    {
+      check("mixed stream", false);
+      break;
+    }
+    if(u32_ChunkSize*3+1>u32_Size)
+      check("mixed stream", true);
+  }
+
+  // a 1 byte header is only valid for idle packets, the byte is skipped
+  {
+    TestReceiver receiver;
+    EncapsulationPacket ep(&receiver);
+
+    au8_Packet[0] = 0xe4;
+    EncapsulationPacket::create(&au8_Packet[1], sizeof(au8_Packet)-1, EncapsulationPacket::LtpProtocol, au8_Data, 0);
+    ep.process(au8_Packet, 3);
+    check("1 byte header with protocol ID rejected", (ep.getSyncErrorCount()==1) && (receiver.mu16_Count==1));
+  }
+
+  // packet length smaller than the header
+  {
+    TestReceiver receiver;
+    EncapsulationPacket ep(&receiver);
+
+    au8_Packet[0] = 0xe5;
+    au8_Packet[1] = 0x01;
+    EncapsulationPacket::create(&au8_Packet[2], sizeof(au8_Packet)-2, EncapsulationPacket::LtpProtocol, au8_Data, 0);
+    ep.process(au8_Packet, 4);
+    check("invalid packet length", (ep.getSyncErrorCount()==1) && (receiver.mu16_Count==1));
+  }
+
+  // a packet which exceeds the internal buffer is only delivered if it is not split
+  {
+    TestReceiver receiver;
+    EncapsulationPacket ep(&receiver);
+    uint8_t au8_Large[EP_MAX_DATA_SIZE+1];
+
+    for(uint32_t i=0; i<sizeof(au8_Large); i++)
+      au8_Large[i] = (uint8_t)i;
+    u32_Size = EncapsulationPacket::create(g_Large, sizeof(g_Large), EncapsulationPacket::LtpProtocol, au8_Large, sizeof(au8_Large));
+    ep.process(g_Large, u32_Size);
+    check("large packet in one block", (receiver.mu16_Count==1) && (receiver.mu32_LastLength==sizeof(au8_Large))
+                                       && (receiver.mu16_Wrong==0));
+    receiver.mu16_Count = 0;
+    feed(ep, g_Large, u32_Size, 7);
+    check("split large packet dropped", (receiver.mu16_Count==0) && (ep.getOverflowErrorCount()==1));
+    u32_Size = EncapsulationPacket::create(g_Large, sizeof(g_Large), EncapsulationPacket::LtpProtocol, au8_Data, sizeof(au8_Data));
+    feed(ep, g_Large, u32_Size, 1);
+    check("packet after the overflow", (receiver.mu16_Count==1) && (receiver.mu16_Wrong==0) && (ep.getSyncErrorCount()==0));
+  }
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
@@ -0,0 +1,131 @@
+/*
+  Self test of the PLOP-2 transmission encoding for CLTUs
+
+  Creates a transmission of several data blocks, compares it with the
+  single CLTUs, decodes it again and prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define BLOCK_COUNT     3
+#define ACQUISITION     16
+#define IDLE            8
+
+
+class TestReceiver : public CltuActionInterface
+{
+public:
+  uint16_t mu16_StartCount = 0;
+  uint16_t mu16_Size = 0;
+  uint8_t mau8_Data[128];
+
+  void onStartOfTransmission(void)
+  {
+    mu16_StartCount++;
+  }
+
+  void onCltuDataReceived(const uint8_t *pu8_Data, const uint16_t u16_DataSize)
+  {
+    if(mu16_Size+u16_DataSize<=sizeof(mau8_Data))
+      memcpy(&mau8_Data[mu16_Size], pu8_Data, u16_DataSize);
+    mu16_Size = (uint16_t)(mu16_Size+u16_DataSize);
+  }
+};
+
+
+uint16_t g_Failed = 0;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+bool isFill(const uint8_t *pu8_Buffer, const uint32_t u32_Size)
+{
+  for(uint32_t i=0; i<u32_Size; i++)
+  {
+    if(pu8_Buffer[i]!=0x55)
+      return false;
+  }
+  return true;
+}
+
+
+void setup() {
+  Serial.begin(9600);
+
+  uint8_t au8_Blocks[BLOCK_COUNT][20];
+  const uint8_t *apu8_Data[BLOCK_COUNT];
+  uint16_t au16_Size[BLOCK_COUNT] = {20, 7, 13};
+  uint8_t au8_Transmission[ACQUISITION+3*(2+3*8+8)+IDLE];
+  uint8_t au8_Cltu[2+3*8+8];
+  uint32_t u32_Expected = ACQUISITION+IDLE;
+  uint32_t u32_Size;
+  uint32_t u32_Pos;
+  bool b_Ok;
+
+  for(uint8_t i=0; i<BLOCK_COUNT; i++)
+  {
+    for(uint8_t j=0; j<sizeof(au8_Blocks[i]); j++)
+      au8_Blocks[i][j] = (uint8_t)(i*31+j*5+1);
+    apu8_Data[i] = au8_Blocks[i];
+    u32_Expected += Cltu::getSize(au16_Size[i]);
+  }
+
+  u32_Size = Cltu::createTransmission(au8_Transmission, sizeof(au8_Transmission), apu8_Data, au16_Size, BLOCK_COUNT, ACQUISITION, IDLE);
+  check("size", (u32_Size==u32_Expected) && (u32_Size<=sizeof(au8_Transmission)));
+  check("acquisition sequence", isFill(au8_Transmission, ACQUISITION));
+  check("idle sequence", isFill(&au8_Transmission[u32_Size-IDLE], IDLE));
+
+  // each CLTU matches the one created by Cltu::create()
+  b_Ok = true;
+  u32_Pos = ACQUISITION;
+  for(uint8_t i=0; i<BLOCK_COUNT; i++)
+  {
+    uint32_t u32_CltuSize = Cltu::create(au8_Cltu, sizeof(au8_Cltu), apu8_Data[i], au16_Size[i]);
+    b_Ok = b_Ok && (u32_CltuSize==Cltu::getSize(au16_Size[i])) && (memcmp(&au8_Transmission[u32_Pos], au8_Cltu, u32_CltuSize)==0);
+    u32_Pos += u32_CltuSize;
+  }
+  check("CLTUs match single encoding", b_Ok);
+
+  // invalid parameters
+  check("buffer too small", Cltu::createTransmission(au8_Transmission, u32_Expected-1, apu8_Data, au16_Size, BLOCK_COUNT, ACQUISITION, IDLE)==0);
+  check("missing data rejected", Cltu::createTransmission(au8_Transmission, sizeof(au8_Transmission), nullptr, au16_Size, BLOCK_COUNT, ACQUISITION, IDLE)==0);
+
+  // the decoder gets all data blocks in sequence
+  {
+    TestReceiver receiver;
+    Cltu cltu(&receiver);
+
+    u32_Size = Cltu::createTransmission(au8_Transmission, sizeof(au8_Transmission), apu8_Data, au16_Size, BLOCK_COUNT, ACQUISITION, IDLE);
+    cltu.process(au8_Transmission, (uint16_t)u32_Size);
+    b_Ok = (receiver.mu16_StartCount==BLOCK_COUNT);
+    u32_Pos = 0;
+    for(uint8_t i=0; i<BLOCK_COUNT; i++)
+    {
+      b_Ok = b_Ok && (memcmp(&receiver.mau8_Data[u32_Pos], apu8_Data[i], au16_Size[i])==0);
+      u32_Pos += ((au16_Size[i]+Cltu::DataBlockSize-1)/Cltu::DataBlockSize)*Cltu::DataBlockSize;
+    }
+    check("transmission decoded", b_Ok && (receiver.mu16_Size==u32_Pos));
+  }
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
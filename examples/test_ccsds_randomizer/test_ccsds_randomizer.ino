@@ -0,0 +1,128 @@
+/*
+  Self test of the CCSDS pseudo-randomizer
+
+  Compares the TM and TC sequences with the published first bytes and
+  with a bitwise reference generator and prints the result of each
+  check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define TEST_SIZE   600
+
+
+uint16_t g_Failed = 0;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+// bitwise Fibonacci generator; the feedback mask holds the taps of the recurrence, starting with all ones
+void referenceSequence(const uint8_t u8_Taps, uint8_t *pu8_Buffer, const uint32_t u32_Size)
+{
+  uint8_t u8_Register = 0xff;
+
+  for(uint32_t i=0; i<u32_Size; i++)
+  {
+    uint8_t u8_Byte = 0;
+    for(uint8_t j=0; j<8; j++)
+    {
+      uint8_t u8_Feedback = (uint8_t)(u8_Register&u8_Taps);
+      u8_Feedback ^= (uint8_t)(u8_Feedback>>4);
+      u8_Feedback ^= (uint8_t)(u8_Feedback>>2);
+      u8_Feedback ^= (uint8_t)(u8_Feedback>>1);
+      u8_Byte = (uint8_t)((u8_Byte<<1) | (u8_Register&1));
+      u8_Register = (uint8_t)((u8_Register>>1) | ((u8_Feedback&1)<<7));
+    }
+    pu8_Buffer[i] = u8_Byte;
+  }
+}
+
+
+#if TF_USE_RANDOMIZER == 1
+bool checkSequence(const enum Randomizer::Sequence e_Sequence, const uint8_t u8_Taps)
+{
+  static uint8_t au8_Reference[TEST_SIZE];
+  static uint8_t au8_Buffer[TEST_SIZE];
+  bool b_Ok;
+
+  referenceSequence(u8_Taps, au8_Reference, TEST_SIZE);
+
+  // whole buffer
+  memset(au8_Buffer, 0, TEST_SIZE);
+  Randomizer::apply(e_Sequence, au8_Buffer, TEST_SIZE);
+  b_Ok = (memcmp(au8_Buffer, au8_Reference, TEST_SIZE)==0);
+
+  // odd sizes and offsets, as used for split frames
+  memset(au8_Buffer, 0, TEST_SIZE);
+  for(uint32_t u32_Pos=0, u32_Chunk=1; u32_Pos<TEST_SIZE; u32_Pos+=u32_Chunk, u32_Chunk=u32_Chunk%37+3)
+  {
+    if(u32_Pos+u32_Chunk>TEST_SIZE)
+      u32_Chunk = TEST_SIZE-u32_Pos;
+    Randomizer::apply(e_Sequence, &au8_Buffer[u32_Pos], u32_Chunk, u32_Pos);
+  }
+  return b_Ok && (memcmp(au8_Buffer, au8_Reference, TEST_SIZE)==0);
+}
+#endif
+
+
+void setup() {
+  Serial.begin(9600);
+
+  // first bytes of the sequences as given in CCSDS 131.0-B-3 and CCSDS 231.0-B-3
+  const uint8_t au8_Tm[] = {0xff, 0x48, 0x0e, 0xc0, 0x9a, 0x0d, 0x70, 0xbc, 0x8e, 0x2c, 0x93, 0xad, 0xa7, 0xb7, 0x46, 0xce};
+  const uint8_t au8_Tc[] = {0xff, 0x39, 0x9e, 0x5a, 0x68, 0xe9, 0x06, 0xf5};
+  uint8_t au8_Buffer[sizeof(au8_Tm)];
+  bool b_Ok;
+
+  referenceSequence(0xa9, au8_Buffer, sizeof(au8_Tm));
+  check("TM reference generator", memcmp(au8_Buffer, au8_Tm, sizeof(au8_Tm))==0);
+  referenceSequence(0x5f, au8_Buffer, sizeof(au8_Tc));
+  check("TC reference generator", memcmp(au8_Buffer, au8_Tc, sizeof(au8_Tc))==0);
+
+#if TF_USE_RANDOMIZER == 1
+  memset(au8_Buffer, 0, sizeof(au8_Buffer));
+  Randomizer::apply(Randomizer::TmSequence, au8_Buffer, sizeof(au8_Tm));
+  check("TM sequence known bytes", memcmp(au8_Buffer, au8_Tm, sizeof(au8_Tm))==0);
+  memset(au8_Buffer, 0, sizeof(au8_Buffer));
+  Randomizer::apply(Randomizer::TcSequence, au8_Buffer, sizeof(au8_Tc));
+  check("TC sequence known bytes", memcmp(au8_Buffer, au8_Tc, sizeof(au8_Tc))==0);
+
+  check("TM sequence with period 255", checkSequence(Randomizer::TmSequence, 0xa9));
+  check("TC sequence with period 255", checkSequence(Randomizer::TcSequence, 0x5f));
+
+  // applying the sequence twice restores the data
+  for(uint8_t i=0; i<sizeof(au8_Buffer); i++)
+    au8_Buffer[i] = (uint8_t)(i*17);
+  Randomizer::apply(Randomizer::TmSequence, au8_Buffer, sizeof(au8_Buffer), 250);
+  b_Ok = (au8_Buffer[0]!=0);
+  Randomizer::apply(Randomizer::TmSequence, au8_Buffer, sizeof(au8_Buffer), 250);
+  for(uint8_t i=0; i<sizeof(au8_Buffer); i++)
+    b_Ok = b_Ok && (au8_Buffer[i]==(uint8_t)(i*17));
+  check("derandomization", b_Ok);
+#else
+  (void)b_Ok;
+  check("randomizer disabled (configTF_USE_RANDOMIZER)", true);
+#endif
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
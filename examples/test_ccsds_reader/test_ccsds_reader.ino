@@ -0,0 +1,189 @@
+/*
+  Self test of the pull based readers and views
+
+  Reads telecommand transfer frames which follow each other directly, as
+  decoded from CLTUs, and frames behind the synchronization marker, also
+  if a frame is split over two fed buffers. Checks the dropping of frames
+  with a wrong length or checksum, reads a telemetry transfer frame with
+  its marker and checks the telecommand packet view with and without PEC.
+  Prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define SCID      0x2a5
+#define VCID      3
+#define TC_APID   0x123
+
+
+uint16_t g_Failed = 0;
+
+uint8_t g_Stream[3*TF_SYNC_SIZE+3*TC_TF_MAX_SIZE];
+uint8_t g_Frame[TM_TF_TOTAL_SIZE+TF_SYNC_SIZE];
+
+TransferframeTcReader g_TcReader;
+TransferframeTmReader g_TmReader;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+/**
+ * @brief Appends a telecommand transfer frame with the given sequence number and 4 data bytes, optionally behind the marker
+ */
+uint32_t addTcFrame(const uint32_t u32_Pos, const uint8_t u8_FrameSeqNumber, const bool b_SyncMarker)
+{
+  const uint8_t au8_Sync[] = {0x1a, 0xcf, 0xfc, 0x1d};
+  const uint8_t au8_Data[] = {u8_FrameSeqNumber, 0x11, 0x22, 0x33};
+  uint32_t u32_Size = 0;
+
+  if(b_SyncMarker)
+  {
+    memcpy(&g_Stream[u32_Pos], au8_Sync, sizeof(au8_Sync));
+    u32_Size = sizeof(au8_Sync);
+  }
+  return u32_Size+TransferframeTc::create(&g_Stream[u32_Pos+u32_Size], sizeof(g_Stream)-u32_Pos-u32_Size, false, false,
+                                          SCID, VCID, u8_FrameSeqNumber, 0, au8_Data, sizeof(au8_Data));
+}
+
+
+/**
+ * @brief Reads all frames of the fed data and returns a bit mask of their sequence numbers, 0xffff if a frame has a wrong content
+ */
+uint16_t readTcFrames(void)
+{
+  TransferframeTcView S_Frame;
+  uint16_t u16_Read = 0;
+
+  while(g_TcReader.next(S_Frame))
+  {
+    if((S_Frame.getSpacecraftID()!=SCID) || (S_Frame.getVirtualChannelID()!=VCID) || (S_Frame.getFrameSeqNumber()>14) ||
+       (S_Frame.getDataSize()!=4) || (S_Frame.getData()[0]!=S_Frame.getFrameSeqNumber()) || (S_Frame.getData()[3]!=0x33))
+      return 0xffff;
+    u16_Read |= (uint16_t)(1<<S_Frame.getFrameSeqNumber());
+  }
+  return u16_Read;
+}
+
+
+void setup()
+{
+  uint8_t au8_Packet[16];
+  const uint8_t u8_Data = 0x5a;
+  uint32_t u32_Size;
+  uint32_t u32_FrameSize;
+  bool b_Ok;
+
+  Serial.begin(115200);
+  while(!Serial);
+
+  // without marker (default): the frames follow each other directly
+  u32_FrameSize = addTcFrame(0, 1, false);
+  u32_Size = u32_FrameSize;
+  u32_Size += addTcFrame(u32_Size, 2, false);
+  u32_Size += addTcFrame(u32_Size, 3, false);
+  g_TcReader.feed(g_Stream, u32_Size);
+  check("frames without marker", (u32_FrameSize>0) && (readTcFrames()==0x000e));
+
+  // a frame split over two fed buffers is assembled
+  g_TcReader.feed(g_Stream, u32_FrameSize+3);
+  check("first part", readTcFrames()==0x0002);
+  g_TcReader.feed(&g_Stream[u32_FrameSize+3], u32_Size-u32_FrameSize-3);
+  check("split frame", readTcFrames()==0x000c);
+
+  // a wrong checksum drops the frame; a wrong length drops the rest of the fed data
+  g_Stream[u32_FrameSize+5] ^= 0x01;
+  g_TcReader.feed(g_Stream, u32_Size);
+  check("wrong checksum", (readTcFrames()==0x000a) && (g_TcReader.getChecksumErrorCount()==1));
+  g_Stream[u32_FrameSize+5] ^= 0x01;
+  g_Stream[u32_FrameSize+2] |= 0x03;
+  g_Stream[u32_FrameSize+3] = 0xff;
+  g_TcReader.feed(g_Stream, u32_Size);
+  check("wrong length", (readTcFrames()==0x0002) && (g_TcReader.getOverflowErrorCount()==1));
+  g_TcReader.feed(&g_Stream[2*u32_FrameSize], u32_FrameSize);
+  check("next fed data", readTcFrames()==0x0008);
+
+  // with marker: leading bytes and bytes between the frames are skipped
+  g_TcReader.setSyncMarker(true);
+  g_TcReader.clearErrorCounters();
+  g_Stream[0] = 0x1a;
+  g_Stream[1] = 0x00;
+  u32_Size = 2;
+  u32_Size += addTcFrame(u32_Size, 4, true);
+  g_Stream[u32_Size++] = 0xaa;
+  u32_Size += addTcFrame(u32_Size, 5, true);
+  g_TcReader.feed(g_Stream, 7);
+  check("marker split", readTcFrames()==0);
+  g_TcReader.feed(&g_Stream[7], u32_Size-7);
+  check("frames with marker", (readTcFrames()==0x0030) && (g_TcReader.getChecksumErrorCount()==0) &&
+                              (g_TcReader.getOverflowErrorCount()==0));
+
+  // switching back drops the search state
+  g_TcReader.setSyncMarker(false);
+  u32_Size = addTcFrame(0, 6, false);
+  g_TcReader.feed(g_Stream, u32_Size);
+  check("marker disabled", readTcFrames()==0x0040);
+  g_TcReader.reset();
+  g_TcReader.feed(g_Stream, u32_Size);
+  check("reset", readTcFrames()==0x0040);
+
+  // the telemetry reader searches the marker
+  {
+    TransferframeTmView S_Frame;
+    const uint8_t au8_Frame[] = {0x1a, 0xcf, 0xfc, 0x1d, (uint8_t)(SCID>>4), (uint8_t)(((SCID&0x0f)<<4) | (VCID<<1)), 7, 8, 0x98, 0x00};
+    uint16_t u16_CRC;
+
+    memset(g_Frame, 0x55, sizeof(g_Frame));
+    memcpy(g_Frame, au8_Frame, sizeof(au8_Frame));
+    u16_CRC = Transferframe::calcCRC(&g_Frame[TF_SYNC_SIZE], TM_TF_TOTAL_SIZE-2);
+    g_Frame[sizeof(g_Frame)-2] = (uint8_t)(u16_CRC>>8);
+    g_Frame[sizeof(g_Frame)-1] = (uint8_t)u16_CRC;
+    g_TmReader.feed(g_Frame, sizeof(g_Frame));
+    b_Ok = g_TmReader.next(S_Frame);
+    check("telemetry frame", b_Ok && (S_Frame.getSpacecraftID()==SCID) && (S_Frame.getVirtualChannelID()==VCID) &&
+                             (S_Frame.getMasterChannelFrameCount()==7) && (S_Frame.getVirtualChannelFrameCount()==8) &&
+                             S_Frame.hasSecHeader() && (S_Frame.getData()[0]==0x55) && !g_TmReader.next(S_Frame));
+    g_TmReader.feed(&g_Frame[TF_SYNC_SIZE], TM_TF_TOTAL_SIZE);
+    check("telemetry frame without marker ignored", !g_TmReader.next(S_Frame));
+  }
+
+  // the telecommand view has no PEC by default, like Tc
+  u32_Size = PUS::Tc::createPacket(au8_Packet, sizeof(au8_Packet), TC_APID, 5, true, false, false, false, 17, 1, 9, &u8_Data, 1,
+                                   PUS_TC_DEFAULT_SEC_HEADER_SIZE, PUS::Tc::None);
+  {
+    PUS::TcView S_Tc(au8_Packet, u32_Size);
+
+    check("view without PEC", S_Tc.isValid() && S_Tc.isAckAcc() && (S_Tc.getService()==17) && (S_Tc.getSubService()==1) &&
+                              (S_Tc.getSourceID()==9) && (S_Tc.getDataSize()==1) && (S_Tc.getData()[0]==u8_Data));
+  }
+  u32_Size = PUS::Tc::createPacket(au8_Packet, sizeof(au8_Packet), TC_APID, 5, true, false, false, false, 17, 1, 9, &u8_Data, 1,
+                                   PUS_TC_DEFAULT_SEC_HEADER_SIZE, PUS::Tc::StandardCRC);
+  {
+    PUS::TcView S_Tc(au8_Packet, u32_Size, PUS_TC_DEFAULT_SEC_HEADER_SIZE, PUS::Tc::StandardCRC);
+
+    check("view with PEC", S_Tc.isValid() && (S_Tc.getDataSize()==1) && (S_Tc.getData()[0]==u8_Data));
+    au8_Packet[u32_Size-3] ^= 0x01;
+    check("wrong PEC", !S_Tc.isValid());
+  }
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,204 @@
+/*
+  Self test of the Reed-Solomon (255,223) code
+
+  Compares the check symbols with known vectors, corrects random symbol
+  errors in interleaved codeblocks, checks that an error pattern with a
+  single nonzero syndrome is rejected and prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+uint16_t g_Failed = 0;
+uint32_t g_Random = 1311;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+uint32_t nextRandom(void)
+{
+  g_Random = g_Random*1103515245UL+12345UL;
+  return g_Random>>8;
+}
+
+
+#if TF_RS_MAX_INTERLEAVE > 0
+// check symbols of the message 0, 1, ..., 222 in the conventional representation
+const uint8_t gau8_Conventional[ReedSolomon::ParitySize] = {
+  0x2f, 0xbd, 0x4f, 0xb4, 0x74, 0x84, 0x94, 0xb9, 0xac, 0xd5, 0x54, 0x62, 0x72, 0x12, 0xee, 0xb3,
+  0xeb, 0xed, 0x41, 0x19, 0x1d, 0xe1, 0xd3, 0x63, 0x20, 0xea, 0x49, 0x29, 0x0b, 0x25, 0xab, 0xcf};
+
+// check symbols of the message 0, 1, ..., 222 in the dual basis representation
+const uint8_t gau8_DualBasis[ReedSolomon::ParitySize] = {
+  0x4f, 0xfb, 0x92, 0xdd, 0x55, 0x7e, 0xc6, 0x7f, 0x27, 0xfb, 0x89, 0x82, 0xcf, 0x58, 0xf8, 0xfd,
+  0x02, 0x8a, 0xd1, 0x17, 0xfc, 0xef, 0x6b, 0x27, 0x93, 0xd0, 0x41, 0x88, 0x26, 0x57, 0x86, 0x51};
+
+// check symbols of the message 100, 101, ..., 222 with virtual fill, in the conventional representation
+const uint8_t gau8_Shortened[ReedSolomon::ParitySize] = {
+  0x8b, 0x4f, 0x81, 0xc3, 0x61, 0x87, 0x42, 0x3b, 0x2d, 0xdd, 0xdb, 0xb5, 0x8e, 0x11, 0x8b, 0xf8,
+  0xf5, 0x17, 0x4e, 0xd3, 0x7a, 0x58, 0x50, 0x7a, 0xae, 0x53, 0x17, 0x32, 0xac, 0xb7, 0xd1, 0x66};
+
+uint8_t gau8_Codeblock[2*ReedSolomon::CodewordSize];
+uint8_t gau8_Original[2*ReedSolomon::CodewordSize];
+
+
+// adds u8_Errors symbol errors at different positions to each codeword of the codeblock
+void addErrors(const uint16_t u16_Size, const uint8_t u8_InterleaveDepth, const uint8_t u8_Errors)
+{
+  for(uint8_t c=0; c<u8_InterleaveDepth; c++)
+  {
+    uint16_t u16_Start = (uint16_t)(nextRandom()%(u16_Size/u8_InterleaveDepth));
+    for(uint8_t e=0; e<u8_Errors; e++)
+    {
+      uint16_t u16_Symbol = (uint16_t)((u16_Start+e*7)%(u16_Size/u8_InterleaveDepth));
+      gau8_Codeblock[u16_Symbol*u8_InterleaveDepth+c] ^= (uint8_t)(1+nextRandom()%255);
+    }
+  }
+}
+
+
+/**
+ * @brief Multiplies two symbols in the conventional representation (field polynom x^8+x^7+x^2+x+1)
+ */
+uint8_t multiply(uint8_t u8_A, uint8_t u8_B)
+{
+  uint8_t u8_Product = 0;
+
+  while(u8_B)
+  {
+    if(u8_B&1)
+      u8_Product ^= u8_A;
+    u8_A = (uint8_t)((u8_A<<1) ^ ((u8_A&0x80)?0x87:0));
+    u8_B >>= 1;
+  }
+  return u8_Product;
+}
+
+
+/**
+ * @brief Adds the 32 symbol error pattern which vanishes at all roots of the generator except the one of syndrome u8_Syndrome
+ *
+ * The pattern is the product of (x+root) over the other 31 roots, added to the last 32 symbols of a conventional codeword.
+ */
+void addSingleSyndromeErrors(const uint8_t u8_Syndrome)
+{
+  uint8_t au8_Pattern[ReedSolomon::ParitySize] = {1};
+
+  for(uint8_t i=0; i<ReedSolomon::ParitySize; i++)
+  {
+    uint8_t u8_Root = 1;
+
+    if(i==u8_Syndrome)
+      continue;
+    for(uint16_t j=0; j<((112+i)*11)%255; j++)
+      u8_Root = multiply(u8_Root, 2);
+    for(uint8_t k=ReedSolomon::ParitySize-1; k>0; k--)
+      au8_Pattern[k] = au8_Pattern[k-1] ^ multiply(u8_Root, au8_Pattern[k]);
+    au8_Pattern[0] = multiply(u8_Root, au8_Pattern[0]);
+  }
+  for(uint8_t k=0; k<ReedSolomon::ParitySize; k++)
+    gau8_Codeblock[ReedSolomon::CodewordSize-1-k] ^= au8_Pattern[k];
+}
+#endif
+
+
+void setup() {
+  Serial.begin(9600);
+
+#if TF_RS_MAX_INTERLEAVE > 0
+  uint32_t u32_Size;
+  uint8_t u8_Depth = (ReedSolomon::MaxInterleaveDepth>=2)?2:1;
+  bool b_Ok;
+
+  // known vectors
+  for(uint8_t i=0; i<ReedSolomon::MessageSize; i++)
+    gau8_Codeblock[i] = i;
+  u32_Size = ReedSolomon::encode(gau8_Codeblock, sizeof(gau8_Codeblock), ReedSolomon::MessageSize, 1, false);
+  check("codeword size", u32_Size==ReedSolomon::CodewordSize);
+  check("conventional check symbols", memcmp(&gau8_Codeblock[ReedSolomon::MessageSize], gau8_Conventional, ReedSolomon::ParitySize)==0);
+
+  ReedSolomon::encode(gau8_Codeblock, sizeof(gau8_Codeblock), ReedSolomon::MessageSize, 1, true);
+  check("dual basis check symbols", memcmp(&gau8_Codeblock[ReedSolomon::MessageSize], gau8_DualBasis, ReedSolomon::ParitySize)==0);
+
+  for(uint8_t i=0; i<123; i++)
+    gau8_Codeblock[i] = (uint8_t)(100+i);
+  u32_Size = ReedSolomon::encode(gau8_Codeblock, sizeof(gau8_Codeblock), 123, 1, false);
+  check("virtual fill check symbols", (u32_Size==123+ReedSolomon::ParitySize)
+                                      && (memcmp(&gau8_Codeblock[123], gau8_Shortened, ReedSolomon::ParitySize)==0));
+
+  // interleaved codewords with the same message get the same check symbols
+  for(uint16_t i=0; i<ReedSolomon::MessageSize*u8_Depth; i++)
+    gau8_Codeblock[i] = (uint8_t)(i/u8_Depth);
+  ReedSolomon::encode(gau8_Codeblock, sizeof(gau8_Codeblock), (uint16_t)(ReedSolomon::MessageSize*u8_Depth), u8_Depth, true);
+  b_Ok = true;
+  for(uint16_t i=0; i<ReedSolomon::ParitySize*u8_Depth; i++)
+    b_Ok = b_Ok && (gau8_Codeblock[ReedSolomon::MessageSize*u8_Depth+i]==gau8_DualBasis[i/u8_Depth]);
+  check("interleaved check symbols", b_Ok);
+
+  // invalid parameters
+  check("buffer too small", ReedSolomon::encode(gau8_Codeblock, ReedSolomon::CodewordSize-1, ReedSolomon::MessageSize, 1)==0);
+  check("data size not a multiple of the depth", (u8_Depth<2) || (ReedSolomon::encode(gau8_Codeblock, sizeof(gau8_Codeblock), 101, 2)==0));
+  check("depth too large", ReedSolomon::encode(gau8_Codeblock, sizeof(gau8_Codeblock), 10, ReedSolomon::MaxInterleaveDepth+1)==0);
+
+  // error correction
+  for(uint16_t i=0; i<ReedSolomon::MessageSize*u8_Depth; i++)
+    gau8_Codeblock[i] = (uint8_t)nextRandom();
+  u32_Size = ReedSolomon::encode(gau8_Codeblock, sizeof(gau8_Codeblock), (uint16_t)(ReedSolomon::MessageSize*u8_Depth), u8_Depth);
+  memcpy(gau8_Original, gau8_Codeblock, u32_Size);
+  check("error-free codeblock", ReedSolomon::decode(gau8_Codeblock, (uint16_t)(ReedSolomon::MessageSize*u8_Depth), u8_Depth)==0);
+
+  b_Ok = true;
+  for(uint8_t u8_Errors=1; u8_Errors<=16; u8_Errors++)
+  {
+    addErrors((uint16_t)u32_Size, u8_Depth, u8_Errors);
+    b_Ok = b_Ok && (ReedSolomon::decode(gau8_Codeblock, (uint16_t)(ReedSolomon::MessageSize*u8_Depth), u8_Depth)==u8_Errors*u8_Depth)
+                && (memcmp(gau8_Codeblock, gau8_Original, u32_Size)==0);
+  }
+  check("up to 16 errors per codeword corrected", b_Ok);
+
+  // shortened codeblock
+  memcpy(gau8_Codeblock, gau8_Original, 100*u8_Depth);
+  u32_Size = ReedSolomon::encode(gau8_Codeblock, sizeof(gau8_Codeblock), (uint16_t)(100*u8_Depth), u8_Depth);
+  memcpy(gau8_Original, gau8_Codeblock, u32_Size);
+  addErrors((uint16_t)u32_Size, u8_Depth, 16);
+  check("shortened codeblock corrected", (ReedSolomon::decode(gau8_Codeblock, (uint16_t)(100*u8_Depth), u8_Depth)==16*u8_Depth)
+                                         && (memcmp(gau8_Codeblock, gau8_Original, u32_Size)==0));
+
+  // 17 errors exceed the capability of the code
+  addErrors((uint16_t)u32_Size, u8_Depth, 17);
+  check("uncorrectable codeblock detected", ReedSolomon::decode(gau8_Codeblock, (uint16_t)(100*u8_Depth), u8_Depth)==-2);
+
+  // 32 errors whose syndromes are all zero except one are uncorrectable, the error locator has no roots
+  b_Ok = true;
+  for(uint8_t u8_Syndrome=0; u8_Syndrome<ReedSolomon::ParitySize; u8_Syndrome++)
+  {
+    memset(gau8_Codeblock, 0, ReedSolomon::CodewordSize);
+    addSingleSyndromeErrors(u8_Syndrome);
+    b_Ok = b_Ok && (ReedSolomon::decode(gau8_Codeblock, ReedSolomon::MessageSize, 1, false)==-2);
+  }
+  check("single nonzero syndrome rejected", b_Ok);
+#else
+  check("Reed-Solomon disabled (configTF_RS_MAX_INTERLEAVE)", true);
+#endif
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
@@ -0,0 +1,179 @@
+/*
+  Self test of the lossless data compression (Rice)
+
+  Compares the code of small blocks with known encodings for each code
+  option (fundamental sequence, split samples, second extension, zero
+  blocks, no compression and the reference sample of the preprocessor),
+  decodes them and compresses random samples of different resolutions
+  without loss. Prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define SAMPLE_COUNT  300
+
+
+uint16_t g_Failed = 0;
+uint32_t g_Random = 4711;
+
+uint16_t g_Samples[SAMPLE_COUNT];
+uint16_t g_Decoded[SAMPLE_COUNT];
+uint8_t g_Code[2*SAMPLE_COUNT+16];
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+uint32_t nextRandom(void)
+{
+  g_Random = g_Random*1103515245UL+12345UL;
+  return g_Random>>8;
+}
+
+
+/**
+ * @brief Encodes the samples, compares the code with the expected one and decodes it again
+ */
+bool checkCode(Rice &rice, const uint16_t *pu16_Samples, const uint32_t u32_SampleCount,
+               const uint8_t *pu8_Expected, const uint32_t u32_ExpectedSize)
+{
+  uint32_t u32_Size = rice.encode(g_Code, sizeof(g_Code), pu16_Samples, u32_SampleCount);
+
+  if((u32_Size!=u32_ExpectedSize) || (memcmp(g_Code, pu8_Expected, u32_Size)!=0))
+    return false;
+  if(rice.decode(g_Code, u32_Size, g_Decoded, u32_SampleCount)!=0)
+    return false;
+  return memcmp(g_Decoded, pu16_Samples, u32_SampleCount*sizeof(uint16_t))==0;
+}
+
+
+/**
+ * @brief Compresses random samples around a slowly changing value and decodes them
+ *
+ * Signed samples are decoded sign-extended.
+ */
+bool checkRoundTrip(Rice &rice, const uint8_t u8_SampleSize, const bool b_Signed, const uint16_t u16_Noise)
+{
+  const uint16_t u16_Mask = (uint16_t)((1UL<<u8_SampleSize)-1);
+  const uint16_t u16_SignBit = (uint16_t)(1UL<<(u8_SampleSize-1));
+  uint32_t u32_Size;
+
+  for(uint16_t i=0; i<SAMPLE_COUNT; i++)
+  {
+    if(i%50<10)
+      g_Samples[i] = 0;     // zero blocks without the preprocessor
+    else if(i%50<20)
+      g_Samples[i] = (uint16_t)(nextRandom()&u16_Mask);
+    else
+      g_Samples[i] = (uint16_t)((u16_Mask/2+i+nextRandom()%(u16_Noise+1))&u16_Mask);
+  }
+  u32_Size = rice.encode(g_Code, sizeof(g_Code), g_Samples, SAMPLE_COUNT);
+  if((u32_Size==0) || (rice.decode(g_Code, u32_Size, g_Decoded, SAMPLE_COUNT)!=0))
+    return false;
+  for(uint16_t i=0; i<SAMPLE_COUNT; i++)
+  {
+    if(g_Decoded[i]!=((b_Signed && (g_Samples[i]&u16_SignBit))?(uint16_t)(g_Samples[i]|~u16_Mask):g_Samples[i]))
+      return false;
+  }
+  return true;
+}
+
+
+void setup() {
+  Serial.begin(9600);
+
+  // 8 bit samples, blocks of 8 samples, without the preprocessor
+  {
+    Rice rice(8, 8, 128, false);
+    const uint16_t au16_FS[] = {1, 0, 2, 1, 0, 0, 3, 1};
+    const uint8_t au8_FS[] = {0x2c, 0xb8, 0xa0};                 // ID 001, FS codes
+    const uint16_t au16_SE[] = {0, 0, 0, 1, 0, 0, 0, 0};
+    const uint8_t au8_SE[] = {0x19, 0xc0};                        // ID 0001, FS codes of the pairs
+    const uint16_t au16_Split[] = {12, 13, 14, 15, 12, 13, 14, 15};
+    const uint8_t au8_Split[] = {0x8a, 0xaa, 0xb2, 0xef, 0x2e, 0xe0}; // ID 100 (k=3), FS codes, 3 LSBs
+    const uint16_t au16_NC[] = {0xff, 0, 0xff, 0, 0xff, 0, 0xff, 0};
+    const uint8_t au8_NC[] = {0xff, 0xe0, 0x1f, 0xe0, 0x1f, 0xe0, 0x1f, 0xe0, 0x00}; // ID 111, samples
+    const uint8_t au8_Zero[] = {0x04, 0xb2, 0xe2, 0x80};          // ID 0000, FS(1) for 2 zero blocks, then the FS block
+    const uint8_t au8_ROS[] = {0x00, 0x80};                       // ID 0000, remainder of segment
+    uint16_t au16_Zero[24];
+
+    check("fundamental sequence", checkCode(rice, au16_FS, 8, au8_FS, sizeof(au8_FS)));
+    check("second extension", checkCode(rice, au16_SE, 8, au8_SE, sizeof(au8_SE)));
+    check("split samples", checkCode(rice, au16_Split, 8, au8_Split, sizeof(au8_Split)));
+    check("no compression", checkCode(rice, au16_NC, 8, au8_NC, sizeof(au8_NC)));
+    memset(au16_Zero, 0, sizeof(au16_Zero));
+    memcpy(&au16_Zero[16], au16_FS, sizeof(au16_FS));
+    check("zero blocks", checkCode(rice, au16_Zero, 24, au8_Zero, sizeof(au8_Zero)));
+    memset(g_Samples, 0, 64*sizeof(uint16_t));
+    check("remainder of segment, 8 blocks", checkCode(rice, g_Samples, 64, au8_ROS, sizeof(au8_ROS)));
+    check("last block filled up", (rice.encode(g_Code, sizeof(g_Code), au16_FS, 7)==3)
+                                  && (rice.decode(g_Code, 3, g_Decoded, 7)==0) && (memcmp(g_Decoded, au16_FS, 7*sizeof(uint16_t))==0));
+    check("truncated code rejected", rice.decode(au8_Split, sizeof(au8_Split)-2, g_Decoded, 8)==-1);
+    check("buffer too small", rice.encode(g_Code, 2, au16_Split, 8)==0);
+  }
+
+  // reference sample and unit-delay predictor: errors 1, 0, -1, 2, 0, 0, 1 are mapped to 2, 0, 1, 4, 0, 0, 2
+  {
+    Rice rice(8, 8, 1, true);
+    const uint16_t au16_Samples[] = {100, 101, 101, 100, 102, 102, 102, 103};
+    const uint8_t au8_Expected[] = {0x2c, 0x86, 0x87, 0x20};      // ID 001, reference sample 100, FS codes
+
+    check("reference sample", checkCode(rice, au16_Samples, 8, au8_Expected, sizeof(au8_Expected)));
+  }
+
+  check("invalid block size", Rice().setParameters(8, 12, 128)==-1);
+  check("invalid sample size", Rice().setParameters(17, 16, 128)==-1);
+
+  // lossless for all resolutions and block sizes, with and without the preprocessor
+  {
+    Rice rice;
+    bool b_Ok = true;
+
+    for(uint8_t u8_SampleSize=1; u8_SampleSize<=Rice::MaxSampleSize; u8_SampleSize++)
+    {
+      for(uint8_t u8_BlockSize=8; u8_BlockSize<=Rice::MaxBlockSize; u8_BlockSize*=2)
+      {
+        const bool b_Signed = (u8_SampleSize&1)?true:false;
+
+        rice.setParameters(u8_SampleSize, u8_BlockSize, (uint16_t)(1+u8_SampleSize%4), (u8_BlockSize&16)?false:true, b_Signed);
+        b_Ok = b_Ok && checkRoundTrip(rice, u8_SampleSize, b_Signed, (uint16_t)(u8_SampleSize*2));
+      }
+    }
+    check("round trip", b_Ok);
+  }
+
+  // space packet with the compressed samples
+  {
+    Rice rice(12, 16, 16);
+    uint32_t u32_Size;
+
+    for(uint16_t i=0; i<SAMPLE_COUNT; i++)
+      g_Samples[i] = (uint16_t)(2000+i/4);
+    u32_Size = rice.createPacket(g_Code, sizeof(g_Code), SpacePacket::TM, 0x42, 7, g_Samples, SAMPLE_COUNT);
+    check("packet", (u32_Size>SP_HEADER_SIZE) && (u32_Size<SAMPLE_COUNT/2)
+                    && (((g_Code[4]<<8) | g_Code[5])+1+SP_HEADER_SIZE==(int)u32_Size)
+                    && (rice.decode(&g_Code[SP_HEADER_SIZE], u32_Size-SP_HEADER_SIZE, g_Decoded, SAMPLE_COUNT)==0)
+                    && (memcmp(g_Decoded, g_Samples, sizeof(g_Samples))==0));
+  }
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
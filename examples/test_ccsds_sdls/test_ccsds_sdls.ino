@@ -0,0 +1,176 @@
+/*
+  Self test of the Space Data Link Security
+
+  Checks the AES block cipher with the examples of FIPS 197, the
+  authentication with the AES-CMAC examples of RFC 4493 and the
+  authenticated encryption with a known AES-GCM encoding, then
+  processes the secured frames and checks the anti-replay and the
+  MAC verification. Prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+uint16_t g_Failed = 0;
+
+#if SDLS_MAX_SA > 0
+Sdls g_Sdls;
+uint8_t g_Frame[64+Sdls::MaxMacSize+2];
+
+// RFC 4493, examples 2 to 4: key and the first 64 bytes of the message
+const uint8_t g_CmacKey[16] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+const uint8_t g_CmacMessage[64] = {0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+                                   0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+                                   0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+                                   0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10};
+const uint8_t g_Cmac16[16] = {0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44, 0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c};
+const uint8_t g_Cmac40[16] = {0xdf, 0xa6, 0x67, 0x47, 0xde, 0x9a, 0xe6, 0x30, 0x30, 0xca, 0x32, 0x61, 0x14, 0x97, 0xc8, 0x27};
+const uint8_t g_Cmac64[16] = {0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92, 0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe};
+
+// AES-GCM: 5 byte frame header, SPI 7 (128 bit key) or 8 (256 bit key), sequence number 0x2a (IV 0...0 0000002a),
+// 20 byte data d9 d8 ... c6; the 256 bit key is 00 01 ... 1f
+const uint8_t g_GcmKey128[16] = {0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08};
+const uint8_t g_GcmHeader[5] = {0x20, 0x03, 0x00, 0x2f, 0x00};
+const uint8_t g_GcmCipher128[20] = {0x0b, 0xbf, 0xcf, 0xb7, 0x26, 0xd7, 0x6e, 0x46, 0x3a, 0x9d,
+                                    0xcf, 0x4f, 0x56, 0xb2, 0xd6, 0x6e, 0xcd, 0x25, 0xb8, 0xbe};
+const uint8_t g_GcmTag128[16] = {0x4b, 0xd7, 0x4a, 0x83, 0xd7, 0xff, 0x86, 0xd3, 0xb4, 0x78, 0xf1, 0xb4, 0x88, 0x65, 0xdc, 0xfe};
+const uint8_t g_GcmCipher256[20] = {0xe1, 0x1d, 0x30, 0xa1, 0x98, 0x9c, 0x25, 0xe1, 0x90, 0x13,
+                                    0xa2, 0xb9, 0x07, 0xd5, 0x2e, 0xa5, 0x27, 0xa6, 0xb0, 0xc1};
+const uint8_t g_GcmTag256[16] = {0x0e, 0xd7, 0x66, 0x0d, 0x78, 0x47, 0xb1, 0xb6, 0x38, 0xc8, 0xf0, 0xd1, 0x0e, 0xd4, 0x66, 0xfd};
+#endif
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+#if SDLS_MAX_SA > 0
+/**
+ * @brief Encrypts the FIPS 197 plaintext 00112233... with the key 000102... of the given size
+ */
+bool checkAes(const uint8_t u8_KeySize, const uint8_t *pu8_Expected)
+{
+  Aes aes;
+  uint8_t au8_Key[Aes::MaxKeySize];
+  uint8_t au8_Block[Aes::BlockSize];
+
+  for(uint8_t i=0; i<u8_KeySize; i++)
+    au8_Key[i] = i;
+  for(uint8_t i=0; i<Aes::BlockSize; i++)
+    au8_Block[i] = (uint8_t)(i*0x11);
+  if(aes.setKey(au8_Key, u8_KeySize)!=0)
+    return false;
+  aes.encrypt(au8_Block, au8_Block);
+  return memcmp(au8_Block, pu8_Expected, Aes::BlockSize)==0;
+}
+
+
+/**
+ * @brief Authenticates the first bytes of the RFC 4493 message; the SPI and the sequence number are its first 6 bytes
+ *
+ * The frame has no header in front of the security header and a 2 byte trailer behind the MAC.
+ */
+bool checkCmac(const uint16_t u16_MessageSize, const uint8_t *pu8_Expected, const uint8_t u8_MacSize)
+{
+  uint16_t u16_FrameSize = (uint16_t)(u16_MessageSize+u8_MacSize+2);
+
+  memcpy(g_Frame, g_CmacMessage, u16_MessageSize);
+  g_Sdls.setSequenceNumbers(0x6bc1, 0xbee22e3f, 0);
+  return (g_Sdls.applySecurity(g_Frame, u16_FrameSize, 0, 2, 0x6bc1)==0)
+         && (memcmp(g_Frame, g_CmacMessage, u16_MessageSize)==0)
+         && (memcmp(&g_Frame[u16_MessageSize], pu8_Expected, u8_MacSize)==0);
+}
+
+
+/**
+ * @brief Encrypts the GCM example frame and compares the data and the MAC
+ */
+bool checkGcm(const uint16_t u16_SPI, const uint8_t *pu8_Cipher, const uint8_t *pu8_Tag)
+{
+  memcpy(g_Frame, g_GcmHeader, sizeof(g_GcmHeader));
+  for(uint8_t i=0; i<20; i++)
+    g_Frame[5+Sdls::HeaderSize+i] = (uint8_t)(0xd9-i);
+  g_Sdls.setSequenceNumbers(u16_SPI, 0x29, 0);
+  return (g_Sdls.applySecurity(g_Frame, 5+Sdls::HeaderSize+20+16+2, 5, 2, u16_SPI)==0)
+         && (g_Frame[5]==(u16_SPI>>8)) && (g_Frame[6]==(u16_SPI&0xff)) && (g_Frame[10]==0x2a)
+         && (memcmp(&g_Frame[5+Sdls::HeaderSize], pu8_Cipher, 20)==0)
+         && (memcmp(&g_Frame[5+Sdls::HeaderSize+20], pu8_Tag, 16)==0);
+}
+#endif
+
+
+void setup() {
+  Serial.begin(9600);
+
+#if SDLS_MAX_SA > 0
+  const uint8_t au8_Aes128[] = {0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a};
+  const uint8_t au8_Aes192[] = {0xdd, 0xa9, 0x7c, 0xa4, 0x86, 0x4c, 0xdf, 0xe0, 0x6e, 0xaf, 0x70, 0xa0, 0xec, 0x0d, 0x71, 0x91};
+  const uint8_t au8_Aes256[] = {0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89};
+  uint8_t au8_Key256[32];
+  uint8_t *pu8_Data;
+  uint16_t u16_DataSize;
+
+  // FIPS 197, appendix C
+  check("AES-128", checkAes(16, au8_Aes128));
+  check("AES-192", checkAes(24, au8_Aes192));
+  check("AES-256", checkAes(32, au8_Aes256));
+
+  // RFC 4493 with a full and a truncated MAC
+  g_Sdls.addSecurityAssociation(0x6bc1, 1, Sdls::Authentication, g_CmacKey, sizeof(g_CmacKey));
+  check("AES-CMAC 16 bytes", checkCmac(16, g_Cmac16, 16));
+  check("AES-CMAC 40 bytes", checkCmac(40, g_Cmac40, 16));
+  check("AES-CMAC 64 bytes", checkCmac(64, g_Cmac64, 16));
+  g_Sdls.removeSecurityAssociation(0x6bc1);
+  g_Sdls.addSecurityAssociation(0x6bc1, 1, Sdls::Authentication, g_CmacKey, sizeof(g_CmacKey), 8);
+  check("AES-CMAC truncated", checkCmac(40, g_Cmac40, 8) && (g_Sdls.getTrailerSize(0x6bc1)==8));
+
+  // authenticated frame: accepted once, a replay and a modified frame are rejected
+  checkCmac(40, g_Cmac40, 8);
+  check("CMAC frame accepted", (g_Sdls.processSecurity(g_Frame, 40+8+2, 0, 2, 1, &pu8_Data, &u16_DataSize)==0)
+                               && (pu8_Data==&g_Frame[Sdls::HeaderSize]) && (u16_DataSize==40-Sdls::HeaderSize));
+  check("replay rejected", (g_Sdls.processSecurity(g_Frame, 40+8+2, 0, 2, 1, &pu8_Data, &u16_DataSize)==-3)
+                           && (g_Sdls.getReplayErrorCount()==1));
+  g_Sdls.setSequenceNumbers(0x6bc1, 0xbee22e3f, 0);
+  g_Frame[20] ^= 0x01;
+  check("modified frame rejected", (g_Sdls.processSecurity(g_Frame, 40+8+2, 0, 2, 1, &pu8_Data, &u16_DataSize)==-4)
+                                   && (g_Sdls.getAuthErrorCount()==1));
+  check("other virtual channel rejected", (g_Sdls.processSecurity(g_Frame, 40+8+2, 0, 2, 2, &pu8_Data, &u16_DataSize)==-2)
+                                          && (g_Sdls.getSpiErrorCount()==1));
+
+  // AES-GCM with 128 and 256 bit keys
+  for(uint8_t i=0; i<32; i++)
+    au8_Key256[i] = i;
+  g_Sdls.addSecurityAssociation(7, 0, Sdls::AuthenticatedEncryption, g_GcmKey128, sizeof(g_GcmKey128));
+  g_Sdls.addSecurityAssociation(8, 0, Sdls::AuthenticatedEncryption, au8_Key256, sizeof(au8_Key256));
+  check("AES-GCM 128", checkGcm(7, g_GcmCipher128, g_GcmTag128));
+  check("AES-GCM decryption", (g_Sdls.processSecurity(g_Frame, 5+Sdls::HeaderSize+20+16+2, 5, 2, 0, &pu8_Data, &u16_DataSize)==0)
+                              && (u16_DataSize==20) && (pu8_Data[0]==0xd9) && (pu8_Data[19]==0xc6));
+  check("AES-GCM 256", checkGcm(8, g_GcmCipher256, g_GcmTag256));
+  g_Frame[0] ^= 0x01;
+  check("AES-GCM modified header rejected", g_Sdls.processSecurity(g_Frame, 5+Sdls::HeaderSize+20+16+2, 5, 2, 0,
+                                                                   &pu8_Data, &u16_DataSize)==-4);
+  check("exhausted sequence numbers", (g_Sdls.setSequenceNumbers(8, 0xffffffff, 0)==0)
+                                      && (g_Sdls.applySecurity(g_Frame, 5+Sdls::HeaderSize+20+16+2, 5, 2, 8)==-3));
+#else
+  check("SDLS disabled (configSDLS_MAX_SA)", true);
+#endif
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
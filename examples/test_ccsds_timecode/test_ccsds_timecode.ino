@@ -0,0 +1,159 @@
+/*
+  Self test of the CCSDS time codes
+
+  Compares CUC and CDS time codes with known encodings, checks that the
+  CUC fine time is truncated exactly, also next to the boundaries of
+  the binary fraction, and that decoded times are encoded to the same
+  code again. Prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+uint16_t g_Failed = 0;
+uint32_t g_Random = 4711;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+uint32_t nextRandom(void)
+{
+  g_Random = g_Random*1103515245UL+12345UL;
+  return g_Random>>8;
+}
+
+
+bool checkCode(const TimeCode &S_Time, const uint32_t u32_Seconds, const uint32_t u32_Nanoseconds,
+               const uint8_t *pu8_Expected, const uint8_t u8_ExpectedSize)
+{
+  uint8_t au8_Code[TimeCode::MaxSize];
+
+  return (S_Time.encode(au8_Code, sizeof(au8_Code), u32_Seconds, u32_Nanoseconds)==u8_ExpectedSize)
+         && (memcmp(au8_Code, pu8_Expected, u8_ExpectedSize)==0);
+}
+
+
+void setup() {
+  Serial.begin(9600);
+
+  // CUC with 4 coarse and 2 fine octets, half a second
+  {
+    const TimeCode S_Time(TimeCode::CUC, 4, 2);
+    const uint8_t au8_Expected[] = {0x12, 0x34, 0x56, 0x78, 0x80, 0x00};
+    uint32_t u32_Seconds, u32_Nanoseconds;
+
+    check("CUC known code", checkCode(S_Time, 0x12345678UL, 500000000UL, au8_Expected, sizeof(au8_Expected)));
+    check("CUC decode", (S_Time.decode(au8_Expected, sizeof(au8_Expected), &u32_Seconds, &u32_Nanoseconds)==6)
+                        && (u32_Seconds==0x12345678UL) && (u32_Nanoseconds==500000000UL));
+  }
+
+  // CUC with P-field (level 1: 0001, 4 coarse and 2 fine octets)
+  {
+    const TimeCode S_Time(TimeCode::CUC, 4, 2, true);
+    const uint8_t au8_Expected[] = {0x1e, 0x00, 0x00, 0x01, 0x00, 0x40, 0x00};
+
+    check("CUC P-field", (S_Time.getPField()==0x1e) && checkCode(S_Time, 256, 250000000UL, au8_Expected, sizeof(au8_Expected)));
+  }
+
+  // CUC fine time truncated: 433743 ns are 0x1c6c.ff... in units of 2^-24 s, 999999999 ns are 0xffffff.fb
+  {
+    const TimeCode S_Time(TimeCode::CUC, 1, 3);
+    const uint8_t au8_Boundary[] = {0x05, 0x00, 0x1c, 0x6c};
+    const uint8_t au8_Last[] = {0x05, 0xff, 0xff, 0xff};
+
+    check("CUC truncated next to a boundary", checkCode(S_Time, 5, 433743UL, au8_Boundary, sizeof(au8_Boundary)));
+    check("CUC last nanosecond", checkCode(S_Time, 5, 999999999UL, au8_Last, sizeof(au8_Last)));
+  }
+
+  // the 32 bit fraction is the truncated value for random times
+  {
+    const TimeCode S_Time(TimeCode::CUC, 4, 3);
+    uint8_t au8_Code[TimeCode::MaxSize];
+    bool b_Ok = true;
+
+    for(uint16_t i=0; b_Ok && (i<2000); i++)
+    {
+      const uint32_t u32_Nanoseconds = nextRandom()%1000000000UL;
+      const uint32_t u32_Fraction = (uint32_t)((((uint64_t)u32_Nanoseconds<<32)/1000000000UL)>>8);
+
+      b_Ok = (S_Time.encode(au8_Code, sizeof(au8_Code), 0, u32_Nanoseconds)==7)
+             && (au8_Code[4]==(uint8_t)(u32_Fraction>>16)) && (au8_Code[5]==(uint8_t)(u32_Fraction>>8))
+             && (au8_Code[6]==(uint8_t)u32_Fraction);
+    }
+    check("CUC truncation of random times", b_Ok);
+  }
+
+  // decoded fine times are encoded to the same code again, for all fine sizes
+  {
+    bool b_Ok = true;
+
+    for(uint8_t u8_FineSize=1; u8_FineSize<=3; u8_FineSize++)
+    {
+      const TimeCode S_Time(TimeCode::CUC, 2, u8_FineSize);
+      uint8_t au8_Code[TimeCode::MaxSize];
+      uint8_t au8_Again[TimeCode::MaxSize];
+      uint32_t u32_Seconds, u32_Nanoseconds;
+
+      for(uint16_t i=0; b_Ok && (i<3000); i++)
+      {
+        const uint32_t u32_Fine = (i<2)?(i?0x4726UL:0xffffffUL):nextRandom();   // 0x4726 is rounded down by the plain estimate
+
+        au8_Code[0] = (uint8_t)i;
+        au8_Code[1] = (uint8_t)(i>>8);
+        for(uint8_t j=0; j<u8_FineSize; j++)
+          au8_Code[2+j] = (uint8_t)(u32_Fine>>(8*(u8_FineSize-1-j)));
+        b_Ok = (S_Time.decode(au8_Code, S_Time.getSize(), &u32_Seconds, &u32_Nanoseconds)==S_Time.getSize())
+               && (S_Time.encode(au8_Again, sizeof(au8_Again), u32_Seconds, u32_Nanoseconds)==S_Time.getSize())
+               && (memcmp(au8_Code, au8_Again, S_Time.getSize())==0);
+      }
+    }
+    check("CUC re-encoding", b_Ok);
+  }
+
+  // CDS with P-field, 16 bit day and microseconds: day 3, 01:01:01.123456789
+  {
+    const TimeCode S_Time(TimeCode::CDS, 2, 2, true);
+    const uint8_t au8_Expected[] = {0x41, 0x00, 0x03, 0x00, 0x37, 0xdd, 0x43, 0x01, 0xc8};
+    uint32_t u32_Seconds, u32_Nanoseconds;
+    uint8_t au8_Code[TimeCode::MaxSize];
+
+    check("CDS known code", checkCode(S_Time, 3UL*86400UL+3661UL, 123456789UL, au8_Expected, sizeof(au8_Expected)));
+    check("CDS decode", (S_Time.decode(au8_Expected, sizeof(au8_Expected), &u32_Seconds, &u32_Nanoseconds)==9)
+                        && (u32_Seconds==3UL*86400UL+3661UL) && (u32_Nanoseconds==123456000UL));
+    memcpy(au8_Code, au8_Expected, sizeof(au8_Expected));
+    au8_Code[3] = 0x05;     // 86400999 ms
+    au8_Code[4] = 0x26;
+    au8_Code[5] = 0x5f;
+    au8_Code[6] = 0xe7;
+    check("CDS leap second", S_Time.decode(au8_Code, sizeof(au8_Expected), &u32_Seconds, &u32_Nanoseconds)==9);
+    au8_Code[6] = 0xe8;     // 86401000 ms
+    check("CDS invalid milliseconds", S_Time.decode(au8_Code, sizeof(au8_Expected), &u32_Seconds, &u32_Nanoseconds)==-1);
+    memcpy(au8_Code, au8_Expected, sizeof(au8_Expected));
+    au8_Code[0] = 0x42;
+    check("CDS wrong P-field", S_Time.decode(au8_Code, sizeof(au8_Expected), &u32_Seconds, &u32_Nanoseconds)==-1);
+    check("CDS too short", S_Time.decode(au8_Expected, sizeof(au8_Expected)-1, &u32_Seconds, &u32_Nanoseconds)==-1);
+  }
+
+  check("invalid format", TimeCode(TimeCode::CUC, 5, 0).encode(nullptr, 0, 0, 0)==0);
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
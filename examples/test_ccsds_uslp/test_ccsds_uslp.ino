@@ -0,0 +1,186 @@
+/*
+  Self test of the USLP transfer frames
+
+  Compares a frame with a known encoding, receives variable-length
+  frames from a stream and fixed-length frames without copying and
+  prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+#define FRAME_COUNT   40
+
+
+#if USLP_TF_MAX_SIZE > 0
+class TestReceiver : public TransferframeUslpActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  uint16_t mu16_Wrong = 0;
+  uint16_t mu16_ValidSize = 0xffff;   // fixed-length frames: the data is followed by fill bytes
+  UslpHeader mS_Header;
+
+  void onTransferframeUslpReceived(const UslpHeader &S_Header,
+                                   const uint8_t *pu8_InsertZone, const uint8_t u8_InsertZoneSize,
+                                   const uint8_t *pu8_Data, const uint16_t u16_DataSize)
+  {
+    bool b_Ok = (S_Header.u16_SpacecraftID==0xabcd) && ((u8_InsertZoneSize==0) || (pu8_InsertZone[0]==0x11));
+
+    for(uint16_t i=0; b_Ok && (i<u16_DataSize); i++)
+      b_Ok = (pu8_Data[i]==((i<mu16_ValidSize)?(uint8_t)(i+S_Header.u64_VcFrameCount):0xca));
+    mS_Header = S_Header;
+    mu16_Count++;
+    if(!b_Ok)
+      mu16_Wrong++;
+  }
+};
+#endif
+
+
+uint16_t g_Failed = 0;
+
+#if USLP_TF_MAX_SIZE > 0
+uint8_t g_Data[200];
+uint8_t g_Frame[4+250];
+#endif
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+#if USLP_TF_MAX_SIZE > 0
+UslpHeader header(const uint8_t u8_Frame)
+{
+  UslpHeader S_Header;
+
+  S_Header.u16_SpacecraftID = 0xabcd;
+  S_Header.b_DestinationFlag = (u8_Frame&1)?true:false;
+  S_Header.u8_VirtualChannelID = (uint8_t)(u8_Frame%64);
+  S_Header.u8_MAP = (uint8_t)(u8_Frame%16);
+  S_Header.b_BypassFlag = (u8_Frame&2)?true:false;
+  S_Header.b_CtrlCmdFlag = false;
+  S_Header.u8_VcFrameCountSize = (uint8_t)(1+u8_Frame%7);
+  S_Header.u64_VcFrameCount = u8_Frame;
+  S_Header.u8_ConstructionRule = TransferframeUslp::NoSegmentation;
+  S_Header.u8_ProtocolID = TransferframeUslp::SpacePacketProtocol;
+  S_Header.u16_FirstHdrPtr = 0;
+  S_Header.b_OcfFlag = (u8_Frame&4)?true:false;
+  S_Header.u32_OCF = 0xdeadbeef;
+  return S_Header;
+}
+#endif
+
+
+void setup() {
+  Serial.begin(9600);
+
+#if USLP_TF_MAX_SIZE > 0
+  uint32_t u32_Size;
+
+  for(uint8_t i=0; i<10; i++)
+    g_Data[i] = i;
+
+  // known frame: SCID 0xabcd, destination, VC 5, MAP 3, bypass, 2 byte VC frame count 0x1234, no OCF
+  {
+    const uint8_t au8_Expected[] = {0xca, 0xbc, 0xd8, 0xa6, 0x00, 0x15, 0x82, 0x12, 0x34, 0xe0,
+                                    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0xfb};
+    UslpHeader S_Header = header(0);
+
+    S_Header.b_DestinationFlag = true;
+    S_Header.u8_VirtualChannelID = 5;
+    S_Header.u8_MAP = 3;
+    S_Header.b_BypassFlag = true;
+    S_Header.u8_VcFrameCountSize = 2;
+    S_Header.u64_VcFrameCount = 0x1234;
+    S_Header.b_OcfFlag = false;
+    u32_Size = TransferframeUslp::create(g_Frame, sizeof(g_Frame), S_Header, g_Data, 10);
+    check("overhead", TransferframeUslp::getOverhead(2, TransferframeUslp::NoSegmentation, false)==u32_Size-10);
+#if TF_USE_FECF == 1
+    check("known frame", (u32_Size==sizeof(au8_Expected)) && (memcmp(g_Frame, au8_Expected, u32_Size)==0));
+#else
+    check("known frame", (u32_Size==sizeof(au8_Expected)-2) && (memcmp(g_Frame, au8_Expected, 4)==0)
+                         && (g_Frame[5]==0x13) && (memcmp(&g_Frame[6], &au8_Expected[6], u32_Size-6)==0));
+#endif
+  }
+
+  // variable-length frames with insert zone, fed in small chunks
+  {
+    const uint8_t au8_InsertZone[] = {0x11, 0x22, 0x33};
+    TestReceiver receiver;
+    TransferframeUslp uslp(&receiver);
+    bool b_Ok = true;
+
+    uslp.setInsertZoneSize(sizeof(au8_InsertZone));
+    for(uint8_t f=0; f<FRAME_COUNT; f++)
+    {
+      UslpHeader S_Header = header(f);
+      uint16_t u16_DataSize = (uint16_t)(1+(f*37)%sizeof(g_Data));
+
+      for(uint16_t i=0; i<u16_DataSize; i++)
+        g_Data[i] = (uint8_t)(i+f);
+      g_Frame[0] = 0x1a; g_Frame[1] = 0xcf; g_Frame[2] = 0xfc; g_Frame[3] = 0x1d;
+      u32_Size = 4+TransferframeUslp::create(&g_Frame[4], sizeof(g_Frame)-4, S_Header, g_Data, u16_DataSize,
+                                             0, au8_InsertZone, sizeof(au8_InsertZone));
+      for(uint32_t u32_Pos=0; u32_Pos<u32_Size; u32_Pos+=7)
+        uslp.process(&g_Frame[u32_Pos], (uint16_t)((u32_Size-u32_Pos<7)?(u32_Size-u32_Pos):7));
+
+      b_Ok = b_Ok && (receiver.mu16_Count==f+1) && (receiver.mS_Header.u8_VirtualChannelID==S_Header.u8_VirtualChannelID)
+                  && (receiver.mS_Header.u8_MAP==S_Header.u8_MAP) && (receiver.mS_Header.b_DestinationFlag==S_Header.b_DestinationFlag)
+                  && (receiver.mS_Header.b_BypassFlag==S_Header.b_BypassFlag) && (receiver.mS_Header.b_OcfFlag==S_Header.b_OcfFlag)
+                  && (!S_Header.b_OcfFlag || (receiver.mS_Header.u32_OCF==0xdeadbeef));
+    }
+    check("variable-length frames received", b_Ok && (receiver.mu16_Wrong==0));
+    check("no sync or checksum errors", (uslp.getSyncErrorCount()==0) && (uslp.getChecksumErrorCount()==0));
+  }
+
+  // fixed-length frames, checked in place
+  {
+    TestReceiver receiver;
+    TransferframeUslp uslp(&receiver);
+    UslpHeader S_Header = header(3);
+
+    for(uint16_t i=0; i<100; i++)
+      g_Data[i] = (uint8_t)(i+3);
+    uslp.setFrameSize(200);
+    receiver.mu16_ValidSize = 100;
+    u32_Size = TransferframeUslp::create(g_Frame, sizeof(g_Frame), S_Header, g_Data, 100, 200);
+    check("fixed-length frame size", u32_Size==200);
+    check("fixed-length frame received", (uslp.processFrame(g_Frame, 200)==0) && (receiver.mu16_Count==1)
+                                         && (receiver.mu16_Wrong==0));
+#if TF_USE_FECF == 1
+    g_Frame[50] ^= 0x01;
+    uslp.processFrame(g_Frame, 200);
+    check("corrupted frame rejected", (receiver.mu16_Count==1) && (uslp.getChecksumErrorCount()==1));
+    g_Frame[50] ^= 0x01;
+#endif
+    u32_Size = TransferframeUslp::create(g_Frame, sizeof(g_Frame), S_Header, g_Data, 100);
+    uslp.processFrame(g_Frame, (uint16_t)u32_Size);
+    check("frame with wrong size rejected", receiver.mu16_Count==1);
+  }
+
+  check("data too large", TransferframeUslp::create(g_Frame, sizeof(g_Frame), header(0), g_Data, 100, 50)==0);
+#else
+  check("USLP disabled (configUSLP_TF_MAX_SIZE)", true);
+#endif
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
@@ -0,0 +1,139 @@
+/*
+  Self test of the PUS housekeeping reports (service 3)
+
+  Defines housekeeping reports, generates them over time and prints the
+  result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace PUS;
+
+
+uint16_t g_Failed = 0;
+
+uint8_t g_Parameters[8] = {0x12, 0x34, 0xde, 0xad, 0xbe, 0xef, 0x01, 0x02};
+uint8_t g_Status = 0x77;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+// counts the reports of the given SID in the buffer
+uint16_t countReports(const uint8_t *pu8_Buffer, const uint32_t u32_Size, const uint8_t u8_SID)
+{
+  uint16_t u16_Count = 0;
+
+  for(uint32_t u32_Pos=0; u32_Pos<u32_Size; u32_Pos+=SP_HEADER_SIZE+((pu8_Buffer[u32_Pos+4]<<8) | pu8_Buffer[u32_Pos+5])+1)
+  {
+    if(pu8_Buffer[u32_Pos+SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE]==u8_SID)
+      u16_Count++;
+  }
+  return u16_Count;
+}
+
+
+void setup() {
+  Serial.begin(9600);
+
+  // 9 bytes in two adjacent parameters and one separate parameter
+  const uint8_t au8_Expected[] = {0x08, 0x50, 0xc0, 0x00, 0x00, 0x0c,
+                                  0x10, 0x03, 0x19,
+                                  0x01,
+                                  0x12, 0x34, 0xde, 0xad, 0xbe, 0xef, 0x01, 0x02,
+                                  0x77};
+  Housekeeping::Parameter aS_Report1[] = {{&g_Parameters[0], 2}, {&g_Parameters[2], 6}, {&g_Status, 1}};
+  Housekeeping::Parameter aS_Report2[] = {{&g_Status, 1}};
+  Housekeeping::Parameter aS_Invalid[] = {{nullptr, 1}};
+  Housekeeping hk;
+  uint8_t au8_Buffer[64];
+  uint32_t u32_Size;
+  uint32_t u32_Time;
+  uint16_t u16_Count;
+  bool b_Ok;
+
+  check("define report", hk.defineReport(1, 0x50, 10, aS_Report1, 3)==0);
+  check("define second report", hk.defineReport(2, 0x51, 5, aS_Report2, 1)==0);
+  check("invalid parameter rejected", hk.defineReport(3, 0x52, 5, aS_Invalid, 1)==-1);
+  check("empty report rejected", hk.defineReport(3, 0x52, 5, aS_Report2, 0)==-1);
+
+  // known packet
+  u32_Size = hk.generate(0, au8_Buffer, sizeof(au8_Buffer));
+  check("both reports generated", u32_Size==sizeof(au8_Expected)+SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE+2);
+  check("report content", memcmp(au8_Buffer, au8_Expected, sizeof(au8_Expected))==0);
+  check("nothing due", hk.generate(4, au8_Buffer, sizeof(au8_Buffer))==0);
+
+  // the parameters are sampled at the time of generation
+  g_Status = 0x78;
+  u32_Size = hk.generate(5, au8_Buffer, sizeof(au8_Buffer));
+  check("second report sampled", (countReports(au8_Buffer, u32_Size, 2)==1) && (countReports(au8_Buffer, u32_Size, 1)==0)
+                                 && (au8_Buffer[u32_Size-1]==0x78) && (au8_Buffer[3]==1));
+
+  // periods across the wrap-around of the onboard time, without drift
+  u16_Count = 0;
+  b_Ok = true;
+  hk.setReportEnabled(2, false);
+  hk.setReportEnabled(1, false);
+  hk.setReportEnabled(1, true);
+  for(u32_Time=0xffffff00UL; u32_Time!=0x100; u32_Time++)
+  {
+    u32_Size = hk.generate(u32_Time, au8_Buffer, sizeof(au8_Buffer));
+    if(u32_Size)
+    {
+      b_Ok = b_Ok && ((u32_Time-0xffffff00UL)%10==0);
+      u16_Count++;
+    }
+  }
+  check("periodic across the wrap-around", b_Ok && (u16_Count==52));
+
+  // missed reports are not caught up
+  hk.generate(0x200, au8_Buffer, sizeof(au8_Buffer));
+  check("no catch up", hk.generate(0x201, au8_Buffer, sizeof(au8_Buffer))==0);
+
+  // a report which does not fit stays due
+  hk.setReportEnabled(2, true);
+  u32_Size = hk.generate(0x20a, au8_Buffer, sizeof(au8_Expected));
+  check("report too large stays due", countReports(au8_Buffer, u32_Size, 1)==1);
+  u32_Size = hk.generate(0x20b, au8_Buffer, sizeof(au8_Buffer));
+  check("pending report generated", countReports(au8_Buffer, u32_Size, 2)==1);
+
+  // disable and enable by telecommand
+  {
+    uint8_t au8_Data[] = {2, 1, 2};
+
+    hk.onTcReceived(false, false, false, false, Tc::HousekeepingAndDiagnosticDataReportingService,
+                    Housekeeping::DisableReportGeneration, 0, au8_Data, sizeof(au8_Data));
+    check("disabled by (3,6)", hk.generate(0x300, au8_Buffer, sizeof(au8_Buffer))==0);
+    au8_Data[0] = 1;
+    hk.onTcReceived(false, false, false, false, Tc::HousekeepingAndDiagnosticDataReportingService,
+                    Housekeeping::EnableReportGeneration, 0, au8_Data, sizeof(au8_Data));
+    u32_Size = hk.generate(0x301, au8_Buffer, sizeof(au8_Buffer));
+    check("enabled by (3,5)", (countReports(au8_Buffer, u32_Size, 1)==1) && (countReports(au8_Buffer, u32_Size, 2)==0));
+  }
+
+  // redefinition, deletion and limits
+  check("redefine report", (hk.defineReport(1, 0x50, 10, aS_Report2, 1)==0)
+                           && (hk.generate(0x400, au8_Buffer, sizeof(au8_Buffer))==SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE+2));
+  check("delete report", (hk.deleteReport(1)==0) && (hk.deleteReport(1)==-1) && (hk.setReportEnabled(1, true)==-1));
+  for(u16_Count=0; (u16_Count<PUS_HK_MAX_REPORTS) && (hk.defineReport((uint8_t)(10+u16_Count), 0x60, 1, aS_Report2, 1)==0); u16_Count++)
+    ;
+  check("report limit", (u16_Count==PUS_HK_MAX_REPORTS-1) && (hk.defineReport(100, 0x60, 1, aS_Report2, 1)==-2));
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
@@ -0,0 +1,227 @@
+/*
+  Self test of the PUS large data transfer (service 13)
+
+  Receives a large data unit with a gap over the full reception window,
+  checks that the unsuccessfully received parts reports (13,15) fit into
+  space packets and list all missing parts, also if the buffer holds only
+  one report per call, then completes the unit and checks the received
+  data and the acknowledgement. Checks the timeout of an uplink and sends
+  a large data unit in parts with acknowledgements and repeated parts.
+  Prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace PUS;
+
+
+#define APID            0x0d0
+#define PART_SIZE       4
+#define WINDOW          LargeDataTransfer::WindowSize
+#define UNIT_SIZE       ((WINDOW+1)*PART_SIZE+2)
+#define MAX_MISSING     (((SP_MAX_DATA_SIZE-PUS_TM_SEC_HEADER_SIZE-2)/2<255)?(SP_MAX_DATA_SIZE-PUS_TM_SEC_HEADER_SIZE-2)/2:255)
+#define REPORT_OFFSET   (SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE)
+
+
+class TestReceiver : public LargeDataTransferActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  uint8_t mu8_ID = 0;
+  uint32_t mu32_Size = 0;
+  bool mb_DataOk = false;
+
+  void onLargeDataReceived(const uint8_t u8_LargeDataUnitID, const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    mu16_Count++;
+    mu8_ID = u8_LargeDataUnitID;
+    mu32_Size = u32_DataSize;
+    mb_DataOk = true;
+    for(uint32_t i=0; i<u32_DataSize; i++)
+      mb_DataOk = mb_DataOk && (pu8_Data[i]==(uint8_t)(i*3+1));
+  }
+};
+
+
+uint16_t g_Failed = 0;
+
+uint8_t g_Unit[UNIT_SIZE];
+uint8_t g_Pool[LargeDataTransfer::MaxTransactions*(UNIT_SIZE+PART_SIZE)];
+uint8_t g_Buffer[1024];
+uint8_t g_Listed[WINDOW+2];
+
+TestReceiver g_Receiver;
+LargeDataTransfer g_Transfer(APID, g_Pool, sizeof(g_Pool), &g_Receiver);
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+/**
+ * @brief Receives an uplink part of the test unit
+ */
+int32_t receive(const uint16_t u16_SequenceNumber, const bool b_Last = false)
+{
+  const uint32_t u32_Offset = (uint32_t)(u16_SequenceNumber-1)*PART_SIZE;
+
+  return g_Transfer.receivePart(b_Last?LargeDataTransfer::LastUplinkPart:LargeDataTransfer::IntermediateUplinkPart, 1,
+                                u16_SequenceNumber, &g_Unit[u32_Offset], b_Last?UNIT_SIZE-u32_Offset:PART_SIZE);
+}
+
+
+/**
+ * @brief Returns the subservice of the report at the given position
+ */
+uint8_t getSubService(const uint32_t u32_Pos)
+{
+  return g_Buffer[u32_Pos+8];
+}
+
+
+/**
+ * @brief Returns the size of the packet at the given position
+ */
+uint32_t getPacketSize(const uint32_t u32_Pos)
+{
+  return SP_HEADER_SIZE+((g_Buffer[u32_Pos+4]<<8) | g_Buffer[u32_Pos+5])+1;
+}
+
+
+/**
+ * @brief Sends a telecommand of service 13 with the large data unit ID and one or more 16 bit values
+ */
+void sendTc(const uint8_t u8_SubService, const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+{
+  g_Transfer.onTcReceived(false, false, false, false, Tc::LargeDataTransferService, u8_SubService, 0, pu8_Data, u32_DataSize);
+}
+
+
+void setup()
+{
+  const uint8_t au8_Downlink[] = {0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19};
+  uint32_t u32_Size;
+  uint32_t u32_Pos;
+  uint16_t u16_Reports;
+  uint16_t u16_Missing;
+  bool b_Ok;
+
+  Serial.begin(115200);
+  while(!Serial);
+
+  for(uint16_t i=0; i<UNIT_SIZE; i++)
+    g_Unit[i] = (uint8_t)(i*3+1);
+  g_Transfer.setTimeout(100);
+
+  // part 1 and the last part of the window; all parts between are missing
+  check("first part", (receive(1)==0) && g_Transfer.isReceiving(1));
+  check("part behind the window dropped", receive(WINDOW+2)==-3);
+  check("last part of the window", receive(WINDOW+1)==0);
+
+  // the reports of the missing parts are split at the packet size, each one fits into a space packet
+  u32_Size = g_Transfer.generate(1, g_Buffer, sizeof(g_Buffer));
+  u16_Reports = 0;
+  u16_Missing = 0;
+  b_Ok = true;
+  memset(g_Listed, 0, sizeof(g_Listed));
+  for(u32_Pos=0; u32_Pos+REPORT_OFFSET<u32_Size; u32_Pos+=getPacketSize(u32_Pos))
+  {
+    const uint8_t *pu8_Report = &g_Buffer[u32_Pos+REPORT_OFFSET];
+
+    b_Ok = b_Ok && (getSubService(u32_Pos)==LargeDataTransfer::UnsuccessfulPartsReport) && (pu8_Report[0]==1) &&
+           (pu8_Report[1]>0) && (pu8_Report[1]<=MAX_MISSING) && (getPacketSize(u32_Pos)<=SP_HEADER_SIZE+SP_MAX_DATA_SIZE) &&
+           (getPacketSize(u32_Pos)==(uint32_t)(REPORT_OFFSET+2+2*pu8_Report[1]));
+    for(uint8_t i=0; i<pu8_Report[1]; i++)
+    {
+      uint16_t u16_Part = (uint16_t)((pu8_Report[2+2*i]<<8) | pu8_Report[3+2*i]);
+      if(u16_Part<sizeof(g_Listed))
+        g_Listed[u16_Part]++;
+    }
+    u16_Missing += pu8_Report[1];
+    u16_Reports++;
+  }
+  for(uint16_t i=2; i<=WINDOW; i++)
+    b_Ok = b_Ok && (g_Listed[i]==1);
+  check("missing parts reports", b_Ok && (u32_Pos==u32_Size) && (u16_Missing==WINDOW-1) &&
+                                 (u16_Reports==(WINDOW-1+MAX_MISSING-1)/MAX_MISSING));
+
+  // with room for one report per call, the list is continued with the next call
+  check("part behind the window reported", receive(WINDOW+2)==-3);
+  memset(g_Listed, 0, sizeof(g_Listed));
+  u16_Missing = 0;
+  u16_Reports = 0;
+  b_Ok = true;
+  while(((u32_Size = g_Transfer.generate(2, g_Buffer, REPORT_OFFSET+2+2*MAX_MISSING))>0) && (u16_Reports<WINDOW))
+  {
+    const uint8_t *pu8_Report = &g_Buffer[REPORT_OFFSET];
+
+    b_Ok = b_Ok && (u32_Size==getPacketSize(0)) && (getSubService(0)==LargeDataTransfer::UnsuccessfulPartsReport);
+    for(uint8_t i=0; i<pu8_Report[1]; i++)
+    {
+      uint16_t u16_Part = (uint16_t)((pu8_Report[2+2*i]<<8) | pu8_Report[3+2*i]);
+      if(u16_Part<sizeof(g_Listed))
+        g_Listed[u16_Part]++;
+    }
+    u16_Missing += pu8_Report[1];
+    u16_Reports++;
+  }
+  for(uint16_t i=2; i<=WINDOW; i++)
+    b_Ok = b_Ok && (g_Listed[i]==1);
+  check("missing parts reports continued", b_Ok && (u16_Missing==WINDOW-1) && (u16_Reports==(WINDOW-1+MAX_MISSING-1)/MAX_MISSING));
+  for(uint16_t i=2; i<=WINDOW; i++)
+    receive(i);
+  check("window filled", g_Transfer.generate(3, g_Buffer, sizeof(g_Buffer))>0);
+
+  // the last part completes the unit
+  check("last part", (receive(WINDOW+2, true)==0) && !g_Transfer.isReceiving(1));
+  check("unit received", (g_Receiver.mu16_Count==1) && (g_Receiver.mu8_ID==1) && (g_Receiver.mu32_Size==UNIT_SIZE) && g_Receiver.mb_DataOk);
+  u32_Size = g_Transfer.generate(4, g_Buffer, sizeof(g_Buffer));
+  check("final acknowledgement", (u32_Size==REPORT_OFFSET+3) && (getSubService(0)==LargeDataTransfer::UplinkReceptionAck) &&
+                                 (g_Buffer[REPORT_OFFSET]==1) && (g_Buffer[REPORT_OFFSET+2]==WINDOW+2));
+
+  // timeout of an uplink
+  check("second unit", g_Transfer.receivePart(LargeDataTransfer::FirstUplinkPart, 2, 1, g_Unit, PART_SIZE)==0);
+  check("no timeout yet", g_Transfer.generate(103, g_Buffer, sizeof(g_Buffer))==0);
+  u32_Size = g_Transfer.generate(104, g_Buffer, sizeof(g_Buffer));
+  check("timeout", (u32_Size==REPORT_OFFSET+2) && (getSubService(0)==LargeDataTransfer::ReceptionAbortReport) &&
+                   (g_Buffer[REPORT_OFFSET]==2) && (g_Buffer[REPORT_OFFSET+1]==LargeDataTransfer::Timeout) && !g_Transfer.isReceiving(2));
+
+  // downlink in three parts
+  check("part size", g_Transfer.setPartSize(PART_SIZE)==0);
+  check("start downlink", (g_Transfer.startDownlink(5, au8_Downlink, sizeof(au8_Downlink))==0) && g_Transfer.isSending());
+  u32_Size = g_Transfer.generate(105, g_Buffer, sizeof(g_Buffer));
+  u32_Pos = getPacketSize(0);
+  check("downlink parts", (getSubService(0)==LargeDataTransfer::FirstDownlinkPart) &&
+                          (getSubService(u32_Pos)==LargeDataTransfer::IntermediateDownlinkPart) &&
+                          (getSubService(u32_Pos+getPacketSize(u32_Pos))==LargeDataTransfer::LastDownlinkPart) &&
+                          (u32_Size==3*(REPORT_OFFSET+3)+sizeof(au8_Downlink)) &&
+                          (g_Buffer[u32_Pos+REPORT_OFFSET+2]==2) && (memcmp(&g_Buffer[u32_Pos+REPORT_OFFSET+3], &au8_Downlink[4], 4)==0));
+  {
+    const uint8_t au8_Repeat[] = {5, 1, 0x00, 0x02};
+    const uint8_t au8_Ack[] = {5, 0x00, 0x03};
+
+    sendTc(LargeDataTransfer::RepeatParts, au8_Repeat, sizeof(au8_Repeat));
+    u32_Size = g_Transfer.generate(106, g_Buffer, sizeof(g_Buffer));
+    check("repeated part", (u32_Size==REPORT_OFFSET+3+4) && (getSubService(0)==LargeDataTransfer::RepeatedPart) &&
+                           (g_Buffer[REPORT_OFFSET+2]==2) && (memcmp(&g_Buffer[REPORT_OFFSET+3], &au8_Downlink[4], 4)==0));
+    sendTc(LargeDataTransfer::DownlinkReceptionAck, au8_Ack, sizeof(au8_Ack));
+    check("downlink acknowledged", !g_Transfer.isSending() && (g_Transfer.generate(107, g_Buffer, sizeof(g_Buffer))==0));
+  }
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+void loop()
+{
+}
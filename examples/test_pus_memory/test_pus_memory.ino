@@ -0,0 +1,235 @@
+/*
+  Self test of the PUS memory management (service 6)
+
+  Loads, dumps and checks memory regions with telecommands, compares the
+  checksum with the known CRC of "123456789", checks the dump and check
+  reports and the completion reports: a dump is completed when its last
+  report was created, a second check is rejected while the first report
+  is pending, and empty blocks are rejected. Prints the result of each
+  check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace PUS;
+
+
+#define APID          0x70
+#define TC_APID       0x071
+#define RAM_ID        1
+#define RAM_ADDRESS   0x1000UL
+#define ROM_ID        2
+#define ROM_ADDRESS   0x8000UL
+#define DUMP_SIZE     100
+#define PACKET_SIZE   32
+#define CHUNK_SIZE    (PACKET_SIZE-SP_HEADER_SIZE-PUS_TM_SEC_HEADER_SIZE-7-2)
+
+
+class TestReports : public VerificationActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  uint8_t mu8_SubService = 0;
+  uint32_t mu32_RequestID = 0;
+  uint8_t mu8_FailureCode = 0;
+
+  void onVerificationReport(const uint8_t *pu8_Packet, const uint16_t u16_PacketSize)
+  {
+    mu16_Count++;
+    mu8_SubService = pu8_Packet[8];
+    mu32_RequestID = ((uint32_t)pu8_Packet[9]<<24) | ((uint32_t)pu8_Packet[10]<<16) | ((uint32_t)pu8_Packet[11]<<8) | pu8_Packet[12];
+    mu8_FailureCode = (u16_PacketSize>13)?pu8_Packet[13]:0;
+  }
+};
+
+
+uint16_t g_Failed = 0;
+uint16_t g_SequenceCount = 0;
+
+uint8_t g_Ram[64];
+uint8_t g_Rom[200];
+
+TestReports g_Reports;
+Verification g_Verification(APID, &g_Reports);
+MemoryManagement g_Memory(APID);
+Tc g_Tc(&g_Memory);
+uint8_t g_Buffer[256];
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+/**
+ * @brief Sends a telecommand of service 6 which requests the completion report; returns its request ID
+ */
+uint32_t send(const uint8_t u8_SubService, const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+{
+  uint8_t au8_Packet[64];
+  uint32_t u32_Size;
+  uint16_t u16_SequenceCount = g_SequenceCount++;
+
+  u32_Size = Tc::createPacket(au8_Packet, sizeof(au8_Packet), TC_APID, u16_SequenceCount, false, false, false, true,
+                              Tc::MemoryManagementService, u8_SubService, 0, pu8_Data, u32_DataSize, PUS_TC_DEFAULT_SEC_HEADER_SIZE,
+                              Tc::None);
+  g_Tc.process(1, 3, TC_APID, u16_SequenceCount, true, &au8_Packet[SP_HEADER_SIZE], u32_Size-SP_HEADER_SIZE);
+  return ((uint32_t)au8_Packet[0]<<24) | ((uint32_t)au8_Packet[1]<<16) | ((uint32_t)au8_Packet[2]<<8) | au8_Packet[3];
+}
+
+
+/**
+ * @brief Sends a dump (6,5) or check (6,9) request
+ */
+uint32_t sendRequest(const uint8_t u8_SubService, const uint8_t u8_MemoryID, const uint32_t u32_Address, const uint32_t u32_Length)
+{
+  const uint8_t au8_Data[] = {u8_MemoryID,
+                              (uint8_t)(u32_Address>>24), (uint8_t)(u32_Address>>16), (uint8_t)(u32_Address>>8), (uint8_t)u32_Address,
+                              (uint8_t)(u32_Length>>24), (uint8_t)(u32_Length>>16), (uint8_t)(u32_Length>>8), (uint8_t)u32_Length};
+
+  return send(u8_SubService, au8_Data, sizeof(au8_Data));
+}
+
+
+/**
+ * @brief Sends a load request (6,2) with the given data and the correct or a wrong checksum
+ */
+uint32_t sendLoad(const uint8_t u8_MemoryID, const uint32_t u32_Address, const uint8_t *pu8_Data, const uint16_t u16_Length,
+                  const bool b_WrongChecksum = false)
+{
+  uint8_t au8_Data[32];
+  uint16_t u16_CRC = CCSDS::Transferframe::calcCRC(pu8_Data, u16_Length)^(b_WrongChecksum?1:0);
+
+  au8_Data[0] = u8_MemoryID;
+  au8_Data[1] = (uint8_t)(u32_Address>>24);
+  au8_Data[2] = (uint8_t)(u32_Address>>16);
+  au8_Data[3] = (uint8_t)(u32_Address>>8);
+  au8_Data[4] = (uint8_t)u32_Address;
+  au8_Data[5] = (uint8_t)(u16_Length>>8);
+  au8_Data[6] = (uint8_t)u16_Length;
+  memcpy(&au8_Data[7], pu8_Data, u16_Length);
+  au8_Data[7+u16_Length] = (uint8_t)(u16_CRC>>8);
+  au8_Data[8+u16_Length] = (uint8_t)u16_CRC;
+  return send(MemoryManagement::LoadMemory, au8_Data, 9+u16_Length);
+}
+
+
+/**
+ * @brief Checks that the last verification report is the given one
+ */
+bool isReport(const uint16_t u16_Count, const uint8_t u8_SubService, const uint32_t u32_RequestID, const uint8_t u8_FailureCode = 0)
+{
+  return (g_Reports.mu16_Count==u16_Count) && (g_Reports.mu8_SubService==u8_SubService) &&
+         (g_Reports.mu32_RequestID==u32_RequestID) && (g_Reports.mu8_FailureCode==u8_FailureCode);
+}
+
+
+void setup()
+{
+  const uint8_t au8_Load[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  uint16_t u16_Count;
+  uint16_t u16_Checksum;
+  uint32_t u32_RequestID;
+  uint32_t u32_Size;
+  uint32_t u32_Dumped;
+  bool b_Ok;
+
+  Serial.begin(115200);
+  while(!Serial);
+
+  for(uint16_t i=0; i<sizeof(g_Rom); i++)
+    g_Rom[i] = (uint8_t)(i*7+3);
+  check("define regions", (g_Memory.defineRegion(RAM_ID, RAM_ADDRESS, g_Ram, sizeof(g_Ram), true)==0) &&
+                          (g_Memory.defineRegion(ROM_ID, ROM_ADDRESS, g_Rom, sizeof(g_Rom), false)==0));
+  check("packet size", (g_Memory.setPacketSize(12)==-1) && (g_Memory.setPacketSize(PACKET_SIZE)==0));
+  g_Tc.setVerification(&g_Verification);
+  g_Memory.setVerification(&g_Verification);
+
+  // load
+  u32_RequestID = sendLoad(RAM_ID, RAM_ADDRESS+4, au8_Load, sizeof(au8_Load));
+  check("load completed", isReport(1, Verification::CompletionSuccess, u32_RequestID) &&
+                          (memcmp(&g_Ram[4], au8_Load, sizeof(au8_Load))==0));
+  check("known checksum", (g_Memory.check(RAM_ID, RAM_ADDRESS+4, sizeof(au8_Load), &u16_Checksum)==0) && (u16_Checksum==0x29b1));
+  u32_RequestID = sendLoad(RAM_ID, RAM_ADDRESS+20, au8_Load, sizeof(au8_Load), true);
+  check("wrong load checksum rejected", isReport(2, Verification::CompletionFailure, u32_RequestID, MemoryManagement::ChecksumError) &&
+                                        (g_Ram[20]==0) && (g_Memory.getChecksumErrorCount()==1));
+  u32_RequestID = sendLoad(ROM_ID, ROM_ADDRESS, au8_Load, sizeof(au8_Load));
+  check("read-only region rejected", isReport(3, Verification::CompletionFailure, u32_RequestID, MemoryManagement::InvalidAddress) &&
+                                     (g_Rom[0]==3) && (g_Memory.getAddressErrorCount()==1));
+  u32_RequestID = sendLoad(RAM_ID, RAM_ADDRESS+60, au8_Load, sizeof(au8_Load));
+  check("load beyond the region rejected", isReport(4, Verification::CompletionFailure, u32_RequestID, MemoryManagement::InvalidAddress));
+  u32_RequestID = sendLoad(RAM_ID, RAM_ADDRESS, au8_Load, 0);
+  check("empty load rejected", isReport(5, Verification::CompletionFailure, u32_RequestID, MemoryManagement::InvalidRequest));
+
+  // dump: the completion is reported with the last dump report
+  u32_RequestID = sendRequest(MemoryManagement::DumpMemory, ROM_ID, ROM_ADDRESS+10, DUMP_SIZE);
+  check("dump started without completion", g_Memory.isDumping() && (g_Reports.mu16_Count==5));
+  u16_Count = g_Reports.mu16_Count;
+  check("second dump rejected", (sendRequest(MemoryManagement::DumpMemory, ROM_ID, ROM_ADDRESS, 10)!=0) &&
+                                (g_Reports.mu16_Count==u16_Count+1) && (g_Reports.mu8_FailureCode==MemoryManagement::DumpRunning));
+  u16_Count = g_Reports.mu16_Count;
+  u32_Dumped = 0;
+  b_Ok = true;
+  while(g_Memory.isDumping() && b_Ok)
+  {
+    const uint8_t *pu8_Block = &g_Buffer[SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE];
+    uint32_t u32_Length;
+
+    // one report per call
+    b_Ok = (g_Reports.mu16_Count==u16_Count);
+    u32_Size = g_Memory.generate(g_Buffer, PACKET_SIZE);
+    u32_Length = ((uint32_t)pu8_Block[5]<<8) | pu8_Block[6];
+    b_Ok = b_Ok && (u32_Size==SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE+7+u32_Length+2) && (u32_Length<=CHUNK_SIZE) &&
+           (g_Buffer[7]==Tc::MemoryManagementService) && (g_Buffer[8]==MemoryManagement::MemoryDumpReport) &&
+           (pu8_Block[0]==ROM_ID) && (((uint32_t)pu8_Block[3]<<8 | pu8_Block[4])==ROM_ADDRESS+10+u32_Dumped) &&
+           (memcmp(&pu8_Block[7], &g_Rom[10+u32_Dumped], u32_Length)==0) &&
+           (CCSDS::Transferframe::calcCRC(&pu8_Block[7], u32_Length+2)==0);
+    u32_Dumped += u32_Length;
+  }
+  check("dump reports", b_Ok && (u32_Dumped==DUMP_SIZE));
+  check("dump completed with the last report", isReport(u16_Count+1, Verification::CompletionSuccess, u32_RequestID));
+  check("nothing left", g_Memory.generate(g_Buffer, sizeof(g_Buffer))==0);
+
+  u32_RequestID = sendRequest(MemoryManagement::DumpMemory, ROM_ID, ROM_ADDRESS, DUMP_SIZE);
+  g_Memory.generate(g_Buffer, PACKET_SIZE);
+  g_Memory.abortDump();
+  check("aborted dump", !g_Memory.isDumping() && isReport(u16_Count+2, Verification::CompletionFailure, u32_RequestID,
+                                                           MemoryManagement::DumpAborted));
+  u32_RequestID = sendRequest(MemoryManagement::DumpMemory, ROM_ID, ROM_ADDRESS, 0);
+  check("empty dump rejected", !g_Memory.isDumping() && isReport(u16_Count+3, Verification::CompletionFailure, u32_RequestID,
+                                                                 MemoryManagement::InvalidRequest));
+  u32_RequestID = sendRequest(MemoryManagement::DumpMemory, ROM_ID, ROM_ADDRESS+190, 11);
+  check("dump beyond the region rejected", isReport(u16_Count+4, Verification::CompletionFailure, u32_RequestID,
+                                                    MemoryManagement::InvalidAddress));
+
+  // check: a second check is rejected until the report was created
+  u16_Count = g_Reports.mu16_Count;
+  u32_RequestID = sendRequest(MemoryManagement::CheckMemory, RAM_ID, RAM_ADDRESS+4, sizeof(au8_Load));
+  check("check completed", isReport(u16_Count+1, Verification::CompletionSuccess, u32_RequestID));
+  u32_RequestID = sendRequest(MemoryManagement::CheckMemory, ROM_ID, ROM_ADDRESS, 10);
+  check("second check rejected", isReport(u16_Count+2, Verification::CompletionFailure, u32_RequestID, MemoryManagement::CheckPending));
+  u32_Size = g_Memory.generate(g_Buffer, sizeof(g_Buffer));
+  check("check report", (u32_Size==SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE+9+2) && (g_Buffer[8]==MemoryManagement::MemoryCheckReport) &&
+                        (g_Buffer[9]==RAM_ID) && (g_Buffer[13]==0x04) && (g_Buffer[17]==sizeof(au8_Load)) &&
+                        (g_Buffer[18]==0x29) && (g_Buffer[19]==0xb1));
+  u32_RequestID = sendRequest(MemoryManagement::CheckMemory, ROM_ID, ROM_ADDRESS, 10);
+  check("check after the report", isReport(u16_Count+3, Verification::CompletionSuccess, u32_RequestID));
+  u32_RequestID = sendRequest(MemoryManagement::CheckMemory, RAM_ID, RAM_ADDRESS, 0);
+  check("empty check rejected", isReport(u16_Count+4, Verification::CompletionFailure, u32_RequestID, MemoryManagement::InvalidRequest));
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+void loop()
+{
+}
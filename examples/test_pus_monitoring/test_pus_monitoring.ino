@@ -0,0 +1,204 @@
+/*
+  Self test of the PUS onboard monitoring (service 12)
+
+  Monitors parameters with limit and delta checks, compares the check
+  transition reports (12,12) with known packets, checks the repetition
+  number, the splitting of many transitions into several reports, the
+  delayed reporting if the buffer is too small and the telecommands to
+  enable and disable monitors and to clear the monitoring list. Prints
+  the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace PUS;
+
+
+#define APID            0x60
+#define MONITOR_COUNT   ((Monitoring::MaxMonitors<40)?Monitoring::MaxMonitors:40)
+#define TRANSITIONS     ((SP_MAX_DATA_SIZE-PUS_TM_SEC_HEADER_SIZE-1)/16)
+#define REPORT_OFFSET   (SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE)
+
+
+uint16_t g_Failed = 0;
+
+int32_t g_Temperature = 20;
+int32_t g_Counter = 0;
+int32_t g_Values[40];
+
+Monitoring g_Monitoring(APID);
+uint8_t g_Buffer[1024];
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+/**
+ * @brief Returns the 32 bit big endian value at the given position
+ */
+uint32_t getUint32(const uint8_t *pu8_Buffer)
+{
+  return ((uint32_t)pu8_Buffer[0]<<24) | ((uint32_t)pu8_Buffer[1]<<16) | ((uint32_t)pu8_Buffer[2]<<8) | pu8_Buffer[3];
+}
+
+
+/**
+ * @brief Checks that the buffer holds exactly one report with one transition of the given content
+ */
+bool isTransition(const uint32_t u32_Size, const uint16_t u16_ParameterID, const int32_t i32_Value, const int32_t i32_Limit,
+                  const uint8_t u8_Previous, const uint8_t u8_Current, const uint32_t u32_Time)
+{
+  const uint8_t *pu8_Transition = &g_Buffer[REPORT_OFFSET+1];
+
+  return (u32_Size==REPORT_OFFSET+1+16) && (g_Buffer[REPORT_OFFSET]==1) &&
+         (((pu8_Transition[0]<<8) | pu8_Transition[1])==u16_ParameterID) &&
+         ((int32_t)getUint32(&pu8_Transition[2])==i32_Value) && ((int32_t)getUint32(&pu8_Transition[6])==i32_Limit) &&
+         (pu8_Transition[10]==u8_Previous) && (pu8_Transition[11]==u8_Current) && (getUint32(&pu8_Transition[12])==u32_Time);
+}
+
+
+/**
+ * @brief Sends a telecommand (12,1) or (12,2) for one parameter
+ */
+void setEnabled(const uint16_t u16_ParameterID, const bool b_Enabled)
+{
+  const uint8_t au8_Data[] = {1, (uint8_t)(u16_ParameterID>>8), (uint8_t)u16_ParameterID};
+
+  g_Monitoring.onTcReceived(false, false, false, false, Tc::OnboardMonitoringService,
+                            b_Enabled?Monitoring::EnableMonitoring:Monitoring::DisableMonitoring, 0, au8_Data, sizeof(au8_Data));
+}
+
+
+void setup()
+{
+  const uint8_t au8_Expected[] =
+  {
+    0x08, 0x60, 0xc0, 0x00, 0x00, 0x13,   // TM, APID 0x60, sequence count 0, 20 bytes
+    0x10, 0x0c, 0x0c,                     // (12,12)
+    0x01,                                 // one transition
+    0x01, 0x01,                           // parameter ID 0x101
+    0x00, 0x00, 0x00, 0x33,               // value 51
+    0x00, 0x00, 0x00, 0x32,               // high limit 50
+    0x00, 0x02,                           // within limits -> above high limit
+    0x00, 0x00, 0x00, 0x02                // time 2
+  };
+  uint32_t u32_Size;
+  uint32_t u32_Pos;
+  uint16_t u16_Reports;
+  uint16_t u16_Transitions;
+  bool b_Ok;
+
+  Serial.begin(115200);
+  while(!Serial);
+
+  check("null parameter rejected", g_Monitoring.defineMonitor(0x101, nullptr, Monitoring::LimitCheck, 0, 50)==-1);
+  check("limits rejected", g_Monitoring.defineMonitor(0x101, &g_Temperature, Monitoring::LimitCheck, 50, 0)==-1);
+  check("define limit check", g_Monitoring.defineMonitor(0x101, &g_Temperature, Monitoring::LimitCheck, -10, 50, 2)==0);
+  check("unchecked", g_Monitoring.getStatus(0x101)==Monitoring::Unchecked);
+
+  // the first status within the limits is not reported
+  check("first check", g_Monitoring.check(0, g_Buffer, sizeof(g_Buffer))==0);
+  check("not confirmed", g_Monitoring.getStatus(0x101)==Monitoring::Unchecked);
+  check("second check", g_Monitoring.check(1, g_Buffer, sizeof(g_Buffer))==0);
+  check("within limits", g_Monitoring.getStatus(0x101)==Monitoring::WithinLimits);
+
+  // the violation must be seen twice
+  g_Temperature = 51;
+  check("one violation not reported", g_Monitoring.check(1, g_Buffer, sizeof(g_Buffer))==0);
+  u32_Size = g_Monitoring.check(2, g_Buffer, sizeof(g_Buffer));
+  check("known report", (u32_Size==sizeof(au8_Expected)) && (memcmp(g_Buffer, au8_Expected, sizeof(au8_Expected))==0));
+  check("above high limit", g_Monitoring.getStatus(0x101)==Monitoring::AboveHighLimit);
+  check("reported once", g_Monitoring.check(3, g_Buffer, sizeof(g_Buffer))==0);
+
+  // a single sample within the limits does not end the violation
+  g_Temperature = 20;
+  g_Monitoring.check(4, g_Buffer, sizeof(g_Buffer));
+  g_Temperature = 60;
+  check("glitch ignored", (g_Monitoring.check(5, g_Buffer, sizeof(g_Buffer))==0) && (g_Monitoring.getStatus(0x101)==Monitoring::AboveHighLimit));
+
+  // back within the limits, reported with the crossed limit; delayed if the buffer is too small
+  g_Temperature = 0;
+  g_Monitoring.check(6, g_Buffer, sizeof(g_Buffer));
+  check("buffer too small", (g_Monitoring.check(7, g_Buffer, REPORT_OFFSET+16)==0) && (g_Monitoring.getStatus(0x101)==Monitoring::AboveHighLimit));
+  u32_Size = g_Monitoring.check(8, g_Buffer, sizeof(g_Buffer));
+  check("delayed report", isTransition(u32_Size, 0x101, 0, 50, Monitoring::AboveHighLimit, Monitoring::WithinLimits, 8));
+  check("sequence count", (((g_Buffer[2]<<8) | g_Buffer[3])&0x3fff)==1);
+
+  g_Temperature = -11;
+  g_Monitoring.check(9, g_Buffer, sizeof(g_Buffer));
+  u32_Size = g_Monitoring.check(10, g_Buffer, sizeof(g_Buffer));
+  check("below low limit", isTransition(u32_Size, 0x101, -11, -10, Monitoring::WithinLimits, Monitoring::BelowLowLimit, 10));
+
+  // delta check: the difference of consecutive samples is checked
+  check("define delta check", g_Monitoring.defineMonitor(0x102, &g_Counter, Monitoring::DeltaCheck, 0, 5)==0);
+  g_Counter = 5;
+  check("delta within limits", (g_Monitoring.check(11, g_Buffer, sizeof(g_Buffer))==0) &&
+                               (g_Monitoring.getStatus(0x102)==Monitoring::WithinLimits));
+  g_Counter = 11;
+  u32_Size = g_Monitoring.check(12, g_Buffer, sizeof(g_Buffer));
+  check("delta above high limit", isTransition(u32_Size, 0x102, 11, 5, Monitoring::WithinLimits, Monitoring::AboveHighLimit, 12));
+  g_Counter = 10;
+  u32_Size = g_Monitoring.check(13, g_Buffer, sizeof(g_Buffer));
+  check("delta below low limit", isTransition(u32_Size, 0x102, 10, 0, Monitoring::AboveHighLimit, Monitoring::BelowLowLimit, 13));
+
+  // disabled monitors are unchecked and not reported
+  setEnabled(0x102, false);
+  g_Counter = 100;
+  check("disabled", (g_Monitoring.check(14, g_Buffer, sizeof(g_Buffer))==0) && (g_Monitoring.getStatus(0x102)==Monitoring::Unchecked));
+  setEnabled(0x102, true);
+  g_Counter = 200;
+  u32_Size = g_Monitoring.check(15, g_Buffer, sizeof(g_Buffer));
+  check("enabled again", isTransition(u32_Size, 0x102, 200, 5, Monitoring::Unchecked, Monitoring::AboveHighLimit, 15));
+
+  // deleting the first monitor keeps the status of the moved one
+  check("delete", (g_Monitoring.deleteMonitor(0x101)==0) && (g_Monitoring.deleteMonitor(0x101)==-1));
+  check("moved monitor kept", g_Monitoring.getStatus(0x102)==Monitoring::AboveHighLimit);
+  g_Monitoring.onTcReceived(false, false, false, false, Tc::OnboardMonitoringService, Monitoring::ClearMonitoringList, 0, nullptr, 0);
+  check("monitoring list cleared", (g_Monitoring.getStatus(0x102)==Monitoring::Unchecked) &&
+                                   (g_Monitoring.check(16, g_Buffer, sizeof(g_Buffer))==0));
+
+  // many transitions are split into several reports
+  b_Ok = true;
+  for(uint16_t i=0; i<MONITOR_COUNT; i++)
+  {
+    g_Values[i] = 0;
+    b_Ok = b_Ok && (g_Monitoring.defineMonitor((uint16_t)(0x200+i), &g_Values[i], Monitoring::LimitCheck, 0, 0)==0);
+  }
+  check("define all monitors", b_Ok);
+  check("maximum number of monitors", (MONITOR_COUNT<Monitoring::MaxMonitors) ||
+                                      (g_Monitoring.defineMonitor(0x300, &g_Temperature, Monitoring::LimitCheck, 0, 0)==-2));
+  g_Monitoring.check(17, g_Buffer, sizeof(g_Buffer));
+  for(uint16_t i=0; i<MONITOR_COUNT; i++)
+    g_Values[i] = 1;
+  u32_Size = g_Monitoring.check(18, g_Buffer, sizeof(g_Buffer));
+  u16_Reports = 0;
+  u16_Transitions = 0;
+  b_Ok = true;
+  for(u32_Pos=0; u32_Pos+REPORT_OFFSET<u32_Size; u32_Pos+=SP_HEADER_SIZE+((g_Buffer[u32_Pos+4]<<8) | g_Buffer[u32_Pos+5])+1)
+  {
+    b_Ok = b_Ok && (g_Buffer[u32_Pos+7]==Tc::OnboardMonitoringService) && (g_Buffer[u32_Pos+8]==Monitoring::CheckTransitionReport) &&
+           (g_Buffer[u32_Pos+REPORT_OFFSET]<=TRANSITIONS) && (g_Buffer[u32_Pos+REPORT_OFFSET]>0);
+    u16_Transitions += g_Buffer[u32_Pos+REPORT_OFFSET];
+    u16_Reports++;
+  }
+  check("reports split", b_Ok && (u32_Pos==u32_Size) && (u16_Reports==(MONITOR_COUNT+TRANSITIONS-1)/TRANSITIONS));
+  check("all transitions reported", (u16_Transitions==MONITOR_COUNT) && (g_Monitoring.getStatus(0x200)==Monitoring::AboveHighLimit));
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,289 @@
+/*
+  Self test of the PUS packet store (service 15)
+
+  Stores space packets, retrieves them by APID and time range, handles
+  the service 15 telecommands and prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace PUS;
+
+
+#define PACKET_COUNT  400
+
+
+class TestReports : public VerificationActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  uint8_t mu8_SubService = 0;
+  uint8_t mu8_FailureCode = 0;
+  uint32_t mu32_RequestID = 0;
+
+  void onVerificationReport(const uint8_t *pu8_Packet, const uint16_t u16_PacketSize)
+  {
+    const uint8_t *pu8_Data = &pu8_Packet[SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE];
+
+    mu16_Count++;
+    mu8_SubService = pu8_Packet[SP_HEADER_SIZE+2];
+    mu32_RequestID = ((uint32_t)pu8_Data[0]<<24) | ((uint32_t)pu8_Data[1]<<16) | ((uint32_t)pu8_Data[2]<<8) | pu8_Data[3];
+    mu8_FailureCode = (u16_PacketSize>SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE+4)?pu8_Data[4]:0;
+  }
+};
+
+
+uint16_t g_Failed = 0;
+uint32_t g_Random = 4711;
+
+uint8_t g_Region[1024];
+uint8_t g_Buffer[64];
+
+// all stored packets, for the comparison with the retrieved ones
+uint16_t g_APID[PACKET_COUNT];
+uint16_t g_SequenceCount[PACKET_COUNT];
+uint32_t g_Time[PACKET_COUNT];
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+uint32_t nextRandom(void)
+{
+  g_Random = g_Random*1103515245UL+12345UL;
+  return g_Random>>8;
+}
+
+
+uint16_t dataLength(const uint16_t u16_APID, const uint16_t u16_SequenceCount)
+{
+  return (uint16_t)(1+(u16_SequenceCount*7+u16_APID)%20);
+}
+
+
+int32_t storePacket(PacketStore &store, const uint32_t u32_Time, const uint16_t u16_APID, const uint16_t u16_SequenceCount)
+{
+  uint8_t au8_Data[20];
+  uint16_t u16_Length = dataLength(u16_APID, u16_SequenceCount);
+
+  for(uint16_t i=0; i<u16_Length; i++)
+    au8_Data[i] = (uint8_t)(u16_SequenceCount+i);
+  return store.store(u32_Time, 0, 3, u16_APID, u16_SequenceCount, false, au8_Data, u16_Length);
+}
+
+
+// retrieves the packets and compares them with the stored ones from index u16_First on; returns the number of
+// retrieved packets or -1 on a mismatch
+int32_t retrieveAndCompare(PacketStore &store, PacketStore::Retrieval *pS_Retrieval, const uint16_t u16_First,
+                           const uint16_t u16_APID, const uint32_t u32_StartTime, const uint32_t u32_EndTime)
+{
+  uint16_t u16_Next = u16_First;
+  int32_t i32_Count = 0;
+
+  while(!pS_Retrieval->b_Complete)
+  {
+    uint32_t u32_Size = store.retrieve(pS_Retrieval, g_Buffer, sizeof(g_Buffer));
+    uint32_t u32_Pos = 0;
+
+    while(u32_Pos<u32_Size)
+    {
+      uint16_t u16_PacketAPID = (uint16_t)(((g_Buffer[u32_Pos]&7)<<8) | g_Buffer[u32_Pos+1]);
+      uint16_t u16_PacketSeq = (uint16_t)(((g_Buffer[u32_Pos+2]&0x3f)<<8) | g_Buffer[u32_Pos+3]);
+      uint16_t u16_Length = (uint16_t)(((g_Buffer[u32_Pos+4]<<8) | g_Buffer[u32_Pos+5])+1);
+
+      // the next expected packet
+      while((u16_Next<PACKET_COUNT) && !(((u16_APID==PacketStore::AllAPIDs) || (g_APID[u16_Next]==u16_APID))
+                                         && (g_Time[u16_Next]>=u32_StartTime) && (g_Time[u16_Next]<=u32_EndTime)))
+        u16_Next++;
+      if((u16_Next==PACKET_COUNT) || (u16_PacketAPID!=g_APID[u16_Next]) || (u16_PacketSeq!=g_SequenceCount[u16_Next])
+         || (u16_Length!=dataLength(u16_PacketAPID, u16_PacketSeq)) || (g_Buffer[u32_Pos+SP_HEADER_SIZE+u16_Length-1]!=(uint8_t)(u16_PacketSeq+u16_Length-1)))
+        return -1;
+      u16_Next++;
+      i32_Count++;
+      u32_Pos += SP_HEADER_SIZE+u16_Length;
+    }
+  }
+
+  // no further packet expected
+  while((u16_Next<PACKET_COUNT) && !(((u16_APID==PacketStore::AllAPIDs) || (g_APID[u16_Next]==u16_APID))
+                                     && (g_Time[u16_Next]>=u32_StartTime) && (g_Time[u16_Next]<=u32_EndTime)))
+    u16_Next++;
+  return (u16_Next==PACKET_COUNT)?i32_Count:-1;
+}
+
+
+uint32_t sendTc(Tc &tc, const uint16_t u16_SequenceCount, const uint8_t u8_SubService, const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+{
+  uint8_t au8_Packet[32];
+  uint32_t u32_Size = Tc::createPacket(au8_Packet, sizeof(au8_Packet), 0x20, u16_SequenceCount, false, false, false, true,
+                                       Tc::OnboardStorageAndRetrievalService, u8_SubService, 0, pu8_Data, u32_DataSize);
+
+  tc.process(1, 3, 0x20, u16_SequenceCount, true, &au8_Packet[SP_HEADER_SIZE], u32_Size-SP_HEADER_SIZE);
+  return ((uint32_t)au8_Packet[0]<<24) | ((uint32_t)au8_Packet[1]<<16) | ((uint32_t)au8_Packet[2]<<8) | au8_Packet[3];
+}
+
+
+void setup() {
+  Serial.begin(9600);
+
+  PacketStore store(g_Region, sizeof(g_Region), 3);
+  PacketStore::Retrieval S_Retrieval;
+  uint16_t au16_Seq[8] = {0};
+  uint32_t u32_Time = 100;
+  uint16_t u16_First;
+  bool b_Ok;
+
+  // fill the store beyond its size, so the oldest packets are overwritten
+  b_Ok = true;
+  for(uint16_t i=0; i<PACKET_COUNT; i++)
+  {
+    u32_Time += nextRandom()%3;
+    g_APID[i] = (uint16_t)(nextRandom()%8);
+    g_SequenceCount[i] = au16_Seq[g_APID[i]]++;
+    g_Time[i] = u32_Time;
+    b_Ok = b_Ok && (storePacket(store, u32_Time, g_APID[i], g_SequenceCount[i])==0);
+  }
+  check("store", b_Ok);
+  check("oldest packets overwritten", (store.getPacketCount()>0) && (store.getPacketCount()<PACKET_COUNT));
+  u16_First = (uint16_t)(PACKET_COUNT-store.getPacketCount());
+
+  // random retrievals compared with a linear search
+  b_Ok = true;
+  for(uint16_t i=0; i<100; i++)
+  {
+    uint16_t u16_APID = (i%3==0)?PacketStore::AllAPIDs:(uint16_t)(nextRandom()%8);
+    uint32_t u32_Start = g_Time[u16_First]+nextRandom()%(u32_Time-g_Time[u16_First]+1);
+    uint32_t u32_End = u32_Start+nextRandom()%100;
+
+    store.startRetrieval(&S_Retrieval, u16_APID, u32_Start, u32_End);
+    b_Ok = b_Ok && (retrieveAndCompare(store, &S_Retrieval, u16_First, u16_APID, u32_Start, u32_End)>=0);
+  }
+  check("retrieval by APID and time", b_Ok);
+
+  store.startRetrieval(&S_Retrieval, PacketStore::AllAPIDs, 0, 0xffffffff);
+  check("retrieval of all packets", retrieveAndCompare(store, &S_Retrieval, u16_First, PacketStore::AllAPIDs, 0, 0xffffffff)==(int32_t)store.getPacketCount());
+
+  // a packet larger than the buffer is skipped instead of blocking the retrieval
+  {
+    uint8_t au8_Small[SP_HEADER_SIZE+4];
+    uint16_t u16_Calls = 0;
+    uint16_t u16_Packets = 0;
+
+    store.clear();
+    store.clearErrorCounters();
+    storePacket(store, 1, 1, 0);   // 2 bytes
+    storePacket(store, 2, 1, 1);   // 9 bytes
+    storePacket(store, 3, 1, 2);   // 16 bytes
+    storePacket(store, 4, 1, 3);   // 3 bytes
+    store.startRetrieval(&S_Retrieval, PacketStore::AllAPIDs, 0, 0xffffffff);
+    while(!S_Retrieval.b_Complete && (u16_Calls<10))
+    {
+      uint32_t u32_Size = store.retrieve(&S_Retrieval, au8_Small, sizeof(au8_Small));
+      u16_Calls++;
+      if(u32_Size>0)
+        u16_Packets++;
+    }
+    check("oversized packet does not block the retrieval", S_Retrieval.b_Complete && (u16_Calls<10));
+    check("oversized packets skipped", (u16_Packets==2) && (store.getSkippedCount()==2));
+    store.clearErrorCounters();
+    check("skip counter cleared", store.getSkippedCount()==0);
+  }
+
+  // service 15 telecommands
+  {
+    TestReports reports;
+    Verification verification(0x10, &reports);
+    Tc tc(PUS_TC_DEFAULT_SEC_HEADER_SIZE, &store);
+    uint8_t au8_Data[9];
+    uint32_t u32_RequestID;
+    uint32_t u32_Size;
+    uint16_t u16_Packets;
+
+    tc.setChecksumType(Tc::StandardCRC);
+    tc.setVerification(&verification);
+    store.setVerification(&verification);
+    store.clear();
+    for(uint16_t i=0; i<10; i++)
+      storePacket(store, 10*i, (uint16_t)(i%2), i);
+
+    // disable storage
+    au8_Data[0] = 3;
+    u32_RequestID = sendTc(tc, 1, PacketStore::DisableStorage, au8_Data, 1);
+    check("(15,2) completed", (reports.mu8_SubService==Verification::CompletionSuccess) && (reports.mu32_RequestID==u32_RequestID));
+    check("storage disabled", (storePacket(store, 100, 0, 10)==-2) && (store.getPacketCount()==10));
+    sendTc(tc, 2, PacketStore::EnableStorage, au8_Data, 1);
+    check("storage enabled", (storePacket(store, 100, 0, 10)==0) && (store.getPacketCount()==11));
+
+    // wrong store ID and wrong length
+    au8_Data[0] = 4;
+    sendTc(tc, 3, PacketStore::EnableStorage, au8_Data, 1);
+    check("unknown store rejected", (reports.mu8_SubService==Verification::CompletionFailure) && (reports.mu8_FailureCode==PacketStore::UnknownStore));
+    au8_Data[0] = 3;
+    sendTc(tc, 4, PacketStore::DeleteUntilTime, au8_Data, 3);
+    check("wrong length rejected", (reports.mu8_SubService==Verification::CompletionFailure) && (reports.mu8_FailureCode==PacketStore::InvalidRequest));
+
+    // downlink of a time period; the completion is reported after the last packet
+    au8_Data[1] = 0; au8_Data[2] = 0; au8_Data[3] = 0; au8_Data[4] = 20;
+    au8_Data[5] = 0; au8_Data[6] = 0; au8_Data[7] = 0; au8_Data[8] = 60;
+    reports.mu16_Count = 0;
+    u32_RequestID = sendTc(tc, 5, PacketStore::DownlinkTimePeriod, au8_Data, 9);
+    check("downlink started without report", store.isDownlinking() && (reports.mu16_Count==0));
+    sendTc(tc, 6, PacketStore::DownlinkTimePeriod, au8_Data, 9);
+    check("second downlink rejected", (reports.mu8_SubService==Verification::CompletionFailure) && (reports.mu8_FailureCode==PacketStore::DownlinkRunning));
+    reports.mu16_Count = 0;
+    u16_Packets = 0;
+    do
+    {
+      u32_Size = store.generate(g_Buffer, SP_HEADER_SIZE+20);
+      if(u32_Size>0)
+        u16_Packets++;
+    } while(store.isDownlinking() && (u16_Packets<20));
+    check("time period downlinked", (u16_Packets>1) && !store.isDownlinking());
+    check("downlink completion reported", (reports.mu16_Count==1) && (reports.mu8_SubService==Verification::CompletionSuccess)
+                                          && (reports.mu32_RequestID==u32_RequestID));
+
+    // downlink of a sequence count range of APID 1
+    au8_Data[1] = 0; au8_Data[2] = 1;
+    au8_Data[3] = 0; au8_Data[4] = 3;
+    au8_Data[5] = 0; au8_Data[6] = 7;
+    sendTc(tc, 7, PacketStore::DownlinkPacketRange, au8_Data, 7);
+    u16_Packets = 0;
+    b_Ok = true;
+    while(store.isDownlinking())
+    {
+      u32_Size = store.generate(g_Buffer, sizeof(g_Buffer));
+      for(uint32_t u32_Pos=0; u32_Pos<u32_Size; u32_Pos+=SP_HEADER_SIZE+((g_Buffer[u32_Pos+4]<<8) | g_Buffer[u32_Pos+5])+1)
+      {
+        uint16_t u16_Seq = (uint16_t)(((g_Buffer[u32_Pos+2]&0x3f)<<8) | g_Buffer[u32_Pos+3]);
+        b_Ok = b_Ok && (g_Buffer[u32_Pos+1]==1) && (u16_Seq>=3) && (u16_Seq<=7);
+        u16_Packets++;
+      }
+    }
+    check("packet range downlinked", b_Ok && (u16_Packets==3));
+
+    // delete until time 40
+    au8_Data[1] = 0; au8_Data[2] = 0; au8_Data[3] = 0; au8_Data[4] = 40;
+    sendTc(tc, 8, PacketStore::DeleteUntilTime, au8_Data, 5);
+    check("packets deleted", (reports.mu8_SubService==Verification::CompletionSuccess) && (store.getPacketCount()==6));
+    store.startRetrieval(&S_Retrieval, PacketStore::AllAPIDs, 0, 0xffffffff);
+    check("oldest remaining packet", (store.retrieve(&S_Retrieval, g_Buffer, sizeof(g_Buffer))>0) && (g_Buffer[3]==5));
+  }
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
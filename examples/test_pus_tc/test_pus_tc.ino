@@ -0,0 +1,144 @@
+/*
+  Self test of the PUS telecommand packet error control (PEC)
+
+  Creates telecommands with and without PEC, processes them and prints
+  the result of each check. Also verifies the PEC with the checksum which
+  the space packet parser calculates while it parses the packet.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace CCSDS;
+
+
+class TestHandler : public PUS::TcActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  uint8_t mu8_Service = 0;
+  uint8_t mu8_SubService = 0;
+  uint8_t mu8_SourceID = 0;
+  uint32_t mu32_DataSize = 0;
+
+  void onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                    const uint8_t u8_Service, const uint8_t u8_SubService,
+                    const uint8_t u8_SourceID,
+                    const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    mu16_Count++;
+    mu8_Service = u8_Service;
+    mu8_SubService = u8_SubService;
+    mu8_SourceID = u8_SourceID;
+    mu32_DataSize = u32_DataSize;
+  }
+};
+
+
+class TestForwarder : public SpacePacketActionInterface
+{
+public:
+  PUS::Tc *mp_Tc = nullptr;
+  SpacePacket *mp_Sp = nullptr;
+  int32_t mi32_Result = 1;
+
+  void onSpacePacketReceived(const uint8_t u8_PacketType,
+                             const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                             const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                             const uint8_t *pu8_PacketData, const uint16_t u16_PacketDataLength)
+  {
+    mi32_Result = mp_Tc->process(u8_PacketType, u8_SequenceFlags, u16_APID, u16_SequenceCount, b_SecHeader,
+                                 pu8_PacketData, u16_PacketDataLength, mp_Sp->getCrcSyndrome());
+  }
+};
+
+
+uint16_t g_Failed = 0;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+int32_t processPacket(PUS::Tc &tc, const uint8_t *pu8_Packet, const uint32_t u32_PacketSize)
+{
+  // the primary header fields are passed as delivered by SpacePacketActionInterface::onSpacePacketReceived()
+  return tc.process((uint8_t)((pu8_Packet[0]>>4)&1), (uint8_t)(pu8_Packet[2]>>6),
+                    (uint16_t)(((pu8_Packet[0]&7)<<8) | pu8_Packet[1]), (uint16_t)(((pu8_Packet[2]&0x3f)<<8) | pu8_Packet[3]),
+                    (pu8_Packet[0]&0x08)?true:false, &pu8_Packet[SP_HEADER_SIZE], u32_PacketSize-SP_HEADER_SIZE);
+}
+
+
+void setup() {
+  const uint8_t au8_Data[3] = {7, 8, 9};
+  uint8_t au8_Packet[32];
+  uint8_t au8_Assembled[32];
+  uint8_t au8_SecHdr[PUS_TC_DEFAULT_SEC_HEADER_SIZE];
+  uint8_t au8_PacketData[5];
+  uint32_t u32_Size;
+  uint32_t u32_DataSize;
+  TestHandler handler;
+  PUS::Tc tc(&handler);
+  TestForwarder forwarder;
+  SpacePacket sp(&forwarder);
+
+  Serial.begin(9600);
+
+  // createPacket() calculates the PEC, process() verifies it
+  tc.setChecksumType(PUS::Tc::StandardCRC);
+  u32_Size = PUS::Tc::createPacket(au8_Packet, sizeof(au8_Packet), 0x48, 5, true, false, false, true, 17, 1, 3, au8_Data, sizeof(au8_Data));
+  check("createPacket size", u32_Size==SP_HEADER_SIZE+PUS_TC_DEFAULT_SEC_HEADER_SIZE+sizeof(au8_Data)+2);
+  check("PEC syndrome is zero", PUS::Tc::calcCRC(au8_Packet, u32_Size)==0);
+  check("valid packet accepted", processPacket(tc, au8_Packet, u32_Size)==0 && handler.mu16_Count==1);
+  check("decoded fields", handler.mu8_Service==17 && handler.mu8_SubService==1 && handler.mu8_SourceID==3 && handler.mu32_DataSize==3);
+
+  // create() without checksum type does not append a PEC, as before
+  u32_DataSize = PUS::Tc::create(au8_SecHdr, sizeof(au8_SecHdr), au8_PacketData, sizeof(au8_Data),
+                                 true, false, false, true, 17, 1, 3, au8_Data, sizeof(au8_Data));
+  check("create default without PEC", u32_DataSize==sizeof(au8_Data));
+
+  // create() reserves the PEC which is filled in by updateCRC()
+  u32_DataSize = PUS::Tc::create(au8_SecHdr, sizeof(au8_SecHdr), au8_PacketData, sizeof(au8_PacketData),
+                                 true, false, false, true, 17, 1, 3, au8_Data, sizeof(au8_Data), PUS::Tc::StandardCRC);
+  u32_Size = SpacePacket::create(au8_Assembled, sizeof(au8_Assembled), SpacePacket::TC, SpacePacket::Unsegmented, 0x48, 5,
+                                 au8_SecHdr, sizeof(au8_SecHdr), au8_PacketData, (uint16_t)u32_DataSize);
+  check("updateCRC", PUS::Tc::updateCRC(au8_Assembled, u32_Size)==0);
+  check("updateCRC equals createPacket", memcmp(au8_Assembled, au8_Packet, u32_Size)==0);
+
+  // the space packet parser calculates the syndrome while parsing, also over several chunks
+  forwarder.mp_Tc = &tc;
+  forwarder.mp_Sp = &sp;
+  sp.setCrcCalculation(true);
+  sp.process(au8_Packet, 4);
+  sp.process(&au8_Packet[4], u32_Size-4);
+  check("parser syndrome accepted", (forwarder.mi32_Result==0) && (sp.getCrcSyndrome()==0) && (handler.mu16_Count==2));
+  au8_Packet[u32_Size-1] ^= 0x80;
+  sp.process(au8_Packet, u32_Size);
+  check("parser syndrome rejected", (forwarder.mi32_Result==-2) && (handler.mu16_Count==2) && (tc.getChecksumErrorCount()==1));
+  au8_Packet[u32_Size-1] ^= 0x80;
+  tc.clearErrorCounters();
+
+  // a corrupted packet is counted and not forwarded
+  au8_Packet[8] ^= 0x01;
+  check("corrupted packet rejected", processPacket(tc, au8_Packet, u32_Size)==-2 && handler.mu16_Count==2);
+  check("checksum error counted", tc.getChecksumErrorCount()==1);
+
+  // too small buffers are rejected
+  check("buffer too small", PUS::Tc::createPacket(au8_Packet, u32_Size-1, 0x48, 5, true, false, false, true, 17, 1, 3, au8_Data, sizeof(au8_Data))==0);
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
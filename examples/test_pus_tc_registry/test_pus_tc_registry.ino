@@ -0,0 +1,123 @@
+/*
+  Self test of the PUS telecommand registry
+
+  Dispatches telecommands to registered handlers and prints the result
+  of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace PUS;
+
+
+class TestHandler : public TcActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  uint8_t mu8_SubService = 0;
+
+  void onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                    const uint8_t u8_Service, const uint8_t u8_SubService,
+                    const uint8_t u8_SourceID,
+                    const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    mu16_Count++;
+    mu8_SubService = u8_SubService;
+  }
+};
+
+
+class TestRejection : public TcRegistryActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  Tc::AcceptanceFailureCode me_FailureCode = Tc::AcceptanceFailureCode::IllegalAPID;
+
+  void onTcRejected(const Tc::AcceptanceFailureCode e_FailureCode,
+                    const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                    const uint8_t u8_Service, const uint8_t u8_SubService,
+                    const uint8_t u8_SourceID,
+                    const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    mu16_Count++;
+    me_FailureCode = e_FailureCode;
+  }
+};
+
+
+uint16_t g_Failed = 0;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+void send(Tc &tc, const uint8_t u8_Service, const uint8_t u8_SubService, const uint8_t u8_SourceID)
+{
+  const uint8_t u8_Data = 0;
+  uint8_t au8_Packet[16];
+  uint32_t u32_Size;
+
+  u32_Size = Tc::createPacket(au8_Packet, sizeof(au8_Packet), 1, 1, false, false, false, false,
+                              u8_Service, u8_SubService, u8_SourceID, &u8_Data, 1, PUS_TC_DEFAULT_SEC_HEADER_SIZE, Tc::None);
+  tc.process(&au8_Packet[SP_HEADER_SIZE], u32_Size-SP_HEADER_SIZE);
+}
+
+
+void setup() {
+  TestRejection rejection;
+  TestHandler test;
+  TestHandler housekeeping;
+  TcRegistry registry(&rejection);
+  Tc tc(&registry);
+  uint16_t u16_Registered = 0;
+
+  Serial.begin(9600);
+
+  check("register", registry.registerHandler(17, 1, &test)==0 && registry.registerHandler(3, 5, &housekeeping)==0);
+  check("subservice out of range", registry.registerHandler(17, PUS_MAX_SUBSERVICES, &test)==-1);
+
+  send(tc, 17, 1, 9);
+  send(tc, 3, 5, 9);
+  check("dispatch to handlers", test.mu16_Count==1 && housekeeping.mu16_Count==1 && housekeeping.mu8_SubService==5);
+
+  send(tc, 3, 6, 9);
+  check("unknown subservice rejected", rejection.mu16_Count==1 && rejection.me_FailureCode==Tc::IllegalPacketSubType);
+  send(tc, 4, 6, 9);
+  check("unknown service rejected", rejection.mu16_Count==2 && rejection.me_FailureCode==Tc::IllegalPacketType);
+
+  registry.setSourceAllowed(9, false);
+  send(tc, 17, 1, 9);
+  check("forbidden source rejected", rejection.mu16_Count==3 && rejection.me_FailureCode==Tc::IllegalSource && test.mu16_Count==1);
+  registry.setSourceAllowed(9, true);
+  send(tc, 17, 1, 9);
+  check("allowed source dispatched", test.mu16_Count==2);
+
+  check("unregister", registry.unregisterHandler(17, 1)==0 && registry.unregisterHandler(17, 1)==-1);
+  send(tc, 17, 1, 9);
+  check("unregistered handler rejected", test.mu16_Count==2 && rejection.mu16_Count==4);
+  check("rejection count", registry.getRejectionCount()==4);
+
+  // the table has PUS_MAX_SERVICES rows; two are used by the services 17 and 3
+  for(uint16_t u16_Service=100; u16_Service<256; u16_Service++)
+    if(registry.registerHandler((uint8_t)u16_Service, 0, &test)==0)
+      u16_Registered++;
+  check("service table limit", u16_Registered==PUS_MAX_SERVICES-2);
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
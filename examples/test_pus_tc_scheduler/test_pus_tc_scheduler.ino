@@ -0,0 +1,187 @@
+/*
+  Self test of the PUS telecommand scheduler (service 11)
+
+  Inserts time-tagged telecommands, releases them and prints the result
+  of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace PUS;
+
+
+class TestRelease : public TcSchedulerActionInterface
+{
+public:
+  TcScheduler *mp_Scheduler = nullptr;
+  uint16_t mu16_Count = 0;
+  uint16_t mu16_TooEarly = 0;
+  uint32_t mu32_CurrentTime = 0;
+  uint32_t mu32_PreviousTime = 0;
+  bool mb_RemoveSelf = false;
+  bool mb_Reset = false;
+  int32_t mi32_RemoveResult = 0;
+
+  void onScheduledTcReleased(const uint32_t u32_ReleaseTime, const uint8_t *pu8_Packet, const uint16_t u16_PacketSize)
+  {
+    mu16_Count++;
+    // a telecommand must be due now, but must not have been due at the previous call of release()
+    if(((int32_t)(mu32_CurrentTime-u32_ReleaseTime)<0) || ((int32_t)(u32_ReleaseTime-mu32_PreviousTime)<=0))
+      mu16_TooEarly++;
+    if(mb_RemoveSelf)
+      mi32_RemoveResult = mp_Scheduler->remove((uint16_t)(((pu8_Packet[0]&7)<<8) | pu8_Packet[1]),
+                                               (uint16_t)(((pu8_Packet[2]&0x3f)<<8) | pu8_Packet[3]));
+    if(mb_Reset)
+      mp_Scheduler->reset(mu32_CurrentTime+1);
+  }
+};
+
+
+class TestReports : public VerificationActionInterface
+{
+public:
+  uint8_t mu8_SubService = 0;
+  uint8_t mu8_FailureCode = 0;
+
+  void onVerificationReport(const uint8_t *pu8_Packet, const uint16_t u16_PacketSize)
+  {
+    mu8_SubService = pu8_Packet[SP_HEADER_SIZE+2];
+    mu8_FailureCode = (u16_PacketSize>SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE+4)?pu8_Packet[SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE+4]:0;
+  }
+};
+
+
+uint16_t g_Failed = 0;
+uint32_t g_Random = 12345;
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+uint32_t nextRandom(void)
+{
+  g_Random = g_Random*1103515245UL+12345UL;
+  return g_Random>>8;
+}
+
+
+int32_t insertTc(TcScheduler &scheduler, const uint32_t u32_ReleaseTime, const uint16_t u16_SequenceCount)
+{
+  const uint8_t u8_Data = 0;
+  uint8_t au8_Packet[16];
+  uint32_t u32_Size = Tc::createPacket(au8_Packet, sizeof(au8_Packet), 0x42, u16_SequenceCount, false, false, false, false,
+                                       17, 1, 0, &u8_Data, 1);
+  return scheduler.insert(u32_ReleaseTime, au8_Packet, (uint16_t)u32_Size);
+}
+
+
+uint32_t releaseAt(TcScheduler &scheduler, TestRelease &release, const uint32_t u32_Time)
+{
+  uint32_t u32_Released;
+
+  release.mu32_CurrentTime = u32_Time;
+  u32_Released = scheduler.release(u32_Time);
+  release.mu32_PreviousTime = u32_Time;
+  return u32_Released;
+}
+
+
+void setup() {
+  TestRelease release;
+  TestReports reports;
+  TcScheduler scheduler(&release);
+  Verification verification(0x10, &reports);
+  uint16_t u16_Inserted = 0;
+  uint32_t u32_Time;
+  uint8_t au8_Request[1+4+TcScheduler::MaxTcSize+1];
+
+  Serial.begin(9600);
+  release.mp_Scheduler = &scheduler;
+
+  // the first release synchronizes the wheel, no tick by tick catch up from time 0
+  check("insert", insertTc(scheduler, 3000000005UL, 1)==0);
+  release.mu32_PreviousTime = 3000000000UL;
+  check("first release at a large time", releaseAt(scheduler, release, 3000000000UL)==0 && scheduler.getCount()==1);
+  check("release when due", releaseAt(scheduler, release, 3000000005UL)==1 && release.mu16_TooEarly==0);
+
+  // random release times around the wrap-around of the onboard time, compared with the expected times
+  u32_Time = 0xffffff00UL;
+  release.mu16_Count = 0;
+  releaseAt(scheduler, release, u32_Time);
+  for(uint16_t u16_Round=0; u16_Round<400; u16_Round++)
+  {
+    while(scheduler.getCount()<TcScheduler::MaxCommands)
+    {
+      uint32_t u32_Span = 1UL<<(nextRandom()%24);
+      insertTc(scheduler, u32_Time+1+nextRandom()%u32_Span, u16_Inserted);
+      u16_Inserted++;
+    }
+    u32_Time += 1+nextRandom()%((u16_Round&1)?300:70000);
+    releaseAt(scheduler, release, u32_Time);
+  }
+  u32_Time += 0x1000000UL;
+  releaseAt(scheduler, release, u32_Time);
+  check("all released", release.mu16_Count==u16_Inserted && scheduler.getCount()==0);
+  check("no early or late release", release.mu16_TooEarly==0);
+
+  // a telecommand which is released can not be deleted by the callback
+  release.mu16_Count = 0;
+  release.mb_RemoveSelf = true;
+  insertTc(scheduler, u32_Time+10, 100);
+  releaseAt(scheduler, release, u32_Time+10);
+  release.mb_RemoveSelf = false;
+  check("remove in callback rejected", release.mi32_RemoveResult==-1 && scheduler.getCount()==0);
+  u16_Inserted = 0;
+  for(uint16_t i=0; i<TcScheduler::MaxCommands+1; i++)
+    if(insertTc(scheduler, u32_Time+20, (uint16_t)(200+i))==0)
+      u16_Inserted++;
+  check("free list intact", u16_Inserted==TcScheduler::MaxCommands && scheduler.getOverflowErrorCount()==1);
+
+  // a reset in the callback ends the release
+  release.mb_Reset = true;
+  check("reset in callback", releaseAt(scheduler, release, u32_Time+20)==1 && scheduler.getCount()==0);
+  release.mb_Reset = false;
+  check("insert after reset", insertTc(scheduler, u32_Time+30, 300)==0 && scheduler.remove(0x42, 300)==0);
+
+  // telecommands which became due while the release was disabled are released after enabling
+  scheduler.setReleaseEnabled(false);
+  insertTc(scheduler, u32_Time+40, 400);
+  check("disabled release", releaseAt(scheduler, release, u32_Time+50)==0);
+  scheduler.setReleaseEnabled(true);
+  release.mu32_PreviousTime = u32_Time+39;
+  check("release after enabling", releaseAt(scheduler, release, u32_Time+2000000000UL)==1);
+
+  // insert errors are reported with a completion failure report (1,8)
+  scheduler.setVerification(&verification);
+  memset(au8_Request, 0, sizeof(au8_Request));
+  au8_Request[0] = 1;
+  CCSDS::SpacePacket::createPrimaryHeader(&au8_Request[5], CCSDS::SpacePacket::TC, CCSDS::SpacePacket::Unsegmented,
+                                          0x42, 500, true, TcScheduler::MaxTcSize+1-SP_HEADER_SIZE);
+  scheduler.onTcReceived(false, false, false, true, Tc::OnboardOperationsSchedulingService, TcScheduler::InsertTelecommands, 0,
+                         au8_Request, sizeof(au8_Request));
+  check("oversized telecommand reported", reports.mu8_SubService==Verification::CompletionFailure
+                                          && reports.mu8_FailureCode==TcScheduler::InvalidPacket);
+  au8_Request[0] = 1;
+  au8_Request[1] = 0x00; au8_Request[2] = 0x42; au8_Request[3] = 0x01; au8_Request[4] = 0xf4; au8_Request[5] = 0; au8_Request[6] = 1;
+  scheduler.onTcReceived(false, false, false, true, Tc::OnboardOperationsSchedulingService, TcScheduler::DeleteTelecommands, 0,
+                         au8_Request, 7);
+  check("unknown telecommand reported", reports.mu8_FailureCode==TcScheduler::UnknownTelecommand);
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+
+void loop() {
+}
@@ -0,0 +1,199 @@
+/*
+  Self test of the PUS telecommand verification (service 1)
+
+  Processes telecommands with a Tc object which sends the acceptance
+  reports itself, compares the reports (1,1) and (1,2) with known
+  packets, checks the failure codes of wrong lengths, wrong checksums
+  and telecommands which are rejected by the registry, and creates the
+  execution reports. Prints the result of each check.
+
+  This example code is in the public domain.
+
+  http://www.trippler.de/stefan/arduino/ccsds/
+*/
+
+#include <ccsds.h>
+
+
+using namespace PUS;
+
+
+#define APID      0x50
+#define TC_APID   0x123
+
+
+class TestHandler : public TcActionInterface
+{
+public:
+  Verification *mp_Verification = nullptr;
+  uint16_t mu16_Count = 0;
+  uint32_t mu32_RequestID = 0;
+
+  void onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                    const uint8_t u8_Service, const uint8_t u8_SubService,
+                    const uint8_t u8_SourceID,
+                    const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    mu16_Count++;
+    mu32_RequestID = mp_Verification->getRequestID();
+  }
+};
+
+
+class TestRejection : public TcRegistryActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+
+  void onTcRejected(const Tc::AcceptanceFailureCode e_FailureCode,
+                    const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                    const uint8_t u8_Service, const uint8_t u8_SubService,
+                    const uint8_t u8_SourceID,
+                    const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    mu16_Count++;
+  }
+};
+
+
+class TestReports : public VerificationActionInterface
+{
+public:
+  uint16_t mu16_Count = 0;
+  uint8_t mau8_Report[32];
+  uint16_t mu16_Size = 0;
+
+  void onVerificationReport(const uint8_t *pu8_Packet, const uint16_t u16_PacketSize)
+  {
+    mu16_Count++;
+    mu16_Size = (u16_PacketSize<sizeof(mau8_Report))?u16_PacketSize:sizeof(mau8_Report);
+    memcpy(mau8_Report, pu8_Packet, mu16_Size);
+  }
+};
+
+
+uint16_t g_Failed = 0;
+
+TestReports g_Reports;
+TestRejection g_Rejection;
+TestHandler g_Handler;
+TcRegistry g_Registry(&g_Rejection);
+Verification g_Verification(APID, &g_Reports);
+Tc g_Tc(&g_Registry);
+
+
+void check(const char *s_Name, const bool b_Ok)
+{
+  Serial.print(b_Ok?"OK     ":"FAILED ");
+  Serial.println(s_Name);
+  if(!b_Ok)
+    g_Failed++;
+}
+
+
+/**
+ * @brief Creates a telecommand with PEC, optionally corrupts it and processes it with the complete header
+ */
+int32_t send(const bool b_AckAcc, const uint8_t u8_Service, const uint8_t u8_SubService, const uint8_t u8_SourceID,
+             const bool b_Corrupt = false, const uint32_t u32_Truncate = 0)
+{
+  const uint8_t u8_Data = 0x5a;
+  uint8_t au8_Packet[16];
+  uint32_t u32_Size;
+
+  u32_Size = Tc::createPacket(au8_Packet, sizeof(au8_Packet), TC_APID, 5, b_AckAcc, false, false, false,
+                              u8_Service, u8_SubService, u8_SourceID, &u8_Data, 1);
+  if(b_Corrupt)
+    au8_Packet[u32_Size-3] ^= 0x01;
+  return g_Tc.process(1, 3, TC_APID, 5, true, &au8_Packet[SP_HEADER_SIZE], u32_Size-SP_HEADER_SIZE-u32_Truncate);
+}
+
+
+/**
+ * @brief Checks that exactly one more report was sent and that it is a report (1,2) with the given failure code
+ */
+bool isAcceptanceFailure(const uint16_t u16_Count, const uint8_t u8_FailureCode)
+{
+  return (g_Reports.mu16_Count==u16_Count+1) && (g_Reports.mu16_Size==14) &&
+         (g_Reports.mau8_Report[8]==Verification::AcceptanceFailure) && (g_Reports.mau8_Report[13]==u8_FailureCode);
+}
+
+
+void setup()
+{
+  const uint8_t au8_AcceptanceSuccess[] =
+  {
+    0x08, 0x50, 0xc0, 0x00, 0x00, 0x06,   // TM, APID 0x50, sequence count 0
+    0x10, 0x01, 0x01,                     // (1,1)
+    0x19, 0x23, 0xc0, 0x05                // request ID: packet ID and sequence control of the telecommand
+  };
+  const uint8_t au8_ProgressFailure[] =
+  {
+    0x08, 0x50, 0xc0, 0x07, 0x00, 0x08,   // sequence count 7
+    0x10, 0x01, 0x06,                     // (1,6)
+    0x19, 0x23, 0xc0, 0x05,
+    0x03, 0x42                            // step 3, failure code 0x42
+  };
+  uint16_t u16_Count;
+
+  Serial.begin(115200);
+  while(!Serial);
+
+  g_Handler.mp_Verification = &g_Verification;
+  g_Registry.registerHandler(17, 1, &g_Handler);
+  g_Tc.setChecksumType(Tc::StandardCRC);
+  g_Tc.setVerification(&g_Verification);
+  g_Verification.setRegistry(&g_Registry);
+
+  check("accepted", send(true, 17, 1, 9)==0);
+  check("acceptance success report", (g_Reports.mu16_Count==1) && (g_Reports.mu16_Size==sizeof(au8_AcceptanceSuccess)) &&
+                                      (memcmp(g_Reports.mau8_Report, au8_AcceptanceSuccess, sizeof(au8_AcceptanceSuccess))==0));
+  check("handler called with the request ID", (g_Handler.mu16_Count==1) && (g_Handler.mu32_RequestID==0x1923c005UL));
+  check("no report if not requested", (send(false, 17, 1, 9)==0) && (g_Reports.mu16_Count==1) && (g_Handler.mu16_Count==2));
+
+  // telecommands rejected by the registry are answered by the verification and counted by the registry
+  u16_Count = g_Reports.mu16_Count;
+  check("unknown service rejected", (send(false, 4, 1, 9)==-3) && isAcceptanceFailure(u16_Count, Tc::IllegalPacketType));
+  u16_Count = g_Reports.mu16_Count;
+  check("unknown subservice rejected", (send(false, 17, 2, 9)==-3) && isAcceptanceFailure(u16_Count, Tc::IllegalPacketSubType));
+  g_Registry.setSourceAllowed(9, false);
+  u16_Count = g_Reports.mu16_Count;
+  check("forbidden source rejected", (send(false, 17, 1, 9)==-3) && isAcceptanceFailure(u16_Count, Tc::IllegalSource));
+  g_Registry.setSourceAllowed(9, true);
+  check("rejections counted", g_Registry.getRejectionCount()==3);
+  check("not forwarded", (g_Handler.mu16_Count==2) && (g_Rejection.mu16_Count==0));
+
+  // length and checksum errors are rejected before the registry is asked
+  u16_Count = g_Reports.mu16_Count;
+  check("wrong checksum rejected", (send(true, 17, 1, 9, true)==-2) && isAcceptanceFailure(u16_Count, Tc::IncorrectChecksum));
+  check("checksum error count", g_Tc.getChecksumErrorCount()==1);
+  u16_Count = g_Reports.mu16_Count;
+  check("wrong length rejected", (send(true, 17, 1, 9, false, 6)==-1) && isAcceptanceFailure(u16_Count, Tc::InvalidLength));
+  check("registry not asked", (g_Registry.getRejectionCount()==3) && (g_Handler.mu16_Count==2));
+
+  // the registry alone counts the rejections and reports them to its own action interface
+  g_Registry.onTcReceived(false, false, false, false, 4, 1, 9, nullptr, 0);
+  check("rejected by the registry", (g_Registry.getRejectionCount()==4) && (g_Rejection.mu16_Count==1));
+
+  // execution reports
+  check("start success", (g_Verification.startSuccess(0x1923c005UL)==0) && (g_Reports.mu16_Size==13) &&
+                         (g_Reports.mau8_Report[8]==Verification::StartSuccess));
+  check("progress failure", (g_Verification.progressFailure(0x1923c005UL, 3, 0x42)==0) &&
+                            (g_Reports.mu16_Size==sizeof(au8_ProgressFailure)) &&
+                            (memcmp(g_Reports.mau8_Report, au8_ProgressFailure, sizeof(au8_ProgressFailure))==0));
+  check("progress success", (g_Verification.progressSuccess(0x1923c005UL, 4)==0) && (g_Reports.mu16_Size==14) &&
+                            (g_Reports.mau8_Report[8]==Verification::ProgressSuccess) && (g_Reports.mau8_Report[13]==4));
+  check("completion failure", (g_Verification.completionFailure(0x1923c005UL, 0x17)==0) && (g_Reports.mu16_Size==14) &&
+                              (g_Reports.mau8_Report[8]==Verification::CompletionFailure) && (g_Reports.mau8_Report[13]==0x17));
+  check("completion success", (g_Verification.completionSuccess(0x1923c005UL)==0) && (g_Reports.mu16_Size==13) &&
+                              (g_Reports.mau8_Report[8]==Verification::CompletionSuccess) && (g_Reports.mau8_Report[3]==10));
+  g_Verification.setActionInterface(nullptr);
+  check("no action interface", g_Verification.startFailure(0x1923c005UL, 1)==-1);
+
+  Serial.print("failed checks: ");
+  Serial.println(g_Failed);
+}
+
+void loop()
+{
+}
@@ -1,14 +1,37 @@
 #ifndef _CCSDS_H_
 #define _CCSDS_H_
 
+#include "ccsds_randomizer.h"
+#include "ccsds_reedsolomon.h"
+#include "ccsds_convolutional.h"
+#include "ccsds_cadu.h"
 #include "ccsds_cltu.h"
 
 #include "ccsds_clcw.h"
 #include "ccsds_transferframe_tc.h"
 #include "ccsds_transferframe_tm.h"
+#include "ccsds_transferframe_uslp.h"
+#include "ccsds_transferframe_aos.h"
+#include "ccsds_sdls.h"
 
 #include "ccsds_spacepacket.h"
+#include "ccsds_encapsulation.h"
+#include "ccsds_rice.h"
+#include "ccsds_timecode.h"
+#include "ccsds_decommutator.h"
+#include "ccsds_reader.h"
 
 #include "pus_tc.h"
+#include "pus_tm.h"
+#include "pus_tc_registry.h"
+#include "pus_verification.h"
+#include "pus_tc_scheduler.h"
+#include "pus_packet_store.h"
+#include "pus_housekeeping.h"
+#include "pus_monitoring.h"
+#include "pus_memory.h"
+#include "pus_large_data.h"
+
+#include "ccsds_cfdp.h"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+/**
+ * @file      ccsds_aes.h
+ *
+ * @brief     Include file of the AES block cipher class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_AES_H_
+#define _CCSDS_AES_H_
+
+/****************************************************************/
+/* AES block cipher according to                                */
+/*                                                              */
+/*  - FIPS 197, - Advanced Encryption Standard (AES)            */
+/*  - CCSDS 352.0-B-2, - CCSDS Cryptographic Algorithms         */
+/*    https://public.ccsds.org/Pubs/352x0b2.pdf                 */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Only the forward cipher is implemented, which is all that */
+/*    is needed by the GCM and CMAC modes                       */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+
+#ifdef configSDLS_USE_AES_TABLE
+#define SDLS_USE_AES_TABLE configSDLS_USE_AES_TABLE
+#else
+#define SDLS_USE_AES_TABLE 1
+#endif
+
+
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Class for encrypting blocks with the AES block cipher (FIPS 197) with 128, 192 or 256 bit keys.
+   *
+   * The round keys are expanded once by setKey(), so encrypt() only needs the 16 byte block. If
+   * SDLS_USE_AES_TABLE is set, the rounds are calculated with a lookup table of 1 kB which combines
+   * SubBytes, ShiftRows and MixColumns; otherwise the S-box is used byte by byte (for Arduino).
+   */
+  class Aes
+  {
+  public:
+    static const uint8_t BlockSize = 16;
+    static const uint8_t MaxKeySize = 32;
+
+  private:
+    const static uint8_t MaxRounds = 14;
+
+    uint8_t mu8_Rounds;
+    uint8_t mau8_RoundKey[(MaxRounds+1)*BlockSize];
+
+  public:
+    Aes(void);
+
+    int32_t setKey(const uint8_t *pu8_Key, const uint8_t u8_KeySize);
+    void clearKey(void);
+    bool hasKey(void);
+
+    void encrypt(const uint8_t *pu8_Input, uint8_t *pu8_Output);
+  };
+
+}
+
+#endif // _CCSDS_AES_H_
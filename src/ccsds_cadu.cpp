@@ -0,0 +1,176 @@
+/**
+ * @file      ccsds_cadu.cpp
+ *
+ * @brief     Source file of the Channel Access Data Unit (CADU) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "ccsds_cadu.h"
+
+
+namespace CCSDS
+{
+  static const uint8_t au8_AttachedSyncMarker[Cadu::AsmSize] = { 0x1a, 0xcf, 0xfc, 0x1d };
+
+
+
+  /**
+   * @brief Returns the size of a CADU
+   *
+   * @param u8_InterleaveDepth  The interleaving depth of the Reed-Solomon code (0 if the code is not used)
+   *
+   * @return The size of the attached sync marker, the transfer frame and the check symbols in bytes
+   */
+  uint32_t Cadu::getSize(const uint8_t u8_InterleaveDepth)
+  {
+#if TF_RS_MAX_INTERLEAVE > 0
+    return AsmSize+(uint32_t)TM_TF_TOTAL_SIZE+(uint32_t)u8_InterleaveDepth*ReedSolomon::ParitySize;
+#else
+    (void)u8_InterleaveDepth;
+    return AsmSize+(uint32_t)TM_TF_TOTAL_SIZE;
+#endif
+  }
+
+
+
+  /**
+   * @brief Creates a CADU (attached sync marker and channel coded TM transfer frame) and writes it into the given buffer
+   *
+   * @param pu8_Buffer                  A pointer to the buffer where the CADU shall be stored
+   * @param u32_BufferSize              The available size of the buffer
+   * @param u16_SpacecraftID            The spacecraft ID which is used for this frame (12 bit)
+   * @param u8_VirtualChannelID         The virtual channel which is used for this frame (0 to 7)
+   * @param u8_MasterChannelFrameCount  The overall frame count over all virtual channels, must be increased externally
+   * @param u8_VirtualChannelFrameCount The channel-specific frame count, must be increased externally
+   * @param u16_FirstHdrPtr             Offset of the first space packet within the data section
+   * @param pu8_Data                    A pointer to the data block which shall be wrapped
+   * @param u16_DataSize                The size of the data block in bytes
+   * @param u32_OCF                     The Operational Control Field (OCF), which is part of the flow control
+   *                                    mechanism for uplink data (can hold the Communications Link Control Word (CLCW))
+   * @param u8_InterleaveDepth          The interleaving depth of the Reed-Solomon code (0 if the code is not used)
+   * @param b_Randomize                 true if the frame and the check symbols shall be randomized with the TM sequence
+   *
+   * @retval 0  No CADU could be created
+   * @return The size of the created CADU in bytes as uint32_t
+   */
+  uint32_t Cadu::create(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                        const uint16_t u16_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                        const uint8_t u8_MasterChannelFrameCount, const uint8_t u8_VirtualChannelFrameCount,
+                        const uint16_t u16_FirstHdrPtr,
+                        const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                        const uint32_t u32_OCF,
+                        const uint8_t u8_InterleaveDepth, const bool b_Randomize)
+  {
+    if(!pu8_Buffer || !_checkParameters(u8_InterleaveDepth, b_Randomize))
+      return 0;
+    if(u32_BufferSize<getSize(u8_InterleaveDepth))
+      return 0;
+
+    if(TransferframeTm::create(&pu8_Buffer[AsmSize], u32_BufferSize-AsmSize,
+                               u16_SpacecraftID, u8_VirtualChannelID,
+                               u8_MasterChannelFrameCount, u8_VirtualChannelFrameCount,
+                               u16_FirstHdrPtr, pu8_Data, u16_DataSize, u32_OCF)==0)
+      return 0;
+
+    _encode(pu8_Buffer, u8_InterleaveDepth, b_Randomize);
+
+    return getSize(u8_InterleaveDepth);
+  }
+
+
+
+  /**
+   * @brief Creates several CADUs and writes them one after another into the given buffer
+   *
+   * Each CADU is completed (frame, check symbols, randomization) before the next one is started.
+   * The spacecraft ID, the interleaving depth and the randomization are the same for all frames.
+   * Idle frames can be created with the first header pointer 0x7FE and without data.
+   *
+   * @param pu8_Buffer          A pointer to the buffer where the CADUs shall be stored
+   * @param u32_BufferSize      The available size of the buffer; must hold u16_FrameCount*getSize() bytes
+   * @param u16_SpacecraftID    The spacecraft ID which is used for all frames (12 bit)
+   * @param pS_Frames           The variable fields of the frames
+   * @param u16_FrameCount      The number of frames
+   * @param u8_InterleaveDepth  The interleaving depth of the Reed-Solomon code (0 if the code is not used)
+   * @param b_Randomize         true if the frames and the check symbols shall be randomized with the TM sequence
+   *
+   * @retval 0  No CADU could be created (invalid parameters, buffer too small or a frame could not be created)
+   * @return The size of all created CADUs in bytes as uint32_t
+   */
+  uint32_t Cadu::createBatch(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                             const uint16_t u16_SpacecraftID,
+                             const Frame *pS_Frames, const uint16_t u16_FrameCount,
+                             const uint8_t u8_InterleaveDepth, const bool b_Randomize)
+  {
+    uint32_t u32_CaduSize = getSize(u8_InterleaveDepth);
+    uint8_t *pu8_Cadu = pu8_Buffer;
+
+    if(!pu8_Buffer || !pS_Frames || u16_FrameCount==0 || !_checkParameters(u8_InterleaveDepth, b_Randomize))
+      return 0;
+    if(u32_BufferSize/u32_CaduSize<u16_FrameCount)
+      return 0;
+
+    for(uint16_t i=0; i<u16_FrameCount; i++)
+    {
+      if(TransferframeTm::create(&pu8_Cadu[AsmSize], u32_CaduSize-AsmSize,
+                                 u16_SpacecraftID, pS_Frames[i].u8_VirtualChannelID,
+                                 pS_Frames[i].u8_MasterChannelFrameCount, pS_Frames[i].u8_VirtualChannelFrameCount,
+                                 pS_Frames[i].u16_FirstHdrPtr, pS_Frames[i].pu8_Data, pS_Frames[i].u16_DataSize,
+                                 pS_Frames[i].u32_OCF)==0)
+        return 0;
+
+      _encode(pu8_Cadu, u8_InterleaveDepth, b_Randomize);
+      pu8_Cadu+=u32_CaduSize;
+    }
+
+    return (uint32_t)u16_FrameCount*u32_CaduSize;
+  }
+
+
+
+  bool Cadu::_checkParameters(const uint8_t u8_InterleaveDepth, const bool b_Randomize)
+  {
+    if(b_Randomize && !TF_USE_RANDOMIZER)
+      return false;
+
+    if(u8_InterleaveDepth>0)
+    {
+#if TF_RS_MAX_INTERLEAVE > 0
+      if(u8_InterleaveDepth>ReedSolomon::MaxInterleaveDepth || (TM_TF_TOTAL_SIZE%u8_InterleaveDepth)!=0)
+        return false;
+      if(TM_TF_TOTAL_SIZE/u8_InterleaveDepth>ReedSolomon::MessageSize)
+        return false;
+#else
+      return false;
+#endif
+    }
+
+    return true;
+  }
+
+
+
+  /*
+   * Adds the sync marker, the check symbols and the randomization to a CADU whose frame was already created
+   */
+  void Cadu::_encode(uint8_t *pu8_Cadu, const uint8_t u8_InterleaveDepth, const bool b_Randomize)
+  {
+    uint32_t u32_CodeblockSize = getSize(u8_InterleaveDepth)-AsmSize;
+
+    memcpy(pu8_Cadu, au8_AttachedSyncMarker, AsmSize);
+
+#if TF_RS_MAX_INTERLEAVE > 0
+    if(u8_InterleaveDepth>0)
+      ReedSolomon::encode(&pu8_Cadu[AsmSize], u32_CodeblockSize, TM_TF_TOTAL_SIZE, u8_InterleaveDepth);
+#endif
+
+    if(b_Randomize)
+      Randomizer::apply(Randomizer::TmSequence, &pu8_Cadu[AsmSize], u32_CodeblockSize);
+  }
+
+}
@@ -0,0 +1,89 @@
+/**
+ * @file      ccsds_cadu.h
+ *
+ * @brief     Include file of the Channel Access Data Unit (CADU) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_CADU_H_
+#define _CCSDS_CADU_H_
+
+/****************************************************************/
+/* Channel Access Data Units according to                       */
+/*                                                              */
+/*  - CCSDS 131.0-B-3, - TM Synchronization and Channel Coding  */
+/*    https://public.ccsds.org/Pubs/131x0b3e1.pdf               */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Only TM transfer frames are supported                     */
+/*  - The convolutional code must be applied separately         */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "ccsds_transferframe_tm.h"
+
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Class for creating the Channel Access Data Units (CADUs) of the TM downlink.
+   *
+   * A CADU consists of the attached sync marker (0x1ACFFC1D) and the channel coded TM transfer frame: the frame
+   * is created with TransferframeTm::create(), the Reed-Solomon check symbols are added (if an interleaving depth
+   * is given) and the frame and the check symbols are randomized with the TM sequence (if requested).
+   *
+   * All steps are done frame by frame directly in the output buffer, so the frame is still in the cache when it
+   * is encoded and randomized. With createBatch(), several CADUs are written one after another into the buffer,
+   * ready to be handed over to the modem. All CADUs of a mission have the same size (getSize()); if the buffer
+   * is aligned and the size is a multiple of 4, every CADU starts aligned, too.
+   */
+  class Cadu
+  {
+  public:
+    const static uint8_t AsmSize = TF_SYNC_SIZE;
+
+    /**
+     * @brief The variable fields of a transfer frame in a batch
+     */
+    struct Frame
+    {
+      uint8_t u8_VirtualChannelID;          /**< The virtual channel ID (0 to 7) */
+      uint8_t u8_MasterChannelFrameCount;   /**< The overall frame count over all virtual channels */
+      uint8_t u8_VirtualChannelFrameCount;  /**< The channel-specific frame count */
+      uint16_t u16_FirstHdrPtr;             /**< Offset of the first space packet within the data section */
+      const uint8_t *pu8_Data;              /**< The data which shall be wrapped */
+      uint16_t u16_DataSize;                /**< The size of the data in bytes */
+      uint32_t u32_OCF;                     /**< The Operational Control Field (usually the CLCW) */
+    };
+
+  public:
+    static uint32_t getSize(const uint8_t u8_InterleaveDepth = 0);
+
+    static uint32_t create(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                           const uint16_t u16_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                           const uint8_t u8_MasterChannelFrameCount, const uint8_t u8_VirtualChannelFrameCount,
+                           const uint16_t u16_FirstHdrPtr,
+                           const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                           const uint32_t u32_OCF = 0,
+                           const uint8_t u8_InterleaveDepth = 0, const bool b_Randomize = false);
+
+    static uint32_t createBatch(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                const uint16_t u16_SpacecraftID,
+                                const Frame *pS_Frames, const uint16_t u16_FrameCount,
+                                const uint8_t u8_InterleaveDepth = 0, const bool b_Randomize = false);
+
+  private:
+    static bool _checkParameters(const uint8_t u8_InterleaveDepth, const bool b_Randomize);
+    static void _encode(uint8_t *pu8_Cadu, const uint8_t u8_InterleaveDepth, const bool b_Randomize);
+  };
+
+}
+
+#endif /* _CCSDS_CADU_H_ */
@@ -0,0 +1,1273 @@
+/**
+ * @file      ccsds_cfdp.cpp
+ *
+ * @brief     Source file of the CCSDS File Delivery Protocol (CFDP) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "ccsds_cfdp.h"
+#include "ccsds_transferframe.h"
+
+
+namespace CCSDS
+{
+
+  static void writeU32(uint8_t *pu8_Buffer, const uint32_t u32_Value)
+  {
+    pu8_Buffer[0] = (uint8_t)(u32_Value>>24);
+    pu8_Buffer[1] = (uint8_t)(u32_Value>>16);
+    pu8_Buffer[2] = (uint8_t)(u32_Value>>8);
+    pu8_Buffer[3] = (uint8_t)u32_Value;
+  }
+
+
+  static uint32_t readU32(const uint8_t *pu8_Buffer)
+  {
+    return ((uint32_t)pu8_Buffer[0]<<24) | ((uint32_t)pu8_Buffer[1]<<16)
+         | ((uint32_t)pu8_Buffer[2]<<8) | (uint32_t)pu8_Buffer[3];
+  }
+
+
+
+  /**
+   * @brief Construct a new Cfdp object
+   *
+   * @param u16_EntityID        The CFDP entity ID of this side
+   * @param u16_APID            The APID of the space packets which carry the PDUs (in both directions)
+   * @param e_PacketType        The packet type of the created space packets (SpacePacket::TM or SpacePacket::TC)
+   * @param p_ActionInterface   A pointer to the implementation of the action interface
+   */
+  Cfdp::Cfdp(const uint16_t u16_EntityID, const uint16_t u16_APID,
+             const SpacePacket::PacketType e_PacketType,
+             CfdpActionInterface *p_ActionInterface)
+    : mu16_EntityID{u16_EntityID}
+    , mu16_APID{u16_APID}
+    , me_PacketType{e_PacketType}
+    , mu16_SequenceCount{0}
+    , mu16_PacketSize{256}
+    , mb_PduCrc{false}
+    , mu32_NextSeqNr{0}
+    , mu32_Time{0}
+    , mu32_AckTimeout{10}
+    , mu32_NakTimeout{10}
+    , mu8_TimerLimit{5}
+    , mu16_ProtocolErrorCount{0}
+    , mu16_ChecksumErrorCount{0}
+    , mp_ActionInterface{p_ActionInterface}
+  {
+    memset(&mS_Tx, 0, sizeof(mS_Tx));
+    memset(&mS_Rx, 0, sizeof(mS_Rx));
+  }
+
+
+
+  /**
+   * @brief Overwrites the action interface which was set using the constructor
+   *
+   * @param p_ActionInterface   A pointer to the implementation of the action interface
+   */
+  void Cfdp::setActionInterface(CfdpActionInterface *p_ActionInterface)
+  {
+    mp_ActionInterface = p_ActionInterface;
+  }
+
+
+
+  /**
+   * @brief Sets the maximum size of the created space packets
+   *
+   * The size should be the data field size of the transfer frames (e.g. TransferframeAos::getDataZoneSize()
+   * minus the M_PDU header), so each file data PDU fills exactly one frame. The file data segment size
+   * is derived from it, see getSegmentSize().
+   *
+   * @param u16_PacketSize  The maximum size of a space packet including all headers
+   *
+   * @retval  0   The size was set
+   * @retval -1   The size is too small
+   */
+  int32_t Cfdp::setPacketSize(const uint16_t u16_PacketSize)
+  {
+    if(u16_PacketSize<MinPacketSize)
+      return -1;
+    mu16_PacketSize = u16_PacketSize;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Enables the CRC of the created PDUs (received PDUs are checked if they have a CRC)
+   *
+   * @param b_Enabled   true if the created PDUs shall have a CRC
+   */
+  void Cfdp::setPduCrc(const bool b_Enabled)
+  {
+    mb_PduCrc = b_Enabled;
+  }
+
+
+
+  /**
+   * @brief Sets the timers of the acknowledged mode
+   *
+   * @param u32_AckTimeout  Time after which an unacknowledged EOF or Finished PDU is sent again
+   * @param u32_NakTimeout  Time after which a NAK PDU is sent again if data is still missing
+   * @param u8_TimerLimit   Number of expirations after which a transaction is finished with an error
+   */
+  void Cfdp::setTimers(const uint32_t u32_AckTimeout, const uint32_t u32_NakTimeout, const uint8_t u8_TimerLimit)
+  {
+    mu32_AckTimeout = u32_AckTimeout;
+    mu32_NakTimeout = u32_NakTimeout;
+    mu8_TimerLimit = u8_TimerLimit;
+  }
+
+
+
+  /**
+   * @brief Starts the transfer of a file
+   *
+   * The file and the file names are not copied, so they must be valid until the transaction is finished.
+   * The checksum of the file is computed while the file data is sent.
+   *
+   * @param u16_DestEntityID    The entity ID of the receiver
+   * @param pu8_File            A pointer to the file data (e.g. a memory-mapped file)
+   * @param u32_FileSize        The size of the file in bytes
+   * @param pc_SourceFileName   The source file name (null-terminated, up to 255 characters)
+   * @param pc_DestFileName     The destination file name (null-terminated, up to 255 characters)
+   * @param b_Acknowledged      true for the acknowledged mode (class 2), false for the unacknowledged mode (class 1)
+   *
+   * @retval  0   The transfer was started
+   * @retval -1   A transfer is already active or the parameters are invalid
+   */
+  int32_t Cfdp::put(const uint16_t u16_DestEntityID, const uint8_t *pu8_File, const uint32_t u32_FileSize,
+                    const char *pc_SourceFileName, const char *pc_DestFileName, const bool b_Acknowledged)
+  {
+    size_t t_SourceLength, t_DestLength;
+
+    if(mS_Tx.b_Active || !pc_SourceFileName || !pc_DestFileName || (u32_FileSize>0 && !pu8_File))
+      return -1;
+
+    t_SourceLength = strlen(pc_SourceFileName);
+    t_DestLength = strlen(pc_DestFileName);
+    if(t_SourceLength>0xff || t_DestLength>0xff)
+      return -1;
+    // the metadata must fit into one packet
+    if(SP_HEADER_SIZE+PduHdrSize+CrcSize+10+t_SourceLength+t_DestLength>mu16_PacketSize)
+      return -1;
+
+    memset(&mS_Tx, 0, sizeof(mS_Tx));
+    mS_Tx.b_Valid = true;
+    mS_Tx.b_Active = true;
+    mS_Tx.b_Acknowledged = b_Acknowledged;
+    mS_Tx.u16_DestEntityID = u16_DestEntityID;
+    mS_Tx.u32_SeqNr = ++mu32_NextSeqNr;
+    mS_Tx.pu8_File = pu8_File;
+    mS_Tx.u32_FileSize = u32_FileSize;
+    mS_Tx.pc_SourceFileName = pc_SourceFileName;
+    mS_Tx.pc_DestFileName = pc_DestFileName;
+    mS_Tx.u8_Condition = NoError;
+    mS_Tx.b_SendMetadata = true;
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Cancels the active transfer; the EOF PDU is sent with the condition CancelRequestReceived
+   *
+   * @retval  0   The transfer is cancelled
+   * @retval -1   No transfer is active
+   */
+  int32_t Cfdp::cancel(void)
+  {
+    if(!mS_Tx.b_Active)
+      return -1;
+
+    mS_Tx.u8_Condition = CancelRequestReceived;
+    mS_Tx.u32_Offset = mS_Tx.u32_FileSize;
+    mS_Tx.u16_RetransmitCount = 0;
+    mS_Tx.b_SendEof = true;
+    mS_Tx.b_EofAcked = false;
+    mS_Tx.b_TimerRunning = false;
+    mS_Tx.u8_TimerCount = 0;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Creates the PDUs which are to be sent, one space packet per PDU
+   *
+   * The directives of the receiver and the sender are created first, then the requested retransmissions and
+   * then new file data, as long as the PDUs fit into the buffer. The remaining PDUs are created with the next
+   * call, so the buffer size limits the data rate. The method also runs the timers, so it must be called
+   * periodically, even if there is nothing to send.
+   *
+   * @param u32_CurrentTime The current time in ticks
+   * @param pu8_Buffer      The buffer where the space packets shall be stored
+   * @param u32_BufferSize  The available size of the buffer
+   *
+   * @return The size of the created space packets in bytes as uint32_t
+   */
+  uint32_t Cfdp::generate(const uint32_t u32_CurrentTime, uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    uint32_t u32_Size = 0;
+    uint32_t u32_PduSize;
+    uint32_t u32_Length;
+    uint32_t u32_SegmentSize = getSegmentSize();
+    Range *pS_Range;
+
+    mu32_Time = u32_CurrentTime;
+    _checkTimers();
+
+    if(!pu8_Buffer)
+      return 0;
+
+    // receiver directives
+    if(mS_Rx.b_SendEofAck)
+    {
+      if((u32_PduSize=_createAck(&pu8_Buffer[u32_Size], u32_BufferSize-u32_Size, true))==0)
+        return u32_Size;
+      u32_Size += u32_PduSize;
+      mS_Rx.b_SendEofAck = false;
+    }
+    while(mS_Rx.b_SendNak)
+    {
+      if((u32_PduSize=_createNak(&pu8_Buffer[u32_Size], u32_BufferSize-u32_Size))==0)
+        return u32_Size;
+      u32_Size += u32_PduSize;
+    }
+    if(mS_Rx.b_SendFinished)
+    {
+      if((u32_PduSize=_createFinished(&pu8_Buffer[u32_Size], u32_BufferSize-u32_Size))==0)
+        return u32_Size;
+      u32_Size += u32_PduSize;
+      mS_Rx.b_SendFinished = false;
+      mS_Rx.b_TimerRunning = true;
+      mS_Rx.u32_Timer = mu32_Time+mu32_AckTimeout;
+    }
+
+    // sender directives
+    if(mS_Tx.b_SendFinishedAck)
+    {
+      if((u32_PduSize=_createAck(&pu8_Buffer[u32_Size], u32_BufferSize-u32_Size, false))==0)
+        return u32_Size;
+      u32_Size += u32_PduSize;
+      mS_Tx.b_SendFinishedAck = false;
+    }
+    if(!mS_Tx.b_Active)
+      return u32_Size;
+
+    if(mS_Tx.b_SendMetadata)
+    {
+      if((u32_PduSize=_createMetadata(&pu8_Buffer[u32_Size], u32_BufferSize-u32_Size))==0)
+        return u32_Size;
+      u32_Size += u32_PduSize;
+      mS_Tx.b_SendMetadata = false;
+    }
+
+    // requested segments
+    while(mS_Tx.u16_RetransmitCount>0)
+    {
+      pS_Range = &mS_Tx.aS_Retransmit[mS_Tx.u16_RetransmitHead];
+      u32_Length = pS_Range->u32_End-pS_Range->u32_Start;
+      if(u32_Length>u32_SegmentSize)
+        u32_Length = u32_SegmentSize;
+      if((u32_PduSize=_createFileData(&pu8_Buffer[u32_Size], u32_BufferSize-u32_Size, pS_Range->u32_Start, u32_Length))==0)
+        return u32_Size;
+      u32_Size += u32_PduSize;
+      pS_Range->u32_Start += u32_Length;
+      if(pS_Range->u32_Start>=pS_Range->u32_End)
+      {
+        mS_Tx.u16_RetransmitHead = (uint16_t)((mS_Tx.u16_RetransmitHead+1)%CFDP_MAX_GAPS);
+        mS_Tx.u16_RetransmitCount--;
+      }
+    }
+
+    // new segments
+    while(mS_Tx.u32_Offset<mS_Tx.u32_FileSize)
+    {
+      u32_Length = mS_Tx.u32_FileSize-mS_Tx.u32_Offset;
+      if(u32_Length>u32_SegmentSize)
+        u32_Length = u32_SegmentSize;
+      if((u32_PduSize=_createFileData(&pu8_Buffer[u32_Size], u32_BufferSize-u32_Size, mS_Tx.u32_Offset, u32_Length))==0)
+        return u32_Size;
+      u32_Size += u32_PduSize;
+      mS_Tx.u32_Checksum = calcChecksum(mS_Tx.u32_Checksum, &mS_Tx.pu8_File[mS_Tx.u32_Offset], u32_Length, mS_Tx.u32_Offset);
+      mS_Tx.u32_Offset += u32_Length;
+    }
+    if(!mS_Tx.b_EofSent)
+      mS_Tx.b_SendEof = true;
+
+    if(mS_Tx.b_SendEof)
+    {
+      if((u32_PduSize=_createEof(&pu8_Buffer[u32_Size], u32_BufferSize-u32_Size))==0)
+        return u32_Size;
+      u32_Size += u32_PduSize;
+      mS_Tx.b_SendEof = false;
+      mS_Tx.b_EofSent = true;
+      if(mS_Tx.b_Acknowledged)
+      {
+        mS_Tx.b_TimerRunning = true;
+        mS_Tx.u32_Timer = mu32_Time+mu32_AckTimeout;
+      }
+      else
+      {
+        _finishSender(mS_Tx.u8_Condition);
+      }
+    }
+
+    return u32_Size;
+  }
+
+
+
+  /**
+   * @brief Returns the size of the file data in a file data PDU, which depends on the packet size
+   *
+   * @return The segment size in bytes
+   */
+  uint16_t Cfdp::getSegmentSize(void)
+  {
+    return (uint16_t)(mu16_PacketSize-(SP_HEADER_SIZE+PduHdrSize+OffsetSize+(mb_PduCrc?CrcSize:0)));
+  }
+
+
+
+  /**
+   * @brief Returns if a file is currently sent
+   *
+   * @return true if a sending transaction is active
+   */
+  bool Cfdp::isSending(void)
+  {
+    return mS_Tx.b_Active;
+  }
+
+
+
+  /**
+   * @brief Returns if a file is currently received
+   *
+   * @return true if a receiving transaction is active
+   */
+  bool Cfdp::isReceiving(void)
+  {
+    return mS_Rx.b_Active;
+  }
+
+
+
+  /**
+   * @brief Returns the number of protocol errors
+   *
+   * Protocol errors occur if a received PDU is malformed or uses features which are not supported.
+   *
+   * If the number of protocol errors exceeds 65535, the method returns 65535.
+   *
+   * @return Number of protocol errors as uint16_t
+   */
+  uint16_t Cfdp::getProtocolErrorCount(void)
+  {
+    return mu16_ProtocolErrorCount;
+  }
+
+
+
+  /**
+   * @brief Returns the number of PDUs which were dropped because of a wrong CRC
+   *
+   * If the number of checksum errors exceeds 65535, the method returns 65535.
+   *
+   * @return Number of checksum errors as uint16_t
+   */
+  uint16_t Cfdp::getChecksumErrorCount(void)
+  {
+    return mu16_ChecksumErrorCount;
+  }
+
+
+
+  /**
+   * @brief Clears all error counters (Protocol Error and Checksum Error)
+   */
+  void Cfdp::clearErrorCounters(void)
+  {
+    mu16_ProtocolErrorCount = 0;
+    mu16_ChecksumErrorCount = 0;
+  }
+
+
+
+  /**
+   * @brief Adds data to the CFDP modular checksum
+   *
+   * The checksum is the sum of all 32 bit words of the file, aligned to the start of the file,
+   * so the data of a file can be added in any order.
+   *
+   * @param u32_Checksum  The checksum of the data so far (0 at the start)
+   * @param pu8_Data      A pointer to the data
+   * @param u32_Size      The size of the data in bytes
+   * @param u32_Offset    The offset of the data within the file
+   *
+   * @return The updated checksum as uint32_t
+   */
+  uint32_t Cfdp::calcChecksum(uint32_t u32_Checksum, const uint8_t *pu8_Data, const uint32_t u32_Size, const uint32_t u32_Offset)
+  {
+    uint32_t i = 0;
+
+    // up to the next word boundary
+    for(; i<u32_Size && ((u32_Offset+i)&0x3)!=0; i++)
+      u32_Checksum += (uint32_t)pu8_Data[i]<<(24-8*((u32_Offset+i)&0x3));
+
+    for(; i+4<=u32_Size; i+=4)
+      u32_Checksum += readU32(&pu8_Data[i]);
+
+    for(; i<u32_Size; i++)
+      u32_Checksum += (uint32_t)pu8_Data[i]<<(24-8*((u32_Offset+i)&0x3));
+
+    return u32_Checksum;
+  }
+
+
+
+  /**
+   * @brief Processes a received space packet which holds a PDU
+   *
+   * Space packets of other APIDs are ignored.
+   *
+   * @param u8_PacketType       The packet type (TM or TC)
+   * @param u8_SequenceFlags    The sequence flags (Continuation, First, Last Segment or Unsegmented)
+   * @param u16_APID            The application ID
+   * @param u16_SequenceCount   The packet sequence count
+   * @param b_SecHeader         A flag which indicates the presence of a secondary space packet header
+   * @param pu8_PacketData      A pointer to the PDU
+   * @param u16_PacketDataLength The size of the PDU in bytes
+   */
+  void Cfdp::onSpacePacketReceived(const uint8_t u8_PacketType,
+                                   const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                                   const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                                   const uint8_t *pu8_PacketData, const uint16_t u16_PacketDataLength)
+  {
+    uint16_t u16_DataFieldLength;
+    uint8_t u8_EntityIdSize, u8_SeqNrSize, u8_HeaderSize;
+    uint16_t u16_SourceEntityID = 0, u16_DestEntityID = 0;
+    uint32_t u32_SeqNr = 0;
+    uint8_t i;
+
+    (void)u8_PacketType;
+    (void)u8_SequenceFlags;
+    (void)u16_SequenceCount;
+    (void)b_SecHeader;
+
+    if(u16_APID!=mu16_APID || !pu8_PacketData)
+      return;
+
+    if(u16_PacketDataLength<4 || (pu8_PacketData[0]>>5)!=CfdpVersion)
+    {
+      if(mu16_ProtocolErrorCount<0xffff)
+        mu16_ProtocolErrorCount++;
+      return;
+    }
+
+    u16_DataFieldLength = (uint16_t)((pu8_PacketData[1]<<8) | pu8_PacketData[2]);
+    u8_EntityIdSize = (uint8_t)(((pu8_PacketData[3]>>4)&0x7)+1);
+    u8_SeqNrSize = (uint8_t)((pu8_PacketData[3]&0x7)+1);
+    u8_HeaderSize = (uint8_t)(4+2*u8_EntityIdSize+u8_SeqNrSize);
+
+    // large files, segment metadata and long IDs are not supported
+    if((pu8_PacketData[0]&0x01) || (pu8_PacketData[3]&0x08)
+       || u8_EntityIdSize>EntityIdSize || u8_SeqNrSize>SeqNrSize
+       || (uint32_t)u8_HeaderSize+u16_DataFieldLength>u16_PacketDataLength)
+    {
+      if(mu16_ProtocolErrorCount<0xffff)
+        mu16_ProtocolErrorCount++;
+      return;
+    }
+
+    if(pu8_PacketData[0]&0x02)
+    {
+      if(u16_DataFieldLength<CrcSize
+         || Transferframe::calcCRC(pu8_PacketData, (uint16_t)(u8_HeaderSize+u16_DataFieldLength-CrcSize))
+            !=(uint16_t)((pu8_PacketData[u8_HeaderSize+u16_DataFieldLength-2]<<8) | pu8_PacketData[u8_HeaderSize+u16_DataFieldLength-1]))
+      {
+        if(mu16_ChecksumErrorCount<0xffff)
+          mu16_ChecksumErrorCount++;
+        return;
+      }
+      u16_DataFieldLength = (uint16_t)(u16_DataFieldLength-CrcSize);
+    }
+
+    for(i=0; i<u8_EntityIdSize; i++)
+    {
+      u16_SourceEntityID = (uint16_t)((u16_SourceEntityID<<8) | pu8_PacketData[4+i]);
+      u16_DestEntityID = (uint16_t)((u16_DestEntityID<<8) | pu8_PacketData[4+u8_EntityIdSize+u8_SeqNrSize+i]);
+    }
+    for(i=0; i<u8_SeqNrSize; i++)
+      u32_SeqNr = (u32_SeqNr<<8) | pu8_PacketData[4+u8_EntityIdSize+i];
+
+    if(pu8_PacketData[0]&0x08)
+    {
+      // toward the sender: directives of the receiver, which are not file data
+      if(u16_SourceEntityID==mu16_EntityID && !(pu8_PacketData[0]&0x10) && u16_DataFieldLength>0)
+        _processSenderPdu(u32_SeqNr, &pu8_PacketData[u8_HeaderSize], u16_DataFieldLength);
+    }
+    else
+    {
+      if(u16_DestEntityID==mu16_EntityID && u16_DataFieldLength>0)
+        _processReceiverPdu((pu8_PacketData[0]&0x10)?true:false, (pu8_PacketData[0]&0x04)?false:true,
+                            u16_SourceEntityID, u32_SeqNr, &pu8_PacketData[u8_HeaderSize], u16_DataFieldLength);
+    }
+  }
+
+
+
+  /*
+   * Creates a space packet with a PDU; the PDU consists of the header, a directive or offset field and the data,
+   * which is copied directly from its source. If pu8_Field is nullptr, the field was already written into the buffer.
+   */
+  uint32_t Cfdp::_createPdu(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                            const bool b_FileData, const bool b_TowardSender, const bool b_Acknowledged,
+                            const uint16_t u16_SourceEntityID, const uint32_t u32_SeqNr, const uint16_t u16_DestEntityID,
+                            const uint8_t *pu8_Field, const uint16_t u16_FieldSize,
+                            const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    uint32_t u32_DataFieldLength = u16_FieldSize+u32_DataSize+(mb_PduCrc?CrcSize:0);
+    uint32_t u32_PacketSize = SP_HEADER_SIZE+PduHdrSize+u32_DataFieldLength;
+    uint8_t *pu8_Pdu = &pu8_Buffer[SP_HEADER_SIZE];
+
+    if(u32_PacketSize>u32_BufferSize || u32_PacketSize>mu16_PacketSize)
+      return 0;
+
+    pu8_Pdu[0] = (uint8_t)((CfdpVersion<<5) | (b_FileData?0x10:0) | (b_TowardSender?0x08:0)
+                           | (b_Acknowledged?0:0x04) | (mb_PduCrc?0x02:0));
+    pu8_Pdu[1] = (uint8_t)(u32_DataFieldLength>>8);
+    pu8_Pdu[2] = (uint8_t)u32_DataFieldLength;
+    pu8_Pdu[3] = (uint8_t)(((EntityIdSize-1)<<4) | (SeqNrSize-1));
+    pu8_Pdu[4] = (uint8_t)(u16_SourceEntityID>>8);
+    pu8_Pdu[5] = (uint8_t)u16_SourceEntityID;
+    writeU32(&pu8_Pdu[6], u32_SeqNr);
+    pu8_Pdu[10] = (uint8_t)(u16_DestEntityID>>8);
+    pu8_Pdu[11] = (uint8_t)u16_DestEntityID;
+
+    if(pu8_Field)
+      memcpy(&pu8_Pdu[PduHdrSize], pu8_Field, u16_FieldSize);
+    if(u32_DataSize>0)
+      memcpy(&pu8_Pdu[PduHdrSize+u16_FieldSize], pu8_Data, u32_DataSize);
+
+    if(mb_PduCrc)
+    {
+      uint16_t u16_CRC = Transferframe::calcCRC(pu8_Pdu, (uint16_t)(u32_PacketSize-SP_HEADER_SIZE-CrcSize));
+      pu8_Buffer[u32_PacketSize-2] = (uint8_t)(u16_CRC>>8);
+      pu8_Buffer[u32_PacketSize-1] = (uint8_t)u16_CRC;
+    }
+
+    SpacePacket::createPrimaryHeader(pu8_Buffer, me_PacketType, SpacePacket::Unsegmented, mu16_APID, mu16_SequenceCount,
+                                     false, u32_PacketSize-SP_HEADER_SIZE);
+    mu16_SequenceCount = (uint16_t)((mu16_SequenceCount+1)&0x3fff);
+
+    return u32_PacketSize;
+  }
+
+
+
+  /*
+   * Creates a file data PDU; the data is read directly from the file
+   */
+  uint32_t Cfdp::_createFileData(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint32_t u32_Offset, const uint32_t u32_Size)
+  {
+    uint8_t au8_Offset[OffsetSize];
+
+    writeU32(au8_Offset, u32_Offset);
+    return _createPdu(pu8_Buffer, u32_BufferSize, true, false, mS_Tx.b_Acknowledged,
+                      mu16_EntityID, mS_Tx.u32_SeqNr, mS_Tx.u16_DestEntityID,
+                      au8_Offset, OffsetSize, &mS_Tx.pu8_File[u32_Offset], u32_Size);
+  }
+
+
+
+  uint32_t Cfdp::_createMetadata(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    uint8_t u8_SourceLength = (uint8_t)strlen(mS_Tx.pc_SourceFileName);
+    uint8_t u8_DestLength = (uint8_t)strlen(mS_Tx.pc_DestFileName);
+    uint16_t u16_FieldSize = (uint16_t)(8+u8_SourceLength+u8_DestLength);
+    uint8_t *pu8_Field = &pu8_Buffer[SP_HEADER_SIZE+PduHdrSize];
+
+    // the field is written in place
+    if((uint32_t)(SP_HEADER_SIZE+PduHdrSize+u16_FieldSize+(mb_PduCrc?CrcSize:0))>u32_BufferSize)
+      return 0;
+
+    pu8_Field[0] = MetadataPdu;
+    pu8_Field[1] = ModularChecksum;
+    writeU32(&pu8_Field[2], mS_Tx.u32_FileSize);
+    pu8_Field[6] = u8_SourceLength;
+    memcpy(&pu8_Field[7], mS_Tx.pc_SourceFileName, u8_SourceLength);
+    pu8_Field[7+u8_SourceLength] = u8_DestLength;
+    memcpy(&pu8_Field[8+u8_SourceLength], mS_Tx.pc_DestFileName, u8_DestLength);
+
+    return _createPdu(pu8_Buffer, u32_BufferSize, false, false, mS_Tx.b_Acknowledged,
+                      mu16_EntityID, mS_Tx.u32_SeqNr, mS_Tx.u16_DestEntityID,
+                      nullptr, u16_FieldSize, nullptr, 0);
+  }
+
+
+
+  /*
+   * Creates the EOF PDU; if the transaction was cancelled, the checksum covers the data sent so far and
+   * this entity is given as the fault location
+   */
+  uint32_t Cfdp::_createEof(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    uint8_t au8_Field[10+FaultLocationSize];
+
+    au8_Field[0] = EofPdu;
+    au8_Field[1] = (uint8_t)(mS_Tx.u8_Condition<<4);
+    writeU32(&au8_Field[2], mS_Tx.u32_Checksum);
+    writeU32(&au8_Field[6], mS_Tx.u32_FileSize);
+    if(mS_Tx.u8_Condition!=NoError)
+      _writeFaultLocation(&au8_Field[10], mu16_EntityID);
+
+    return _createPdu(pu8_Buffer, u32_BufferSize, false, false, mS_Tx.b_Acknowledged,
+                      mu16_EntityID, mS_Tx.u32_SeqNr, mS_Tx.u16_DestEntityID,
+                      au8_Field, (uint16_t)((mS_Tx.u8_Condition!=NoError)?sizeof(au8_Field):10), nullptr, 0);
+  }
+
+
+
+  /*
+   * Creates the ACK of the EOF PDU (receiver) or of the Finished PDU (sender)
+   */
+  uint32_t Cfdp::_createAck(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const bool b_TowardSender)
+  {
+    uint8_t au8_Field[3];
+
+    au8_Field[0] = AckPdu;
+    if(b_TowardSender)
+    {
+      au8_Field[1] = (uint8_t)(EofPdu<<4);
+      au8_Field[2] = (uint8_t)((mS_Rx.u8_EofCondition<<4) | (mS_Rx.b_Active?0x01:0x02));
+      return _createPdu(pu8_Buffer, u32_BufferSize, false, true, true,
+                        mS_Rx.u16_SourceEntityID, mS_Rx.u32_SeqNr, mu16_EntityID,
+                        au8_Field, sizeof(au8_Field), nullptr, 0);
+    }
+
+    au8_Field[1] = (uint8_t)((FinishedPdu<<4) | 0x01);
+    au8_Field[2] = (uint8_t)((mS_Tx.u8_FinishedCondition<<4) | 0x02);
+    return _createPdu(pu8_Buffer, u32_BufferSize, false, false, true,
+                      mu16_EntityID, mS_Tx.u32_SeqNr, mS_Tx.u16_DestEntityID,
+                      au8_Field, sizeof(au8_Field), nullptr, 0);
+  }
+
+
+
+  /*
+   * Creates the next NAK PDU of the list of missing data; the metadata is requested with the range 0..0
+   */
+  uint32_t Cfdp::_createNak(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    uint16_t u16_Entries = (uint16_t)(mS_Rx.u16_GapCount+(mS_Rx.b_Metadata?0:1));
+    uint16_t u16_Count = (uint16_t)((mu16_PacketSize-(SP_HEADER_SIZE+PduHdrSize+NakHdrSize+(mb_PduCrc?CrcSize:0)))/SegmentRequestSize);
+    uint16_t u16_FieldSize;
+    uint8_t *pu8_Field = &pu8_Buffer[SP_HEADER_SIZE+PduHdrSize];
+    uint8_t *pu8_Request;
+    uint32_t u32_ScopeStart = 0;
+    uint32_t u32_ScopeEnd = mS_Rx.u32_Progress;
+    uint32_t u32_PduSize;
+    uint16_t u16_Entry;
+
+    if(mS_Rx.u16_NakNext>u16_Entries)
+      mS_Rx.u16_NakNext = u16_Entries;
+    if(u16_Count>u16_Entries-mS_Rx.u16_NakNext)
+      u16_Count = (uint16_t)(u16_Entries-mS_Rx.u16_NakNext);
+
+    // the field is written in place
+    u16_FieldSize = (uint16_t)(NakHdrSize+u16_Count*SegmentRequestSize);
+    if((uint32_t)(SP_HEADER_SIZE+PduHdrSize+u16_FieldSize+(mb_PduCrc?CrcSize:0))>u32_BufferSize)
+      return 0;
+
+    pu8_Request = &pu8_Field[NakHdrSize];
+    for(uint16_t i=0; i<u16_Count; i++)
+    {
+      u16_Entry = (uint16_t)(mS_Rx.u16_NakNext+i);
+      if(!mS_Rx.b_Metadata)
+      {
+        if(u16_Entry==0)
+        {
+          writeU32(&pu8_Request[0], 0);
+          writeU32(&pu8_Request[4], 0);
+          pu8_Request += SegmentRequestSize;
+          continue;
+        }
+        u16_Entry--;
+      }
+      writeU32(&pu8_Request[0], mS_Rx.aS_Gap[u16_Entry].u32_Start);
+      writeU32(&pu8_Request[4], mS_Rx.aS_Gap[u16_Entry].u32_End);
+      if(i==0)
+        u32_ScopeStart = mS_Rx.aS_Gap[u16_Entry].u32_Start;
+      pu8_Request += SegmentRequestSize;
+    }
+    if(mS_Rx.u16_NakNext==0)
+      u32_ScopeStart = 0;
+    if(mS_Rx.u16_NakNext+u16_Count<u16_Entries)
+      u32_ScopeEnd = readU32(&pu8_Request[-4]);
+
+    pu8_Field[0] = NakPdu;
+    writeU32(&pu8_Field[1], u32_ScopeStart);
+    writeU32(&pu8_Field[5], u32_ScopeEnd);
+
+    if((u32_PduSize=_createPdu(pu8_Buffer, u32_BufferSize, false, true, true,
+                               mS_Rx.u16_SourceEntityID, mS_Rx.u32_SeqNr, mu16_EntityID,
+                               nullptr, u16_FieldSize, nullptr, 0))==0)
+      return 0;
+
+    mS_Rx.u16_NakNext = (uint16_t)(mS_Rx.u16_NakNext+u16_Count);
+    if(mS_Rx.u16_NakNext>=u16_Entries)
+    {
+      mS_Rx.b_SendNak = false;
+      mS_Rx.u16_NakNext = 0;
+      // the NAK timer is only used when the end of the file is known
+      if(mS_Rx.b_Eof)
+      {
+        mS_Rx.b_TimerRunning = true;
+        mS_Rx.u32_Timer = mu32_Time+mu32_NakTimeout;
+      }
+    }
+
+    return u32_PduSize;
+  }
+
+
+
+  /*
+   * Creates the Finished PDU; a fault is located at this entity, except for the cancel request of the sender
+   */
+  uint32_t Cfdp::_createFinished(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    uint8_t au8_Field[2+FaultLocationSize];
+
+    // delivery code complete and file retained, or incomplete and file status unreported
+    au8_Field[0] = FinishedPdu;
+    au8_Field[1] = (uint8_t)((mS_Rx.u8_Condition<<4) | ((mS_Rx.u8_Condition==NoError)?0x02:0x07));
+    if(mS_Rx.u8_Condition!=NoError)
+      _writeFaultLocation(&au8_Field[2], (mS_Rx.u8_Condition==CancelRequestReceived)?mS_Rx.u16_SourceEntityID:mu16_EntityID);
+
+    return _createPdu(pu8_Buffer, u32_BufferSize, false, true, mS_Rx.b_Acknowledged,
+                      mS_Rx.u16_SourceEntityID, mS_Rx.u32_SeqNr, mu16_EntityID,
+                      au8_Field, (uint16_t)((mS_Rx.u8_Condition!=NoError)?sizeof(au8_Field):2), nullptr, 0);
+  }
+
+
+
+  /*
+   * Writes the fault location, an entity ID TLV
+   */
+  void Cfdp::_writeFaultLocation(uint8_t *pu8_Buffer, const uint16_t u16_EntityID)
+  {
+    pu8_Buffer[0] = EntityIdTlv;
+    pu8_Buffer[1] = EntityIdSize;
+    pu8_Buffer[2] = (uint8_t)(u16_EntityID>>8);
+    pu8_Buffer[3] = (uint8_t)u16_EntityID;
+  }
+
+
+
+  /*
+   * Handles the expired ACK and NAK timers
+   */
+  void Cfdp::_checkTimers(void)
+  {
+    if(mS_Tx.b_Active && mS_Tx.b_TimerRunning && _expired(mS_Tx.u32_Timer))
+    {
+      // EOF not acknowledged
+      mS_Tx.b_TimerRunning = false;
+      if(++mS_Tx.u8_TimerCount>mu8_TimerLimit)
+        _finishSender(PositiveAckLimitReached);
+      else
+        mS_Tx.b_SendEof = true;
+    }
+
+    if(mS_Rx.b_Active && mS_Rx.b_TimerRunning && _expired(mS_Rx.u32_Timer))
+    {
+      mS_Rx.b_TimerRunning = false;
+      if(mS_Rx.b_Complete)
+      {
+        // Finished not acknowledged
+        if(++mS_Rx.u8_TimerCount>mu8_TimerLimit)
+        {
+          mS_Rx.b_Active = false;
+          if(mp_ActionInterface)
+            mp_ActionInterface->onCfdpFault(false, mS_Rx.u16_SourceEntityID, mS_Rx.u32_SeqNr, PositiveAckLimitReached);
+        }
+        else
+          mS_Rx.b_SendFinished = true;
+      }
+      else
+      {
+        // data still missing
+        if(++mS_Rx.u8_TimerCount>mu8_TimerLimit)
+        {
+          _finishReceiver(NakLimitReached);
+        }
+        else
+        {
+          mS_Rx.b_SendNak = true;
+          mS_Rx.u16_NakNext = 0;
+        }
+      }
+    }
+  }
+
+
+
+  bool Cfdp::_expired(const uint32_t u32_Timer)
+  {
+    return ((int32_t)(mu32_Time-u32_Timer)>=0);
+  }
+
+
+
+  /*
+   * Processes a directive which was sent by the receiver of the own file
+   */
+  void Cfdp::_processSenderPdu(const uint32_t u32_SeqNr, const uint8_t *pu8_Pdu, const uint16_t u16_PduSize)
+  {
+    uint32_t u32_Start, u32_End;
+
+    if(!mS_Tx.b_Valid || u32_SeqNr!=mS_Tx.u32_SeqNr)
+      return;
+
+    switch(pu8_Pdu[0])
+    {
+      case AckPdu:
+        if(u16_PduSize>=3 && (pu8_Pdu[1]>>4)==EofPdu && mS_Tx.b_Active && mS_Tx.b_EofSent)
+        {
+          mS_Tx.b_EofAcked = true;
+          mS_Tx.b_TimerRunning = false;
+          mS_Tx.u8_TimerCount = 0;
+        }
+        break;
+
+      case NakPdu:
+        if(!mS_Tx.b_Active || !mS_Tx.b_Acknowledged || u16_PduSize<NakHdrSize)
+          break;
+        // a NAK list which starts at the beginning of the file replaces all pending requests
+        if(readU32(&pu8_Pdu[1])==0)
+          mS_Tx.u16_RetransmitCount = 0;
+        for(uint16_t i=NakHdrSize; i+SegmentRequestSize<=u16_PduSize; i+=SegmentRequestSize)
+        {
+          u32_Start = readU32(&pu8_Pdu[i]);
+          u32_End = readU32(&pu8_Pdu[i+4]);
+          if(u32_Start==0 && u32_End==0)
+          {
+            mS_Tx.b_SendMetadata = true;
+            continue;
+          }
+          if(u32_End>mS_Tx.u32_FileSize)
+            u32_End = mS_Tx.u32_FileSize;
+          if(u32_Start<u32_End)
+            _queueRetransmit(u32_Start, u32_End);
+        }
+        break;
+
+      case FinishedPdu:
+        if(u16_PduSize<2)
+          break;
+        mS_Tx.u8_FinishedCondition = (uint8_t)(pu8_Pdu[1]>>4);
+        if(mS_Tx.b_Acknowledged)
+          mS_Tx.b_SendFinishedAck = true;
+        if(mS_Tx.b_Active)
+          _finishSender(mS_Tx.u8_FinishedCondition);
+        break;
+
+      default:
+        break;
+    }
+  }
+
+
+
+  /*
+   * Processes a PDU which was sent to this entity by the sender of a file
+   */
+  void Cfdp::_processReceiverPdu(const bool b_FileData, const bool b_Acknowledged,
+                                 const uint16_t u16_SourceEntityID, const uint32_t u32_SeqNr,
+                                 const uint8_t *pu8_Pdu, const uint16_t u16_PduSize)
+  {
+    if(!mS_Rx.b_Valid || u16_SourceEntityID!=mS_Rx.u16_SourceEntityID || u32_SeqNr!=mS_Rx.u32_SeqNr)
+    {
+      // only one receiving transaction at a time
+      if(mS_Rx.b_Active)
+        return;
+      if(!b_FileData && pu8_Pdu[0]!=MetadataPdu && pu8_Pdu[0]!=EofPdu)
+        return;
+
+      memset(&mS_Rx, 0, sizeof(mS_Rx));
+      mS_Rx.b_Valid = true;
+      mS_Rx.b_Active = true;
+      mS_Rx.b_Acknowledged = b_Acknowledged;
+      mS_Rx.u16_SourceEntityID = u16_SourceEntityID;
+      mS_Rx.u32_SeqNr = u32_SeqNr;
+    }
+    else if(!mS_Rx.b_Active)
+    {
+      // the ACK of the EOF PDU of a finished transaction was lost
+      if(!b_FileData && pu8_Pdu[0]==EofPdu && mS_Rx.b_Acknowledged)
+        mS_Rx.b_SendEofAck = true;
+      return;
+    }
+
+    if(b_FileData)
+    {
+      _receiveFileData(pu8_Pdu, u16_PduSize);
+      return;
+    }
+
+    switch(pu8_Pdu[0])
+    {
+      case MetadataPdu:
+        _receiveMetadata(pu8_Pdu, u16_PduSize);
+        break;
+
+      case EofPdu:
+        _receiveEof(pu8_Pdu, u16_PduSize);
+        break;
+
+      case AckPdu:
+        if(u16_PduSize>=2 && (pu8_Pdu[1]>>4)==FinishedPdu && mS_Rx.b_Complete)
+        {
+          mS_Rx.b_Active = false;
+          mS_Rx.b_TimerRunning = false;
+        }
+        break;
+
+      case PromptPdu:
+        // NAK response requested
+        if(u16_PduSize>=2 && !(pu8_Pdu[1]&0x80) && mS_Rx.b_Acknowledged && !mS_Rx.b_Complete)
+        {
+          mS_Rx.b_SendNak = true;
+          mS_Rx.u16_NakNext = 0;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+
+
+  void Cfdp::_receiveMetadata(const uint8_t *pu8_Pdu, const uint16_t u16_PduSize)
+  {
+    uint8_t u8_SourceLength, u8_DestLength;
+    uint32_t u32_FileSize;
+
+    if(mS_Rx.b_Metadata || mS_Rx.b_Complete)
+      return;
+
+    if(u16_PduSize<8 || u16_PduSize<8+pu8_Pdu[6] || u16_PduSize<8+pu8_Pdu[6]+pu8_Pdu[7+pu8_Pdu[6]])
+    {
+      if(mu16_ProtocolErrorCount<0xffff)
+        mu16_ProtocolErrorCount++;
+      return;
+    }
+    u32_FileSize = readU32(&pu8_Pdu[2]);
+    u8_SourceLength = pu8_Pdu[6];
+    u8_DestLength = pu8_Pdu[7+u8_SourceLength];
+
+    if((pu8_Pdu[1]&0x0f)!=ModularChecksum)
+    {
+      _finishReceiver(UnsupportedChecksumType);
+      return;
+    }
+    if(mS_Rx.b_Eof && u32_FileSize!=mS_Rx.u32_FileSize)
+    {
+      _finishReceiver(FileSizeError);
+      return;
+    }
+
+    mS_Rx.b_Metadata = true;
+    mS_Rx.u32_FileSize = u32_FileSize;
+    if(mp_ActionInterface)
+      mS_Rx.pu8_File = mp_ActionInterface->onCfdpMetadataReceived(mS_Rx.u16_SourceEntityID, mS_Rx.u32_SeqNr,
+                                                                  &pu8_Pdu[7], u8_SourceLength,
+                                                                  &pu8_Pdu[8+u8_SourceLength], u8_DestLength,
+                                                                  u32_FileSize);
+    if(!mS_Rx.pu8_File)
+    {
+      _finishReceiver(FilestoreRejection);
+      return;
+    }
+
+    _checkComplete();
+  }
+
+
+
+  /*
+   * Writes the file data directly to its place in the file and updates the list of missing ranges
+   */
+  void Cfdp::_receiveFileData(const uint8_t *pu8_Pdu, const uint16_t u16_PduSize)
+  {
+    uint32_t u32_Offset, u32_Size;
+
+    if(u16_PduSize<OffsetSize)
+    {
+      if(mu16_ProtocolErrorCount<0xffff)
+        mu16_ProtocolErrorCount++;
+      return;
+    }
+
+    // data without the metadata is dropped and requested again
+    if(mS_Rx.b_Complete || !mS_Rx.pu8_File)
+      return;
+
+    u32_Offset = readU32(pu8_Pdu);
+    u32_Size = (uint32_t)(u16_PduSize-OffsetSize);
+    if(u32_Offset>mS_Rx.u32_FileSize || u32_Size>mS_Rx.u32_FileSize-u32_Offset)
+    {
+      if(mu16_ProtocolErrorCount<0xffff)
+        mu16_ProtocolErrorCount++;
+      return;
+    }
+
+    memcpy(&mS_Rx.pu8_File[u32_Offset], &pu8_Pdu[OffsetSize], u32_Size);
+
+    if(u32_Offset>mS_Rx.u32_Progress)
+      _addGap(mS_Rx.u32_Progress, u32_Offset);
+    else if(u32_Offset<mS_Rx.u32_Progress)
+    {
+      _removeGaps(u32_Offset, u32_Offset+u32_Size);
+      // the retransmission is in progress, so the NAK timer is restarted
+      if(mS_Rx.b_TimerRunning)
+      {
+        mS_Rx.u32_Timer = mu32_Time+mu32_NakTimeout;
+        mS_Rx.u8_TimerCount = 0;
+      }
+    }
+    if(u32_Offset+u32_Size>mS_Rx.u32_Progress)
+      mS_Rx.u32_Progress = u32_Offset+u32_Size;
+
+    _checkComplete();
+  }
+
+
+
+  void Cfdp::_receiveEof(const uint8_t *pu8_Pdu, const uint16_t u16_PduSize)
+  {
+    uint8_t u8_Condition;
+    uint32_t u32_FileSize;
+
+    if(u16_PduSize<10)
+    {
+      if(mu16_ProtocolErrorCount<0xffff)
+        mu16_ProtocolErrorCount++;
+      return;
+    }
+    u8_Condition = (uint8_t)(pu8_Pdu[1]>>4);
+    u32_FileSize = readU32(&pu8_Pdu[6]);
+
+    if(mS_Rx.b_Acknowledged)
+    {
+      mS_Rx.u8_EofCondition = u8_Condition;
+      mS_Rx.b_SendEofAck = true;
+    }
+    if(mS_Rx.b_Eof || mS_Rx.b_Complete)
+      return;
+
+    mS_Rx.b_Eof = true;
+    mS_Rx.u32_EofChecksum = readU32(&pu8_Pdu[2]);
+
+    if(u8_Condition!=NoError)
+    {
+      _finishReceiver(u8_Condition);
+      return;
+    }
+    if((mS_Rx.b_Metadata && u32_FileSize!=mS_Rx.u32_FileSize) || mS_Rx.u32_Progress>u32_FileSize)
+    {
+      _finishReceiver(FileSizeError);
+      return;
+    }
+
+    mS_Rx.u32_FileSize = u32_FileSize;
+    if(mS_Rx.u32_Progress<u32_FileSize)
+    {
+      _addGap(mS_Rx.u32_Progress, u32_FileSize);
+      mS_Rx.u32_Progress = u32_FileSize;
+    }
+
+    _checkComplete();
+    if(!mS_Rx.b_Complete)
+    {
+      // deferred NAK mode: the missing data is requested when the EOF PDU is received
+      mS_Rx.b_SendNak = true;
+      mS_Rx.u16_NakNext = 0;
+      mS_Rx.u8_TimerCount = 0;
+    }
+  }
+
+
+
+  /*
+   * Appends a requested range to the retransmissions; if the queue is full, the range is merged with the last one
+   */
+  void Cfdp::_queueRetransmit(const uint32_t u32_Start, const uint32_t u32_End)
+  {
+    Range *pS_Range;
+
+    if(mS_Tx.u16_RetransmitCount>=CFDP_MAX_GAPS)
+    {
+      pS_Range = &mS_Tx.aS_Retransmit[(mS_Tx.u16_RetransmitHead+mS_Tx.u16_RetransmitCount-1)%CFDP_MAX_GAPS];
+      if(u32_Start<pS_Range->u32_Start)
+        pS_Range->u32_Start = u32_Start;
+      if(u32_End>pS_Range->u32_End)
+        pS_Range->u32_End = u32_End;
+      return;
+    }
+
+    pS_Range = &mS_Tx.aS_Retransmit[(mS_Tx.u16_RetransmitHead+mS_Tx.u16_RetransmitCount)%CFDP_MAX_GAPS];
+    pS_Range->u32_Start = u32_Start;
+    pS_Range->u32_End = u32_End;
+    mS_Tx.u16_RetransmitCount++;
+  }
+
+
+
+  /*
+   * Appends a missing range behind all others; if the list is full, it is merged with the last one
+   */
+  void Cfdp::_addGap(const uint32_t u32_Start, const uint32_t u32_End)
+  {
+    if(mS_Rx.u16_GapCount>=CFDP_MAX_GAPS)
+    {
+      mS_Rx.aS_Gap[mS_Rx.u16_GapCount-1].u32_End = u32_End;
+      return;
+    }
+    mS_Rx.aS_Gap[mS_Rx.u16_GapCount].u32_Start = u32_Start;
+    mS_Rx.aS_Gap[mS_Rx.u16_GapCount].u32_End = u32_End;
+    mS_Rx.u16_GapCount++;
+  }
+
+
+
+  /*
+   * Removes a received range from the missing ranges
+   */
+  void Cfdp::_removeGaps(const uint32_t u32_Start, const uint32_t u32_End)
+  {
+    Range *pS_Gap;
+    uint16_t i = 0;
+
+    while(i<mS_Rx.u16_GapCount)
+    {
+      pS_Gap = &mS_Rx.aS_Gap[i];
+      if(pS_Gap->u32_Start>=u32_End)
+        break;
+      if(pS_Gap->u32_End<=u32_Start)
+      {
+        i++;
+        continue;
+      }
+
+      if(u32_Start<=pS_Gap->u32_Start && u32_End>=pS_Gap->u32_End)
+      {
+        memmove(pS_Gap, &pS_Gap[1], (mS_Rx.u16_GapCount-i-1)*sizeof(Range));
+        mS_Rx.u16_GapCount--;
+        continue;
+      }
+
+      if(u32_Start<=pS_Gap->u32_Start)
+      {
+        pS_Gap->u32_Start = u32_End;
+      }
+      else if(u32_End>=pS_Gap->u32_End)
+      {
+        pS_Gap->u32_End = u32_Start;
+      }
+      else if(mS_Rx.u16_GapCount<CFDP_MAX_GAPS)
+      {
+        // split the gap
+        memmove(&pS_Gap[2], &pS_Gap[1], (mS_Rx.u16_GapCount-i-1)*sizeof(Range));
+        pS_Gap[1].u32_Start = u32_End;
+        pS_Gap[1].u32_End = pS_Gap->u32_End;
+        pS_Gap->u32_End = u32_Start;
+        mS_Rx.u16_GapCount++;
+        i++;
+      }
+      else if(i>0)
+      {
+        // the list is full: the lower part is merged with the previous gap (received data in between is requested again)
+        pS_Gap[-1].u32_End = u32_Start;
+        pS_Gap->u32_Start = u32_End;
+      }
+      else if(i+1<mS_Rx.u16_GapCount)
+      {
+        // the list is full: the upper part is merged with the next gap
+        pS_Gap[1].u32_Start = u32_End;
+        pS_Gap->u32_End = u32_Start;
+      }
+      i++;
+    }
+  }
+
+
+
+  /*
+   * Finishes the receiving transaction if the end of the file is known and all data is received
+   */
+  void Cfdp::_checkComplete(void)
+  {
+    if(!mS_Rx.b_Eof || mS_Rx.b_Complete)
+      return;
+
+    if(mS_Rx.b_Metadata && mS_Rx.u16_GapCount==0)
+    {
+      if(calcChecksum(0, mS_Rx.pu8_File, mS_Rx.u32_FileSize, 0)==mS_Rx.u32_EofChecksum)
+        _finishReceiver(NoError);
+      else
+        _finishReceiver(FileChecksumFailure);
+    }
+    else if(!mS_Rx.b_Acknowledged)
+    {
+      // unacknowledged mode: missing data is not requested
+      _finishReceiver(FileSizeError);
+    }
+  }
+
+
+
+  void Cfdp::_finishSender(const uint8_t u8_Condition)
+  {
+    mS_Tx.b_Active = false;
+    mS_Tx.b_TimerRunning = false;
+    if(mp_ActionInterface)
+      mp_ActionInterface->onCfdpTransactionFinished(true, mu16_EntityID, mS_Tx.u32_SeqNr, u8_Condition, mS_Tx.u32_FileSize);
+  }
+
+
+
+  /*
+   * Finishes the receiving transaction; in the acknowledged mode, the Finished PDU is sent until it is acknowledged
+   */
+  void Cfdp::_finishReceiver(const uint8_t u8_Condition)
+  {
+    mS_Rx.b_Complete = true;
+    mS_Rx.u8_Condition = u8_Condition;
+    mS_Rx.b_SendNak = false;
+    mS_Rx.b_TimerRunning = false;
+    mS_Rx.u8_TimerCount = 0;
+    if(mS_Rx.b_Acknowledged)
+      mS_Rx.b_SendFinished = true;
+    else
+      mS_Rx.b_Active = false;
+
+    if(mp_ActionInterface)
+      mp_ActionInterface->onCfdpTransactionFinished(false, mS_Rx.u16_SourceEntityID, mS_Rx.u32_SeqNr, u8_Condition, mS_Rx.u32_FileSize);
+  }
+
+}
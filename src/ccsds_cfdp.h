@@ -0,0 +1,323 @@
+/**
+ * @file      ccsds_cfdp.h
+ *
+ * @brief     Include file of the CCSDS File Delivery Protocol (CFDP) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_CFDP_H_
+#define _CCSDS_CFDP_H_
+
+/****************************************************************/
+/* CFDP according to                                            */
+/*                                                              */
+/*  - CCSDS 727.0-B-5, - CCSDS File Delivery Protocol (CFDP)    */
+/*    https://public.ccsds.org/Pubs/727x0b5.pdf                 */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - One sending and one receiving transaction per object      */
+/*  - Only the modular checksum, no large files, no segment     */
+/*    metadata, no filestore requests and no TLV options        */
+/*    other than the fault location                             */
+/*  - Deferred NAK mode only; keep alive PDUs and the           */
+/*    inactivity timer are not supported                        */
+/*  - Entity IDs are 16 bit, transaction sequence numbers are   */
+/*    32 bit                                                    */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "ccsds_spacepacket.h"
+
+#ifdef configCFDP_MAX_GAPS
+#define CFDP_MAX_GAPS configCFDP_MAX_GAPS
+#else
+#define CFDP_MAX_GAPS 64
+#endif
+
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Interface class for handling CFDP actions
+   */
+  class CfdpActionInterface
+  {
+  public:
+    /**
+     * @brief Declaration of the action which shall be called if the metadata of a new file was received
+     *
+     * The implementation provides the memory where the received file data is written to, for example a
+     * memory-mapped file. The file names are not terminated by a null character.
+     *
+     * @param u16_SourceEntityID      The entity ID of the sender
+     * @param u32_TransactionSeqNr    The transaction sequence number
+     * @param pu8_SourceFileName      The source file name
+     * @param u8_SourceFileNameLength The length of the source file name
+     * @param pu8_DestFileName        The destination file name
+     * @param u8_DestFileNameLength   The length of the destination file name
+     * @param u32_FileSize            The size of the file in bytes
+     *
+     * @retval nullptr  The file is rejected (filestore rejection)
+     * @return A pointer to the memory for the file data (at least u32_FileSize bytes)
+     */
+    virtual uint8_t *onCfdpMetadataReceived(const uint16_t u16_SourceEntityID, const uint32_t u32_TransactionSeqNr,
+                                            const uint8_t *pu8_SourceFileName, const uint8_t u8_SourceFileNameLength,
+                                            const uint8_t *pu8_DestFileName, const uint8_t u8_DestFileNameLength,
+                                            const uint32_t u32_FileSize) = 0;
+
+    /**
+     * @brief Declaration of the action which shall be called if a transaction is finished
+     *
+     * @param b_Sender              true if the transaction was sent by this entity, false if it was received
+     * @param u16_SourceEntityID    The entity ID of the sender
+     * @param u32_TransactionSeqNr  The transaction sequence number
+     * @param u8_ConditionCode      The condition code (Cfdp::NoError if the file was delivered completely)
+     * @param u32_FileSize          The size of the file in bytes
+     */
+    virtual void onCfdpTransactionFinished(const bool b_Sender, const uint16_t u16_SourceEntityID,
+                                           const uint32_t u32_TransactionSeqNr, const uint8_t u8_ConditionCode,
+                                           const uint32_t u32_FileSize) = 0;
+
+    /**
+     * @brief Declaration of the action which shall be called if a fault occurs after the transaction was finished
+     *
+     * This is the case if the receiver of a file does not get the ACK of its Finished PDU, so the sender
+     * may not know that the transaction is finished.
+     *
+     * @param b_Sender              true if the transaction was sent by this entity, false if it was received
+     * @param u16_SourceEntityID    The entity ID of the sender
+     * @param u32_TransactionSeqNr  The transaction sequence number
+     * @param u8_ConditionCode      The condition code of the fault (e.g. Cfdp::PositiveAckLimitReached)
+     */
+    virtual void onCfdpFault(const bool b_Sender, const uint16_t u16_SourceEntityID,
+                             const uint32_t u32_TransactionSeqNr, const uint8_t u8_ConditionCode) = 0;
+  };
+
+
+
+  /**
+   * @brief Class for transferring files with the CCSDS File Delivery Protocol as described in CCSDS 727.0-B-5.
+   *
+   * The protocol data units (PDUs) are transported in space packets of one APID. Received space packets are
+   * handed over by a SpacePacket object, as the class implements the SpacePacketActionInterface. PDUs to be
+   * sent are created by generate() into a caller buffer, one space packet per PDU, which can then be given to
+   * the transfer frame layer. With setPacketSize() the size of the space packets is matched to the data field
+   * of the transfer frames, so each file data PDU fills one frame.
+   *
+   * put() starts the transfer of a file which is given as a memory region (e.g. a memory-mapped file); the file
+   * data is read directly from there without an intermediate copy. In the unacknowledged mode (class 1) the
+   * sender transmits the metadata, the file data and the EOF PDU once. In the acknowledged mode (class 2) the
+   * sender does not wait for acknowledgements: all segments are sent back to back, limited only by the buffer
+   * given to generate(), and the receiver requests the missing ones with NAK PDUs after the EOF PDU
+   * (deferred NAK mode). The sender retransmits the requested segments before any new data, until the
+   * receiver confirms the transaction with the Finished PDU.
+   *
+   * The receiver writes the file data directly into the memory returned by the metadata callback and keeps a
+   * list of the missing ranges (up to CFDP_MAX_GAPS; if the list is full, adjacent gaps are merged, which only
+   * causes some unnecessary retransmissions).
+   *
+   * The time is given to generate() in ticks (for example seconds); the ACK and NAK timers use the same unit.
+   */
+  class Cfdp : public SpacePacketActionInterface
+  {
+  public:
+    static const int MaxGaps = CFDP_MAX_GAPS;    /**< Maximum number of missing ranges of a received file */
+
+    enum ConditionCode
+    {
+      NoError = 0,
+      PositiveAckLimitReached = 1,
+      KeepAliveLimitReached = 2,
+      InvalidTransmissionMode = 3,
+      FilestoreRejection = 4,
+      FileChecksumFailure = 5,
+      FileSizeError = 6,
+      NakLimitReached = 7,
+      InactivityDetected = 8,
+      InvalidFileStructure = 9,
+      CheckLimitReached = 10,
+      UnsupportedChecksumType = 11,
+      SuspendRequestReceived = 14,
+      CancelRequestReceived = 15
+    };
+
+  private:
+    const static uint8_t CfdpVersion = 1;
+    const static uint8_t EntityIdSize = 2;
+    const static uint8_t SeqNrSize = 4;
+    const static uint8_t PduHdrSize = 4+2*EntityIdSize+SeqNrSize;
+    const static uint8_t OffsetSize = 4;
+    const static uint8_t CrcSize = 2;
+    const static uint8_t NakHdrSize = 9;          // directive code and scope
+    const static uint8_t SegmentRequestSize = 8;
+    const static uint8_t ModularChecksum = 0;
+    const static uint8_t FaultLocationSize = 2+EntityIdSize;  // entity ID TLV
+    const static uint8_t EntityIdTlv = 0x06;
+    const static uint16_t MinPacketSize = SP_HEADER_SIZE+PduHdrSize+CrcSize+NakHdrSize+2*SegmentRequestSize;
+
+    enum DirectiveCode
+    {
+      EofPdu = 0x04,
+      FinishedPdu = 0x05,
+      AckPdu = 0x06,
+      MetadataPdu = 0x07,
+      NakPdu = 0x08,
+      PromptPdu = 0x09,
+      KeepAlivePdu = 0x0c
+    };
+
+    struct Range
+    {
+      uint32_t u32_Start;
+      uint32_t u32_End;
+    };
+
+    struct Sender
+    {
+      bool b_Valid;               // the fields belong to the last transaction
+      bool b_Active;
+      bool b_Acknowledged;
+      uint16_t u16_DestEntityID;
+      uint32_t u32_SeqNr;
+      const uint8_t *pu8_File;
+      uint32_t u32_FileSize;
+      const char *pc_SourceFileName;
+      const char *pc_DestFileName;
+      uint32_t u32_Offset;        // next file data which was not sent yet
+      uint32_t u32_Checksum;      // of the file data up to u32_Offset
+      uint8_t u8_Condition;
+      bool b_SendMetadata;
+      bool b_SendEof;
+      bool b_EofSent;
+      bool b_EofAcked;
+      bool b_SendFinishedAck;
+      uint8_t u8_FinishedCondition;
+      bool b_TimerRunning;
+      uint32_t u32_Timer;
+      uint8_t u8_TimerCount;
+      Range aS_Retransmit[CFDP_MAX_GAPS];   // ring buffer of requested ranges
+      uint16_t u16_RetransmitHead;
+      uint16_t u16_RetransmitCount;
+    };
+
+    struct Receiver
+    {
+      bool b_Valid;
+      bool b_Active;
+      bool b_Acknowledged;
+      bool b_Complete;
+      uint16_t u16_SourceEntityID;
+      uint32_t u32_SeqNr;
+      uint8_t *pu8_File;
+      bool b_Metadata;
+      uint32_t u32_FileSize;
+      bool b_Eof;
+      uint8_t u8_EofCondition;
+      uint32_t u32_EofChecksum;
+      uint32_t u32_Progress;      // end of the highest received file data
+      uint8_t u8_Condition;
+      bool b_SendEofAck;
+      bool b_SendNak;
+      uint16_t u16_NakNext;       // next entry of the NAK list to be sent
+      bool b_SendFinished;
+      bool b_TimerRunning;
+      uint32_t u32_Timer;
+      uint8_t u8_TimerCount;
+      Range aS_Gap[CFDP_MAX_GAPS];          // missing ranges, sorted
+      uint16_t u16_GapCount;
+    };
+
+    uint16_t mu16_EntityID;
+    uint16_t mu16_APID;
+    enum SpacePacket::PacketType me_PacketType;
+    uint16_t mu16_SequenceCount;
+    uint16_t mu16_PacketSize;
+    bool mb_PduCrc;
+    uint32_t mu32_NextSeqNr;
+    uint32_t mu32_Time;
+    uint32_t mu32_AckTimeout;
+    uint32_t mu32_NakTimeout;
+    uint8_t mu8_TimerLimit;
+
+    Sender mS_Tx;
+    Receiver mS_Rx;
+
+    uint16_t mu16_ProtocolErrorCount;
+    uint16_t mu16_ChecksumErrorCount;
+
+    CfdpActionInterface *mp_ActionInterface;
+
+  public:
+    Cfdp(const uint16_t u16_EntityID, const uint16_t u16_APID,
+         const SpacePacket::PacketType e_PacketType = SpacePacket::TM,
+         CfdpActionInterface *p_ActionInterface = nullptr);
+
+    void setActionInterface(CfdpActionInterface *p_ActionInterface);
+    int32_t setPacketSize(const uint16_t u16_PacketSize);
+    void setPduCrc(const bool b_Enabled);
+    void setTimers(const uint32_t u32_AckTimeout, const uint32_t u32_NakTimeout, const uint8_t u8_TimerLimit);
+
+    int32_t put(const uint16_t u16_DestEntityID, const uint8_t *pu8_File, const uint32_t u32_FileSize,
+                const char *pc_SourceFileName, const char *pc_DestFileName, const bool b_Acknowledged = true);
+    int32_t cancel(void);
+
+    uint32_t generate(const uint32_t u32_CurrentTime, uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+
+    uint16_t getSegmentSize(void);
+    bool isSending(void);
+    bool isReceiving(void);
+
+    uint16_t getProtocolErrorCount(void);
+    uint16_t getChecksumErrorCount(void);
+    void clearErrorCounters(void);
+
+    static uint32_t calcChecksum(uint32_t u32_Checksum, const uint8_t *pu8_Data, const uint32_t u32_Size, const uint32_t u32_Offset);
+
+    void onSpacePacketReceived(const uint8_t u8_PacketType,
+                               const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                               const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                               const uint8_t *pu8_PacketData, const uint16_t u16_PacketDataLength);
+
+  private:
+    uint32_t _createPdu(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                        const bool b_FileData, const bool b_TowardSender, const bool b_Acknowledged,
+                        const uint16_t u16_SourceEntityID, const uint32_t u32_SeqNr, const uint16_t u16_DestEntityID,
+                        const uint8_t *pu8_Field, const uint16_t u16_FieldSize,
+                        const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+    uint32_t _createFileData(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint32_t u32_Offset, const uint32_t u32_Size);
+    uint32_t _createMetadata(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+    uint32_t _createEof(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+    uint32_t _createAck(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const bool b_TowardSender);
+    uint32_t _createNak(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+    uint32_t _createFinished(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+    void _writeFaultLocation(uint8_t *pu8_Buffer, const uint16_t u16_EntityID);
+
+    void _checkTimers(void);
+    bool _expired(const uint32_t u32_Timer);
+
+    void _processSenderPdu(const uint32_t u32_SeqNr, const uint8_t *pu8_Pdu, const uint16_t u16_PduSize);
+    void _processReceiverPdu(const bool b_FileData, const bool b_Acknowledged,
+                             const uint16_t u16_SourceEntityID, const uint32_t u32_SeqNr,
+                             const uint8_t *pu8_Pdu, const uint16_t u16_PduSize);
+    void _receiveMetadata(const uint8_t *pu8_Pdu, const uint16_t u16_PduSize);
+    void _receiveFileData(const uint8_t *pu8_Pdu, const uint16_t u16_PduSize);
+    void _receiveEof(const uint8_t *pu8_Pdu, const uint16_t u16_PduSize);
+
+    void _queueRetransmit(const uint32_t u32_Start, const uint32_t u32_End);
+    void _addGap(const uint32_t u32_Start, const uint32_t u32_End);
+    void _removeGaps(const uint32_t u32_Start, const uint32_t u32_End);
+    void _checkComplete(void);
+    void _finishSender(const uint8_t u8_Condition);
+    void _finishReceiver(const uint8_t u8_Condition);
+  };
+
+}
+
+#endif // _CCSDS_CFDP_H_
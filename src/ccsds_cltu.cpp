@@ -15,6 +15,47 @@
 
 namespace CCSDS
 {
+#if CLTU_USE_BCH_TABLE
+  /*
+   * Parity register after shifting in one byte, polynom G(X) = X^7 + X^6 + X^2 + 1.
+   * The 7 bit register is kept in the upper bits of a byte, so that a code block is processed
+   * with one lookup per byte: u8_Reg = au8_BchParityTable[u8_Reg ^ u8_Byte]
+   */
+  static const uint8_t au8_BchParityTable[256] = {
+      0x00, 0x8a, 0x9e, 0x14, 0xb6, 0x3c, 0x28, 0xa2, 0xe6, 0x6c, 0x78, 0xf2, 0x50, 0xda, 0xce, 0x44,
+      0x46, 0xcc, 0xd8, 0x52, 0xf0, 0x7a, 0x6e, 0xe4, 0xa0, 0x2a, 0x3e, 0xb4, 0x16, 0x9c, 0x88, 0x02,
+      0x8c, 0x06, 0x12, 0x98, 0x3a, 0xb0, 0xa4, 0x2e, 0x6a, 0xe0, 0xf4, 0x7e, 0xdc, 0x56, 0x42, 0xc8,
+      0xca, 0x40, 0x54, 0xde, 0x7c, 0xf6, 0xe2, 0x68, 0x2c, 0xa6, 0xb2, 0x38, 0x9a, 0x10, 0x04, 0x8e,
+      0x92, 0x18, 0x0c, 0x86, 0x24, 0xae, 0xba, 0x30, 0x74, 0xfe, 0xea, 0x60, 0xc2, 0x48, 0x5c, 0xd6,
+      0xd4, 0x5e, 0x4a, 0xc0, 0x62, 0xe8, 0xfc, 0x76, 0x32, 0xb8, 0xac, 0x26, 0x84, 0x0e, 0x1a, 0x90,
+      0x1e, 0x94, 0x80, 0x0a, 0xa8, 0x22, 0x36, 0xbc, 0xf8, 0x72, 0x66, 0xec, 0x4e, 0xc4, 0xd0, 0x5a,
+      0x58, 0xd2, 0xc6, 0x4c, 0xee, 0x64, 0x70, 0xfa, 0xbe, 0x34, 0x20, 0xaa, 0x08, 0x82, 0x96, 0x1c,
+      0xae, 0x24, 0x30, 0xba, 0x18, 0x92, 0x86, 0x0c, 0x48, 0xc2, 0xd6, 0x5c, 0xfe, 0x74, 0x60, 0xea,
+      0xe8, 0x62, 0x76, 0xfc, 0x5e, 0xd4, 0xc0, 0x4a, 0x0e, 0x84, 0x90, 0x1a, 0xb8, 0x32, 0x26, 0xac,
+      0x22, 0xa8, 0xbc, 0x36, 0x94, 0x1e, 0x0a, 0x80, 0xc4, 0x4e, 0x5a, 0xd0, 0x72, 0xf8, 0xec, 0x66,
+      0x64, 0xee, 0xfa, 0x70, 0xd2, 0x58, 0x4c, 0xc6, 0x82, 0x08, 0x1c, 0x96, 0x34, 0xbe, 0xaa, 0x20,
+      0x3c, 0xb6, 0xa2, 0x28, 0x8a, 0x00, 0x14, 0x9e, 0xda, 0x50, 0x44, 0xce, 0x6c, 0xe6, 0xf2, 0x78,
+      0x7a, 0xf0, 0xe4, 0x6e, 0xcc, 0x46, 0x52, 0xd8, 0x9c, 0x16, 0x02, 0x88, 0x2a, 0xa0, 0xb4, 0x3e,
+      0xb0, 0x3a, 0x2e, 0xa4, 0x06, 0x8c, 0x98, 0x12, 0x56, 0xdc, 0xc8, 0x42, 0xe0, 0x6a, 0x7e, 0xf4,
+      0xf6, 0x7c, 0x68, 0xe2, 0x40, 0xca, 0xde, 0x54, 0x10, 0x9a, 0x8e, 0x04, 0xa6, 0x2c, 0x38, 0xb2
+  };
+
+  /*
+   * Bit position (0..55 data bits, 56..62 parity bits, in transmission order) of a single bit error
+   * for each of the 128 syndromes; 0xff marks syndromes which are not caused by a single bit error.
+   */
+  static const uint8_t au8_BchErrorPosTable[128] = {
+      0xff, 0x3e, 0x3d, 0xff, 0x3c, 0xff, 0xff, 0x24, 0x3b, 0xff, 0xff, 0x1b, 0xff, 0x0e, 0x23, 0xff,
+      0x3a, 0xff, 0xff, 0x2e, 0xff, 0x0a, 0x1a, 0xff, 0xff, 0x11, 0x0d, 0xff, 0x22, 0xff, 0xff, 0x06,
+      0x39, 0xff, 0xff, 0x33, 0xff, 0x1f, 0x2d, 0xff, 0xff, 0x27, 0x09, 0xff, 0x19, 0xff, 0xff, 0x16,
+      0xff, 0x01, 0x10, 0xff, 0x0c, 0xff, 0xff, 0x13, 0x21, 0xff, 0xff, 0x29, 0xff, 0x03, 0x05, 0xff,
+      0x38, 0xff, 0xff, 0xff, 0xff, 0x37, 0x32, 0xff, 0xff, 0x31, 0x1e, 0xff, 0x2c, 0xff, 0xff, 0x36,
+      0xff, 0x1d, 0x26, 0xff, 0x08, 0xff, 0xff, 0x30, 0x18, 0xff, 0xff, 0x35, 0xff, 0x2b, 0x15, 0xff,
+      0xff, 0x25, 0x00, 0xff, 0x0f, 0xff, 0xff, 0x1c, 0x0b, 0xff, 0xff, 0x2f, 0xff, 0x07, 0x12, 0xff,
+      0x20, 0xff, 0xff, 0x34, 0xff, 0x17, 0x28, 0xff, 0xff, 0x14, 0x02, 0xff, 0x04, 0xff, 0xff, 0x2a
+  };
+#endif
+
   /**
    * @brief Construct a new Cltu object
    *
@@ -22,7 +63,11 @@ namespace CCSDS
    */
   Cltu::Cltu(CltuActionInterface *p_ActionInterface)
     : mb_Sync{false}
+    , mb_ErrorCorrection{false}
+    , mb_Randomization{false}
+    , mu16_RandomizerOffset{0}
     , mu8_Index{0}
+    , mu16_CorrectedErrorCount{0}
     , mp_ActionInterface{p_ActionInterface}
   {
   }
@@ -39,6 +84,38 @@ namespace CCSDS
   }
   
   
+  /**
+   * @brief Selects the decoding mode of the code blocks (CCSDS 231.0-B-3, 3.3.2)
+   *
+   * In error-detecting mode (default), any parity error ends the CLTU. In error-correcting mode, code blocks
+   * with a single bit error are corrected and delivered; the tail sequence still ends the CLTU.
+   *
+   * @param b_Enabled  true to enable the error-correcting mode
+   */
+  void Cltu::setErrorCorrection(const bool b_Enabled)
+  {
+    mb_ErrorCorrection = b_Enabled;
+  }
+  
+  
+  /**
+   * @brief Enables the derandomization of the received code blocks with the TC sequence
+   *
+   * @param b_Enabled  true if the received data is randomized
+   *
+   * @retval  0   The randomization was set
+   * @retval -1   The randomizer is disabled by the configuration (configTF_USE_RANDOMIZER)
+   */
+  int32_t Cltu::setRandomization(const bool b_Enabled)
+  {
+    if(b_Enabled && !TF_USE_RANDOMIZER)
+      return -1;
+    mb_Randomization = b_Enabled;
+    
+    return 0;
+  }
+  
+  
   /**
    * @brief Creates a sequence of CLTUs, embeds the data to be sent and writes it into the given buffer.
    *
@@ -46,45 +123,93 @@ namespace CCSDS
    * @param u32_BufferSize  The available size of the buffer
    * @param pu8_Data        A pointer to the data block which shall be wrapped
    * @param u16_DataSize    The size of the data block
+   * @param b_Randomize     true if the data shall be randomized with the TC sequence
    *
    * @return     The size of the CLTU sequence if sucessfull
    * @retval  0  If the buffer size is not sufficient or an other error occured
    */
   uint32_t Cltu::create(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
-                        const uint8_t *pu8_Data, const uint16_t u16_DataSize)
+                        const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                        const bool b_Randomize)
   {
-    uint16_t u16_RequiredBufferSize = StartSequenceSize
-    +((u16_DataSize+(DataBlockSize-1))/DataBlockSize)*(DataBlockSize+CRCSize)
-    +TailSquenceSize;
-    uint16_t u16_BlockNr;
-    uint16_t u16_RemainingDataSize = 0;
-    uint16_t u16_WritePos = 0;
-    
-    if(!pu8_Buffer || (u32_BufferSize<u16_RequiredBufferSize))
+    if(!pu8_Buffer || (u32_BufferSize<getSize(u16_DataSize)))
       return 0;
     if(u16_DataSize>0 && !pu8_Data)
       return 0;
+    if(b_Randomize && !TF_USE_RANDOMIZER)
+      return 0;
     
-    pu8_Buffer[u16_WritePos++]=0xEB;
-    pu8_Buffer[u16_WritePos++]=0x90;
-    for(u16_BlockNr=0; ((u16_BlockNr+1)*DataBlockSize-1)<u16_DataSize; u16_BlockNr++)
-    {
-      memcpy(&pu8_Buffer[u16_WritePos], &pu8_Data[u16_BlockNr*DataBlockSize], DataBlockSize);
-      pu8_Buffer[u16_WritePos+DataBlockSize]=calcCRC(&pu8_Buffer[u16_WritePos], DataBlockSize);
-      u16_WritePos+=(DataBlockSize+CRCSize);
-    }
-    u16_RemainingDataSize=u16_DataSize-(u16_BlockNr*DataBlockSize);
-    if(u16_RemainingDataSize)
+    return _encode(pu8_Buffer, pu8_Data, u16_DataSize, b_Randomize);
+  }
+  
+  
+  /**
+   * @brief Creates a complete PLOP-2 transmission (CCSDS 231.0-B-3, 6.3) for several data blocks (usually TC
+   *        frames) and writes it into the given buffer.
+   *
+   * The transmission consists of the acquisition sequence, one CLTU per data block and the idle sequence.
+   * The acquisition and the idle sequence are alternating ones and zeros (0x55). The required size is checked
+   * once for the whole transmission; the code blocks are then written and encoded in a single pass.
+   *
+   * @param pu8_Buffer           A pointer to the buffer where the transmission shall be stored
+   * @param u32_BufferSize       The available size of the buffer
+   * @param ppu8_Data            An array of pointers to the data blocks which shall be wrapped
+   * @param pu16_DataSize        An array with the sizes of the data blocks
+   * @param u16_DataBlockCount   The number of data blocks
+   * @param u16_AcquisitionSize  The size of the acquisition sequence in bytes (at least 16 recommended)
+   * @param u16_IdleSize         The size of the idle sequence in bytes
+   * @param b_Randomize          true if the data blocks shall be randomized with the TC sequence
+   *
+   * @return     The size of the transmission if sucessfull
+   * @retval  0  If the buffer size is not sufficient or an other error occured
+   */
+  uint32_t Cltu::createTransmission(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                    const uint8_t * const *ppu8_Data, const uint16_t *pu16_DataSize,
+                                    const uint16_t u16_DataBlockCount,
+                                    const uint16_t u16_AcquisitionSize, const uint16_t u16_IdleSize,
+                                    const bool b_Randomize)
+  {
+    uint32_t u32_RequiredBufferSize = (uint32_t)u16_AcquisitionSize+u16_IdleSize;
+    uint32_t u32_WritePos = 0;
+    uint16_t u16_BlockNr;
+    
+    if(!pu8_Buffer || (u16_DataBlockCount>0 && (!ppu8_Data || !pu16_DataSize)))
+      return 0;
+    if(b_Randomize && !TF_USE_RANDOMIZER)
+      return 0;
+    for(u16_BlockNr=0; u16_BlockNr<u16_DataBlockCount; u16_BlockNr++)
     {
-      memcpy(&pu8_Buffer[u16_WritePos], &pu8_Data[u16_BlockNr*DataBlockSize], u16_RemainingDataSize);
-      memset(&pu8_Buffer[u16_WritePos+u16_RemainingDataSize], 0x55, DataBlockSize-u16_RemainingDataSize);
-      pu8_Buffer[u16_WritePos+DataBlockSize]=calcCRC(&pu8_Buffer[u16_WritePos], DataBlockSize);
-      u16_WritePos+=(DataBlockSize+CRCSize);
+      if(pu16_DataSize[u16_BlockNr]>0 && !ppu8_Data[u16_BlockNr])
+        return 0;
+      u32_RequiredBufferSize+=getSize(pu16_DataSize[u16_BlockNr]);
     }
-    memset(&pu8_Buffer[u16_WritePos], 0x55, DataBlockSize);
-    pu8_Buffer[u16_WritePos+DataBlockSize]=0x79;
+    if(u32_BufferSize<u32_RequiredBufferSize)
+      return 0;
+    
+    memset(pu8_Buffer, 0x55, u16_AcquisitionSize);
+    u32_WritePos+=u16_AcquisitionSize;
+    for(u16_BlockNr=0; u16_BlockNr<u16_DataBlockCount; u16_BlockNr++)
+      u32_WritePos+=_encode(&pu8_Buffer[u32_WritePos], ppu8_Data[u16_BlockNr], pu16_DataSize[u16_BlockNr],
+                             b_Randomize);
+    memset(&pu8_Buffer[u32_WritePos], 0x55, u16_IdleSize);
+    u32_WritePos+=u16_IdleSize;
     
-    return u16_WritePos+DataBlockSize+CRCSize;
+    return u32_WritePos;
+  }
+  
+  
+  /**
+   * @brief Returns the size of the CLTU for a data block
+   *
+   * @param u16_DataSize  The size of the data block
+   *
+   * @return The size of the CLTU including start and tail sequence
+   */
+  uint32_t Cltu::getSize(const uint16_t u16_DataSize)
+  {
+    return StartSequenceSize
+      +(((uint32_t)u16_DataSize+(DataBlockSize-1))/DataBlockSize)*(DataBlockSize+CRCSize)
+      +TailSquenceSize;
   }
   
   
@@ -131,6 +256,7 @@ namespace CCSDS
           //cout << "Sync found" << endl;
           mb_Sync=true;
           mu8_Index=0;
+          mu16_RandomizerOffset=0;
           if(mp_ActionInterface)
             mp_ActionInterface->onStartOfTransmission();
         }
@@ -144,14 +270,24 @@ namespace CCSDS
         }
         else
         {
-          if(calcCRC(mau8_Buffer, DataBlockSize) == pu8_Data[i])
+          switch(decodeCodeBlock(mau8_Buffer, pu8_Data[i], mb_ErrorCorrection))
           {
+          case 1:
+            if(mu16_CorrectedErrorCount<0xffff)
+              mu16_CorrectedErrorCount++;
+            // fall through
+          case 0:
+            if(mb_Randomization)
+            {
+              Randomizer::apply(Randomizer::TcSequence, mau8_Buffer, DataBlockSize, mu16_RandomizerOffset);
+              mu16_RandomizerOffset+=DataBlockSize;
+            }
             if(mp_ActionInterface)
               mp_ActionInterface->onCltuDataReceived(mau8_Buffer, DataBlockSize);
-          }
-          else
-          {
+            break;
+          default:
             mb_Sync=false;
+            break;
           }
           mu8_Index=0;
         }
@@ -164,8 +300,99 @@ namespace CCSDS
   
   
   
+  /**
+   * @brief Returns the number of code blocks which were corrected in error-correcting mode
+   *
+   * @return The number of corrected code blocks
+   */
+  uint16_t Cltu::getCorrectedErrorCount(void)
+  {
+    return mu16_CorrectedErrorCount;
+  }
+  
+  
+  /**
+   * @brief Clears the error counters
+   */
+  void Cltu::clearErrorCounters(void)
+  {
+    mu16_CorrectedErrorCount = 0;
+  }
+  
+  
+  
+  
+  uint32_t Cltu::_encode(uint8_t *pu8_Buffer, const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                         const bool b_Randomize)
+  {
+    uint32_t u32_WritePos = 0;
+    uint16_t u16_ReadPos = 0;
+    uint16_t u16_RemainingDataSize;
+    
+    pu8_Buffer[u32_WritePos++]=0xEB;
+    pu8_Buffer[u32_WritePos++]=0x90;
+    for(; (uint32_t)u16_ReadPos+DataBlockSize<=u16_DataSize; u16_ReadPos+=DataBlockSize)
+    {
+      memcpy(&pu8_Buffer[u32_WritePos], &pu8_Data[u16_ReadPos], DataBlockSize);
+      if(b_Randomize)
+        Randomizer::apply(Randomizer::TcSequence, &pu8_Buffer[u32_WritePos], DataBlockSize, u16_ReadPos);
+      pu8_Buffer[u32_WritePos+DataBlockSize]=calcCRC(&pu8_Buffer[u32_WritePos], DataBlockSize);
+      u32_WritePos+=(DataBlockSize+CRCSize);
+    }
+    u16_RemainingDataSize=u16_DataSize-u16_ReadPos;
+    if(u16_RemainingDataSize)
+    {
+      memcpy(&pu8_Buffer[u32_WritePos], &pu8_Data[u16_ReadPos], u16_RemainingDataSize);
+      if(b_Randomize)
+        Randomizer::apply(Randomizer::TcSequence, &pu8_Buffer[u32_WritePos], u16_RemainingDataSize, u16_ReadPos);
+      memset(&pu8_Buffer[u32_WritePos+u16_RemainingDataSize], 0x55, DataBlockSize-u16_RemainingDataSize);
+      pu8_Buffer[u32_WritePos+DataBlockSize]=calcCRC(&pu8_Buffer[u32_WritePos], DataBlockSize);
+      u32_WritePos+=(DataBlockSize+CRCSize);
+    }
+    memset(&pu8_Buffer[u32_WritePos], 0x55, DataBlockSize);
+    pu8_Buffer[u32_WritePos+DataBlockSize]=0x79;
+    
+    return u32_WritePos+DataBlockSize+CRCSize;
+  }
+  
+  
+  /**
+   * @brief Checks a code block and corrects it in place if the error-correcting mode is used
+   *
+   * @param pu8_Buffer         The 7 byte data part of the code block
+   * @param u8_Parity          The received parity byte
+   * @param b_ErrorCorrection  true if single bit errors shall be corrected
+   *
+   * @retval  0  The code block is valid
+   * @retval  1  The code block had a single bit error which was corrected
+   * @retval -1  The code block is the tail sequence
+   * @retval -2  The code block is invalid
+   */
+  int32_t Cltu::decodeCodeBlock(uint8_t *pu8_Buffer, const uint8_t u8_Parity, const bool b_ErrorCorrection)
+  {
+    if(calcCRC(pu8_Buffer, DataBlockSize) == u8_Parity)
+      return 0;
+    if(_isTailSequence(pu8_Buffer, u8_Parity))
+      return -1;
+    if(b_ErrorCorrection && _correctCodeBlock(pu8_Buffer, u8_Parity))
+      return 1;
+    
+    return -2;
+  }
+  
+  
+  
+  
   uint8_t Cltu::calcCRC(const uint8_t *pu8_Buffer, const uint8_t u8_BufferSize)
   {
+#if CLTU_USE_BCH_TABLE
+    uint8_t u8_Reg=0x00;
+    
+    for(uint8_t u8_BytePos = 0; u8_BytePos<u8_BufferSize; u8_BytePos++)
+      u8_Reg = au8_BchParityTable[u8_Reg ^ pu8_Buffer[u8_BytePos]];
+    
+    return (uint8_t)(~u8_Reg) & 0xfe;
+#else
     uint8_t u8_CRC=0x00;
     uint8_t u8_DataStreamXorBit6;
     
@@ -181,6 +408,70 @@ namespace CCSDS
     }
     
     return (~u8_CRC)<<1;
+#endif
+  }
+  
+  
+  /**
+   * @brief Corrects a single bit error of a code block in place
+   *
+   * The syndrome is the difference between the calculated and the received parity. A single bit error at
+   * position p (in transmission order, 0..62) results in the syndrome X^(62-p) mod G(X). All other non-zero
+   * syndromes are caused by multiple bit errors, which can only be detected.
+   *
+   * @param pu8_Buffer  The 7 byte data part of the code block
+   * @param u8_Parity   The received parity byte
+   *
+   * @return  true if the code block is valid (after the correction)
+   */
+  bool Cltu::_correctCodeBlock(uint8_t *pu8_Buffer, const uint8_t u8_Parity)
+  {
+    uint8_t u8_Syndrome = (uint8_t)(calcCRC(pu8_Buffer, DataBlockSize) ^ u8_Parity)>>1;
+    uint8_t u8_ErrorPos;
+    
+    if(u8_Syndrome==0)
+      return true;                              // only the filler bit is wrong
+    
+#if CLTU_USE_BCH_TABLE
+    u8_ErrorPos = au8_BchErrorPosTable[u8_Syndrome];
+#else
+    uint8_t u8_Reg = 0x01;
+    
+    for(u8_ErrorPos = 62; u8_Reg!=u8_Syndrome; u8_ErrorPos--)
+    {
+      if(u8_ErrorPos==0)
+        return false;
+      u8_Reg = (u8_Reg&0x40) ? (uint8_t)(((u8_Reg<<1)&0x7f) ^ 0x45) : (uint8_t)(u8_Reg<<1);
+    }
+#endif
+    if(u8_ErrorPos>62)
+      return false;
+    if(u8_ErrorPos<DataBlockSize*8)
+      pu8_Buffer[u8_ErrorPos>>3] ^= (uint8_t)(0x80>>(u8_ErrorPos&0x07));
+    
+    return true;
+  }
+  
+  
+  /**
+   * @brief Checks if a code block is the tail sequence
+   *
+   * @param pu8_Buffer  The 7 byte data part of the code block
+   * @param u8_Parity   The received parity byte
+   *
+   * @return  true if the code block is the tail sequence
+   */
+  bool Cltu::_isTailSequence(const uint8_t *pu8_Buffer, const uint8_t u8_Parity)
+  {
+    if(u8_Parity!=0x79)
+      return false;
+    for(uint8_t u8_BytePos = 0; u8_BytePos<DataBlockSize; u8_BytePos++)
+    {
+      if(pu8_Buffer[u8_BytePos]!=0x55)
+        return false;
+    }
+    
+    return true;
   }
   
 
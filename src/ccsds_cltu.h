@@ -13,6 +13,8 @@
 
 #include <inttypes.h>
 
+#include "configCCSDS.h"
+#include "ccsds_randomizer.h"
 
 #ifdef configCLTU_MAX_SIZE
 #define CLTU_MAX_SIZE configCLTU_MAX_SIZE
@@ -20,6 +22,12 @@
 #define CLTU_MAX_SIZE (2+((TC_TF_MAX_SIZE+6)/7)*8+8)
 #endif
 
+#ifdef configCLTU_USE_BCH_TABLE
+#define CLTU_USE_BCH_TABLE configCLTU_USE_BCH_TABLE
+#else
+#define CLTU_USE_BCH_TABLE 1
+#endif
+
 
 namespace CCSDS
 {
@@ -60,18 +68,29 @@ namespace CCSDS
    * On real satellites, CLTUs are usually processed by hardware, and the raw Transfer Frames are handed over to the
    * application which handles the communication between ground and the satellite. With this class, it is possible to
    * detect a start of transmission, to create and unpack CLTUs in software.
+   *
+   * By default, a code block with a parity error ends the CLTU (error-detecting mode). If the error-correcting mode
+   * is enabled with setErrorCorrection(), code blocks with a single bit error are corrected in place and delivered.
+   *
+   * Optionally, the data is randomized with the TC sequence (CCSDS 231.0-B-3) before it is encoded; process()
+   * removes the randomization if setRandomization() was called.
    */
   class Cltu
   {
-  private:
+  public:
     const static uint8_t StartSequenceSize = 2;
     const static uint8_t DataBlockSize = 7;
     const static uint8_t CRCSize = 1;
     const static uint8_t TailSquenceSize = 8;
     
+  private:
     bool mb_Sync;
+    bool mb_ErrorCorrection;
+    bool mb_Randomization;
+    uint16_t mu16_RandomizerOffset;
     uint8_t mau8_Buffer[DataBlockSize];
     uint8_t mu8_Index;
+    uint16_t mu16_CorrectedErrorCount;
     
     CltuActionInterface *mp_ActionInterface;
     
@@ -79,15 +98,33 @@ namespace CCSDS
     Cltu(CltuActionInterface *p_ActionInterface = nullptr);
     
     void setActionInterface(CltuActionInterface *p_ActionInterface);
+    void setErrorCorrection(const bool b_Enabled);
+    int32_t setRandomization(const bool b_Enabled);
     
   public:
-   static uint32_t create(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
-                           const uint8_t *pu8_Data, const uint16_t u16_DataSize);
+    static uint32_t create(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                           const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                           const bool b_Randomize = false);
+    static uint32_t createTransmission(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                       const uint8_t * const *ppu8_Data, const uint16_t *pu16_DataSize,
+                                       const uint16_t u16_DataBlockCount,
+                                       const uint16_t u16_AcquisitionSize, const uint16_t u16_IdleSize,
+                                       const bool b_Randomize = false);
+    static uint32_t getSize(const uint16_t u16_DataSize);
     
     void process(const uint8_t *pu8_Data, const uint16_t u16_DataSize);
     
+    uint16_t getCorrectedErrorCount(void);
+    void clearErrorCounters(void);
+    
+    static int32_t decodeCodeBlock(uint8_t *pu8_Buffer, const uint8_t u8_Parity, const bool b_ErrorCorrection);
+    
   private:
     static uint8_t calcCRC(const uint8_t *pu8_Buffer, const uint8_t u8_BufferSize);
+    static uint32_t _encode(uint8_t *pu8_Buffer, const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                            const bool b_Randomize);
+    static bool _correctCodeBlock(uint8_t *pu8_Buffer, const uint8_t u8_Parity);
+    static bool _isTailSequence(const uint8_t *pu8_Buffer, const uint8_t u8_Parity);
   };
     
 }
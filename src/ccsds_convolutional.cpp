@@ -0,0 +1,291 @@
+/**
+ * @file      ccsds_convolutional.cpp
+ *
+ * @brief     Source file of the convolutional encoder and Viterbi decoder classes
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "ccsds_convolutional.h"
+
+
+// taps of the generator polynomials, the newest bit is the least significant bit
+#define CONV_POLY_G1 0x4f     // 1111001
+#define CONV_POLY_G2 0x6d     // 1011011
+
+
+namespace CCSDS
+{
+  
+  static inline uint8_t _parity(uint8_t u8_Value)
+  {
+    u8_Value ^= u8_Value>>4;
+    u8_Value ^= u8_Value>>2;
+    u8_Value ^= u8_Value>>1;
+    return u8_Value&0x01;
+  }
+  
+  
+  /**
+   * @brief Construct a new ConvolutionalEncoder object
+   */
+  ConvolutionalEncoder::ConvolutionalEncoder(void)
+    : mu8_State{0}
+  {
+  }
+  
+  
+  /**
+   * @brief Resets the shift register of the encoder to zero
+   */
+  void ConvolutionalEncoder::reset(void)
+  {
+    mu8_State = 0;
+  }
+  
+  
+  /**
+   * @brief Encodes the given data and writes the channel symbols into the given buffer
+   *
+   * The symbols are packed into bytes, most significant bit first; the output is twice as large as the input.
+   *
+   * @param pu8_Buffer      A pointer to the buffer where the symbols shall be stored
+   * @param u32_BufferSize  The available size of the buffer
+   * @param pu8_Data        A pointer to the data which shall be encoded
+   * @param u32_DataSize    The size of the data in bytes
+   *
+   * @return     The number of bytes written into the buffer
+   * @retval  0  If the buffer size is not sufficient or an other error occured
+   */
+  uint32_t ConvolutionalEncoder::encode(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                        const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    uint16_t u16_Symbols;
+    
+    if(!pu8_Buffer || !pu8_Data || (u32_BufferSize/2<u32_DataSize))
+      return 0;
+    
+    for(uint32_t i=0; i<u32_DataSize; i++)
+    {
+      u16_Symbols = 0;
+      for(int8_t i8_Bit=7; i8_Bit>=0; i8_Bit--)
+      {
+        mu8_State = (uint8_t)(((mu8_State<<1) | ((pu8_Data[i]>>i8_Bit)&0x01)) & 0x7f);
+        u16_Symbols = (uint16_t)((u16_Symbols<<2) | (_parity(mu8_State&CONV_POLY_G1)<<1)
+                                 | (_parity(mu8_State&CONV_POLY_G2)^0x01));
+      }
+      pu8_Buffer[2*i]   = (uint8_t)(u16_Symbols>>8);
+      pu8_Buffer[2*i+1] = (uint8_t)(u16_Symbols&0xff);
+    }
+    
+    return 2*u32_DataSize;
+  }
+  
+  
+  
+#if TF_VITERBI_TRACEBACK_DEPTH > 0
+  /*
+   * Expected symbol pair (G1<<1 | inverted G2) for the transition into state s with the
+   * oldest register bit being zero; if it is one, both symbols are inverted.
+   */
+  static const uint8_t au8_BranchSymbols[64] = {
+    1, 2, 3, 0, 2, 1, 0, 3, 2, 1, 0, 3, 1, 2, 3, 0,
+    1, 2, 3, 0, 2, 1, 0, 3, 2, 1, 0, 3, 1, 2, 3, 0,
+    0, 3, 2, 1, 3, 0, 1, 2, 3, 0, 1, 2, 0, 3, 2, 1,
+    0, 3, 2, 1, 3, 0, 1, 2, 3, 0, 1, 2, 0, 3, 2, 1
+  };
+  
+  
+  /**
+   * @brief Construct a new ViterbiDecoder object
+   *
+   * @param p_Transferframe  A pointer to the transfer frame object which receives the decoded data
+   */
+  ViterbiDecoder::ViterbiDecoder(Transferframe *p_Transferframe)
+    : mp_Transferframe{p_Transferframe}
+  {
+    reset();
+  }
+  
+  
+  /**
+   * @brief Sets the transfer frame object which receives the decoded data
+   *
+   * @param p_Transferframe  A pointer to the transfer frame object
+   */
+  void ViterbiDecoder::setTransferframe(Transferframe *p_Transferframe)
+  {
+    mp_Transferframe = p_Transferframe;
+  }
+  
+  
+  /**
+   * @brief Resets the decoder; all data which was not yet released is dropped
+   */
+  void ViterbiDecoder::reset(void)
+  {
+    memset(mai32_Metric, 0, sizeof(mai32_Metric));
+    mu16_HistoryPos = 0;
+    mu32_PendingSteps = 0;
+    mb_SymbolPending = false;
+    mi8_PendingSymbol = 0;
+    mu8_OutputSize = 0;
+  }
+  
+  
+  /**
+   * @brief Decodes the given soft symbols
+   *
+   * The method can handle continuously incoming data; an odd number of symbols is allowed. The decoded bytes
+   * are handed over to the transfer frame object with a delay of about TF_VITERBI_TRACEBACK_DEPTH bits, at the
+   * latest when the method returns.
+   *
+   * @param pi8_Symbols      A pointer to the soft symbols (log-likelihood ratios, positive for a 0 bit)
+   * @param u32_SymbolCount  The number of symbols
+   */
+  void ViterbiDecoder::process(const int8_t *pi8_Symbols, const uint32_t u32_SymbolCount)
+  {
+    uint32_t i=0;
+    
+    if(!pi8_Symbols)
+      return;
+    
+    if(mb_SymbolPending && u32_SymbolCount>0)
+    {
+      _step(mi8_PendingSymbol, pi8_Symbols[i++]);
+      mb_SymbolPending = false;
+    }
+    for(; i+1<u32_SymbolCount; i+=2)
+      _step(pi8_Symbols[i], pi8_Symbols[i+1]);
+    if(i<u32_SymbolCount)
+    {
+      mi8_PendingSymbol = pi8_Symbols[i];
+      mb_SymbolPending = true;
+    }
+    
+    _deliver();
+  }
+  
+  
+  /**
+   * @brief Releases all complete bytes which are still held in the survivor memory (e.g. at the end of a pass)
+   */
+  void ViterbiDecoder::flush(void)
+  {
+    uint32_t u32_BitCount = mu32_PendingSteps&~0x7UL;
+    
+    if(u32_BitCount>0)
+      _traceback(mu32_PendingSteps, (uint16_t)(u32_BitCount/8));
+    mu32_PendingSteps = 0;
+    _deliver();
+  }
+  
+  
+  
+  // add-compare-select for one symbol pair
+  void ViterbiDecoder::_step(const int8_t i8_Symbol1, const int8_t i8_Symbol2)
+  {
+    int32_t ai32_Branch[4];
+    int32_t ai32_Metric[StateCount];
+    uint8_t *pu8_Decision = maau8_Decision[mu16_HistoryPos];
+    int32_t i32_Metric0;
+    int32_t i32_Metric1;
+    uint8_t u8_Symbols;
+    
+    // correlation of the received symbols with the expected symbol pair (G1<<1 | G2)
+    ai32_Branch[0] = (int32_t)i8_Symbol1+i8_Symbol2;
+    ai32_Branch[1] = (int32_t)i8_Symbol1-i8_Symbol2;
+    ai32_Branch[2] = -ai32_Branch[1];
+    ai32_Branch[3] = -ai32_Branch[0];
+    
+    memset(pu8_Decision, 0, StateCount/8);
+    for(uint8_t u8_State=0; u8_State<StateCount; u8_State++)
+    {
+      u8_Symbols = au8_BranchSymbols[u8_State];
+      i32_Metric0 = mai32_Metric[u8_State>>1]+ai32_Branch[u8_Symbols];
+      i32_Metric1 = mai32_Metric[(u8_State>>1)|0x20]+ai32_Branch[u8_Symbols^0x03];
+      if(i32_Metric1>i32_Metric0)
+      {
+        ai32_Metric[u8_State] = i32_Metric1;
+        pu8_Decision[u8_State>>3] |= (uint8_t)(1<<(u8_State&0x07));
+      }
+      else
+      {
+        ai32_Metric[u8_State] = i32_Metric0;
+      }
+    }
+    
+    // only the differences of the metrics are relevant
+    i32_Metric0 = ai32_Metric[0];
+    if(i32_Metric0>0x1000000 || i32_Metric0<-0x1000000)
+    {
+      for(uint8_t u8_State=0; u8_State<StateCount; u8_State++)
+        ai32_Metric[u8_State] -= i32_Metric0;
+    }
+    memcpy(mai32_Metric, ai32_Metric, sizeof(mai32_Metric));
+    
+    if(++mu16_HistoryPos==HistorySize)
+      mu16_HistoryPos = 0;
+    if(++mu32_PendingSteps==HistorySize)
+    {
+      _traceback(HistorySize, 1);
+      mu32_PendingSteps -= 8;
+    }
+  }
+  
+  
+  
+  // traces back u32_Steps steps from the best state and releases the oldest u16_ByteCount bytes
+  void ViterbiDecoder::_traceback(const uint32_t u32_Steps, const uint16_t u16_ByteCount)
+  {
+    uint8_t au8_Bytes[HistorySize/8+1];
+    uint32_t u32_FirstOutputStep = u32_Steps-(uint32_t)u16_ByteCount*8;
+    uint16_t u16_Pos = mu16_HistoryPos;
+    uint8_t u8_State = 0;
+    uint16_t u16_Bit;
+    
+    for(uint8_t u8_Candidate=1; u8_Candidate<StateCount; u8_Candidate++)
+    {
+      if(mai32_Metric[u8_Candidate]>mai32_Metric[u8_State])
+        u8_State = u8_Candidate;
+    }
+    
+    memset(au8_Bytes, 0, u16_ByteCount);
+    for(uint32_t j=0; j<u32_Steps; j++)
+    {
+      u16_Pos = (u16_Pos==0)?HistorySize-1:u16_Pos-1;
+      if(j>=u32_FirstOutputStep)
+      {
+        u16_Bit = (uint16_t)(j-u32_FirstOutputStep);
+        au8_Bytes[u16_ByteCount-1-u16_Bit/8] |= (uint8_t)((u8_State&0x01)<<(u16_Bit%8));
+      }
+      u8_State = (uint8_t)((u8_State>>1) | (((maau8_Decision[u16_Pos][u8_State>>3]>>(u8_State&0x07))&0x01)<<5));
+    }
+    
+    for(uint16_t i=0; i<u16_ByteCount; i++)
+      _output(au8_Bytes[i]);
+  }
+  
+  
+  
+  void ViterbiDecoder::_output(const uint8_t u8_Byte)
+  {
+    mau8_Output[mu8_OutputSize++] = u8_Byte;
+    if(mu8_OutputSize==OutputBufferSize)
+      _deliver();
+  }
+  
+  
+  void ViterbiDecoder::_deliver(void)
+  {
+    if(mu8_OutputSize>0 && mp_Transferframe)
+      mp_Transferframe->process(mau8_Output, mu8_OutputSize);
+    mu8_OutputSize = 0;
+  }
+#endif
+  
+}
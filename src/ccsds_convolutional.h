@@ -0,0 +1,113 @@
+/**
+ * @file      ccsds_convolutional.h
+ *
+ * @brief     Include file of the convolutional encoder and Viterbi decoder classes
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_CONVOLUTIONAL_H_
+#define _CCSDS_CONVOLUTIONAL_H_
+
+/****************************************************************/
+/* Convolutional coding according to                            */
+/*                                                              */
+/*  - CCSDS 131.0-B-3, - TM Synchronization and Channel Coding  */
+/*    https://public.ccsds.org/Pubs/131x0b3e1.pdf               */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Only the basic code (rate 1/2, K=7) is supported, the     */
+/*    punctured codes are not supported                         */
+/*  - The decoder expects the symbol pairs to be aligned (the   */
+/*    first symbol of the stream belongs to G1)                 */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "ccsds_transferframe.h"
+
+#ifdef configTF_VITERBI_TRACEBACK_DEPTH
+#define TF_VITERBI_TRACEBACK_DEPTH configTF_VITERBI_TRACEBACK_DEPTH
+#else
+#define TF_VITERBI_TRACEBACK_DEPTH 64
+#endif
+
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Class for encoding a data stream with the convolutional code (rate 1/2, K=7) of CCSDS 131.0-B-3.
+   *
+   * Each data bit results in two channel symbols: the first one of G1 = 1111001, the second one of
+   * G2 = 1011011, which is inverted. The encoder keeps its state between the calls of encode(), so a
+   * continuous stream (sync markers and frames) can be encoded in parts.
+   */
+  class ConvolutionalEncoder
+  {
+  private:
+    uint8_t mu8_State;
+    
+  public:
+    ConvolutionalEncoder(void);
+    
+    void reset(void);
+    uint32_t encode(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                    const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+  };
+  
+  
+#if TF_VITERBI_TRACEBACK_DEPTH > 0
+  /**
+   * @brief Class for decoding the convolutional code (rate 1/2, K=7) of CCSDS 131.0-B-3 with soft decisions.
+   *
+   * The decoder takes soft symbols as 8 bit log-likelihood ratios: positive values stand for a 0 bit, negative
+   * values for a 1 bit, the magnitude is the confidence (hard decisions can be given as +127 and -127).
+   *
+   * The survivor memory is bounded: the decisions of the last TF_VITERBI_TRACEBACK_DEPTH+8 steps are kept, and
+   * every 8 steps one byte is traced back from the best state and released. The decoded bytes are handed over
+   * directly to the process() method of a transfer frame object, which synchronizes to the frames.
+   */
+  class ViterbiDecoder
+  {
+  private:
+    const static uint8_t StateCount = 64;
+    const static uint16_t TracebackDepth = TF_VITERBI_TRACEBACK_DEPTH;
+    const static uint16_t HistorySize = TracebackDepth+8;
+    const static uint8_t OutputBufferSize = 16;
+    
+    int32_t mai32_Metric[StateCount];
+    uint8_t maau8_Decision[HistorySize][StateCount/8];
+    uint16_t mu16_HistoryPos;
+    uint32_t mu32_PendingSteps;
+    bool mb_SymbolPending;
+    int8_t mi8_PendingSymbol;
+    
+    uint8_t mau8_Output[OutputBufferSize];
+    uint8_t mu8_OutputSize;
+    
+    Transferframe *mp_Transferframe;
+    
+  public:
+    ViterbiDecoder(Transferframe *p_Transferframe = nullptr);
+    
+    void setTransferframe(Transferframe *p_Transferframe);
+    void reset(void);
+    void process(const int8_t *pi8_Symbols, const uint32_t u32_SymbolCount);
+    void flush(void);
+    
+  private:
+    void _step(const int8_t i8_Symbol1, const int8_t i8_Symbol2);
+    void _traceback(const uint32_t u32_Steps, const uint16_t u16_ByteCount);
+    void _output(const uint8_t u8_Byte);
+    void _deliver(void);
+  };
+#endif
+  
+}
+
+#endif /* _CCSDS_CONVOLUTIONAL_H_ */
@@ -0,0 +1,438 @@
+/**
+ * @file      ccsds_decommutator.cpp
+ *
+ * @brief     Source file of the telemetry decommutation class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "ccsds_decommutator.h"
+
+
+namespace CCSDS
+{
+
+  static inline uint64_t loadBigEndian(const uint8_t *pu8_Data, const uint8_t u8_Size)
+  {
+    uint64_t u64_Value=0;
+
+    for(uint8_t i=0; i<u8_Size; i++)
+      u64_Value = (u64_Value<<8) | pu8_Data[i];
+    return u64_Value;
+  }
+
+  static inline uint64_t loadLittleEndian(const uint8_t *pu8_Data, const uint8_t u8_Size)
+  {
+    uint64_t u64_Value=0;
+
+    for(uint8_t i=u8_Size; i>0; i--)
+      u64_Value = (u64_Value<<8) | pu8_Data[i-1];
+    return u64_Value;
+  }
+
+  static inline double toFloat(const uint64_t u64_Raw)
+  {
+    const uint32_t u32_Raw = (uint32_t)u64_Raw;
+    float f_Value;
+
+    memcpy(&f_Value, &u32_Raw, sizeof(f_Value));
+    return f_Value;
+  }
+
+  static inline double toDouble(const uint64_t u64_Raw)
+  {
+    double d_Value;
+
+    memcpy(&d_Value, &u64_Raw, sizeof(d_Value));
+    return d_Value;
+  }
+
+
+
+  /**
+   * @brief Construct a new Decommutator object without parameter definitions
+   */
+  Decommutator::Decommutator(void)
+    : mu32_ColumnSize{0}
+    , mu16_ParameterCount{0}
+    , mu16_OpCount{0}
+    , mu8_ProgramCount{0}
+    , mu16_UnknownApidCount{0}
+    , mu16_LengthErrorCount{0}
+    , mu16_OverflowErrorCount{0}
+  {
+  }
+
+
+
+  /**
+   * @brief Loads a parameter table and compiles it into the extraction programs
+   *
+   * The previous definitions are replaced and the row counts are cleared. The parameters of an APID are
+   * extracted in the order of the table; parameters of the same type which follow each other in the table
+   * at a constant distance are merged into one operation.
+   *
+   * @param pS_Parameters       The parameter table
+   * @param u16_ParameterCount  The number of parameters
+   * @param u32_ColumnSize      The number of values each column buffer can hold
+   *
+   * @retval  0   If the table was loaded
+   * @retval -1   If a parameter definition is invalid, the previous definitions are kept
+   * @retval -2   If the table has more than MaxParameters parameters or MaxApids APIDs
+   */
+  int32_t Decommutator::load(const Parameter *pS_Parameters, const uint16_t u16_ParameterCount, const uint32_t u32_ColumnSize)
+  {
+    uint8_t u8_Kind;
+    uint8_t u8_Bytes;
+    uint8_t u8_Shift;
+    uint16_t u16_Apids = 0;
+
+    if(!pS_Parameters || (u16_ParameterCount==0) || (u32_ColumnSize==0))
+      return -1;
+    if(u16_ParameterCount>MaxParameters)
+      return -2;
+
+    // check all definitions first and count the APIDs
+    for(uint16_t i=0; i<u16_ParameterCount; i++)
+    {
+      bool b_New = true;
+
+      if(_compileParameter(&pS_Parameters[i], &u8_Kind, &u8_Bytes, &u8_Shift)<0)
+        return -1;
+      for(uint16_t j=0; (j<i) && b_New; j++)
+        b_New = (pS_Parameters[j].u16_APID!=pS_Parameters[i].u16_APID);
+      if(b_New)
+        u16_Apids++;
+    }
+    if(u16_Apids>MaxApids)
+      return -2;
+
+    mu32_ColumnSize = u32_ColumnSize;
+    mu16_ParameterCount = 0;
+    mu16_OpCount = 0;
+    mu8_ProgramCount = 0;
+
+    // one program per APID, in the order of the first appearance in the table
+    for(uint16_t i=0; i<u16_ParameterCount; i++)
+    {
+      const uint16_t u16_APID = pS_Parameters[i].u16_APID;
+      uint8_t u8_Program;
+
+      if(_findProgram(u16_APID)!=NoProgram)
+        continue;
+
+      u8_Program = mu8_ProgramCount++;
+      mau16_APID[u8_Program] = u16_APID;
+      mau16_FirstOp[u8_Program] = mu16_OpCount;
+      mau32_MinDataSize[u8_Program] = 0;
+      mau32_RowCount[u8_Program] = 0;
+
+      for(uint16_t j=i; j<u16_ParameterCount; j++)
+      {
+        const Parameter *pS_Parameter = &pS_Parameters[j];
+        const uint16_t u16_Op = (uint16_t)(mu16_OpCount-1);
+        uint16_t u16_Parameter;
+
+        if(pS_Parameter->u16_APID!=u16_APID)
+          continue;
+
+        _compileParameter(pS_Parameter, &u8_Kind, &u8_Bytes, &u8_Shift);
+        u16_Parameter = mu16_ParameterCount++;
+        mad_Scale[u16_Parameter] = pS_Parameter->d_Scale;
+        mad_Offset[u16_Parameter] = pS_Parameter->d_Offset;
+        mapd_Column[u16_Parameter] = pS_Parameter->pd_Column;
+        if(pS_Parameter->u16_ByteOffset+u8_Bytes>mau32_MinDataSize[u8_Program])
+          mau32_MinDataSize[u8_Program] = pS_Parameter->u16_ByteOffset+u8_Bytes;
+
+        // merge with the previous operation if the type matches and the distance is constant
+        if((mu16_OpCount>mau16_FirstOp[u8_Program]) &&
+           (mau8_OpKind[u16_Op]==u8_Kind) && (mau8_OpBytes[u16_Op]==u8_Bytes) &&
+           (mau8_OpShift[u16_Op]==u8_Shift) && (mau8_OpWidth[u16_Op]==pS_Parameter->u8_Width) &&
+           (pS_Parameter->u16_ByteOffset>mau16_OpOffset[u16_Op]))
+        {
+          const uint32_t u32_Distance = pS_Parameter->u16_ByteOffset-mau16_OpOffset[u16_Op];
+
+          if(mau16_OpCount[u16_Op]==1)
+          {
+            mau16_OpStride[u16_Op] = (uint16_t)u32_Distance;
+            mau16_OpCount[u16_Op]++;
+            continue;
+          }
+          if(u32_Distance==(uint32_t)mau16_OpStride[u16_Op]*mau16_OpCount[u16_Op])
+          {
+            mau16_OpCount[u16_Op]++;
+            continue;
+          }
+        }
+
+        mau8_OpKind[mu16_OpCount] = u8_Kind;
+        mau8_OpBytes[mu16_OpCount] = u8_Bytes;
+        mau8_OpShift[mu16_OpCount] = u8_Shift;
+        mau8_OpWidth[mu16_OpCount] = pS_Parameter->u8_Width;
+        mau16_OpOffset[mu16_OpCount] = pS_Parameter->u16_ByteOffset;
+        mau16_OpStride[mu16_OpCount] = 0;
+        mau16_OpCount[mu16_OpCount] = 1;
+        mau16_OpFirstParameter[mu16_OpCount] = u16_Parameter;
+        mu16_OpCount++;
+      }
+      mau16_ProgramOpCount[u8_Program] = (uint16_t)(mu16_OpCount-mau16_FirstOp[u8_Program]);
+    }
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Extracts the parameters of a packet into the next row of their columns
+   *
+   * @param u16_APID        The APID of the packet
+   * @param pu8_Data        A pointer to the packet data field
+   * @param u32_DataSize    The size of the packet data field
+   *
+   * @retval  0   If the parameters were extracted
+   * @retval -1   If no parameters are defined for the APID
+   * @retval -2   If the packet is too short for the parameters of the APID
+   * @retval -3   If the columns of the APID are full
+   */
+  int32_t Decommutator::process(const uint16_t u16_APID, const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    const uint8_t u8_Program = _findProgram(u16_APID);
+    uint32_t u32_Row;
+    uint16_t u16_LastOp;
+
+    if(u8_Program==NoProgram)
+    {
+      if(mu16_UnknownApidCount<0xffff)
+        mu16_UnknownApidCount++;
+      return -1;
+    }
+    if(!pu8_Data || (u32_DataSize<mau32_MinDataSize[u8_Program]))
+    {
+      if(mu16_LengthErrorCount<0xffff)
+        mu16_LengthErrorCount++;
+      return -2;
+    }
+    if(mau32_RowCount[u8_Program]>=mu32_ColumnSize)
+    {
+      if(mu16_OverflowErrorCount<0xffff)
+        mu16_OverflowErrorCount++;
+      return -3;
+    }
+
+    u32_Row = mau32_RowCount[u8_Program]++;
+    u16_LastOp = (uint16_t)(mau16_FirstOp[u8_Program]+mau16_ProgramOpCount[u8_Program]);
+    for(uint16_t u16_Op=mau16_FirstOp[u8_Program]; u16_Op<u16_LastOp; u16_Op++)
+    {
+      const uint8_t *pu8_Src = &pu8_Data[mau16_OpOffset[u16_Op]];
+      const uint16_t u16_First = mau16_OpFirstParameter[u16_Op];
+      const uint16_t u16_Count = mau16_OpCount[u16_Op];
+      const uint16_t u16_Stride = mau16_OpStride[u16_Op];
+      const uint8_t u8_Bytes = mau8_OpBytes[u16_Op];
+      const uint8_t u8_Shift = mau8_OpShift[u16_Op];
+      const uint8_t u8_SignShift = (mau8_OpWidth[u16_Op]<32)?(uint8_t)(32-mau8_OpWidth[u16_Op]):0;
+      const uint32_t u32_Mask = 0xffffffffUL>>u8_SignShift;
+
+      // the type is resolved once per operation, the loops only extract and calibrate
+      switch(mau8_OpKind[u16_Op])
+      {
+        case BigEndianUnsigned:
+          for(uint16_t i=0; i<u16_Count; i++)
+          {
+            const uint32_t u32_Raw = (uint32_t)(loadBigEndian(&pu8_Src[i*u16_Stride], u8_Bytes)>>u8_Shift)&u32_Mask;
+            mapd_Column[u16_First+i][u32_Row] = u32_Raw*mad_Scale[u16_First+i]+mad_Offset[u16_First+i];
+          }
+          break;
+
+        case BigEndianSigned:
+          for(uint16_t i=0; i<u16_Count; i++)
+          {
+            const uint32_t u32_Raw = (uint32_t)(loadBigEndian(&pu8_Src[i*u16_Stride], u8_Bytes)>>u8_Shift);
+            const int32_t i32_Raw = (int32_t)(u32_Raw<<u8_SignShift)>>u8_SignShift;
+            mapd_Column[u16_First+i][u32_Row] = i32_Raw*mad_Scale[u16_First+i]+mad_Offset[u16_First+i];
+          }
+          break;
+
+        case LittleEndianUnsigned:
+          for(uint16_t i=0; i<u16_Count; i++)
+          {
+            const uint32_t u32_Raw = (uint32_t)loadLittleEndian(&pu8_Src[i*u16_Stride], u8_Bytes);
+            mapd_Column[u16_First+i][u32_Row] = u32_Raw*mad_Scale[u16_First+i]+mad_Offset[u16_First+i];
+          }
+          break;
+
+        case LittleEndianSigned:
+          for(uint16_t i=0; i<u16_Count; i++)
+          {
+            const uint32_t u32_Raw = (uint32_t)loadLittleEndian(&pu8_Src[i*u16_Stride], u8_Bytes);
+            const int32_t i32_Raw = (int32_t)(u32_Raw<<u8_SignShift)>>u8_SignShift;
+            mapd_Column[u16_First+i][u32_Row] = i32_Raw*mad_Scale[u16_First+i]+mad_Offset[u16_First+i];
+          }
+          break;
+
+        case BigEndianFloat:
+          for(uint16_t i=0; i<u16_Count; i++)
+            mapd_Column[u16_First+i][u32_Row] = toFloat(loadBigEndian(&pu8_Src[i*u16_Stride], 4))*mad_Scale[u16_First+i]+mad_Offset[u16_First+i];
+          break;
+
+        case BigEndianDouble:
+          for(uint16_t i=0; i<u16_Count; i++)
+            mapd_Column[u16_First+i][u32_Row] = toDouble(loadBigEndian(&pu8_Src[i*u16_Stride], 8))*mad_Scale[u16_First+i]+mad_Offset[u16_First+i];
+          break;
+
+        case LittleEndianFloat:
+          for(uint16_t i=0; i<u16_Count; i++)
+            mapd_Column[u16_First+i][u32_Row] = toFloat(loadLittleEndian(&pu8_Src[i*u16_Stride], 4))*mad_Scale[u16_First+i]+mad_Offset[u16_First+i];
+          break;
+
+        case LittleEndianDouble:
+          for(uint16_t i=0; i<u16_Count; i++)
+            mapd_Column[u16_First+i][u32_Row] = toDouble(loadLittleEndian(&pu8_Src[i*u16_Stride], 8))*mad_Scale[u16_First+i]+mad_Offset[u16_First+i];
+          break;
+
+        default:
+          break;
+      }
+    }
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Returns the number of rows which were written to the columns of an APID
+   *
+   * @param u16_APID    The APID
+   *
+   * @return The number of rows (0 if no parameters are defined for the APID)
+   */
+  uint32_t Decommutator::getRowCount(const uint16_t u16_APID)
+  {
+    const uint8_t u8_Program = _findProgram(u16_APID);
+
+    return (u8_Program==NoProgram)?0:mau32_RowCount[u8_Program];
+  }
+
+
+
+  /**
+   * @brief Clears the row counts of all APIDs, the next packets are written to the start of the columns
+   */
+  void Decommutator::clearRows(void)
+  {
+    for(uint8_t i=0; i<mu8_ProgramCount; i++)
+      mau32_RowCount[i] = 0;
+  }
+
+
+
+  /**
+   * @brief Extracts the parameters of a received space packet
+   *
+   * This method is called by a SpacePacket object; the parameters are the ones of
+   * SpacePacketActionInterface::onSpacePacketReceived().
+   */
+  void Decommutator::onSpacePacketReceived(const uint8_t u8_PacketType,
+                                           const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                                           const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                                           const uint8_t *pu8_PacketData, const uint16_t u16_PacketDataLength)
+  {
+    (void)u8_PacketType; (void)u8_SequenceFlags; (void)u16_SequenceCount; (void)b_SecHeader;
+
+    process(u16_APID, pu8_PacketData, u16_PacketDataLength);
+  }
+
+
+
+  uint16_t Decommutator::getUnknownApidCount(void)
+  {
+    return mu16_UnknownApidCount;
+  }
+
+  uint16_t Decommutator::getLengthErrorCount(void)
+  {
+    return mu16_LengthErrorCount;
+  }
+
+  uint16_t Decommutator::getOverflowErrorCount(void)
+  {
+    return mu16_OverflowErrorCount;
+  }
+
+  void Decommutator::clearErrorCounters(void)
+  {
+    mu16_UnknownApidCount = 0;
+    mu16_LengthErrorCount = 0;
+    mu16_OverflowErrorCount = 0;
+  }
+
+
+
+  uint8_t Decommutator::_findProgram(const uint16_t u16_APID)
+  {
+    for(uint8_t i=0; i<mu8_ProgramCount; i++)
+    {
+      if(mau16_APID[i]==u16_APID)
+        return i;
+    }
+    return NoProgram;
+  }
+
+
+
+  // checks a parameter definition and determines the operation kind, the number of bytes to load and the shift
+  int32_t Decommutator::_compileParameter(const Parameter *pS_Parameter, uint8_t *pu8_Kind, uint8_t *pu8_Bytes, uint8_t *pu8_Shift)
+  {
+    const uint8_t u8_BitOffset = pS_Parameter->u8_BitOffset;
+    const uint8_t u8_Width = pS_Parameter->u8_Width;
+
+    if(!pS_Parameter->pd_Column || (u8_BitOffset>7))
+      return -1;
+
+    if(pS_Parameter->e_Type==Float)
+    {
+      if((u8_BitOffset!=0) || ((u8_Width!=32) && (u8_Width!=64)))
+        return -1;
+      // double precision values can not be represented where double has only 32 bits (e.g. AVR)
+      if((u8_Width==64) && (sizeof(double)<8))
+        return -1;
+      if(pS_Parameter->b_LittleEndian)
+        *pu8_Kind = (u8_Width==32)?LittleEndianFloat:LittleEndianDouble;
+      else
+        *pu8_Kind = (u8_Width==32)?BigEndianFloat:BigEndianDouble;
+      *pu8_Bytes = (uint8_t)(u8_Width/8);
+      *pu8_Shift = 0;
+    }
+    else if((pS_Parameter->e_Type==Unsigned) || (pS_Parameter->e_Type==Signed))
+    {
+      if((u8_Width<1) || (u8_Width>32))
+        return -1;
+      *pu8_Bytes = (uint8_t)((u8_BitOffset+u8_Width+7)/8);
+      *pu8_Shift = (uint8_t)(*pu8_Bytes*8-u8_BitOffset-u8_Width);
+      if(pS_Parameter->b_LittleEndian)
+      {
+        if((u8_BitOffset!=0) || (u8_Width%8!=0))
+          return -1;
+        *pu8_Kind = (pS_Parameter->e_Type==Signed)?LittleEndianSigned:LittleEndianUnsigned;
+      }
+      else
+      {
+        *pu8_Kind = (pS_Parameter->e_Type==Signed)?BigEndianSigned:BigEndianUnsigned;
+      }
+    }
+    else
+    {
+      return -1;
+    }
+
+    if(pS_Parameter->u16_ByteOffset+*pu8_Bytes>0x10000UL)
+      return -1;
+    return 0;
+  }
+
+}
@@ -0,0 +1,168 @@
+/**
+ * @file      ccsds_decommutator.h
+ *
+ * @brief     Include file of the telemetry decommutation class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_DECOMMUTATOR_H_
+#define _CCSDS_DECOMMUTATOR_H_
+
+/****************************************************************/
+/* Telemetry decommutation of space packet data fields          */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Integer parameters have up to 32 bits, floating point     */
+/*    parameters are IEEE 754 single or double precision        */
+/*  - Little endian parameters must be byte-aligned             */
+/*  - Only linear calibration (scale and offset) is supported   */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "ccsds_spacepacket.h"
+
+#ifdef configDECOM_MAX_PARAMETERS
+#define DECOM_MAX_PARAMETERS configDECOM_MAX_PARAMETERS
+#else
+#define DECOM_MAX_PARAMETERS 256
+#endif
+
+#ifdef configDECOM_MAX_APIDS
+#define DECOM_MAX_APIDS configDECOM_MAX_APIDS
+#else
+#define DECOM_MAX_APIDS 16
+#endif
+
+
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Class for extracting telemetry parameters from the data fields of space packets.
+   *
+   * The parameters are described by a table: APID, position in the packet data field (byte offset and bit
+   * offset from the most significant bit), width, type, byte order and a linear calibration. Each parameter
+   * has its own column buffer; every processed packet adds one row to the columns of the parameters of its
+   * APID, so the values of a parameter are stored one after another for further processing.
+   *
+   * load() compiles the table into one extraction program per APID. Parameters which follow each other in the
+   * table with the same type, width, bit position and a constant distance are merged into one operation which
+   * is executed as a tight loop. The minimum packet size of each program is calculated once, so the extraction
+   * needs no further bounds checks.
+   *
+   * The class implements the SpacePacketActionInterface, so it can be given directly to a SpacePacket object;
+   * the offsets are counted from the start of the packet data field (including a secondary header).
+   */
+  class Decommutator : public SpacePacketActionInterface
+  {
+  public:
+    static const uint16_t MaxParameters = DECOM_MAX_PARAMETERS;
+    static const uint8_t MaxApids = DECOM_MAX_APIDS;
+
+    /** The type of a parameter
+     */
+    enum ParameterType
+    {
+      Unsigned = 0,     /**< Unsigned integer with 1 to 32 bits */
+      Signed = 1,       /**< Two's complement integer with 1 to 32 bits */
+      Float = 2         /**< IEEE 754 floating point number with 32 or 64 bits, byte-aligned */
+    };
+
+    /**
+     * @brief The definition of a parameter
+     */
+    struct Parameter
+    {
+      uint16_t u16_APID;              /**< APID of the packets which contain the parameter */
+      uint16_t u16_ByteOffset;        /**< Offset of the first byte in the packet data field */
+      uint8_t u8_BitOffset;           /**< Offset of the first bit in the first byte (0 is the MSB) */
+      uint8_t u8_Width;               /**< Width of the parameter in bits */
+      enum ParameterType e_Type;      /**< Type of the parameter */
+      bool b_LittleEndian;            /**< true if the bytes of the parameter are in little endian order */
+      double d_Scale;                 /**< Calibration: value = raw value * d_Scale + d_Offset */
+      double d_Offset;
+      double *pd_Column;              /**< Column buffer for the calibrated values (one per processed packet) */
+    };
+
+  private:
+    const static uint8_t NoProgram = 0xff;
+    static_assert(DECOM_MAX_APIDS<NoProgram, "configDECOM_MAX_APIDS must be below 255, the program index 0xff marks an unknown APID");
+
+    // operation kinds
+    enum OperationKind
+    {
+      BigEndianUnsigned,
+      BigEndianSigned,
+      LittleEndianUnsigned,
+      LittleEndianSigned,
+      BigEndianFloat,
+      BigEndianDouble,
+      LittleEndianFloat,
+      LittleEndianDouble
+    };
+
+    uint32_t mu32_ColumnSize;
+
+    // parameters in program order, stored as structure of arrays
+    uint16_t mu16_ParameterCount;
+    double mad_Scale[DECOM_MAX_PARAMETERS];
+    double mad_Offset[DECOM_MAX_PARAMETERS];
+    double *mapd_Column[DECOM_MAX_PARAMETERS];
+
+    // operations; an operation extracts u16_Count parameters at a distance of u16_Stride bytes
+    uint16_t mu16_OpCount;
+    uint8_t mau8_OpKind[DECOM_MAX_PARAMETERS];
+    uint8_t mau8_OpBytes[DECOM_MAX_PARAMETERS];
+    uint8_t mau8_OpShift[DECOM_MAX_PARAMETERS];
+    uint8_t mau8_OpWidth[DECOM_MAX_PARAMETERS];
+    uint16_t mau16_OpOffset[DECOM_MAX_PARAMETERS];
+    uint16_t mau16_OpStride[DECOM_MAX_PARAMETERS];
+    uint16_t mau16_OpCount[DECOM_MAX_PARAMETERS];
+    uint16_t mau16_OpFirstParameter[DECOM_MAX_PARAMETERS];
+
+    // programs per APID
+    uint8_t mu8_ProgramCount;
+    uint16_t mau16_APID[DECOM_MAX_APIDS];
+    uint16_t mau16_FirstOp[DECOM_MAX_APIDS];
+    uint16_t mau16_ProgramOpCount[DECOM_MAX_APIDS];
+    uint32_t mau32_MinDataSize[DECOM_MAX_APIDS];
+    uint32_t mau32_RowCount[DECOM_MAX_APIDS];
+
+    uint16_t mu16_UnknownApidCount;
+    uint16_t mu16_LengthErrorCount;
+    uint16_t mu16_OverflowErrorCount;
+
+  public:
+    Decommutator(void);
+
+    int32_t load(const Parameter *pS_Parameters, const uint16_t u16_ParameterCount, const uint32_t u32_ColumnSize);
+
+    int32_t process(const uint16_t u16_APID, const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+    uint32_t getRowCount(const uint16_t u16_APID);
+    void clearRows(void);
+
+    void onSpacePacketReceived(const uint8_t u8_PacketType,
+                               const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                               const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                               const uint8_t *pu8_PacketData, const uint16_t u16_PacketDataLength);
+
+    uint16_t getUnknownApidCount(void);
+    uint16_t getLengthErrorCount(void);
+    uint16_t getOverflowErrorCount(void);
+    void clearErrorCounters(void);
+
+  private:
+    uint8_t _findProgram(const uint16_t u16_APID);
+    static int32_t _compileParameter(const Parameter *pS_Parameter, uint8_t *pu8_Kind, uint8_t *pu8_Bytes, uint8_t *pu8_Shift);
+  };
+
+}
+
+#endif // _CCSDS_DECOMMUTATOR_H_
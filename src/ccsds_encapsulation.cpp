@@ -0,0 +1,468 @@
+/**
+ * @file      ccsds_encapsulation.cpp
+ *
+ * @brief     Source file of the Encapsulation Packet (EP) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "ccsds_encapsulation.h"
+
+
+namespace CCSDS
+{
+  // header size depending on the length of length field
+  static const uint8_t au8_EpHeaderSize[4] = { 1, 2, 4, 8 };
+
+
+
+  /**
+   * @brief Construct a new EncapsulationPacket object
+   *
+   * @param p_ActionInterface   A pointer to the implementation of the action interface
+   * @param p_SpacePacket       A pointer to a SpacePacket object which receives the space packets of a mixed stream (optional)
+   */
+  EncapsulationPacket::EncapsulationPacket(EncapsulationPacketActionInterface *p_ActionInterface, SpacePacket *p_SpacePacket)
+    : mu32_Index{0}
+    , mu32_PacketLength{0}
+    , mu8_HeaderSize{0}
+    , mb_SpacePacket{false}
+    , mb_Skipping{false}
+    , mb_Overflow{false}
+    , mu16_SyncErrorCount{0}
+    , mu16_OverflowErrorCount{0}
+    , mp_ActionInterface{p_ActionInterface}
+    , mp_SpacePacket{p_SpacePacket}
+  {
+  }
+
+
+
+  /**
+   * @brief Overwrites the action interface which was set using the constructor
+   *
+   * @param p_ActionInterface   A pointer to the implementation of the action interface
+   */
+  void EncapsulationPacket::setActionInterface(EncapsulationPacketActionInterface *p_ActionInterface)
+  {
+    mp_ActionInterface = p_ActionInterface;
+  }
+
+
+
+  /**
+   * @brief Sets the SpacePacket object which receives the space packets of a mixed stream
+   *
+   * @param p_SpacePacket   A pointer to the SpacePacket object (nullptr if space packets shall be skipped)
+   */
+  void EncapsulationPacket::setSpacePacket(SpacePacket *p_SpacePacket)
+  {
+    reset();
+    mp_SpacePacket = p_SpacePacket;
+  }
+
+
+
+  /**
+   * @brief Returns the size of the header which create() uses for the given data and header fields
+   *
+   * @param u32_PacketDataLength    The size of the data to be encapsulated in bytes
+   * @param u8_ProtocolIDExtension  The protocol ID extension (4 bit)
+   * @param u8_UserDefinedField     The user defined field (4 bit)
+   * @param u16_CcsdsDefinedField   The CCSDS defined field
+   *
+   * @retval 0  The data is too large for an encapsulation packet
+   * @return The header size in bytes (2, 4 or 8)
+   */
+  uint8_t EncapsulationPacket::getHeaderSize(const uint32_t u32_PacketDataLength, const uint8_t u8_ProtocolIDExtension,
+                                             const uint8_t u8_UserDefinedField, const uint16_t u16_CcsdsDefinedField)
+  {
+    if(u32_PacketDataLength>0xffffffffUL-EP_MAX_HEADER_SIZE)
+      return 0;
+
+    if(u16_CcsdsDefinedField==0 && u8_ProtocolIDExtension==0 && u8_UserDefinedField==0
+       && u32_PacketDataLength<=0xffUL-2)
+      return 2;
+
+    if(u16_CcsdsDefinedField==0 && u32_PacketDataLength<=0xffffUL-4)
+      return 4;
+
+    return 8;
+  }
+
+
+
+  /**
+   * @brief Creates an Encapsulation Packet and writes it into the given buffer
+   *
+   * The shortest header which can hold the packet length and the given optional fields is used.
+   *
+   * @param pu8_Buffer              A pointer to the buffer where the packet shall be stored
+   * @param u32_BufferSize          The available size of the buffer
+   * @param u8_ProtocolID           The protocol ID of the data (1 to 7, see EncapsulationPacket::ProtocolID)
+   * @param pu8_PacketData          A pointer to the data block which shall be wrapped
+   * @param u32_PacketDataLength    The size of the data block in bytes (may be 0)
+   * @param u8_ProtocolIDExtension  The protocol ID extension (0 to 15)
+   * @param u8_UserDefinedField     The user defined field (0 to 15)
+   * @param u16_CcsdsDefinedField   The CCSDS defined field
+   *
+   * @retval 0  No packet could be created
+   * @return The size of the created packet in bytes as uint32_t
+   */
+  uint32_t EncapsulationPacket::create(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                       const uint8_t u8_ProtocolID,
+                                       const uint8_t *pu8_PacketData, const uint32_t u32_PacketDataLength,
+                                       const uint8_t u8_ProtocolIDExtension, const uint8_t u8_UserDefinedField,
+                                       const uint16_t u16_CcsdsDefinedField)
+  {
+    uint8_t u8_HeaderSize = getHeaderSize(u32_PacketDataLength, u8_ProtocolIDExtension, u8_UserDefinedField, u16_CcsdsDefinedField);
+    uint32_t u32_PacketLength = u8_HeaderSize+u32_PacketDataLength;
+
+    if(!pu8_Buffer || u8_HeaderSize==0 || u32_BufferSize<u32_PacketLength)
+      return 0;
+    if(u8_ProtocolID==Idle || u8_ProtocolID>7 || u8_ProtocolIDExtension>0xf || u8_UserDefinedField>0xf)
+      return 0;
+    if(u32_PacketDataLength>0 && !pu8_PacketData)
+      return 0;
+
+    switch(u8_HeaderSize)
+    {
+      case 2:
+        pu8_Buffer[0] = (uint8_t)((EpPacketVersion<<5) | (u8_ProtocolID<<2) | 1);
+        pu8_Buffer[1] = (uint8_t)u32_PacketLength;
+        break;
+      case 4:
+        pu8_Buffer[0] = (uint8_t)((EpPacketVersion<<5) | (u8_ProtocolID<<2) | 2);
+        pu8_Buffer[1] = (uint8_t)((u8_UserDefinedField<<4) | u8_ProtocolIDExtension);
+        pu8_Buffer[2] = (uint8_t)(u32_PacketLength>>8);
+        pu8_Buffer[3] = (uint8_t)u32_PacketLength;
+        break;
+      default:
+        pu8_Buffer[0] = (uint8_t)((EpPacketVersion<<5) | (u8_ProtocolID<<2) | 3);
+        pu8_Buffer[1] = (uint8_t)((u8_UserDefinedField<<4) | u8_ProtocolIDExtension);
+        pu8_Buffer[2] = (uint8_t)(u16_CcsdsDefinedField>>8);
+        pu8_Buffer[3] = (uint8_t)u16_CcsdsDefinedField;
+        pu8_Buffer[4] = (uint8_t)(u32_PacketLength>>24);
+        pu8_Buffer[5] = (uint8_t)(u32_PacketLength>>16);
+        pu8_Buffer[6] = (uint8_t)(u32_PacketLength>>8);
+        pu8_Buffer[7] = (uint8_t)u32_PacketLength;
+        break;
+    }
+
+    if(u32_PacketDataLength>0)
+      memcpy(&pu8_Buffer[u8_HeaderSize], pu8_PacketData, u32_PacketDataLength);
+
+    return u32_PacketLength;
+  }
+
+
+
+  /**
+   * @brief Creates an idle Encapsulation Packet of the given size, e.g. to fill up a frame
+   *
+   * A size of 1 results in the 1 byte idle packet, larger sizes in an idle packet with a length field.
+   *
+   * @param pu8_Buffer          A pointer to the buffer where the packet shall be stored
+   * @param u32_BufferSize      The available size of the buffer
+   * @param u32_TargetPacketSize The size of the packet including the header
+   *
+   * @retval 0  No packet could be created
+   * @return The size of the created packet in bytes as uint32_t
+   */
+  uint32_t EncapsulationPacket::createIdle(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint32_t u32_TargetPacketSize)
+  {
+    uint8_t u8_HeaderSize;
+
+    if(!pu8_Buffer || u32_TargetPacketSize==0 || u32_BufferSize<u32_TargetPacketSize)
+      return 0;
+
+    if(u32_TargetPacketSize==1)
+    {
+      pu8_Buffer[0] = (uint8_t)((EpPacketVersion<<5) | (Idle<<2));
+      return 1;
+    }
+
+    if(u32_TargetPacketSize<=0xff)
+    {
+      u8_HeaderSize = 2;
+      pu8_Buffer[0] = (uint8_t)((EpPacketVersion<<5) | (Idle<<2) | 1);
+      pu8_Buffer[1] = (uint8_t)u32_TargetPacketSize;
+    }
+    else if(u32_TargetPacketSize<=0xffff)
+    {
+      u8_HeaderSize = 4;
+      pu8_Buffer[0] = (uint8_t)((EpPacketVersion<<5) | (Idle<<2) | 2);
+      pu8_Buffer[1] = 0;
+      pu8_Buffer[2] = (uint8_t)(u32_TargetPacketSize>>8);
+      pu8_Buffer[3] = (uint8_t)u32_TargetPacketSize;
+    }
+    else
+    {
+      u8_HeaderSize = 8;
+      pu8_Buffer[0] = (uint8_t)((EpPacketVersion<<5) | (Idle<<2) | 3);
+      memset(&pu8_Buffer[1], 0, 3);
+      pu8_Buffer[4] = (uint8_t)(u32_TargetPacketSize>>24);
+      pu8_Buffer[5] = (uint8_t)(u32_TargetPacketSize>>16);
+      pu8_Buffer[6] = (uint8_t)(u32_TargetPacketSize>>8);
+      pu8_Buffer[7] = (uint8_t)u32_TargetPacketSize;
+    }
+
+    memset(&pu8_Buffer[u8_HeaderSize], 0xff, u32_TargetPacketSize-u8_HeaderSize);
+
+    return u32_TargetPacketSize;
+  }
+
+
+
+  /**
+   * @brief Resets the parser; a packet which is currently processed is dropped
+   *
+   * If a SpacePacket object is set, it is reset as well.
+   *
+   * @return 0
+   */
+  int32_t EncapsulationPacket::reset(void)
+  {
+    if((mu32_Index>0) && !(mb_SpacePacket && mp_SpacePacket) && (mu16_SyncErrorCount<0xffff))
+      mu16_SyncErrorCount++;
+    if(mp_SpacePacket)
+      mp_SpacePacket->reset();
+    mu32_Index = 0;
+    mb_SpacePacket = false;
+    mb_Skipping = false;
+    mb_Overflow = false;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief The given upstream data is parsed for Encapsulation Packets (and Space Packets).
+   *
+   * The method can handle continuously incoming data as well as complete data blocks.
+   * If a complete Encapsulation Packet is processed, the action interface is called. Packets which
+   * are completely contained in the given buffer are not copied. Space packets are forwarded to the
+   * SpacePacket object, if it is set, or skipped otherwise. Data which does not start with a valid
+   * packet version number is skipped up to the next valid one.
+   *
+   * @param pu8_Buffer      The data buffer which is to parse
+   * @param u32_BufferSize  The size of the data buffer
+   *
+   * @retval  0   If the buffer was parsed
+   * @retval -1   If the buffer is invalid
+   */
+  int32_t EncapsulationPacket::process(const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    uint32_t i = 0;
+    uint32_t u32_Chunk;
+    bool b_Delivered;
+
+    if((u32_BufferSize==0) || !pu8_Buffer)
+      return -1;
+
+    while(i<u32_BufferSize)
+    {
+      // packet version number
+      if(mu32_Index==0)
+      {
+        if((pu8_Buffer[i]>>5)==EpPacketVersion)
+        {
+          mu8_HeaderSize = au8_EpHeaderSize[pu8_Buffer[i]&0x3];
+          mb_SpacePacket = false;
+        }
+        else if((pu8_Buffer[i]>>5)==SpPacketVersion)
+        {
+          mu8_HeaderSize = SP_HEADER_SIZE;
+          mb_SpacePacket = true;
+        }
+        else
+        {
+          if(!mb_Skipping && (mu16_SyncErrorCount<0xffff))
+            mu16_SyncErrorCount++;
+          mb_Skipping = true;
+          i++;
+          continue;
+        }
+        mb_Skipping = false;
+
+        // 1 byte idle packet, the short header is not allowed for other protocols
+        if(mu8_HeaderSize==1)
+        {
+          if((((pu8_Buffer[i]>>2)&0x7)!=Idle) && (mu16_SyncErrorCount<0xffff))
+            mu16_SyncErrorCount++;
+          i++;
+          continue;
+        }
+      }
+
+      // header
+      if(mu32_Index<mu8_HeaderSize)
+      {
+        mau8_Header[mu32_Index++] = pu8_Buffer[i++];
+        if(mu32_Index==mu8_HeaderSize)
+        {
+          if(!_parseHeader())
+          {
+            if(mu16_SyncErrorCount<0xffff)
+              mu16_SyncErrorCount++;
+            mu32_Index = 0;
+          }
+          else if(mu32_Index==mu32_PacketLength)
+          {
+            _deliver(nullptr, 0);
+            mu32_Index = 0;
+          }
+        }
+        continue;
+      }
+
+      // data
+      u32_Chunk = mu32_PacketLength-mu32_Index;
+      if(u32_Chunk>u32_BufferSize-i)
+        u32_Chunk = u32_BufferSize-i;
+      b_Delivered = false;
+
+      if(mb_SpacePacket)
+      {
+        if(mp_SpacePacket)
+          mp_SpacePacket->process(&pu8_Buffer[i], u32_Chunk);
+        b_Delivered = true;
+      }
+      else if(((mau8_Header[0]>>2)&0x7)==Idle)
+      {
+        // fill data is skipped
+        b_Delivered = true;
+      }
+      else if((mu32_Index==mu8_HeaderSize) && (u32_Chunk==mu32_PacketLength-mu32_Index))
+      {
+        // the complete data is in the given buffer
+        _deliver(&pu8_Buffer[i], u32_Chunk);
+        b_Delivered = true;
+      }
+      else if(!mb_Overflow && (mu32_Index-mu8_HeaderSize+u32_Chunk<=EP_MAX_DATA_SIZE))
+      {
+        memcpy(&mau8_PacketData[mu32_Index-mu8_HeaderSize], &pu8_Buffer[i], u32_Chunk);
+      }
+      else
+      {
+        if(!mb_Overflow && mu16_OverflowErrorCount<0xffff)
+          mu16_OverflowErrorCount++;
+        mb_Overflow = true;
+      }
+
+      mu32_Index += u32_Chunk;
+      i += u32_Chunk;
+
+      if(mu32_Index>=mu32_PacketLength)
+      {
+        if(!b_Delivered && !mb_Overflow)
+          _deliver(mau8_PacketData, mu32_PacketLength-mu8_HeaderSize);
+        mu32_Index = 0;
+        mb_Overflow = false;
+      }
+    }
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Returns the number of sync errors
+   *
+   * Sync Errors occur if the data does not start with a valid packet version number, if a header holds
+   * an invalid packet length, if a 1 byte header holds a protocol ID other than idle or if the parsing
+   * engine is reset while a packet is currently processed.
+   *
+   * If the number of sync errors exceeds 65535, the method returns 65535.
+   *
+   * @return Number of sync errors as uint16_t
+   */
+  uint16_t EncapsulationPacket::getSyncErrorCount(void)
+  {
+    return mu16_SyncErrorCount;
+  }
+
+
+
+  /**
+   * @brief Returns the number of overflow errors
+   *
+   * Overflow errors occur if a packet which is split over several calls of process()
+   * is bigger than the internal memory of this class.
+   *
+   * If the number of overflow errors exceeds 65535, the method returns 65535.
+   *
+   * @return Number of overflow errors as uint16_t
+   */
+  uint16_t EncapsulationPacket::getOverflowErrorCount(void)
+  {
+    return mu16_OverflowErrorCount;
+  }
+
+
+
+  /**
+   * @brief Clears all error counters (Sync Error and Overflow Error)
+   */
+  void EncapsulationPacket::clearErrorCounters(void)
+  {
+    mu16_SyncErrorCount = 0;
+    mu16_OverflowErrorCount = 0;
+  }
+
+
+
+  /*
+   * Gets the packet length of the received header; space packet headers are forwarded
+   */
+  bool EncapsulationPacket::_parseHeader(void)
+  {
+    if(mb_SpacePacket)
+    {
+      mu32_PacketLength = SP_HEADER_SIZE+1UL+(((uint32_t)mau8_Header[4]<<8) | (uint32_t)mau8_Header[5]);
+      if(mp_SpacePacket)
+        mp_SpacePacket->process(mau8_Header, SP_HEADER_SIZE);
+      return true;
+    }
+
+    switch(mu8_HeaderSize)
+    {
+      case 2:
+        mu32_PacketLength = mau8_Header[1];
+        break;
+      case 4:
+        mu32_PacketLength = ((uint32_t)mau8_Header[2]<<8) | (uint32_t)mau8_Header[3];
+        break;
+      default:
+        mu32_PacketLength = ((uint32_t)mau8_Header[4]<<24) | ((uint32_t)mau8_Header[5]<<16)
+                          | ((uint32_t)mau8_Header[6]<<8) | (uint32_t)mau8_Header[7];
+        break;
+    }
+
+    return (mu32_PacketLength>=mu8_HeaderSize);
+  }
+
+
+
+  /*
+   * Calls the action interface with the fields of the current header (not for idle packets)
+   */
+  void EncapsulationPacket::_deliver(const uint8_t *pu8_PacketData, const uint32_t u32_PacketDataLength)
+  {
+    uint8_t u8_ProtocolID = (uint8_t)((mau8_Header[0]>>2)&0x7);
+
+    if(!mp_ActionInterface || u8_ProtocolID==Idle)
+      return;
+
+    mp_ActionInterface->onEncapsulationPacketReceived(u8_ProtocolID,
+                                                      (mu8_HeaderSize>2)?(uint8_t)(mau8_Header[1]&0xf):0,
+                                                      (mu8_HeaderSize>2)?(uint8_t)(mau8_Header[1]>>4):0,
+                                                      (mu8_HeaderSize>4)?(uint16_t)(((uint16_t)mau8_Header[2]<<8) | mau8_Header[3]):0,
+                                                      pu8_PacketData, u32_PacketDataLength);
+  }
+
+}
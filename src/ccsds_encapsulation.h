@@ -0,0 +1,161 @@
+/**
+ * @file      ccsds_encapsulation.h
+ *
+ * @brief     Include file of the Encapsulation Packet (EP) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_ENCAPSULATION_H_
+#define _CCSDS_ENCAPSULATION_H_
+
+/****************************************************************/
+/* Encapsulation Packets according to                           */
+/*                                                              */
+/*  - CCSDS 133.1-B-3, - Encapsulation Packet Protocol          */
+/*    https://public.ccsds.org/Pubs/133x1b3e1.pdf               */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Packets which are split over several calls of process()   */
+/*    are limited to EP_MAX_DATA_SIZE bytes of data             */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+
+#ifdef configEP_MAX_DATA_SIZE
+#define EP_MAX_DATA_SIZE configEP_MAX_DATA_SIZE
+#else
+#define EP_MAX_DATA_SIZE 1500
+#endif
+
+
+#include "ccsds_spacepacket.h"
+
+
+#define EP_MAX_HEADER_SIZE   8
+
+
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Interface class for handling encapsulation packet actions
+   */
+  class EncapsulationPacketActionInterface
+  {
+  public:
+    /**
+     * @brief Declaration of the action which shall be called if a complete encapsulation packet was received
+     *
+     * Idle packets are dropped by the parser and do not lead to a call of this action. The data pointer
+     * either refers to the buffer given to process() or to the internal buffer of the parser, so it is
+     * only valid during the callback.
+     *
+     * @param u8_ProtocolID           The protocol ID of the encapsulated data (see EncapsulationPacket::ProtocolID)
+     * @param u8_ProtocolIDExtension  The protocol ID extension (0 if the header has no extension field)
+     * @param u8_UserDefinedField     The 4 bit user defined field (0 if the header has no such field)
+     * @param u16_CcsdsDefinedField   The CCSDS defined field (0 if the header has no such field)
+     * @param pu8_PacketData          A pointer to the encapsulated data
+     * @param u32_PacketDataLength    The size of the encapsulated data in bytes
+     */
+    virtual void onEncapsulationPacketReceived(const uint8_t u8_ProtocolID, const uint8_t u8_ProtocolIDExtension,
+                                               const uint8_t u8_UserDefinedField, const uint16_t u16_CcsdsDefinedField,
+                                               const uint8_t *pu8_PacketData, const uint32_t u32_PacketDataLength) = 0;
+  };
+
+
+
+  /**
+   * @brief Class for handling the Encapsulation Packets as described in CCSDS 133.1-B-3.
+   *
+   * Encapsulation Packets carry the data units of protocols which are not space packets (e.g. IP datagrams
+   * with the IPE header) over the CCSDS data link protocols. The header is 1, 2, 4 or 8 bytes long,
+   * depending on the size of the packet length field (up to 4 GB) and on the optional fields; create()
+   * always selects the shortest header for the given data.
+   *
+   * process() has the same streaming semantics as SpacePacket::process(): the data may be given in blocks
+   * of any size. A packet which is completely contained in one block is handed over to the callback without
+   * being copied; only packets which are split over several blocks are assembled in the internal buffer.
+   *
+   * Encapsulation Packets and Space Packets can be mixed in the data stream of one virtual channel,
+   * as they are distinguished by the packet version number. If a SpacePacket object is set, the space packets
+   * of the stream are forwarded to it; otherwise they are skipped.
+   */
+  class EncapsulationPacket
+  {
+  public:
+    static const uint32_t MaxDataSize = EP_MAX_DATA_SIZE;   /**< Maximum size of the data of a packet which is assembled internally */
+    static const uint8_t MaxHeaderSize = EP_MAX_HEADER_SIZE;
+
+    /** The protocol ID identifies the protocol of the encapsulated data
+     */
+    enum ProtocolID
+    {
+      Idle = 0,                   /**< Idle packet (fill data), dropped by the receiver */
+      LtpProtocol = 1,            /**< Licklider Transmission Protocol */
+      IpeProtocol = 2,            /**< Internet protocols with the IP Extension (IPE) header */
+      CfdpProtocol = 3,           /**< CCSDS File Delivery Protocol */
+      BundleProtocol = 4,         /**< Bundle Protocol */
+      ExtendedProtocolID = 6,     /**< The protocol is identified by the protocol ID extension */
+      MissionSpecific = 7         /**< Mission-specific protocol */
+    };
+
+  private:
+    const static uint8_t EpPacketVersion = 7;
+    const static uint8_t SpPacketVersion = 0;
+
+    uint32_t mu32_Index;
+    uint32_t mu32_PacketLength;
+    uint8_t mu8_HeaderSize;
+    uint8_t mau8_Header[EP_MAX_HEADER_SIZE];
+    bool mb_SpacePacket;
+    bool mb_Skipping;
+    uint8_t mau8_PacketData[EP_MAX_DATA_SIZE];
+
+    bool mb_Overflow;
+    uint16_t mu16_SyncErrorCount;
+    uint16_t mu16_OverflowErrorCount;
+
+    EncapsulationPacketActionInterface *mp_ActionInterface;
+    SpacePacket *mp_SpacePacket;
+
+  public:
+    EncapsulationPacket(EncapsulationPacketActionInterface *p_ActionInterface = nullptr, SpacePacket *p_SpacePacket = nullptr);
+
+    void setActionInterface(EncapsulationPacketActionInterface *p_ActionInterface);
+    void setSpacePacket(SpacePacket *p_SpacePacket);
+
+    // EP generation
+    static uint32_t create(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                           const uint8_t u8_ProtocolID,
+                           const uint8_t *pu8_PacketData, const uint32_t u32_PacketDataLength,
+                           const uint8_t u8_ProtocolIDExtension = 0, const uint8_t u8_UserDefinedField = 0,
+                           const uint16_t u16_CcsdsDefinedField = 0);
+
+    static uint32_t createIdle(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint32_t u32_TargetPacketSize);
+
+    static uint8_t getHeaderSize(const uint32_t u32_PacketDataLength, const uint8_t u8_ProtocolIDExtension = 0,
+                                 const uint8_t u8_UserDefinedField = 0, const uint16_t u16_CcsdsDefinedField = 0);
+
+    // ep processing
+    int32_t process(const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+    int32_t reset(void);
+
+    uint16_t getSyncErrorCount(void);
+    uint16_t getOverflowErrorCount(void);
+    void clearErrorCounters(void);
+
+  private:
+    bool _parseHeader(void);
+    void _deliver(const uint8_t *pu8_PacketData, const uint32_t u32_PacketDataLength);
+  };
+
+}
+
+#endif // _CCSDS_ENCAPSULATION_H_
@@ -0,0 +1,72 @@
+/**
+ * @file      ccsds_randomizer.h
+ *
+ * @brief     Include file of the pseudo-randomizer class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_RANDOMIZER_H_
+#define _CCSDS_RANDOMIZER_H_
+
+/****************************************************************/
+/* Pseudo-Randomizer according to                               */
+/*                                                              */
+/*  - CCSDS 131.0-B-3, - TM Synchronization and Channel Coding  */
+/*    https://public.ccsds.org/Pubs/131x0b3e1.pdf               */
+/*  - CCSDS 231.0-B-3, - TC Synchronization and Channel Coding  */
+/*    https://public.ccsds.org/Pubs/231x0b3.pdf                 */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+
+#ifdef configTF_USE_RANDOMIZER
+#define TF_USE_RANDOMIZER configTF_USE_RANDOMIZER
+#else
+#define TF_USE_RANDOMIZER 1
+#endif
+
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Class for applying the CCSDS pseudo-randomizer sequences.
+   *
+   * The randomizer ensures sufficient bit transitions in the channel. The data is combined by exclusive-or
+   * with a pseudo-random sequence which starts at the beginning of each frame; the same operation removes
+   * the randomization again.
+   *
+   * - The TM sequence (CCSDS 131.0-B-3) is generated by h(x) = x^8 + x^7 + x^5 + x^3 + 1 and is applied to the
+   *   transfer frame after the attached sync marker.
+   * - The TC sequence (CCSDS 231.0-B-3) is generated by h(x) = x^8 + x^6 + x^4 + x^3 + x^2 + x + 1 and is
+   *   applied to the transfer frame before it is encoded into CLTUs.
+   *
+   * Both sequences repeat after 255 bits, i.e. after 255 bytes when applied byte by byte. They are stored as
+   * precomputed tables and applied four bytes at a time.
+   */
+  class Randomizer
+  {
+  public:
+    enum Sequence
+    {
+      NoSequence = 0,
+      TmSequence = 1,
+      TcSequence = 2
+    };
+    
+    const static uint8_t SequenceLength = 255;
+    
+  public:
+    static void apply(const enum Sequence e_Sequence, uint8_t *pu8_Buffer, const uint32_t u32_Size,
+                      const uint32_t u32_Offset = 0);
+  };
+  
+}
+
+#endif /* _CCSDS_RANDOMIZER_H_ */
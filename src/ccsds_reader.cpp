@@ -0,0 +1,468 @@
+/**
+ * @file      ccsds_reader.cpp
+ *
+ * @brief     Source file of the pull based reader classes
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "ccsds_reader.h"
+
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Construct a new SpacePacketReader object
+   */
+  SpacePacketReader::SpacePacketReader(void)
+    : mpu8_Data{nullptr}
+    , mu32_DataSize{0}
+    , mu32_Pos{0}
+    , mu32_Buffered{0}
+    , mu32_Skip{0}
+    , mu16_OverflowErrorCount{0}
+  {
+  }
+
+
+
+  /**
+   * @brief Sets the data which is read by the following calls of next()
+   *
+   * The data is not copied and must stay valid until all packets were read. The unread data of a
+   * previous call is dropped; a packet which was started in the previous data is continued.
+   *
+   * @param pu8_Data        The received data, e.g. the data field of a transfer frame
+   * @param u32_DataSize    The size of the data
+   */
+  void SpacePacketReader::feed(const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    mpu8_Data = pu8_Data;
+    mu32_DataSize = pu8_Data?u32_DataSize:0;
+    mu32_Pos = 0;
+  }
+
+
+
+  /**
+   * @brief Reads the next complete space packet
+   *
+   * Packets which are larger than SP_MAX_TOTAL_SIZE are skipped and counted as overflow errors.
+   *
+   * @param S_View    The view which is set to the packet; it is valid until the next call of next() or feed()
+   *
+   * @return true if a packet was read, false if more data has to be fed
+   */
+  bool SpacePacketReader::next(SpacePacketView &S_View)
+  {
+    uint32_t u32_Remaining;
+    uint32_t u32_Copy;
+    uint32_t u32_PacketSize;
+
+    while(mu32_Pos<mu32_DataSize)
+    {
+      u32_Remaining = mu32_DataSize-mu32_Pos;
+
+      if(mu32_Skip)
+      {
+        u32_Copy = (mu32_Skip<u32_Remaining)?mu32_Skip:u32_Remaining;
+        mu32_Skip -= u32_Copy;
+        mu32_Pos += u32_Copy;
+        continue;
+      }
+
+      // a packet which is located completely within the fed data is not copied
+      if(!mu32_Buffered && (u32_Remaining>=SP_HEADER_SIZE))
+      {
+        u32_PacketSize = SP_HEADER_SIZE+1UL+(((uint32_t)mpu8_Data[mu32_Pos+4]<<8) | mpu8_Data[mu32_Pos+5]);
+        if(u32_PacketSize>SP_MAX_TOTAL_SIZE)
+        {
+          if(mu16_OverflowErrorCount<0xffff)
+            mu16_OverflowErrorCount++;
+          mu32_Skip = u32_PacketSize;
+          continue;
+        }
+        if(u32_PacketSize<=u32_Remaining)
+        {
+          S_View = SpacePacketView(&mpu8_Data[mu32_Pos], u32_PacketSize);
+          mu32_Pos += u32_PacketSize;
+          return true;
+        }
+      }
+
+      // the packet continues in the next fed data: complete the header first, then the packet
+      if(mu32_Buffered<SP_HEADER_SIZE)
+      {
+        u32_Copy = SP_HEADER_SIZE-mu32_Buffered;
+        if(u32_Copy>u32_Remaining)
+          u32_Copy = u32_Remaining;
+        memcpy(&mau8_Buffer[mu32_Buffered], &mpu8_Data[mu32_Pos], u32_Copy);
+        mu32_Buffered += u32_Copy;
+        mu32_Pos += u32_Copy;
+        if(mu32_Buffered<SP_HEADER_SIZE)
+          return false;
+      }
+
+      u32_PacketSize = SP_HEADER_SIZE+1UL+(((uint32_t)mau8_Buffer[4]<<8) | mau8_Buffer[5]);
+      if(u32_PacketSize>SP_MAX_TOTAL_SIZE)
+      {
+        if(mu16_OverflowErrorCount<0xffff)
+          mu16_OverflowErrorCount++;
+        mu32_Skip = u32_PacketSize-mu32_Buffered;
+        mu32_Buffered = 0;
+        continue;
+      }
+
+      u32_Copy = u32_PacketSize-mu32_Buffered;
+      if(u32_Copy>mu32_DataSize-mu32_Pos)
+        u32_Copy = mu32_DataSize-mu32_Pos;
+      memcpy(&mau8_Buffer[mu32_Buffered], &mpu8_Data[mu32_Pos], u32_Copy);
+      mu32_Buffered += u32_Copy;
+      mu32_Pos += u32_Copy;
+
+      if(mu32_Buffered==u32_PacketSize)
+      {
+        // the buffer is not written before the next call of next()
+        mu32_Buffered = 0;
+        S_View = SpacePacketView(mau8_Buffer, u32_PacketSize);
+        return true;
+      }
+    }
+    return false;
+  }
+
+
+
+  /**
+   * @brief Drops the fed data and a partly received packet
+   */
+  void SpacePacketReader::reset(void)
+  {
+    mpu8_Data = nullptr;
+    mu32_DataSize = 0;
+    mu32_Pos = 0;
+    mu32_Buffered = 0;
+    mu32_Skip = 0;
+  }
+
+
+
+  /**
+   * @brief Returns the number of fed bytes which were not read yet
+   *
+   * @return The number of bytes as uint32_t
+   */
+  uint32_t SpacePacketReader::getRemainingSize(void)
+  {
+    return mu32_DataSize-mu32_Pos;
+  }
+
+
+
+  /**
+   * @brief Returns the number of packets which were skipped because they are larger than SP_MAX_TOTAL_SIZE
+   *
+   * @return The number of errors as uint16_t
+   */
+  uint16_t SpacePacketReader::getOverflowErrorCount(void)
+  {
+    return mu16_OverflowErrorCount;
+  }
+
+
+
+  /**
+   * @brief Resets all error counters
+   */
+  void SpacePacketReader::clearErrorCounters(void)
+  {
+    mu16_OverflowErrorCount = 0;
+  }
+
+
+
+  TransferframeReader::TransferframeReader(uint8_t *pu8_Buffer, const uint16_t u16_BufferSize, const uint16_t u16_PrimaryHdrSize,
+                                           const bool b_SyncMarker)
+    : mpu8_Data{nullptr}
+    , mu32_DataSize{0}
+    , mu32_Pos{0}
+    , mpu8_Buffer{pu8_Buffer}
+    , mu16_BufferSize{u16_BufferSize}
+    , mu16_PrimaryHdrSize{u16_PrimaryHdrSize}
+    , mu16_Buffered{0}
+    , mu8_SyncIndex{0}
+    , mb_SyncMarker{b_SyncMarker}
+    , mu16_ChecksumErrorCount{0}
+    , mu16_OverflowErrorCount{0}
+  {
+  }
+
+
+
+  /**
+   * @brief Sets the data which is read by the following calls of next()
+   *
+   * The data is not copied and must stay valid until all frames were read. The unread data of a
+   * previous call is dropped; a frame which was started in the previous data is continued.
+   *
+   * @param pu8_Data        The received data, searched for the synchronization marker or starting with a frame
+   * @param u32_DataSize    The size of the data
+   */
+  void TransferframeReader::feed(const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    mpu8_Data = pu8_Data;
+    mu32_DataSize = pu8_Data?u32_DataSize:0;
+    mu32_Pos = 0;
+  }
+
+
+
+  /**
+   * @brief Drops the fed data and a partly received frame; the next frame is searched by its synchronization marker
+   *        or, without the marker, expected at the start of the next fed data
+   */
+  void TransferframeReader::reset(void)
+  {
+    mpu8_Data = nullptr;
+    mu32_DataSize = 0;
+    mu32_Pos = 0;
+    mu16_Buffered = 0;
+    mu8_SyncIndex = 0;
+  }
+
+
+
+  /**
+   * @brief Sets whether the frames are preceded by the synchronization marker
+   *
+   * Without the marker, the fed data must start with a frame and the frames must follow each other directly.
+   * A partly received frame is dropped.
+   *
+   * @param b_SyncMarker    true if the marker 0x1ACFFC1D is searched before each frame
+   */
+  void TransferframeReader::setSyncMarker(const bool b_SyncMarker)
+  {
+    mb_SyncMarker = b_SyncMarker;
+    mu16_Buffered = 0;
+    mu8_SyncIndex = 0;
+  }
+
+
+
+  /**
+   * @brief Returns the number of frames with a wrong Frame Error Control Field (FECF)
+   *
+   * @return The number of errors as uint16_t
+   */
+  uint16_t TransferframeReader::getChecksumErrorCount(void)
+  {
+    return mu16_ChecksumErrorCount;
+  }
+
+
+
+  /**
+   * @brief Returns the number of frames which were dropped because of an invalid frame length
+   *
+   * @return The number of errors as uint16_t
+   */
+  uint16_t TransferframeReader::getOverflowErrorCount(void)
+  {
+    return mu16_OverflowErrorCount;
+  }
+
+
+
+  /**
+   * @brief Resets all error counters
+   */
+  void TransferframeReader::clearErrorCounters(void)
+  {
+    mu16_ChecksumErrorCount = 0;
+    mu16_OverflowErrorCount = 0;
+  }
+
+
+
+  const uint8_t *TransferframeReader::_nextFrame(void)
+  {
+    static const uint8_t au8_Sync[SyncSize] = {0x1a, 0xcf, 0xfc, 0x1d};
+    const uint8_t *pu8_Frame;
+    uint32_t u32_Remaining;
+    uint32_t u32_Copy;
+    uint16_t u16_FrameSize;
+
+    while(mu32_Pos<mu32_DataSize)
+    {
+      if(!mb_SyncMarker)
+        mu8_SyncIndex = SyncSize;
+
+      // the marker has no repeating prefix, so a mismatch restarts the search at the current byte
+      while((mu8_SyncIndex<SyncSize) && (mu32_Pos<mu32_DataSize))
+      {
+        if(mpu8_Data[mu32_Pos]==au8_Sync[mu8_SyncIndex])
+          mu8_SyncIndex++;
+        else
+          mu8_SyncIndex = (mpu8_Data[mu32_Pos]==au8_Sync[0])?1:0;
+        mu32_Pos++;
+      }
+      if(mu8_SyncIndex<SyncSize)
+        return nullptr;
+
+      u32_Remaining = mu32_DataSize-mu32_Pos;
+      pu8_Frame = nullptr;
+      u16_FrameSize = 0;
+
+      if(!mu16_Buffered && (u32_Remaining>=mu16_PrimaryHdrSize))
+      {
+        // a frame which is located completely within the fed data is not copied
+        u16_FrameSize = _getFrameSize(&mpu8_Data[mu32_Pos]);
+        if(u16_FrameSize && (u16_FrameSize<=u32_Remaining))
+        {
+          pu8_Frame = &mpu8_Data[mu32_Pos];
+          mu32_Pos += u16_FrameSize;
+        }
+      }
+      else
+      {
+        if(mu16_Buffered<mu16_PrimaryHdrSize)
+        {
+          u32_Copy = mu16_PrimaryHdrSize-mu16_Buffered;
+          if(u32_Copy>u32_Remaining)
+            u32_Copy = u32_Remaining;
+          memcpy(&mpu8_Buffer[mu16_Buffered], &mpu8_Data[mu32_Pos], u32_Copy);
+          mu16_Buffered = (uint16_t)(mu16_Buffered+u32_Copy);
+          mu32_Pos += u32_Copy;
+          if(mu16_Buffered<mu16_PrimaryHdrSize)
+            return nullptr;
+        }
+        u16_FrameSize = _getFrameSize(mpu8_Buffer);
+      }
+
+      if(!u16_FrameSize || (u16_FrameSize>mu16_BufferSize))
+      {
+        if(mu16_OverflowErrorCount<0xffff)
+          mu16_OverflowErrorCount++;
+        mu16_Buffered = 0;
+        mu8_SyncIndex = 0;
+        // without the marker, the start of the next frame is unknown
+        if(!mb_SyncMarker)
+          mu32_Pos = mu32_DataSize;
+        continue;
+      }
+
+      if(!pu8_Frame)
+      {
+        // the frame continues in the next fed data
+        u32_Copy = (uint32_t)(u16_FrameSize-mu16_Buffered);
+        if(u32_Copy>mu32_DataSize-mu32_Pos)
+          u32_Copy = mu32_DataSize-mu32_Pos;
+        memcpy(&mpu8_Buffer[mu16_Buffered], &mpu8_Data[mu32_Pos], u32_Copy);
+        mu16_Buffered = (uint16_t)(mu16_Buffered+u32_Copy);
+        mu32_Pos += u32_Copy;
+        if(mu16_Buffered<u16_FrameSize)
+          return nullptr;
+        pu8_Frame = mpu8_Buffer;
+        mu16_Buffered = 0;
+      }
+
+      mu8_SyncIndex = 0;
+
+#if TF_USE_FECF == 1
+      if(Transferframe::calcCRC(pu8_Frame, (uint16_t)(u16_FrameSize-2))
+         != (uint16_t)((pu8_Frame[u16_FrameSize-2]<<8) | pu8_Frame[u16_FrameSize-1]))
+      {
+        if(mu16_ChecksumErrorCount<0xffff)
+          mu16_ChecksumErrorCount++;
+        continue;
+      }
+#endif
+      return pu8_Frame;
+    }
+    return nullptr;
+  }
+
+
+
+  /**
+   * @brief Construct a new TransferframeTmReader object
+   */
+  TransferframeTmReader::TransferframeTmReader(void)
+    : TransferframeReader(mau8_Buffer, TM_TF_TOTAL_SIZE, 6, true)
+  {
+  }
+
+
+
+  /**
+   * @brief Reads the next valid telemetry transfer frame
+   *
+   * @param S_View    The view which is set to the frame; it is valid until the next call of next() or feed()
+   *
+   * @return true if a frame was read, false if more data has to be fed
+   */
+  bool TransferframeTmReader::next(TransferframeTmView &S_View)
+  {
+    const uint8_t *pu8_Frame = _nextFrame();
+
+    if(!pu8_Frame)
+      return false;
+    S_View = TransferframeTmView(pu8_Frame);
+    return true;
+  }
+
+
+
+  uint16_t TransferframeTmReader::_getFrameSize(const uint8_t *pu8_PrimaryHeader)
+  {
+    (void)pu8_PrimaryHeader;
+    return TM_TF_TOTAL_SIZE;
+  }
+
+
+
+  /**
+   * @brief Construct a new TransferframeTcReader object
+   */
+  TransferframeTcReader::TransferframeTcReader(void)
+    : TransferframeReader(mau8_Buffer, TC_TF_MAX_SIZE, 5, false)
+  {
+  }
+
+
+
+  /**
+   * @brief Reads the next valid telecommand transfer frame
+   *
+   * @param S_View    The view which is set to the frame; it is valid until the next call of next() or feed()
+   *
+   * @return true if a frame was read, false if more data has to be fed
+   */
+  bool TransferframeTcReader::next(TransferframeTcView &S_View)
+  {
+    const uint8_t *pu8_Frame = _nextFrame();
+
+    if(!pu8_Frame)
+      return false;
+    S_View = TransferframeTcView(pu8_Frame);
+    return true;
+  }
+
+
+
+  uint16_t TransferframeTcReader::_getFrameSize(const uint8_t *pu8_PrimaryHeader)
+  {
+    uint16_t u16_FrameSize = (uint16_t)((((pu8_PrimaryHeader[2]&0x03)<<8) | pu8_PrimaryHeader[3])+1);
+
+    // the frame must at least contain the headers, one data byte and the FECF
+    if(u16_FrameSize<5+((configTF_TC_USE_SEG_HDR)?1:0)+1+((TF_USE_FECF)?2:0))
+      return 0;
+    return u16_FrameSize;
+  }
+
+}
@@ -0,0 +1,328 @@
+/**
+ * @file      ccsds_reader.h
+ *
+ * @brief     Include file of the pull based reader and view classes
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_READER_H_
+#define _CCSDS_READER_H_
+
+/****************************************************************/
+/* Pull based parsing of transfer frames and space packets      */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - The transfer frame readers do not support derandomization,*/
+/*    Reed-Solomon decoding and SDLS, since the received data   */
+/*    is not modified; the process() methods of the transfer    */
+/*    frame classes have to be used for these frames            */
+/*  - CLTUs are only decoded by the process() method            */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "ccsds_spacepacket.h"
+#include "ccsds_transferframe.h"
+#include "ccsds_transferframe_tm.h"
+#include "ccsds_transferframe_tc.h"
+
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Iterator which allows to use a reader in a range-based for loop
+   *
+   * Each step calls next() of the reader; the loop ends if the reader has no further element.
+   */
+  template<class Reader, class View>
+  class ReaderIterator
+  {
+  private:
+    Reader *mp_Reader;
+    View mS_View;
+
+  public:
+    ReaderIterator(Reader *p_Reader) : mp_Reader{p_Reader}, mS_View{}
+    {
+      if(mp_Reader && !mp_Reader->next(mS_View))
+        mp_Reader = nullptr;
+    }
+    const View &operator*(void) const { return mS_View; }
+    const View *operator->(void) const { return &mS_View; }
+    ReaderIterator &operator++(void)
+    {
+      if(!mp_Reader->next(mS_View))
+        mp_Reader = nullptr;
+      return *this;
+    }
+    bool operator!=(const ReaderIterator &S_Other) const { return mp_Reader!=S_Other.mp_Reader; }
+  };
+
+
+
+  /**
+   * @brief View of a space packet in a buffer
+   *
+   * The view only holds a pointer to the packet; the header fields are decoded when they are read.
+   */
+  class SpacePacketView
+  {
+  private:
+    const uint8_t *mpu8_Packet;
+    uint32_t mu32_Size;
+
+  public:
+    SpacePacketView(void) : mpu8_Packet{nullptr}, mu32_Size{0} {}
+    SpacePacketView(const uint8_t *pu8_Packet, const uint32_t u32_Size) : mpu8_Packet{pu8_Packet}, mu32_Size{u32_Size} {}
+
+    /** @brief Returns true if the buffer holds exactly one space packet of version 0 */
+    bool isValid(void) const
+    {
+      return mpu8_Packet && (mu32_Size>SP_HEADER_SIZE) && ((mpu8_Packet[0]&0xe0)==0)
+             && (mu32_Size==SP_HEADER_SIZE+1UL+(((uint32_t)mpu8_Packet[4]<<8) | mpu8_Packet[5]));
+    }
+    uint8_t getPacketType(void) const { return (uint8_t)((mpu8_Packet[0]&0x10)>>4); }
+    bool hasSecHeader(void) const { return (mpu8_Packet[0]&0x08)?true:false; }
+    uint16_t getAPID(void) const { return (uint16_t)(((mpu8_Packet[0]&0x07)<<8) | mpu8_Packet[1]); }
+    bool isIdle(void) const { return getAPID()==0x7ff; }
+    uint8_t getSequenceFlags(void) const { return (uint8_t)((mpu8_Packet[2]&0xc0)>>6); }
+    uint16_t getSequenceCount(void) const { return (uint16_t)(((mpu8_Packet[2]&0x3f)<<8) | mpu8_Packet[3]); }
+    const uint8_t *getPacketData(void) const { return &mpu8_Packet[SP_HEADER_SIZE]; }
+    uint32_t getPacketDataLength(void) const { return mu32_Size-SP_HEADER_SIZE; }
+    const uint8_t *getPacket(void) const { return mpu8_Packet; }
+    uint32_t getSize(void) const { return mu32_Size; }
+  };
+
+
+
+  /**
+   * @brief Class for reading space packets from a byte stream without callbacks.
+   *
+   * The data is given with feed(); next() then returns one packet after the other as SpacePacketView.
+   * Packets which are located completely within the fed data are not copied; the view points into the
+   * fed buffer, which must stay valid while the packets are read. Only a packet which continues in the
+   * next fed buffer (for example in the next transfer frame) is assembled in an internal buffer.
+   * A view is valid until the next call of next() or feed().
+   *
+   * @code
+   * reader.feed(pu8_Data, u16_DataSize);
+   * for(const CCSDS::SpacePacketView &S_Packet : reader)
+   *   if(S_Packet.getAPID()==u16_MyAPID)
+   *     handle(S_Packet.getPacketData(), S_Packet.getPacketDataLength());
+   * @endcode
+   */
+  class SpacePacketReader
+  {
+  private:
+    const uint8_t *mpu8_Data;
+    uint32_t mu32_DataSize;
+    uint32_t mu32_Pos;
+
+    uint8_t mau8_Buffer[SP_MAX_TOTAL_SIZE];
+    uint32_t mu32_Buffered;
+    uint32_t mu32_Skip;
+    uint16_t mu16_OverflowErrorCount;
+
+  public:
+    typedef ReaderIterator<SpacePacketReader, SpacePacketView> Iterator;
+
+    SpacePacketReader(void);
+
+    void feed(const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+    bool next(SpacePacketView &S_View);
+    void reset(void);
+    uint32_t getRemainingSize(void);
+
+    Iterator begin(void) { return Iterator(this); }
+    Iterator end(void) { return Iterator(nullptr); }
+
+    uint16_t getOverflowErrorCount(void);
+    void clearErrorCounters(void);
+  };
+
+
+
+  /**
+   * @brief View of a telemetry transfer frame in a buffer; the header fields are decoded when they are read
+   */
+  class TransferframeTmView
+  {
+  private:
+    const static uint8_t PrimaryHdrSize = 6;
+    const static uint8_t OcfSize = 4;
+    const static uint8_t FecfSize = (TF_USE_FECF)?2:0;
+
+    const uint8_t *mpu8_Frame;
+
+  public:
+    TransferframeTmView(void) : mpu8_Frame{nullptr} {}
+    TransferframeTmView(const uint8_t *pu8_Frame) : mpu8_Frame{pu8_Frame} {}
+
+    uint16_t getSpacecraftID(void) const { return (uint16_t)(((mpu8_Frame[0]&0x3f)<<4) | ((mpu8_Frame[1]&0xf0)>>4)); }
+    uint8_t getVirtualChannelID(void) const { return (uint8_t)((mpu8_Frame[1]&0x0e)>>1); }
+    bool hasOCF(void) const { return (TF_USE_OCF) && (mpu8_Frame[1]&0x01); }
+    uint8_t getMasterChannelFrameCount(void) const { return mpu8_Frame[2]; }
+    uint8_t getVirtualChannelFrameCount(void) const { return mpu8_Frame[3]; }
+    bool hasSecHeader(void) const { return (mpu8_Frame[4]&0x80)?true:false; }
+    uint16_t getFirstHdrPtr(void) const { return (uint16_t)(((mpu8_Frame[4]&0x07)<<8) | mpu8_Frame[5]); }
+    const uint8_t *getData(void) const { return &mpu8_Frame[PrimaryHdrSize]; }
+    uint16_t getDataSize(void) const { return (uint16_t)(TM_TF_TOTAL_SIZE-PrimaryHdrSize-(hasOCF()?OcfSize:0)-FecfSize); }
+    uint32_t getOCF(void) const
+    {
+      const uint8_t *pu8_OCF = &mpu8_Frame[TM_TF_TOTAL_SIZE-OcfSize-FecfSize];
+      if(!hasOCF())
+        return 0;
+      return ((uint32_t)pu8_OCF[0]<<24) | ((uint32_t)pu8_OCF[1]<<16) | ((uint32_t)pu8_OCF[2]<<8) | (uint32_t)pu8_OCF[3];
+    }
+    const uint8_t *getFrame(void) const { return mpu8_Frame; }
+    uint16_t getSize(void) const { return TM_TF_TOTAL_SIZE; }
+  };
+
+
+
+  /**
+   * @brief View of a telecommand transfer frame in a buffer; the header fields are decoded when they are read
+   */
+  class TransferframeTcView
+  {
+  private:
+    const static uint8_t PrimaryHdrSize = 5;
+    const static uint8_t SegmentHdrSize = (configTF_TC_USE_SEG_HDR)?1:0;
+    const static uint8_t FecfSize = (TF_USE_FECF)?2:0;
+
+    const uint8_t *mpu8_Frame;
+
+  public:
+    TransferframeTcView(void) : mpu8_Frame{nullptr} {}
+    TransferframeTcView(const uint8_t *pu8_Frame) : mpu8_Frame{pu8_Frame} {}
+
+    bool isBypass(void) const { return (mpu8_Frame[0]&0x20)?true:false; }
+    bool isControlCommand(void) const { return (mpu8_Frame[0]&0x10)?true:false; }
+    uint16_t getSpacecraftID(void) const { return (uint16_t)(((mpu8_Frame[0]&0x03)<<8) | mpu8_Frame[1]); }
+    uint8_t getVirtualChannelID(void) const { return (uint8_t)((mpu8_Frame[2]&0xfc)>>2); }
+    uint8_t getFrameSeqNumber(void) const { return mpu8_Frame[4]; }
+    uint8_t getMAP(void) const { return SegmentHdrSize?(uint8_t)(mpu8_Frame[PrimaryHdrSize]&0x3f):0; }
+    const uint8_t *getData(void) const { return &mpu8_Frame[PrimaryHdrSize+SegmentHdrSize]; }
+    uint16_t getDataSize(void) const { return (uint16_t)(getSize()-PrimaryHdrSize-SegmentHdrSize-FecfSize); }
+    const uint8_t *getFrame(void) const { return mpu8_Frame; }
+    uint16_t getSize(void) const { return (uint16_t)((((mpu8_Frame[2]&0x03)<<8) | mpu8_Frame[3])+1); }
+  };
+
+
+
+  /**
+   * @brief Base class of the transfer frame readers
+   *
+   * The reader searches the synchronization marker (0x1ACFFC1D) in the fed data and returns the frame behind
+   * it if its Frame Error Control Field (FECF) is correct. Frames which are located completely within the fed
+   * data are not copied; a frame which continues in the next fed buffer is assembled in the buffer of the
+   * derived class.
+   *
+   * Without the synchronization marker (see setSyncMarker()), the fed data must start with a frame and each
+   * frame must directly follow the previous one, e.g. the frames decoded from CLTUs. If a frame has an invalid
+   * length, the rest of the fed data is dropped because the start of the next frame is unknown.
+   */
+  class TransferframeReader
+  {
+  protected:
+    const static uint8_t SyncSize = TF_SYNC_SIZE;
+
+    const uint8_t *mpu8_Data;
+    uint32_t mu32_DataSize;
+    uint32_t mu32_Pos;
+
+    uint8_t *mpu8_Buffer;
+    uint16_t mu16_BufferSize;
+    uint16_t mu16_PrimaryHdrSize;
+    uint16_t mu16_Buffered;
+    uint8_t mu8_SyncIndex;
+    bool mb_SyncMarker;
+
+    uint16_t mu16_ChecksumErrorCount;
+    uint16_t mu16_OverflowErrorCount;
+
+  public:
+    void feed(const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+    void reset(void);
+    void setSyncMarker(const bool b_SyncMarker);
+
+    uint16_t getChecksumErrorCount(void);
+    uint16_t getOverflowErrorCount(void);
+    void clearErrorCounters(void);
+
+  protected:
+    TransferframeReader(uint8_t *pu8_Buffer, const uint16_t u16_BufferSize, const uint16_t u16_PrimaryHdrSize,
+                        const bool b_SyncMarker);
+    const uint8_t *_nextFrame(void);
+
+  private:
+    virtual uint16_t _getFrameSize(const uint8_t *pu8_PrimaryHeader) = 0;
+  };
+
+
+
+  /**
+   * @brief Class for reading telemetry transfer frames from a byte stream without callbacks.
+   *
+   * @code
+   * reader.feed(pu8_Data, u32_DataSize);
+   * for(const CCSDS::TransferframeTmView &S_Frame : reader)
+   *   packetReader.feed(S_Frame.getData(), S_Frame.getDataSize());
+   * @endcode
+   */
+  class TransferframeTmReader : public TransferframeReader
+  {
+  private:
+    uint8_t mau8_Buffer[TM_TF_TOTAL_SIZE];
+
+  public:
+    typedef ReaderIterator<TransferframeTmReader, TransferframeTmView> Iterator;
+
+    TransferframeTmReader(void);
+
+    bool next(TransferframeTmView &S_View);
+
+    Iterator begin(void) { return Iterator(this); }
+    Iterator end(void) { return Iterator(nullptr); }
+
+  private:
+    uint16_t _getFrameSize(const uint8_t *pu8_PrimaryHeader);
+  };
+
+
+
+  /**
+   * @brief Class for reading telecommand transfer frames from a byte stream without callbacks.
+   *
+   * Telecommand transfer frames do not come with a synchronization marker, so by default the fed data must
+   * contain the frames back to back, e.g. the data decoded from a CLTU. setSyncMarker() enables the search for
+   * the marker if the frames are sent with one.
+   */
+  class TransferframeTcReader : public TransferframeReader
+  {
+  private:
+    uint8_t mau8_Buffer[TC_TF_MAX_SIZE];
+
+  public:
+    typedef ReaderIterator<TransferframeTcReader, TransferframeTcView> Iterator;
+
+    TransferframeTcReader(void);
+
+    bool next(TransferframeTcView &S_View);
+
+    Iterator begin(void) { return Iterator(this); }
+    Iterator end(void) { return Iterator(nullptr); }
+
+  private:
+    uint16_t _getFrameSize(const uint8_t *pu8_PrimaryHeader);
+  };
+
+}
+
+#endif // _CCSDS_READER_H_
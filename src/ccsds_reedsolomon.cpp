@@ -0,0 +1,694 @@
+/**
+ * @file      ccsds_reedsolomon.cpp
+ *
+ * @brief     Source file of the Reed-Solomon (255,223) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "ccsds_reedsolomon.h"
+
+
+#if TF_RS_MAX_INTERLEAVE > 0
+
+// symbol size 8 bit, field generator F(x) = x^8 + x^7 + x^2 + x + 1
+// code generator g(x) = prod (x - alpha^(11*j)), j = 112..143
+#define RS_NN    255
+#define RS_A0    RS_NN        // log of zero
+#define RS_FCR   112
+#define RS_PRIM  11
+#define RS_IPRIM 116          // RS_PRIM * RS_IPRIM = 1 mod RS_NN
+
+namespace CCSDS
+{
+  // antilog table: alpha^i in conventional representation; index RS_A0 is zero
+  static const uint8_t au8_AlphaTo[256] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x87, 0x89, 0x95, 0xad, 0xdd, 0x3d, 0x7a, 0xf4,
+    0x6f, 0xde, 0x3b, 0x76, 0xec, 0x5f, 0xbe, 0xfb, 0x71, 0xe2, 0x43, 0x86, 0x8b, 0x91, 0xa5, 0xcd,
+    0x1d, 0x3a, 0x74, 0xe8, 0x57, 0xae, 0xdb, 0x31, 0x62, 0xc4, 0x0f, 0x1e, 0x3c, 0x78, 0xf0, 0x67,
+    0xce, 0x1b, 0x36, 0x6c, 0xd8, 0x37, 0x6e, 0xdc, 0x3f, 0x7e, 0xfc, 0x7f, 0xfe, 0x7b, 0xf6, 0x6b,
+    0xd6, 0x2b, 0x56, 0xac, 0xdf, 0x39, 0x72, 0xe4, 0x4f, 0x9e, 0xbb, 0xf1, 0x65, 0xca, 0x13, 0x26,
+    0x4c, 0x98, 0xb7, 0xe9, 0x55, 0xaa, 0xd3, 0x21, 0x42, 0x84, 0x8f, 0x99, 0xb5, 0xed, 0x5d, 0xba,
+    0xf3, 0x61, 0xc2, 0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x07, 0x0e, 0x1c, 0x38, 0x70, 0xe0,
+    0x47, 0x8e, 0x9b, 0xb1, 0xe5, 0x4d, 0x9a, 0xb3, 0xe1, 0x45, 0x8a, 0x93, 0xa1, 0xc5, 0x0d, 0x1a,
+    0x34, 0x68, 0xd0, 0x27, 0x4e, 0x9c, 0xbf, 0xf9, 0x75, 0xea, 0x53, 0xa6, 0xcb, 0x11, 0x22, 0x44,
+    0x88, 0x97, 0xa9, 0xd5, 0x2d, 0x5a, 0xb4, 0xef, 0x59, 0xb2, 0xe3, 0x41, 0x82, 0x83, 0x81, 0x85,
+    0x8d, 0x9d, 0xbd, 0xfd, 0x7d, 0xfa, 0x73, 0xe6, 0x4b, 0x96, 0xab, 0xd1, 0x25, 0x4a, 0x94, 0xaf,
+    0xd9, 0x35, 0x6a, 0xd4, 0x2f, 0x5e, 0xbc, 0xff, 0x79, 0xf2, 0x63, 0xc6, 0x0b, 0x16, 0x2c, 0x58,
+    0xb0, 0xe7, 0x49, 0x92, 0xa3, 0xc1, 0x05, 0x0a, 0x14, 0x28, 0x50, 0xa0, 0xc7, 0x09, 0x12, 0x24,
+    0x48, 0x90, 0xa7, 0xc9, 0x15, 0x2a, 0x54, 0xa8, 0xd7, 0x29, 0x52, 0xa4, 0xcf, 0x19, 0x32, 0x64,
+    0xc8, 0x17, 0x2e, 0x5c, 0xb8, 0xf7, 0x69, 0xd2, 0x23, 0x46, 0x8c, 0x9f, 0xb9, 0xf5, 0x6d, 0xda,
+    0x33, 0x66, 0xcc, 0x1f, 0x3e, 0x7c, 0xf8, 0x77, 0xee, 0x5b, 0xb6, 0xeb, 0x51, 0xa2, 0xc3, 0x00
+  };
+  
+  // log table: log_alpha(i); index 0 is RS_A0
+  static const uint8_t au8_IndexOf[256] = {
+    0xff, 0x00, 0x01, 0x63, 0x02, 0xc6, 0x64, 0x6a, 0x03, 0xcd, 0xc7, 0xbc, 0x65, 0x7e, 0x6b, 0x2a,
+    0x04, 0x8d, 0xce, 0x4e, 0xc8, 0xd4, 0xbd, 0xe1, 0x66, 0xdd, 0x7f, 0x31, 0x6c, 0x20, 0x2b, 0xf3,
+    0x05, 0x57, 0x8e, 0xe8, 0xcf, 0xac, 0x4f, 0x83, 0xc9, 0xd9, 0xd5, 0x41, 0xbe, 0x94, 0xe2, 0xb4,
+    0x67, 0x27, 0xde, 0xf0, 0x80, 0xb1, 0x32, 0x35, 0x6d, 0x45, 0x21, 0x12, 0x2c, 0x0d, 0xf4, 0x38,
+    0x06, 0x9b, 0x58, 0x1a, 0x8f, 0x79, 0xe9, 0x70, 0xd0, 0xc2, 0xad, 0xa8, 0x50, 0x75, 0x84, 0x48,
+    0xca, 0xfc, 0xda, 0x8a, 0xd6, 0x54, 0x42, 0x24, 0xbf, 0x98, 0x95, 0xf9, 0xe3, 0x5e, 0xb5, 0x15,
+    0x68, 0x61, 0x28, 0xba, 0xdf, 0x4c, 0xf1, 0x2f, 0x81, 0xe6, 0xb2, 0x3f, 0x33, 0xee, 0x36, 0x10,
+    0x6e, 0x18, 0x46, 0xa6, 0x22, 0x88, 0x13, 0xf7, 0x2d, 0xb8, 0x0e, 0x3d, 0xf5, 0xa4, 0x39, 0x3b,
+    0x07, 0x9e, 0x9c, 0x9d, 0x59, 0x9f, 0x1b, 0x08, 0x90, 0x09, 0x7a, 0x1c, 0xea, 0xa0, 0x71, 0x5a,
+    0xd1, 0x1d, 0xc3, 0x7b, 0xae, 0x0a, 0xa9, 0x91, 0x51, 0x5b, 0x76, 0x72, 0x85, 0xa1, 0x49, 0xeb,
+    0xcb, 0x7c, 0xfd, 0xc4, 0xdb, 0x1e, 0x8b, 0xd2, 0xd7, 0x92, 0x55, 0xaa, 0x43, 0x0b, 0x25, 0xaf,
+    0xc0, 0x73, 0x99, 0x77, 0x96, 0x5c, 0xfa, 0x52, 0xe4, 0xec, 0x5f, 0x4a, 0xb6, 0xa2, 0x16, 0x86,
+    0x69, 0xc5, 0x62, 0xfe, 0x29, 0x7d, 0xbb, 0xcc, 0xe0, 0xd3, 0x4d, 0x8c, 0xf2, 0x1f, 0x30, 0xdc,
+    0x82, 0xab, 0xe7, 0x56, 0xb3, 0x93, 0x40, 0xd8, 0x34, 0xb0, 0xef, 0x26, 0x37, 0x0c, 0x11, 0x44,
+    0x6f, 0x78, 0x19, 0x9a, 0x47, 0x74, 0xa7, 0xc1, 0x23, 0x53, 0x89, 0xfb, 0x14, 0x5d, 0xf8, 0x97,
+    0x2e, 0x4b, 0xb9, 0x60, 0x0f, 0xed, 0x3e, 0xe5, 0xf6, 0x87, 0xa5, 0x17, 0x3a, 0xa3, 0x3c, 0xb7
+  };
+  
+  // products of the code generator polynomial coefficients with alpha^i (i = log of the encoder feedback),
+  // packed as the encoder register (four symbols per word, first symbol in the upper byte); row RS_A0 is zero
+  static const uint32_t aau32_GenPolyProduct[256][ReedSolomon::ParitySize/4] = {
+    { 0x5b7f5610, 0x1e0deb61, 0xa5082a36, 0x56ab2071, 0x20ab5636, 0x2a08a561, 0xeb0d1e10, 0x567f5b01 },
+    { 0xb6feac20, 0x3c1a51c2, 0xcd10546c, 0xacd140e2, 0x40d1ac6c, 0x5410cdc2, 0x511a3c20, 0xacfeb602 },
+    { 0xeb7bdf40, 0x7834a203, 0x1d20a8d8, 0xdf258043, 0x8025dfd8, 0xa8201d03, 0xa2347840, 0xdf7beb04 },
+    { 0x51f63980, 0xf068c306, 0x3a40d737, 0x394a8786, 0x874a3937, 0xd7403a06, 0xc368f080, 0x39f65108 },
+    { 0xa26b7287, 0x67d0010c, 0x7480296e, 0x7294898b, 0x8994726e, 0x2980740c, 0x01d06787, 0x726ba210 },
+    { 0xc3d6e489, 0xce270218, 0xe88752dc, 0xe4af9591, 0x95afe4dc, 0x5287e818, 0x0227ce89, 0xe4d6c320 },
+    { 0x012b4f95, 0x1b4e0430, 0x5789a43f, 0x4fd9ada5, 0xadd94f3f, 0xa4895730, 0x044e1b95, 0x4f2b0140 },
+    { 0x02569ead, 0x369c0860, 0xae95cf7e, 0x9e35ddcd, 0xdd359e7e, 0xcf95ae60, 0x089c36ad, 0x9e560280 },
+    { 0x04acbbdd, 0x6cbf10c0, 0xdbad19fc, 0xbb6a3d1d, 0x3d6abbfc, 0x19addbc0, 0x10bf6cdd, 0xbbac0487 },
+    { 0x08dff13d, 0xd8f92007, 0x31dd327f, 0xf1d47a3a, 0x7ad4f17f, 0x32dd3107, 0x20f9d83d, 0xf1df0889 },
+    { 0x1039657a, 0x3775400e, 0x623d64fe, 0x652ff474, 0xf42f65fe, 0x643d620e, 0x4075377a, 0x65391095 },
+    { 0x2072caf4, 0x6eea801c, 0xc47ac87b, 0xca5e6fe8, 0x6f5eca7b, 0xc87ac41c, 0x80ea6ef4, 0xca7220ad },
+    { 0x40e4136f, 0xdc538738, 0x0ff417f6, 0x13bcde57, 0xdebc13f6, 0x17f40f38, 0x8753dc6f, 0x13e440dd },
+    { 0x804f26de, 0x3fa68970, 0x1e6f2e6b, 0x26ff3bae, 0x3bff266b, 0x2e6f1e70, 0x89a63fde, 0x264f803d },
+    { 0x879e4c3b, 0x7ecb95e0, 0x3cde5cd6, 0x4c7976db, 0x76794cd6, 0x5cde3ce0, 0x95cb7e3b, 0x4c9e877a },
+    { 0x89bb9876, 0xfc11ad47, 0x783bb82b, 0x98f2ec31, 0xecf2982b, 0xb83b7847, 0xad11fc76, 0x98bb89f4 },
+    { 0x95f1b7ec, 0x7f22dd8e, 0xf076f756, 0xb7635f62, 0x5f63b756, 0xf776f08e, 0xdd227fec, 0xb7f1956f },
+    { 0xad65e95f, 0xfe443d9b, 0x67ec69ac, 0xe9c6bec4, 0xbec6e9ac, 0x69ec679b, 0x3d44fe5f, 0xe965adde },
+    { 0xddca55be, 0x7b887ab1, 0xce5fd2df, 0x550bfb0f, 0xfb0b55df, 0xd25fceb1, 0x7a887bbe, 0x55cadd3b },
+    { 0x3d13aafb, 0xf697f4e5, 0x1bbe2339, 0xaa16711e, 0x7116aa39, 0x23be1be5, 0xf497f6fb, 0xaa133d76 },
+    { 0x7a26d371, 0x6ba96f4d, 0x36fb4672, 0xd32ce23c, 0xe22cd372, 0x46fb364d, 0x6fa96b71, 0xd3267aec },
+    { 0xf44c21e2, 0xd6d5de9a, 0x6c718ce4, 0x21584378, 0x435821e4, 0x8c716c9a, 0xded5d6e2, 0x214cf45f },
+    { 0x6f984243, 0x2b2d3bb3, 0xd8e29f4f, 0x42b086f0, 0x86b0424f, 0x9fe2d8b3, 0x3b2d2b43, 0x42986fbe },
+    { 0xdeb78486, 0x565a76e1, 0x3743b99e, 0x84e78b67, 0x8be7849e, 0xb94337e1, 0x765a5686, 0x84b7defb },
+    { 0x3be98f8b, 0xacb4ec45, 0x6e86f5bb, 0x8f4991ce, 0x91498fbb, 0xf5866e45, 0xecb4ac8b, 0x8fe93b71 },
+    { 0x76559991, 0xdfef5f8a, 0xdc8b6df1, 0x9992a51b, 0xa59299f1, 0x6d8bdc8a, 0x5fefdf91, 0x995576e2 },
+    { 0xecaab5a5, 0x3959be93, 0x3f91da65, 0xb5a3cd36, 0xcda3b565, 0xda913f93, 0xbe5939a5, 0xb5aaec43 },
+    { 0x5fd3edcd, 0x72b2fba1, 0x7ea533ca, 0xedc11d6c, 0x1dc1edca, 0x33a57ea1, 0xfbb272cd, 0xedd35f86 },
+    { 0xbe215d1d, 0xe4e371c5, 0xfccd6613, 0x5d053ad8, 0x3a055d13, 0x66cdfcc5, 0x71e3e41d, 0x5d21be8b },
+    { 0xfb42ba3a, 0x4f41e20d, 0x7f1dcc26, 0xba0a7437, 0x740aba26, 0xcc1d7f0d, 0xe2414f3a, 0xba42fb91 },
+    { 0x7184f374, 0x9e82431a, 0xfe3a1f4c, 0xf314e86e, 0xe814f34c, 0x1f3afe1a, 0x43829e74, 0xf38471a5 },
+    { 0xe28f61e8, 0xbb838634, 0x7b743e98, 0x612857dc, 0x57286198, 0x3e747b34, 0x8683bbe8, 0x618fe2cd },
+    { 0x4399c257, 0xf1818b68, 0xf6e87cb7, 0xc250ae3f, 0xae50c2b7, 0x7ce8f668, 0x8b81f157, 0xc299431d },
+    { 0x86b503ae, 0x658591d0, 0x6b57f8e9, 0x03a0db7e, 0xdba003e9, 0xf8576bd0, 0x918565ae, 0x03b5863a },
+    { 0x8bed06db, 0xca8da527, 0xd6ae7755, 0x06c731fc, 0x31c70655, 0x77aed627, 0xa58dcadb, 0x06ed8b74 },
+    { 0x915d0c31, 0x139dcd4e, 0x2bdbeeaa, 0x0c09627f, 0x62090caa, 0xeedb2b4e, 0xcd9d1331, 0x0c5d91e8 },
+    { 0xa5ba1862, 0x26bd1d9c, 0x56315bd3, 0x1812c4fe, 0xc41218d3, 0x5b31569c, 0x1dbd2662, 0x18baa557 },
+    { 0xcdf330c4, 0x4cfd3abf, 0xac62b621, 0x30240f7b, 0x0f243021, 0xb662acbf, 0x3afd4cc4, 0x30f3cdae },
+    { 0x1d61600f, 0x987d74f9, 0xdfc4eb42, 0x60481ef6, 0x1e486042, 0xebc4dff9, 0x747d980f, 0x60611ddb },
+    { 0x3ac2c01e, 0xb7fae875, 0x390f5184, 0xc0903c6b, 0x3c90c084, 0x510f3975, 0xe8fab71e, 0xc0c23a31 },
+    { 0x7403073c, 0xe97357ea, 0x721ea28f, 0x07a778d6, 0x78a7078f, 0xa21e72ea, 0x5773e93c, 0x07037462 },
+    { 0xe8060e78, 0x55e6ae53, 0xe43cc399, 0x0ec9f02b, 0xf0c90e99, 0xc33ce453, 0xaee65578, 0x0e06e8c4 },
+    { 0x570c1cf0, 0xaa4bdba6, 0x4f7801b5, 0x1c156756, 0x67151cb5, 0x01784fa6, 0xdb4baaf0, 0x1c0c570f },
+    { 0xae183867, 0xd39631cb, 0x9ef002ed, 0x382aceac, 0xce2a38ed, 0x02f09ecb, 0x3196d367, 0x3818ae1e },
+    { 0xdb3070ce, 0x21ab6211, 0xbb67045d, 0x70541bdf, 0x1b54705d, 0x0467bb11, 0x62ab21ce, 0x7030db3c },
+    { 0x3160e01b, 0x42d1c422, 0xf1ce08ba, 0xe0a83639, 0x36a8e0ba, 0x08cef122, 0xc4d1421b, 0xe0603178 },
+    { 0x62c04736, 0x84250f44, 0x651b10f3, 0x47d76c72, 0x6cd747f3, 0x101b6544, 0x0f258436, 0x47c062f0 },
+    { 0xc4078e6c, 0x8f4a1e88, 0xca362061, 0x8e29d8e4, 0xd8298e61, 0x2036ca88, 0x1e4a8f6c, 0x8e07c467 },
+    { 0x0f0e9bd8, 0x99943c97, 0x136c40c2, 0x9b52374f, 0x37529bc2, 0x406c1397, 0x3c9499d8, 0x9b0e0fce },
+    { 0x1e1cb137, 0xb5af78a9, 0x26d88003, 0xb1a46e9e, 0x6ea4b103, 0x80d826a9, 0x78afb537, 0xb11c1e1b },
+    { 0x3c38e56e, 0xedd9f0d5, 0x4c378706, 0xe5cfdcbb, 0xdccfe506, 0x87374cd5, 0xf0d9ed6e, 0xe5383c36 },
+    { 0x78704ddc, 0x5d35672d, 0x986e890c, 0x4d193ff1, 0x3f194d0c, 0x896e982d, 0x67355ddc, 0x4d70786c },
+    { 0xf0e09a3f, 0xba6ace5a, 0xb7dc9518, 0x9a327e65, 0x7e329a18, 0x95dcb75a, 0xce6aba3f, 0x9ae0f0d8 },
+    { 0x6747b37e, 0xf3d41bb4, 0xe93fad30, 0xb364fcca, 0xfc64b330, 0xad3fe9b4, 0x1bd4f37e, 0xb3476737 },
+    { 0xce8ee1fc, 0x612f36ef, 0x557edd60, 0xe1c87f13, 0x7fc8e160, 0xdd7e55ef, 0x362f61fc, 0xe18ece6e },
+    { 0x1b9b457f, 0xc25e6c59, 0xaafc3dc0, 0x4517fe26, 0xfe1745c0, 0x3dfcaa59, 0x6c5ec27f, 0x459b1bdc },
+    { 0x36b18afe, 0x03bcd8b2, 0xd37f7a07, 0x8a2e7b4c, 0x7b2e8a07, 0x7a7fd3b2, 0xd8bc03fe, 0x8ab1363f },
+    { 0x6ce5937b, 0x06ff37e3, 0x21fef40e, 0x935cf698, 0xf65c930e, 0xf4fe21e3, 0x37ff067b, 0x93e56c7e },
+    { 0xd84da1f6, 0x0c796e41, 0x427b6f1c, 0xa1b86bb7, 0x6bb8a11c, 0x6f7b4241, 0x6e790cf6, 0xa14dd8fc },
+    { 0x379ac56b, 0x18f2dc82, 0x84f6de38, 0xc5f7d6e9, 0xd6f7c538, 0xdef68482, 0xdcf2186b, 0xc59a377f },
+    { 0x6eb30dd6, 0x30633f83, 0x8f6b3b70, 0x0d692b55, 0x2b690d70, 0x3b6b8f83, 0x3f6330d6, 0x0db36efe },
+    { 0xdce11a2b, 0x60c67e81, 0x99d676e0, 0x1ad256aa, 0x56d21ae0, 0x76d69981, 0x7ec6602b, 0x1ae1dc7b },
+    { 0x3f453456, 0xc00bfc85, 0xb52bec47, 0x3423acd3, 0xac233447, 0xec2bb585, 0xfc0bc056, 0x34453ff6 },
+    { 0x7e8a68ac, 0x07167f8d, 0xed565f8e, 0x6846df21, 0xdf46688e, 0x5f56ed8d, 0x7f1607ac, 0x688a7e6b },
+    { 0xfc93d0df, 0x0e2cfe9d, 0x5dacbe9b, 0xd08c3942, 0x398cd09b, 0xbeac5d9d, 0xfe2c0edf, 0xd093fcd6 },
+    { 0x7fa12739, 0x1c587bbd, 0xbadffbb1, 0x279f7284, 0x729f27b1, 0xfbdfbabd, 0x7b581c39, 0x27a17f2b },
+    { 0xfec54e72, 0x38b0f6fd, 0xf33971e5, 0x4eb9e48f, 0xe4b94ee5, 0x7139f3fd, 0xf6b03872, 0x4ec5fe56 },
+    { 0x7b0d9ce4, 0x70e76b7d, 0x6172e24d, 0x9cf54f99, 0x4ff59c4d, 0xe272617d, 0x6be770e4, 0x9c0d7bac },
+    { 0xf61abf4f, 0xe049d6fa, 0xc2e4439a, 0xbf6d9eb5, 0x9e6dbf9a, 0x43e4c2fa, 0xd649e04f, 0xbf1af6df },
+    { 0x6b34f99e, 0x47922b73, 0x034f86b3, 0xf9dabbed, 0xbbdaf9b3, 0x864f0373, 0x2b92479e, 0xf9346b39 },
+    { 0xd66875bb, 0x8ea356e6, 0x069e8be1, 0x7533f15d, 0xf13375e1, 0x8b9e06e6, 0x56a38ebb, 0x7568d672 },
+    { 0x2bd0eaf1, 0x9bc1ac4b, 0x0cbb9145, 0xea6665ba, 0x6566ea45, 0x91bb0c4b, 0xacc19bf1, 0xead02be4 },
+    { 0x56275365, 0xb105df96, 0x18f1a58a, 0x53cccaf3, 0xcacc538a, 0xa5f11896, 0xdf05b165, 0x5327564f },
+    { 0xac4ea6ca, 0xe50a39ab, 0x3065cd93, 0xa61f1361, 0x131fa693, 0xcd6530ab, 0x390ae5ca, 0xa64eac9e },
+    { 0xdf9ccb13, 0x4d1472d1, 0x60ca1da1, 0xcb3e26c2, 0x263ecba1, 0x1dca60d1, 0x72144d13, 0xcb9cdfbb },
+    { 0x39bf1126, 0x9a28e425, 0xc0133ac5, 0x117c4c03, 0x4c7c11c5, 0x3a13c025, 0xe4289a26, 0x11bf39f1 },
+    { 0x72f9224c, 0xb3504f4a, 0x0726740d, 0x22f89806, 0x98f8220d, 0x7426074a, 0x4f50b34c, 0x22f97265 },
+    { 0xe4754498, 0xe1a09e94, 0x0e4ce81a, 0x4477b70c, 0xb777441a, 0xe84c0e94, 0x9ea0e198, 0x4475e4ca },
+    { 0x4fea88b7, 0x45c7bbaf, 0x1c985734, 0x88eee918, 0xe9ee8834, 0x57981caf, 0xbbc745b7, 0x88ea4f13 },
+    { 0x9e5397e9, 0x8a09f1d9, 0x38b7ae68, 0x975b5530, 0x555b9768, 0xaeb738d9, 0xf1098ae9, 0x97539e26 },
+    { 0xbba6a955, 0x93126535, 0x70e9dbd0, 0xa9b6aa60, 0xaab6a9d0, 0xdbe97035, 0x65129355, 0xa9a6bb4c },
+    { 0xf1cbd5aa, 0xa124ca6a, 0xe0553127, 0xd5ebd3c0, 0xd3ebd527, 0x3155e06a, 0xca24a1aa, 0xd5cbf198 },
+    { 0x65112dd3, 0xc54813d4, 0x47aa624e, 0x2d512107, 0x21512d4e, 0x62aa47d4, 0x1348c5d3, 0x2d1165b7 },
+    { 0xca225a21, 0x0d90262f, 0x8ed3c49c, 0x5aa2420e, 0x42a25a9c, 0xc4d38e2f, 0x26900d21, 0x5a22cae9 },
+    { 0x1344b442, 0x1aa74c5e, 0x9b210fbf, 0xb4c3841c, 0x84c3b4bf, 0x0f219b5e, 0x4ca71a42, 0xb4441355 },
+    { 0x2688ef84, 0x34c998bc, 0xb1421ef9, 0xef018f38, 0x8f01eff9, 0x1e42b1bc, 0x98c93484, 0xef8826aa },
+    { 0x4c97598f, 0x6815b7ff, 0xe5843c75, 0x59029970, 0x99025975, 0x3c84e5ff, 0xb715688f, 0x59974cd3 },
+    { 0x98a9b299, 0xd02ae979, 0x4d8f78ea, 0xb204b5e0, 0xb504b2ea, 0x788f4d79, 0xe92ad099, 0xb2a99821 },
+    { 0xb7d5e3b5, 0x275455f2, 0x9a99f053, 0xe308ed47, 0xed08e353, 0xf0999af2, 0x555427b5, 0xe3d5b742 },
+    { 0xe92d41ed, 0x4ea8aa63, 0xb3b567a6, 0x41105d8e, 0x5d1041a6, 0x67b5b363, 0xaaa84eed, 0x412de984 },
+    { 0x555a825d, 0x9cd7d3c6, 0xe1edcecb, 0x8220ba9b, 0xba2082cb, 0xceede1c6, 0xd3d79c5d, 0x825a558f },
+    { 0xaab483ba, 0xbf29210b, 0x455d1b11, 0x8340f3b1, 0xf3408311, 0x1b5d450b, 0x2129bfba, 0x83b4aa99 },
+    { 0xd3ef81f3, 0xf9524216, 0x8aba3622, 0x818061e5, 0x61808122, 0x36ba8a16, 0x4252f9f3, 0x81efd3b5 },
+    { 0x21598561, 0x75a4842c, 0x93f36c44, 0x8587c24d, 0xc2878544, 0x6cf3932c, 0x84a47561, 0x855921ed },
+    { 0x42b28dc2, 0xeacf8f58, 0xa161d888, 0x8d89039a, 0x03898d88, 0xd861a158, 0x8fcfeac2, 0x8db2425d },
+    { 0x84e39d03, 0x531999b0, 0xc5c23797, 0x9d9506b3, 0x06959d97, 0x37c2c5b0, 0x99195303, 0x9de384ba },
+    { 0x8f41bd06, 0xa632b5e7, 0x0d036ea9, 0xbdad0ce1, 0x0cadbda9, 0x6e030de7, 0xb532a606, 0xbd418ff3 },
+    { 0x9982fd0c, 0xcb64ed49, 0x1a06dcd5, 0xfddd1845, 0x18ddfdd5, 0xdc061a49, 0xed64cb0c, 0xfd829961 },
+    { 0xb5837d18, 0x11c85d92, 0x340c3f2d, 0x7d3d308a, 0x303d7d2d, 0x3f0c3492, 0x5dc81118, 0x7d83b5c2 },
+    { 0xed81fa30, 0x2217baa3, 0x68187e5a, 0xfa7a6093, 0x607afa5a, 0x7e1868a3, 0xba172230, 0xfa81ed03 },
+    { 0x5d857360, 0x442ef3c1, 0xd030fcb4, 0x73f4c0a1, 0xc0f473b4, 0xfc30d0c1, 0xf32e4460, 0x73855d06 },
+    { 0xba8de6c0, 0x885c6105, 0x27607fef, 0xe66f07c5, 0x076fe6ef, 0x7f602705, 0x615c88c0, 0xe68dba0c },
+    { 0xf39d4b07, 0x97b8c20a, 0x4ec0fe59, 0x4bde0e0d, 0x0ede4b59, 0xfec04e0a, 0xc2b89707, 0x4b9df318 },
+    { 0x61bd960e, 0xa9f70314, 0x9c077bb2, 0x963b1c1a, 0x1c3b96b2, 0x7b079c14, 0x03f7a90e, 0x96bd6130 },
+    { 0xc2fdab1c, 0xd5690628, 0xbf0ef6e3, 0xab763834, 0x3876abe3, 0xf60ebf28, 0x0669d51c, 0xabfdc260 },
+    { 0x037dd138, 0x2dd20c50, 0xf91c6b41, 0xd1ec7068, 0x70ecd141, 0x6b1cf950, 0x0cd22d38, 0xd17d03c0 },
+    { 0x06fa2570, 0x5a2318a0, 0x7538d682, 0x255fe0d0, 0xe05f2582, 0xd63875a0, 0x18235a70, 0x25fa0607 },
+    { 0x0c734ae0, 0xb44630c7, 0xea702b83, 0x4abe4727, 0x47be4a83, 0x2b70eac7, 0x3046b4e0, 0x4a730c0e },
+    { 0x18e69447, 0xef8c6009, 0x53e05681, 0x94fb8e4e, 0x8efb9481, 0x56e05309, 0x608cef47, 0x94e6181c },
+    { 0x304baf8e, 0x599fc012, 0xa647ac85, 0xaf719b9c, 0x9b71af85, 0xac47a612, 0xc09f598e, 0xaf4b3038 },
+    { 0x6096d99b, 0xb2b90724, 0xcb8edf8d, 0xd9e2b1bf, 0xb1e2d98d, 0xdf8ecb24, 0x07b9b29b, 0xd9966070 },
+    { 0xc0ab35b1, 0xe3f50e48, 0x119b399d, 0x3543e5f9, 0xe543359d, 0x399b1148, 0x0ef5e3b1, 0x35abc0e0 },
+    { 0x07d16ae5, 0x416d1c90, 0x22b172bd, 0x6a864d75, 0x4d866abd, 0x72b12290, 0x1c6d41e5, 0x6ad10747 },
+    { 0x0e25d44d, 0x82da38a7, 0x44e5e4fd, 0xd48b9aea, 0x9a8bd4fd, 0xe4e544a7, 0x38da824d, 0xd4250e8e },
+    { 0x1c4a2f9a, 0x833370c9, 0x884d4f7d, 0x2f91b353, 0xb3912f7d, 0x4f4d88c9, 0x7033839a, 0x2f4a1c9b },
+    { 0x38945eb3, 0x8166e015, 0x979a9efa, 0x5ea5e1a6, 0xe1a55efa, 0x9e9a9715, 0xe06681b3, 0x5e9438b1 },
+    { 0x70afbce1, 0x85cc472a, 0xa9b3bb73, 0xbccd45cb, 0x45cdbc73, 0xbbb3a92a, 0x47cc85e1, 0xbcaf70e5 },
+    { 0xe0d9ff45, 0x8d1f8e54, 0xd5e1f1e6, 0xff1d8a11, 0x8a1dffe6, 0xf1e1d554, 0x8e1f8d45, 0xffd9e04d },
+    { 0x4735798a, 0x9d3e9ba8, 0x2d45654b, 0x793a9322, 0x933a794b, 0x65452da8, 0x9b3e9d8a, 0x7935479a },
+    { 0x8e6af293, 0xbd7cb1d7, 0x5a8aca96, 0xf274a144, 0xa174f296, 0xca8a5ad7, 0xb17cbd93, 0xf26a8eb3 },
+    { 0x9bd463a1, 0xfdf8e529, 0xb49313ab, 0x63e8c588, 0xc5e863ab, 0x1393b429, 0xe5f8fda1, 0x63d49be1 },
+    { 0xb12fc6c5, 0x7d774d52, 0xefa126d1, 0xc6570d97, 0x0d57c6d1, 0x26a1ef52, 0x4d777dc5, 0xc62fb145 },
+    { 0xe55e0b0d, 0xfaee9aa4, 0x59c54c25, 0x0bae1aa9, 0x1aae0b25, 0x4cc559a4, 0x9aeefa0d, 0x0b5ee58a },
+    { 0x4dbc161a, 0x735bb3cf, 0xb20d984a, 0x16db34d5, 0x34db164a, 0x980db2cf, 0xb35b731a, 0x16bc4d93 },
+    { 0x9aff2c34, 0xe6b6e119, 0xe31ab794, 0x2c31682d, 0x68312c94, 0xb71ae319, 0xe1b6e634, 0x2cff9aa1 },
+    { 0xb3795868, 0x4beb4532, 0x4134e9af, 0x5862d05a, 0xd06258af, 0xe9344132, 0x45eb4b68, 0x5879b3c5 },
+    { 0xe1f2b0d0, 0x96518a64, 0x826855d9, 0xb0c427b4, 0x27c4b0d9, 0x55688264, 0x8a5196d0, 0xb0f2e10d },
+    { 0x4563e727, 0xaba293c8, 0x83d0aa35, 0xe70f4eef, 0x4e0fe735, 0xaad083c8, 0x93a2ab27, 0xe763451a },
+    { 0x8ac6494e, 0xd1c3a117, 0x8127d36a, 0x491e9c59, 0x9c1e496a, 0xd3278117, 0xa1c3d14e, 0x49c68a34 },
+    { 0x930b929c, 0x2501c52e, 0x854e21d4, 0x923cbfb2, 0xbf3c92d4, 0x214e852e, 0xc501259c, 0x920b9368 },
+    { 0xa116a3bf, 0x4a020d5c, 0x8d9c422f, 0xa378f9e3, 0xf978a32f, 0x429c8d5c, 0x0d024abf, 0xa316a1d0 },
+    { 0xc52cc1f9, 0x94041ab8, 0x9dbf845e, 0xc1f07541, 0x75f0c15e, 0x84bf9db8, 0x1a0494f9, 0xc12cc527 },
+    { 0x0d580575, 0xaf0834f7, 0xbdf98fbc, 0x0567ea82, 0xea6705bc, 0x8ff9bdf7, 0x3408af75, 0x05580d4e },
+    { 0x1ab00aea, 0xd9106869, 0xfd7599ff, 0x0ace5383, 0x53ce0aff, 0x9975fd69, 0x6810d9ea, 0x0ab01a9c },
+    { 0x34e71453, 0x3520d0d2, 0x7deab579, 0x141ba681, 0xa61b1479, 0xb5ea7dd2, 0xd0203553, 0x14e734bf },
+    { 0x684928a6, 0x6a402723, 0xfa53edf2, 0x2836cb85, 0xcb3628f2, 0xed53fa23, 0x27406aa6, 0x284968f9 },
+    { 0xd09250cb, 0xd4804e46, 0x73a65d63, 0x506c118d, 0x116c5063, 0x5da67346, 0x4e80d4cb, 0x5092d075 },
+    { 0x27a3a011, 0x2f879c8c, 0xe6cbbac6, 0xa0d8229d, 0x22d8a0c6, 0xbacbe68c, 0x9c872f11, 0xa0a327ea },
+    { 0x4ec1c722, 0x5e89bf9f, 0x4b11f30b, 0xc73744bd, 0x4437c70b, 0xf3114b9f, 0xbf895e22, 0xc7c14e53 },
+    { 0x9c050944, 0xbc95f9b9, 0x96226116, 0x096e88fd, 0x886e0916, 0x612296b9, 0xf995bc44, 0x09059ca6 },
+    { 0xbf0a1288, 0xffad75f5, 0xab44c22c, 0x12dc977d, 0x97dc122c, 0xc244abf5, 0x75adff88, 0x120abfcb },
+    { 0xf9142497, 0x79ddea6d, 0xd1880358, 0x243fa9fa, 0xa93f2458, 0x0388d16d, 0xeadd7997, 0x2414f911 },
+    { 0x752848a9, 0xf23d53da, 0x259706b0, 0x487ed573, 0xd57e48b0, 0x069725da, 0x533df2a9, 0x48287522 },
+    { 0xea5090d5, 0x637aa633, 0x4aa90ce7, 0x90fc2de6, 0x2dfc90e7, 0x0ca94a33, 0xa67a63d5, 0x9050ea44 },
+    { 0x53a0a72d, 0xc6f4cb66, 0x94d51849, 0xa77f5a4b, 0x5a7fa749, 0x18d59466, 0xcbf4c62d, 0xa7a05388 },
+    { 0xa6c7c95a, 0x0b6f11cc, 0xaf2d3092, 0xc9feb496, 0xb4fec992, 0x302dafcc, 0x116f0b5a, 0xc9c7a697 },
+    { 0xcb0915b4, 0x16de221f, 0xd95a60a3, 0x157befab, 0xef7b15a3, 0x605ad91f, 0x22de16b4, 0x1509cba9 },
+    { 0x11122aef, 0x2c3b443e, 0x35b4c0c1, 0x2af659d1, 0x59f62ac1, 0xc0b4353e, 0x443b2cef, 0x2a1211d5 },
+    { 0x22245459, 0x5876887c, 0x6aef0705, 0x546bb225, 0xb26b5405, 0x07ef6a7c, 0x88765859, 0x5424222d },
+    { 0x4448a8b2, 0xb0ec97f8, 0xd4590e0a, 0xa8d6e34a, 0xe3d6a80a, 0x0e59d4f8, 0x97ecb0b2, 0xa848445a },
+    { 0x8890d7e3, 0xe75fa977, 0x2fb21c14, 0xd72b4194, 0x412bd714, 0x1cb22f77, 0xa95fe7e3, 0xd79088b4 },
+    { 0x97a72941, 0x49bed5ee, 0x5ee33828, 0x295682af, 0x82562928, 0x38e35eee, 0xd5be4941, 0x29a797ef },
+    { 0xa9c95282, 0x92fb2d5b, 0xbc417050, 0x52ac83d9, 0x83ac5250, 0x7041bc5b, 0x2dfb9282, 0x52c9a959 },
+    { 0xd515a483, 0xa3715ab6, 0xff82e0a0, 0xa4df8135, 0x81dfa4a0, 0xe082ffb6, 0x5a71a383, 0xa415d5b2 },
+    { 0x2d2acf81, 0xc1e2b4eb, 0x798347c7, 0xcf39856a, 0x8539cfc7, 0x478379eb, 0xb4e2c181, 0xcf2a2de3 },
+    { 0x5a541985, 0x0543ef51, 0xf2818e09, 0x19728dd4, 0x8d721909, 0x8e81f251, 0xef430585, 0x19545a41 },
+    { 0xb4a8328d, 0x0a8659a2, 0x63859b12, 0x32e49d2f, 0x9de43212, 0x9b8563a2, 0x59860a8d, 0x32a8b482 },
+    { 0xefd7649d, 0x148bb2c3, 0xc68db124, 0x644fbd5e, 0xbd4f6424, 0xb18dc6c3, 0xb28b149d, 0x64d7ef83 },
+    { 0x5929c8bd, 0x2891e301, 0x0b9de548, 0xc89efdbc, 0xfd9ec848, 0xe59d0b01, 0xe39128bd, 0xc8295981 },
+    { 0xb25217fd, 0x50a54102, 0x16bd4d90, 0x17bb7dff, 0x7dbb1790, 0x4dbd1602, 0x41a550fd, 0x1752b285 },
+    { 0xe3a42e7d, 0xa0cd8204, 0x2cfd9aa7, 0x2ef1fa79, 0xfaf12ea7, 0x9afd2c04, 0x82cda07d, 0x2ea4e38d },
+    { 0x41cf5cfa, 0xc71d8308, 0x587db3c9, 0x5c6573f2, 0x73655cc9, 0xb37d5808, 0x831dc7fa, 0x5ccf419d },
+    { 0x8219b873, 0x093a8110, 0xb0fae115, 0xb8cae663, 0xe6cab815, 0xe1fab010, 0x813a0973, 0xb81982bd },
+    { 0x8332f7e6, 0x12748520, 0xe773452a, 0xf7134bc6, 0x4b13f72a, 0x4573e720, 0x857412e6, 0xf73283fd },
+    { 0x8164694b, 0x24e88d40, 0x49e68a54, 0x6926960b, 0x96266954, 0x8ae64940, 0x8de8244b, 0x6964817d },
+    { 0x85c8d296, 0x48579d80, 0x924b93a8, 0xd24cab16, 0xab4cd2a8, 0x934b9280, 0x9d574896, 0xd2c885fa },
+    { 0x8d1723ab, 0x90aebd87, 0xa396a1d7, 0x2398d12c, 0xd19823d7, 0xa196a387, 0xbdae90ab, 0x23178d73 },
+    { 0x9d2e46d1, 0xa7dbfd89, 0xc1abc529, 0x46b72558, 0x25b74629, 0xc5abc189, 0xfddba7d1, 0x462e9de6 },
+    { 0xbd5c8c25, 0xc9317d95, 0x05d10d52, 0x8ce94ab0, 0x4ae98c52, 0x0dd10595, 0x7d31c925, 0x8c5cbd4b },
+    { 0xfdb89f4a, 0x1562faad, 0x0a251aa4, 0x9f5594e7, 0x94559fa4, 0x1a250aad, 0xfa62154a, 0x9fb8fd96 },
+    { 0x7df7b994, 0x2ac473dd, 0x144a34cf, 0xb9aaaf49, 0xafaab9cf, 0x344a14dd, 0x73c42a94, 0xb9f77dab },
+    { 0xfa69f5af, 0x540fe63d, 0x28946819, 0xf5d3d992, 0xd9d3f519, 0x6894283d, 0xe60f54af, 0xf569fad1 },
+    { 0x73d26dd9, 0xa81e4b7a, 0x50afd032, 0x6d2135a3, 0x35216d32, 0xd0af507a, 0x4b1ea8d9, 0x6dd27325 },
+    { 0xe623da35, 0xd73c96f4, 0xa0d92764, 0xda426ac1, 0x6a42da64, 0x27d9a0f4, 0x963cd735, 0xda23e64a },
+    { 0x4b46336a, 0x2978ab6f, 0xc7354ec8, 0x3384d405, 0xd48433c8, 0x4e35c76f, 0xab78296a, 0x33464b94 },
+    { 0x968c66d4, 0x52f0d1de, 0x096a9c17, 0x668f2f0a, 0x2f8f6617, 0x9c6a09de, 0xd1f052d4, 0x668c96af },
+    { 0xab9fcc2f, 0xa467253b, 0x12d4bf2e, 0xcc995e14, 0x5e99cc2e, 0xbfd4123b, 0x2567a42f, 0xcc9fabd9 },
+    { 0xd1b91f5e, 0xcfce4a76, 0x242ff95c, 0x1fb5bc28, 0xbcb51f5c, 0xf92f2476, 0x4acecf5e, 0x1fb9d135 },
+    { 0x25f53ebc, 0x191b94ec, 0x485e75b8, 0x3eedff50, 0xffed3eb8, 0x755e48ec, 0x941b19bc, 0x3ef5256a },
+    { 0x4a6d7cff, 0x3236af5f, 0x90bceaf7, 0x7c5d79a0, 0x795d7cf7, 0xeabc905f, 0xaf3632ff, 0x7c6d4ad4 },
+    { 0x94daf879, 0x646cd9be, 0xa7ff5369, 0xf8baf2c7, 0xf2baf869, 0x53ffa7be, 0xd96c6479, 0xf8da942f },
+    { 0xaf3377f2, 0xc8d835fb, 0xc979a6d2, 0x77f36309, 0x63f377d2, 0xa679c9fb, 0x35d8c8f2, 0x7733af5e },
+    { 0xd966ee63, 0x17376a71, 0x15f2cb23, 0xee61c612, 0xc661ee23, 0xcbf21571, 0x6a371763, 0xee66d9bc },
+    { 0x35cc5bc6, 0x2e6ed4e2, 0x2a631146, 0x5bc20b24, 0x0bc25b46, 0x11632ae2, 0xd46e2ec6, 0x5bcc35ff },
+    { 0x6a1fb60b, 0x5cdc2f43, 0x54c6228c, 0xb6031648, 0x1603b68c, 0x22c65443, 0x2fdc5c0b, 0xb61f6a79 },
+    { 0xd43eeb16, 0xb83f5e86, 0xa80b449f, 0xeb062c90, 0x2c06eb9f, 0x440ba886, 0x5e3fb816, 0xeb3ed4f2 },
+    { 0x2f7c512c, 0xf77ebc8b, 0xd71688b9, 0x510c58a7, 0x580c51b9, 0x8816d78b, 0xbc7ef72c, 0x517c2f63 },
+    { 0x5ef8a258, 0x69fcff91, 0x292c97f5, 0xa218b0c9, 0xb018a2f5, 0x972c2991, 0xfffc6958, 0xa2f85ec6 },
+    { 0xbc77c3b0, 0xd27f79a5, 0x5258a96d, 0xc330e715, 0xe730c36d, 0xa95852a5, 0x797fd2b0, 0xc377bc0b },
+    { 0xffee01e7, 0x23fef2cd, 0xa4b0d5da, 0x0160492a, 0x496001da, 0xd5b0a4cd, 0xf2fe23e7, 0x01eeff16 },
+    { 0x795b0249, 0x467b631d, 0xcfe72d33, 0x02c09254, 0x92c00233, 0x2de7cf1d, 0x637b4649, 0x025b792c },
+    { 0xf2b60492, 0x8cf6c63a, 0x19495a66, 0x0407a3a8, 0xa3070466, 0x5a49193a, 0xc6f68c92, 0x04b6f258 },
+    { 0x63eb08a3, 0x9f6b0b74, 0x3292b4cc, 0x080ec1d7, 0xc10e08cc, 0xb4923274, 0x0b6b9fa3, 0x08eb63b0 },
+    { 0xc65110c1, 0xb9d616e8, 0x64a3ef1f, 0x101c0529, 0x051c101f, 0xefa364e8, 0x16d6b9c1, 0x1051c6e7 },
+    { 0x0ba22005, 0xf52b2c57, 0xc8c1593e, 0x20380a52, 0x0a38203e, 0x59c1c857, 0x2c2bf505, 0x20a20b49 },
+    { 0x16c3400a, 0x6d5658ae, 0x1705b27c, 0x407014a4, 0x1470407c, 0xb20517ae, 0x58566d0a, 0x40c31692 },
+    { 0x2c018014, 0xdaacb0db, 0x2e0ae3f8, 0x80e028cf, 0x28e080f8, 0xe30a2edb, 0xb0acda14, 0x80012ca3 },
+    { 0x58028728, 0x33dfe731, 0x5c144177, 0x87475019, 0x50478777, 0x41145c31, 0xe7df3328, 0x870258c1 },
+    { 0xb0048950, 0x66394962, 0xb82882ee, 0x898ea032, 0xa08e89ee, 0x8228b862, 0x49396650, 0x8904b005 },
+    { 0xe70895a0, 0xcc7292c4, 0xf750835b, 0x959bc764, 0xc79b955b, 0x8350f7c4, 0x9272cca0, 0x9508e70a },
+    { 0x4910adc7, 0x1fe4a30f, 0x69a081b6, 0xadb109c8, 0x09b1adb6, 0x81a0690f, 0xa3e41fc7, 0xad104914 },
+    { 0x9220dd09, 0x3e4fc11e, 0xd2c785eb, 0xdde51217, 0x12e5ddeb, 0x85c7d21e, 0xc14f3e09, 0xdd209228 },
+    { 0xa3403d12, 0x7c9e053c, 0x23098d51, 0x3d4d242e, 0x244d3d51, 0x8d09233c, 0x059e7c12, 0x3d40a350 },
+    { 0xc1807a24, 0xf8bb0a78, 0x46129da2, 0x7a9a485c, 0x489a7aa2, 0x9d124678, 0x0abbf824, 0x7a80c1a0 },
+    { 0x0587f448, 0x77f114f0, 0x8c24bdc3, 0xf4b390b8, 0x90b3f4c3, 0xbd248cf0, 0x14f17748, 0xf48705c7 },
+    { 0x0a896f90, 0xee652867, 0x9f48fd01, 0x6fe1a7f7, 0xa7e16f01, 0xfd489f67, 0x2865ee90, 0x6f890a09 },
+    { 0x1495dea7, 0x5bca50ce, 0xb9907d02, 0xde45c969, 0xc945de02, 0x7d90b9ce, 0x50ca5ba7, 0xde951412 },
+    { 0x28ad3bc9, 0xb613a01b, 0xf5a7fa04, 0x3b8a15d2, 0x158a3b04, 0xfaa7f51b, 0xa013b6c9, 0x3bad2824 },
+    { 0x50dd7615, 0xeb26c736, 0x6dc97308, 0x76932a23, 0x2a937608, 0x73c96d36, 0xc726eb15, 0x76dd5048 },
+    { 0xa03dec2a, 0x514c096c, 0xda15e610, 0xeca15446, 0x54a1ec10, 0xe615da6c, 0x094c512a, 0xec3da090 },
+    { 0xc77a5f54, 0xa29812d8, 0x332a4b20, 0x5fc5a88c, 0xa8c55f20, 0x4b2a33d8, 0x1298a254, 0x5f7ac7a7 },
+    { 0x09f4bea8, 0xc3b72437, 0x66549640, 0xbe0dd79f, 0xd70dbe40, 0x96546637, 0x24b7c3a8, 0xbef409c9 },
+    { 0x126ffbd7, 0x01e9486e, 0xcca8ab80, 0xfb1a29b9, 0x291afb80, 0xaba8cc6e, 0x48e901d7, 0xfb6f1215 },
+    { 0x24de7129, 0x025590dc, 0x1fd7d187, 0x713452f5, 0x52347187, 0xd1d71fdc, 0x90550229, 0x71de242a },
+    { 0x483be252, 0x04aaa73f, 0x3e292589, 0xe268a46d, 0xa468e289, 0x25293e3f, 0xa7aa0452, 0xe23b4854 },
+    { 0x907643a4, 0x08d3c97e, 0x7c524a95, 0x43d0cfda, 0xcfd04395, 0x4a527c7e, 0xc9d308a4, 0x437690a8 },
+    { 0xa7ec86cf, 0x102115fc, 0xf8a494ad, 0x86271933, 0x192786ad, 0x94a4f8fc, 0x152110cf, 0x86eca7d7 },
+    { 0xc95f8b19, 0x20422a7f, 0x77cfafdd, 0x8b4e3266, 0x324e8bdd, 0xafcf777f, 0x2a422019, 0x8b5fc929 },
+    { 0x15be9132, 0x408454fe, 0xee19d93d, 0x919c64cc, 0x649c913d, 0xd919eefe, 0x54844032, 0x91be1552 },
+    { 0x2afba564, 0x808fa87b, 0x5b32357a, 0xa5bfc81f, 0xc8bfa57a, 0x35325b7b, 0xa88f8064, 0xa5fb2aa4 },
+    { 0x5471cdc8, 0x8799d7f6, 0xb6646af4, 0xcdf9173e, 0x17f9cdf4, 0x6a64b6f6, 0xd79987c8, 0xcd7154cf },
+    { 0xa8e21d17, 0x89b5296b, 0xebc8d46f, 0x1d752e7c, 0x2e751d6f, 0xd4c8eb6b, 0x29b58917, 0x1de2a819 },
+    { 0xd7433a2e, 0x95ed52d6, 0x51172fde, 0x3aea5cf8, 0x5cea3ade, 0x2f1751d6, 0x52ed952e, 0x3a43d732 },
+    { 0x2986745c, 0xad5da42b, 0xa22e5e3b, 0x7453b877, 0xb853743b, 0x5e2ea22b, 0xa45dad5c, 0x74862964 },
+    { 0x528be8b8, 0xddbacf56, 0xc35cbc76, 0xe8a6f7ee, 0xf7a6e876, 0xbc5cc356, 0xcfbaddb8, 0xe88b52c8 },
+    { 0xa49157f7, 0x3df319ac, 0x01b8ffec, 0x57cb695b, 0x69cb57ec, 0xffb801ac, 0x19f33df7, 0x5791a417 },
+    { 0xcfa5ae69, 0x7a6132df, 0x02f7795f, 0xae11d2b6, 0xd211ae5f, 0x79f702df, 0x32617a69, 0xaea5cf2e },
+    { 0x19cddbd2, 0xf4c26439, 0x0469f2be, 0xdb2223eb, 0x2322dbbe, 0xf2690439, 0x64c2f4d2, 0xdbcd195c },
+    { 0x321d3123, 0x6f03c872, 0x08d263fb, 0x31444651, 0x464431fb, 0x63d20872, 0xc8036f23, 0x311d32b8 },
+    { 0x643a6246, 0xde0617e4, 0x1023c671, 0x62888ca2, 0x8c886271, 0xc62310e4, 0x1706de46, 0x623a64f7 },
+    { 0xc874c48c, 0x3b0c2e4f, 0x20460be2, 0xc4979fc3, 0x9f97c4e2, 0x0b46204f, 0x2e0c3b8c, 0xc474c869 },
+    { 0x17e80f9f, 0x76185c9e, 0x408c1643, 0x0fa9b901, 0xb9a90f43, 0x168c409e, 0x5c18769f, 0x0fe817d2 },
+    { 0x2e571eb9, 0xec30b8bb, 0x809f2c86, 0x1ed5f502, 0xf5d51e86, 0x2c9f80bb, 0xb830ecb9, 0x1e572e23 },
+    { 0x5cae3cf5, 0x5f60f7f1, 0x87b9588b, 0x3c2d6d04, 0x6d2d3c8b, 0x58b987f1, 0xf7605ff5, 0x3cae5c46 },
+    { 0xb8db786d, 0xbec06965, 0x89f5b091, 0x785ada08, 0xda5a7891, 0xb0f58965, 0x69c0be6d, 0x78dbb88c },
+    { 0xf731f0da, 0xfb07d2ca, 0x956de7a5, 0xf0b43310, 0x33b4f0a5, 0xe76d95ca, 0xd207fbda, 0xf031f79f },
+    { 0x69626733, 0x710e2313, 0xadda49cd, 0x67ef6620, 0x66ef67cd, 0x49daad13, 0x230e7133, 0x676269b9 },
+    { 0xd2c4ce66, 0xe21c4626, 0xdd33921d, 0xce59cc40, 0xcc59ce1d, 0x9233dd26, 0x461ce266, 0xcec4d2f5 },
+    { 0x230f1bcc, 0x43388c4c, 0x3d66a33a, 0x1bb21f80, 0x1fb21b3a, 0xa3663d4c, 0x8c3843cc, 0x1b0f236d },
+    { 0x461e361f, 0x86709f98, 0x7accc174, 0x36e33e87, 0x3ee33674, 0xc1cc7a98, 0x9f70861f, 0x361e46da },
+    { 0x8c3c6c3e, 0x8be0b9b7, 0xf41f05e8, 0x6c417c89, 0x7c416ce8, 0x051ff4b7, 0xb9e08b3e, 0x6c3c8c33 },
+    { 0x9f78d87c, 0x9147f5e9, 0x6f3e0a57, 0xd882f895, 0xf882d857, 0x0a3e6fe9, 0xf547917c, 0xd8789f66 },
+    { 0xb9f037f8, 0xa58e6d55, 0xde7c14ae, 0x378377ad, 0x778337ae, 0x147cde55, 0x6d8ea5f8, 0x37f0b9cc },
+    { 0xf5676e77, 0xcd9bdaaa, 0x3bf828db, 0x6e81eedd, 0xee816edb, 0x28f83baa, 0xda9bcd77, 0x6e67f51f },
+    { 0x6dcedcee, 0x1db133d3, 0x76775031, 0xdc855b3d, 0x5b85dc31, 0x507776d3, 0x33b11dee, 0xdcce6d3e },
+    { 0xda1b3f5b, 0x3ae56621, 0xeceea062, 0x3f8db67a, 0xb68d3f62, 0xa0eeec21, 0x66e53a5b, 0x3f1bda7c },
+    { 0x33367eb6, 0x744dcc42, 0x5f5bc7c4, 0x7e9debf4, 0xeb9d7ec4, 0xc75b5f42, 0xcc4d74b6, 0x7e3633f8 },
+    { 0x666cfceb, 0xe89a1f84, 0xbeb6090f, 0xfcbd516f, 0x51bdfc0f, 0x09b6be84, 0x1f9ae8eb, 0xfc6c6677 },
+    { 0xccd87f51, 0x57b33e8f, 0xfbeb121e, 0x7ffda2de, 0xa2fd7f1e, 0x12ebfb8f, 0x3eb35751, 0x7fd8ccee },
+    { 0x1f37fea2, 0xaee17c99, 0x7151243c, 0xfe7dc33b, 0xc37dfe3c, 0x24517199, 0x7ce1aea2, 0xfe371f5b },
+    { 0x3e6e7bc3, 0xdb45f8b5, 0xe2a24878, 0x7bfa0176, 0x01fa7b78, 0x48a2e2b5, 0xf845dbc3, 0x7b6e3eb6 },
+    { 0x7cdcf601, 0x318a77ed, 0x43c390f0, 0xf67302ec, 0x0273f6f0, 0x90c343ed, 0x778a3101, 0xf6dc7ceb },
+    { 0xf83f6b02, 0x6293ee5d, 0x8601a767, 0x6be6045f, 0x04e66b67, 0xa701865d, 0xee936202, 0x6b3ff851 },
+    { 0x777ed604, 0xc4a15bba, 0x8b02c9ce, 0xd64b08be, 0x084bd6ce, 0xc9028bba, 0x5ba1c404, 0xd67e77a2 },
+    { 0xeefc2b08, 0x0fc5b6f3, 0x9104151b, 0x2b9610fb, 0x10962b1b, 0x150491f3, 0xb6c50f08, 0x2bfceec3 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000 }
+  };
+  
+  // conversion from conventional to dual basis representation
+  static const uint8_t au8_ToDual[256] = {
+    0x00, 0x7b, 0xaf, 0xd4, 0x99, 0xe2, 0x36, 0x4d, 0xfa, 0x81, 0x55, 0x2e, 0x63, 0x18, 0xcc, 0xb7,
+    0x86, 0xfd, 0x29, 0x52, 0x1f, 0x64, 0xb0, 0xcb, 0x7c, 0x07, 0xd3, 0xa8, 0xe5, 0x9e, 0x4a, 0x31,
+    0xec, 0x97, 0x43, 0x38, 0x75, 0x0e, 0xda, 0xa1, 0x16, 0x6d, 0xb9, 0xc2, 0x8f, 0xf4, 0x20, 0x5b,
+    0x6a, 0x11, 0xc5, 0xbe, 0xf3, 0x88, 0x5c, 0x27, 0x90, 0xeb, 0x3f, 0x44, 0x09, 0x72, 0xa6, 0xdd,
+    0xef, 0x94, 0x40, 0x3b, 0x76, 0x0d, 0xd9, 0xa2, 0x15, 0x6e, 0xba, 0xc1, 0x8c, 0xf7, 0x23, 0x58,
+    0x69, 0x12, 0xc6, 0xbd, 0xf0, 0x8b, 0x5f, 0x24, 0x93, 0xe8, 0x3c, 0x47, 0x0a, 0x71, 0xa5, 0xde,
+    0x03, 0x78, 0xac, 0xd7, 0x9a, 0xe1, 0x35, 0x4e, 0xf9, 0x82, 0x56, 0x2d, 0x60, 0x1b, 0xcf, 0xb4,
+    0x85, 0xfe, 0x2a, 0x51, 0x1c, 0x67, 0xb3, 0xc8, 0x7f, 0x04, 0xd0, 0xab, 0xe6, 0x9d, 0x49, 0x32,
+    0x8d, 0xf6, 0x22, 0x59, 0x14, 0x6f, 0xbb, 0xc0, 0x77, 0x0c, 0xd8, 0xa3, 0xee, 0x95, 0x41, 0x3a,
+    0x0b, 0x70, 0xa4, 0xdf, 0x92, 0xe9, 0x3d, 0x46, 0xf1, 0x8a, 0x5e, 0x25, 0x68, 0x13, 0xc7, 0xbc,
+    0x61, 0x1a, 0xce, 0xb5, 0xf8, 0x83, 0x57, 0x2c, 0x9b, 0xe0, 0x34, 0x4f, 0x02, 0x79, 0xad, 0xd6,
+    0xe7, 0x9c, 0x48, 0x33, 0x7e, 0x05, 0xd1, 0xaa, 0x1d, 0x66, 0xb2, 0xc9, 0x84, 0xff, 0x2b, 0x50,
+    0x62, 0x19, 0xcd, 0xb6, 0xfb, 0x80, 0x54, 0x2f, 0x98, 0xe3, 0x37, 0x4c, 0x01, 0x7a, 0xae, 0xd5,
+    0xe4, 0x9f, 0x4b, 0x30, 0x7d, 0x06, 0xd2, 0xa9, 0x1e, 0x65, 0xb1, 0xca, 0x87, 0xfc, 0x28, 0x53,
+    0x8e, 0xf5, 0x21, 0x5a, 0x17, 0x6c, 0xb8, 0xc3, 0x74, 0x0f, 0xdb, 0xa0, 0xed, 0x96, 0x42, 0x39,
+    0x08, 0x73, 0xa7, 0xdc, 0x91, 0xea, 0x3e, 0x45, 0xf2, 0x89, 0x5d, 0x26, 0x6b, 0x10, 0xc4, 0xbf
+  };
+  
+  // conversion from dual basis to conventional representation
+  static const uint8_t au8_FromDual[256] = {
+    0x00, 0xcc, 0xac, 0x60, 0x79, 0xb5, 0xd5, 0x19, 0xf0, 0x3c, 0x5c, 0x90, 0x89, 0x45, 0x25, 0xe9,
+    0xfd, 0x31, 0x51, 0x9d, 0x84, 0x48, 0x28, 0xe4, 0x0d, 0xc1, 0xa1, 0x6d, 0x74, 0xb8, 0xd8, 0x14,
+    0x2e, 0xe2, 0x82, 0x4e, 0x57, 0x9b, 0xfb, 0x37, 0xde, 0x12, 0x72, 0xbe, 0xa7, 0x6b, 0x0b, 0xc7,
+    0xd3, 0x1f, 0x7f, 0xb3, 0xaa, 0x66, 0x06, 0xca, 0x23, 0xef, 0x8f, 0x43, 0x5a, 0x96, 0xf6, 0x3a,
+    0x42, 0x8e, 0xee, 0x22, 0x3b, 0xf7, 0x97, 0x5b, 0xb2, 0x7e, 0x1e, 0xd2, 0xcb, 0x07, 0x67, 0xab,
+    0xbf, 0x73, 0x13, 0xdf, 0xc6, 0x0a, 0x6a, 0xa6, 0x4f, 0x83, 0xe3, 0x2f, 0x36, 0xfa, 0x9a, 0x56,
+    0x6c, 0xa0, 0xc0, 0x0c, 0x15, 0xd9, 0xb9, 0x75, 0x9c, 0x50, 0x30, 0xfc, 0xe5, 0x29, 0x49, 0x85,
+    0x91, 0x5d, 0x3d, 0xf1, 0xe8, 0x24, 0x44, 0x88, 0x61, 0xad, 0xcd, 0x01, 0x18, 0xd4, 0xb4, 0x78,
+    0xc5, 0x09, 0x69, 0xa5, 0xbc, 0x70, 0x10, 0xdc, 0x35, 0xf9, 0x99, 0x55, 0x4c, 0x80, 0xe0, 0x2c,
+    0x38, 0xf4, 0x94, 0x58, 0x41, 0x8d, 0xed, 0x21, 0xc8, 0x04, 0x64, 0xa8, 0xb1, 0x7d, 0x1d, 0xd1,
+    0xeb, 0x27, 0x47, 0x8b, 0x92, 0x5e, 0x3e, 0xf2, 0x1b, 0xd7, 0xb7, 0x7b, 0x62, 0xae, 0xce, 0x02,
+    0x16, 0xda, 0xba, 0x76, 0x6f, 0xa3, 0xc3, 0x0f, 0xe6, 0x2a, 0x4a, 0x86, 0x9f, 0x53, 0x33, 0xff,
+    0x87, 0x4b, 0x2b, 0xe7, 0xfe, 0x32, 0x52, 0x9e, 0x77, 0xbb, 0xdb, 0x17, 0x0e, 0xc2, 0xa2, 0x6e,
+    0x7a, 0xb6, 0xd6, 0x1a, 0x03, 0xcf, 0xaf, 0x63, 0x8a, 0x46, 0x26, 0xea, 0xf3, 0x3f, 0x5f, 0x93,
+    0xa9, 0x65, 0x05, 0xc9, 0xd0, 0x1c, 0x7c, 0xb0, 0x59, 0x95, 0xf5, 0x39, 0x20, 0xec, 0x8c, 0x40,
+    0x54, 0x98, 0xf8, 0x34, 0x2d, 0xe1, 0x81, 0x4d, 0xa4, 0x68, 0x08, 0xc4, 0xdd, 0x11, 0x71, 0xbd
+  };
+  
+  
+  static inline uint16_t _modnn(uint16_t u16_Value)
+  {
+    while(u16_Value>=RS_NN)
+    {
+      u16_Value-=RS_NN;
+      u16_Value=(u16_Value>>8)+(u16_Value&RS_NN);
+    }
+    return u16_Value;
+  }
+  
+  
+  
+  /**
+   * @brief Adds the check symbols to a codeblock
+   *
+   * The data part (usually a TM transfer frame) must be located at the start of the buffer; the check symbols
+   * are written directly behind it.
+   *
+   * @param pu8_Buffer          A pointer to the codeblock
+   * @param u32_BufferSize      The available size of the buffer
+   * @param u16_DataSize        The size of the data part; a multiple of the interleaving depth and at most
+   *                            223 times the interleaving depth
+   * @param u8_InterleaveDepth  The interleaving depth (1 to 8)
+   * @param b_DualBasis         true if the symbols are represented in the dual basis (as required by CCSDS 131.0)
+   *
+   * @return     The size of the codeblock (data and check symbols)
+   * @retval  0  If the parameters are invalid or the buffer is too small
+   */
+  uint32_t ReedSolomon::encode(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                               const uint16_t u16_DataSize, const uint8_t u8_InterleaveDepth,
+                               const bool b_DualBasis)
+  {
+    // shift register of the check symbols, four symbols per word; the next symbol to leave is in the upper byte of word 0
+    uint32_t au32_Reg[ParitySize/4];
+    const uint32_t *pu32_Product;
+    uint16_t u16_SymbolCount;
+    uint8_t u8_Symbol;
+    
+    if(!pu8_Buffer || !_checkParameters(u16_DataSize, u8_InterleaveDepth))
+      return 0;
+    if(u32_BufferSize<(uint32_t)u16_DataSize+(uint32_t)u8_InterleaveDepth*ParitySize)
+      return 0;
+    
+    u16_SymbolCount=u16_DataSize/u8_InterleaveDepth;
+    for(uint8_t u8_Codeword=0; u8_Codeword<u8_InterleaveDepth; u8_Codeword++)
+    {
+      memset(au32_Reg, 0, sizeof(au32_Reg));
+      for(uint16_t i=0; i<u16_SymbolCount; i++)
+      {
+        u8_Symbol=pu8_Buffer[i*u8_InterleaveDepth+u8_Codeword];
+        if(b_DualBasis)
+          u8_Symbol=au8_FromDual[u8_Symbol];
+        pu32_Product=aau32_GenPolyProduct[au8_IndexOf[u8_Symbol ^ (uint8_t)(au32_Reg[0]>>24)]];
+        
+        // shift the register by one symbol and add the products
+        for(uint8_t j=0; j<ParitySize/4-1; j++)
+          au32_Reg[j]=((au32_Reg[j]<<8) | (au32_Reg[j+1]>>24)) ^ pu32_Product[j];
+        au32_Reg[ParitySize/4-1]=(au32_Reg[ParitySize/4-1]<<8) ^ pu32_Product[ParitySize/4-1];
+      }
+      
+      for(uint8_t j=0; j<ParitySize; j++)
+      {
+        u8_Symbol=(uint8_t)(au32_Reg[j/4]>>(24-8*(j%4)));
+        pu8_Buffer[u16_DataSize+j*u8_InterleaveDepth+u8_Codeword]=b_DualBasis?au8_ToDual[u8_Symbol]:u8_Symbol;
+      }
+    }
+    
+    return u16_DataSize+(uint32_t)u8_InterleaveDepth*ParitySize;
+  }
+  
+  
+  
+  /**
+   * @brief Checks a codeblock and corrects the errors in place
+   *
+   * @param pu8_Buffer          A pointer to the codeblock (data part followed by the check symbols)
+   * @param u16_DataSize        The size of the data part; a multiple of the interleaving depth and at most
+   *                            223 times the interleaving depth
+   * @param u8_InterleaveDepth  The interleaving depth (1 to 8)
+   * @param b_DualBasis         true if the symbols are represented in the dual basis (as required by CCSDS 131.0)
+   *
+   * @return     The number of corrected symbols
+   * @retval -1  If the parameters are invalid
+   * @retval -2  If at least one codeword could not be corrected
+   */
+  int32_t ReedSolomon::decode(uint8_t *pu8_Buffer, const uint16_t u16_DataSize, const uint8_t u8_InterleaveDepth,
+                              const bool b_DualBasis)
+  {
+    uint8_t au8_Codeword[CodewordSize];
+    uint16_t u16_SymbolCount;
+    uint8_t u8_Pad;
+    int32_t i32_Corrected=0;
+    int32_t i32_Result;
+    bool b_Failed=false;
+    
+    if(!pu8_Buffer || !_checkParameters(u16_DataSize, u8_InterleaveDepth))
+      return -1;
+    
+    u16_SymbolCount=u16_DataSize/u8_InterleaveDepth+ParitySize;
+    u8_Pad=(uint8_t)(CodewordSize-u16_SymbolCount);
+    for(uint8_t u8_Codeword=0; u8_Codeword<u8_InterleaveDepth; u8_Codeword++)
+    {
+      for(uint16_t i=0; i<u16_SymbolCount; i++)
+      {
+        au8_Codeword[i]=pu8_Buffer[i*u8_InterleaveDepth+u8_Codeword];
+        if(b_DualBasis)
+          au8_Codeword[i]=au8_FromDual[au8_Codeword[i]];
+      }
+      
+      i32_Result=_decodeCodeword(au8_Codeword, u8_Pad);
+      if(i32_Result<0)
+      {
+        b_Failed=true;
+        continue;
+      }
+      if(i32_Result==0)
+        continue;
+      
+      i32_Corrected+=i32_Result;
+      for(uint16_t i=0; i<u16_SymbolCount; i++)
+        pu8_Buffer[i*u8_InterleaveDepth+u8_Codeword]=b_DualBasis?au8_ToDual[au8_Codeword[i]]:au8_Codeword[i];
+    }
+    
+    return b_Failed?-2:i32_Corrected;
+  }
+  
+  
+  
+  bool ReedSolomon::_checkParameters(const uint16_t u16_DataSize, const uint8_t u8_InterleaveDepth)
+  {
+    if(u8_InterleaveDepth==0 || u8_InterleaveDepth>MaxInterleaveDepth)
+      return false;
+    if(u16_DataSize==0 || (u16_DataSize%u8_InterleaveDepth)!=0)
+      return false;
+    
+    return (u16_DataSize/u8_InterleaveDepth<=MessageSize)?true:false;
+  }
+  
+  
+  
+  /*
+   * Decodes one codeword in conventional representation; the first u8_Pad symbols are virtual fill
+   * and not part of the buffer. Returns the number of corrected symbols or -1.
+   */
+  int32_t ReedSolomon::_decodeCodeword(uint8_t *pu8_Codeword, const uint8_t u8_Pad)
+  {
+    uint8_t au8_Syndrome[ParitySize];
+    uint8_t au8_RootLog[ParitySize];
+    uint8_t au8_Lambda[ParitySize+1];
+    uint8_t au8_B[ParitySize+1];
+    uint8_t au8_T[ParitySize+1];
+    uint8_t au8_Omega[ParitySize+1];
+    uint8_t au8_Reg[ParitySize+1];
+    uint8_t au8_Root[ParitySize];
+    uint8_t au8_Loc[ParitySize];
+    uint16_t u16_SymbolCount=CodewordSize-u8_Pad;
+    uint8_t u8_SyndromeError=0;
+    uint8_t u8_Discrepancy;
+    uint8_t u8_DegLambda=0;
+    uint8_t u8_DegOmega;
+    uint8_t u8_Count=0;
+    uint8_t u8_L=0;
+    uint8_t u8_Tmp;
+    uint8_t u8_Num1;
+    uint8_t u8_Num2;
+    uint8_t u8_Den;
+    uint8_t q;
+    uint16_t k;
+    uint16_t u16_Log;
+    
+    // syndromes, evaluated with Horner's scheme at the roots of the generator
+    for(uint8_t i=0; i<ParitySize; i++)
+    {
+      au8_Syndrome[i]=pu8_Codeword[0];
+      au8_RootLog[i]=(uint8_t)_modnn((RS_FCR+i)*RS_PRIM);
+    }
+    for(uint16_t j=1; j<u16_SymbolCount; j++)
+    {
+      for(uint8_t i=0; i<ParitySize; i++)
+      {
+        if(au8_Syndrome[i]==0)
+        {
+          au8_Syndrome[i]=pu8_Codeword[j];
+        }
+        else
+        {
+          u16_Log=au8_IndexOf[au8_Syndrome[i]]+au8_RootLog[i];
+          if(u16_Log>=RS_NN)
+            u16_Log-=RS_NN;
+          au8_Syndrome[i]=pu8_Codeword[j]^au8_AlphaTo[u16_Log];
+        }
+      }
+    }
+    for(uint8_t i=0; i<ParitySize; i++)
+    {
+      u8_SyndromeError|=au8_Syndrome[i];
+      au8_Syndrome[i]=au8_IndexOf[au8_Syndrome[i]];
+    }
+    if(!u8_SyndromeError)
+      return 0;
+    
+    // Berlekamp-Massey: error locator polynomial lambda
+    memset(&au8_Lambda[1], 0, ParitySize);
+    au8_Lambda[0]=1;
+    for(uint8_t i=0; i<ParitySize+1; i++)
+      au8_B[i]=au8_IndexOf[au8_Lambda[i]];
+    
+    for(uint8_t r=1; r<=ParitySize; r++)
+    {
+      u8_Discrepancy=0;
+      for(uint8_t i=0; i<r; i++)
+      {
+        if(au8_Lambda[i]!=0 && au8_Syndrome[r-i-1]!=RS_A0)
+          u8_Discrepancy^=au8_AlphaTo[_modnn(au8_IndexOf[au8_Lambda[i]]+au8_Syndrome[r-i-1])];
+      }
+      u8_Discrepancy=au8_IndexOf[u8_Discrepancy];
+      
+      if(u8_Discrepancy==RS_A0)
+      {
+        memmove(&au8_B[1], au8_B, ParitySize);
+        au8_B[0]=RS_A0;
+        continue;
+      }
+      
+      au8_T[0]=au8_Lambda[0];
+      for(uint8_t i=0; i<ParitySize; i++)
+      {
+        if(au8_B[i]!=RS_A0)
+          au8_T[i+1]=au8_Lambda[i+1]^au8_AlphaTo[_modnn(u8_Discrepancy+au8_B[i])];
+        else
+          au8_T[i+1]=au8_Lambda[i+1];
+      }
+      if(2*u8_L<=r-1)
+      {
+        u8_L=r-u8_L;
+        for(uint8_t i=0; i<=ParitySize; i++)
+          au8_B[i]=(au8_Lambda[i]==0)?RS_A0:(uint8_t)_modnn(au8_IndexOf[au8_Lambda[i]]-u8_Discrepancy+RS_NN);
+      }
+      else
+      {
+        memmove(&au8_B[1], au8_B, ParitySize);
+        au8_B[0]=RS_A0;
+      }
+      memcpy(au8_Lambda, au8_T, ParitySize+1);
+    }
+    
+    for(uint8_t i=0; i<ParitySize+1; i++)
+    {
+      au8_Lambda[i]=au8_IndexOf[au8_Lambda[i]];
+      if(au8_Lambda[i]!=RS_A0)
+        u8_DegLambda=i;
+    }
+    // a nonzero syndrome without error locations cannot be corrected; omega would have the degree -1
+    if(u8_DegLambda==0)
+      return -1;
+    
+    // Chien search: roots of lambda are the inverse error locations
+    memcpy(&au8_Reg[1], &au8_Lambda[1], ParitySize);
+    k=RS_IPRIM-1;
+    for(uint16_t i=1; i<=RS_NN; i++, k=_modnn(k+RS_IPRIM))
+    {
+      q=1;
+      for(uint8_t j=u8_DegLambda; j>0; j--)
+      {
+        if(au8_Reg[j]!=RS_A0)
+        {
+          au8_Reg[j]=(uint8_t)_modnn(au8_Reg[j]+j);
+          q^=au8_AlphaTo[au8_Reg[j]];
+        }
+      }
+      if(q!=0)
+        continue;
+      au8_Root[u8_Count]=(uint8_t)i;
+      au8_Loc[u8_Count]=(uint8_t)k;
+      if(++u8_Count==u8_DegLambda)
+        break;
+    }
+    if(u8_DegLambda!=u8_Count)
+      return -1;
+    
+    // error evaluator polynomial omega = syndrome * lambda mod x^ParitySize
+    u8_DegOmega=u8_DegLambda-1;
+    for(uint8_t i=0; i<=u8_DegOmega; i++)
+    {
+      u8_Tmp=0;
+      for(int16_t j=i; j>=0; j--)
+      {
+        if(au8_Syndrome[i-j]!=RS_A0 && au8_Lambda[j]!=RS_A0)
+          u8_Tmp^=au8_AlphaTo[_modnn(au8_Syndrome[i-j]+au8_Lambda[j])];
+      }
+      au8_Omega[i]=au8_IndexOf[u8_Tmp];
+    }
+    
+    // Forney: error values
+    for(int16_t j=u8_Count-1; j>=0; j--)
+    {
+      if(au8_Loc[j]<u8_Pad)
+        return -1;                    // error in the virtual fill: decoding failure
+      
+      u8_Num1=0;
+      for(int16_t i=u8_DegOmega; i>=0; i--)
+      {
+        if(au8_Omega[i]!=RS_A0)
+          u8_Num1^=au8_AlphaTo[_modnn(au8_Omega[i]+i*au8_Root[j])];
+      }
+      u8_Num2=au8_AlphaTo[_modnn(au8_Root[j]*(RS_FCR-1)+RS_NN)];
+      u8_Den=0;
+      // lambda[i+1] for even i is the formal derivative of lambda
+      for(int16_t i=((u8_DegLambda<ParitySize-1)?u8_DegLambda:ParitySize-1)&~1; i>=0; i-=2)
+      {
+        if(au8_Lambda[i+1]!=RS_A0)
+          u8_Den^=au8_AlphaTo[_modnn(au8_Lambda[i+1]+i*au8_Root[j])];
+      }
+      if(u8_Den==0)
+        return -1;
+      if(u8_Num1!=0)
+        pu8_Codeword[au8_Loc[j]-u8_Pad]^=au8_AlphaTo[_modnn(au8_IndexOf[u8_Num1]+au8_IndexOf[u8_Num2]+RS_NN-au8_IndexOf[u8_Den])];
+    }
+    
+    return u8_Count;
+  }
+  
+}
+
+#endif
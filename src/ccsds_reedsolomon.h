@@ -0,0 +1,81 @@
+/**
+ * @file      ccsds_reedsolomon.h
+ *
+ * @brief     Include file of the Reed-Solomon (255,223) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_REEDSOLOMON_H_
+#define _CCSDS_REEDSOLOMON_H_
+
+/****************************************************************/
+/* Reed-Solomon coding according to                             */
+/*                                                              */
+/*  - CCSDS 131.0-B-3, - TM Synchronization and Channel Coding  */
+/*    https://public.ccsds.org/Pubs/131x0b3e1.pdf               */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Only the code with E=16 (255,223) is supported            */
+/*  - Erasures are not supported                                */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+
+#ifdef configTF_RS_MAX_INTERLEAVE
+#define TF_RS_MAX_INTERLEAVE configTF_RS_MAX_INTERLEAVE
+#else
+#define TF_RS_MAX_INTERLEAVE 8
+#endif
+
+
+#if TF_RS_MAX_INTERLEAVE > 0
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Class for encoding and decoding the Reed-Solomon (255,223) code of CCSDS 131.0-B-3.
+   *
+   * The code corrects up to 16 symbol errors per codeword. With an interleaving depth I (1 to 8), a codeblock
+   * consists of I codewords: symbol j of the codeblock belongs to codeword j mod I. The data part of a codeblock
+   * is usually a TM transfer frame of I*223 bytes, followed by I*32 check symbols. Shorter frames (multiples of I)
+   * are supported by virtual fill, i.e. the missing leading symbols of each codeword are treated as zero.
+   *
+   * The symbols are transmitted in the dual basis representation (b_DualBasis) as required by the standard;
+   * internally, the arithmetic is done in the conventional representation with log and antilog tables.
+   * The encoder adds the precomputed products of the generator polynomial to its register four symbols at a time.
+   * Decoding uses the Berlekamp-Massey algorithm, Chien search and Forney's formula.
+   *
+   * All methods work in place on the given buffer.
+   */
+  class ReedSolomon
+  {
+  public:
+    const static uint8_t CodewordSize = 255;
+    const static uint8_t MessageSize = 223;
+    const static uint8_t ParitySize = 32;
+    const static uint8_t MaxInterleaveDepth = TF_RS_MAX_INTERLEAVE;
+    
+  public:
+    static uint32_t encode(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                           const uint16_t u16_DataSize, const uint8_t u8_InterleaveDepth,
+                           const bool b_DualBasis = true);
+    static int32_t decode(uint8_t *pu8_Buffer, const uint16_t u16_DataSize, const uint8_t u8_InterleaveDepth,
+                          const bool b_DualBasis = true);
+    
+  private:
+    static bool _checkParameters(const uint16_t u16_DataSize, const uint8_t u8_InterleaveDepth);
+    static int32_t _decodeCodeword(uint8_t *pu8_Codeword, const uint8_t u8_Pad);
+  };
+  
+}
+
+#endif
+
+#endif /* _CCSDS_REEDSOLOMON_H_ */
@@ -0,0 +1,620 @@
+/**
+ * @file      ccsds_rice.cpp
+ *
+ * @brief     Source file of the lossless data compression (Rice) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "ccsds_rice.h"
+
+
+namespace CCSDS
+{
+  // number of leading zeros of a byte (the value for 0 is not used)
+  static const uint8_t au8_LeadingZeros[256] = {
+    8, 7, 6, 6, 5, 5, 5, 5, 4, 4, 4, 4, 4, 4, 4, 4,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+  };
+
+
+  /*
+   * Bit writer: the bits are collected in a register and written byte by byte
+   */
+  struct BitWriter
+  {
+    uint8_t *pu8_Buffer;
+    uint32_t u32_BufferSize;
+    uint32_t u32_Pos;
+    uint32_t u32_Bits;
+    uint8_t u8_BitCount;
+    bool b_Overflow;
+  };
+
+  // writes up to 16 bits
+  static inline void putBits(BitWriter *pS_Writer, const uint32_t u32_Value, const uint8_t u8_Count)
+  {
+    pS_Writer->u32_Bits = (pS_Writer->u32_Bits<<u8_Count) | (u32_Value&((1UL<<u8_Count)-1));
+    pS_Writer->u8_BitCount += u8_Count;
+    while(pS_Writer->u8_BitCount>=8)
+    {
+      pS_Writer->u8_BitCount -= 8;
+      if(pS_Writer->u32_Pos<pS_Writer->u32_BufferSize)
+        pS_Writer->pu8_Buffer[pS_Writer->u32_Pos++] = (uint8_t)(pS_Writer->u32_Bits>>pS_Writer->u8_BitCount);
+      else
+        pS_Writer->b_Overflow = true;
+    }
+  }
+
+  // writes the fundamental sequence of a value: u32_Value zeros followed by a one
+  static inline void putFundamentalSequence(BitWriter *pS_Writer, uint32_t u32_Value)
+  {
+    while(u32_Value>=16)
+    {
+      putBits(pS_Writer, 0, 16);
+      u32_Value -= 16;
+    }
+    putBits(pS_Writer, 1, (uint8_t)(u32_Value+1));
+  }
+
+
+  /*
+   * Bit reader
+   */
+  struct BitReader
+  {
+    const uint8_t *pu8_Data;
+    uint32_t u32_DataSize;
+    uint32_t u32_Pos;
+    uint8_t u8_BitPos;
+    bool b_Underflow;
+  };
+
+  // reads up to 16 bits
+  static inline uint32_t getBits(BitReader *pS_Reader, uint8_t u8_Count)
+  {
+    uint32_t u32_Value=0;
+    uint8_t u8_Available;
+    uint8_t u8_Take;
+
+    while(u8_Count>0)
+    {
+      if(pS_Reader->u32_Pos>=pS_Reader->u32_DataSize)
+      {
+        pS_Reader->b_Underflow = true;
+        return 0;
+      }
+      u8_Available = (uint8_t)(8-pS_Reader->u8_BitPos);
+      u8_Take = (u8_Count<u8_Available)?u8_Count:u8_Available;
+      u32_Value = (u32_Value<<u8_Take) | (uint32_t)((pS_Reader->pu8_Data[pS_Reader->u32_Pos]>>(u8_Available-u8_Take))&((1<<u8_Take)-1));
+      pS_Reader->u8_BitPos += u8_Take;
+      u8_Count -= u8_Take;
+      if(pS_Reader->u8_BitPos==8)
+      {
+        pS_Reader->u8_BitPos = 0;
+        pS_Reader->u32_Pos++;
+      }
+    }
+    return u32_Value;
+  }
+
+  // reads a fundamental sequence, the zeros are counted byte by byte with the table
+  static inline uint32_t getFundamentalSequence(BitReader *pS_Reader)
+  {
+    uint32_t u32_Value=0;
+    uint8_t u8_Bits;
+
+    while(pS_Reader->u32_Pos<pS_Reader->u32_DataSize)
+    {
+      u8_Bits = (uint8_t)(pS_Reader->pu8_Data[pS_Reader->u32_Pos]<<pS_Reader->u8_BitPos);
+      if(u8_Bits==0)
+      {
+        u32_Value += (uint32_t)(8-pS_Reader->u8_BitPos);
+        pS_Reader->u8_BitPos = 0;
+        pS_Reader->u32_Pos++;
+        continue;
+      }
+      u32_Value += au8_LeadingZeros[u8_Bits];
+      pS_Reader->u8_BitPos = (uint8_t)(pS_Reader->u8_BitPos+au8_LeadingZeros[u8_Bits]+1);
+      if(pS_Reader->u8_BitPos==8)
+      {
+        pS_Reader->u8_BitPos = 0;
+        pS_Reader->u32_Pos++;
+      }
+      return u32_Value;
+    }
+    pS_Reader->b_Underflow = true;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Construct a new Rice object
+   *
+   * @param u8_SampleSize           The resolution of the samples in bits (1 to 16)
+   * @param u8_BlockSize            The number of samples per block J (8, 16, 32 or 64)
+   * @param u16_ReferenceInterval   The number of blocks per reference sample interval r (1 to 4096)
+   * @param b_Preprocessor          true if the unit-delay predictor and the mapper are used
+   * @param b_Signed                true if the samples are signed (two's complement)
+   */
+  Rice::Rice(const uint8_t u8_SampleSize, const uint8_t u8_BlockSize, const uint16_t u16_ReferenceInterval,
+             const bool b_Preprocessor, const bool b_Signed)
+    : mu8_SampleSize{8}
+    , mu8_BlockSize{16}
+    , mu16_ReferenceInterval{128}
+    , mb_Preprocessor{true}
+    , mb_Signed{false}
+    , mu8_IdSize{3}
+    , mu8_MaxSplit{5}
+  {
+    setParameters(u8_SampleSize, u8_BlockSize, u16_ReferenceInterval, b_Preprocessor, b_Signed);
+  }
+
+
+
+  /**
+   * @brief Sets the coding parameters; the encoder and the decoder must use the same parameters
+   *
+   * @param u8_SampleSize           The resolution of the samples in bits (1 to 16)
+   * @param u8_BlockSize            The number of samples per block J (8, 16, 32 or 64)
+   * @param u16_ReferenceInterval   The number of blocks per reference sample interval r (1 to 4096)
+   * @param b_Preprocessor          true if the unit-delay predictor and the mapper are used
+   * @param b_Signed                true if the samples are signed (two's complement)
+   *
+   * @retval  0  If the parameters were set
+   * @retval -1  If a parameter is invalid, the previous parameters are kept
+   */
+  int32_t Rice::setParameters(const uint8_t u8_SampleSize, const uint8_t u8_BlockSize, const uint16_t u16_ReferenceInterval,
+                              const bool b_Preprocessor, const bool b_Signed)
+  {
+    if((u8_SampleSize<1) || (u8_SampleSize>MaxSampleSize))
+      return -1;
+    if((u8_BlockSize!=8) && (u8_BlockSize!=16) && (u8_BlockSize!=32) && (u8_BlockSize!=64))
+      return -1;
+    if((u16_ReferenceInterval<1) || (u16_ReferenceInterval>MaxReferenceInterval))
+      return -1;
+
+    mu8_SampleSize = u8_SampleSize;
+    mu8_BlockSize = u8_BlockSize;
+    mu16_ReferenceInterval = u16_ReferenceInterval;
+    mb_Preprocessor = b_Preprocessor;
+    mb_Signed = b_Signed;
+
+    // the ID has 3 bits for up to 8 bit samples and 4 bits for up to 16 bit samples
+    mu8_IdSize = (u8_SampleSize>8)?4:3;
+    mu8_MaxSplit = (uint8_t)((1<<mu8_IdSize)-3);
+    if(mu8_MaxSplit>u8_SampleSize-1)
+      mu8_MaxSplit = (uint8_t)(u8_SampleSize-1);
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Compresses the samples into the given buffer
+   *
+   * Only the lower u8_SampleSize bits of the samples are used; signed samples may be given sign-extended.
+   *
+   * @param pu8_Buffer        A pointer to the buffer where the compressed data shall be stored
+   * @param u32_BufferSize    The available size of the buffer
+   * @param pu16_Samples      A pointer to the samples
+   * @param u32_SampleCount   The number of samples
+   *
+   * @return     The size of the compressed data in bytes
+   * @retval  0  If the parameters are invalid or the buffer is too small
+   */
+  uint32_t Rice::encode(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                        const uint16_t *pu16_Samples, const uint32_t u32_SampleCount)
+  {
+    const uint16_t u16_Mask = (uint16_t)((1UL<<mu8_SampleSize)-1);
+    const uint8_t u8_NoCompressionId = (uint8_t)((1<<mu8_IdSize)-1);
+    const uint32_t u32_BlockCount = (u32_SampleCount+mu8_BlockSize-1)/mu8_BlockSize;
+    BitWriter S_Writer = {pu8_Buffer, u32_BufferSize, 0, 0, 0, false};
+    uint16_t au16_Block[MaxBlockSize];
+    uint16_t au16_Mapped[MaxBlockSize];
+    uint16_t u16_Prediction=0;
+    uint16_t u16_BlockIndex;
+    uint32_t u32_ZeroBlocks=0;
+    bool b_ZeroReference=false;
+    uint16_t u16_ZeroReferenceSample=0;
+    bool b_Reference;
+    uint8_t u8_First;
+    uint32_t u32_Sum;
+    bool b_SegmentEnd;
+
+    if(!pu8_Buffer || !pu16_Samples || (u32_SampleCount==0))
+      return 0;
+
+    for(uint32_t u32_Block=0; u32_Block<u32_BlockCount; u32_Block++)
+    {
+      u16_BlockIndex = (uint16_t)(u32_Block%mu16_ReferenceInterval);
+      b_Reference = mb_Preprocessor && (u16_BlockIndex==0);
+      u8_First = b_Reference?1:0;
+
+      // the last block is filled up with the last sample
+      for(uint8_t i=0; i<mu8_BlockSize; i++)
+      {
+        const uint32_t u32_Index = u32_Block*mu8_BlockSize+i;
+        au16_Block[i] = (uint16_t)(pu16_Samples[(u32_Index<u32_SampleCount)?u32_Index:(u32_SampleCount-1)]&u16_Mask);
+      }
+
+      if(mb_Preprocessor)
+      {
+        if(b_Reference)
+        {
+          au16_Mapped[0] = 0;
+          u16_Prediction = au16_Block[0];
+        }
+        _map(&au16_Block[u8_First], u16_Prediction, &au16_Mapped[u8_First], (uint8_t)(mu8_BlockSize-u8_First));
+        u16_Prediction = au16_Block[mu8_BlockSize-1];
+      }
+      else
+      {
+        memcpy(au16_Mapped, au16_Block, mu8_BlockSize*sizeof(uint16_t));
+      }
+
+      u32_Sum = 0;
+      for(uint8_t i=u8_First; i<mu8_BlockSize; i++)
+        u32_Sum += au16_Mapped[i];
+
+      // zero blocks are collected up to the end of a segment (64 blocks) or reference sample interval
+      b_SegmentEnd = (((u16_BlockIndex+1)%SegmentSize)==0) || (u16_BlockIndex+1==mu16_ReferenceInterval) || (u32_Block+1==u32_BlockCount);
+      if((u32_Sum!=0) && (u32_ZeroBlocks>0))
+      {
+        putBits(&S_Writer, 0, (uint8_t)(mu8_IdSize+1));
+        if(b_ZeroReference)
+          putBits(&S_Writer, u16_ZeroReferenceSample, mu8_SampleSize);
+        putFundamentalSequence(&S_Writer, (u32_ZeroBlocks<=RemainderOfSegment)?u32_ZeroBlocks-1:u32_ZeroBlocks);
+        u32_ZeroBlocks = 0;
+      }
+      if(u32_Sum==0)
+      {
+        if(u32_ZeroBlocks==0)
+        {
+          b_ZeroReference = b_Reference;
+          u16_ZeroReferenceSample = au16_Block[0];
+        }
+        u32_ZeroBlocks++;
+        if(b_SegmentEnd)
+        {
+          putBits(&S_Writer, 0, (uint8_t)(mu8_IdSize+1));
+          if(b_ZeroReference)
+            putBits(&S_Writer, u16_ZeroReferenceSample, mu8_SampleSize);
+          putFundamentalSequence(&S_Writer, (u32_ZeroBlocks>RemainderOfSegment)?RemainderOfSegment:u32_ZeroBlocks-1);
+          u32_ZeroBlocks = 0;
+        }
+        continue;
+      }
+
+      // select the option with the shortest code
+      const uint8_t u8_Samples = (uint8_t)(mu8_BlockSize-u8_First);
+      uint32_t u32_BestSize = (uint32_t)u8_Samples*mu8_SampleSize;
+      uint8_t u8_BestId = u8_NoCompressionId;
+      uint32_t u32_Size;
+      uint32_t u32_PrevSize = 0xffffffff;
+
+      for(uint8_t k=0; k<=mu8_MaxSplit; k++)
+      {
+        u32_Size = (uint32_t)u8_Samples*(k+1);
+        for(uint8_t i=u8_First; i<mu8_BlockSize; i++)
+          u32_Size += au16_Mapped[i]>>k;
+        if(u32_Size<u32_BestSize)
+        {
+          u32_BestSize = u32_Size;
+          u8_BestId = (uint8_t)(k+1);
+        }
+        // the code size is convex in k
+        if(u32_Size>=u32_PrevSize)
+          break;
+        u32_PrevSize = u32_Size;
+      }
+
+      // second extension: pairs of samples as one FS code; only useful for very low values
+      if(u32_Sum<(uint32_t)mu8_BlockSize*2)
+      {
+        u32_Size = 1;
+        for(uint8_t i=0; i<mu8_BlockSize; i+=2)
+        {
+          const uint32_t u32_Pair = (uint32_t)au16_Mapped[i]+au16_Mapped[i+1];
+          u32_Size += u32_Pair*(u32_Pair+1)/2+au16_Mapped[i+1]+1;
+        }
+        if(u32_Size<u32_BestSize)
+        {
+          u32_BestSize = u32_Size;
+          u8_BestId = 0;
+        }
+      }
+
+      putBits(&S_Writer, u8_BestId, mu8_IdSize);
+      if(u8_BestId==0)
+        putBits(&S_Writer, 1, 1);
+      if(b_Reference)
+        putBits(&S_Writer, au16_Block[0], mu8_SampleSize);
+
+      if(u8_BestId==0)
+      {
+        for(uint8_t i=0; i<mu8_BlockSize; i+=2)
+        {
+          const uint32_t u32_Pair = (uint32_t)au16_Mapped[i]+au16_Mapped[i+1];
+          putFundamentalSequence(&S_Writer, u32_Pair*(u32_Pair+1)/2+au16_Mapped[i+1]);
+        }
+      }
+      else if(u8_BestId==u8_NoCompressionId)
+      {
+        for(uint8_t i=u8_First; i<mu8_BlockSize; i++)
+          putBits(&S_Writer, au16_Mapped[i], mu8_SampleSize);
+      }
+      else
+      {
+        const uint8_t k = (uint8_t)(u8_BestId-1);
+        for(uint8_t i=u8_First; i<mu8_BlockSize; i++)
+          putFundamentalSequence(&S_Writer, au16_Mapped[i]>>k);
+        if(k>0)
+        {
+          for(uint8_t i=u8_First; i<mu8_BlockSize; i++)
+            putBits(&S_Writer, au16_Mapped[i], k);
+        }
+      }
+
+      if(S_Writer.b_Overflow)
+        return 0;
+    }
+
+    if(S_Writer.u8_BitCount>0)
+      putBits(&S_Writer, 0, (uint8_t)(8-S_Writer.u8_BitCount));
+    if(S_Writer.b_Overflow)
+      return 0;
+
+    return S_Writer.u32_Pos;
+  }
+
+
+
+  /**
+   * @brief Creates a space packet whose data field holds the compressed samples
+   *
+   * The samples are compressed directly into the data field, so no intermediate buffer is needed.
+   *
+   * @param pu8_Buffer          A pointer to the buffer where the space packet shall be stored
+   * @param u32_BufferSize      The available size of the buffer
+   * @param e_PacketType        The type of the space packet (SpacePacket::TM or SpacePacket::TC)
+   * @param u16_APID            The application identifier (APID)
+   * @param u16_SequenceCount   The 14-bit sequence counter
+   * @param pu16_Samples        A pointer to the samples
+   * @param u32_SampleCount     The number of samples
+   *
+   * @return     The size of the created packet in bytes
+   * @retval  0  If no packet could be created
+   */
+  uint32_t Rice::createPacket(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                              const SpacePacket::PacketType e_PacketType, const uint16_t u16_APID, const uint16_t u16_SequenceCount,
+                              const uint16_t *pu16_Samples, const uint32_t u32_SampleCount)
+  {
+    uint32_t u32_DataSize;
+
+    if(!pu8_Buffer || (u32_BufferSize<=SP_HEADER_SIZE))
+      return 0;
+
+    // the packet data field is limited to 65536 bytes
+    u32_DataSize = encode(&pu8_Buffer[SP_HEADER_SIZE],
+                          (u32_BufferSize-SP_HEADER_SIZE>65536UL)?65536UL:u32_BufferSize-SP_HEADER_SIZE,
+                          pu16_Samples, u32_SampleCount);
+    if(u32_DataSize==0)
+      return 0;
+
+    SpacePacket::createPrimaryHeader(pu8_Buffer, e_PacketType, SpacePacket::Unsegmented, u16_APID, u16_SequenceCount,
+                                     false, u32_DataSize);
+
+    return SP_HEADER_SIZE+u32_DataSize;
+  }
+
+
+
+  /**
+   * @brief Decompresses the given data
+   *
+   * Signed samples are returned sign-extended to 16 bits.
+   *
+   * @param pu8_Data          A pointer to the compressed data
+   * @param u32_DataSize      The size of the compressed data in bytes
+   * @param pu16_Samples      A pointer to the buffer for the samples
+   * @param u32_SampleCount   The number of samples which shall be decoded
+   *
+   * @retval  0  If the samples were decoded
+   * @retval -1  If a parameter is invalid or the data is corrupt or too short
+   */
+  int32_t Rice::decode(const uint8_t *pu8_Data, const uint32_t u32_DataSize,
+                       uint16_t *pu16_Samples, const uint32_t u32_SampleCount)
+  {
+    const uint16_t u16_Mask = (uint16_t)((1UL<<mu8_SampleSize)-1);
+    const uint8_t u8_NoCompressionId = (uint8_t)((1<<mu8_IdSize)-1);
+    const uint32_t u32_BlockCount = (u32_SampleCount+mu8_BlockSize-1)/mu8_BlockSize;
+    BitReader S_Reader = {pu8_Data, u32_DataSize, 0, 0, false};
+    uint16_t au16_Mapped[MaxBlockSize];
+    uint16_t u16_Prediction=0;
+    uint16_t u16_BlockIndex;
+    uint32_t u32_Out=0;
+    uint32_t u32_Blocks;
+    uint32_t u32_Value;
+    bool b_Reference;
+    uint8_t u8_First;
+    uint8_t u8_Id;
+
+    if(!pu8_Data || !pu16_Samples || (u32_SampleCount==0))
+      return -1;
+
+    for(uint32_t u32_Block=0; u32_Block<u32_BlockCount; u32_Block+=u32_Blocks)
+    {
+      u16_BlockIndex = (uint16_t)(u32_Block%mu16_ReferenceInterval);
+      b_Reference = mb_Preprocessor && (u16_BlockIndex==0);
+      u8_First = b_Reference?1:0;
+      u32_Blocks = 1;
+
+      u8_Id = (uint8_t)getBits(&S_Reader, mu8_IdSize);
+      if(u8_Id==0)
+        u8_Id = (uint8_t)(getBits(&S_Reader, 1)?0:0xff);   // 0: second extension, 0xff: zero block
+      if(b_Reference)
+      {
+        u16_Prediction = (uint16_t)getBits(&S_Reader, mu8_SampleSize);
+        au16_Mapped[0] = 0;
+      }
+
+      if(u8_Id==0xff)
+      {
+        u32_Value = getFundamentalSequence(&S_Reader);
+        if(u32_Value<RemainderOfSegment)
+          u32_Blocks = u32_Value+1;
+        else if(u32_Value>RemainderOfSegment)
+          u32_Blocks = u32_Value;
+        else
+        {
+          // remainder of the segment
+          u32_Blocks = SegmentSize-(u16_BlockIndex%SegmentSize);
+          if(u32_Blocks>(uint32_t)(mu16_ReferenceInterval-u16_BlockIndex))
+            u32_Blocks = mu16_ReferenceInterval-u16_BlockIndex;
+          if(u32_Blocks>u32_BlockCount-u32_Block)
+            u32_Blocks = u32_BlockCount-u32_Block;
+        }
+        if((u32_Blocks>u32_BlockCount-u32_Block) || (u32_Blocks>(uint32_t)(mu16_ReferenceInterval-u16_BlockIndex)))
+          return -1;
+        memset(au16_Mapped, 0, sizeof(au16_Mapped));
+      }
+      else if(u8_Id==0)
+      {
+        for(uint8_t i=u8_First; i<mu8_BlockSize; )
+        {
+          uint32_t u32_Pair=0;
+          u32_Value = getFundamentalSequence(&S_Reader);
+          while((u32_Pair+1)*(u32_Pair+2)/2<=u32_Value)
+            u32_Pair++;
+          const uint32_t u32_Second = u32_Value-u32_Pair*(u32_Pair+1)/2;
+          if((u32_Second>u16_Mask) || (u32_Pair-u32_Second>u16_Mask) || S_Reader.b_Underflow)
+            return -1;
+          if((i&1)==0)
+            au16_Mapped[i++] = (uint16_t)(u32_Pair-u32_Second);
+          au16_Mapped[i++] = (uint16_t)u32_Second;
+        }
+      }
+      else if(u8_Id==u8_NoCompressionId)
+      {
+        for(uint8_t i=u8_First; i<mu8_BlockSize; i++)
+          au16_Mapped[i] = (uint16_t)getBits(&S_Reader, mu8_SampleSize);
+      }
+      else
+      {
+        const uint8_t k = (uint8_t)(u8_Id-1);
+        for(uint8_t i=u8_First; i<mu8_BlockSize; i++)
+        {
+          u32_Value = getFundamentalSequence(&S_Reader);
+          if(u32_Value>(uint32_t)(u16_Mask>>k))
+            return -1;
+          au16_Mapped[i] = (uint16_t)(u32_Value<<k);
+        }
+        if(k>0)
+        {
+          for(uint8_t i=u8_First; i<mu8_BlockSize; i++)
+            au16_Mapped[i] |= (uint16_t)getBits(&S_Reader, k);
+        }
+      }
+
+      if(S_Reader.b_Underflow)
+        return -1;
+
+      // reconstruct the samples, the padding of the last block is dropped
+      for(uint32_t b=0; b<u32_Blocks; b++)
+      {
+        for(uint8_t i=0; i<mu8_BlockSize; i++)
+        {
+          uint16_t u16_Sample;
+          if(b_Reference && (b==0) && (i==0))
+            u16_Sample = u16_Prediction;
+          else if(mb_Preprocessor)
+            u16_Sample = _unmap(u16_Prediction, au16_Mapped[i]);
+          else
+            u16_Sample = au16_Mapped[i];
+          u16_Prediction = u16_Sample;
+          if(u32_Out<u32_SampleCount)
+          {
+            if(mb_Signed && (u16_Sample&(1U<<(mu8_SampleSize-1))))
+              u16_Sample |= (uint16_t)~u16_Mask;
+            pu16_Samples[u32_Out++] = u16_Sample;
+          }
+        }
+      }
+    }
+
+    return 0;
+  }
+
+
+
+  // unit-delay prediction and mapping of the prediction error to a non-negative value
+  void Rice::_map(const uint16_t *pu16_Samples, uint16_t u16_Prediction, uint16_t *pu16_Mapped, const uint8_t u8_Count)
+  {
+    const int32_t i32_Min = mb_Signed?-(1L<<(mu8_SampleSize-1)):0;
+    const int32_t i32_Max = mb_Signed?(1L<<(mu8_SampleSize-1))-1:(1L<<mu8_SampleSize)-1;
+    const uint16_t u16_SignBit = mb_Signed?(uint16_t)(1U<<(mu8_SampleSize-1)):0;
+    int32_t i32_Sample, i32_Prediction, i32_Delta, i32_Theta;
+
+    i32_Prediction = (u16_Prediction&u16_SignBit)?(int32_t)u16_Prediction-(1L<<mu8_SampleSize):(int32_t)u16_Prediction;
+    for(uint8_t i=0; i<u8_Count; i++)
+    {
+      i32_Sample = (pu16_Samples[i]&u16_SignBit)?(int32_t)pu16_Samples[i]-(1L<<mu8_SampleSize):(int32_t)pu16_Samples[i];
+      i32_Delta = i32_Sample-i32_Prediction;
+      i32_Theta = (i32_Prediction-i32_Min<i32_Max-i32_Prediction)?i32_Prediction-i32_Min:i32_Max-i32_Prediction;
+
+      if((i32_Delta>=0) && (i32_Delta<=i32_Theta))
+        pu16_Mapped[i] = (uint16_t)(2*i32_Delta);
+      else if((i32_Delta<0) && (i32_Delta>=-i32_Theta))
+        pu16_Mapped[i] = (uint16_t)(-2*i32_Delta-1);
+      else
+        pu16_Mapped[i] = (uint16_t)(i32_Theta+((i32_Delta<0)?-i32_Delta:i32_Delta));
+
+      i32_Prediction = i32_Sample;
+    }
+  }
+
+
+
+  // inverse mapping, returns the sample in n bits
+  uint16_t Rice::_unmap(const uint16_t u16_Prediction, const uint16_t u16_Mapped)
+  {
+    const int32_t i32_Min = mb_Signed?-(1L<<(mu8_SampleSize-1)):0;
+    const int32_t i32_Max = mb_Signed?(1L<<(mu8_SampleSize-1))-1:(1L<<mu8_SampleSize)-1;
+    const uint16_t u16_SignBit = mb_Signed?(uint16_t)(1U<<(mu8_SampleSize-1)):0;
+    int32_t i32_Prediction, i32_Delta, i32_Theta;
+
+    i32_Prediction = (u16_Prediction&u16_SignBit)?(int32_t)u16_Prediction-(1L<<mu8_SampleSize):(int32_t)u16_Prediction;
+    i32_Theta = (i32_Prediction-i32_Min<i32_Max-i32_Prediction)?i32_Prediction-i32_Min:i32_Max-i32_Prediction;
+
+    if(u16_Mapped<=2*i32_Theta)
+      i32_Delta = (u16_Mapped&1)?-(int32_t)((u16_Mapped+1)/2):(int32_t)(u16_Mapped/2);
+    else if(i32_Prediction-i32_Min<i32_Max-i32_Prediction)
+      i32_Delta = u16_Mapped-i32_Theta;
+    else
+      i32_Delta = i32_Theta-u16_Mapped;
+
+    return (uint16_t)((i32_Prediction+i32_Delta)&((1L<<mu8_SampleSize)-1));
+  }
+
+}
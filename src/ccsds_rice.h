@@ -0,0 +1,100 @@
+/**
+ * @file      ccsds_rice.h
+ *
+ * @brief     Include file of the lossless data compression (Rice) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_RICE_H_
+#define _CCSDS_RICE_H_
+
+/****************************************************************/
+/* Lossless data compression according to                       */
+/*                                                              */
+/*  - CCSDS 121.0-B-3, - Lossless Data Compression              */
+/*    https://public.ccsds.org/Pubs/121x0b3.pdf                 */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - The sample resolution is limited to 16 bits               */
+/*  - Only the unit-delay predictor is supported                */
+/*  - The restricted code options for n <= 4 are not supported  */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "ccsds_spacepacket.h"
+
+
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Class for compressing and decompressing samples with the adaptive entropy coder of CCSDS 121.0-B-3.
+   *
+   * The samples are divided into blocks of J samples. For each block, the coder selects the code option which
+   * results in the shortest code: the zero-block option for runs of blocks which contain only zeros, the second
+   * extension option for blocks with very low values, the split-sample options with k = 0 (fundamental sequence)
+   * up to 13 least significant bits sent uncoded, or no compression. The option is signalled by an ID in front
+   * of each block, so the decoder needs the same parameters as the encoder but no further side information.
+   *
+   * If the preprocessor is enabled, the samples are predicted from the previous sample (unit-delay predictor)
+   * and the prediction errors are mapped to non-negative values. The first block of each reference sample
+   * interval (r blocks) contains the uncoded reference sample, so the decoding can restart there.
+   *
+   * The compressed data is written as one continuous bit stream without padding, only the end is padded to a
+   * full byte. The last block is filled up with the last sample; the decoder needs the number of samples, which
+   * is usually known from the instrument configuration or sent in front of the compressed data.
+   *
+   * createPacket() compresses the samples directly into the data field of a space packet. On the receiving
+   * side, decode() is called with the packet data from SpacePacketActionInterface::onSpacePacketReceived().
+   */
+  class Rice
+  {
+  public:
+    static const uint8_t MaxSampleSize = 16;
+    static const uint8_t MaxBlockSize = 64;
+    static const uint16_t MaxReferenceInterval = 4096;
+
+  private:
+    const static uint8_t SegmentSize = 64;          // blocks per segment of the zero-block option
+    const static uint8_t RemainderOfSegment = 4;    // FS code of the zero-block option for the rest of the segment
+
+    uint8_t mu8_SampleSize;
+    uint8_t mu8_BlockSize;
+    uint16_t mu16_ReferenceInterval;
+    bool mb_Preprocessor;
+    bool mb_Signed;
+    uint8_t mu8_IdSize;
+    uint8_t mu8_MaxSplit;
+
+  public:
+    Rice(const uint8_t u8_SampleSize = 8, const uint8_t u8_BlockSize = 16, const uint16_t u16_ReferenceInterval = 128,
+         const bool b_Preprocessor = true, const bool b_Signed = false);
+
+    int32_t setParameters(const uint8_t u8_SampleSize, const uint8_t u8_BlockSize, const uint16_t u16_ReferenceInterval,
+                          const bool b_Preprocessor = true, const bool b_Signed = false);
+
+    uint32_t encode(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                    const uint16_t *pu16_Samples, const uint32_t u32_SampleCount);
+
+    uint32_t createPacket(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                          const SpacePacket::PacketType e_PacketType, const uint16_t u16_APID, const uint16_t u16_SequenceCount,
+                          const uint16_t *pu16_Samples, const uint32_t u32_SampleCount);
+
+    int32_t decode(const uint8_t *pu8_Data, const uint32_t u32_DataSize,
+                   uint16_t *pu16_Samples, const uint32_t u32_SampleCount);
+
+  private:
+    void _map(const uint16_t *pu16_Samples, uint16_t u16_Prediction, uint16_t *pu16_Mapped, const uint8_t u8_Count);
+    uint16_t _unmap(const uint16_t u16_Prediction, const uint16_t u16_Mapped);
+  };
+
+}
+
+#endif // _CCSDS_RICE_H_
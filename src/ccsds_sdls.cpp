@@ -0,0 +1,659 @@
+/**
+ * @file      ccsds_sdls.cpp
+ *
+ * @brief     Source file of the Space Data Link Security (SDLS) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "ccsds_sdls.h"
+#include "ccsds_transferframe.h"
+
+
+#if SDLS_MAX_SA > 0
+
+namespace CCSDS
+{
+  // reduction of the 4 bits which are shifted out of the GHASH value (polynomial x^128 + x^7 + x^2 + x + 1)
+  static const uint16_t au16_HashReduction[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+  };
+
+  static inline uint64_t readU64(const uint8_t *pu8_Buffer)
+  {
+    uint64_t u64_Value=0;
+    for(uint8_t i=0; i<8; i++)
+      u64_Value = (u64_Value<<8) | pu8_Buffer[i];
+    return u64_Value;
+  }
+
+  static inline void writeU64(uint8_t *pu8_Buffer, uint64_t u64_Value)
+  {
+    for(uint8_t i=8; i>0; i--)
+    {
+      pu8_Buffer[i-1] = (uint8_t)(u64_Value&0xff);
+      u64_Value >>= 8;
+    }
+  }
+
+  static inline void shiftSubkey(uint8_t *pu8_Key)
+  {
+    const uint8_t u8_Carry = (pu8_Key[0]&0x80)?0x87:0x00;
+    for(uint8_t i=0; i<Aes::BlockSize-1; i++)
+      pu8_Key[i] = (uint8_t)((pu8_Key[i]<<1) | (pu8_Key[i+1]>>7));
+    pu8_Key[Aes::BlockSize-1] = (uint8_t)((pu8_Key[Aes::BlockSize-1]<<1) ^ u8_Carry);
+  }
+
+
+
+  /**
+   * @brief Construct a new Sdls object without security associations
+   */
+  Sdls::Sdls(void)
+    : mu16_SpiErrorCount{0}
+    , mu16_ReplayErrorCount{0}
+    , mu16_AuthErrorCount{0}
+  {
+    for(uint16_t i=0; i<SDLS_MAX_SA; i++)
+      maS_SA[i].u16_SPI = 0;
+  }
+
+
+
+  /**
+   * @brief Adds a security association for a virtual channel
+   *
+   * The sequence numbers start at 0, the first frame is sent with sequence number 1. If the SA is used
+   * after a restart, the sequence numbers must be restored with setSequenceNumbers().
+   *
+   * @param u16_SPI               The security parameter index (1 to 65535)
+   * @param u8_VirtualChannelID   The virtual channel which is protected by the SA
+   * @param e_ServiceType         The cryptographic service
+   * @param pu8_Key               A pointer to the AES key
+   * @param u8_KeySize            The size of the key in bytes (16, 24 or 32)
+   * @param u8_MacSize            The size of the MAC in bytes (MinMacSize to MaxMacSize)
+   * @param u32_ReplayWindow      The maximum increase of the sequence number between two accepted frames
+   *                              (0 for no limit)
+   *
+   * @retval  0  If the SA was added
+   * @retval -1  If a parameter is invalid
+   * @retval -2  If the SPI is already used or no free entry is available
+   */
+  int32_t Sdls::addSecurityAssociation(const uint16_t u16_SPI, const uint8_t u8_VirtualChannelID,
+                                       const enum ServiceType e_ServiceType,
+                                       const uint8_t *pu8_Key, const uint8_t u8_KeySize,
+                                       const uint8_t u8_MacSize, const uint32_t u32_ReplayWindow)
+  {
+    SecurityAssociation *pS_SA=nullptr;
+
+    if((u16_SPI==0) || !pu8_Key || (u8_MacSize<MinMacSize) || (u8_MacSize>MaxMacSize))
+      return -1;
+    if((e_ServiceType!=Authentication) && (e_ServiceType!=AuthenticatedEncryption))
+      return -1;
+    if(_findSA(u16_SPI))
+      return -2;
+
+    for(uint16_t i=0; i<SDLS_MAX_SA; i++)
+    {
+      if(maS_SA[i].u16_SPI==0)
+      {
+        pS_SA = &maS_SA[i];
+        break;
+      }
+    }
+    if(!pS_SA)
+      return -2;
+
+    if(pS_SA->Cipher.setKey(pu8_Key, u8_KeySize)<0)
+      return -1;
+
+    pS_SA->u16_SPI = u16_SPI;
+    pS_SA->u8_VirtualChannelID = u8_VirtualChannelID;
+    pS_SA->u8_MacSize = u8_MacSize;
+    pS_SA->e_ServiceType = e_ServiceType;
+    pS_SA->u32_TxSequenceNumber = 0;
+    pS_SA->u32_RxSequenceNumber = 0;
+    pS_SA->u32_ReplayWindow = u32_ReplayWindow;
+    if(e_ServiceType==AuthenticatedEncryption)
+      _initHash(pS_SA);
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Removes a security association and clears its key material
+   *
+   * @param u16_SPI   The security parameter index
+   *
+   * @retval  0  If the SA was removed
+   * @retval -2  If the SPI is unknown
+   */
+  int32_t Sdls::removeSecurityAssociation(const uint16_t u16_SPI)
+  {
+    SecurityAssociation *pS_SA=_findSA(u16_SPI);
+
+    if(!pS_SA)
+      return -2;
+
+    pS_SA->Cipher.clearKey();
+    memset(pS_SA->au64_HashHigh, 0, sizeof(pS_SA->au64_HashHigh));
+    memset(pS_SA->au64_HashLow, 0, sizeof(pS_SA->au64_HashLow));
+    pS_SA->u16_SPI = 0;
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Sets the sequence numbers of a security association, e.g. to restore them after a restart
+   *
+   * @param u16_SPI                 The security parameter index
+   * @param u32_TxSequenceNumber    The sequence number of the last sent frame
+   * @param u32_RxSequenceNumber    The sequence number of the last accepted frame
+   *
+   * @retval  0  If the sequence numbers were set
+   * @retval -2  If the SPI is unknown
+   */
+  int32_t Sdls::setSequenceNumbers(const uint16_t u16_SPI, const uint32_t u32_TxSequenceNumber, const uint32_t u32_RxSequenceNumber)
+  {
+    SecurityAssociation *pS_SA=_findSA(u16_SPI);
+
+    if(!pS_SA)
+      return -2;
+
+    pS_SA->u32_TxSequenceNumber = u32_TxSequenceNumber;
+    pS_SA->u32_RxSequenceNumber = u32_RxSequenceNumber;
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Reads the sequence numbers of a security association, e.g. to store them before a restart
+   *
+   * @param u16_SPI                 The security parameter index
+   * @param pu32_TxSequenceNumber   A pointer to the sequence number of the last sent frame (may be NULL)
+   * @param pu32_RxSequenceNumber   A pointer to the sequence number of the last accepted frame (may be NULL)
+   *
+   * @retval  0  If the sequence numbers were read
+   * @retval -2  If the SPI is unknown
+   */
+  int32_t Sdls::getSequenceNumbers(const uint16_t u16_SPI, uint32_t *pu32_TxSequenceNumber, uint32_t *pu32_RxSequenceNumber)
+  {
+    SecurityAssociation *pS_SA=_findSA(u16_SPI);
+
+    if(!pS_SA)
+      return -2;
+
+    if(pu32_TxSequenceNumber)
+      *pu32_TxSequenceNumber = pS_SA->u32_TxSequenceNumber;
+    if(pu32_RxSequenceNumber)
+      *pu32_RxSequenceNumber = pS_SA->u32_RxSequenceNumber;
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Returns the size of the security trailer (MAC) of a security association
+   *
+   * The data field of a frame must be HeaderSize+getTrailerSize() bytes larger than the data which is to be sent.
+   *
+   * @param u16_SPI   The security parameter index
+   *
+   * @return     The size of the security trailer in bytes
+   * @retval  0  If the SPI is unknown
+   */
+  uint8_t Sdls::getTrailerSize(const uint16_t u16_SPI)
+  {
+    SecurityAssociation *pS_SA=_findSA(u16_SPI);
+
+    return pS_SA?pS_SA->u8_MacSize:0;
+  }
+
+
+
+  /**
+   * @brief Returns if a virtual channel is protected by a security association
+   *
+   * @param u8_VirtualChannelID   The virtual channel
+   *
+   * @retval true   If an SA for the virtual channel exists
+   * @retval false  If the frames of the virtual channel are sent in clear
+   */
+  bool Sdls::isSecured(const uint8_t u8_VirtualChannelID)
+  {
+    for(uint16_t i=0; i<SDLS_MAX_SA; i++)
+    {
+      if(maS_SA[i].u16_SPI && (maS_SA[i].u8_VirtualChannelID==u8_VirtualChannelID))
+        return true;
+    }
+    return false;
+  }
+
+
+
+  /**
+   * @brief Applies the security of a security association to a frame in place
+   *
+   * The frame consists of the frame header (primary header and further headers, e.g. the TC segment header),
+   * the data field and the frame trailer (OCF and FECF). The data field starts with the security header and
+   * ends with the security trailer, both are written by this method; the data in between is encrypted
+   * according to the service of the SA.
+   *
+   * @param pu8_Frame             A pointer to the complete frame
+   * @param u16_FrameSize         The size of the frame in bytes
+   * @param u16_FrameHeaderSize   The size of the headers in front of the security header
+   * @param u16_FrameTrailerSize  The size of the fields behind the security trailer (OCF and FECF)
+   * @param u16_SPI               The security parameter index of the SA which is to be used
+   *
+   * @retval  0  If the security was applied
+   * @retval -1  If a parameter is invalid or the frame is too small
+   * @retval -2  If the SPI is unknown
+   * @retval -3  If the sequence numbers of the SA are exhausted (a new key is needed)
+   */
+  int32_t Sdls::applySecurity(uint8_t *pu8_Frame, const uint16_t u16_FrameSize,
+                              const uint16_t u16_FrameHeaderSize, const uint16_t u16_FrameTrailerSize,
+                              const uint16_t u16_SPI)
+  {
+    SecurityAssociation *pS_SA=_findSA(u16_SPI);
+    uint8_t au8_Iv[IvSize];
+    uint8_t au8_Mac[Aes::BlockSize];
+    uint8_t *pu8_SecurityHeader;
+    uint8_t *pu8_Data;
+    uint16_t u16_DataSize;
+
+    if(!pS_SA)
+      return -2;
+    if(!pu8_Frame || ((uint32_t)u16_FrameHeaderSize+HeaderSize+pS_SA->u8_MacSize+u16_FrameTrailerSize>u16_FrameSize))
+      return -1;
+#if TF_USE_FECF == 1
+    if(u16_FrameTrailerSize<FecfSize)
+      return -1;
+#endif
+    if(pS_SA->u32_TxSequenceNumber==0xffffffff)
+      return -3;
+
+    pS_SA->u32_TxSequenceNumber++;
+
+    pu8_SecurityHeader = &pu8_Frame[u16_FrameHeaderSize];
+    pu8_Data = &pu8_SecurityHeader[HeaderSize];
+    u16_DataSize = u16_FrameSize-u16_FrameHeaderSize-HeaderSize-pS_SA->u8_MacSize-u16_FrameTrailerSize;
+
+    pu8_SecurityHeader[0] = (uint8_t)(u16_SPI>>8);
+    pu8_SecurityHeader[1] = (uint8_t)(u16_SPI&0xff);
+    pu8_SecurityHeader[2] = (uint8_t)(pS_SA->u32_TxSequenceNumber>>24);
+    pu8_SecurityHeader[3] = (uint8_t)(pS_SA->u32_TxSequenceNumber>>16);
+    pu8_SecurityHeader[4] = (uint8_t)(pS_SA->u32_TxSequenceNumber>>8);
+    pu8_SecurityHeader[5] = (uint8_t)(pS_SA->u32_TxSequenceNumber&0xff);
+
+    if(pS_SA->e_ServiceType==AuthenticatedEncryption)
+    {
+      memset(au8_Iv, 0, IvSize-SequenceNumberSize);
+      memcpy(&au8_Iv[IvSize-SequenceNumberSize], &pu8_SecurityHeader[SpiSize], SequenceNumberSize);
+      _applyCounterMode(pS_SA, au8_Iv, pu8_Data, u16_DataSize);
+      _calcGcmTag(pS_SA, au8_Iv, pu8_Frame, u16_FrameHeaderSize+HeaderSize, pu8_Data, u16_DataSize, au8_Mac);
+    }
+    else
+    {
+      _calcCmac(pS_SA, pu8_Frame, (uint32_t)u16_FrameHeaderSize+HeaderSize+u16_DataSize, au8_Mac);
+    }
+    memcpy(&pu8_Data[u16_DataSize], au8_Mac, pS_SA->u8_MacSize);
+
+#if TF_USE_FECF == 1
+    uint16_t u16_CRC = Transferframe::calcCRC(pu8_Frame, u16_FrameSize-FecfSize);
+    pu8_Frame[u16_FrameSize-2] = (uint8_t)(u16_CRC>>8);
+    pu8_Frame[u16_FrameSize-1] = (uint8_t)(u16_CRC&0xff);
+#endif
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Checks the security of a received frame and decrypts its data in place
+   *
+   * The SPI of the security header must belong to an SA of the given virtual channel, the sequence number
+   * must pass the anti-replay check and the MAC must be valid; only then the data is decrypted and the
+   * sequence number of the SA is updated. The FECF is not checked, this is done by the transfer frame classes.
+   *
+   * @param pu8_Frame             A pointer to the complete frame
+   * @param u16_FrameSize         The size of the frame in bytes
+   * @param u16_FrameHeaderSize   The size of the headers in front of the security header
+   * @param u16_FrameTrailerSize  The size of the fields behind the security trailer (OCF and FECF)
+   * @param u8_VirtualChannelID   The virtual channel of the frame
+   * @param ppu8_Data             Returns a pointer to the (decrypted) data within the frame
+   * @param pu16_DataSize         Returns the size of the data in bytes
+   *
+   * @retval  0  If the frame is valid
+   * @retval -1  If a parameter is invalid or the frame is too small
+   * @retval -2  If the SPI is unknown or belongs to another virtual channel
+   * @retval -3  If the sequence number was rejected (replay)
+   * @retval -4  If the MAC is invalid
+   */
+  int32_t Sdls::processSecurity(uint8_t *pu8_Frame, const uint16_t u16_FrameSize,
+                                const uint16_t u16_FrameHeaderSize, const uint16_t u16_FrameTrailerSize,
+                                const uint8_t u8_VirtualChannelID,
+                                uint8_t **ppu8_Data, uint16_t *pu16_DataSize)
+  {
+    SecurityAssociation *pS_SA;
+    uint8_t au8_Iv[IvSize];
+    uint8_t au8_Mac[Aes::BlockSize];
+    uint8_t *pu8_SecurityHeader;
+    uint8_t *pu8_Data;
+    uint16_t u16_DataSize;
+    uint32_t u32_SequenceNumber;
+    uint8_t u8_Difference=0;
+
+    if(!pu8_Frame || !ppu8_Data || !pu16_DataSize || ((uint32_t)u16_FrameHeaderSize+HeaderSize+u16_FrameTrailerSize>u16_FrameSize))
+      return -1;
+
+    pu8_SecurityHeader = &pu8_Frame[u16_FrameHeaderSize];
+    pS_SA = _findSA((uint16_t)(((uint16_t)pu8_SecurityHeader[0]<<8) | (uint16_t)pu8_SecurityHeader[1]));
+    if(!pS_SA || (pS_SA->u8_VirtualChannelID!=u8_VirtualChannelID)
+       || ((uint32_t)u16_FrameHeaderSize+HeaderSize+pS_SA->u8_MacSize+u16_FrameTrailerSize>u16_FrameSize))
+    {
+      if(mu16_SpiErrorCount<0xffff)
+        mu16_SpiErrorCount++;
+      return -2;
+    }
+
+    u32_SequenceNumber = ((uint32_t)pu8_SecurityHeader[2]<<24) | ((uint32_t)pu8_SecurityHeader[3]<<16) | ((uint32_t)pu8_SecurityHeader[4]<<8) | (uint32_t)pu8_SecurityHeader[5];
+    if((u32_SequenceNumber<=pS_SA->u32_RxSequenceNumber)
+       || (pS_SA->u32_ReplayWindow && (u32_SequenceNumber-pS_SA->u32_RxSequenceNumber>pS_SA->u32_ReplayWindow)))
+    {
+      if(mu16_ReplayErrorCount<0xffff)
+        mu16_ReplayErrorCount++;
+      return -3;
+    }
+
+    pu8_Data = &pu8_SecurityHeader[HeaderSize];
+    u16_DataSize = u16_FrameSize-u16_FrameHeaderSize-HeaderSize-pS_SA->u8_MacSize-u16_FrameTrailerSize;
+
+    // the MAC is checked before anything is decrypted
+    if(pS_SA->e_ServiceType==AuthenticatedEncryption)
+    {
+      memset(au8_Iv, 0, IvSize-SequenceNumberSize);
+      memcpy(&au8_Iv[IvSize-SequenceNumberSize], &pu8_SecurityHeader[SpiSize], SequenceNumberSize);
+      _calcGcmTag(pS_SA, au8_Iv, pu8_Frame, u16_FrameHeaderSize+HeaderSize, pu8_Data, u16_DataSize, au8_Mac);
+    }
+    else
+    {
+      _calcCmac(pS_SA, pu8_Frame, (uint32_t)u16_FrameHeaderSize+HeaderSize+u16_DataSize, au8_Mac);
+    }
+    for(uint8_t i=0; i<pS_SA->u8_MacSize; i++)
+      u8_Difference |= (uint8_t)(au8_Mac[i]^pu8_Data[u16_DataSize+i]);
+    if(u8_Difference)
+    {
+      if(mu16_AuthErrorCount<0xffff)
+        mu16_AuthErrorCount++;
+      return -4;
+    }
+
+    if(pS_SA->e_ServiceType==AuthenticatedEncryption)
+      _applyCounterMode(pS_SA, au8_Iv, pu8_Data, u16_DataSize);
+    pS_SA->u32_RxSequenceNumber = u32_SequenceNumber;
+
+    *ppu8_Data = pu8_Data;
+    *pu16_DataSize = u16_DataSize;
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Returns the number of frames with an unknown SPI or an SPI of another virtual channel
+   *
+   * @return The number of errors as uint16_t
+   */
+  uint16_t Sdls::getSpiErrorCount(void)
+  {
+    return mu16_SpiErrorCount;
+  }
+
+
+
+  /**
+   * @brief Returns the number of frames which were rejected by the anti-replay check
+   *
+   * @return The number of errors as uint16_t
+   */
+  uint16_t Sdls::getReplayErrorCount(void)
+  {
+    return mu16_ReplayErrorCount;
+  }
+
+
+
+  /**
+   * @brief Returns the number of frames with an invalid MAC
+   *
+   * @return The number of errors as uint16_t
+   */
+  uint16_t Sdls::getAuthErrorCount(void)
+  {
+    return mu16_AuthErrorCount;
+  }
+
+
+
+  /**
+   * @brief Resets all error counters
+   */
+  void Sdls::clearErrorCounters(void)
+  {
+    mu16_SpiErrorCount = 0;
+    mu16_ReplayErrorCount = 0;
+    mu16_AuthErrorCount = 0;
+  }
+
+
+
+  Sdls::SecurityAssociation *Sdls::_findSA(const uint16_t u16_SPI)
+  {
+    if(u16_SPI==0)
+      return nullptr;
+
+    for(uint16_t i=0; i<SDLS_MAX_SA; i++)
+    {
+      if(maS_SA[i].u16_SPI==u16_SPI)
+        return &maS_SA[i];
+    }
+    return nullptr;
+  }
+
+
+
+  // precalculates the products of the GHASH key H = E(0) with all 4 bit values
+  void Sdls::_initHash(SecurityAssociation *pS_SA)
+  {
+    uint8_t au8_H[Aes::BlockSize];
+    uint64_t u64_High, u64_Low;
+    uint64_t u64_Reduction;
+
+    memset(au8_H, 0, Aes::BlockSize);
+    pS_SA->Cipher.encrypt(au8_H, au8_H);
+    u64_High = readU64(&au8_H[0]);
+    u64_Low = readU64(&au8_H[8]);
+
+    // the bit order of GHASH is reversed: index 8 is H, 4 is H*x, 2 is H*x^2 and 1 is H*x^3
+    pS_SA->au64_HashHigh[0] = 0;
+    pS_SA->au64_HashLow[0] = 0;
+    pS_SA->au64_HashHigh[8] = u64_High;
+    pS_SA->au64_HashLow[8] = u64_Low;
+    for(uint8_t i=4; i>0; i>>=1)
+    {
+      u64_Reduction = (u64_Low&1)?0xe100000000000000ULL:0;
+      u64_Low = (u64_High<<63) | (u64_Low>>1);
+      u64_High = (u64_High>>1) ^ u64_Reduction;
+      pS_SA->au64_HashHigh[i] = u64_High;
+      pS_SA->au64_HashLow[i] = u64_Low;
+    }
+    for(uint8_t i=2; i<=8; i<<=1)
+    {
+      for(uint8_t j=1; j<i; j++)
+      {
+        pS_SA->au64_HashHigh[i+j] = pS_SA->au64_HashHigh[i] ^ pS_SA->au64_HashHigh[j];
+        pS_SA->au64_HashLow[i+j] = pS_SA->au64_HashLow[i] ^ pS_SA->au64_HashLow[j];
+      }
+    }
+  }
+
+
+
+  // multiplies the hash value with H in GF(2^128), 4 bits at once
+  void Sdls::_multiplyHash(SecurityAssociation *pS_SA, uint8_t *pu8_Hash)
+  {
+    uint8_t u8_Nibble = pu8_Hash[15]&0x0f;
+    uint8_t u8_Remainder;
+    uint64_t u64_High = pS_SA->au64_HashHigh[u8_Nibble];
+    uint64_t u64_Low = pS_SA->au64_HashLow[u8_Nibble];
+
+    for(int8_t i=15; i>=0; i--)
+    {
+      if(i!=15)
+      {
+        u8_Nibble = pu8_Hash[i]&0x0f;
+        u8_Remainder = (uint8_t)(u64_Low&0x0f);
+        u64_Low = (u64_High<<60) | (u64_Low>>4);
+        u64_High = (u64_High>>4) ^ ((uint64_t)au16_HashReduction[u8_Remainder]<<48);
+        u64_High ^= pS_SA->au64_HashHigh[u8_Nibble];
+        u64_Low ^= pS_SA->au64_HashLow[u8_Nibble];
+      }
+      u8_Nibble = pu8_Hash[i]>>4;
+      u8_Remainder = (uint8_t)(u64_Low&0x0f);
+      u64_Low = (u64_High<<60) | (u64_Low>>4);
+      u64_High = (u64_High>>4) ^ ((uint64_t)au16_HashReduction[u8_Remainder]<<48);
+      u64_High ^= pS_SA->au64_HashHigh[u8_Nibble];
+      u64_Low ^= pS_SA->au64_HashLow[u8_Nibble];
+    }
+
+    writeU64(&pu8_Hash[0], u64_High);
+    writeU64(&pu8_Hash[8], u64_Low);
+  }
+
+
+
+  // adds the data to the hash value, the last block is padded with zeros
+  void Sdls::_updateHash(SecurityAssociation *pS_SA, uint8_t *pu8_Hash, const uint8_t *pu8_Data, const uint32_t u32_Size)
+  {
+    uint32_t u32_Pos=0;
+    uint8_t u8_BlockSize;
+
+    while(u32_Pos<u32_Size)
+    {
+      u8_BlockSize = (u32_Size-u32_Pos>Aes::BlockSize)?Aes::BlockSize:(uint8_t)(u32_Size-u32_Pos);
+      for(uint8_t i=0; i<u8_BlockSize; i++)
+        pu8_Hash[i] ^= pu8_Data[u32_Pos+i];
+      _multiplyHash(pS_SA, pu8_Hash);
+      u32_Pos += u8_BlockSize;
+    }
+  }
+
+
+
+  void Sdls::_calcGcmTag(SecurityAssociation *pS_SA, const uint8_t *pu8_Iv,
+                         const uint8_t *pu8_AuthData, const uint32_t u32_AuthDataSize,
+                         const uint8_t *pu8_CipherText, const uint32_t u32_CipherTextSize,
+                         uint8_t *pu8_Tag)
+  {
+    uint8_t au8_Hash[Aes::BlockSize];
+    uint8_t au8_Lengths[Aes::BlockSize];
+
+    memset(au8_Hash, 0, Aes::BlockSize);
+    _updateHash(pS_SA, au8_Hash, pu8_AuthData, u32_AuthDataSize);
+    _updateHash(pS_SA, au8_Hash, pu8_CipherText, u32_CipherTextSize);
+    writeU64(&au8_Lengths[0], (uint64_t)u32_AuthDataSize*8);
+    writeU64(&au8_Lengths[8], (uint64_t)u32_CipherTextSize*8);
+    _updateHash(pS_SA, au8_Hash, au8_Lengths, Aes::BlockSize);
+
+    // tag = E(J0) xor GHASH, J0 = IV || 1
+    memcpy(pu8_Tag, pu8_Iv, IvSize);
+    pu8_Tag[12] = 0;
+    pu8_Tag[13] = 0;
+    pu8_Tag[14] = 0;
+    pu8_Tag[15] = 1;
+    pS_SA->Cipher.encrypt(pu8_Tag, pu8_Tag);
+    for(uint8_t i=0; i<Aes::BlockSize; i++)
+      pu8_Tag[i] ^= au8_Hash[i];
+  }
+
+
+
+  // GCTR starting with the counter block IV || 2, encryption and decryption are the same
+  void Sdls::_applyCounterMode(SecurityAssociation *pS_SA, const uint8_t *pu8_Iv, uint8_t *pu8_Data, const uint32_t u32_Size)
+  {
+    uint8_t au8_Counter[Aes::BlockSize];
+    uint8_t au8_KeyStream[Aes::BlockSize];
+    uint32_t u32_Counter=2;
+    uint32_t u32_Pos=0;
+    uint8_t u8_BlockSize;
+
+    memcpy(au8_Counter, pu8_Iv, IvSize);
+    while(u32_Pos<u32_Size)
+    {
+      au8_Counter[12] = (uint8_t)(u32_Counter>>24);
+      au8_Counter[13] = (uint8_t)(u32_Counter>>16);
+      au8_Counter[14] = (uint8_t)(u32_Counter>>8);
+      au8_Counter[15] = (uint8_t)(u32_Counter&0xff);
+      pS_SA->Cipher.encrypt(au8_Counter, au8_KeyStream);
+
+      u8_BlockSize = (u32_Size-u32_Pos>Aes::BlockSize)?Aes::BlockSize:(uint8_t)(u32_Size-u32_Pos);
+      for(uint8_t i=0; i<u8_BlockSize; i++)
+        pu8_Data[u32_Pos+i] ^= au8_KeyStream[i];
+      u32_Pos += u8_BlockSize;
+      u32_Counter++;
+    }
+  }
+
+
+
+  void Sdls::_calcCmac(SecurityAssociation *pS_SA, const uint8_t *pu8_Data, const uint32_t u32_Size, uint8_t *pu8_Mac)
+  {
+    uint8_t au8_Subkey[Aes::BlockSize];
+    uint32_t u32_Pos=0;
+    uint8_t u8_LastSize;
+
+    // subkey K1 = L*x, K2 = L*x^2 with L = E(0)
+    memset(au8_Subkey, 0, Aes::BlockSize);
+    pS_SA->Cipher.encrypt(au8_Subkey, au8_Subkey);
+    shiftSubkey(au8_Subkey);
+
+    memset(pu8_Mac, 0, Aes::BlockSize);
+    while(u32_Size-u32_Pos>Aes::BlockSize)
+    {
+      for(uint8_t i=0; i<Aes::BlockSize; i++)
+        pu8_Mac[i] ^= pu8_Data[u32_Pos+i];
+      pS_SA->Cipher.encrypt(pu8_Mac, pu8_Mac);
+      u32_Pos += Aes::BlockSize;
+    }
+
+    // the last block is xored with K1 if it is complete, otherwise it is padded and xored with K2
+    u8_LastSize = (uint8_t)(u32_Size-u32_Pos);
+    for(uint8_t i=0; i<u8_LastSize; i++)
+      pu8_Mac[i] ^= pu8_Data[u32_Pos+i];
+    if(u8_LastSize<Aes::BlockSize)
+    {
+      pu8_Mac[u8_LastSize] ^= 0x80;
+      shiftSubkey(au8_Subkey);
+    }
+    for(uint8_t i=0; i<Aes::BlockSize; i++)
+      pu8_Mac[i] ^= au8_Subkey[i];
+    pS_SA->Cipher.encrypt(pu8_Mac, pu8_Mac);
+  }
+
+}
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * @file      ccsds_sdls.h
+ *
+ * @brief     Include file of the Space Data Link Security (SDLS) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_SDLS_H_
+#define _CCSDS_SDLS_H_
+
+/****************************************************************/
+/* Space Data Link Security according to                        */
+/*                                                              */
+/*  - CCSDS 355.0-B-2, - Space Data Link Security Protocol      */
+/*    https://public.ccsds.org/Pubs/355x0b2.pdf                 */
+/*  - CCSDS 352.0-B-2, - CCSDS Cryptographic Algorithms         */
+/*    https://public.ccsds.org/Pubs/352x0b2.pdf                 */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - The security header has a fixed layout: SPI (2 bytes) and */
+/*    sequence number (4 bytes), no padding field               */
+/*  - The frame headers are authenticated completely (no mask)  */
+/*  - Key management and SA management procedures are not       */
+/*    supported, the SAs are set up by the application          */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+
+#ifdef configSDLS_MAX_SA
+#define SDLS_MAX_SA configSDLS_MAX_SA
+#else
+#define SDLS_MAX_SA 8
+#endif
+
+
+#include "ccsds_aes.h"
+
+
+#if SDLS_MAX_SA > 0
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Class for applying and processing the security of transfer frames as described in CCSDS 355.0-B-2.
+   *
+   * A security association (SA) binds a virtual channel to a key, a cryptographic service and the anti-replay
+   * state. It is identified by the security parameter index (SPI), which is sent in the security header of each
+   * frame. Two services are supported:
+   *   - Authentication: the frame is authenticated with AES-CMAC, the data is sent in clear
+   *   - AuthenticatedEncryption: the data is encrypted and authenticated with AES-GCM; the frame headers and the
+   *     security header are authenticated as additional data
+   *
+   * The security is applied in place to a complete frame, which is created as usual (e.g. with
+   * TransferframeTc::create() or TransferframeTm::create()); its data field must start with HeaderSize reserved
+   * bytes for the security header and end with getTrailerSize() reserved bytes for the MAC. applySecurity()
+   * writes the security header, encrypts the data and writes the MAC; if TF_USE_FECF is set, the FECF is
+   * recalculated. Randomization must be applied after the security.
+   *
+   * The sequence number of each SA is increased for every frame and forms the last 4 bytes of the 12 byte GCM
+   * IV (the first 8 bytes are zero), so the same key and IV are never used twice. The receiver only accepts
+   * frames with a sequence number above the last accepted one (anti-replay); if a window is given, the sequence
+   * number may not exceed the last accepted one by more than the window.
+   *
+   * On the receiving side, an Sdls object is given to TransferframeTc::setSecurity() or
+   * TransferframeTm::setSecurity(); the frames are checked and decrypted in the frame buffer before the action
+   * interface is called, and frames which fail the check are dropped. Virtual channels without an SA (e.g. the
+   * idle channel) are passed in clear.
+   */
+  class Sdls
+  {
+  public:
+    static const uint8_t HeaderSize = 6;       /**< Size of the security header (SPI and sequence number) */
+    static const uint8_t MinMacSize = 4;
+    static const uint8_t MaxMacSize = 16;
+    static const int MaxSecurityAssociations = SDLS_MAX_SA;
+
+    /** The cryptographic service of a security association
+     */
+    enum ServiceType
+    {
+      Authentication = 1,             /**< AES-CMAC over the frame, data in clear */
+      AuthenticatedEncryption = 3     /**< AES-GCM, data encrypted */
+    };
+
+  private:
+    const static uint8_t SpiSize = 2;
+    const static uint8_t SequenceNumberSize = 4;
+    const static uint8_t IvSize = 12;
+    const static uint8_t FecfSize = 2;
+
+    struct SecurityAssociation
+    {
+      uint16_t u16_SPI;               // 0 if the entry is unused
+      uint8_t u8_VirtualChannelID;
+      uint8_t u8_MacSize;
+      enum ServiceType e_ServiceType;
+      uint32_t u32_TxSequenceNumber;  // last sent
+      uint32_t u32_RxSequenceNumber;  // last accepted
+      uint32_t u32_ReplayWindow;
+      Aes Cipher;
+      uint64_t au64_HashHigh[16];     // multiples of the GHASH key H by 4 bit values
+      uint64_t au64_HashLow[16];
+    };
+
+    SecurityAssociation maS_SA[SDLS_MAX_SA];
+
+    uint16_t mu16_SpiErrorCount;
+    uint16_t mu16_ReplayErrorCount;
+    uint16_t mu16_AuthErrorCount;
+
+  public:
+    Sdls(void);
+
+    // SA management
+    int32_t addSecurityAssociation(const uint16_t u16_SPI, const uint8_t u8_VirtualChannelID,
+                                   const enum ServiceType e_ServiceType,
+                                   const uint8_t *pu8_Key, const uint8_t u8_KeySize,
+                                   const uint8_t u8_MacSize = MaxMacSize, const uint32_t u32_ReplayWindow = 0);
+    int32_t removeSecurityAssociation(const uint16_t u16_SPI);
+    int32_t setSequenceNumbers(const uint16_t u16_SPI, const uint32_t u32_TxSequenceNumber, const uint32_t u32_RxSequenceNumber);
+    int32_t getSequenceNumbers(const uint16_t u16_SPI, uint32_t *pu32_TxSequenceNumber, uint32_t *pu32_RxSequenceNumber);
+    uint8_t getTrailerSize(const uint16_t u16_SPI);
+    bool isSecured(const uint8_t u8_VirtualChannelID);
+
+    // frame security
+    int32_t applySecurity(uint8_t *pu8_Frame, const uint16_t u16_FrameSize,
+                          const uint16_t u16_FrameHeaderSize, const uint16_t u16_FrameTrailerSize,
+                          const uint16_t u16_SPI);
+    int32_t processSecurity(uint8_t *pu8_Frame, const uint16_t u16_FrameSize,
+                            const uint16_t u16_FrameHeaderSize, const uint16_t u16_FrameTrailerSize,
+                            const uint8_t u8_VirtualChannelID,
+                            uint8_t **ppu8_Data, uint16_t *pu16_DataSize);
+
+    uint16_t getSpiErrorCount(void);
+    uint16_t getReplayErrorCount(void);
+    uint16_t getAuthErrorCount(void);
+    void clearErrorCounters(void);
+
+  private:
+    SecurityAssociation *_findSA(const uint16_t u16_SPI);
+    void _initHash(SecurityAssociation *pS_SA);
+    void _multiplyHash(SecurityAssociation *pS_SA, uint8_t *pu8_Hash);
+    void _updateHash(SecurityAssociation *pS_SA, uint8_t *pu8_Hash, const uint8_t *pu8_Data, const uint32_t u32_Size);
+    void _calcGcmTag(SecurityAssociation *pS_SA, const uint8_t *pu8_Iv,
+                     const uint8_t *pu8_AuthData, const uint32_t u32_AuthDataSize,
+                     const uint8_t *pu8_CipherText, const uint32_t u32_CipherTextSize,
+                     uint8_t *pu8_Tag);
+    void _applyCounterMode(SecurityAssociation *pS_SA, const uint8_t *pu8_Iv, uint8_t *pu8_Data, const uint32_t u32_Size);
+    void _calcCmac(SecurityAssociation *pS_SA, const uint8_t *pu8_Data, const uint32_t u32_Size, uint8_t *pu8_Mac);
+  };
+
+}
+
+#endif
+
+#endif // _CCSDS_SDLS_H_
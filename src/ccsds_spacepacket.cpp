@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include "ccsds_spacepacket.h"
+#include "ccsds_transferframe.h"
 
 
 namespace CCSDS 
@@ -31,6 +32,8 @@ namespace CCSDS
     , mu16_PacketSequenceCount{0}
     , mu16_PacketDataLength{0}
     , mb_Overflow{false}
+    , mb_CrcCalculation{false}
+    , mu16_Syndrome{0xffff}
     , mu16_SyncErrorCount{0}
     , mu16_OverflowErrorCount{0}
     , mp_ActionInterface{p_ActionInterface}
@@ -119,8 +122,8 @@ namespace CCSDS
       return 0;
     
     // create primary header
-    _create_primary_header(pu8_Buffer, e_PacketType, e_SequenceFlags, u16_APID, u16_SequenceCount,
-                           u16_SecondaryHeaderLength?true:false, (uint32_t)u16_SecondaryHeaderLength+(uint32_t)u16_PacketDataLength);
+    createPrimaryHeader(pu8_Buffer, e_PacketType, e_SequenceFlags, u16_APID, u16_SequenceCount,
+                        u16_SecondaryHeaderLength?true:false, (uint32_t)u16_SecondaryHeaderLength+(uint32_t)u16_PacketDataLength);
     
     if(u16_SecondaryHeaderLength>0)
       memcpy((char*)&pu8_Buffer[PrimaryHdrSize], (const char*)pu8_SecondaryHeaderData, u16_SecondaryHeaderLength);
@@ -155,8 +158,8 @@ namespace CCSDS
       return 0;
     
     // create primary header
-    _create_primary_header(pu8_Buffer, SpacePacket::TM, SpacePacket::Unsegmented, 0x7ff, u16_SequenceCount,
-                           false, (uint32_t)u16_TargetPacketSize-PrimaryHdrSize);
+    createPrimaryHeader(pu8_Buffer, SpacePacket::TM, SpacePacket::Unsegmented, 0x7ff, u16_SequenceCount,
+                        false, (uint32_t)u16_TargetPacketSize-PrimaryHdrSize);
     
     memset((char*)&pu8_Buffer[PrimaryHdrSize], 0xff, u16_TargetPacketSize-PrimaryHdrSize);
     
@@ -165,9 +168,26 @@ namespace CCSDS
   
   
   
-  int32_t SpacePacket::_create_primary_header(uint8_t *pu8_Buffer,
-                                              const PacketType e_PacketType, const SequenceFlags e_SequenceFlags, const uint16_t u16_APID, const uint16_t u16_SequenceCount, const bool b_SecHeader,
-                                              const uint32_t u32_PacketDataLength)
+  /**
+   * @brief Writes the 6 byte primary header of a Space Packet into the given buffer
+   *
+   * This method is used by create() and createIdle(), but it is also useful for protocols
+   * on top of Space Packets which have to know the primary header in advance (for example
+   * for the packet error control of PUS packets).
+   *
+   * @param pu8_Buffer           A pointer to the buffer where the header shall be stored (at least 6 bytes)
+   * @param e_PacketType         Identifies the type of Space Packet (SpacePacket::TM or SpacePacket::TC)
+   * @param e_SequenceFlags      Identifies that a packet belongs to a sequence of packets
+   * @param u16_APID             The application identifier (APID)
+   * @param u16_SequenceCount    The 14-bit sequence counter
+   * @param b_SecHeader          Flag if a secondary header is present
+   * @param u32_PacketDataLength The size of the packet data field (secondary header and data) in bytes
+   *
+   * @return 0
+   */
+  int32_t SpacePacket::createPrimaryHeader(uint8_t *pu8_Buffer,
+                                           const PacketType e_PacketType, const SequenceFlags e_SequenceFlags, const uint16_t u16_APID, const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                                           const uint32_t u32_PacketDataLength)
   {
     pu8_Buffer[0] = (uint8_t)(((SpPacketVersion&0x7)<<5) | ((e_PacketType&0x1)<<4) | ((b_SecHeader?1:0)<<3) | ((u16_APID>>8)&0x7));
     pu8_Buffer[1] = (uint8_t)(u16_APID&0xff);
@@ -197,6 +217,37 @@ namespace CCSDS
   
   
   
+  /**
+   * @brief Enables the calculation of the CRC-16 (polynom 0x1021) over each received space packet
+   *
+   * The checksum is calculated while the packet is parsed, so a Packet Error Control (PEC) field, e.g. of
+   * a PUS telecommand, can be verified without walking through the packet again (see getCrcSyndrome()).
+   *
+   * @param b_Enabled   true if the checksum is calculated
+   */
+  void SpacePacket::setCrcCalculation(const bool b_Enabled)
+  {
+    mb_CrcCalculation = b_Enabled;
+  }
+  
+  
+  
+  /**
+   * @brief Returns the CRC-16 syndrome over the complete last received space packet, including the primary header
+   *
+   * The syndrome is valid within SpacePacketActionInterface::onSpacePacketReceived() and until the next packet
+   * starts; the calculation must be enabled with setCrcCalculation(). The syndrome over a packet which ends with
+   * a correct CRC-16 is zero; it can be given to PUS::Tc::process().
+   *
+   * @return The syndrome as uint16_t
+   */
+  uint16_t SpacePacket::getCrcSyndrome(void)
+  {
+    return mu16_Syndrome;
+  }
+  
+  
+  
   /**
    * @brief The given upstream data is parsed for SpacePackets.
    *
@@ -216,6 +267,9 @@ namespace CCSDS
     
     for(uint32_t i=0; i<u32_BufferSize; i++)
     {
+      if(mb_CrcCalculation)
+        mu16_Syndrome = Transferframe::updateCRC((mu32_Index==0)?0xffff:mu16_Syndrome, pu8_Buffer[i]);
+      
       switch(mu32_Index)
       {
         case 0:
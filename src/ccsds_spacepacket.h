@@ -127,6 +127,8 @@ namespace CCSDS
     uint8_t au8_PacketData[SP_MAX_DATA_SIZE];
     
     bool mb_Overflow;
+    bool mb_CrcCalculation;
+    uint16_t mu16_Syndrome;
     uint16_t mu16_SyncErrorCount;
     uint16_t mu16_OverflowErrorCount;
     
@@ -153,15 +155,16 @@ namespace CCSDS
     // sp processing
     int32_t process(const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
     int32_t reset(void);
+    void setCrcCalculation(const bool b_Enabled);
+    uint16_t getCrcSyndrome(void);
     
     uint16_t getSyncErrorCount(void);
     uint16_t getOverflowErrorCount(void);
     void clearErrorCounters(void);
     
-  private:
-    static int32_t _create_primary_header(uint8_t *pu8_Buffer,
-                                          const PacketType e_PacketType, const SequenceFlags e_SequenceFlags, const uint16_t u16_APID, const uint16_t u16_SequenceCount, const bool b_SecHeader,
-                                          const uint32_t u32_PacketDataLength);
+    static int32_t createPrimaryHeader(uint8_t *pu8_Buffer,
+                                       const PacketType e_PacketType, const SequenceFlags e_SequenceFlags, const uint16_t u16_APID, const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                                       const uint32_t u32_PacketDataLength);
   };
   
 }
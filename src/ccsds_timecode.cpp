@@ -0,0 +1,382 @@
+/**
+ * @file      ccsds_timecode.cpp
+ *
+ * @brief     Source file of the time code (CUC / CDS) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include "ccsds_timecode.h"
+
+
+namespace CCSDS
+{
+  static const uint32_t NanosecondsPerSecond = 1000000000UL;
+  static const uint32_t SecondsPerDay = 86400UL;
+  static const uint32_t MillisecondsPerDay = 86400000UL;
+
+  // 2^62/10^9 rounded down: (ns*FractionFactor)>>30 is the 32 bit binary fraction of a second or at most one below,
+  // without a 64 bit division
+  static const uint64_t FractionFactor = 4611686018ULL;
+
+  // P-field time code identifications
+  static const uint8_t PFieldCucLevel1 = 0x10;    // CUC, epoch 1958-01-01 TAI
+  static const uint8_t PFieldCucLevel2 = 0x20;    // CUC, agency-defined epoch
+  static const uint8_t PFieldCds = 0x40;
+
+
+  static inline void putBigEndian(uint8_t *pu8_Buffer, uint32_t u32_Value, const uint8_t u8_Size)
+  {
+    for(uint8_t i=u8_Size; i>0; i--)
+    {
+      pu8_Buffer[i-1] = (uint8_t)u32_Value;
+      u32_Value >>= 8;
+    }
+  }
+
+  static inline uint32_t getBigEndian(const uint8_t *pu8_Data, const uint8_t u8_Size)
+  {
+    uint32_t u32_Value=0;
+
+    for(uint8_t i=0; i<u8_Size; i++)
+      u32_Value = (u32_Value<<8) | pu8_Data[i];
+    return u32_Value;
+  }
+
+
+
+  /**
+   * @brief Returns the preamble field (P-field) of the time code format
+   *
+   * @return The P-field octet
+   */
+  uint8_t TimeCode::getPField(void) const
+  {
+    if(me_Format==CUC)
+      return (uint8_t)((mb_AgencyEpoch?PFieldCucLevel2:PFieldCucLevel1) | ((mu8_CoarseSize-1)<<2) | mu8_FineSize);
+
+    return (uint8_t)(PFieldCds | (mb_AgencyEpoch?0x08:0) | ((mu8_CoarseSize==3)?0x04:0) | (mu8_FineSize/2));
+  }
+
+
+
+  /**
+   * @brief Sets the format from a received preamble field (P-field)
+   *
+   * The P-field is expected in front of the time codes afterwards.
+   *
+   * @param u8_PField   The P-field octet
+   *
+   * @retval  0  If the format was set
+   * @retval -1  If the P-field is extended or describes an unsupported format, the previous format is kept
+   */
+  int32_t TimeCode::setFromPField(const uint8_t u8_PField)
+  {
+    const uint8_t u8_Id = (uint8_t)(u8_PField&0xf0);
+
+    if((u8_Id==PFieldCucLevel1) || (u8_Id==PFieldCucLevel2))
+    {
+      me_Format = CUC;
+      mu8_CoarseSize = (uint8_t)(((u8_PField>>2)&0x03)+1);
+      mu8_FineSize = (uint8_t)(u8_PField&0x03);
+      mb_AgencyEpoch = (u8_Id==PFieldCucLevel2);
+    }
+    else if((u8_Id==PFieldCds) && ((u8_PField&0x03)!=0x03))
+    {
+      me_Format = CDS;
+      mu8_CoarseSize = (u8_PField&0x04)?3:2;
+      mu8_FineSize = (uint8_t)((u8_PField&0x03)*2);
+      mb_AgencyEpoch = (u8_PField&0x08)!=0;
+    }
+    else
+    {
+      return -1;
+    }
+
+    mb_PField = true;
+    mb_Valid = true;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Encodes the given time
+   *
+   * @param pu8_Buffer        A pointer to the buffer where the time code shall be stored
+   * @param u32_BufferSize    The available size of the buffer
+   * @param u32_Seconds       The seconds since the epoch
+   * @param u32_Nanoseconds   The nanoseconds of the second (0 to 999999999)
+   *
+   * @return     The size of the time code in bytes
+   * @retval  0  If the format is invalid, the buffer is too small or the time can not be represented
+   */
+  uint8_t TimeCode::encode(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                           const uint32_t u32_Seconds, const uint32_t u32_Nanoseconds) const
+  {
+    return _encode(pu8_Buffer, u32_BufferSize, u32_Seconds, u32_Nanoseconds);
+  }
+
+
+
+  /**
+   * @brief Encodes the given time
+   *
+   * @param pu8_Buffer        A pointer to the buffer where the time code shall be stored
+   * @param u32_BufferSize    The available size of the buffer
+   * @param u64_Nanoseconds   The nanoseconds since the epoch
+   *
+   * @return     The size of the time code in bytes
+   * @retval  0  If the format is invalid, the buffer is too small or the time can not be represented
+   */
+  uint8_t TimeCode::encode(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint64_t u64_Nanoseconds) const
+  {
+    const uint64_t u64_Seconds = u64_Nanoseconds/NanosecondsPerSecond;
+
+    return _encode(pu8_Buffer, u32_BufferSize, u64_Seconds, (uint32_t)(u64_Nanoseconds-u64_Seconds*NanosecondsPerSecond));
+  }
+
+
+
+  /**
+   * @brief Decodes a time code
+   *
+   * @param pu8_Data            A pointer to the time code
+   * @param u32_DataSize        The available size of the data
+   * @param pu32_Seconds        A pointer to the seconds since the epoch
+   * @param pu32_Nanoseconds    A pointer to the nanoseconds of the second
+   *
+   * @return     The size of the time code in bytes
+   * @retval -1  If the data is too short or invalid, the P-field does not match or the time exceeds 32 bit seconds
+   */
+  int32_t TimeCode::decode(const uint8_t *pu8_Data, const uint32_t u32_DataSize,
+                           uint32_t *pu32_Seconds, uint32_t *pu32_Nanoseconds) const
+  {
+    uint64_t u64_Seconds;
+    uint32_t u32_Nanoseconds;
+    int32_t i32_Size;
+
+    if(!pu32_Seconds || !pu32_Nanoseconds)
+      return -1;
+
+    i32_Size = _decode(pu8_Data, u32_DataSize, &u64_Seconds, &u32_Nanoseconds);
+    if((i32_Size<0) || (u64_Seconds>0xffffffffULL))
+      return -1;
+
+    *pu32_Seconds = (uint32_t)u64_Seconds;
+    *pu32_Nanoseconds = u32_Nanoseconds;
+    return i32_Size;
+  }
+
+
+
+  /**
+   * @brief Decodes a time code
+   *
+   * @param pu8_Data            A pointer to the time code
+   * @param u32_DataSize        The available size of the data
+   * @param pu64_Nanoseconds    A pointer to the nanoseconds since the epoch
+   *
+   * @return     The size of the time code in bytes
+   * @retval -1  If the data is too short or invalid or the P-field does not match
+   */
+  int32_t TimeCode::decode(const uint8_t *pu8_Data, const uint32_t u32_DataSize, uint64_t *pu64_Nanoseconds) const
+  {
+    uint64_t u64_Seconds;
+    uint32_t u32_Nanoseconds;
+    int32_t i32_Size;
+
+    if(!pu64_Nanoseconds)
+      return -1;
+
+    // the nanoseconds exceed 64 bits after about 584 years (CDS with 24 bit days)
+    i32_Size = _decode(pu8_Data, u32_DataSize, &u64_Seconds, &u32_Nanoseconds);
+    if((i32_Size<0) || (u64_Seconds>=18446744073ULL))
+      return -1;
+
+    *pu64_Nanoseconds = u64_Seconds*NanosecondsPerSecond+u32_Nanoseconds;
+    return i32_Size;
+  }
+
+
+
+  /**
+   * @brief Decodes a sequence of time codes with a fixed distance, e.g. the time stamps of archived packets
+   *
+   * The format checks are done once for the whole batch; CUC codes are read with one big-endian load each.
+   *
+   * @param pu8_Data            A pointer to the first time code
+   * @param u32_DataSize        The available size of the data
+   * @param u32_Stride          The distance between the start of two time codes in bytes
+   * @param pu64_Nanoseconds    A pointer to the array for the nanoseconds since the epoch
+   * @param u32_Count           The number of time codes
+   *
+   * @retval  0  If all time codes were decoded
+   * @retval -1  If a parameter is invalid, the data is too short or a time code is invalid
+   */
+  int32_t TimeCode::decodeBatch(const uint8_t *pu8_Data, const uint32_t u32_DataSize, const uint32_t u32_Stride,
+                                uint64_t *pu64_Nanoseconds, const uint32_t u32_Count) const
+  {
+    const uint8_t u8_Size = getSize();
+    const uint8_t u8_PField = getPField();
+
+    if(!mb_Valid || !pu8_Data || !pu64_Nanoseconds || (u32_Count==0) || (u32_Stride<u8_Size))
+      return -1;
+    if((uint64_t)(u32_Count-1)*u32_Stride+u8_Size>u32_DataSize)
+      return -1;
+
+    if(me_Format==CUC)
+    {
+      const uint8_t u8_Offset = mb_PField?PFieldSize:0;
+      const uint8_t u8_Length = (uint8_t)(mu8_CoarseSize+mu8_FineSize);
+      const uint8_t u8_FineBits = (uint8_t)(8*mu8_FineSize);
+      const uint64_t u64_FineMask = (1ULL<<u8_FineBits)-1;
+
+      for(uint32_t i=0; i<u32_Count; i++)
+      {
+        const uint8_t *pu8_Code = &pu8_Data[i*u32_Stride];
+        uint64_t u64_Value=0;
+
+        if(mb_PField && (pu8_Code[0]!=u8_PField))
+          return -1;
+        for(uint8_t j=0; j<u8_Length; j++)
+          u64_Value = (u64_Value<<8) | pu8_Code[u8_Offset+j];
+
+        pu64_Nanoseconds[i] = (u64_Value>>u8_FineBits)*NanosecondsPerSecond
+                            + (((u64_Value&u64_FineMask)*NanosecondsPerSecond+u64_FineMask)>>u8_FineBits);
+      }
+    }
+    else
+    {
+      for(uint32_t i=0; i<u32_Count; i++)
+      {
+        if(decode(&pu8_Data[i*u32_Stride], u8_Size, &pu64_Nanoseconds[i])<0)
+          return -1;
+      }
+    }
+
+    return 0;
+  }
+
+
+
+  // encodes the time, the seconds are only divided with 64 bits for CDS times beyond 2106
+  uint8_t TimeCode::_encode(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                            const uint64_t u64_Seconds, const uint32_t u32_Nanoseconds) const
+  {
+    const uint8_t u8_Size = getSize();
+    uint8_t *pu8_Code = pu8_Buffer;
+
+    if(!mb_Valid || !pu8_Buffer || (u32_BufferSize<u8_Size) || (u32_Nanoseconds>=NanosecondsPerSecond))
+      return 0;
+
+    if(mb_PField)
+      *pu8_Code++ = getPField();
+
+    if(me_Format==CUC)
+    {
+      // the coarse time wraps around
+      putBigEndian(pu8_Code, (uint32_t)u64_Seconds, mu8_CoarseSize);
+      if(mu8_FineSize>0)
+      {
+        uint32_t u32_Fraction = (uint32_t)(((uint64_t)u32_Nanoseconds*FractionFactor)>>30);
+
+        // the estimate is corrected to the truncated fraction
+        if(((uint64_t)u32_Fraction+1)*NanosecondsPerSecond<=((uint64_t)u32_Nanoseconds<<32))
+          u32_Fraction++;
+        putBigEndian(&pu8_Code[mu8_CoarseSize], u32_Fraction>>(32-8*mu8_FineSize), mu8_FineSize);
+      }
+    }
+    else
+    {
+      uint32_t u32_Days;
+      uint32_t u32_SecondOfDay;
+      const uint32_t u32_SubMillisecond = u32_Nanoseconds%1000000UL;
+
+      if(u64_Seconds<=0xffffffffULL)
+      {
+        u32_Days = (uint32_t)u64_Seconds/SecondsPerDay;
+        u32_SecondOfDay = (uint32_t)u64_Seconds-u32_Days*SecondsPerDay;
+      }
+      else
+      {
+        if(u64_Seconds/SecondsPerDay>0xffffffUL)
+          return 0;
+        u32_Days = (uint32_t)(u64_Seconds/SecondsPerDay);
+        u32_SecondOfDay = (uint32_t)(u64_Seconds-(uint64_t)u32_Days*SecondsPerDay);
+      }
+      if(u32_Days>>(8*mu8_CoarseSize))
+        return 0;
+
+      putBigEndian(pu8_Code, u32_Days, mu8_CoarseSize);
+      putBigEndian(&pu8_Code[mu8_CoarseSize], u32_SecondOfDay*1000UL+u32_Nanoseconds/1000000UL, 4);
+      if(mu8_FineSize==2)
+        putBigEndian(&pu8_Code[mu8_CoarseSize+4], u32_SubMillisecond/1000UL, 2);
+      else if(mu8_FineSize==4)
+        putBigEndian(&pu8_Code[mu8_CoarseSize+4], u32_SubMillisecond*1000UL, 4);
+    }
+
+    return u8_Size;
+  }
+
+
+
+  // decodes the time into seconds and nanoseconds, returns the size of the code or -1
+  int32_t TimeCode::_decode(const uint8_t *pu8_Data, const uint32_t u32_DataSize,
+                            uint64_t *pu64_Seconds, uint32_t *pu32_Nanoseconds) const
+  {
+    const uint8_t u8_Size = getSize();
+    const uint8_t *pu8_Code = pu8_Data;
+
+    if(!mb_Valid || !pu8_Data || (u32_DataSize<u8_Size))
+      return -1;
+
+    if(mb_PField)
+    {
+      if(*pu8_Code++!=getPField())
+        return -1;
+    }
+
+    if(me_Format==CUC)
+    {
+      const uint8_t u8_FineBits = (uint8_t)(8*mu8_FineSize);
+      const uint64_t u64_Fine = getBigEndian(&pu8_Code[mu8_CoarseSize], mu8_FineSize);
+
+      *pu64_Seconds = getBigEndian(pu8_Code, mu8_CoarseSize);
+      // rounded up, so the fraction is encoded to the same value again
+      *pu32_Nanoseconds = (uint32_t)((u64_Fine*NanosecondsPerSecond+(1ULL<<u8_FineBits)-1)>>u8_FineBits);
+    }
+    else
+    {
+      const uint32_t u32_Days = getBigEndian(pu8_Code, mu8_CoarseSize);
+      const uint32_t u32_Milliseconds = getBigEndian(&pu8_Code[mu8_CoarseSize], 4);
+      uint32_t u32_SubMillisecond=0;
+
+      // a day may have a leap second
+      if(u32_Milliseconds>=MillisecondsPerDay+1000UL)
+        return -1;
+      if(mu8_FineSize==2)
+      {
+        u32_SubMillisecond = getBigEndian(&pu8_Code[mu8_CoarseSize+4], 2);
+        if(u32_SubMillisecond>=1000UL)
+          return -1;
+        u32_SubMillisecond *= 1000UL;
+      }
+      else if(mu8_FineSize==4)
+      {
+        u32_SubMillisecond = getBigEndian(&pu8_Code[mu8_CoarseSize+4], 4);
+        if(u32_SubMillisecond>=NanosecondsPerSecond)
+          return -1;
+        u32_SubMillisecond /= 1000UL;
+      }
+
+      *pu64_Seconds = (uint64_t)u32_Days*SecondsPerDay+u32_Milliseconds/1000UL;
+      *pu32_Nanoseconds = (u32_Milliseconds%1000UL)*1000000UL+u32_SubMillisecond;
+    }
+
+    return u8_Size;
+  }
+
+}
@@ -0,0 +1,136 @@
+/**
+ * @file      ccsds_timecode.h
+ *
+ * @brief     Include file of the time code (CUC / CDS) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_TIMECODE_H_
+#define _CCSDS_TIMECODE_H_
+
+/****************************************************************/
+/* Time codes according to                                      */
+/*                                                              */
+/*  - CCSDS 301.0-B-4, - Time Code Formats                      */
+/*    https://public.ccsds.org/Pubs/301x0b4e1.pdf               */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Only the CUC and CDS formats are supported (no CCS/ASCII) */
+/*  - The P-field extension (second octet) is not supported,    */
+/*    so CUC has at most 4 coarse and 3 fine octets             */
+/*  - Leap seconds are not handled, the time is a plain count   */
+/*    of seconds since the epoch                                */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+
+
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Class for encoding and decoding the CCSDS unsegmented (CUC) and day segmented (CDS) time codes.
+   *
+   * A TimeCode object only holds the format, so it can be created as a constexpr object and shared by all
+   * users of the same format, e.g. for the secondary headers of space packets:
+   * @code
+   * static constexpr CCSDS::TimeCode gS_Time(CCSDS::TimeCode::CUC, 4, 2);
+   * @endcode
+   *
+   * The time is given either as seconds and nanoseconds or as nanoseconds since the epoch of the time code
+   * (1958-01-01 TAI or an agency-defined epoch). The seconds/nanoseconds variants only need 32 bit divisions
+   * and are meant for the onboard side; the 64 bit variants and decodeBatch() are meant for the ground side.
+   *
+   * The CUC coarse time wraps around like the onboard counter. The CUC fine time is truncated on encoding and
+   * rounded up on decoding, so re-encoding a decoded time results in the same code.
+   */
+  class TimeCode
+  {
+  public:
+    /** The time code format
+     */
+    enum Format
+    {
+      CUC,    /**< CCSDS unsegmented time code: coarse (seconds) and fine (binary fraction) time */
+      CDS     /**< CCSDS day segmented time code: days, milliseconds of day and submilliseconds */
+    };
+
+    static const uint8_t PFieldSize = 1;
+    static const uint8_t MaxSize = 12;        /**< P-field, 24 bit day, milliseconds and picoseconds */
+
+  private:
+    enum Format me_Format;
+    uint8_t mu8_CoarseSize;                   // CUC: coarse octets, CDS: day octets
+    uint8_t mu8_FineSize;                     // CUC: fine octets, CDS: submillisecond octets
+    bool mb_PField;
+    bool mb_AgencyEpoch;
+    bool mb_Valid;
+
+    static constexpr bool _isValid(const enum Format e_Format, const uint8_t u8_CoarseSize, const uint8_t u8_FineSize)
+    {
+      return (e_Format==CUC) ? ((u8_CoarseSize>=1) && (u8_CoarseSize<=4) && (u8_FineSize<=3))
+                             : (((u8_CoarseSize==2) || (u8_CoarseSize==3)) && ((u8_FineSize==0) || (u8_FineSize==2) || (u8_FineSize==4)));
+    }
+
+  public:
+    /**
+     * @brief Construct a new TimeCode object
+     *
+     * @param e_Format        The time code format (CUC or CDS)
+     * @param u8_CoarseSize   CUC: number of coarse time octets (1 to 4); CDS: number of day octets (2 or 3)
+     * @param u8_FineSize     CUC: number of fine time octets (0 to 3); CDS: number of submillisecond octets
+     *                        (0, 2 for microseconds or 4 for picoseconds)
+     * @param b_PField        true if the preamble field (P-field) is sent in front of the time code
+     * @param b_AgencyEpoch   true if the epoch is agency-defined instead of 1958-01-01 TAI
+     */
+    constexpr TimeCode(const enum Format e_Format = CUC, const uint8_t u8_CoarseSize = 4, const uint8_t u8_FineSize = 2,
+                       const bool b_PField = false, const bool b_AgencyEpoch = false)
+      : me_Format{e_Format}
+      , mu8_CoarseSize{u8_CoarseSize}
+      , mu8_FineSize{u8_FineSize}
+      , mb_PField{b_PField}
+      , mb_AgencyEpoch{b_AgencyEpoch}
+      , mb_Valid{_isValid(e_Format, u8_CoarseSize, u8_FineSize)}
+    {
+    }
+
+    /** @brief Returns true if the format parameters are valid */
+    constexpr bool isValid(void) const { return mb_Valid; }
+
+    /** @brief Returns the size of the time code in bytes (including the P-field, if used) */
+    constexpr uint8_t getSize(void) const
+    {
+      return (uint8_t)((mb_PField?PFieldSize:0)+mu8_CoarseSize+((me_Format==CDS)?4:0)+mu8_FineSize);
+    }
+
+    uint8_t getPField(void) const;
+    int32_t setFromPField(const uint8_t u8_PField);
+
+    uint8_t encode(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                   const uint32_t u32_Seconds, const uint32_t u32_Nanoseconds) const;
+    uint8_t encode(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint64_t u64_Nanoseconds) const;
+
+    int32_t decode(const uint8_t *pu8_Data, const uint32_t u32_DataSize,
+                   uint32_t *pu32_Seconds, uint32_t *pu32_Nanoseconds) const;
+    int32_t decode(const uint8_t *pu8_Data, const uint32_t u32_DataSize, uint64_t *pu64_Nanoseconds) const;
+
+    int32_t decodeBatch(const uint8_t *pu8_Data, const uint32_t u32_DataSize, const uint32_t u32_Stride,
+                        uint64_t *pu64_Nanoseconds, const uint32_t u32_Count) const;
+
+  private:
+    uint8_t _encode(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                    const uint64_t u64_Seconds, const uint32_t u32_Nanoseconds) const;
+    int32_t _decode(const uint8_t *pu8_Data, const uint32_t u32_DataSize,
+                    uint64_t *pu64_Seconds, uint32_t *pu32_Nanoseconds) const;
+  };
+
+}
+
+#endif // _CCSDS_TIMECODE_H_
@@ -8,6 +8,8 @@
  * @copyright Copyright (C) 2021-2022 Stefan Trippler.  All rights reserved.
  */
 
+#include <string.h>
+
 #include "ccsds_transferframe.h"
 
 
@@ -34,17 +36,62 @@
 namespace CCSDS 
 {
   
+#if TF_USE_CRC_TABLE == 1
+  /*
+   * CRC register after shifting in one byte with a zero register, polynom G(X) = X^16 + X^12 + X^5 + 1
+   */
+  static const uint16_t au16_CrcTable[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+    0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+    0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+    0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+    0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+    0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+    0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+    0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+    0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+    0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+    0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+    0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+    0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+    0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+    0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+    0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+    0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+    0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+    0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+    0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+    0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+    0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0
+  };
+#endif
+  
+  
   
   /**
    * @brief Construct a new Transferframe object
+   *
+   * @param e_RandomizerSequence  The pseudo-random sequence which is used if the randomization is enabled
    */
-  Transferframe::Transferframe(void)
+  Transferframe::Transferframe(const enum Randomizer::Sequence e_RandomizerSequence)
     : mu16_Index{0}
     , mu16_FrameLength{0}
     , mb_Sync{true}
     , mu16_SyncErrorCount{0}
     , mu16_ChecksumErrorCount{0}
     , mu16_OverflowErrorCount{0}
+    , me_RandomizerSequence{e_RandomizerSequence}
+    , mb_Randomization{false}
   {
   }
   
@@ -66,6 +113,28 @@ namespace CCSDS
   
   
   
+  /**
+   * @brief Enables the derandomization of received frames
+   *
+   * If enabled, process() removes the pseudo-random sequence (see Randomizer) from each frame before the
+   * header is evaluated and the CRC is checked. The sync code is not randomized.
+   *
+   * @param b_Enabled  true if the received frames are randomized
+   *
+   * @retval  0   The randomization was set
+   * @retval -1   The randomizer is disabled by the configuration (configTF_USE_RANDOMIZER)
+   */
+  int32_t Transferframe::setRandomization(const bool b_Enabled)
+  {
+    if(b_Enabled && !UseRandomizer)
+      return -1;
+    mb_Randomization=b_Enabled;
+    
+    return 0;
+  }
+  
+  
+  
   /**
    * @brief The given data stream is parsed for Transfer Frames.
    *
@@ -89,6 +158,7 @@ namespace CCSDS
     uint16_t u16_MaxTfSize = _getMaxTfSize();
     uint8_t *pu8_Buffer = _getTfBufferAddr();
     uint16_t u16_PrimaryHdrSize = _getPrimaryHeaderSize();
+    uint16_t u16_CopySize;
     bool b_Valid = true;
     
     if((u16_DataSize==0) || !pu8_Data)
@@ -115,13 +185,23 @@ namespace CCSDS
         }
         //      cout << mu16_Index;
       }
-      else if((mu16_Index<SyncSize+u16_PrimaryHdrSize) || (mu16_Index<SyncSize+mu16_FrameLength+1))
+      else if(mu16_Index<SyncSize+u16_PrimaryHdrSize)
       {
         if(mu16_Index-SyncSize<u16_MaxTfSize)
           pu8_Buffer[mu16_Index-SyncSize]=pu8_Data[i];
         mu16_Index++;
         //    cout << '.';
       }
+      else if(mu16_Index<SyncSize+mu16_FrameLength+1)
+      {
+        // the frame length is known (and checked), so the rest of the frame is copied at once
+        u16_CopySize=(uint16_t)(SyncSize+mu16_FrameLength+1-mu16_Index);
+        if(u16_CopySize>u16_DataSize-i)
+          u16_CopySize=(uint16_t)(u16_DataSize-i);
+        memcpy(&pu8_Buffer[mu16_Index-SyncSize], &pu8_Data[i], u16_CopySize);
+        mu16_Index+=u16_CopySize;
+        i+=(uint16_t)(u16_CopySize-1);
+      }
       
       if(mu16_Index==SyncSize)
       {
@@ -135,6 +215,8 @@ namespace CCSDS
       {
         //  cout << 'H';
         //displaybuffer(pu8_Buffer, u16_PrimaryHdrSize);
+        if(mb_Randomization)
+          Randomizer::apply(me_RandomizerSequence, pu8_Buffer, u16_PrimaryHdrSize);
         _getFrameLength();
         if(mu16_FrameLength+1>_getMaxTfSize())
         {
@@ -152,11 +234,17 @@ namespace CCSDS
         //  displaybuffer(pu8_Buffer, mu16_FrameLength+1);
         //  cout << endl << "  ";
         
+        if(mb_Randomization)
+          Randomizer::apply(me_RandomizerSequence, &pu8_Buffer[u16_PrimaryHdrSize],
+                            mu16_FrameLength+1-u16_PrimaryHdrSize, u16_PrimaryHdrSize);
+        
+        b_Valid = _decodeFrame();
 #if TF_USE_FECF == 1
-        b_Valid = _checkCRC();
+        if(b_Valid)
+          b_Valid = _checkCRC();
+#endif
         if(!b_Valid && (mu16_ChecksumErrorCount<0xffff))
           mu16_ChecksumErrorCount++;
-#endif
         
         if(b_Valid)
           _processFrame();
@@ -229,6 +317,17 @@ namespace CCSDS
   
   
   
+  /*
+   * Hook for a channel code which is removed in place before the CRC is checked (e.g. Reed-Solomon);
+   * returns false if the frame can not be decoded
+   */
+  bool Transferframe::_decodeFrame(void)
+  {
+    return true;
+  }
+  
+  
+  
   bool Transferframe::_checkCRC(void)
   {
     uint8_t *pu8_Buffer = _getTfBufferAddr();
@@ -246,25 +345,64 @@ namespace CCSDS
   
   
   
-  uint16_t Transferframe::calcCRC(const uint8_t *pu8_Buffer, const uint16_t u16_BufferSize)
+  static inline uint16_t _updateCRC(uint16_t u16_CRC, const uint8_t u8_Data)
   {
-    uint16_t u16_CRC=0xffff;
+#if TF_USE_CRC_TABLE == 1
+    return (uint16_t)((u16_CRC<<8) ^ au16_CrcTable[(uint8_t)(u16_CRC>>8) ^ u8_Data]);
+#else
     uint16_t u16_DataStreamXorBit15;
     
     // This implementation is slow compared to other implementations, but it
     // does consume much less space in memory (relevant for Arduino).
     
     // polynom: G(X) = X^16 + X^12 + X^5 + 1
-    for(uint16_t u16_BytePos = 0; u16_BytePos<u16_BufferSize; u16_BytePos++)
+    for(uint32_t u8_BitPos = 0; u8_BitPos<8; u8_BitPos++)
     {
-      for(uint32_t u8_BitPos = 0; u8_BitPos<8; u8_BitPos++)
-      {
-        u16_DataStreamXorBit15 = ((pu8_Buffer[u16_BytePos]>>(7-u8_BitPos))&0x1) ^ ((u16_CRC>>15)&0x1);
-        u16_CRC = (uint16_t)((u16_CRC<<1) ^ ((u16_DataStreamXorBit15<<12) | (u16_DataStreamXorBit15<<5) | (u16_DataStreamXorBit15)));
-      }
+      u16_DataStreamXorBit15 = ((u8_Data>>(7-u8_BitPos))&0x1) ^ ((u16_CRC>>15)&0x1);
+      u16_CRC = (uint16_t)((u16_CRC<<1) ^ ((u16_DataStreamXorBit15<<12) | (u16_DataStreamXorBit15<<5) | (u16_DataStreamXorBit15)));
     }
+    return u16_CRC;
+#endif
+  }
+  
+  
+  
+  /**
+   * @brief Calculates the CRC-16 of the frame error control field (polynom 0x1021)
+   *
+   * The same checksum is used by the Packet Error Control of PUS packets and by the memory management service.
+   *
+   * @param pu8_Buffer      The data buffer
+   * @param u32_BufferSize  The size of the data buffer
+   * @param u16_Syndrome    The initial syndrome; the result of a previous call can be given to continue a calculation
+   *
+   * @return The checksum as uint16_t
+   */
+  uint16_t Transferframe::calcCRC(const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint16_t u16_Syndrome)
+  {
+    uint16_t u16_CRC = u16_Syndrome;
+    
+    for(uint32_t u32_BytePos = 0; u32_BytePos<u32_BufferSize; u32_BytePos++)
+      u16_CRC = _updateCRC(u16_CRC, pu8_Buffer[u32_BytePos]);
     
     return u16_CRC;
   }
   
+  
+  
+  /**
+   * @brief Continues the CRC-16 calculation of calcCRC() with one byte
+   *
+   * This allows parsers which walk through the received data byte by byte to calculate the checksum in the same pass.
+   *
+   * @param u16_Syndrome    The syndrome of the previous bytes (0xffff for the first byte)
+   * @param u8_Data         The next byte
+   *
+   * @return The new syndrome as uint16_t
+   */
+  uint16_t Transferframe::updateCRC(const uint16_t u16_Syndrome, const uint8_t u8_Data)
+  {
+    return _updateCRC(u16_Syndrome, u8_Data);
+  }
+  
 }
@@ -28,6 +28,7 @@
 #include <inttypes.h>
 
 #include "configCCSDS.h"
+#include "ccsds_randomizer.h"
 
 
 #ifdef configTF_USE_OCF
@@ -36,6 +37,12 @@
 #define TF_USE_FECF 1
 #endif
 
+#ifdef configTF_USE_CRC_TABLE
+#define TF_USE_CRC_TABLE configTF_USE_CRC_TABLE
+#else
+#define TF_USE_CRC_TABLE 1
+#endif
+
 
 
 
@@ -59,6 +66,7 @@ namespace CCSDS
     const static uint8_t SyncSize = TF_SYNC_SIZE;
     const static uint8_t FecfSize = 2;
     const static bool UseFECF = (TF_USE_FECF)?true:false;  // Frame error control field (CRC)
+    const static bool UseRandomizer = (TF_USE_RANDOMIZER)?true:false;
     
     uint16_t mu16_Index;
     uint16_t mu16_FrameLength;
@@ -66,9 +74,12 @@ namespace CCSDS
     uint16_t mu16_SyncErrorCount;
     uint16_t mu16_ChecksumErrorCount;
     uint16_t mu16_OverflowErrorCount;
+    enum Randomizer::Sequence me_RandomizerSequence;
+    bool mb_Randomization;
     
   public:
     void setSync(void);
+    int32_t setRandomization(const bool b_Enabled);
     int32_t process(const uint8_t *pu8_Data, const uint16_t u16_DataSize);
     uint16_t getSyncErrorCount(void);
     uint16_t getChecksumErrorCount(void);
@@ -76,9 +87,10 @@ namespace CCSDS
     void clearErrorCounters(void);
     
   public:
-    Transferframe(void);
+    Transferframe(const enum Randomizer::Sequence e_RandomizerSequence = Randomizer::NoSequence);
     bool _checkCRC(void);
-    static uint16_t calcCRC(const uint8_t *pu8_Buffer, const uint16_t u16_BufferSize);
+    static uint16_t calcCRC(const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint16_t u16_Syndrome = 0xffff);
+    static uint16_t updateCRC(const uint16_t u16_Syndrome, const uint8_t u8_Data);
     
   private:
     virtual uint16_t _getMaxTfSize(void) = 0;
@@ -86,6 +98,7 @@ namespace CCSDS
     virtual uint16_t _getPrimaryHeaderSize(void) = 0;
     virtual void _getFrameLength(void) = 0;
     virtual int32_t _processFrame(void) = 0;
+    virtual bool _decodeFrame(void);
   };
   
   
@@ -0,0 +1,528 @@
+/**
+ * @file      ccsds_transferframe_aos.cpp
+ *
+ * @brief     Source file of the Transfer Frame (AOS) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "ccsds_transferframe_aos.h"
+
+
+#if AOS_TF_TOTAL_SIZE > 0
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Construct a new TransferframeAos object
+   *
+   * @param p_ActionInterface   A pointer to the implementation of the action interface
+   */
+  TransferframeAos::TransferframeAos(TransferframeAosActionInterface *p_ActionInterface)
+    : Transferframe(Randomizer::TmSequence)
+#if TF_RS_MAX_INTERLEAVE > 0
+    , mu8_RsInterleaveDepth{0}
+#endif
+    , mu8_InsertZoneSize{0}
+    , mp_ActionInterface{p_ActionInterface}
+  {
+  }
+
+
+
+  /**
+   * @brief Overwrites the context pointer and callback which were set using the constructor
+   *
+   * @param p_ActionInterface   A pointer to the implementation of the action interface
+   */
+  void TransferframeAos::setActionInterface(TransferframeAosActionInterface *p_ActionInterface)
+  {
+    mp_ActionInterface = p_ActionInterface;
+  }
+
+
+
+  /**
+   * @brief Sets the size of the insert zone of the physical channel
+   *
+   * @param u8_InsertZoneSize   The size of the insert zone in bytes (0 if the insert zone is not used)
+   *
+   * @retval  0   The insert zone size was set
+   * @retval -1   The insert zone does not fit into the frame
+   */
+  int32_t TransferframeAos::setInsertZoneSize(const uint8_t u8_InsertZoneSize)
+  {
+    if(getDataZoneSize(u8_InsertZoneSize)==0)
+      return -1;
+    mu8_InsertZoneSize = u8_InsertZoneSize;
+
+    return 0;
+  }
+
+
+
+#if TF_RS_MAX_INTERLEAVE > 0
+  /**
+   * @brief Enables the Reed-Solomon decoding of received frames
+   *
+   * If enabled, process() expects the check symbols of the (255,223) code behind each frame and corrects the
+   * frame in place before the CRC is checked. Frames which can not be corrected are counted as checksum errors.
+   *
+   * @param u8_InterleaveDepth  The interleaving depth (1 to 8), or 0 to disable the decoding; the frame size
+   *                            must be a multiple of the interleaving depth
+   *
+   * @retval  0   The decoding was set
+   * @retval -1   The interleaving depth is not supported with the frame size
+   */
+  int32_t TransferframeAos::setReedSolomon(const uint8_t u8_InterleaveDepth)
+  {
+    if(u8_InterleaveDepth>0)
+    {
+      if(u8_InterleaveDepth>ReedSolomon::MaxInterleaveDepth || (TfSize%u8_InterleaveDepth)!=0)
+        return -1;
+      if(TfSize/u8_InterleaveDepth>ReedSolomon::MessageSize)
+        return -1;
+    }
+    mu8_RsInterleaveDepth = u8_InterleaveDepth;
+
+    return 0;
+  }
+#endif
+
+
+
+  /**
+   * @brief Returns the size of the packet zone (M_PDU) or bitstream data zone (B_PDU) of a frame
+   *
+   * @param u8_InsertZoneSize   The size of the insert zone in bytes
+   *
+   * @retval 0  The insert zone does not fit into the frame
+   * @return The size of the zone in bytes
+   */
+  uint16_t TransferframeAos::getDataZoneSize(const uint8_t u8_InsertZoneSize)
+  {
+    uint16_t u16_Overhead = PrimaryHdrSize+u8_InsertZoneSize+PduHdrSize+(UseOCF?OcfSize:0)+(UseFECF?FecfSize:0);
+
+    return (TfSize>u16_Overhead)?(uint16_t)(TfSize-u16_Overhead):0;
+  }
+
+
+
+  /**
+   * @brief Creates an AOS Transfer Frame with an M_PDU (space packets) and writes it into the given buffer
+   *
+   * If the data is shorter than the packet zone, the zone is filled up with 0xCA.
+   *
+   * @param pu8_Buffer          A pointer to the buffer where the frame shall be stored
+   * @param u32_BufferSize      The available size of the buffer
+   * @param u8_SpacecraftID     The spacecraft ID which is used for this frame (8 bit)
+   * @param u8_VirtualChannelID The virtual channel which is used for this frame (0 to 62)
+   * @param u32_VcFrameCount    The channel-specific frame count (24 bit), must be increased externally
+   * @param u16_FirstHdrPtr     Offset of the first space packet within the packet zone (NoFirstHdr if none)
+   * @param pu8_Data            A pointer to the packet zone content
+   * @param u16_DataSize        The size of the packet zone content in bytes
+   * @param u32_OCF             The Operational Control Field (OCF), usually the CLCW
+   * @param pu8_InsertZone      A pointer to the content of the insert zone
+   * @param u8_InsertZoneSize   The size of the insert zone in bytes (0 if the insert zone is not used)
+   *
+   * @retval 0  No frame could be created
+   * @return The size of the created frame in bytes as uint32_t
+   */
+  uint32_t TransferframeAos::createMpdu(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                        const uint8_t u8_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                                        const uint32_t u32_VcFrameCount, const uint16_t u16_FirstHdrPtr,
+                                        const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                                        const uint32_t u32_OCF,
+                                        const uint8_t *pu8_InsertZone, const uint8_t u8_InsertZoneSize)
+  {
+    return _create(pu8_Buffer, u32_BufferSize, u8_SpacecraftID, u8_VirtualChannelID, u32_VcFrameCount,
+                   u16_FirstHdrPtr&0x7ff, pu8_Data, u16_DataSize, u32_OCF, pu8_InsertZone, u8_InsertZoneSize);
+  }
+
+
+
+  /**
+   * @brief Creates an AOS Transfer Frame with a B_PDU (bitstream) and writes it into the given buffer
+   *
+   * If the data is shorter than the bitstream data zone, the zone is filled up with 0xCA and the bitstream
+   * data pointer marks the last bit of the data as the last valid bit.
+   *
+   * @param pu8_Buffer          A pointer to the buffer where the frame shall be stored
+   * @param u32_BufferSize      The available size of the buffer
+   * @param u8_SpacecraftID     The spacecraft ID which is used for this frame (8 bit)
+   * @param u8_VirtualChannelID The virtual channel which is used for this frame (0 to 62)
+   * @param u32_VcFrameCount    The channel-specific frame count (24 bit), must be increased externally
+   * @param pu8_Data            A pointer to the bitstream data
+   * @param u16_DataSize        The size of the bitstream data in bytes
+   * @param u32_OCF             The Operational Control Field (OCF), usually the CLCW
+   * @param pu8_InsertZone      A pointer to the content of the insert zone
+   * @param u8_InsertZoneSize   The size of the insert zone in bytes (0 if the insert zone is not used)
+   *
+   * @retval 0  No frame could be created
+   * @return The size of the created frame in bytes as uint32_t
+   */
+  uint32_t TransferframeAos::createBpdu(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                        const uint8_t u8_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                                        const uint32_t u32_VcFrameCount,
+                                        const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                                        const uint32_t u32_OCF,
+                                        const uint8_t *pu8_InsertZone, const uint8_t u8_InsertZoneSize)
+  {
+    uint16_t u16_BitstreamPtr = BitstreamAllValid;
+
+    if(u16_DataSize==0)
+      u16_BitstreamPtr = BitstreamIdle;
+    else if(u16_DataSize<getDataZoneSize(u8_InsertZoneSize))
+      u16_BitstreamPtr = (uint16_t)(u16_DataSize*8-1);
+
+    return _create(pu8_Buffer, u32_BufferSize, u8_SpacecraftID, u8_VirtualChannelID, u32_VcFrameCount,
+                   u16_BitstreamPtr, pu8_Data, u16_DataSize, u32_OCF, pu8_InsertZone, u8_InsertZoneSize);
+  }
+
+
+
+  /**
+   * @brief Creates an Idle AOS Transfer Frame (virtual channel 63) and writes it into the given buffer
+   *
+   * @param pu8_Buffer          A pointer to the buffer where the frame shall be stored
+   * @param u32_BufferSize      The available size of the buffer
+   * @param u8_SpacecraftID     The spacecraft ID which is used for this frame (8 bit)
+   * @param u32_VcFrameCount    The frame count of the idle channel (24 bit), must be increased externally
+   * @param u32_OCF             The Operational Control Field (OCF), usually the CLCW
+   * @param pu8_InsertZone      A pointer to the content of the insert zone
+   * @param u8_InsertZoneSize   The size of the insert zone in bytes (0 if the insert zone is not used)
+   *
+   * @retval 0  No frame could be created
+   * @return The size of the created frame in bytes as uint32_t
+   */
+  uint32_t TransferframeAos::createIdle(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                        const uint8_t u8_SpacecraftID, const uint32_t u32_VcFrameCount,
+                                        const uint32_t u32_OCF,
+                                        const uint8_t *pu8_InsertZone, const uint8_t u8_InsertZoneSize)
+  {
+    return _create(pu8_Buffer, u32_BufferSize, u8_SpacecraftID, IdleVirtualChannel, u32_VcFrameCount,
+                   IdleFirstHdr, nullptr, 0, u32_OCF, pu8_InsertZone, u8_InsertZoneSize);
+  }
+
+
+
+  /**
+   * @brief Returns the valid bits of a B_PDU without copying them
+   *
+   * @param pu8_DataField       A pointer to the data field of a received frame (B_PDU header and data zone)
+   * @param u16_DataFieldSize   The size of the data field in bytes
+   * @param ppu8_Data           Returns a pointer to the bitstream data zone
+   * @param pu32_BitCount       Returns the number of valid bits (0 for idle data)
+   *
+   * @retval  0   The bitstream was extracted
+   * @retval -1   The data field is invalid
+   */
+  int32_t TransferframeAos::getBitstream(const uint8_t *pu8_DataField, const uint16_t u16_DataFieldSize,
+                                         const uint8_t **ppu8_Data, uint32_t *pu32_BitCount)
+  {
+    uint16_t u16_BitstreamPtr;
+
+    if(!pu8_DataField || !ppu8_Data || !pu32_BitCount || u16_DataFieldSize<PduHdrSize)
+      return -1;
+
+    u16_BitstreamPtr = (uint16_t)((pu8_DataField[0]&0x3f)<<8) | (uint16_t)pu8_DataField[1];
+    *ppu8_Data = &pu8_DataField[PduHdrSize];
+    if(u16_BitstreamPtr==BitstreamAllValid)
+      *pu32_BitCount = (uint32_t)(u16_DataFieldSize-PduHdrSize)*8;
+    else if(u16_BitstreamPtr==BitstreamIdle)
+      *pu32_BitCount = 0;
+    else if((uint32_t)u16_BitstreamPtr<(uint32_t)(u16_DataFieldSize-PduHdrSize)*8)
+      *pu32_BitCount = (uint32_t)u16_BitstreamPtr+1;
+    else
+      return -1;
+
+    return 0;
+  }
+
+
+
+  uint32_t TransferframeAos::_create(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                     const uint8_t u8_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                                     const uint32_t u32_VcFrameCount, const uint16_t u16_PduHeader,
+                                     const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                                     const uint32_t u32_OCF,
+                                     const uint8_t *pu8_InsertZone, const uint8_t u8_InsertZoneSize)
+  {
+    uint16_t u16_DataZoneSize = getDataZoneSize(u8_InsertZoneSize);
+    uint16_t u16_Pos;
+#if TF_USE_FECF == 1
+    uint16_t u16_CRC;
+#endif
+
+    if(!pu8_Buffer || (u32_BufferSize<TfSize) || u16_DataZoneSize==0)
+      return 0;
+    if((u16_DataSize>0 && !pu8_Data) || (u8_InsertZoneSize>0 && !pu8_InsertZone))
+      return 0;
+    if(u16_DataSize>u16_DataZoneSize || u8_VirtualChannelID>IdleVirtualChannel)
+      return 0;
+
+    // primary header; the VC frame count cycle is not used
+    pu8_Buffer[0] = (uint8_t)((AosTfVersionNumber<<6) | (u8_SpacecraftID>>2));
+    pu8_Buffer[1] = (uint8_t)(((u8_SpacecraftID&0x03)<<6) | u8_VirtualChannelID);
+    pu8_Buffer[2] = (uint8_t)(u32_VcFrameCount>>16);
+    pu8_Buffer[3] = (uint8_t)(u32_VcFrameCount>>8);
+    pu8_Buffer[4] = (uint8_t)(u32_VcFrameCount&0xff);
+    pu8_Buffer[5] = 0x00;
+    u16_Pos = PrimaryHdrSize;
+
+    if(u8_InsertZoneSize>0)
+      memcpy(&pu8_Buffer[u16_Pos], pu8_InsertZone, u8_InsertZoneSize);
+    u16_Pos += u8_InsertZoneSize;
+
+    pu8_Buffer[u16_Pos++] = (uint8_t)(u16_PduHeader>>8);
+    pu8_Buffer[u16_Pos++] = (uint8_t)(u16_PduHeader&0xff);
+    if(u16_DataSize>0)
+      memcpy(&pu8_Buffer[u16_Pos], pu8_Data, u16_DataSize);
+    if(u16_DataZoneSize>u16_DataSize)
+      memset(&pu8_Buffer[u16_Pos+u16_DataSize], 0xCA, u16_DataZoneSize-u16_DataSize);
+
+#if TF_USE_OCF == 1
+    pu8_Buffer[TfSize-(UseFECF?FecfSize:0)-OcfSize] = (uint8_t)(u32_OCF>>24);
+    pu8_Buffer[TfSize-(UseFECF?FecfSize:0)-OcfSize+1] = (uint8_t)(u32_OCF>>16);
+    pu8_Buffer[TfSize-(UseFECF?FecfSize:0)-OcfSize+2] = (uint8_t)(u32_OCF>>8);
+    pu8_Buffer[TfSize-(UseFECF?FecfSize:0)-OcfSize+3] = (uint8_t)(u32_OCF&0xff);
+#else
+    (void)u32_OCF;
+#endif
+
+#if TF_USE_FECF == 1
+    u16_CRC = Transferframe::calcCRC(pu8_Buffer, TfSize-2);
+    pu8_Buffer[TfSize-2] = (uint8_t)(u16_CRC>>8);
+    pu8_Buffer[TfSize-1] = (uint8_t)(u16_CRC&0xff);
+#endif
+
+    return TfSize;
+  }
+
+
+
+  inline uint16_t TransferframeAos::_getMaxTfSize(void)
+  {
+    return BufferSize;
+  }
+
+  inline uint8_t *TransferframeAos::_getTfBufferAddr(void)
+  {
+    return mau8_Buffer;
+  }
+
+  inline uint16_t TransferframeAos::_getPrimaryHeaderSize(void)
+  {
+    return PrimaryHdrSize;
+  }
+
+  inline void TransferframeAos::_getFrameLength(void)
+  {
+    mu16_FrameLength=TfSize-1;
+#if TF_RS_MAX_INTERLEAVE > 0
+    mu16_FrameLength+=mu8_RsInterleaveDepth*ReedSolomon::ParitySize;
+#endif
+  }
+
+
+
+  bool TransferframeAos::_decodeFrame(void)
+  {
+#if TF_RS_MAX_INTERLEAVE > 0
+    if(mu8_RsInterleaveDepth>0)
+    {
+      mu16_FrameLength=TfSize-1;
+      if(ReedSolomon::decode(mau8_Buffer, TfSize, mu8_RsInterleaveDepth)<0)
+        return false;
+    }
+#endif
+    return true;
+  }
+
+
+
+  int32_t TransferframeAos::_processFrame(void)
+  {
+    uint8_t u8_SpacecraftID;
+    uint8_t u8_VirtualChannelID;
+    uint32_t u32_VcFrameCount;
+    bool b_ReplayFlag;
+    uint32_t u32_OCF=0x00;
+    uint16_t u16_DataFieldPos = PrimaryHdrSize+mu8_InsertZoneSize;
+
+    if((mau8_Buffer[0]>>6)!=AosTfVersionNumber)
+    {
+      if(mu16_SyncErrorCount<0xffff)
+        mu16_SyncErrorCount++;
+      return -1;
+    }
+
+    u8_SpacecraftID = (uint8_t)(((mau8_Buffer[0]&0x3f)<<2) | (mau8_Buffer[1]>>6));
+    u8_VirtualChannelID = (uint8_t)(mau8_Buffer[1]&0x3f);
+    u32_VcFrameCount = ((uint32_t)mau8_Buffer[2]<<16) | ((uint32_t)mau8_Buffer[3]<<8) | (uint32_t)mau8_Buffer[4];
+    b_ReplayFlag = (mau8_Buffer[5]&0x80)?true:false;
+
+#if TF_USE_OCF == 1
+    uint32_t u32_OCFPos=TfSize-OcfSize-(UseFECF?FecfSize:0);
+    u32_OCF = ((uint32_t)mau8_Buffer[u32_OCFPos]<<24) | ((uint32_t)mau8_Buffer[u32_OCFPos+1]<<16) | ((uint32_t)mau8_Buffer[u32_OCFPos+2]<<8) | (uint32_t)mau8_Buffer[u32_OCFPos+3];
+#endif
+
+    if(mp_ActionInterface)
+    {
+      mp_ActionInterface->onTransferframeAosReceived(u8_SpacecraftID, u8_VirtualChannelID,
+                                                     u32_VcFrameCount, b_ReplayFlag,
+                                                     (mu8_InsertZoneSize>0)?&mau8_Buffer[PrimaryHdrSize]:nullptr, mu8_InsertZoneSize,
+                                                     &mau8_Buffer[u16_DataFieldPos], getDataZoneSize(mu8_InsertZoneSize)+PduHdrSize,
+                                                     u32_OCF);
+    }
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Construct a new MpduExtractor object
+   *
+   * @param p_SpacePacket   A pointer to the SpacePacket object which assembles the packets
+   */
+  MpduExtractor::MpduExtractor(SpacePacket *p_SpacePacket)
+    : mp_SpacePacket{p_SpacePacket}
+    , mp_EncapsulationPacket{nullptr}
+    , mb_Sync{false}
+    , mu32_NextFrameCount{0}
+    , mu16_LostFrameCount{0}
+  {
+  }
+
+
+
+  /**
+   * @brief Overwrites the SpacePacket object which was set using the constructor
+   *
+   * @param p_SpacePacket   A pointer to the SpacePacket object which assembles the packets
+   */
+  void MpduExtractor::setSpacePacket(SpacePacket *p_SpacePacket)
+  {
+    mp_SpacePacket = p_SpacePacket;
+    mb_Sync = false;
+  }
+
+
+
+  /**
+   * @brief Sets an EncapsulationPacket object which receives the packet zones instead of the SpacePacket object
+   *
+   * @param p_EncapsulationPacket   A pointer to the EncapsulationPacket object (nullptr to use the SpacePacket object again)
+   */
+  void MpduExtractor::setEncapsulationPacket(EncapsulationPacket *p_EncapsulationPacket)
+  {
+    mp_EncapsulationPacket = p_EncapsulationPacket;
+    mb_Sync = false;
+  }
+
+
+
+  /**
+   * @brief Drops a partially received packet; the extraction restarts at the next first header pointer
+   */
+  void MpduExtractor::reset(void)
+  {
+    if(mp_EncapsulationPacket)
+      mp_EncapsulationPacket->reset();
+    else if(mp_SpacePacket)
+      mp_SpacePacket->reset();
+    mb_Sync = false;
+  }
+
+
+
+  /**
+   * @brief Processes the M_PDU of a received frame of the virtual channel
+   *
+   * @param u32_VcFrameCount    The virtual channel frame count of the frame
+   * @param pu8_DataField       A pointer to the data field of the frame (M_PDU header and packet zone)
+   * @param u16_DataFieldSize   The size of the data field in bytes
+   *
+   * @retval  0   The M_PDU was processed
+   * @retval -1   The data field or the first header pointer is invalid
+   */
+  int32_t MpduExtractor::process(const uint32_t u32_VcFrameCount, const uint8_t *pu8_DataField, const uint16_t u16_DataFieldSize)
+  {
+    uint16_t u16_FirstHdrPtr;
+    const uint8_t *pu8_Zone;
+    uint16_t u16_ZoneSize;
+    uint32_t u32_Lost;
+
+    if((!mp_SpacePacket && !mp_EncapsulationPacket) || !pu8_DataField || u16_DataFieldSize<=TransferframeAos::PduHdrSize)
+      return -1;
+
+    u16_FirstHdrPtr = (uint16_t)((pu8_DataField[0]&0x07)<<8) | (uint16_t)pu8_DataField[1];
+    pu8_Zone = &pu8_DataField[TransferframeAos::PduHdrSize];
+    u16_ZoneSize = (uint16_t)(u16_DataFieldSize-TransferframeAos::PduHdrSize);
+
+    if(mb_Sync && u32_VcFrameCount!=mu32_NextFrameCount)
+    {
+      u32_Lost = (u32_VcFrameCount-mu32_NextFrameCount)&0xffffff;
+      mu16_LostFrameCount = (u32_Lost<0xffffUL-mu16_LostFrameCount)?(uint16_t)(mu16_LostFrameCount+u32_Lost):0xffff;
+      reset();
+    }
+    mu32_NextFrameCount = (u32_VcFrameCount+1)&0xffffff;
+
+    if(u16_FirstHdrPtr==TransferframeAos::IdleFirstHdr)
+      return 0;
+
+    if(!mb_Sync)
+    {
+      if(u16_FirstHdrPtr==TransferframeAos::NoFirstHdr)
+        return 0;
+      if(u16_FirstHdrPtr>=u16_ZoneSize)
+        return -1;
+      if(mp_EncapsulationPacket)
+        mp_EncapsulationPacket->reset();
+      else
+        mp_SpacePacket->reset();
+      pu8_Zone += u16_FirstHdrPtr;
+      u16_ZoneSize = (uint16_t)(u16_ZoneSize-u16_FirstHdrPtr);
+      mb_Sync = true;
+    }
+
+    if(mp_EncapsulationPacket)
+      mp_EncapsulationPacket->process(pu8_Zone, u16_ZoneSize);
+    else
+      mp_SpacePacket->process(pu8_Zone, u16_ZoneSize);
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Returns the number of frames which were detected as lost by a gap in the VC frame count
+   *
+   * If the number exceeds 65535, the method returns 65535.
+   *
+   * @return Number of lost frames as uint16_t
+   */
+  uint16_t MpduExtractor::getLostFrameCount(void)
+  {
+    return mu16_LostFrameCount;
+  }
+
+
+
+  /**
+   * @brief Clears the lost frame counter
+   */
+  void MpduExtractor::clearErrorCounters(void)
+  {
+    mu16_LostFrameCount = 0;
+  }
+
+}
+
+#endif
@@ -0,0 +1,223 @@
+/**
+ * @file      ccsds_transferframe_aos.h
+ *
+ * @brief     Include file of the Transfer Frame (AOS) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_TRANSFERFRAME_AOS_H_
+#define _CCSDS_TRANSFERFRAME_AOS_H_
+
+/****************************************************************/
+/* AOS Transferframes according to                              */
+/*                                                              */
+/*  - CCSDS 131.0-B-3, - TM Synchronization and Channel Coding  */
+/*    https://public.ccsds.org/Pubs/131x0b3e1.pdf               */
+/*  - CCSDS 732.0-B-4, - AOS Space Data Link Protocol           */
+/*    https://public.ccsds.org/Pubs/732x0b4.pdf                 */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - The Frame Header Error Control field is not supported     */
+/*  - The VC frame count cycle is not used (24 bit count only)  */
+/*  - Frames must not exceed 2048 bytes, so the bitstream data  */
+/*    pointer of a B_PDU fits into its 14 bits                  */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+
+#ifdef configAOS_TF_TOTAL_SIZE
+#define AOS_TF_TOTAL_SIZE configAOS_TF_TOTAL_SIZE
+#else
+#define AOS_TF_TOTAL_SIZE 1115
+#endif
+
+
+#include "ccsds_transferframe.h"
+#include "ccsds_transferframe_tm.h"
+#include "ccsds_reedsolomon.h"
+#include "ccsds_spacepacket.h"
+#include "ccsds_encapsulation.h"
+
+
+#if AOS_TF_TOTAL_SIZE > 0
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Interface class for handling transferframe aos actions
+   */
+  class TransferframeAosActionInterface
+  {
+  public:
+    /**
+     * @brief Declaration of the action which shall be called if a complete AOS transfer frame was received
+     *
+     * The data field still holds the M_PDU or B_PDU header; it can be handed over to an MpduExtractor or to
+     * TransferframeAos::getBitstream(), depending on the virtual channel. The pointers refer to the frame
+     * buffer of the receiving object, so they are only valid during the callback.
+     *
+     * @param u8_SpacecraftID     The spacecraft ID
+     * @param u8_VirtualChannelID The virtual channel ID (63 for idle frames)
+     * @param u32_VcFrameCount    The virtual channel frame count (24 bit)
+     * @param b_ReplayFlag        true if the frame is a replay of stored data
+     * @param pu8_InsertZone      A pointer to the insert zone (nullptr if the insert zone size is 0)
+     * @param u8_InsertZoneSize   The size of the insert zone in bytes
+     * @param pu8_DataField       A pointer to the transfer frame data field (M_PDU or B_PDU)
+     * @param u16_DataFieldSize   The size of the data field in bytes
+     * @param u32_OCF             The Operational Control Field (OCF), usually the CLCW
+     */
+    virtual void onTransferframeAosReceived(const uint8_t u8_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                                            const uint32_t u32_VcFrameCount, const bool b_ReplayFlag,
+                                            const uint8_t *pu8_InsertZone, const uint8_t u8_InsertZoneSize,
+                                            const uint8_t *pu8_DataField, const uint16_t u16_DataFieldSize,
+                                            const uint32_t u32_OCF) = 0;
+  };
+
+
+
+  /**
+   * @brief Class for handling the Transfer Frames of the AOS Space Data Link Protocol as described in CCSDS 732.0-B-4.
+   *
+   * AOS frames are used for high-rate downlinks. Like TM frames, they have a fixed size within a mission and are
+   * preceded by the sync code 0x1ACFFC1D; they can be protected by the Reed-Solomon code and randomized in the
+   * same way (setReedSolomon(), setRandomization()). In contrast to TM frames, there are 64 virtual channels
+   * (channel 63 is used for idle frames), a 24 bit virtual channel frame count and an optional insert zone whose
+   * size is a managed parameter of the physical channel (setInsertZoneSize()). The OCF is used if TF_USE_OCF is set.
+   *
+   * The data field of a virtual channel is either a multiplexing protocol data unit (M_PDU), which carries space
+   * packets and a first header pointer, or a bitstream protocol data unit (B_PDU), which carries a bitstream and
+   * a pointer to its last valid bit. Which of them is used is defined per virtual channel by the mission.
+   *
+   * The received data field is not copied: the callback gets a pointer into the frame buffer, which can be given
+   * to an MpduExtractor for the space packets or to getBitstream() for the bitstream data.
+   */
+  class TransferframeAos : public Transferframe
+  {
+  public:
+    const static uint8_t IdleVirtualChannel = 63;
+    const static uint16_t NoFirstHdr = 0x7ff;       /**< M_PDU first header pointer if no packet starts in the frame */
+    const static uint16_t IdleFirstHdr = 0x7fe;     /**< M_PDU first header pointer if the frame holds idle data only */
+    const static uint16_t BitstreamAllValid = 0x3fff;  /**< B_PDU bitstream data pointer if all bits are valid */
+    const static uint16_t BitstreamIdle = 0x3ffe;      /**< B_PDU bitstream data pointer if the frame holds idle data only */
+    const static uint8_t PduHdrSize = 2;            // M_PDU and B_PDU header
+
+  private:
+    const static uint8_t AosTfVersionNumber = 1;
+    const static uint8_t PrimaryHdrSize = 6;
+    const static uint8_t OcfSize = 4;
+    const static uint16_t TfSize = AOS_TF_TOTAL_SIZE;
+    static_assert(AOS_TF_TOTAL_SIZE<=2048, "configAOS_TF_TOTAL_SIZE must not exceed 2048 (14 bit bitstream data pointer of B_PDUs)");
+#if TF_RS_MAX_INTERLEAVE > 0
+    // the Reed-Solomon check symbols are received behind the frame
+    const static uint16_t BufferSize = TfSize+TF_RS_MAX_INTERLEAVE*ReedSolomon::ParitySize;
+    uint8_t mu8_RsInterleaveDepth;
+#else
+    const static uint16_t BufferSize = TfSize;
+#endif
+    uint8_t mau8_Buffer[BufferSize];
+    uint8_t mu8_InsertZoneSize;
+
+    const static bool UseOCF = (TF_USE_OCF)?true:false;  // Operational Control Field (CLCW)
+
+    TransferframeAosActionInterface *mp_ActionInterface;
+
+  public:
+    TransferframeAos(TransferframeAosActionInterface *p_ActionInterface = nullptr);
+
+    void setActionInterface(TransferframeAosActionInterface *p_ActionInterface);
+    int32_t setInsertZoneSize(const uint8_t u8_InsertZoneSize);
+#if TF_RS_MAX_INTERLEAVE > 0
+    int32_t setReedSolomon(const uint8_t u8_InterleaveDepth);
+#endif
+
+    // AOS generation
+    static uint32_t createMpdu(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                               const uint8_t u8_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                               const uint32_t u32_VcFrameCount, const uint16_t u16_FirstHdrPtr,
+                               const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                               const uint32_t u32_OCF = 0,
+                               const uint8_t *pu8_InsertZone = nullptr, const uint8_t u8_InsertZoneSize = 0);
+
+    static uint32_t createBpdu(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                               const uint8_t u8_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                               const uint32_t u32_VcFrameCount,
+                               const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                               const uint32_t u32_OCF = 0,
+                               const uint8_t *pu8_InsertZone = nullptr, const uint8_t u8_InsertZoneSize = 0);
+
+    static uint32_t createIdle(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                               const uint8_t u8_SpacecraftID, const uint32_t u32_VcFrameCount,
+                               const uint32_t u32_OCF = 0,
+                               const uint8_t *pu8_InsertZone = nullptr, const uint8_t u8_InsertZoneSize = 0);
+
+    static uint16_t getDataZoneSize(const uint8_t u8_InsertZoneSize = 0);
+
+    // B_PDU processing
+    static int32_t getBitstream(const uint8_t *pu8_DataField, const uint16_t u16_DataFieldSize,
+                                const uint8_t **ppu8_Data, uint32_t *pu32_BitCount);
+
+  private:
+    static uint32_t _create(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                            const uint8_t u8_SpacecraftID, const uint8_t u8_VirtualChannelID,
+                            const uint32_t u32_VcFrameCount, const uint16_t u16_PduHeader,
+                            const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                            const uint32_t u32_OCF,
+                            const uint8_t *pu8_InsertZone, const uint8_t u8_InsertZoneSize);
+
+    int32_t _processFrame(void);
+    bool _decodeFrame(void);
+
+  private:
+    inline uint16_t _getMaxTfSize(void);
+    inline uint8_t *_getTfBufferAddr(void);
+    inline uint16_t _getPrimaryHeaderSize(void);
+    inline void _getFrameLength(void);
+  };
+
+
+
+  /**
+   * @brief Class for extracting the space packets of the M_PDUs of one virtual channel.
+   *
+   * The packet zones of consecutive frames are forwarded to a SpacePacket object, which assembles the packets
+   * (also across frame boundaries) and calls its action interface. If a frame of the virtual channel is lost
+   * (gap in the VC frame count) or at the start, the SpacePacket object is reset and the extraction continues at
+   * the first header pointer of the next frame which contains the start of a packet.
+   *
+   * If the virtual channel carries encapsulation packets (alone or mixed with space packets), an
+   * EncapsulationPacket object is set with setEncapsulationPacket(); it then receives the packet zones and
+   * forwards the space packets to its own SpacePacket object.
+   */
+  class MpduExtractor
+  {
+  private:
+    SpacePacket *mp_SpacePacket;
+    EncapsulationPacket *mp_EncapsulationPacket;
+    bool mb_Sync;
+    uint32_t mu32_NextFrameCount;
+    uint16_t mu16_LostFrameCount;
+
+  public:
+    MpduExtractor(SpacePacket *p_SpacePacket = nullptr);
+
+    void setSpacePacket(SpacePacket *p_SpacePacket);
+    void setEncapsulationPacket(EncapsulationPacket *p_EncapsulationPacket);
+    void reset(void);
+    int32_t process(const uint32_t u32_VcFrameCount, const uint8_t *pu8_DataField, const uint16_t u16_DataFieldSize);
+
+    uint16_t getLostFrameCount(void);
+    void clearErrorCounters(void);
+  };
+
+}
+
+#endif
+
+#endif // _CCSDS_TRANSFERFRAME_AOS_H_
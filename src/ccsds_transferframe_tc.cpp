@@ -28,8 +28,18 @@ namespace CCSDS
    * @param p_ActionInterface   A pointer to the implementation of the action interface
    */
   TransferframeTc::TransferframeTc(TransferframeTcActionInterface *p_ActionInterface) 
-    : Transferframe()
+    : Transferframe(Randomizer::TcSequence)
+#if TC_TF_USE_CLTU == 1
+    , mb_CltuSync{false}
+    , mb_CltuFrameDone{false}
+    , mb_CltuErrorCorrection{false}
+    , mu8_CltuIndex{0}
+    , mu16_CltuWritePos{0}
+#endif
     , mp_ActionInterface{p_ActionInterface}
+#if SDLS_MAX_SA > 0
+    , mp_Sdls{nullptr}
+#endif
   {
   }
   
@@ -47,6 +57,20 @@ namespace CCSDS
   
   
   
+#if SDLS_MAX_SA > 0
+  /**
+   * @brief Enables the Space Data Link Security (SDLS) for the received frames
+   *
+   * @param p_Sdls   A pointer to the Sdls object with the security associations or NULL to disable the security
+   */
+  void TransferframeTc::setSecurity(Sdls *p_Sdls)
+  {
+    mp_Sdls = p_Sdls;
+  }
+#endif
+  
+  
+  
   /**
    * @brief Creates a Telecommand Transfer Frame and writes it into the given buffer
    *
@@ -112,6 +136,132 @@ namespace CCSDS
   
   
   
+#if TC_TF_USE_CLTU == 1
+  /**
+   * @brief Selects the decoding mode of the code blocks for processCltu()
+   *
+   * @param b_Enabled  true to correct single bit errors (error-correcting mode), false to end
+   *                   the CLTU at the first code block with an error (error-detecting mode, default)
+   */
+  void TransferframeTc::setCltuErrorCorrection(const bool b_Enabled)
+  {
+    mb_CltuErrorCorrection = b_Enabled;
+  }
+  
+  
+  
+  /**
+   * @brief The given upstream data is parsed for CLTUs which contain Telecommand Transfer Frames.
+   *
+   * The method can handle continuously incoming data as well as complete data blocks. It replaces the
+   * combination of a Cltu object and process(): after a CLTU start sequence, the code blocks are checked
+   * and written directly into the frame buffer. As soon as the frame is complete, its CRC is checked and
+   * the action interface is called once; the fill data up to the tail sequence is only checked.
+   *
+   * A CLTU which ends (with the tail sequence or an invalid code block) before the frame is complete
+   * is counted as sync error. If setRandomization() was called, the code blocks are derandomized with
+   * the TC sequence.
+   *
+   * Attention: process() and processCltu() must not be used with the same object.
+   *
+   * @param pu8_Data      The data buffer which is to parse
+   * @param u16_DataSize  The size of the data buffer
+   *
+   * @retval  0   If the buffer was parsed
+   * @retval -1   If fhe u16_DataSize is 0 or the pu8_Data is NULL
+   */
+  int32_t TransferframeTc::processCltu(const uint8_t *pu8_Data, const uint16_t u16_DataSize)
+  {
+    const uint8_t au8_StartSequence[Cltu::StartSequenceSize]={0xeb, 0x90};
+    const uint16_t u16_MinFrameSize = PrimaryHdrSize+SegmentHdrSize+(UseFECF?FecfSize:0);
+    uint8_t *pu8_CodeBlock;
+    uint16_t u16_CopySize;
+    uint16_t i=0;
+    
+    if((u16_DataSize==0) || !pu8_Data)
+      return -1;
+    
+    while(i<u16_DataSize)
+    {
+      if(!mb_CltuSync)
+      {
+        if(pu8_Data[i]==au8_StartSequence[mu8_CltuIndex])
+          mu8_CltuIndex++;
+        else
+          mu8_CltuIndex=(pu8_Data[i]==au8_StartSequence[0])?1:0;
+        i++;
+        
+        if(mu8_CltuIndex==Cltu::StartSequenceSize)
+        {
+          mb_CltuSync=true;
+          mb_CltuFrameDone=false;
+          mu8_CltuIndex=0;
+          mu16_CltuWritePos=0;
+          mu16_FrameLength=0;
+        }
+        continue;
+      }
+      
+      // code blocks after the end of the frame are only checked, so they can overwrite the frame buffer
+      pu8_CodeBlock=&mau8_Buffer[mb_CltuFrameDone?0:mu16_CltuWritePos];
+      
+      if(mu8_CltuIndex<Cltu::DataBlockSize)
+      {
+        u16_CopySize=Cltu::DataBlockSize-mu8_CltuIndex;
+        if(u16_CopySize>u16_DataSize-i)
+          u16_CopySize=u16_DataSize-i;
+        memcpy(&pu8_CodeBlock[mu8_CltuIndex], &pu8_Data[i], u16_CopySize);
+        mu8_CltuIndex+=u16_CopySize;
+        i+=u16_CopySize;
+        continue;
+      }
+      
+      mu8_CltuIndex=0;
+      if(Cltu::decodeCodeBlock(pu8_CodeBlock, pu8_Data[i++], mb_CltuErrorCorrection)<0)
+      {
+        _endCltu();
+        continue;
+      }
+      if(mb_CltuFrameDone)
+        continue;
+      
+      if(mb_Randomization)
+        Randomizer::apply(me_RandomizerSequence, pu8_CodeBlock, Cltu::DataBlockSize, mu16_CltuWritePos);
+      mu16_CltuWritePos+=Cltu::DataBlockSize;
+      if(mu16_FrameLength==0 && mu16_CltuWritePos>=PrimaryHdrSize)
+      {
+        _getFrameLength();
+        if((mu16_FrameLength+1>MaxTfSize) || (mu16_FrameLength+1<u16_MinFrameSize))
+        {
+          if(mu16_OverflowErrorCount<0xffff)
+            mu16_OverflowErrorCount++;
+          mb_CltuSync=false;
+          mu16_FrameLength=0;
+          continue;
+        }
+      }
+      
+      if(mu16_CltuWritePos>=mu16_FrameLength+1)
+      {
+        mb_CltuFrameDone=true;
+#if TF_USE_FECF == 1
+        if(!_checkCRC())
+        {
+          if(mu16_ChecksumErrorCount<0xffff)
+            mu16_ChecksumErrorCount++;
+          continue;
+        }
+#endif
+        _processFrame();
+      }
+    }
+    
+    return 0;
+  }
+#endif
+  
+  
+  
   int32_t TransferframeTc::_createPrimaryHeader(uint8_t *pu8_Buffer,
                                                 const bool b_BypassFlag, const bool b_CtrlCmdFlag,
                                                 const uint16_t u16_SpacecraftID, const uint8_t u8_VirtualChannelID,
@@ -168,6 +318,8 @@ namespace CCSDS
     uint8_t u8_MAP;
     uint8_t *pu8_PrimaryHeader=mau8_Buffer;
     uint8_t *pu8_SegmentHeader=&mau8_Buffer[PrimaryHdrSize];
+    uint8_t *pu8_Data=&mau8_Buffer[PrimaryHdrSize+SegmentHdrSize];
+    uint16_t u16_DataSize=(mu16_FrameLength+1)-PrimaryHdrSize-SegmentHdrSize-(UseFECF?FecfSize:0);
     
     b_BypassFlag = (pu8_PrimaryHeader[0]&0x20)?true:false;
     b_CtrlCmdFlag = (pu8_PrimaryHeader[0]&0x10)?true:false;
@@ -177,15 +329,33 @@ namespace CCSDS
 
     u8_MAP = UseSegHdr?(pu8_SegmentHeader[0]&0x3F):0x00;
     
+#if SDLS_MAX_SA > 0
+    if(mp_Sdls && mp_Sdls->isSecured(u8_VirtualChannelID)
+       && (mp_Sdls->processSecurity(mau8_Buffer, mu16_FrameLength+1, PrimaryHdrSize+SegmentHdrSize, UseFECF?FecfSize:0,
+                                       u8_VirtualChannelID, &pu8_Data, &u16_DataSize)<0))
+      return -1;
+#endif
+    
     if(mp_ActionInterface)
     {
       mp_ActionInterface->onTransferframeTcReceived(b_BypassFlag, b_CtrlCmdFlag,
                                                     u16_SpacecraftID, u8_VirtualChannelID,
                                                     u8_FrameSeqNumber, u8_MAP,
-                                                    &mau8_Buffer[PrimaryHdrSize+SegmentHdrSize], (mu16_FrameLength+1)-PrimaryHdrSize-SegmentHdrSize-(UseFECF?FecfSize:0));
+                                                    pu8_Data, u16_DataSize);
     }
     return 0;
   }
   
   
+#if TC_TF_USE_CLTU == 1
+  void TransferframeTc::_endCltu(void)
+  {
+    if(!mb_CltuFrameDone && (mu16_SyncErrorCount<0xffff))
+      mu16_SyncErrorCount++;
+    mb_CltuSync=false;
+    mu16_FrameLength=0;
+  }
+#endif
+  
+  
 }
@@ -36,8 +36,16 @@
 #define TC_TF_MAX_SIZE 508
 #endif
 
+#ifdef configUSE_CLTU_SUPPORT
+#define TC_TF_USE_CLTU configUSE_CLTU_SUPPORT
+#else
+#define TC_TF_USE_CLTU 1
+#endif
+
 
 #include "ccsds_transferframe.h"
+#include "ccsds_cltu.h"
+#include "ccsds_sdls.h"
 
 
 namespace CCSDS 
@@ -98,6 +106,15 @@ namespace CCSDS
    * The size of the Transfer Frame may vary and depends on the information which are to be transfered.
    * The maximum size is limmited to 1024 bytes by the protocol including the header and the CRC. Since
    * source packets can be larger, sequence flags are used for segmentation of the uplink data.
+   *
+   * If the frames are received within CLTUs, processCltu() can be used instead of a Cltu object which
+   * forwards each code block to process(): the code blocks are decoded directly into the frame buffer and
+   * the frame is delivered once per CLTU.
+   *
+   * If an Sdls object is set with setSecurity(), the security header follows the segment header; the frames are
+   * checked and decrypted before the action interface is called, which then gets the data without the security
+   * header and trailer. Frames which fail the check are dropped and counted by the Sdls object; virtual channels
+   * without a security association are passed in clear.
    */
   class TransferframeTc : public Transferframe
   {
@@ -109,9 +126,23 @@ namespace CCSDS
 
     const static bool UseSegHdr = (configTF_TC_USE_SEG_HDR)?true:false;  // Frame error control field (CRC)
 
+#if TC_TF_USE_CLTU == 1
+    // the last code block of a frame may contain up to 6 fill bytes
+    uint8_t mau8_Buffer[MaxTfSize+Cltu::DataBlockSize-1];
+    
+    bool mb_CltuSync;
+    bool mb_CltuFrameDone;
+    bool mb_CltuErrorCorrection;
+    uint8_t mu8_CltuIndex;
+    uint16_t mu16_CltuWritePos;
+#else
     uint8_t mau8_Buffer[MaxTfSize];
+#endif
     
     TransferframeTcActionInterface *mp_ActionInterface;
+#if SDLS_MAX_SA > 0
+    Sdls *mp_Sdls;
+#endif
 
     enum ESeqFlags 
     {
@@ -125,6 +156,9 @@ namespace CCSDS
     TransferframeTc(TransferframeTcActionInterface *p_ActionInterface = nullptr);
     
     void setActionInterface(TransferframeTcActionInterface *p_ActionInterface);
+#if SDLS_MAX_SA > 0
+    void setSecurity(Sdls *p_Sdls);
+#endif
     
     // TC generation
     static uint32_t create(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
@@ -133,6 +167,12 @@ namespace CCSDS
                            const uint8_t u8_FrameSeqNumber, const uint8_t u8_MAP,
                            const uint8_t *pu8_Data, const uint16_t u16_DataSize);
     
+#if TC_TF_USE_CLTU == 1
+    // TC processing of CLTUs
+    void setCltuErrorCorrection(const bool b_Enabled);
+    int32_t processCltu(const uint8_t *pu8_Data, const uint16_t u16_DataSize);
+#endif
+    
   private:
     static int32_t _createPrimaryHeader(uint8_t *pu8_Buffer,
                                         const bool b_BypassFlag, const bool b_CtrlCmdFlag,
@@ -142,6 +182,9 @@ namespace CCSDS
     static int32_t _createSegmentHeader(uint8_t *pu8_Buffer, const enum ESeqFlags e_SeqFlags, const uint8_t u8_MAP);
     
     int32_t _processFrame(void);
+#if TC_TF_USE_CLTU == 1
+    void _endCltu(void);
+#endif
     
   private:
     inline uint16_t _getMaxTfSize(void);
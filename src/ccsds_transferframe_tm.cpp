@@ -29,8 +29,14 @@ namespace CCSDS
    * @param p_ActionInterface   A pointer to the implementation of the action interface
    */
   TransferframeTm::TransferframeTm(TransferframeTmActionInterface *p_ActionInterface) 
-    : Transferframe()
+    : Transferframe(Randomizer::TmSequence)
+#if TF_RS_MAX_INTERLEAVE > 0
+    , mu8_RsInterleaveDepth{0}
+#endif
     , mp_ActionInterface{p_ActionInterface}  
+#if SDLS_MAX_SA > 0
+    , mp_Sdls{nullptr}
+#endif
   {
   }
   
@@ -46,6 +52,48 @@ namespace CCSDS
   }
   
   
+#if SDLS_MAX_SA > 0
+  /**
+   * @brief Enables the Space Data Link Security (SDLS) for the received frames
+   *
+   * @param p_Sdls   A pointer to the Sdls object with the security associations or NULL to disable the security
+   */
+  void TransferframeTm::setSecurity(Sdls *p_Sdls)
+  {
+    mp_Sdls = p_Sdls;
+  }
+#endif
+  
+  
+#if TF_RS_MAX_INTERLEAVE > 0
+  /**
+   * @brief Enables the Reed-Solomon decoding of received frames
+   *
+   * If enabled, process() expects the check symbols of the (255,223) code behind each frame and corrects the
+   * frame in place before the CRC is checked. Frames which can not be corrected are counted as checksum errors.
+   *
+   * @param u8_InterleaveDepth  The interleaving depth (1 to 8) or 0 to disable the decoding; the frame size
+   *                            must be a multiple of the interleaving depth
+   *
+   * @retval  0   The decoding was set
+   * @retval -1   The interleaving depth is not supported with the frame size
+   */
+  int32_t TransferframeTm::setReedSolomon(const uint8_t u8_InterleaveDepth)
+  {
+    if(u8_InterleaveDepth>0)
+    {
+      if(u8_InterleaveDepth>ReedSolomon::MaxInterleaveDepth || (TfSize%u8_InterleaveDepth)!=0)
+        return -1;
+      if(TfSize/u8_InterleaveDepth>ReedSolomon::MessageSize)
+        return -1;
+    }
+    mu8_RsInterleaveDepth = u8_InterleaveDepth;
+    
+    return 0;
+  }
+#endif
+  
+  
   
   /**
    * @brief Creates a Telemetry Transfer Frame and writes it into the given buffer
@@ -61,6 +109,7 @@ namespace CCSDS
    * @param u16_DataSize                The size of the data block in bytes
    * @param u32_OCF                     The Operational Control Field (OCF), which is part of the flow control
    *                                    mechanism for uplink data (can hold the Communications Link Control Word (CLCW))
+   * @param b_Randomize                 true if the frame shall be randomized with the TM sequence
    *
    * @retval 0  No packet could be created
    * @return The size of the created packet in bytes as uint32_t
@@ -70,7 +119,7 @@ namespace CCSDS
                                    const uint8_t u8_MasterChannelFrameCount, const uint8_t u8_VirtualChannelFrameCount,
                                    const uint16_t u16_FirstHdrPtr,
                                    const uint8_t *pu8_Data, const uint16_t u16_DataSize,
-                                   const uint32_t u32_OCF)
+                                   const uint32_t u32_OCF, const bool b_Randomize)
   {
     uint16_t u16_AvailableDataSize;
 #if TF_USE_FECF == 1
@@ -79,6 +128,8 @@ namespace CCSDS
     
     if(!pu8_Buffer || (u32_BufferSize<TfSize))
       return 0;
+    if(b_Randomize && !UseRandomizer)
+      return 0;
     if(u16_DataSize>0 && !pu8_Data)
       return 0;
     
@@ -109,6 +160,9 @@ namespace CCSDS
     pu8_Buffer[TfSize-1] = (uint8_t)(u16_CRC&0xff);
 #endif
     
+    if(b_Randomize)
+      Randomizer::apply(Randomizer::TmSequence, pu8_Buffer, TfSize);
+    
     return TfSize;
   }
   
@@ -127,6 +181,7 @@ namespace CCSDS
    * @param u8_VirtualChannelFrameCount The channel-specific frame count, must be increased externally
    * @param u32_OCF                     The Operational Control Field (OCF), which is part of the flow control
    *                                    mechanism for uplink data (can hold the Communications Link Control Word (CLCW))
+   * @param b_Randomize                 true if the frame shall be randomized with the TM sequence
    *
    * @retval 0  No packet could be created
    * @return The size of the created packet in bytes as uint32_t
@@ -134,7 +189,7 @@ namespace CCSDS
   uint32_t TransferframeTm::createIdle(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
                                        const uint16_t u16_SpacecraftID, const uint8_t u8_VirtualChannelID,
                                        const uint8_t u8_MasterChannelFrameCount, const uint8_t u8_VirtualChannelFrameCount,
-                                       const uint32_t u32_OCF)
+                                       const uint32_t u32_OCF, const bool b_Randomize)
   {
     uint16_t u16_AvailableDataSize;
 #if TF_USE_FECF == 1
@@ -143,6 +198,8 @@ namespace CCSDS
     
     if(!pu8_Buffer || (u32_BufferSize<TfSize))
       return 0;
+    if(b_Randomize && !UseRandomizer)
+      return 0;
     
     u16_AvailableDataSize=TfSize-PrimaryHdrSize-(UseOCF?OcfSize:0)-(UseFECF?FecfSize:0);
     
@@ -168,6 +225,9 @@ namespace CCSDS
     pu8_Buffer[TfSize-1] = (uint8_t)(u16_CRC&0xff);
 #endif
     
+    if(b_Randomize)
+      Randomizer::apply(Randomizer::TmSequence, pu8_Buffer, TfSize);
+    
     return TfSize;
   }
   
@@ -196,7 +256,7 @@ namespace CCSDS
   
   inline uint16_t TransferframeTm::_getMaxTfSize(void)
   {
-    return TfSize;
+    return BufferSize;
   }
   
   inline uint8_t *TransferframeTm::_getTfBufferAddr(void)
@@ -212,6 +272,9 @@ namespace CCSDS
   inline void TransferframeTm::_getFrameLength(void)
   {
     mu16_FrameLength=TfSize-1;
+#if TF_RS_MAX_INTERLEAVE > 0
+    mu16_FrameLength+=mu8_RsInterleaveDepth*ReedSolomon::ParitySize;
+#endif
     // cout << "[" << mu16_FrameLength << "]";
   }
   
@@ -220,6 +283,21 @@ namespace CCSDS
   
   
   
+  bool TransferframeTm::_decodeFrame(void)
+  {
+#if TF_RS_MAX_INTERLEAVE > 0
+    if(mu8_RsInterleaveDepth>0)
+    {
+      mu16_FrameLength=TfSize-1;
+      if(ReedSolomon::decode(mau8_Buffer, TfSize, mu8_RsInterleaveDepth)<0)
+        return false;
+    }
+#endif
+    return true;
+  }
+  
+  
+  
   int32_t TransferframeTm::_processFrame(void)
   {
     uint16_t u16_SpacecraftID;
@@ -230,6 +308,8 @@ namespace CCSDS
     uint16_t u16_FirstHdrPtr;
     bool     b_TFSecHdrFlag;
     uint32_t u32_OCF=0x00;
+    uint8_t *pu8_Data;
+    uint16_t u16_DataSize;
     
     
     u16_SpacecraftID = (uint16_t)((mau8_Buffer[0]&0x3f)<<4) | (uint16_t)((mau8_Buffer[1]&0xf0)>>4);
@@ -248,12 +328,21 @@ namespace CCSDS
     }
 #endif
     
+    pu8_Data = &mau8_Buffer[PrimaryHdrSize];
+    u16_DataSize = TM_TF_TOTAL_SIZE-PrimaryHdrSize-((UseOCF&&b_OcfFlag)?OcfSize:0)-(UseFECF?FecfSize:0);
+#if SDLS_MAX_SA > 0
+    if(mp_Sdls && mp_Sdls->isSecured(u8_VirtualChannelID)
+       && (mp_Sdls->processSecurity(mau8_Buffer, TfSize, PrimaryHdrSize, ((UseOCF&&b_OcfFlag)?OcfSize:0)+(UseFECF?FecfSize:0),
+                                    u8_VirtualChannelID, &pu8_Data, &u16_DataSize)<0))
+      return -1;
+#endif
+    
     if(mp_ActionInterface)
     {
       mp_ActionInterface->onTransferframeTmReceived(u16_SpacecraftID, u8_VirtualChannelID,
                     u8_MasterChannelFrameCount, u8_VirtualChannelFrameCount,
                     b_TFSecHdrFlag, u16_FirstHdrPtr,
-                    &mau8_Buffer[PrimaryHdrSize], TM_TF_TOTAL_SIZE-PrimaryHdrSize-((UseOCF&&b_OcfFlag)?OcfSize:0)-(UseFECF?FecfSize:0),
+                    pu8_Data, u16_DataSize,
                     u32_OCF);
     }
     return 0;
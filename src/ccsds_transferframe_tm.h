@@ -21,7 +21,6 @@
 /*                                                              */
 /* Limitations:                                                 */ 
 /*  - The TM secondary header is not supported                  */
-/*  - Randomization is not supported                            */
 /*                                                              */
 /****************************************************************/
 
@@ -43,6 +42,8 @@
 
 
 #include "ccsds_transferframe.h"
+#include "ccsds_reedsolomon.h"
+#include "ccsds_sdls.h"
 
 
 namespace CCSDS
@@ -94,7 +95,11 @@ namespace CCSDS
    *
    * With respect to the specification, this class does *not* add a synchronization sequence to the head
    * of the transfer frame. These synchronization sequence (usually 0x1ACFFC1D) must be added before
-   * sending the transfer frame to the ground is done.
+   * sending the transfer frame to the ground is done. If the frames are protected by the Reed-Solomon code,
+   * process() corrects them in place when setReedSolomon() was called. If randomization is requested, the frame is randomized
+   * with the TM sequence after the CRC was calculated; process() removes it if setRandomization() was called.
+   * If an Sdls object is set with setSecurity(), the frames of secured virtual channels are checked and decrypted
+   * before the action interface is called, which then gets the data without the security header and trailer.
    *
    * With the Transfer Frame protocol, virtual channels (0 to 7) are supported. The virtual channels can
    * be used for different sub systems within one spacecraft or different purposes. Channel 0 is usually
@@ -117,16 +122,32 @@ namespace CCSDS
     const static uint8_t PrimaryHdrSize = 6;
     const static uint8_t OcfSize = 4;
     const static uint16_t TfSize = TM_TF_TOTAL_SIZE;
-    uint8_t mau8_Buffer[TfSize];
+#if TF_RS_MAX_INTERLEAVE > 0
+    // the Reed-Solomon check symbols are received behind the frame
+    const static uint16_t BufferSize = TfSize+TF_RS_MAX_INTERLEAVE*ReedSolomon::ParitySize;
+    uint8_t mu8_RsInterleaveDepth;
+#else
+    const static uint16_t BufferSize = TfSize;
+#endif
+    uint8_t mau8_Buffer[BufferSize];
     
     const static bool UseOCF = (TF_USE_OCF)?true:false;  // Operational Control Field (CLCW)
     
     TransferframeTmActionInterface *mp_ActionInterface;
+#if SDLS_MAX_SA > 0
+    Sdls *mp_Sdls;
+#endif
     
   public:
     TransferframeTm(TransferframeTmActionInterface *p_ActionInterface = nullptr);
     
     void setActionInterface(TransferframeTmActionInterface *p_ActionInterface);
+#if SDLS_MAX_SA > 0
+    void setSecurity(Sdls *p_Sdls);
+#endif
+#if TF_RS_MAX_INTERLEAVE > 0
+    int32_t setReedSolomon(const uint8_t u8_InterleaveDepth);
+#endif
     
     
     // TM generation
@@ -135,12 +156,12 @@ namespace CCSDS
                            const uint8_t u8_MasterChannelFrameCount, const uint8_t u8_VirtualChannelFrameCount,
                            const uint16_t u16_FirstHdrPtr,
                            const uint8_t *pu8_Data, const uint16_t u16_DataSize,
-                           const uint32_t u32_OCF = 0);
+                           const uint32_t u32_OCF = 0, const bool b_Randomize = false);
     
     static uint32_t createIdle(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
                                const uint16_t u16_SpacecraftID, const uint8_t u8_VirtualChannelID,
                                const uint8_t u8_MasterChannelFrameCount, const uint8_t u8_VirtualChannelFrameCount,
-                               const uint32_t u32_OCF = 0);
+                               const uint32_t u32_OCF = 0, const bool b_Randomize = false);
     
   private:
     static int32_t _createPrimaryHeader(uint8_t *pu8_Buffer,
@@ -150,6 +171,7 @@ namespace CCSDS
                                         const uint8_t u8_SegLengthID, const uint16_t u16_FirstHdrPtr);
     
     int32_t _processFrame(void);
+    bool _decodeFrame(void);
     
   private:
     inline uint16_t _getMaxTfSize(void);
@@ -0,0 +1,364 @@
+/**
+ * @file      ccsds_transferframe_uslp.cpp
+ *
+ * @brief     Source file of the Transfer Frame (USLP) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "ccsds_transferframe_uslp.h"
+
+
+#if USLP_TF_MAX_SIZE > 0
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Construct a new TransferframeUslp object
+   *
+   * The frames are expected to have variable length and no insert zone.
+   *
+   * @param p_ActionInterface   A pointer to the implementation of the action interface
+   */
+  TransferframeUslp::TransferframeUslp(TransferframeUslpActionInterface *p_ActionInterface)
+    : Transferframe(Randomizer::TmSequence)
+    , mu16_FrameSize{0}
+    , mu8_InsertZoneSize{0}
+    , mp_ActionInterface{p_ActionInterface}
+  {
+  }
+
+
+
+  /**
+   * @brief Overwrites the context pointer and callback which were set using the constructor
+   *
+   * @param p_ActionInterface   A pointer to the implementation of the action interface
+   */
+  void TransferframeUslp::setActionInterface(TransferframeUslpActionInterface *p_ActionInterface)
+  {
+    mp_ActionInterface = p_ActionInterface;
+  }
+
+
+
+  /**
+   * @brief Sets the frame size of the physical channel
+   *
+   * @param u16_FrameSize   The size of all frames in bytes (fixed length), or 0 if the frames have variable length
+   *
+   * @retval  0   The frame size was set
+   * @retval -1   The frame size exceeds the buffer (configUSLP_TF_MAX_SIZE)
+   */
+  int32_t TransferframeUslp::setFrameSize(const uint16_t u16_FrameSize)
+  {
+    if(u16_FrameSize>MaxTfSize)
+      return -1;
+    mu16_FrameSize = u16_FrameSize;
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Sets the size of the insert zone of the physical channel
+   *
+   * @param u8_InsertZoneSize   The size of the insert zone in bytes (0 if the insert zone is not used)
+   */
+  void TransferframeUslp::setInsertZoneSize(const uint8_t u8_InsertZoneSize)
+  {
+    mu8_InsertZoneSize = u8_InsertZoneSize;
+  }
+
+
+
+  /**
+   * @brief Returns the number of bytes of a frame which are not part of the data zone
+   *
+   * @param u8_VcFrameCountSize   The size of the VC frame count in bytes (0 to 7)
+   * @param u8_ConstructionRule   The construction rule of the data zone
+   * @param b_OcfFlag             true if the frame holds an Operational Control Field
+   * @param u8_InsertZoneSize     The size of the insert zone in bytes
+   *
+   * @return The size of the headers, the insert zone, the OCF and the FECF in bytes
+   */
+  uint32_t TransferframeUslp::getOverhead(const uint8_t u8_VcFrameCountSize, const uint8_t u8_ConstructionRule,
+                                          const bool b_OcfFlag, const uint8_t u8_InsertZoneSize)
+  {
+    return PrimaryHdrSize+(uint32_t)u8_VcFrameCountSize+u8_InsertZoneSize+_getDataFieldHeaderSize(u8_ConstructionRule)
+           +(b_OcfFlag?OcfSize:0)+(UseFECF?FecfSize:0);
+  }
+
+
+
+  /**
+   * @brief Creates a USLP Transfer Frame and writes it into the given buffer
+   *
+   * For a fixed-length frame, the data zone is filled up with 0xCA behind the given data; the first header
+   * pointer or last valid octet pointer in the header must be set accordingly by the caller.
+   *
+   * @param pu8_Buffer          A pointer to the buffer where the frame shall be stored
+   * @param u32_BufferSize      The available size of the buffer
+   * @param S_Header            The header fields of the frame
+   * @param pu8_Data            A pointer to the data which shall be wrapped
+   * @param u16_DataSize        The size of the data in bytes
+   * @param u16_FrameSize       The size of the frame for fixed-length frames, or 0 for a variable-length frame
+   * @param pu8_InsertZone      A pointer to the content of the insert zone
+   * @param u8_InsertZoneSize   The size of the insert zone in bytes (0 if the insert zone is not used)
+   *
+   * @retval 0  No frame could be created
+   * @return The size of the created frame in bytes as uint32_t
+   */
+  uint32_t TransferframeUslp::create(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                     const UslpHeader &S_Header,
+                                     const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                                     const uint16_t u16_FrameSize,
+                                     const uint8_t *pu8_InsertZone, const uint8_t u8_InsertZoneSize)
+  {
+    uint32_t u32_FrameSize;
+    uint32_t u32_Pos;
+    uint32_t u32_DataZoneSize;
+#if TF_USE_FECF == 1
+    uint16_t u16_CRC;
+#endif
+
+    if(!pu8_Buffer)
+      return 0;
+    if((u16_DataSize>0 && !pu8_Data) || (u8_InsertZoneSize>0 && !pu8_InsertZone))
+      return 0;
+    if(S_Header.u8_VirtualChannelID>63 || S_Header.u8_MAP>15 || S_Header.u8_VcFrameCountSize>7
+       || S_Header.u8_ConstructionRule>7 || S_Header.u8_ProtocolID>31)
+      return 0;
+
+    u32_FrameSize = getOverhead(S_Header.u8_VcFrameCountSize, S_Header.u8_ConstructionRule,
+                                S_Header.b_OcfFlag, u8_InsertZoneSize);
+    u32_DataZoneSize = u16_DataSize;
+    if(u16_FrameSize>0)
+    {
+      if(u16_FrameSize<u32_FrameSize+u16_DataSize)
+        return 0;
+      u32_DataZoneSize = u16_FrameSize-u32_FrameSize;
+    }
+    u32_FrameSize += u32_DataZoneSize;
+    if(u32_BufferSize<u32_FrameSize || u32_FrameSize>0x10000)
+      return 0;
+
+    // primary header
+    pu8_Buffer[0] = (uint8_t)((UslpTfVersionNumber<<4) | (S_Header.u16_SpacecraftID>>12));
+    pu8_Buffer[1] = (uint8_t)(S_Header.u16_SpacecraftID>>4);
+    pu8_Buffer[2] = (uint8_t)(((S_Header.u16_SpacecraftID&0x0f)<<4) | ((S_Header.b_DestinationFlag?1:0)<<3)
+                              | (S_Header.u8_VirtualChannelID>>3));
+    pu8_Buffer[3] = (uint8_t)(((S_Header.u8_VirtualChannelID&0x07)<<5) | (S_Header.u8_MAP<<1));
+    pu8_Buffer[4] = (uint8_t)((u32_FrameSize-1)>>8);
+    pu8_Buffer[5] = (uint8_t)((u32_FrameSize-1)&0xff);
+    pu8_Buffer[6] = (uint8_t)(((S_Header.b_BypassFlag?1:0)<<7) | ((S_Header.b_CtrlCmdFlag?1:0)<<6)
+                              | ((S_Header.b_OcfFlag?1:0)<<3) | S_Header.u8_VcFrameCountSize);
+    u32_Pos = PrimaryHdrSize;
+    for(uint8_t i=S_Header.u8_VcFrameCountSize; i>0; i--)
+      pu8_Buffer[u32_Pos++] = (uint8_t)(S_Header.u64_VcFrameCount>>(8*(i-1)));
+
+    // insert zone
+    if(u8_InsertZoneSize>0)
+      memcpy(&pu8_Buffer[u32_Pos], pu8_InsertZone, u8_InsertZoneSize);
+    u32_Pos += u8_InsertZoneSize;
+
+    // transfer frame data field header and data zone
+    pu8_Buffer[u32_Pos++] = (uint8_t)((S_Header.u8_ConstructionRule<<5) | S_Header.u8_ProtocolID);
+    if(_getDataFieldHeaderSize(S_Header.u8_ConstructionRule)>1)
+    {
+      pu8_Buffer[u32_Pos++] = (uint8_t)(S_Header.u16_FirstHdrPtr>>8);
+      pu8_Buffer[u32_Pos++] = (uint8_t)(S_Header.u16_FirstHdrPtr&0xff);
+    }
+    if(u16_DataSize>0)
+      memcpy(&pu8_Buffer[u32_Pos], pu8_Data, u16_DataSize);
+    if(u32_DataZoneSize>u16_DataSize)
+      memset(&pu8_Buffer[u32_Pos+u16_DataSize], 0xCA, u32_DataZoneSize-u16_DataSize);
+    u32_Pos += u32_DataZoneSize;
+
+    if(S_Header.b_OcfFlag)
+    {
+      pu8_Buffer[u32_Pos++] = (uint8_t)(S_Header.u32_OCF>>24);
+      pu8_Buffer[u32_Pos++] = (uint8_t)(S_Header.u32_OCF>>16);
+      pu8_Buffer[u32_Pos++] = (uint8_t)(S_Header.u32_OCF>>8);
+      pu8_Buffer[u32_Pos++] = (uint8_t)(S_Header.u32_OCF&0xff);
+    }
+
+#if TF_USE_FECF == 1
+    u16_CRC = Transferframe::calcCRC(pu8_Buffer, (uint16_t)u32_Pos);
+    pu8_Buffer[u32_Pos]   = (uint8_t)(u16_CRC>>8);
+    pu8_Buffer[u32_Pos+1] = (uint8_t)(u16_CRC&0xff);
+#endif
+
+    return u32_FrameSize;
+  }
+
+
+
+  /**
+   * @brief Processes a complete USLP Transfer Frame in place
+   *
+   * This method can be used instead of process() if the frames are already delimited, e.g. by a hardware frame
+   * synchronizer. The frame is not copied; it is derandomized in place (if the randomization was enabled), the
+   * CRC is checked and the callback gets pointers into the given frame.
+   *
+   * @param pu8_Frame       A pointer to the frame (without sync code)
+   * @param u16_FrameSize   The size of the frame in bytes
+   *
+   * @retval  0   The frame was delivered
+   * @retval -1   The frame is invalid (the corresponding error counter is increased)
+   */
+  int32_t TransferframeUslp::processFrame(uint8_t *pu8_Frame, const uint16_t u16_FrameSize)
+  {
+    if(!pu8_Frame || u16_FrameSize<PrimaryHdrSize)
+      return -1;
+
+    if(mb_Randomization)
+      Randomizer::apply(me_RandomizerSequence, pu8_Frame, u16_FrameSize);
+
+    if((((uint16_t)pu8_Frame[4]<<8) | (uint16_t)pu8_Frame[5])+1!=u16_FrameSize)
+    {
+      if(mu16_OverflowErrorCount<0xffff)
+        mu16_OverflowErrorCount++;
+      return -1;
+    }
+
+#if TF_USE_FECF == 1
+    if(u16_FrameSize<PrimaryHdrSize+FecfSize
+       || calcCRC(pu8_Frame, u16_FrameSize-FecfSize)!=(((uint16_t)pu8_Frame[u16_FrameSize-2]<<8) | (uint16_t)pu8_Frame[u16_FrameSize-1]))
+    {
+      if(mu16_ChecksumErrorCount<0xffff)
+        mu16_ChecksumErrorCount++;
+      return -1;
+    }
+#endif
+
+    return _deliver(pu8_Frame, u16_FrameSize);
+  }
+
+
+
+  uint8_t TransferframeUslp::_getDataFieldHeaderSize(const uint8_t u8_ConstructionRule)
+  {
+    // only the construction rules with fixed-length data zones carry a pointer
+    return (u8_ConstructionRule<=MapaSduContinuing)?3:1;
+  }
+
+
+
+  /*
+   * Evaluates the headers of a checked frame and calls the action interface with pointers into the frame
+   */
+  int32_t TransferframeUslp::_deliver(const uint8_t *pu8_Frame, const uint16_t u16_FrameSize)
+  {
+    UslpHeader S_Header;
+    uint32_t u32_Pos;
+    uint32_t u32_TrailerSize;
+    const uint8_t *pu8_InsertZone;
+
+    // truncated primary headers (end of frame primary header flag) are not supported
+    if((pu8_Frame[0]>>4)!=UslpTfVersionNumber || (pu8_Frame[3]&0x01))
+    {
+      if(mu16_SyncErrorCount<0xffff)
+        mu16_SyncErrorCount++;
+      return -1;
+    }
+    if(mu16_FrameSize>0 && u16_FrameSize!=mu16_FrameSize)
+    {
+      if(mu16_OverflowErrorCount<0xffff)
+        mu16_OverflowErrorCount++;
+      return -1;
+    }
+
+    S_Header.u16_SpacecraftID = (uint16_t)((pu8_Frame[0]&0x0f)<<12) | (uint16_t)(pu8_Frame[1]<<4) | (uint16_t)(pu8_Frame[2]>>4);
+    S_Header.b_DestinationFlag = (pu8_Frame[2]&0x08)?true:false;
+    S_Header.u8_VirtualChannelID = (uint8_t)(((pu8_Frame[2]&0x07)<<3) | (pu8_Frame[3]>>5));
+    S_Header.u8_MAP = (uint8_t)((pu8_Frame[3]>>1)&0x0f);
+    S_Header.b_BypassFlag = (pu8_Frame[6]&0x80)?true:false;
+    S_Header.b_CtrlCmdFlag = (pu8_Frame[6]&0x40)?true:false;
+    S_Header.b_OcfFlag = (pu8_Frame[6]&0x08)?true:false;
+    S_Header.u8_VcFrameCountSize = (uint8_t)(pu8_Frame[6]&0x07);
+
+    u32_TrailerSize = (S_Header.b_OcfFlag?OcfSize:0)+(UseFECF?FecfSize:0);
+    if(u16_FrameSize<PrimaryHdrSize+S_Header.u8_VcFrameCountSize+mu8_InsertZoneSize+1+u32_TrailerSize)
+    {
+      if(mu16_OverflowErrorCount<0xffff)
+        mu16_OverflowErrorCount++;
+      return -1;
+    }
+
+    u32_Pos = PrimaryHdrSize;
+    S_Header.u64_VcFrameCount = 0;
+    for(uint8_t i=0; i<S_Header.u8_VcFrameCountSize; i++)
+      S_Header.u64_VcFrameCount = (S_Header.u64_VcFrameCount<<8) | pu8_Frame[u32_Pos++];
+
+    pu8_InsertZone = (mu8_InsertZoneSize>0)?&pu8_Frame[u32_Pos]:nullptr;
+    u32_Pos += mu8_InsertZoneSize;
+
+    S_Header.u8_ConstructionRule = (uint8_t)(pu8_Frame[u32_Pos]>>5);
+    S_Header.u8_ProtocolID = (uint8_t)(pu8_Frame[u32_Pos]&0x1f);
+    S_Header.u16_FirstHdrPtr = NoFirstHdr;
+    if(_getDataFieldHeaderSize(S_Header.u8_ConstructionRule)>1)
+    {
+      if(u16_FrameSize<u32_Pos+3+u32_TrailerSize)
+      {
+        if(mu16_OverflowErrorCount<0xffff)
+          mu16_OverflowErrorCount++;
+        return -1;
+      }
+      S_Header.u16_FirstHdrPtr = (uint16_t)(pu8_Frame[u32_Pos+1]<<8) | (uint16_t)pu8_Frame[u32_Pos+2];
+    }
+    u32_Pos += _getDataFieldHeaderSize(S_Header.u8_ConstructionRule);
+
+    S_Header.u32_OCF = 0;
+    if(S_Header.b_OcfFlag)
+    {
+      const uint8_t *pu8_OCF = &pu8_Frame[u16_FrameSize-u32_TrailerSize];
+      S_Header.u32_OCF = ((uint32_t)pu8_OCF[0]<<24) | ((uint32_t)pu8_OCF[1]<<16) | ((uint32_t)pu8_OCF[2]<<8) | (uint32_t)pu8_OCF[3];
+    }
+
+    if(mp_ActionInterface)
+    {
+      mp_ActionInterface->onTransferframeUslpReceived(S_Header, pu8_InsertZone, mu8_InsertZoneSize,
+                                                      &pu8_Frame[u32_Pos], (uint16_t)(u16_FrameSize-u32_Pos-u32_TrailerSize));
+    }
+    return 0;
+  }
+
+
+
+  int32_t TransferframeUslp::_processFrame(void)
+  {
+    return _deliver(mau8_Buffer, mu16_FrameLength+1);
+  }
+
+
+
+  inline uint16_t TransferframeUslp::_getMaxTfSize(void)
+  {
+    return MaxTfSize;
+  }
+
+  inline uint8_t *TransferframeUslp::_getTfBufferAddr(void)
+  {
+    return mau8_Buffer;
+  }
+
+  inline uint16_t TransferframeUslp::_getPrimaryHeaderSize(void)
+  {
+    return PrimaryHdrSize;
+  }
+
+  inline void TransferframeUslp::_getFrameLength(void)
+  {
+    mu16_FrameLength=(uint16_t)((uint16_t)(mau8_Buffer[4]<<8) | (uint16_t)mau8_Buffer[5]);
+  }
+
+}
+
+#endif
@@ -0,0 +1,192 @@
+/**
+ * @file      ccsds_transferframe_uslp.h
+ *
+ * @brief     Include file of the Transfer Frame (USLP) class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#ifndef _CCSDS_TRANSFERFRAME_USLP_H_
+#define _CCSDS_TRANSFERFRAME_USLP_H_
+
+/****************************************************************/
+/* USLP Transferframes according to                             */
+/*                                                              */
+/*  - CCSDS 732.1-B-2, - Unified Space Data Link Protocol       */
+/*    https://public.ccsds.org/Pubs/732x1b2.pdf                 */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Truncated transfer frame primary headers are not          */
+/*    supported                                                 */
+/*  - The FECF is always the 16 bit CRC (if configured)         */
+/*  - Frames must not exceed 65531 bytes because of the 16 bit  */
+/*    stream index of the parser                                */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+
+#ifdef configUSLP_TF_MAX_SIZE
+#define USLP_TF_MAX_SIZE configUSLP_TF_MAX_SIZE
+#else
+#define USLP_TF_MAX_SIZE 4096
+#endif
+
+
+#include "ccsds_transferframe.h"
+
+
+#if USLP_TF_MAX_SIZE > 0
+
+namespace CCSDS
+{
+
+  /**
+   * @brief Header fields of a USLP transfer frame (primary header, data field header and OCF)
+   */
+  struct UslpHeader
+  {
+    uint16_t u16_SpacecraftID;        /**< The spacecraft ID (16 bit) */
+    bool b_DestinationFlag;           /**< true if the spacecraft ID is the destination, false if it is the source */
+    uint8_t u8_VirtualChannelID;      /**< The virtual channel ID (0 to 63) */
+    uint8_t u8_MAP;                   /**< The multiplexer access point ID (0 to 15) */
+    bool b_BypassFlag;                /**< true for expedited (BD) frames, false for sequence-controlled (AD) frames */
+    bool b_CtrlCmdFlag;               /**< true if the frame holds protocol control commands (COP) */
+    uint8_t u8_VcFrameCountSize;      /**< The size of the VC frame count in bytes (0 to 7) */
+    uint64_t u64_VcFrameCount;        /**< The virtual channel frame count */
+    uint8_t u8_ConstructionRule;      /**< The construction rule of the data zone, see TransferframeUslp::ConstructionRule */
+    uint8_t u8_ProtocolID;            /**< The USLP protocol ID of the data zone, see TransferframeUslp::ProtocolID */
+    uint16_t u16_FirstHdrPtr;         /**< First header pointer or last valid octet pointer (construction rules 0 to 2 only) */
+    bool b_OcfFlag;                   /**< true if the frame holds an Operational Control Field */
+    uint32_t u32_OCF;                 /**< The Operational Control Field (usually the CLCW) */
+  };
+
+
+
+  /**
+   * @brief Interface class for handling transferframe uslp actions
+   */
+  class TransferframeUslpActionInterface
+  {
+  public:
+    /**
+     * @brief Declaration of the action which shall be called if a complete USLP transfer frame was received
+     *
+     * The pointers refer to the frame buffer of the receiving object (or to the frame given to processFrame()),
+     * so they are only valid during the callback.
+     *
+     * @param S_Header          The header fields of the frame
+     * @param pu8_InsertZone    A pointer to the insert zone (nullptr if the insert zone size is 0)
+     * @param u8_InsertZoneSize The size of the insert zone in bytes
+     * @param pu8_Data          A pointer to the transfer frame data zone
+     * @param u16_DataSize      The size of the data zone in bytes
+     */
+    virtual void onTransferframeUslpReceived(const UslpHeader &S_Header,
+                                             const uint8_t *pu8_InsertZone, const uint8_t u8_InsertZoneSize,
+                                             const uint8_t *pu8_Data, const uint16_t u16_DataSize) = 0;
+  };
+
+
+
+  /**
+   * @brief Class for handling the Transfer Frames of the Unified Space Data Link Protocol as described in CCSDS 732.1-B-2.
+   *
+   * USLP frames can be used for uplink and downlink. In contrast to TM and TC frames, they can be up to 65536 bytes
+   * long, have a 16 bit spacecraft ID, up to 64 virtual channels with 16 MAPs each and a virtual channel frame count
+   * of 0 to 7 bytes.
+   *
+   * The length of the frames is a managed parameter of the physical channel: either all frames have the same size
+   * (fixed length, e.g. for a continuous downlink) or each frame has its own size (variable length). In both cases
+   * the frame length is part of the primary header, so process() can parse both kinds of frames; with
+   * setFrameSize(), frames which do not have the expected size are rejected. The insert zone is another managed
+   * parameter; its size must be set with setInsertZoneSize() on both sides.
+   *
+   * Like TM frames, USLP frames are expected to be preceded by the sync code 0x1ACFFC1D in the stream given to
+   * process(); setSync() can be used if the frames are delimited by another layer. Frames which are already
+   * delimited (e.g. by a hardware frame synchronizer) can be handed over to processFrame(), which checks them in
+   * place without copying.
+   *
+   * The received data zone is not copied: the callback gets pointers into the frame buffer.
+   */
+  class TransferframeUslp : public Transferframe
+  {
+  public:
+    enum ConstructionRule
+    {
+      PacketsSpanning = 0,        /**< Packets spanning multiple frames, with first header pointer */
+      MapaSduStart = 1,           /**< Start of a MAPA_SDU, with last valid octet pointer */
+      MapaSduContinuing = 2,      /**< Continuing portion of a MAPA_SDU, with last valid octet pointer */
+      OctetStream = 3,            /**< Octet stream */
+      SegmentStart = 4,           /**< Starting segment of a variable-length unit */
+      SegmentContinuing = 5,      /**< Continuing segment of a variable-length unit */
+      SegmentLast = 6,            /**< Last segment of a variable-length unit */
+      NoSegmentation = 7          /**< A complete variable-length unit (packet or MAPA_SDU) */
+    };
+
+    enum ProtocolID
+    {
+      SpacePacketProtocol = 0,    /**< Space packets or encapsulation packets */
+      Cop1ControlCommands = 1,
+      CopPControlCommands = 2,
+      SdlsProtocol = 3,
+      UserOctetStream = 4,
+      MissionSpecific = 5,
+      IdleData = 31
+    };
+
+    const static uint16_t NoFirstHdr = 0xffff;    /**< First header pointer if no packet starts in the frame */
+
+  private:
+    const static uint8_t UslpTfVersionNumber = 12;
+    const static uint8_t PrimaryHdrSize = 7;        // without the VC frame count
+    const static uint8_t OcfSize = 4;
+    const static uint16_t MaxTfSize = USLP_TF_MAX_SIZE;
+
+    uint8_t mau8_Buffer[MaxTfSize];
+    uint16_t mu16_FrameSize;
+    uint8_t mu8_InsertZoneSize;
+
+    TransferframeUslpActionInterface *mp_ActionInterface;
+
+  public:
+    TransferframeUslp(TransferframeUslpActionInterface *p_ActionInterface = nullptr);
+
+    void setActionInterface(TransferframeUslpActionInterface *p_ActionInterface);
+    int32_t setFrameSize(const uint16_t u16_FrameSize);
+    void setInsertZoneSize(const uint8_t u8_InsertZoneSize);
+
+    // USLP generation
+    static uint32_t create(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                           const UslpHeader &S_Header,
+                           const uint8_t *pu8_Data, const uint16_t u16_DataSize,
+                           const uint16_t u16_FrameSize = 0,
+                           const uint8_t *pu8_InsertZone = nullptr, const uint8_t u8_InsertZoneSize = 0);
+
+    static uint32_t getOverhead(const uint8_t u8_VcFrameCountSize, const uint8_t u8_ConstructionRule,
+                                const bool b_OcfFlag, const uint8_t u8_InsertZoneSize = 0);
+
+    // USLP processing of delimited frames
+    int32_t processFrame(uint8_t *pu8_Frame, const uint16_t u16_FrameSize);
+
+  private:
+    static uint8_t _getDataFieldHeaderSize(const uint8_t u8_ConstructionRule);
+    int32_t _deliver(const uint8_t *pu8_Frame, const uint16_t u16_FrameSize);
+
+    int32_t _processFrame(void);
+
+  private:
+    inline uint16_t _getMaxTfSize(void);
+    inline uint8_t *_getTfBufferAddr(void);
+    inline uint16_t _getPrimaryHeaderSize(void);
+    inline void _getFrameLength(void);
+  };
+
+}
+
+#endif
+
+#endif // _CCSDS_TRANSFERFRAME_USLP_H_
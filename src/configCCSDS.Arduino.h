@@ -8,24 +8,99 @@
 /** Maximum size of space packets (can be up to 65535 according to the standard) */
 #define configSP_MAX_DATA_SIZE      32  
 
+/** Maximum data size of encapsulation packets which are split over several process() calls (complete packets are not copied) */
+#define configEP_MAX_DATA_SIZE      32  
+
 /** Telecommand TF size (without SYNC); maximum as defined in CCSDS 232.0-B-3 is 1024 */
 #define configTC_TF_MAX_SIZE        44  
 
 /** Telemetry TF size (without SYNC) */
 #define configTM_TF_TOTAL_SIZE      44  
 
+/** Maximum size of USLP transfer frames (without SYNC); up to 65531, 0 disables USLP */
+#define configUSLP_TF_MAX_SIZE       0  
+
+/** AOS TF size (without SYNC); 0 disables AOS */
+#define configAOS_TF_TOTAL_SIZE       0  
+
 /** The OCF field (which contains the CLCW needed for automatic re-transfer) is optional */
 #define configTF_USE_OCF             1  
 
 /** The Frame Error Control Field (FECF) contains the CRC of telemetry packets */
 #define configTF_USE_FECF            1
 
+/** The FECF is calculated with a lookup table (512 bytes) instead of bit by bit */
+#define configTF_USE_CRC_TABLE       0
+
+/** The pseudo-randomizer sequences (CCSDS 131.0 / 231.0) can be applied to transfer frames (2*258 bytes of tables) */
+#define configTF_USE_RANDOMIZER      0
+
+/** Maximum interleaving depth of the Reed-Solomon (255,223) code for TM frames (0 disables the code and its 9.5k tables) */
+#define configTF_RS_MAX_INTERLEAVE   0
+
+/** Traceback depth of the Viterbi decoder for the convolutional code in bits (0 disables the decoder; about 9 bytes of RAM per bit) */
+#define configTF_VITERBI_TRACEBACK_DEPTH 0
+
 /** the maximum number of spacecraft IDs which can be checked by tmtc client */
 #define configTMTC_MAX_SCIDS         2  
 
 /** FrameSeqNumber window for AD mode, see 232.1-b-2 */
 #define configFARM_SLIDING_WINDOW_WIDTH 16  
 
+/** Maximum number of PUS services which can be registered at the telecommand registry */
+#define configPUS_MAX_SERVICES       4  
+
+/** Subservices of a registered PUS service must be lower than this value */
+#define configPUS_MAX_SUBSERVICES   16  
+
+/** Number of time-tagged telecommands which can be stored by the onboard scheduler (service 11), below 65535 */
+#define configPUS_SCHEDULER_MAX_COMMANDS   4  
+
+/** Maximum size of a time-tagged telecommand packet (including headers) */
+#define configPUS_SCHEDULER_MAX_TC_SIZE   32  
+
+/** Number of bits per level of the scheduler timer wheel (the wheel has 2^bits slots per level) */
+#define configPUS_SCHEDULER_WHEEL_BITS     4  
+
+/** Number of entries of the sparse index of the packet store (service 15) */
+#define configPUS_STORE_INDEX_SIZE         8  
+
+/** Number of packets which are covered by one index entry of the packet store */
+#define configPUS_STORE_INDEX_INTERVAL     4  
+
+/** Maximum number of housekeeping report definitions (service 3), below 255 */
+#define configPUS_HK_MAX_REPORTS           2  
+
+/** Maximum number of copy operations of all compiled housekeeping report definitions */
+#define configPUS_HK_MAX_COPY_OPS          8  
+
+/** Maximum number of parameter monitors of the onboard monitoring (service 12) */
+#define configPUS_MON_MAX_MONITORS         4  
+
+/** Maximum number of memory regions of the memory management (service 6) */
+#define configPUS_MEM_MAX_REGIONS          2  
+
+/** Maximum number of large data units which are received at the same time (service 13) */
+#define configPUS_LDT_MAX_TRANSACTIONS     1  
+
+/** Number of parts which can be received out of order behind a missing part (service 13) */
+#define configPUS_LDT_WINDOW_SIZE         16  
+
+/** Maximum number of missing file ranges (gaps) which the CFDP receiver can track */
+#define configCFDP_MAX_GAPS               4  
+
+/** Maximum number of SDLS security associations (about 550 bytes each); 0 disables SDLS */
+#define configSDLS_MAX_SA                0  
+
+/** The AES rounds are calculated with a lookup table (1 kB) instead of byte by byte */
+#define configSDLS_USE_AES_TABLE         0  
+
+/** Maximum number of parameter definitions of the telemetry decommutator */
+#define configDECOM_MAX_PARAMETERS     16  
+
+/** Maximum number of APIDs with a decommutation program */
+#define configDECOM_MAX_APIDS           2  
+
 #ifndef configUSE_CLTU_SUPPORT             // this is needed for test cases
 /** CLTUs are used to syncronize to the uplink data stream. On TET1, this is done by hardware. */
 # define configUSE_CLTU_SUPPORT       0
@@ -36,5 +111,8 @@
  */
 #define configCLTU_MAX_SIZE         66   
 
+/** The BCH parity of CLTU code blocks is calculated with lookup tables (384 bytes) instead of bit by bit */
+#define configCLTU_USE_BCH_TABLE     0
+
 
 #endif // _CONFIG_CCSDS_H_
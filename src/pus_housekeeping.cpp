@@ -0,0 +1,304 @@
+/**
+ * @file      pus_housekeeping.cpp
+ *
+ * @brief     Source file of the PUS housekeeping class (service 3)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "pus_housekeeping.h"
+#include "ccsds_spacepacket.h"
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Construct a new Housekeeping object without report definitions
+   */
+  Housekeeping::Housekeeping(void)
+    : mu8_ReportCount{0}
+    , mu16_OpCount{0}
+  {
+  }
+
+
+
+  /**
+   * @brief Defines a periodic housekeeping report and compiles it into a copy program
+   *
+   * The parameters are copied into the report in the given order. An already existing definition
+   * with the same structure ID (SID) is replaced. New reports are enabled and generated with the
+   * next call of generate().
+   *
+   * @param u8_SID              The structure ID of the report
+   * @param u16_APID            The APID of the report packets
+   * @param u16_Interval        The collection interval in ticks of the onboard time
+   * @param pS_Parameters       The list of parameters
+   * @param u16_ParameterCount  The number of parameters
+   *
+   * @retval  0   If the report was defined
+   * @retval -1   If the parameters are invalid or the report is too large
+   * @retval -2   If the maximum number of reports or copy operations is reached
+   */
+  int32_t Housekeeping::defineReport(const uint8_t u8_SID, const uint16_t u16_APID, const uint16_t u16_Interval,
+                                     const Parameter *pS_Parameters, const uint16_t u16_ParameterCount)
+  {
+    uint32_t u32_DataSize = 0;
+    uint16_t u16_Ops = 0;
+    uint16_t u16_OpSize = 0;
+    const uint8_t *pu8_End = nullptr;
+    uint8_t u8_Report;
+
+    if(!pS_Parameters || (u16_ParameterCount==0))
+      return -1;
+
+    // count the copy operations after merging adjacent parameters
+    for(uint16_t i=0; i<u16_ParameterCount; i++)
+    {
+      const uint8_t *pu8_Address = (const uint8_t*)pS_Parameters[i].p_Address;
+      if(!pu8_Address || (pS_Parameters[i].u16_Size==0))
+        return -1;
+      if((i>0) && (pu8_Address==pu8_End) && (u16_OpSize<=0xffff-pS_Parameters[i].u16_Size))
+      {
+        u16_OpSize = (uint16_t)(u16_OpSize+pS_Parameters[i].u16_Size);
+      }
+      else
+      {
+        u16_OpSize = pS_Parameters[i].u16_Size;
+        u16_Ops++;
+      }
+      pu8_End = pu8_Address+pS_Parameters[i].u16_Size;
+      u32_DataSize += pS_Parameters[i].u16_Size;
+    }
+    if(TemplateSize+u32_DataSize>0xffff)
+      return -1;
+
+    u8_Report = _findReport(u8_SID);
+    if(u8_Report==NoReport)
+    {
+      if((mu8_ReportCount>=PUS_HK_MAX_REPORTS) || (mu16_OpCount+u16_Ops>PUS_HK_MAX_COPY_OPS))
+        return -2;
+    }
+    else
+    {
+      if(mu16_OpCount-mau16_OpCount[u8_Report]+u16_Ops>PUS_HK_MAX_COPY_OPS)
+        return -2;
+      deleteReport(u8_SID);
+    }
+
+    u8_Report = mu8_ReportCount++;
+    mau8_SID[u8_Report] = u8_SID;
+    mab_Enabled[u8_Report] = true;
+    mab_Started[u8_Report] = false;
+    mau32_NextDue[u8_Report] = 0;
+    mau16_Interval[u8_Report] = u16_Interval?u16_Interval:1;
+    mau16_PacketSize[u8_Report] = (uint16_t)(TemplateSize+u32_DataSize);
+    mau16_SequenceCount[u8_Report] = 0;
+
+    CCSDS::SpacePacket::createPrimaryHeader(maau8_Template[u8_Report], CCSDS::SpacePacket::TM, CCSDS::SpacePacket::Unsegmented,
+                                            u16_APID, 0, true, TemplateSize-SP_HEADER_SIZE+u32_DataSize);
+    Tm::createSecondaryHeader(&maau8_Template[u8_Report][SP_HEADER_SIZE], Tm::SecHdrSize,
+                              Tc::HousekeepingAndDiagnosticDataReportingService, HousekeepingReport);
+    maau8_Template[u8_Report][TemplateSize-SidSize] = u8_SID;
+
+    // compile the copy program
+    mau16_FirstOp[u8_Report] = mu16_OpCount;
+    pu8_End = nullptr;
+    for(uint16_t i=0; i<u16_ParameterCount; i++)
+    {
+      const uint8_t *pu8_Address = (const uint8_t*)pS_Parameters[i].p_Address;
+      if((pu8_Address==pu8_End) && (mu16_OpCount>mau16_FirstOp[u8_Report]) && (mau16_OpSize[mu16_OpCount-1]<=0xffff-pS_Parameters[i].u16_Size))
+      {
+        mau16_OpSize[mu16_OpCount-1] = (uint16_t)(mau16_OpSize[mu16_OpCount-1]+pS_Parameters[i].u16_Size);
+      }
+      else
+      {
+        mapu8_OpSource[mu16_OpCount] = pu8_Address;
+        mau16_OpSize[mu16_OpCount] = pS_Parameters[i].u16_Size;
+        mu16_OpCount++;
+      }
+      pu8_End = pu8_Address+pS_Parameters[i].u16_Size;
+    }
+    mau16_OpCount[u8_Report] = (uint16_t)(mu16_OpCount-mau16_FirstOp[u8_Report]);
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Deletes a report definition
+   *
+   * @param u8_SID    The structure ID of the report
+   *
+   * @retval  0   If the report was deleted
+   * @retval -1   If the report is not defined
+   */
+  int32_t Housekeeping::deleteReport(const uint8_t u8_SID)
+  {
+    uint8_t u8_Report = _findReport(u8_SID);
+    uint8_t u8_Last;
+    uint16_t u16_FirstOp;
+    uint16_t u16_OpCount;
+
+    if(u8_Report==NoReport)
+      return -1;
+
+    // remove the copy program from the pool
+    u16_FirstOp = mau16_FirstOp[u8_Report];
+    u16_OpCount = mau16_OpCount[u8_Report];
+    for(uint16_t i=u16_FirstOp; i+u16_OpCount<mu16_OpCount; i++)
+    {
+      mapu8_OpSource[i] = mapu8_OpSource[i+u16_OpCount];
+      mau16_OpSize[i] = mau16_OpSize[i+u16_OpCount];
+    }
+    mu16_OpCount = (uint16_t)(mu16_OpCount-u16_OpCount);
+    for(uint8_t i=0; i<mu8_ReportCount; i++)
+    {
+      if(mau16_FirstOp[i]>u16_FirstOp)
+        mau16_FirstOp[i] = (uint16_t)(mau16_FirstOp[i]-u16_OpCount);
+    }
+
+    // move the last report definition into the gap
+    u8_Last = (uint8_t)(mu8_ReportCount-1);
+    if(u8_Report!=u8_Last)
+    {
+      mau8_SID[u8_Report] = mau8_SID[u8_Last];
+      mab_Enabled[u8_Report] = mab_Enabled[u8_Last];
+      mab_Started[u8_Report] = mab_Started[u8_Last];
+      mau32_NextDue[u8_Report] = mau32_NextDue[u8_Last];
+      mau16_Interval[u8_Report] = mau16_Interval[u8_Last];
+      mau16_FirstOp[u8_Report] = mau16_FirstOp[u8_Last];
+      mau16_OpCount[u8_Report] = mau16_OpCount[u8_Last];
+      mau16_PacketSize[u8_Report] = mau16_PacketSize[u8_Last];
+      mau16_SequenceCount[u8_Report] = mau16_SequenceCount[u8_Last];
+      memcpy(maau8_Template[u8_Report], maau8_Template[u8_Last], TemplateSize);
+    }
+    mu8_ReportCount = u8_Last;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Enables or disables the generation of a report
+   *
+   * An enabled report is generated with the next call of generate().
+   *
+   * @param u8_SID      The structure ID of the report
+   * @param b_Enabled   true if the report shall be generated
+   *
+   * @retval  0   If the report was enabled or disabled
+   * @retval -1   If the report is not defined
+   */
+  int32_t Housekeeping::setReportEnabled(const uint8_t u8_SID, const bool b_Enabled)
+  {
+    uint8_t u8_Report = _findReport(u8_SID);
+
+    if(u8_Report==NoReport)
+      return -1;
+    if(b_Enabled && !mab_Enabled[u8_Report])
+      mab_Started[u8_Report] = false;
+    mab_Enabled[u8_Report] = b_Enabled;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Generates all reports which are due and writes them into the given buffer
+   *
+   * The report packets are written one after another. Reports which do not fit into the buffer stay
+   * due and are generated with the next call. Times are compared with wrap-around.
+   *
+   * @param u32_CurrentTime   The current onboard time
+   * @param pu8_Buffer        A pointer to the buffer where the report packets shall be stored
+   * @param u32_BufferSize    The available size of the buffer
+   *
+   * @return The number of bytes written into the buffer
+   */
+  uint32_t Housekeeping::generate(const uint32_t u32_CurrentTime, uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    uint32_t u32_Written = 0;
+
+    if(!pu8_Buffer)
+      return 0;
+
+    for(uint8_t r=0; r<mu8_ReportCount; r++)
+    {
+      uint8_t *pu8_Dst;
+      uint16_t u16_Op;
+      uint16_t u16_LastOp;
+
+      if(!mab_Enabled[r] || (mab_Started[r] && ((int32_t)(u32_CurrentTime-mau32_NextDue[r])<0)))
+        continue;
+      if(u32_Written+mau16_PacketSize[r]>u32_BufferSize)
+        continue;
+
+      pu8_Dst = &pu8_Buffer[u32_Written];
+      memcpy(pu8_Dst, maau8_Template[r], TemplateSize);
+      pu8_Dst[2] = (uint8_t)((pu8_Dst[2]&0xc0) | ((mau16_SequenceCount[r]>>8)&0x3f));
+      pu8_Dst[3] = (uint8_t)(mau16_SequenceCount[r]&0xff);
+      mau16_SequenceCount[r] = (uint16_t)((mau16_SequenceCount[r]+1)&0x3fff);
+
+      pu8_Dst += TemplateSize;
+      u16_LastOp = (uint16_t)(mau16_FirstOp[r]+mau16_OpCount[r]);
+      for(u16_Op=mau16_FirstOp[r]; u16_Op<u16_LastOp; u16_Op++)
+      {
+        memcpy(pu8_Dst, mapu8_OpSource[u16_Op], mau16_OpSize[u16_Op]);
+        pu8_Dst += mau16_OpSize[u16_Op];
+      }
+      u32_Written += mau16_PacketSize[r];
+
+      // keep the period without drift, but do not catch up on missed reports
+      if(!mab_Started[r] || ((uint32_t)(u32_CurrentTime-mau32_NextDue[r])>=mau16_Interval[r]))
+        mau32_NextDue[r] = u32_CurrentTime+mau16_Interval[r];
+      else
+        mau32_NextDue[r] += mau16_Interval[r];
+      mab_Started[r] = true;
+    }
+    return u32_Written;
+  }
+
+
+
+  /**
+   * @brief Handles a telecommand of service 3
+   *
+   * This method is called by the Tc object or a TcRegistry; the parameters are the ones of
+   * TcActionInterface::onTcReceived(). The application data of the subservices 5 and 6 is N, N times SID.
+   */
+  void Housekeeping::onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                                  const uint8_t u8_Service, const uint8_t u8_SubService,
+                                  const uint8_t u8_SourceID,
+                                  const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    (void)b_AckAcc; (void)b_AckStart; (void)b_AckProg; (void)b_AckComp; (void)u8_SourceID;
+
+    if((u8_Service!=Tc::HousekeepingAndDiagnosticDataReportingService) || !pu8_Data || (u32_DataSize<1))
+      return;
+    if((u8_SubService!=EnableReportGeneration) && (u8_SubService!=DisableReportGeneration))
+      return;
+
+    for(uint32_t i=1; (i<=pu8_Data[0]) && (i<u32_DataSize); i++)
+      setReportEnabled(pu8_Data[i], u8_SubService==EnableReportGeneration);
+  }
+
+
+
+  uint8_t Housekeeping::_findReport(const uint8_t u8_SID)
+  {
+    for(uint8_t i=0; i<mu8_ReportCount; i++)
+    {
+      if(mau8_SID[i]==u8_SID)
+        return i;
+    }
+    return NoReport;
+  }
+
+}
@@ -0,0 +1,132 @@
+/**
+ * @file      pus_housekeeping.h
+ *
+ * @brief     Include file of the PUS housekeeping class (service 3)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+
+#ifndef _PUS_HOUSEKEEPING_H_
+#define _PUS_HOUSEKEEPING_H_
+
+/****************************************************************/
+/* Housekeeping and Diagnostic Data Reporting Service           */
+/* according to                                                 */
+/*                                                              */
+/*  ECSS-E-70-41A - Ground systems and operations -             */
+/*                  Telemetry and telecommand packet            */
+/*                  utilization, service 3                      */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Only periodic housekeeping reports (3,25) are supported;  */
+/*    diagnostic reports and filtered mode are not supported    */
+/*  - Report definitions are created onboard with               */
+/*    defineReport(), not by telecommand                        */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "pus_tc.h"
+#include "pus_tm.h"
+
+#ifdef configPUS_HK_MAX_REPORTS
+#define PUS_HK_MAX_REPORTS configPUS_HK_MAX_REPORTS
+#else
+#define PUS_HK_MAX_REPORTS 32
+#endif
+
+#ifdef configPUS_HK_MAX_COPY_OPS
+#define PUS_HK_MAX_COPY_OPS configPUS_HK_MAX_COPY_OPS
+#else
+#define PUS_HK_MAX_COPY_OPS 256
+#endif
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Class for generating periodic housekeeping reports (PUS service 3).
+   *
+   * A report definition is a list of parameters, each given by its address in memory and its size. When a
+   * report is defined, the list is compiled into a copy program: parameters which are located next to each
+   * other in memory are merged into a single copy operation. The header of the report packet (space packet
+   * primary header, data field header and structure ID) is also prepared once as a template.
+   *
+   * generate() samples all reports which are due in one batch and writes the packets one after another
+   * into the given buffer; for each packet, only the template is copied, the sequence count is set and the
+   * copy program is executed.
+   *
+   * The class implements the TcActionInterface, so it can be registered at a TcRegistry for the
+   * subservices 5 (enable report generation) and 6 (disable report generation) of service 3.
+   */
+  class Housekeeping : public TcActionInterface
+  {
+  public:
+    /**
+     * @brief A parameter of a report definition
+     */
+    struct Parameter
+    {
+      const void *p_Address;    /**< Address of the parameter in memory */
+      uint16_t u16_Size;        /**< Size of the parameter in bytes */
+    };
+
+    enum SubService
+    {
+      EnableReportGeneration = 5,
+      DisableReportGeneration = 6,
+      HousekeepingReport = 25
+    };
+
+  private:
+    const static uint8_t NoReport = 0xff;
+    static_assert(PUS_HK_MAX_REPORTS<NoReport, "configPUS_HK_MAX_REPORTS must be below 255, the index 0xff marks an unknown report");
+    const static uint8_t SidSize = 1;
+    const static uint8_t TemplateSize = 6+PUS_TM_SEC_HEADER_SIZE+1;
+
+    // report definitions, stored as structure of arrays
+    uint8_t mu8_ReportCount;
+    uint8_t mau8_SID[PUS_HK_MAX_REPORTS];
+    bool mab_Enabled[PUS_HK_MAX_REPORTS];
+    bool mab_Started[PUS_HK_MAX_REPORTS];
+    uint32_t mau32_NextDue[PUS_HK_MAX_REPORTS];
+    uint16_t mau16_Interval[PUS_HK_MAX_REPORTS];
+    uint16_t mau16_FirstOp[PUS_HK_MAX_REPORTS];
+    uint16_t mau16_OpCount[PUS_HK_MAX_REPORTS];
+    uint16_t mau16_PacketSize[PUS_HK_MAX_REPORTS];
+    uint16_t mau16_SequenceCount[PUS_HK_MAX_REPORTS];
+    uint8_t maau8_Template[PUS_HK_MAX_REPORTS][TemplateSize];
+
+    // copy programs of all reports
+    uint16_t mu16_OpCount;
+    const uint8_t *mapu8_OpSource[PUS_HK_MAX_COPY_OPS];
+    uint16_t mau16_OpSize[PUS_HK_MAX_COPY_OPS];
+
+  public:
+    Housekeeping(void);
+
+    int32_t defineReport(const uint8_t u8_SID, const uint16_t u16_APID, const uint16_t u16_Interval,
+                         const Parameter *pS_Parameters, const uint16_t u16_ParameterCount);
+    int32_t deleteReport(const uint8_t u8_SID);
+    int32_t setReportEnabled(const uint8_t u8_SID, const bool b_Enabled);
+
+    uint32_t generate(const uint32_t u32_CurrentTime, uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+
+    void onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                      const uint8_t u8_Service, const uint8_t u8_SubService,
+                      const uint8_t u8_SourceID,
+                      const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+
+  private:
+    uint8_t _findReport(const uint8_t u8_SID);
+  };
+
+}
+
+#endif // _PUS_HOUSEKEEPING_H_
@@ -0,0 +1,662 @@
+/**
+ * @file      pus_large_data.cpp
+ *
+ * @brief     Source file of the PUS large data transfer class (service 13)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "pus_large_data.h"
+
+
+namespace PUS
+{
+
+  static inline bool isReceived(const uint8_t *pu8_Window, const uint16_t u16_Part)
+  {
+    uint16_t u16_Index = (uint16_t)(u16_Part%PUS_LDT_WINDOW_SIZE);
+    return (pu8_Window[u16_Index>>3]&(1<<(u16_Index&0x7)))?true:false;
+  }
+
+
+
+  static inline void setReceived(uint8_t *pu8_Window, const uint16_t u16_Part, const bool b_Received)
+  {
+    uint16_t u16_Index = (uint16_t)(u16_Part%PUS_LDT_WINDOW_SIZE);
+    if(b_Received)
+      pu8_Window[u16_Index>>3] |= (uint8_t)(1<<(u16_Index&0x7));
+    else
+      pu8_Window[u16_Index>>3] &= (uint8_t)~(1<<(u16_Index&0x7));
+  }
+
+
+
+  /**
+   * @brief Construct a new LargeDataTransfer object
+   *
+   * The pool is divided into PUS_LDT_MAX_TRANSACTIONS buffers of the same size; the size of a buffer is the
+   * maximum size of a received large data unit.
+   *
+   * @param u16_APID            The APID of the reports
+   * @param pu8_Pool            The memory for the uplink transactions, or nullptr if no uplink is needed
+   * @param u32_PoolSize        The size of the pool in bytes
+   * @param p_ActionInterface   A pointer to the implementation of the action interface for received large data units
+   */
+  LargeDataTransfer::LargeDataTransfer(const uint16_t u16_APID, uint8_t *pu8_Pool, const uint32_t u32_PoolSize,
+                                       LargeDataTransferActionInterface *p_ActionInterface)
+    : mu16_APID{u16_APID}
+    , mu16_SequenceCount{0}
+    , mu16_PartSize{SP_MAX_DATA_SIZE-PUS_TM_SEC_HEADER_SIZE-PartHdrSize}
+    , mu32_Timeout{60}
+    , mu32_Time{0}
+    , mpu8_Pool{pu8_Pool}
+    , mu32_SlotSize{pu8_Pool?(u32_PoolSize/PUS_LDT_MAX_TRANSACTIONS):0}
+    , mb_RejectPending{false}
+    , mu8_RejectID{0}
+    , mpu8_DownlinkData{nullptr}
+    , mu32_DownlinkSize{0}
+    , mu8_DownlinkID{0}
+    , mu8_DownlinkAbortReason{0}
+    , mu16_DownlinkParts{0}
+    , mu16_DownlinkNext{0}
+    , mu16_DownlinkAcked{0}
+    , mu32_DownlinkActivity{0}
+    , mu16_RepeatCount{0}
+    , mp_ActionInterface{p_ActionInterface}
+  {
+    memset(mau8_State, Free, sizeof(mau8_State));
+  }
+
+
+
+  /**
+   * @brief Sets the action class which is used to call the methods when a large data unit was received
+   *
+   * @param p_ActionInterface A pointer to the implementation of the action interface
+   */
+  void LargeDataTransfer::setActionInterface(LargeDataTransferActionInterface *p_ActionInterface)
+  {
+    mp_ActionInterface = p_ActionInterface;
+  }
+
+
+
+  /**
+   * @brief Sets the size of the data of the downlink parts
+   *
+   * The size shall be chosen so that a part report fills the data field of a transfer frame.
+   *
+   * @param u16_PartSize  The number of bytes of a large data unit which are sent in one part
+   *
+   * @retval  0   If the size was set
+   * @retval -1   If the size is invalid or a downlink is active
+   */
+  int32_t LargeDataTransfer::setPartSize(const uint16_t u16_PartSize)
+  {
+    if((u16_PartSize==0) || (u16_PartSize>0x10000UL-PUS_TM_SEC_HEADER_SIZE-PartHdrSize) || mpu8_DownlinkData)
+      return -1;
+    mu16_PartSize = u16_PartSize;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Sets the timeout of the transactions
+   *
+   * An uplink transaction is aborted if no part was received, a downlink if no acknowledgement was received
+   * for the given time.
+   *
+   * @param u32_Timeout   The timeout in the time unit of generate(); 0 disables the timeout
+   */
+  void LargeDataTransfer::setTimeout(const uint32_t u32_Timeout)
+  {
+    mu32_Timeout = u32_Timeout;
+  }
+
+
+
+  /**
+   * @brief Receives a part of an uplinked large data unit
+   *
+   * A new transaction is opened for an unknown large data unit ID. The data of the part is copied directly to
+   * its position in the transaction buffer. Parts which were already received are ignored.
+   *
+   * @param u8_SubService         The subservice of the part (9 to 12); a lost last part must be repeated with 11
+   * @param u8_LargeDataUnitID    The ID of the large data unit
+   * @param u16_SequenceNumber    The sequence number of the part, from 1 to 65534
+   * @param pu8_Data              The data of the part
+   * @param u32_DataSize          The size of the data
+   *
+   * @retval  0   If the part was stored or ignored
+   * @retval -1   If the parameters are invalid
+   * @retval -2   If no transaction is free or the large data unit does not fit into the transaction buffer
+   * @retval -3   If the part is outside of the reception window or cannot be placed yet; it is reported as missing
+   * @retval -4   If the size or sequence number of the part is inconsistent; the transaction is aborted
+   */
+  int32_t LargeDataTransfer::receivePart(const uint8_t u8_SubService, const uint8_t u8_LargeDataUnitID, const uint16_t u16_SequenceNumber,
+                                         const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    uint8_t u8_Transaction;
+    bool b_Last = (u8_SubService==LastUplinkPart);
+    uint32_t u32_Offset;
+
+    if((u8_SubService<FirstUplinkPart) || (u8_SubService>RepeatedUplinkPart) || (u16_SequenceNumber==0) || (u16_SequenceNumber==0xffff) || !pu8_Data)
+      return -1;
+
+    u8_Transaction = _findTransaction(u8_LargeDataUnitID);
+    if(u8_Transaction==NoTransaction)
+    {
+      for(uint8_t i=0; i<PUS_LDT_MAX_TRANSACTIONS; i++)
+      {
+        if((mau8_State[i]==Free) && (mu32_SlotSize>0))
+        {
+          u8_Transaction = i;
+          break;
+        }
+      }
+      if(u8_Transaction==NoTransaction)
+      {
+        mb_RejectPending = true;
+        mu8_RejectID = u8_LargeDataUnitID;
+        return -2;
+      }
+      mau8_State[u8_Transaction] = Receiving;
+      mau8_ID[u8_Transaction] = u8_LargeDataUnitID;
+      mau16_PartSize[u8_Transaction] = 0;
+      mau16_NextPart[u8_Transaction] = 1;
+      mau16_EndPart[u8_Transaction] = 1;
+      mau16_LastPart[u8_Transaction] = 0;
+      mau16_AckedPart[u8_Transaction] = 0;
+      mau32_Size[u8_Transaction] = 0;
+      mab_MissingPending[u8_Transaction] = false;
+      mau16_MissingFrom[u8_Transaction] = 0;
+      memset(maau8_Window[u8_Transaction], 0, sizeof(maau8_Window[u8_Transaction]));
+    }
+    if(mau8_State[u8_Transaction]!=Receiving)
+      return 0;
+    mau32_LastActivity[u8_Transaction] = mu32_Time;
+
+    // parts in front of the window were received already; parts behind the window are dropped
+    if(u16_SequenceNumber<mau16_NextPart[u8_Transaction])
+      return 0;
+    if((uint32_t)u16_SequenceNumber>=(uint32_t)mau16_NextPart[u8_Transaction]+PUS_LDT_WINDOW_SIZE)
+    {
+      // at least the first part of the window is missing
+      if(mau16_EndPart[u8_Transaction]==mau16_NextPart[u8_Transaction])
+        mau16_EndPart[u8_Transaction]++;
+      mab_MissingPending[u8_Transaction] = true;
+      return -3;
+    }
+    if(isReceived(maau8_Window[u8_Transaction], u16_SequenceNumber))
+      return 0;
+    if(mau16_LastPart[u8_Transaction] && (u16_SequenceNumber>mau16_LastPart[u8_Transaction]))
+    {
+      _abort(u8_Transaction, InvalidPart);
+      return -4;
+    }
+
+    // all parts except the last one have the same size, which gives the position of a part
+    if(!b_Last)
+    {
+      if(mau16_PartSize[u8_Transaction]==0)
+      {
+        if((u32_DataSize==0) || (u32_DataSize>0xffff))
+        {
+          _abort(u8_Transaction, InvalidPart);
+          return -4;
+        }
+        mau16_PartSize[u8_Transaction] = (uint16_t)u32_DataSize;
+      }
+      else if(u32_DataSize!=mau16_PartSize[u8_Transaction])
+      {
+        _abort(u8_Transaction, InvalidPart);
+        return -4;
+      }
+    }
+    else if(mau16_PartSize[u8_Transaction]==0)
+    {
+      if(u16_SequenceNumber>1)
+      {
+        mab_MissingPending[u8_Transaction] = true;
+        return -3;
+      }
+    }
+    else if(u32_DataSize>mau16_PartSize[u8_Transaction])
+    {
+      _abort(u8_Transaction, InvalidPart);
+      return -4;
+    }
+
+    u32_Offset = (uint32_t)(u16_SequenceNumber-1)*mau16_PartSize[u8_Transaction];
+    if((uint64_t)u32_Offset+u32_DataSize>mu32_SlotSize)
+    {
+      _abort(u8_Transaction, NoResources);
+      return -2;
+    }
+    memcpy(&mpu8_Pool[u8_Transaction*mu32_SlotSize+u32_Offset], pu8_Data, u32_DataSize);
+
+    setReceived(maau8_Window[u8_Transaction], u16_SequenceNumber, true);
+    if(b_Last)
+    {
+      mau16_LastPart[u8_Transaction] = u16_SequenceNumber;
+      mau32_Size[u8_Transaction] = u32_Offset+u32_DataSize;
+    }
+    if(u16_SequenceNumber>=mau16_EndPart[u8_Transaction])
+      mau16_EndPart[u8_Transaction] = (uint16_t)(u16_SequenceNumber+1);
+
+    // move the window behind the parts which were received without gap
+    while((mau16_NextPart[u8_Transaction]<mau16_EndPart[u8_Transaction]) && isReceived(maau8_Window[u8_Transaction], mau16_NextPart[u8_Transaction]))
+    {
+      setReceived(maau8_Window[u8_Transaction], mau16_NextPart[u8_Transaction], false);
+      mau16_NextPart[u8_Transaction]++;
+    }
+    if(mau16_NextPart[u8_Transaction]<mau16_EndPart[u8_Transaction])
+      mab_MissingPending[u8_Transaction] = true;
+
+    if(mau16_LastPart[u8_Transaction] && (mau16_NextPart[u8_Transaction]>mau16_LastPart[u8_Transaction]))
+    {
+      mau8_State[u8_Transaction] = Completed;
+      if(mp_ActionInterface)
+        mp_ActionInterface->onLargeDataReceived(u8_LargeDataUnitID, &mpu8_Pool[u8_Transaction*mu32_SlotSize], mau32_Size[u8_Transaction]);
+    }
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Aborts the reception of a large data unit; a reception abort report (13,16) is sent
+   *
+   * @param u8_LargeDataUnitID    The ID of the large data unit
+   *
+   * @retval  0   If the reception was aborted
+   * @retval -1   If the large data unit is not received
+   */
+  int32_t LargeDataTransfer::abortUplink(const uint8_t u8_LargeDataUnitID)
+  {
+    uint8_t u8_Transaction = _findTransaction(u8_LargeDataUnitID);
+
+    if((u8_Transaction==NoTransaction) || (mau8_State[u8_Transaction]!=Receiving))
+      return -1;
+    _abort(u8_Transaction, Aborted);
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Returns if a large data unit is being received
+   *
+   * @param u8_LargeDataUnitID    The ID of the large data unit
+   *
+   * @return true if the transaction of the large data unit is open
+   */
+  bool LargeDataTransfer::isReceiving(const uint8_t u8_LargeDataUnitID)
+  {
+    uint8_t u8_Transaction = _findTransaction(u8_LargeDataUnitID);
+
+    return (u8_Transaction!=NoTransaction) && (mau8_State[u8_Transaction]==Receiving);
+  }
+
+
+
+  /**
+   * @brief Starts the downlink of a large data unit
+   *
+   * The data is sent in parts by generate() and must not be changed until the downlink is finished.
+   *
+   * @param u8_LargeDataUnitID    The ID of the large data unit
+   * @param pu8_Data              The data of the large data unit
+   * @param u32_DataSize          The size of the data
+   *
+   * @retval  0   If the downlink was started
+   * @retval -1   If the parameters are invalid or the data needs more than 65534 parts
+   * @retval -2   If a downlink is active
+   */
+  int32_t LargeDataTransfer::startDownlink(const uint8_t u8_LargeDataUnitID, const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    uint32_t u32_Parts = (u32_DataSize+mu16_PartSize-1)/mu16_PartSize;
+
+    if(!pu8_Data || (u32_DataSize==0) || (u32_Parts>0xfffe))
+      return -1;
+    if(mpu8_DownlinkData)
+      return -2;
+
+    mpu8_DownlinkData = pu8_Data;
+    mu32_DownlinkSize = u32_DataSize;
+    mu8_DownlinkID = u8_LargeDataUnitID;
+    mu8_DownlinkAbortReason = 0;
+    mu16_DownlinkParts = (uint16_t)u32_Parts;
+    mu16_DownlinkNext = 1;
+    mu16_DownlinkAcked = 0;
+    mu32_DownlinkActivity = mu32_Time;
+    mu16_RepeatCount = 0;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Aborts the active downlink; a downlink abort report (13,8) is sent
+   */
+  void LargeDataTransfer::abortDownlink(void)
+  {
+    if(mpu8_DownlinkData && (mu8_DownlinkAbortReason==0))
+      mu8_DownlinkAbortReason = Aborted;
+  }
+
+
+
+  /**
+   * @brief Returns if a downlink is active
+   *
+   * @return true if not all parts of the downlink were acknowledged yet
+   */
+  bool LargeDataTransfer::isSending(void)
+  {
+    return mpu8_DownlinkData && (mu8_DownlinkAbortReason==0);
+  }
+
+
+
+  /**
+   * @brief Handles the timeouts and creates the pending reports
+   *
+   * The reports are written one after another into the given buffer: abort reports, acknowledgements and
+   * reports of missing parts of the uplinks, then the repeated and the next parts of the downlink. Reports
+   * which do not fit into the buffer are created with the next call.
+   *
+   * @param u32_CurrentTime   The current time in the unit of the timeout
+   * @param pu8_Buffer        The buffer for the report packets
+   * @param u32_BufferSize    The size of the buffer
+   *
+   * @return The number of bytes written into the buffer
+   */
+  uint32_t LargeDataTransfer::generate(const uint32_t u32_CurrentTime, uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    uint8_t au8_Data[2+2*MaxMissingParts];
+    uint32_t u32_Pos = 0;
+    uint32_t u32_Size;
+
+    mu32_Time = u32_CurrentTime;
+    if(!pu8_Buffer)
+      return 0;
+
+    // timeouts
+    for(uint8_t i=0; i<PUS_LDT_MAX_TRANSACTIONS; i++)
+    {
+      if((mau8_State[i]==Receiving) && mu32_Timeout && (u32_CurrentTime-mau32_LastActivity[i]>=mu32_Timeout))
+        _abort(i, Timeout);
+    }
+    if(isSending() && mu32_Timeout && (u32_CurrentTime-mu32_DownlinkActivity>=mu32_Timeout))
+      mu8_DownlinkAbortReason = Timeout;
+
+    // uplink reports
+    if(mb_RejectPending)
+    {
+      au8_Data[0] = mu8_RejectID;
+      au8_Data[1] = NoResources;
+      u32_Size = _createReport(&pu8_Buffer[u32_Pos], u32_BufferSize-u32_Pos, ReceptionAbortReport, au8_Data, 2);
+      if(u32_Size==0)
+        return u32_Pos;
+      u32_Pos += u32_Size;
+      mb_RejectPending = false;
+    }
+    for(uint8_t i=0; i<PUS_LDT_MAX_TRANSACTIONS; i++)
+    {
+      uint16_t u16_Received = (uint16_t)(mau16_NextPart[i]-1);
+
+      au8_Data[0] = mau8_ID[i];
+      if(mau8_State[i]==Aborting)
+      {
+        au8_Data[1] = mau8_AbortReason[i];
+        u32_Size = _createReport(&pu8_Buffer[u32_Pos], u32_BufferSize-u32_Pos, ReceptionAbortReport, au8_Data, 2);
+        if(u32_Size==0)
+          return u32_Pos;
+        u32_Pos += u32_Size;
+        mau8_State[i] = Free;
+      }
+      else if(mau8_State[i]==Completed)
+      {
+        au8_Data[1] = (uint8_t)(u16_Received>>8);
+        au8_Data[2] = (uint8_t)(u16_Received&0xff);
+        u32_Size = _createReport(&pu8_Buffer[u32_Pos], u32_BufferSize-u32_Pos, UplinkReceptionAck, au8_Data, 3);
+        if(u32_Size==0)
+          return u32_Pos;
+        u32_Pos += u32_Size;
+        mau8_State[i] = Free;
+      }
+      else if(mau8_State[i]==Receiving)
+      {
+        // the window is acknowledged each time it has moved by half of its size
+        if(u16_Received>=mau16_AckedPart[i]+(PUS_LDT_WINDOW_SIZE+1)/2)
+        {
+          au8_Data[1] = (uint8_t)(u16_Received>>8);
+          au8_Data[2] = (uint8_t)(u16_Received&0xff);
+          u32_Size = _createReport(&pu8_Buffer[u32_Pos], u32_BufferSize-u32_Pos, UplinkReceptionAck, au8_Data, 3);
+          if(u32_Size==0)
+            return u32_Pos;
+          u32_Pos += u32_Size;
+          mau16_AckedPart[i] = u16_Received;
+        }
+        if(mab_MissingPending[i])
+        {
+          uint16_t p = (mau16_MissingFrom[i]>mau16_NextPart[i])?mau16_MissingFrom[i]:mau16_NextPart[i];
+
+          // the list is split into reports which fit into a space packet
+          while(p<mau16_EndPart[i])
+          {
+            const uint16_t u16_First = p;
+            uint8_t u8_Count = 0;
+
+            for(; (p<mau16_EndPart[i]) && (u8_Count<MaxMissingParts); p++)
+            {
+              if(!isReceived(maau8_Window[i], p))
+              {
+                au8_Data[2+2*u8_Count] = (uint8_t)(p>>8);
+                au8_Data[3+2*u8_Count] = (uint8_t)(p&0xff);
+                u8_Count++;
+              }
+            }
+            if(u8_Count==0)
+              break;
+            au8_Data[1] = u8_Count;
+            u32_Size = _createReport(&pu8_Buffer[u32_Pos], u32_BufferSize-u32_Pos, UnsuccessfulPartsReport, au8_Data, (uint16_t)(2+2*u8_Count));
+            if(u32_Size==0)
+            {
+              mau16_MissingFrom[i] = u16_First;
+              return u32_Pos;
+            }
+            u32_Pos += u32_Size;
+          }
+          mau16_MissingFrom[i] = 0;
+          mab_MissingPending[i] = false;
+        }
+      }
+    }
+
+    // downlink reports
+    if(!mpu8_DownlinkData)
+      return u32_Pos;
+    if(mu8_DownlinkAbortReason)
+    {
+      au8_Data[0] = mu8_DownlinkID;
+      au8_Data[1] = mu8_DownlinkAbortReason;
+      u32_Size = _createReport(&pu8_Buffer[u32_Pos], u32_BufferSize-u32_Pos, DownlinkAbortReport, au8_Data, 2);
+      if(u32_Size==0)
+        return u32_Pos;
+      u32_Pos += u32_Size;
+      mpu8_DownlinkData = nullptr;
+      return u32_Pos;
+    }
+    for(uint16_t i=0; i<mu16_RepeatCount; i++)
+    {
+      u32_Size = _createPart(&pu8_Buffer[u32_Pos], u32_BufferSize-u32_Pos, RepeatedPart, mau16_Repeat[i]);
+      if(u32_Size==0)
+      {
+        memmove(mau16_Repeat, &mau16_Repeat[i], (mu16_RepeatCount-i)*sizeof(mau16_Repeat[0]));
+        mu16_RepeatCount = (uint16_t)(mu16_RepeatCount-i);
+        return u32_Pos;
+      }
+      u32_Pos += u32_Size;
+    }
+    mu16_RepeatCount = 0;
+    while((mu16_DownlinkNext<=mu16_DownlinkParts) && ((uint32_t)mu16_DownlinkNext<=(uint32_t)mu16_DownlinkAcked+PUS_LDT_WINDOW_SIZE))
+    {
+      uint8_t u8_SubService = IntermediateDownlinkPart;
+      if(mu16_DownlinkNext==mu16_DownlinkParts)
+        u8_SubService = LastDownlinkPart;
+      else if(mu16_DownlinkNext==1)
+        u8_SubService = FirstDownlinkPart;
+
+      u32_Size = _createPart(&pu8_Buffer[u32_Pos], u32_BufferSize-u32_Pos, u8_SubService, mu16_DownlinkNext);
+      if(u32_Size==0)
+        return u32_Pos;
+      u32_Pos += u32_Size;
+      mu16_DownlinkNext++;
+    }
+    return u32_Pos;
+  }
+
+
+
+  /**
+   * @brief Handles the telecommands of service 13
+   *
+   * This method is called by the Tc object or by a TcRegistry; the parameters are the ones of
+   * TcActionInterface::onTcReceived(). The application data starts with the large data unit ID (8 bit);
+   * the parts (9 to 12) and the downlink reception acknowledgement (4) continue with the sequence number
+   * (16 bit), the repeat parts request (5) with N (8 bit) and N sequence numbers.
+   *
+   * The data of a part is copied from the telecommand directly into the transaction buffer; if the
+   * telecommand was forwarded by a SpacePacket object, pu8_Data points into the received packet.
+   */
+  void LargeDataTransfer::onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                                       const uint8_t u8_Service, const uint8_t u8_SubService,
+                                       const uint8_t u8_SourceID,
+                                       const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    uint8_t u8_Transaction;
+    uint16_t u16_SequenceNumber;
+
+    (void)b_AckAcc; (void)b_AckStart; (void)b_AckProg; (void)b_AckComp; (void)u8_SourceID;
+
+    if((u8_Service!=Tc::LargeDataTransferService) || !pu8_Data || (u32_DataSize<1))
+      return;
+
+    switch(u8_SubService)
+    {
+    case FirstUplinkPart:
+    case IntermediateUplinkPart:
+    case LastUplinkPart:
+    case RepeatedUplinkPart:
+      if(u32_DataSize<PartHdrSize)
+        return;
+      receivePart(u8_SubService, pu8_Data[0], (uint16_t)((pu8_Data[1]<<8) | pu8_Data[2]),
+                  &pu8_Data[PartHdrSize], u32_DataSize-PartHdrSize);
+      return;
+
+    case AbortUplink:
+      u8_Transaction = _findTransaction(pu8_Data[0]);
+      if(u8_Transaction!=NoTransaction)
+        mau8_State[u8_Transaction] = Free;
+      return;
+
+    case DownlinkReceptionAck:
+      if(!isSending() || (pu8_Data[0]!=mu8_DownlinkID) || (u32_DataSize<PartHdrSize))
+        return;
+      u16_SequenceNumber = (uint16_t)((pu8_Data[1]<<8) | pu8_Data[2]);
+      if((u16_SequenceNumber>mu16_DownlinkAcked) && (u16_SequenceNumber<mu16_DownlinkNext))
+        mu16_DownlinkAcked = u16_SequenceNumber;
+      mu32_DownlinkActivity = mu32_Time;
+      if(mu16_DownlinkAcked>=mu16_DownlinkParts)
+        mpu8_DownlinkData = nullptr;
+      return;
+
+    case RepeatParts:
+      if(!isSending() || (pu8_Data[0]!=mu8_DownlinkID) || (u32_DataSize<2))
+        return;
+      for(uint32_t i=0; (i<pu8_Data[1]) && (3+2*i<u32_DataSize) && (mu16_RepeatCount<PUS_LDT_WINDOW_SIZE); i++)
+      {
+        u16_SequenceNumber = (uint16_t)((pu8_Data[2+2*i]<<8) | pu8_Data[3+2*i]);
+        if((u16_SequenceNumber>0) && (u16_SequenceNumber<mu16_DownlinkNext))
+          mau16_Repeat[mu16_RepeatCount++] = u16_SequenceNumber;
+      }
+      mu32_DownlinkActivity = mu32_Time;
+      return;
+
+    case AbortDownlink:
+      if(mpu8_DownlinkData && (pu8_Data[0]==mu8_DownlinkID))
+        mpu8_DownlinkData = nullptr;
+      return;
+
+    default:
+      return;
+    }
+  }
+
+
+
+  uint8_t LargeDataTransfer::_findTransaction(const uint8_t u8_LargeDataUnitID)
+  {
+    for(uint8_t i=0; i<PUS_LDT_MAX_TRANSACTIONS; i++)
+    {
+      if((mau8_State[i]!=Free) && (mau8_ID[i]==u8_LargeDataUnitID))
+        return i;
+    }
+    return NoTransaction;
+  }
+
+
+
+  void LargeDataTransfer::_abort(const uint8_t u8_Transaction, const enum AbortReason e_Reason)
+  {
+    mau8_State[u8_Transaction] = Aborting;
+    mau8_AbortReason[u8_Transaction] = (uint8_t)e_Reason;
+  }
+
+
+
+  uint32_t LargeDataTransfer::_createReport(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint8_t u8_SubService,
+                                            const uint8_t *pu8_Data, const uint16_t u16_DataSize)
+  {
+    uint32_t u32_Size = Tm::createPacket(pu8_Buffer, u32_BufferSize, mu16_APID, mu16_SequenceCount,
+                                         Tc::LargeDataTransferService, u8_SubService, pu8_Data, u16_DataSize);
+    if(u32_Size>0)
+      mu16_SequenceCount = (uint16_t)((mu16_SequenceCount+1)&0x3fff);
+    return u32_Size;
+  }
+
+
+
+  uint32_t LargeDataTransfer::_createPart(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint8_t u8_SubService,
+                                          const uint16_t u16_SequenceNumber)
+  {
+    uint32_t u32_Offset = (uint32_t)(u16_SequenceNumber-1)*mu16_PartSize;
+    uint32_t u32_Length = mu32_DownlinkSize-u32_Offset;
+    uint8_t *pu8_Dst;
+
+    if(u32_Length>mu16_PartSize)
+      u32_Length = mu16_PartSize;
+    if(u32_BufferSize<SP_HEADER_SIZE+Tm::SecHdrSize+PartHdrSize+u32_Length)
+      return 0;
+
+    CCSDS::SpacePacket::createPrimaryHeader(pu8_Buffer, CCSDS::SpacePacket::TM, CCSDS::SpacePacket::Unsegmented,
+                                            mu16_APID, mu16_SequenceCount, true, Tm::SecHdrSize+PartHdrSize+u32_Length);
+    mu16_SequenceCount = (uint16_t)((mu16_SequenceCount+1)&0x3fff);
+    Tm::createSecondaryHeader(&pu8_Buffer[SP_HEADER_SIZE], Tm::SecHdrSize, Tc::LargeDataTransferService, u8_SubService);
+    pu8_Dst = &pu8_Buffer[SP_HEADER_SIZE+Tm::SecHdrSize];
+    pu8_Dst[0] = mu8_DownlinkID;
+    pu8_Dst[1] = (uint8_t)(u16_SequenceNumber>>8);
+    pu8_Dst[2] = (uint8_t)(u16_SequenceNumber&0xff);
+    memcpy(&pu8_Dst[PartHdrSize], &mpu8_DownlinkData[u32_Offset], u32_Length);
+
+    return SP_HEADER_SIZE+Tm::SecHdrSize+PartHdrSize+u32_Length;
+  }
+
+}
@@ -0,0 +1,219 @@
+/**
+ * @file      pus_large_data.h
+ *
+ * @brief     Include file of the PUS large data transfer class (service 13)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+
+#ifndef _PUS_LARGE_DATA_H_
+#define _PUS_LARGE_DATA_H_
+
+/****************************************************************/
+/* Large Data Transfer Service according to                     */
+/*                                                              */
+/*  ECSS-E-70-41A - Ground systems and operations -             */
+/*                  Telemetry and telecommand packet            */
+/*                  utilization, service 13                     */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - All parts of a large data unit except the last one must   */
+/*    have the same size                                        */
+/*  - Only one downlink can be active at a time                 */
+/*  - The reception acknowledgements are sent for windows of    */
+/*    parts instead of single parts                             */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "ccsds_spacepacket.h"
+#include "pus_tc.h"
+#include "pus_tm.h"
+
+#ifdef configPUS_LDT_MAX_TRANSACTIONS
+#define PUS_LDT_MAX_TRANSACTIONS configPUS_LDT_MAX_TRANSACTIONS
+#else
+#define PUS_LDT_MAX_TRANSACTIONS 4
+#endif
+
+#ifdef configPUS_LDT_WINDOW_SIZE
+#define PUS_LDT_WINDOW_SIZE configPUS_LDT_WINDOW_SIZE
+#else
+#define PUS_LDT_WINDOW_SIZE 64
+#endif
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Interface class for handling received large data units
+   */
+  class LargeDataTransferActionInterface
+  {
+  public:
+    /**
+     * @brief Declaration of the action which shall be called if a large data unit was received completely
+     *
+     * The data is located in the pool buffer of the transaction, which is released after the call. The
+     * implementation has to copy or apply the data within the call.
+     *
+     * @param u8_LargeDataUnitID    The ID of the large data unit
+     * @param pu8_Data              The received data
+     * @param u32_DataSize          The size of the data in bytes
+     */
+    virtual void onLargeDataReceived(const uint8_t u8_LargeDataUnitID, const uint8_t *pu8_Data, const uint32_t u32_DataSize) = 0;
+  };
+
+
+
+  /**
+   * @brief Class for the transfer of large data units in parts (PUS service 13).
+   *
+   * Uplink: the pool which is given to the constructor is divided into PUS_LDT_MAX_TRANSACTIONS buffers of the
+   * same size. A transaction is opened with the first received part of an unknown large data unit ID. Each part
+   * is copied directly from the received telecommand into its position in the transaction buffer, so parts can
+   * be received in any order within a sliding window of PUS_LDT_WINDOW_SIZE parts following the first missing
+   * part. Instead of acknowledging every part, an uplink reception acknowledgement (13,14) is sent each time the
+   * window has moved by half of its size, and missing parts are reported with unsuccessfully received parts
+   * reports (13,15), so ground can send the next parts while waiting for the acknowledgements. A list of missing
+   * parts which does not fit into one space packet is split into several reports. After the last part,
+   * the large data unit is handed over to the LargeDataTransferActionInterface. Transactions which receive no part
+   * for the timeout are aborted with a reception abort report (13,16).
+   *
+   * Downlink: a large data unit given to startDownlink() is sent in first, intermediate and last part reports
+   * (13,1 to 13,3), at most PUS_LDT_WINDOW_SIZE parts ahead of the part which was acknowledged by ground (13,4).
+   * Parts requested by ground (13,5) are sent again as repeated part reports (13,6).
+   *
+   * The reports are written into the buffer given to generate(), which also handles the timeouts. The class
+   * implements the TcActionInterface, so it can be registered at a TcRegistry for the telecommands of service 13.
+   */
+  class LargeDataTransfer : public TcActionInterface
+  {
+  public:
+    const static uint8_t MaxTransactions = PUS_LDT_MAX_TRANSACTIONS;
+    const static uint16_t WindowSize = PUS_LDT_WINDOW_SIZE;
+
+    enum SubService
+    {
+      FirstDownlinkPart = 1,
+      IntermediateDownlinkPart = 2,
+      LastDownlinkPart = 3,
+      DownlinkReceptionAck = 4,
+      RepeatParts = 5,
+      RepeatedPart = 6,
+      AbortDownlink = 7,
+      DownlinkAbortReport = 8,
+      FirstUplinkPart = 9,
+      IntermediateUplinkPart = 10,
+      LastUplinkPart = 11,
+      RepeatedUplinkPart = 12,
+      AbortUplink = 13,
+      UplinkReceptionAck = 14,
+      UnsuccessfulPartsReport = 15,
+      ReceptionAbortReport = 16
+    };
+
+    /** The reasons of the abort reports (13,8) and (13,16) */
+    enum AbortReason
+    {
+      Timeout = 1,            /**< No part (uplink) or acknowledgement (downlink) was received in time */
+      NoResources = 2,        /**< No free transaction or the data does not fit into the transaction buffer */
+      InvalidPart = 3,        /**< A part has a wrong size or sequence number */
+      Aborted = 4             /**< The transfer was aborted onboard */
+    };
+
+  private:
+    const static uint8_t PartHdrSize = 3;           // large data unit ID, sequence number
+    const static uint8_t NoTransaction = 0xff;
+    // missing parts per report (13,15): large data unit ID, count and 16 bit sequence numbers in one space packet
+    const static uint8_t MaxMissingParts = ((SP_MAX_DATA_SIZE-PUS_TM_SEC_HEADER_SIZE-2)/2<255)?(SP_MAX_DATA_SIZE-PUS_TM_SEC_HEADER_SIZE-2)/2:255;
+
+    enum State
+    {
+      Free = 0,
+      Receiving = 1,
+      Completed = 2,          // the final acknowledgement is pending
+      Aborting = 3            // the abort report is pending
+    };
+
+    uint16_t mu16_APID;
+    uint16_t mu16_SequenceCount;
+    uint16_t mu16_PartSize;
+    uint32_t mu32_Timeout;
+    uint32_t mu32_Time;
+
+    // uplink transactions, stored as structure of arrays
+    uint8_t *mpu8_Pool;
+    uint32_t mu32_SlotSize;
+    uint8_t mau8_State[PUS_LDT_MAX_TRANSACTIONS];
+    uint8_t mau8_ID[PUS_LDT_MAX_TRANSACTIONS];
+    uint8_t mau8_AbortReason[PUS_LDT_MAX_TRANSACTIONS];
+    uint16_t mau16_PartSize[PUS_LDT_MAX_TRANSACTIONS];
+    uint16_t mau16_NextPart[PUS_LDT_MAX_TRANSACTIONS];       // first missing part
+    uint16_t mau16_EndPart[PUS_LDT_MAX_TRANSACTIONS];        // end of the range which is checked for missing parts
+    uint16_t mau16_LastPart[PUS_LDT_MAX_TRANSACTIONS];       // 0 until the last part was received
+    uint16_t mau16_AckedPart[PUS_LDT_MAX_TRANSACTIONS];
+    uint32_t mau32_Size[PUS_LDT_MAX_TRANSACTIONS];
+    uint32_t mau32_LastActivity[PUS_LDT_MAX_TRANSACTIONS];
+    bool mab_MissingPending[PUS_LDT_MAX_TRANSACTIONS];
+    uint16_t mau16_MissingFrom[PUS_LDT_MAX_TRANSACTIONS];    // first part of the next report (13,15) if the list was split
+    uint8_t maau8_Window[PUS_LDT_MAX_TRANSACTIONS][(PUS_LDT_WINDOW_SIZE+7)/8];   // received flags, indexed by part modulo window size
+    bool mb_RejectPending;
+    uint8_t mu8_RejectID;
+
+    // downlink
+    const uint8_t *mpu8_DownlinkData;
+    uint32_t mu32_DownlinkSize;
+    uint8_t mu8_DownlinkID;
+    uint8_t mu8_DownlinkAbortReason;
+    uint16_t mu16_DownlinkParts;
+    uint16_t mu16_DownlinkNext;
+    uint16_t mu16_DownlinkAcked;
+    uint32_t mu32_DownlinkActivity;
+    uint16_t mu16_RepeatCount;
+    uint16_t mau16_Repeat[PUS_LDT_WINDOW_SIZE];
+
+    LargeDataTransferActionInterface *mp_ActionInterface;
+
+  public:
+    LargeDataTransfer(const uint16_t u16_APID, uint8_t *pu8_Pool, const uint32_t u32_PoolSize,
+                      LargeDataTransferActionInterface *p_ActionInterface = nullptr);
+
+    void setActionInterface(LargeDataTransferActionInterface *p_ActionInterface);
+    int32_t setPartSize(const uint16_t u16_PartSize);
+    void setTimeout(const uint32_t u32_Timeout);
+
+    int32_t receivePart(const uint8_t u8_SubService, const uint8_t u8_LargeDataUnitID, const uint16_t u16_SequenceNumber,
+                        const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+    int32_t abortUplink(const uint8_t u8_LargeDataUnitID);
+    bool isReceiving(const uint8_t u8_LargeDataUnitID);
+
+    int32_t startDownlink(const uint8_t u8_LargeDataUnitID, const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+    void abortDownlink(void);
+    bool isSending(void);
+
+    uint32_t generate(const uint32_t u32_CurrentTime, uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+
+    void onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                      const uint8_t u8_Service, const uint8_t u8_SubService,
+                      const uint8_t u8_SourceID,
+                      const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+
+  private:
+    uint8_t _findTransaction(const uint8_t u8_LargeDataUnitID);
+    void _abort(const uint8_t u8_Transaction, const enum AbortReason e_Reason);
+    uint32_t _createReport(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint8_t u8_SubService,
+                           const uint8_t *pu8_Data, const uint16_t u16_DataSize);
+    uint32_t _createPart(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint8_t u8_SubService,
+                         const uint16_t u16_SequenceNumber);
+  };
+
+}
+
+#endif // _PUS_LARGE_DATA_H_
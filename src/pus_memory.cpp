@@ -0,0 +1,517 @@
+/**
+ * @file      pus_memory.cpp
+ *
+ * @brief     Source file of the PUS memory management class (service 6)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "pus_memory.h"
+#include "ccsds_transferframe.h"
+
+
+namespace PUS
+{
+
+  static inline uint32_t getUint32(const uint8_t *pu8_Buffer)
+  {
+    return ((uint32_t)pu8_Buffer[0]<<24) | ((uint32_t)pu8_Buffer[1]<<16) | ((uint32_t)pu8_Buffer[2]<<8) | (uint32_t)pu8_Buffer[3];
+  }
+
+
+
+  static inline void putUint32(uint8_t *pu8_Buffer, const uint32_t u32_Value)
+  {
+    pu8_Buffer[0] = (uint8_t)(u32_Value>>24);
+    pu8_Buffer[1] = (uint8_t)(u32_Value>>16);
+    pu8_Buffer[2] = (uint8_t)(u32_Value>>8);
+    pu8_Buffer[3] = (uint8_t)u32_Value;
+  }
+
+
+
+  /**
+   * @brief Construct a new MemoryManagement object without memory regions
+   *
+   * @param u16_APID    The APID of the dump and check reports
+   */
+  MemoryManagement::MemoryManagement(const uint16_t u16_APID)
+    : mu16_APID{u16_APID}
+    , mu16_SequenceCount{0}
+    , mu16_PacketSize{SP_HEADER_SIZE+SP_MAX_DATA_SIZE}
+    , mu8_RegionCount{0}
+    , mpu8_DumpSource{nullptr}
+    , mu8_DumpMemoryID{0}
+    , mu32_DumpAddress{0}
+    , mu32_DumpRemaining{0}
+    , mu32_DumpRequestID{0}
+    , mb_DumpVerification{false}
+    , mb_DumpAckComp{false}
+    , mb_CheckPending{false}
+    , mu8_CheckMemoryID{0}
+    , mu32_CheckAddress{0}
+    , mu32_CheckLength{0}
+    , mu16_CheckCRC{0}
+    , mu16_AddressErrorCount{0}
+    , mu16_ChecksumErrorCount{0}
+    , mp_Verification{nullptr}
+  {
+  }
+
+
+
+  /**
+   * @brief Defines a memory region which can be accessed by ground
+   *
+   * Regions of the same memory ID must not overlap.
+   *
+   * @param u8_MemoryID       The memory ID which is used in the telecommands and reports
+   * @param u32_StartAddress  The address of the first byte of the region as seen by ground
+   * @param p_Memory          The buffer in the onboard memory which holds the region
+   * @param u32_Size          The size of the region in bytes
+   * @param b_Writable        true if the region can be loaded; otherwise it can only be dumped and checked
+   *
+   * @retval  0   If the region was defined
+   * @retval -1   If the parameters are invalid
+   * @retval -2   If the maximum number of regions is reached
+   */
+  int32_t MemoryManagement::defineRegion(const uint8_t u8_MemoryID, const uint32_t u32_StartAddress,
+                                         void *p_Memory, const uint32_t u32_Size, const bool b_Writable)
+  {
+    if(!p_Memory || (u32_Size==0) || ((uint64_t)u32_StartAddress+u32_Size>0x100000000ULL))
+      return -1;
+    if(mu8_RegionCount>=PUS_MEM_MAX_REGIONS)
+      return -2;
+
+    mau8_MemoryID[mu8_RegionCount] = u8_MemoryID;
+    mau32_StartAddress[mu8_RegionCount] = u32_StartAddress;
+    mau32_Size[mu8_RegionCount] = u32_Size;
+    mapu8_Memory[mu8_RegionCount] = (uint8_t*)p_Memory;
+    mab_Writable[mu8_RegionCount] = b_Writable;
+    mu8_RegionCount++;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Removes all memory regions; a running dump and a pending check report are discarded
+   */
+  void MemoryManagement::clearRegions(void)
+  {
+    mu8_RegionCount = 0;
+    mb_CheckPending = false;
+    abortDump();
+  }
+
+
+
+  /**
+   * @brief Sets the maximum size of the created report packets
+   *
+   * The size shall be the data size of the transfer frames, so each dump report fills a frame.
+   *
+   * @param u16_PacketSize  The maximum size of a report packet including the primary header
+   *
+   * @retval  0   If the size was set
+   * @retval -1   If the size is too small for a dump report with at least one byte
+   */
+  int32_t MemoryManagement::setPacketSize(const uint16_t u16_PacketSize)
+  {
+    if(u16_PacketSize<MinPacketSize)
+      return -1;
+    mu16_PacketSize = u16_PacketSize;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Sets the verification service which sends the completion reports of the telecommands
+   *
+   * @param p_Verification  A pointer to the verification service, or nullptr
+   */
+  void MemoryManagement::setVerification(Verification *p_Verification)
+  {
+    mp_Verification = p_Verification;
+  }
+
+
+
+  /**
+   * @brief Loads a memory block
+   *
+   * The data is only written if its checksum is correct. After writing, the checksum of the memory is
+   * calculated again to verify the load.
+   *
+   * @param u8_MemoryID       The memory ID
+   * @param u32_StartAddress  The address of the first byte
+   * @param pu8_Data          The data to load
+   * @param u32_Length        The number of bytes to load
+   * @param u16_Checksum      The checksum (CRC-16) of the data
+   *
+   * @retval  0   If the data was loaded
+   * @retval -1   If the block is not located within one writable region
+   * @retval -2   If the checksum of the data is wrong
+   * @retval -3   If the memory does not contain the data after writing
+   */
+  int32_t MemoryManagement::load(const uint8_t u8_MemoryID, const uint32_t u32_StartAddress,
+                                 const uint8_t *pu8_Data, const uint32_t u32_Length, const uint16_t u16_Checksum)
+  {
+    uint8_t *pu8_Memory = _translate(u8_MemoryID, u32_StartAddress, u32_Length, true);
+
+    if(!pu8_Memory || !pu8_Data)
+      return -1;
+    if(CCSDS::Transferframe::calcCRC(pu8_Data, u32_Length)!=u16_Checksum)
+    {
+      if(mu16_ChecksumErrorCount<0xffff)
+        mu16_ChecksumErrorCount++;
+      return -2;
+    }
+
+    memcpy(pu8_Memory, pu8_Data, u32_Length);
+    if(CCSDS::Transferframe::calcCRC(pu8_Memory, u32_Length)!=u16_Checksum)
+      return -3;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Starts a memory dump
+   *
+   * The dump reports are created by generate().
+   *
+   * @param u8_MemoryID       The memory ID
+   * @param u32_StartAddress  The address of the first byte
+   * @param u32_Length        The number of bytes to dump
+   *
+   * @retval  0   If the dump was started
+   * @retval -1   If the block is not located within one region
+   * @retval -2   If a dump is running
+   */
+  int32_t MemoryManagement::startDump(const uint8_t u8_MemoryID, const uint32_t u32_StartAddress, const uint32_t u32_Length)
+  {
+    const uint8_t *pu8_Memory;
+
+    if(isDumping())
+      return -2;
+    pu8_Memory = _translate(u8_MemoryID, u32_StartAddress, u32_Length, false);
+    if(!pu8_Memory)
+      return -1;
+
+    mpu8_DumpSource = pu8_Memory;
+    mb_DumpVerification = false;
+    mu8_DumpMemoryID = u8_MemoryID;
+    mu32_DumpAddress = u32_StartAddress;
+    mu32_DumpRemaining = u32_Length;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Stops a running memory dump
+   *
+   * If the dump was requested by a telecommand, a completion failure report (1,8) is sent.
+   */
+  void MemoryManagement::abortDump(void)
+  {
+    if(mb_DumpVerification && isDumping() && mp_Verification)
+      mp_Verification->completionFailure(mu32_DumpRequestID, DumpAborted);
+    mb_DumpVerification = false;
+    mpu8_DumpSource = nullptr;
+    mu32_DumpRemaining = 0;
+  }
+
+
+
+  /**
+   * @brief Returns if a memory dump is running
+   *
+   * @return true if not all dump reports were created yet
+   */
+  bool MemoryManagement::isDumping(void)
+  {
+    return mu32_DumpRemaining>0;
+  }
+
+
+
+  /**
+   * @brief Calculates the checksum of a memory block
+   *
+   * @param u8_MemoryID       The memory ID
+   * @param u32_StartAddress  The address of the first byte
+   * @param u32_Length        The number of bytes to check
+   * @param pu16_Checksum     The checksum (CRC-16) of the block is written here
+   *
+   * @retval  0   If the checksum was calculated
+   * @retval -1   If the block is not located within one region or pu16_Checksum is nullptr
+   */
+  int32_t MemoryManagement::check(const uint8_t u8_MemoryID, const uint32_t u32_StartAddress, const uint32_t u32_Length,
+                                  uint16_t *pu16_Checksum)
+  {
+    const uint8_t *pu8_Memory = _translate(u8_MemoryID, u32_StartAddress, u32_Length, false);
+
+    if(!pu8_Memory || !pu16_Checksum)
+      return -1;
+    *pu16_Checksum = CCSDS::Transferframe::calcCRC(pu8_Memory, u32_Length);
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Creates the pending memory check report and the next dump reports
+   *
+   * The packets are written one after another into the given buffer. The dump reports are split at the
+   * packet size; a report which does not fit into the remaining buffer is created with the next call.
+   * When the last report of a dump which was requested by a telecommand was created, the completion
+   * success report (1,7) is sent if it was requested.
+   *
+   * @param pu8_Buffer      The buffer for the report packets
+   * @param u32_BufferSize  The size of the buffer
+   *
+   * @return The number of bytes written into the buffer
+   */
+  uint32_t MemoryManagement::generate(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    const uint32_t u32_HdrSize = SP_HEADER_SIZE+Tm::SecHdrSize;
+    const uint32_t u32_MaxChunk = mu16_PacketSize-u32_HdrSize-BlockHdrSize-CrcSize;
+    uint8_t *pu8_Dst = pu8_Buffer;
+    uint32_t u32_Free = u32_BufferSize;
+
+    if(!pu8_Buffer)
+      return 0;
+
+    if(mb_CheckPending && (u32_Free>=u32_HdrSize+RequestSize+CrcSize))
+    {
+      CCSDS::SpacePacket::createPrimaryHeader(pu8_Dst, CCSDS::SpacePacket::TM, CCSDS::SpacePacket::Unsegmented,
+                                              mu16_APID, mu16_SequenceCount, true, Tm::SecHdrSize+RequestSize+CrcSize);
+      mu16_SequenceCount = (uint16_t)((mu16_SequenceCount+1)&0x3fff);
+      Tm::createSecondaryHeader(&pu8_Dst[SP_HEADER_SIZE], Tm::SecHdrSize, Tc::MemoryManagementService, MemoryCheckReport);
+      pu8_Dst += u32_HdrSize;
+      pu8_Dst[0] = mu8_CheckMemoryID;
+      putUint32(&pu8_Dst[1], mu32_CheckAddress);
+      putUint32(&pu8_Dst[5], mu32_CheckLength);
+      pu8_Dst[RequestSize] = (uint8_t)(mu16_CheckCRC>>8);
+      pu8_Dst[RequestSize+1] = (uint8_t)(mu16_CheckCRC&0xff);
+      pu8_Dst += RequestSize+CrcSize;
+      u32_Free -= u32_HdrSize+RequestSize+CrcSize;
+      mb_CheckPending = false;
+    }
+
+    while(mu32_DumpRemaining>0)
+    {
+      uint32_t u32_Chunk = (mu32_DumpRemaining<u32_MaxChunk)?mu32_DumpRemaining:u32_MaxChunk;
+      uint16_t u16_CRC;
+      uint8_t *pu8_Data;
+
+      if(u32_Free<u32_HdrSize+BlockHdrSize+u32_Chunk+CrcSize)
+        break;
+
+      CCSDS::SpacePacket::createPrimaryHeader(pu8_Dst, CCSDS::SpacePacket::TM, CCSDS::SpacePacket::Unsegmented,
+                                              mu16_APID, mu16_SequenceCount, true,
+                                              Tm::SecHdrSize+BlockHdrSize+u32_Chunk+CrcSize);
+      mu16_SequenceCount = (uint16_t)((mu16_SequenceCount+1)&0x3fff);
+      Tm::createSecondaryHeader(&pu8_Dst[SP_HEADER_SIZE], Tm::SecHdrSize, Tc::MemoryManagementService, MemoryDumpReport);
+      pu8_Dst += u32_HdrSize;
+      pu8_Dst[0] = mu8_DumpMemoryID;
+      putUint32(&pu8_Dst[1], mu32_DumpAddress);
+      pu8_Dst[5] = (uint8_t)(u32_Chunk>>8);
+      pu8_Dst[6] = (uint8_t)(u32_Chunk&0xff);
+
+      // the checksum is calculated over the copy, which is still in the cache
+      pu8_Data = &pu8_Dst[BlockHdrSize];
+      memcpy(pu8_Data, mpu8_DumpSource, u32_Chunk);
+      u16_CRC = CCSDS::Transferframe::calcCRC(pu8_Data, u32_Chunk);
+      pu8_Data[u32_Chunk] = (uint8_t)(u16_CRC>>8);
+      pu8_Data[u32_Chunk+1] = (uint8_t)(u16_CRC&0xff);
+
+      pu8_Dst += BlockHdrSize+u32_Chunk+CrcSize;
+      u32_Free -= u32_HdrSize+BlockHdrSize+u32_Chunk+CrcSize;
+      mpu8_DumpSource += u32_Chunk;
+      mu32_DumpAddress += u32_Chunk;
+      mu32_DumpRemaining -= u32_Chunk;
+    }
+    if(mu32_DumpRemaining==0)
+    {
+      mpu8_DumpSource = nullptr;
+
+      // the dump is completed when its last report was created
+      if(mb_DumpVerification)
+      {
+        mb_DumpVerification = false;
+        if(mb_DumpAckComp && mp_Verification)
+          mp_Verification->completionSuccess(mu32_DumpRequestID);
+      }
+    }
+
+    return (uint32_t)(pu8_Dst-pu8_Buffer);
+  }
+
+
+
+  /**
+   * @brief Handles the telecommands of service 6
+   *
+   * This method is called by the Tc object or by a TcRegistry; the parameters are the ones of
+   * TcActionInterface::onTcReceived(). The application data is the memory ID (8 bit) and the start address
+   * (32 bit), followed by the length (16 bit), the data and the checksum for subservice 2, or by the length
+   * (32 bit) for the subservices 5 and 9.
+   */
+  void MemoryManagement::onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                                      const uint8_t u8_Service, const uint8_t u8_SubService,
+                                      const uint8_t u8_SourceID,
+                                      const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    int32_t i32_FailureCode;
+
+    (void)b_AckAcc; (void)b_AckStart; (void)b_AckProg; (void)u8_SourceID;
+
+    if(u8_Service!=Tc::MemoryManagementService)
+      return;
+
+    i32_FailureCode = _execute(u8_SubService, pu8_Data, u32_DataSize);
+    if(!mp_Verification)
+      return;
+
+    if(i32_FailureCode)
+    {
+      mp_Verification->completionFailure(mp_Verification->getRequestID(), (uint8_t)i32_FailureCode);
+    }
+    else if(u8_SubService==DumpMemory)
+    {
+      // the completion of a dump is reported by generate()
+      mu32_DumpRequestID = mp_Verification->getRequestID();
+      mb_DumpAckComp = b_AckComp;
+      mb_DumpVerification = true;
+    }
+    else if(b_AckComp)
+    {
+      mp_Verification->completionSuccess(mp_Verification->getRequestID());
+    }
+  }
+
+
+
+  /**
+   * @brief Returns the number of accesses outside of the defined regions
+   *
+   * If the number of errors exceeds 65535, the method returns 65535.
+   *
+   * @return Number of address errors as uint16_t
+   */
+  uint16_t MemoryManagement::getAddressErrorCount(void)
+  {
+    return mu16_AddressErrorCount;
+  }
+
+
+
+  /**
+   * @brief Returns the number of loads with a wrong checksum
+   *
+   * If the number of errors exceeds 65535, the method returns 65535.
+   *
+   * @return Number of checksum errors as uint16_t
+   */
+  uint16_t MemoryManagement::getChecksumErrorCount(void)
+  {
+    return mu16_ChecksumErrorCount;
+  }
+
+
+
+  /**
+   * @brief Clears all error counters
+   */
+  void MemoryManagement::clearErrorCounters(void)
+  {
+    mu16_AddressErrorCount = 0;
+    mu16_ChecksumErrorCount = 0;
+    return;
+  }
+
+
+
+  uint8_t *MemoryManagement::_translate(const uint8_t u8_MemoryID, const uint32_t u32_StartAddress, const uint32_t u32_Length,
+                                        const bool b_Write)
+  {
+    for(uint8_t i=0; i<mu8_RegionCount; i++)
+    {
+      if((mau8_MemoryID[i]!=u8_MemoryID) || (u32_StartAddress<mau32_StartAddress[i]))
+        continue;
+      if((uint64_t)(u32_StartAddress-mau32_StartAddress[i])+u32_Length>mau32_Size[i])
+        continue;
+      if(b_Write && !mab_Writable[i])
+        break;
+      return &mapu8_Memory[i][u32_StartAddress-mau32_StartAddress[i]];
+    }
+
+    if(mu16_AddressErrorCount<0xffff)
+      mu16_AddressErrorCount++;
+    return nullptr;
+  }
+
+
+
+  int32_t MemoryManagement::_execute(const uint8_t u8_SubService, const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    uint32_t u32_Length;
+    uint16_t u16_Checksum;
+
+    if(!pu8_Data || (u32_DataSize<BlockHdrSize))
+      return InvalidRequest;
+
+    switch(u8_SubService)
+    {
+    case LoadMemory:
+      u32_Length = ((uint32_t)pu8_Data[5]<<8) | pu8_Data[6];
+      if((u32_Length==0) || (u32_DataSize!=BlockHdrSize+u32_Length+CrcSize))
+        return InvalidRequest;
+      u16_Checksum = (uint16_t)((pu8_Data[BlockHdrSize+u32_Length]<<8) | pu8_Data[BlockHdrSize+u32_Length+1]);
+      switch(load(pu8_Data[0], getUint32(&pu8_Data[1]), &pu8_Data[BlockHdrSize], u32_Length, u16_Checksum))
+      {
+      case 0:  return 0;
+      case -2: return ChecksumError;
+      case -3: return VerificationError;
+      default: return InvalidAddress;
+      }
+
+    case DumpMemory:
+      if((u32_DataSize!=RequestSize) || (getUint32(&pu8_Data[5])==0))
+        return InvalidRequest;
+      switch(startDump(pu8_Data[0], getUint32(&pu8_Data[1]), getUint32(&pu8_Data[5])))
+      {
+      case 0:  return 0;
+      case -2: return DumpRunning;
+      default: return InvalidAddress;
+      }
+
+    case CheckMemory:
+      if((u32_DataSize!=RequestSize) || (getUint32(&pu8_Data[5])==0))
+        return InvalidRequest;
+      // the result of the previous check was not reported yet
+      if(mb_CheckPending)
+        return CheckPending;
+      if(check(pu8_Data[0], getUint32(&pu8_Data[1]), getUint32(&pu8_Data[5]), &u16_Checksum)!=0)
+        return InvalidAddress;
+      mu8_CheckMemoryID = pu8_Data[0];
+      mu32_CheckAddress = getUint32(&pu8_Data[1]);
+      mu32_CheckLength = getUint32(&pu8_Data[5]);
+      mu16_CheckCRC = u16_Checksum;
+      mb_CheckPending = true;
+      return 0;
+
+    default:
+      return InvalidRequest;
+    }
+  }
+
+}
@@ -0,0 +1,174 @@
+/**
+ * @file      pus_memory.h
+ *
+ * @brief     Include file of the PUS memory management class (service 6)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+
+#ifndef _PUS_MEMORY_H_
+#define _PUS_MEMORY_H_
+
+/****************************************************************/
+/* Memory Management Service according to                       */
+/*                                                              */
+/*  ECSS-E-70-41A - Ground systems and operations -             */
+/*                  Telemetry and telecommand packet            */
+/*                  utilization, service 6                      */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Only the subservices with absolute addresses are          */
+/*    supported (6,2 / 6,5 / 6,6 / 6,9 / 6,10)                  */
+/*  - A load telecommand contains one memory block; the lengths */
+/*    of dumps and checks are 32 bit values                     */
+/*  - The addresses are mapped to memory regions which are      */
+/*    defined onboard with defineRegion()                       */
+/*  - The checksum is the CRC-16 of the Packet Error Control    */
+/*    (polynom 0x1021, initial value 0xffff)                    */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "ccsds_spacepacket.h"
+#include "pus_tc.h"
+#include "pus_tm.h"
+#include "pus_verification.h"
+
+#ifdef configPUS_MEM_MAX_REGIONS
+#define PUS_MEM_MAX_REGIONS configPUS_MEM_MAX_REGIONS
+#else
+#define PUS_MEM_MAX_REGIONS 8
+#endif
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Class for loading, dumping and checking onboard memory (PUS service 6).
+   *
+   * The memory which can be accessed by ground is defined as a list of regions. A region maps the addresses
+   * [start address, start address + size) of a memory ID to a buffer in the onboard memory; regions can be
+   * read-only. All accesses must be located completely within one region.
+   *
+   * A memory dump is split into dump reports (6,6) which fit into the packet size set with setPacketSize().
+   * generate() writes as many reports as fit into the given buffer; the data is copied straight from the
+   * memory into the reports. The checksums are calculated with Transferframe::calcCRC(), which uses a 256 entry
+   * table if configTF_USE_CRC_TABLE is set.
+   *
+   * A load (6,2) is only applied if the checksum of the load data is correct; after the data was written, the
+   * memory is read back and compared against the checksum. A check (6,9) calculates the checksum of a memory
+   * block, which is reported with the next call of generate() in a memory check report (6,10).
+   *
+   * The class implements the TcActionInterface, so it can be registered at a TcRegistry for the subservices
+   * 2, 5 and 9 of service 6. If a Verification object is set, the execution of these telecommands is
+   * confirmed with completion reports (1,7) and (1,8); the completion of a dump is reported when its last dump
+   * report was created. A check is rejected while the report of the previous check was not created yet.
+   */
+  class MemoryManagement : public TcActionInterface
+  {
+  public:
+    const static uint16_t MaxRegions = PUS_MEM_MAX_REGIONS;
+
+    enum SubService
+    {
+      LoadMemory = 2,
+      DumpMemory = 5,
+      MemoryDumpReport = 6,
+      CheckMemory = 9,
+      MemoryCheckReport = 10
+    };
+
+    /** Failure codes of the completion failure reports (1,8) */
+    enum FailureCode
+    {
+      InvalidRequest = 1,     /**< The application data of the telecommand has a wrong length or a length of 0 */
+      InvalidAddress = 2,     /**< The memory block is not located within one (writable) region */
+      ChecksumError = 3,      /**< The checksum of the load data is wrong */
+      VerificationError = 4,  /**< The memory does not contain the load data after writing */
+      DumpRunning = 5,        /**< A dump is requested while the previous dump is not finished */
+      CheckPending = 6,       /**< A check is requested while the previous check report was not created */
+      DumpAborted = 7         /**< The dump was aborted before all dump reports were created */
+    };
+
+  private:
+    const static uint8_t BlockHdrSize = 1+4+2;     // memory ID, start address, length
+    const static uint8_t RequestSize = 1+4+4;      // memory ID, start address, 32 bit length
+    const static uint8_t CrcSize = 2;
+    const static uint16_t MinPacketSize = SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE+BlockHdrSize+CrcSize+1;
+
+    uint16_t mu16_APID;
+    uint16_t mu16_SequenceCount;
+    uint16_t mu16_PacketSize;
+
+    // regions, stored as structure of arrays
+    uint8_t mu8_RegionCount;
+    uint8_t mau8_MemoryID[PUS_MEM_MAX_REGIONS];
+    uint32_t mau32_StartAddress[PUS_MEM_MAX_REGIONS];
+    uint32_t mau32_Size[PUS_MEM_MAX_REGIONS];
+    uint8_t *mapu8_Memory[PUS_MEM_MAX_REGIONS];
+    bool mab_Writable[PUS_MEM_MAX_REGIONS];
+
+    // running dump
+    const uint8_t *mpu8_DumpSource;
+    uint8_t mu8_DumpMemoryID;
+    uint32_t mu32_DumpAddress;
+    uint32_t mu32_DumpRemaining;
+    uint32_t mu32_DumpRequestID;
+    bool mb_DumpVerification;     // the dump was requested by a telecommand, its completion is reported
+    bool mb_DumpAckComp;
+
+    // pending check report
+    bool mb_CheckPending;
+    uint8_t mu8_CheckMemoryID;
+    uint32_t mu32_CheckAddress;
+    uint32_t mu32_CheckLength;
+    uint16_t mu16_CheckCRC;
+
+    uint16_t mu16_AddressErrorCount;
+    uint16_t mu16_ChecksumErrorCount;
+
+    Verification *mp_Verification;
+
+  public:
+    MemoryManagement(const uint16_t u16_APID);
+
+    int32_t defineRegion(const uint8_t u8_MemoryID, const uint32_t u32_StartAddress,
+                         void *p_Memory, const uint32_t u32_Size, const bool b_Writable);
+    void clearRegions(void);
+    int32_t setPacketSize(const uint16_t u16_PacketSize);
+    void setVerification(Verification *p_Verification);
+
+    int32_t load(const uint8_t u8_MemoryID, const uint32_t u32_StartAddress,
+                 const uint8_t *pu8_Data, const uint32_t u32_Length, const uint16_t u16_Checksum);
+    int32_t startDump(const uint8_t u8_MemoryID, const uint32_t u32_StartAddress, const uint32_t u32_Length);
+    void abortDump(void);
+    bool isDumping(void);
+    int32_t check(const uint8_t u8_MemoryID, const uint32_t u32_StartAddress, const uint32_t u32_Length,
+                  uint16_t *pu16_Checksum);
+
+    uint32_t generate(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+
+    void onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                      const uint8_t u8_Service, const uint8_t u8_SubService,
+                      const uint8_t u8_SourceID,
+                      const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+
+    uint16_t getAddressErrorCount(void);
+    uint16_t getChecksumErrorCount(void);
+    void clearErrorCounters(void);
+
+  private:
+    uint8_t *_translate(const uint8_t u8_MemoryID, const uint32_t u32_StartAddress, const uint32_t u32_Length,
+                        const bool b_Write);
+    int32_t _execute(const uint8_t u8_SubService, const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+  };
+
+}
+
+#endif // _PUS_MEMORY_H_
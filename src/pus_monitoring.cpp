@@ -0,0 +1,347 @@
+/**
+ * @file      pus_monitoring.cpp
+ *
+ * @brief     Source file of the PUS onboard monitoring class (service 12)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include "pus_monitoring.h"
+#include "ccsds_spacepacket.h"
+
+
+namespace PUS
+{
+
+  static inline void putUint32(uint8_t *pu8_Buffer, const uint32_t u32_Value)
+  {
+    pu8_Buffer[0] = (uint8_t)(u32_Value>>24);
+    pu8_Buffer[1] = (uint8_t)(u32_Value>>16);
+    pu8_Buffer[2] = (uint8_t)(u32_Value>>8);
+    pu8_Buffer[3] = (uint8_t)u32_Value;
+  }
+
+
+
+  /**
+   * @brief Construct a new Monitoring object without monitors
+   *
+   * @param u16_APID    The APID of the check transition reports
+   */
+  Monitoring::Monitoring(const uint16_t u16_APID)
+    : mu16_APID{u16_APID}
+    , mu16_SequenceCount{0}
+    , mu16_MonitorCount{0}
+  {
+  }
+
+
+
+  /**
+   * @brief Defines a monitor for a parameter
+   *
+   * An already existing monitor of the same parameter ID is replaced. New monitors are enabled; their
+   * status is Unchecked until the first status was confirmed. The change from Unchecked to WithinLimits
+   * is not reported.
+   *
+   * @param u16_ParameterID   The ID of the parameter which is used in the reports and telecommands
+   * @param pi32_Parameter    The address of the parameter in memory
+   * @param e_CheckType       LimitCheck or DeltaCheck
+   * @param i32_LowLimit      The lowest allowed value (or difference for delta checks)
+   * @param i32_HighLimit     The highest allowed value (or difference for delta checks)
+   * @param u8_Repetitions    The number of consecutive cycles a new status must be seen before it is accepted
+   *
+   * @retval  0   If the monitor was defined
+   * @retval -1   If the parameters are invalid
+   * @retval -2   If the maximum number of monitors is reached
+   */
+  int32_t Monitoring::defineMonitor(const uint16_t u16_ParameterID, const int32_t *pi32_Parameter, const enum CheckType e_CheckType,
+                                    const int32_t i32_LowLimit, const int32_t i32_HighLimit, const uint8_t u8_Repetitions)
+  {
+    uint16_t u16_Monitor;
+
+    if(!pi32_Parameter || (i32_LowLimit>i32_HighLimit) || ((e_CheckType!=LimitCheck) && (e_CheckType!=DeltaCheck)))
+      return -1;
+
+    u16_Monitor = _findMonitor(u16_ParameterID);
+    if(u16_Monitor==NoMonitor)
+    {
+      if(mu16_MonitorCount>=MaxMonitors)
+        return -2;
+      u16_Monitor = mu16_MonitorCount++;
+    }
+
+    mau16_ParameterID[u16_Monitor] = u16_ParameterID;
+    mapi32_Source[u16_Monitor] = pi32_Parameter;
+    mai32_Value[u16_Monitor] = *pi32_Parameter;
+    mai32_Previous[u16_Monitor] = *pi32_Parameter;
+    mau32_DeltaMask[u16_Monitor] = (e_CheckType==DeltaCheck)?0xffffffffUL:0;
+    mai32_LowLimit[u16_Monitor] = i32_LowLimit;
+    mai32_HighLimit[u16_Monitor] = i32_HighLimit;
+    mau8_Repetitions[u16_Monitor] = u8_Repetitions?u8_Repetitions:1;
+    mau8_RepetitionCount[u16_Monitor] = 0;
+    mau8_PendingStatus[u16_Monitor] = Unchecked;
+    mau8_Status[u16_Monitor] = Unchecked;
+    mab_Enabled[u16_Monitor] = true;
+
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Deletes the monitor of a parameter
+   *
+   * @param u16_ParameterID   The ID of the parameter
+   *
+   * @retval  0   If the monitor was deleted
+   * @retval -1   If the parameter is not monitored
+   */
+  int32_t Monitoring::deleteMonitor(const uint16_t u16_ParameterID)
+  {
+    const uint16_t u16_Monitor = _findMonitor(u16_ParameterID);
+    uint16_t u16_Last;
+
+    if(u16_Monitor==NoMonitor)
+      return -1;
+
+    // move the last monitor into the gap
+    u16_Last = (uint16_t)(mu16_MonitorCount-1);
+    if(u16_Monitor!=u16_Last)
+    {
+      mau16_ParameterID[u16_Monitor] = mau16_ParameterID[u16_Last];
+      mapi32_Source[u16_Monitor] = mapi32_Source[u16_Last];
+      mai32_Value[u16_Monitor] = mai32_Value[u16_Last];
+      mai32_Previous[u16_Monitor] = mai32_Previous[u16_Last];
+      mau32_DeltaMask[u16_Monitor] = mau32_DeltaMask[u16_Last];
+      mai32_LowLimit[u16_Monitor] = mai32_LowLimit[u16_Last];
+      mai32_HighLimit[u16_Monitor] = mai32_HighLimit[u16_Last];
+      mau8_Repetitions[u16_Monitor] = mau8_Repetitions[u16_Last];
+      mau8_RepetitionCount[u16_Monitor] = mau8_RepetitionCount[u16_Last];
+      mau8_PendingStatus[u16_Monitor] = mau8_PendingStatus[u16_Last];
+      mau8_Status[u16_Monitor] = mau8_Status[u16_Last];
+      mab_Enabled[u16_Monitor] = mab_Enabled[u16_Last];
+    }
+    mu16_MonitorCount = u16_Last;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Deletes all monitors
+   */
+  void Monitoring::clearMonitors(void)
+  {
+    mu16_MonitorCount = 0;
+  }
+
+
+
+  /**
+   * @brief Enables or disables the monitor of a parameter
+   *
+   * A disabled monitor has the status Unchecked; when it is enabled again, the checks start from scratch.
+   *
+   * @param u16_ParameterID   The ID of the parameter
+   * @param b_Enabled         true if the parameter shall be monitored
+   *
+   * @retval  0   If the monitor was enabled or disabled
+   * @retval -1   If the parameter is not monitored
+   */
+  int32_t Monitoring::setMonitorEnabled(const uint16_t u16_ParameterID, const bool b_Enabled)
+  {
+    const uint16_t u16_Monitor = _findMonitor(u16_ParameterID);
+
+    if(u16_Monitor==NoMonitor)
+      return -1;
+    if(b_Enabled && !mab_Enabled[u16_Monitor])
+      mai32_Previous[u16_Monitor] = *mapi32_Source[u16_Monitor];
+    if(b_Enabled!=mab_Enabled[u16_Monitor])
+    {
+      mau8_RepetitionCount[u16_Monitor] = 0;
+      mau8_PendingStatus[u16_Monitor] = Unchecked;
+      mau8_Status[u16_Monitor] = Unchecked;
+    }
+    mab_Enabled[u16_Monitor] = b_Enabled;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Returns the accepted checking status of a parameter
+   *
+   * @param u16_ParameterID   The ID of the parameter
+   *
+   * @return The checking status (Unchecked if the parameter is not monitored)
+   */
+  enum Monitoring::CheckingStatus Monitoring::getStatus(const uint16_t u16_ParameterID)
+  {
+    const uint16_t u16_Monitor = _findMonitor(u16_ParameterID);
+
+    if(u16_Monitor==NoMonitor)
+      return Unchecked;
+    return (enum CheckingStatus)mau8_Status[u16_Monitor];
+  }
+
+
+
+  /**
+   * @brief Executes one monitoring cycle and writes the check transition reports into the given buffer
+   *
+   * The report packets (12,12) are written one after another; each holds up to the maximum number of
+   * transitions which fit into a space packet. A transition consists of the parameter ID (16 bit), the
+   * parameter value (32 bit), the crossed limit (32 bit), the previous and the current checking status
+   * (8 bit each) and the transition time (32 bit). Transitions which do not fit into the buffer are not
+   * accepted yet and are reported with the next call.
+   *
+   * @param u32_CurrentTime   The current onboard time, used as transition time
+   * @param pu8_Buffer        A pointer to the buffer where the report packets shall be stored
+   * @param u32_BufferSize    The available size of the buffer
+   *
+   * @return The number of bytes written into the buffer
+   */
+  uint32_t Monitoring::check(const uint32_t u32_CurrentTime, uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    const uint8_t u8_MaxTransitions = (uint8_t)((SP_MAX_DATA_SIZE-Tm::SecHdrSize-1)/TransitionSize);
+    uint8_t au8_Data[1+((SP_MAX_DATA_SIZE-Tm::SecHdrSize-1)/TransitionSize)*TransitionSize];
+    uint16_t au16_Reported[(SP_MAX_DATA_SIZE-Tm::SecHdrSize-1)/TransitionSize];
+    uint8_t u8_Transitions = 0;
+    uint32_t u32_Written = 0;
+    uint32_t u32_Size;
+
+    if(!pu8_Buffer)
+      return 0;
+
+    // sample the parameters
+    for(uint16_t i=0; i<mu16_MonitorCount; i++)
+      mai32_Value[i] = *mapi32_Source[i];
+
+    // evaluate all monitors without branches; the delta wraps around like the 32 bit difference
+    for(uint16_t i=0; i<mu16_MonitorCount; i++)
+    {
+      const int32_t i32_Checked = (int32_t)((uint32_t)mai32_Value[i]-((uint32_t)mai32_Previous[i]&mau32_DeltaMask[i]));
+      const uint8_t u8_Status = (uint8_t)((i32_Checked<mai32_LowLimit[i]) | ((i32_Checked>mai32_HighLimit[i])<<1));
+      const uint8_t u8_Count = mau8_RepetitionCount[i];
+
+      mau8_RepetitionCount[i] = (u8_Status==mau8_PendingStatus[i])?(uint8_t)(u8_Count+(u8_Count<0xff)):1;
+      mau8_PendingStatus[i] = u8_Status;
+      mai32_Previous[i] = mai32_Value[i];
+    }
+
+    // report the confirmed status changes
+    for(uint16_t i=0; i<mu16_MonitorCount; i++)
+    {
+      uint8_t *pu8_Transition;
+      uint8_t u8_Previous;
+      uint8_t u8_Current;
+      int32_t i32_Limit;
+
+      if(!mab_Enabled[i] || (mau8_RepetitionCount[i]<mau8_Repetitions[i]) || (mau8_PendingStatus[i]==mau8_Status[i]))
+        continue;
+
+      u8_Previous = mau8_Status[i];
+      u8_Current = mau8_PendingStatus[i];
+      if((u8_Previous==Unchecked) && (u8_Current==WithinLimits))
+      {
+        mau8_Status[i] = u8_Current;
+        continue;
+      }
+
+      if(u8_Transitions==u8_MaxTransitions)
+      {
+        au8_Data[0] = u8_Transitions;
+        u32_Size = Tm::createPacket(&pu8_Buffer[u32_Written], u32_BufferSize-u32_Written, mu16_APID, mu16_SequenceCount,
+                                    Tc::OnboardMonitoringService, CheckTransitionReport,
+                                    au8_Data, (uint16_t)(1+u8_Transitions*TransitionSize));
+        if(u32_Size==0)
+          return u32_Written;
+        for(uint8_t j=0; j<u8_Transitions; j++)
+          mau8_Status[au16_Reported[j]] = mau8_PendingStatus[au16_Reported[j]];
+        mu16_SequenceCount = (uint16_t)((mu16_SequenceCount+1)&0x3fff);
+        u32_Written += u32_Size;
+        u8_Transitions = 0;
+      }
+
+      if(u8_Current==BelowLowLimit)
+        i32_Limit = mai32_LowLimit[i];
+      else if(u8_Current==AboveHighLimit)
+        i32_Limit = mai32_HighLimit[i];
+      else
+        i32_Limit = (u8_Previous==BelowLowLimit)?mai32_LowLimit[i]:mai32_HighLimit[i];
+
+      pu8_Transition = &au8_Data[1+u8_Transitions*TransitionSize];
+      pu8_Transition[0] = (uint8_t)(mau16_ParameterID[i]>>8);
+      pu8_Transition[1] = (uint8_t)mau16_ParameterID[i];
+      putUint32(&pu8_Transition[2], (uint32_t)mai32_Value[i]);
+      putUint32(&pu8_Transition[6], (uint32_t)i32_Limit);
+      pu8_Transition[10] = u8_Previous;
+      pu8_Transition[11] = u8_Current;
+      putUint32(&pu8_Transition[12], u32_CurrentTime);
+      au16_Reported[u8_Transitions++] = i;
+    }
+
+    if(u8_Transitions>0)
+    {
+      au8_Data[0] = u8_Transitions;
+      u32_Size = Tm::createPacket(&pu8_Buffer[u32_Written], u32_BufferSize-u32_Written, mu16_APID, mu16_SequenceCount,
+                                  Tc::OnboardMonitoringService, CheckTransitionReport,
+                                  au8_Data, (uint16_t)(1+u8_Transitions*TransitionSize));
+      if(u32_Size==0)
+        return u32_Written;
+      for(uint8_t j=0; j<u8_Transitions; j++)
+        mau8_Status[au16_Reported[j]] = mau8_PendingStatus[au16_Reported[j]];
+      mu16_SequenceCount = (uint16_t)((mu16_SequenceCount+1)&0x3fff);
+      u32_Written += u32_Size;
+    }
+
+    return u32_Written;
+  }
+
+
+
+  /**
+   * @brief Handles a telecommand of service 12
+   *
+   * This method is called by the Tc object or a TcRegistry; the parameters are the ones of
+   * TcActionInterface::onTcReceived(). The application data of the subservices 1 and 2 is N, N times the
+   * 16 bit parameter ID; subservice 4 has no application data.
+   */
+  void Monitoring::onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                                const uint8_t u8_Service, const uint8_t u8_SubService,
+                                const uint8_t u8_SourceID,
+                                const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    (void)b_AckAcc; (void)b_AckStart; (void)b_AckProg; (void)b_AckComp; (void)u8_SourceID;
+
+    if(u8_Service!=Tc::OnboardMonitoringService)
+      return;
+
+    if(u8_SubService==ClearMonitoringList)
+    {
+      clearMonitors();
+      return;
+    }
+    if(((u8_SubService!=EnableMonitoring) && (u8_SubService!=DisableMonitoring)) || !pu8_Data || (u32_DataSize<1))
+      return;
+
+    for(uint32_t i=0; (i<pu8_Data[0]) && (1+2*i+1<u32_DataSize); i++)
+      setMonitorEnabled((uint16_t)((pu8_Data[1+2*i]<<8) | pu8_Data[2+2*i]), u8_SubService==EnableMonitoring);
+  }
+
+
+
+  uint16_t Monitoring::_findMonitor(const uint16_t u16_ParameterID)
+  {
+    for(uint16_t i=0; i<mu16_MonitorCount; i++)
+    {
+      if(mau16_ParameterID[i]==u16_ParameterID)
+        return i;
+    }
+    return NoMonitor;
+  }
+
+}
@@ -0,0 +1,141 @@
+/**
+ * @file      pus_monitoring.h
+ *
+ * @brief     Include file of the PUS onboard monitoring class (service 12)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+
+#ifndef _PUS_MONITORING_H_
+#define _PUS_MONITORING_H_
+
+/****************************************************************/
+/* Onboard Monitoring Service according to                      */
+/*                                                              */
+/*  ECSS-E-70-41A - Ground systems and operations -             */
+/*                  Telemetry and telecommand packet            */
+/*                  utilization, service 12                     */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Only limit checks and delta checks of 32 bit signed       */
+/*    parameters with one pair of limits are supported          */
+/*  - Monitors are defined onboard with defineMonitor(), not by */
+/*    telecommand; the check transition report (12,12) is sent  */
+/*    immediately, there is no maximum reporting delay          */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "pus_tc.h"
+#include "pus_tm.h"
+
+#ifdef configPUS_MON_MAX_MONITORS
+#define PUS_MON_MAX_MONITORS configPUS_MON_MAX_MONITORS
+#else
+#define PUS_MON_MAX_MONITORS 1024
+#endif
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Class for monitoring onboard parameters against limits (PUS service 12).
+   *
+   * A monitor checks a 32 bit signed parameter, given by its address in memory, either against a low and a
+   * high limit (limit check) or checks the difference to the previous sample against the limits (delta
+   * check). A new checking status is only accepted after it was seen in a given number of consecutive
+   * monitoring cycles (repetition number).
+   *
+   * The monitors are stored as structure of arrays. check() first samples all parameters, then evaluates
+   * all monitors in one loop without branches, which the compiler can vectorize, and finally walks over the
+   * few monitors whose status changed. The status changes are reported in check transition reports (12,12)
+   * which are written into the given buffer; changes which do not fit into the buffer are reported with the
+   * next call.
+   *
+   * The class implements the TcActionInterface, so it can be registered at a TcRegistry for the subservices
+   * 1 (enable monitoring of parameters), 2 (disable monitoring of parameters) and 4 (clear monitoring list)
+   * of service 12.
+   */
+  class Monitoring : public TcActionInterface
+  {
+  public:
+    static const uint16_t MaxMonitors = PUS_MON_MAX_MONITORS;
+
+    /** The type of the check
+     */
+    enum CheckType
+    {
+      LimitCheck = 0,     /**< The value is checked against the limits */
+      DeltaCheck = 1      /**< The difference to the previous value is checked against the limits */
+    };
+
+    /** The checking status of a monitor
+     */
+    enum CheckingStatus
+    {
+      WithinLimits = 0,
+      BelowLowLimit = 1,
+      AboveHighLimit = 2,
+      Unchecked = 3       /**< The monitor is disabled or was not yet checked */
+    };
+
+    enum SubService
+    {
+      EnableMonitoring = 1,
+      DisableMonitoring = 2,
+      ClearMonitoringList = 4,
+      CheckTransitionReport = 12
+    };
+
+  private:
+    const static uint16_t NoMonitor = 0xffff;
+    const static uint8_t TransitionSize = 16;     // parameter ID, value, limit, previous and current status, time
+
+    uint16_t mu16_APID;
+    uint16_t mu16_SequenceCount;
+
+    // monitors, stored as structure of arrays
+    uint16_t mu16_MonitorCount;
+    uint16_t mau16_ParameterID[PUS_MON_MAX_MONITORS];
+    const int32_t *mapi32_Source[PUS_MON_MAX_MONITORS];
+    int32_t mai32_Value[PUS_MON_MAX_MONITORS];
+    int32_t mai32_Previous[PUS_MON_MAX_MONITORS];
+    uint32_t mau32_DeltaMask[PUS_MON_MAX_MONITORS];   // all ones for delta checks
+    int32_t mai32_LowLimit[PUS_MON_MAX_MONITORS];
+    int32_t mai32_HighLimit[PUS_MON_MAX_MONITORS];
+    uint8_t mau8_Repetitions[PUS_MON_MAX_MONITORS];
+    uint8_t mau8_RepetitionCount[PUS_MON_MAX_MONITORS];
+    uint8_t mau8_PendingStatus[PUS_MON_MAX_MONITORS];
+    uint8_t mau8_Status[PUS_MON_MAX_MONITORS];
+    bool mab_Enabled[PUS_MON_MAX_MONITORS];
+
+  public:
+    Monitoring(const uint16_t u16_APID);
+
+    int32_t defineMonitor(const uint16_t u16_ParameterID, const int32_t *pi32_Parameter, const enum CheckType e_CheckType,
+                          const int32_t i32_LowLimit, const int32_t i32_HighLimit, const uint8_t u8_Repetitions = 1);
+    int32_t deleteMonitor(const uint16_t u16_ParameterID);
+    void clearMonitors(void);
+    int32_t setMonitorEnabled(const uint16_t u16_ParameterID, const bool b_Enabled);
+    enum CheckingStatus getStatus(const uint16_t u16_ParameterID);
+
+    uint32_t check(const uint32_t u32_CurrentTime, uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+
+    void onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                      const uint8_t u8_Service, const uint8_t u8_SubService,
+                      const uint8_t u8_SourceID,
+                      const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+
+  private:
+    uint16_t _findMonitor(const uint16_t u16_ParameterID);
+  };
+
+}
+
+#endif // _PUS_MONITORING_H_
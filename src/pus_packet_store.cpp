@@ -0,0 +1,655 @@
+/**
+ * @file      pus_packet_store.cpp
+ *
+ * @brief     Source file of the PUS packet store class (service 15)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "pus_packet_store.h"
+
+
+#define RECORD_FLAGS_POS      0
+#define RECORD_APID_POS       1
+#define RECORD_SEQCOUNT_POS   3
+#define RECORD_LENGTH_POS     5
+#define RECORD_TIME_POS       7
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Construct a new PacketStore object
+   *
+   * @param pu8_Region      A pointer to the memory region where the packets shall be stored
+   * @param u32_RegionSize  The size of the memory region
+   * @param u8_StoreID      The packet store ID which is expected in the service 15 telecommands
+   */
+  PacketStore::PacketStore(uint8_t *pu8_Region, const uint32_t u32_RegionSize, const uint8_t u8_StoreID)
+    : mpu8_Region{pu8_Region}
+    , mu32_RegionSize{pu8_Region?u32_RegionSize:0}
+    , mu32_Time{0}
+    , mu8_StoreID{u8_StoreID}
+    , mb_StorageEnabled{true}
+    , mu16_OverflowErrorCount{0}
+    , mu16_SkippedCount{0}
+    , mu32_DownlinkRequestID{0}
+    , mb_DownlinkAckComp{false}
+    , mp_Verification{nullptr}
+  {
+    mS_Downlink.b_Complete = true;
+    clear();
+  }
+
+
+
+  /**
+   * @brief Deletes all stored packets
+   */
+  void PacketStore::clear(void)
+  {
+    mu32_Tail = 0;
+    mu32_Used = 0;
+    mu32_FirstRecordNr = 0;
+    mu32_NextRecordNr = 0;
+    mu16_IndexTail = 0;
+    mu16_IndexCount = 0;
+    mu32_IndexFirstBlock = 0;
+  }
+
+
+
+  /**
+   * @brief Sets the time which is used for packets received with onSpacePacketReceived()
+   *
+   * @param u32_CurrentTime   The current onboard time
+   */
+  void PacketStore::setTime(const uint32_t u32_CurrentTime)
+  {
+    mu32_Time = u32_CurrentTime;
+  }
+
+
+
+  /**
+   * @brief Enables or disables the storage of new packets, as done by the telecommands (15,1) and (15,2)
+   *
+   * @param b_Enabled   true, if new packets shall be stored
+   */
+  void PacketStore::setStorageEnabled(const bool b_Enabled)
+  {
+    mb_StorageEnabled = b_Enabled;
+  }
+
+
+
+  /**
+   * @brief Sets the Verification object which is used for the completion reports of the service 15 telecommands
+   *
+   * @param p_Verification  A pointer to the Verification object, or nullptr
+   */
+  void PacketStore::setVerification(Verification *p_Verification)
+  {
+    mp_Verification = p_Verification;
+  }
+
+
+
+  /**
+   * @brief Appends a space packet to the store
+   *
+   * If the memory region is full, the oldest packets are overwritten.
+   *
+   * @param u32_Time              The storage time; must not be lower than the one of the previous packet
+   * @param u8_PacketType         The packet type (TM or TC)
+   * @param u8_SequenceFlags      The sequence flags
+   * @param u16_APID              The application ID
+   * @param u16_SequenceCount     The sequence count of the packet
+   * @param b_SecHeader           The secondary header flag of the packet
+   * @param pu8_PacketData        A pointer to the packet data field
+   * @param u16_PacketDataLength  The size of the packet data field in bytes
+   *
+   * @retval  0   If the packet was stored
+   * @retval -1   If the packet is invalid or larger than the memory region
+   * @retval -2   If the storage is disabled
+   */
+  int32_t PacketStore::store(const uint32_t u32_Time, const uint8_t u8_PacketType,
+                             const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                             const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                             const uint8_t *pu8_PacketData, const uint16_t u16_PacketDataLength)
+  {
+    uint32_t u32_RecordSize = RecordHdrSize+(uint32_t)u16_PacketDataLength;
+    uint8_t au8_Hdr[RecordHdrSize];
+    uint32_t u32_Offset;
+    uint32_t u32_Block = mu32_NextRecordNr/PUS_STORE_INDEX_INTERVAL;
+    IndexEntry *pS_Entry;
+
+    if(!mb_StorageEnabled)
+      return -2;
+
+    if(!pu8_PacketData || (u16_PacketDataLength==0) || (u32_RecordSize>mu32_RegionSize))
+    {
+      if(mu16_OverflowErrorCount<0xffff)
+        mu16_OverflowErrorCount++;
+      return -1;
+    }
+
+    while(mu32_RegionSize-mu32_Used<u32_RecordSize)
+      _dropOldest();
+    u32_Offset = (mu32_Tail+mu32_Used)%mu32_RegionSize;
+
+    if((mu32_NextRecordNr%PUS_STORE_INDEX_INTERVAL)==0)
+    {
+      if(mu16_IndexCount==PUS_STORE_INDEX_SIZE)
+      {
+        mu16_IndexTail = (uint16_t)((mu16_IndexTail+1)%PUS_STORE_INDEX_SIZE);
+        mu16_IndexCount--;
+        mu32_IndexFirstBlock++;
+      }
+      if(mu16_IndexCount==0)
+        mu32_IndexFirstBlock = u32_Block;
+      pS_Entry = &maS_Index[(mu16_IndexTail+mu16_IndexCount)%PUS_STORE_INDEX_SIZE];
+      pS_Entry->u32_Offset = u32_Offset;
+      pS_Entry->u32_Time = u32_Time;
+      pS_Entry->u32_ApidMask = 0;
+      mu16_IndexCount++;
+    }
+    pS_Entry = _getIndexEntry(u32_Block);
+    if(pS_Entry)
+      pS_Entry->u32_ApidMask |= _apidMask(u16_APID);
+
+    au8_Hdr[RECORD_FLAGS_POS] = (uint8_t)(((u8_PacketType&0x1)<<7) | ((b_SecHeader?1:0)<<6) | ((u8_SequenceFlags&0x3)<<4));
+    au8_Hdr[RECORD_APID_POS] = (uint8_t)((u16_APID>>8)&0x7);
+    au8_Hdr[RECORD_APID_POS+1] = (uint8_t)(u16_APID&0xff);
+    au8_Hdr[RECORD_SEQCOUNT_POS] = (uint8_t)((u16_SequenceCount>>8)&0x3f);
+    au8_Hdr[RECORD_SEQCOUNT_POS+1] = (uint8_t)(u16_SequenceCount&0xff);
+    au8_Hdr[RECORD_LENGTH_POS] = (uint8_t)(u16_PacketDataLength>>8);
+    au8_Hdr[RECORD_LENGTH_POS+1] = (uint8_t)(u16_PacketDataLength&0xff);
+    au8_Hdr[RECORD_TIME_POS] = (uint8_t)(u32_Time>>24);
+    au8_Hdr[RECORD_TIME_POS+1] = (uint8_t)(u32_Time>>16);
+    au8_Hdr[RECORD_TIME_POS+2] = (uint8_t)(u32_Time>>8);
+    au8_Hdr[RECORD_TIME_POS+3] = (uint8_t)(u32_Time&0xff);
+
+    _write(u32_Offset, au8_Hdr, RecordHdrSize);
+    _write((u32_Offset+RecordHdrSize)%mu32_RegionSize, pu8_PacketData, u16_PacketDataLength);
+    mu32_Used += u32_RecordSize;
+    mu32_NextRecordNr++;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Prepares the retrieval of stored packets
+   *
+   * The start position is looked up in the sparse index, so the store is not scanned from the beginning.
+   *
+   * @param pS_Retrieval            A pointer to the retrieval state, which is used for the following calls of retrieve()
+   * @param u16_APID                The APID of the requested packets, or AllAPIDs
+   * @param u32_StartTime           The storage time of the first requested packet
+   * @param u32_EndTime             The storage time of the last requested packet
+   * @param u16_FirstSequenceCount  The first requested sequence count
+   * @param u16_LastSequenceCount   The last requested sequence count; if it is lower than the first one, the
+   *                                range wraps around at the end of the 14-bit sequence counter
+   *
+   * @retval  0   If the retrieval was prepared
+   * @retval -1   If pS_Retrieval is nullptr
+   */
+  int32_t PacketStore::startRetrieval(Retrieval *pS_Retrieval, const uint16_t u16_APID,
+                                      const uint32_t u32_StartTime, const uint32_t u32_EndTime,
+                                      const uint16_t u16_FirstSequenceCount, const uint16_t u16_LastSequenceCount)
+  {
+    uint16_t u16_Low = 0;
+    uint16_t u16_High = mu16_IndexCount;
+
+    if(!pS_Retrieval)
+      return -1;
+
+    pS_Retrieval->u16_APID = u16_APID;
+    pS_Retrieval->u32_StartTime = u32_StartTime;
+    pS_Retrieval->u32_EndTime = u32_EndTime;
+    pS_Retrieval->u16_FirstSequenceCount = u16_FirstSequenceCount&0x3fff;
+    pS_Retrieval->u16_LastSequenceCount = u16_LastSequenceCount&0x3fff;
+    pS_Retrieval->b_Complete = false;
+
+    // search the first index entry which is not older than the start time
+    while(u16_Low<u16_High)
+    {
+      uint16_t u16_Mid = (uint16_t)((u16_Low+u16_High)/2);
+      if(maS_Index[(mu16_IndexTail+u16_Mid)%PUS_STORE_INDEX_SIZE].u32_Time<u32_StartTime)
+        u16_Low = (uint16_t)(u16_Mid+1);
+      else
+        u16_High = u16_Mid;
+    }
+
+    // the packets of interest may start in the block before
+    if(u16_Low>0)
+    {
+      pS_Retrieval->u32_RecordNr = (mu32_IndexFirstBlock+u16_Low-1)*PUS_STORE_INDEX_INTERVAL;
+      pS_Retrieval->u32_Offset = maS_Index[(mu16_IndexTail+u16_Low-1)%PUS_STORE_INDEX_SIZE].u32_Offset;
+    }
+    else
+    {
+      pS_Retrieval->u32_RecordNr = mu32_FirstRecordNr;
+      pS_Retrieval->u32_Offset = mu32_Tail;
+    }
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Retrieves stored packets and writes them into the given buffer
+   *
+   * The matching packets are written as complete space packets, one after another, as long as they fit into the buffer.
+   * The buffer can then be wrapped into a transfer frame. The method shall be called until the flag b_Complete
+   * of the retrieval is set. A matching packet which does not even fit into the empty buffer is skipped and
+   * counted (see getSkippedCount()).
+   *
+   * @param pS_Retrieval    A pointer to the retrieval state prepared by startRetrieval()
+   * @param pu8_Buffer      A pointer to the buffer where the packets shall be stored
+   * @param u32_BufferSize  The available size of the buffer
+   *
+   * @return The number of bytes written into the buffer
+   */
+  uint32_t PacketStore::retrieve(Retrieval *pS_Retrieval, uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    uint32_t u32_Written = 0;
+    uint8_t au8_Hdr[RecordHdrSize];
+
+    if(!pS_Retrieval || !pu8_Buffer || pS_Retrieval->b_Complete)
+      return 0;
+
+    // the packets were overwritten in the meantime
+    if(pS_Retrieval->u32_RecordNr<mu32_FirstRecordNr)
+    {
+      pS_Retrieval->u32_RecordNr = mu32_FirstRecordNr;
+      pS_Retrieval->u32_Offset = mu32_Tail;
+    }
+
+    while(pS_Retrieval->u32_RecordNr<mu32_NextRecordNr)
+    {
+      uint16_t u16_APID;
+      uint16_t u16_SequenceCount;
+      uint16_t u16_Length;
+      uint32_t u32_Time;
+      bool b_Match;
+
+      // skip blocks without the requested APID
+      if((pS_Retrieval->u16_APID!=AllAPIDs) && ((pS_Retrieval->u32_RecordNr%PUS_STORE_INDEX_INTERVAL)==0))
+      {
+        uint32_t u32_Block = pS_Retrieval->u32_RecordNr/PUS_STORE_INDEX_INTERVAL;
+        IndexEntry *pS_Entry = _getIndexEntry(u32_Block);
+        if(pS_Entry && !(pS_Entry->u32_ApidMask&_apidMask(pS_Retrieval->u16_APID)))
+        {
+          IndexEntry *pS_Next = _getIndexEntry(u32_Block+1);
+          if(pS_Next)
+          {
+            pS_Retrieval->u32_RecordNr = (u32_Block+1)*PUS_STORE_INDEX_INTERVAL;
+            pS_Retrieval->u32_Offset = pS_Next->u32_Offset;
+          }
+          else
+          {
+            pS_Retrieval->u32_RecordNr = mu32_NextRecordNr;
+            pS_Retrieval->u32_Offset = (mu32_Tail+mu32_Used)%mu32_RegionSize;
+          }
+          continue;
+        }
+      }
+
+      _read(pS_Retrieval->u32_Offset, au8_Hdr, RecordHdrSize);
+      u16_APID = (uint16_t)(au8_Hdr[RECORD_APID_POS]<<8) | au8_Hdr[RECORD_APID_POS+1];
+      u16_SequenceCount = (uint16_t)(au8_Hdr[RECORD_SEQCOUNT_POS]<<8) | au8_Hdr[RECORD_SEQCOUNT_POS+1];
+      u16_Length = (uint16_t)(au8_Hdr[RECORD_LENGTH_POS]<<8) | au8_Hdr[RECORD_LENGTH_POS+1];
+      u32_Time = ((uint32_t)au8_Hdr[RECORD_TIME_POS]<<24) | ((uint32_t)au8_Hdr[RECORD_TIME_POS+1]<<16)
+               | ((uint32_t)au8_Hdr[RECORD_TIME_POS+2]<<8) | (uint32_t)au8_Hdr[RECORD_TIME_POS+3];
+
+      if(u32_Time>pS_Retrieval->u32_EndTime)
+      {
+        pS_Retrieval->b_Complete = true;
+        return u32_Written;
+      }
+
+      b_Match = (pS_Retrieval->u16_APID==AllAPIDs) || (pS_Retrieval->u16_APID==u16_APID);
+      b_Match = b_Match && (u32_Time>=pS_Retrieval->u32_StartTime);
+      if(pS_Retrieval->u16_FirstSequenceCount<=pS_Retrieval->u16_LastSequenceCount)
+        b_Match = b_Match && (u16_SequenceCount>=pS_Retrieval->u16_FirstSequenceCount) && (u16_SequenceCount<=pS_Retrieval->u16_LastSequenceCount);
+      else
+        b_Match = b_Match && ((u16_SequenceCount>=pS_Retrieval->u16_FirstSequenceCount) || (u16_SequenceCount<=pS_Retrieval->u16_LastSequenceCount));
+
+      if(b_Match)
+      {
+        if((uint32_t)SP_HEADER_SIZE+u16_Length>u32_BufferSize)
+        {
+          if(mu16_SkippedCount<0xffff)
+            mu16_SkippedCount++;
+        }
+        else if(u32_Written+SP_HEADER_SIZE+u16_Length>u32_BufferSize)
+          return u32_Written;
+        else
+        {
+          CCSDS::SpacePacket::createPrimaryHeader(&pu8_Buffer[u32_Written],
+                                                  (CCSDS::SpacePacket::PacketType)((au8_Hdr[RECORD_FLAGS_POS]>>7)&0x1),
+                                                  (CCSDS::SpacePacket::SequenceFlags)((au8_Hdr[RECORD_FLAGS_POS]>>4)&0x3),
+                                                  u16_APID, u16_SequenceCount, (au8_Hdr[RECORD_FLAGS_POS]&0x40)?true:false,
+                                                  u16_Length);
+          _read((pS_Retrieval->u32_Offset+RecordHdrSize)%mu32_RegionSize, &pu8_Buffer[u32_Written+SP_HEADER_SIZE], u16_Length);
+          u32_Written += SP_HEADER_SIZE+u16_Length;
+        }
+      }
+
+      pS_Retrieval->u32_RecordNr++;
+      pS_Retrieval->u32_Offset = (pS_Retrieval->u32_Offset+RecordHdrSize+u16_Length)%mu32_RegionSize;
+    }
+
+    pS_Retrieval->b_Complete = true;
+    return u32_Written;
+  }
+
+
+
+  /**
+   * @brief Deletes the oldest packets up to the given storage time, as done by the telecommand (15,10)
+   *
+   * @param u32_Time  The storage time of the last packet which shall be deleted
+   *
+   * @return The number of deleted packets
+   */
+  uint32_t PacketStore::deleteUntil(const uint32_t u32_Time)
+  {
+    uint32_t u32_Count = 0;
+    uint8_t au8_Time[4];
+
+    while(mu32_FirstRecordNr<mu32_NextRecordNr)
+    {
+      _read((mu32_Tail+RECORD_TIME_POS)%mu32_RegionSize, au8_Time, 4);
+      if((((uint32_t)au8_Time[0]<<24) | ((uint32_t)au8_Time[1]<<16) | ((uint32_t)au8_Time[2]<<8) | au8_Time[3])>u32_Time)
+        break;
+      _dropOldest();
+      u32_Count++;
+    }
+    return u32_Count;
+  }
+
+
+
+  /**
+   * @brief Returns if a downlink requested by (15,7) or (15,8) is running
+   *
+   * @return true, if generate() has packets to write
+   */
+  bool PacketStore::isDownlinking(void)
+  {
+    return !mS_Downlink.b_Complete;
+  }
+
+
+
+  /**
+   * @brief Aborts a running downlink; no completion report is sent
+   */
+  void PacketStore::abortDownlink(void)
+  {
+    mS_Downlink.b_Complete = true;
+  }
+
+
+
+  /**
+   * @brief Writes the next packets of the downlink requested by (15,7) or (15,8) into the given buffer
+   *
+   * The method works like retrieve() on the internal retrieval state. When the last packet was written, the
+   * completion report (1,7) is sent if it was requested and a Verification object is set.
+   *
+   * @param pu8_Buffer      A pointer to the buffer where the packets shall be stored
+   * @param u32_BufferSize  The available size of the buffer
+   *
+   * @return The number of bytes written into the buffer
+   */
+  uint32_t PacketStore::generate(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    uint32_t u32_Written;
+
+    if(mS_Downlink.b_Complete)
+      return 0;
+
+    u32_Written = retrieve(&mS_Downlink, pu8_Buffer, u32_BufferSize);
+    if(mS_Downlink.b_Complete && mb_DownlinkAckComp && mp_Verification)
+      mp_Verification->completionSuccess(mu32_DownlinkRequestID);
+    return u32_Written;
+  }
+
+
+
+  /**
+   * @brief Returns the number of stored packets
+   *
+   * @return Number of packets as uint32_t
+   */
+  uint32_t PacketStore::getPacketCount(void)
+  {
+    return mu32_NextRecordNr-mu32_FirstRecordNr;
+  }
+
+
+
+  /**
+   * @brief Returns the number of overflow errors
+   *
+   * Overflow errors occur if a packet is larger than the memory region of the store.
+   *
+   * If the number of overflow errors exceeds 65535, the method returns 65535.
+   *
+   * @return Number of overflow errors as uint16_t
+   */
+  uint16_t PacketStore::getOverflowErrorCount(void)
+  {
+    return mu16_OverflowErrorCount;
+  }
+
+
+
+  /**
+   * @brief Returns the number of retrieved packets which were skipped because they did not fit into the buffer
+   *
+   * If the number of skipped packets exceeds 65535, the method returns 65535.
+   *
+   * @return Number of skipped packets as uint16_t
+   */
+  uint16_t PacketStore::getSkippedCount(void)
+  {
+    return mu16_SkippedCount;
+  }
+
+
+
+  /**
+   * @brief Clears all error counters
+   */
+  void PacketStore::clearErrorCounters(void)
+  {
+    mu16_OverflowErrorCount = 0;
+    mu16_SkippedCount = 0;
+    return;
+  }
+
+
+
+  /**
+   * @brief Stores a received space packet with the time set by setTime()
+   *
+   * This method is called by the SpacePacket object; the parameters are the ones of
+   * SpacePacketActionInterface::onSpacePacketReceived().
+   */
+  void PacketStore::onSpacePacketReceived(const uint8_t u8_PacketType,
+                                          const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                                          const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                                          const uint8_t *pu8_PacketData, const uint16_t u16_PacketDataLength)
+  {
+    store(mu32_Time, u8_PacketType, u8_SequenceFlags, u16_APID, u16_SequenceCount, b_SecHeader,
+          pu8_PacketData, u16_PacketDataLength);
+  }
+
+
+
+  /**
+   * @brief Handles the telecommands of service 15
+   *
+   * This method is called by the Tc or TcRegistry object; the parameters are the ones of
+   * TcActionInterface::onTcReceived(). The application data starts with the packet store ID (8 bit). It is
+   * followed by the APID (16 bit) and the first and last sequence count (16 bit each) for subservice 7, by the
+   * start and end time (32 bit each) for subservice 8 and by the time (32 bit) for subservice 10.
+   *
+   * The completion of a downlink is reported when generate() wrote its last packet.
+   */
+  void PacketStore::onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                                 const uint8_t u8_Service, const uint8_t u8_SubService,
+                                 const uint8_t u8_SourceID,
+                                 const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    int32_t i32_FailureCode;
+
+    (void)b_AckAcc; (void)b_AckStart; (void)b_AckProg; (void)u8_SourceID;
+
+    if(u8_Service!=Tc::OnboardStorageAndRetrievalService)
+      return;
+
+    i32_FailureCode = _execute(u8_SubService, pu8_Data, u32_DataSize);
+    if(!i32_FailureCode && ((u8_SubService==DownlinkPacketRange) || (u8_SubService==DownlinkTimePeriod)))
+    {
+      mu32_DownlinkRequestID = mp_Verification?mp_Verification->getRequestID():0;
+      mb_DownlinkAckComp = b_AckComp;
+      return;
+    }
+    if(mp_Verification)
+    {
+      if(i32_FailureCode)
+        mp_Verification->completionFailure(mp_Verification->getRequestID(), (uint8_t)i32_FailureCode);
+      else if(b_AckComp)
+        mp_Verification->completionSuccess(mp_Verification->getRequestID());
+    }
+  }
+
+
+
+  int32_t PacketStore::_execute(const uint8_t u8_SubService, const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    if(!pu8_Data || (u32_DataSize<1))
+      return InvalidRequest;
+    if(pu8_Data[0]!=mu8_StoreID)
+      return UnknownStore;
+
+    switch(u8_SubService)
+    {
+    case EnableStorage:
+    case DisableStorage:
+      if(u32_DataSize!=1)
+        return InvalidRequest;
+      setStorageEnabled(u8_SubService==EnableStorage);
+      return 0;
+
+    case DownlinkPacketRange:
+      if(u32_DataSize!=7)
+        return InvalidRequest;
+      if(!mS_Downlink.b_Complete)
+        return DownlinkRunning;
+      startRetrieval(&mS_Downlink, (uint16_t)((pu8_Data[1]<<8) | pu8_Data[2]), 0, 0xffffffff,
+                     (uint16_t)((pu8_Data[3]<<8) | pu8_Data[4]), (uint16_t)((pu8_Data[5]<<8) | pu8_Data[6]));
+      return 0;
+
+    case DownlinkTimePeriod:
+      if(u32_DataSize!=9)
+        return InvalidRequest;
+      if(!mS_Downlink.b_Complete)
+        return DownlinkRunning;
+      startRetrieval(&mS_Downlink, AllAPIDs,
+                     ((uint32_t)pu8_Data[1]<<24) | ((uint32_t)pu8_Data[2]<<16) | ((uint32_t)pu8_Data[3]<<8) | pu8_Data[4],
+                     ((uint32_t)pu8_Data[5]<<24) | ((uint32_t)pu8_Data[6]<<16) | ((uint32_t)pu8_Data[7]<<8) | pu8_Data[8],
+                     0, 0x3fff);
+      return 0;
+
+    case DeleteUntilTime:
+      if(u32_DataSize!=5)
+        return InvalidRequest;
+      deleteUntil(((uint32_t)pu8_Data[1]<<24) | ((uint32_t)pu8_Data[2]<<16) | ((uint32_t)pu8_Data[3]<<8) | pu8_Data[4]);
+      return 0;
+
+    default:
+      return InvalidRequest;
+    }
+  }
+
+
+
+  void PacketStore::_write(uint32_t u32_Offset, const uint8_t *pu8_Data, uint32_t u32_Size)
+  {
+    uint32_t u32_Part = mu32_RegionSize-u32_Offset;
+
+    if(u32_Part>=u32_Size)
+    {
+      memcpy(&mpu8_Region[u32_Offset], pu8_Data, u32_Size);
+      return;
+    }
+    memcpy(&mpu8_Region[u32_Offset], pu8_Data, u32_Part);
+    memcpy(mpu8_Region, &pu8_Data[u32_Part], u32_Size-u32_Part);
+  }
+
+
+
+  void PacketStore::_read(uint32_t u32_Offset, uint8_t *pu8_Data, uint32_t u32_Size)
+  {
+    uint32_t u32_Part = mu32_RegionSize-u32_Offset;
+
+    if(u32_Part>=u32_Size)
+    {
+      memcpy(pu8_Data, &mpu8_Region[u32_Offset], u32_Size);
+      return;
+    }
+    memcpy(pu8_Data, &mpu8_Region[u32_Offset], u32_Part);
+    memcpy(&pu8_Data[u32_Part], mpu8_Region, u32_Size-u32_Part);
+  }
+
+
+
+  void PacketStore::_dropOldest(void)
+  {
+    uint8_t au8_Length[2];
+    uint32_t u32_RecordSize;
+
+    _read((mu32_Tail+RECORD_LENGTH_POS)%mu32_RegionSize, au8_Length, 2);
+    u32_RecordSize = RecordHdrSize+(((uint32_t)au8_Length[0]<<8) | au8_Length[1]);
+    mu32_Tail = (mu32_Tail+u32_RecordSize)%mu32_RegionSize;
+    mu32_Used -= u32_RecordSize;
+    mu32_FirstRecordNr++;
+
+    // index entries of partly overwritten blocks are not valid anymore
+    while(mu16_IndexCount>0 && (mu32_IndexFirstBlock*PUS_STORE_INDEX_INTERVAL<mu32_FirstRecordNr))
+    {
+      mu16_IndexTail = (uint16_t)((mu16_IndexTail+1)%PUS_STORE_INDEX_SIZE);
+      mu16_IndexCount--;
+      mu32_IndexFirstBlock++;
+    }
+  }
+
+
+
+  PacketStore::IndexEntry *PacketStore::_getIndexEntry(const uint32_t u32_Block)
+  {
+    if((mu16_IndexCount==0) || (u32_Block<mu32_IndexFirstBlock) || (u32_Block-mu32_IndexFirstBlock>=mu16_IndexCount))
+      return nullptr;
+    return &maS_Index[(mu16_IndexTail+(u32_Block-mu32_IndexFirstBlock))%PUS_STORE_INDEX_SIZE];
+  }
+
+
+
+  uint32_t PacketStore::_apidMask(const uint16_t u16_APID)
+  {
+    return (uint32_t)1<<((u16_APID^(u16_APID>>5))&0x1f);
+  }
+
+}
@@ -0,0 +1,196 @@
+/**
+ * @file      pus_packet_store.h
+ *
+ * @brief     Include file of the PUS packet store class (service 15)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+
+#ifndef _PUS_PACKET_STORE_H_
+#define _PUS_PACKET_STORE_H_
+
+/****************************************************************/
+/* Onboard Storage and Retrieval Service according to           */
+/*                                                              */
+/*  ECSS-E-70-41A - Ground systems and operations -             */
+/*                  Telemetry and telecommand packet            */
+/*                  utilization, service 15                     */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Only one packet store per object                          */
+/*  - The storage times must not decrease                       */
+/*  - Only the subservices 1, 2, 7, 8 and 10 are supported; the */
+/*    packet range of (15,7) is given by one APID and a range   */
+/*    of sequence counts                                        */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "ccsds_spacepacket.h"
+#include "pus_tc.h"
+#include "pus_verification.h"
+
+#ifdef configPUS_STORE_INDEX_SIZE
+#define PUS_STORE_INDEX_SIZE configPUS_STORE_INDEX_SIZE
+#else
+#define PUS_STORE_INDEX_SIZE 256
+#endif
+
+#ifdef configPUS_STORE_INDEX_INTERVAL
+#define PUS_STORE_INDEX_INTERVAL configPUS_STORE_INDEX_INTERVAL
+#else
+#define PUS_STORE_INDEX_INTERVAL 16
+#endif
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Class for storing space packets and retrieving them by APID, time range and sequence range (PUS service 15).
+   *
+   * The packets are appended to a circular memory region which is given by the caller; this can be a static
+   * buffer or a memory-mapped file. If the region is full, the oldest packets are overwritten. Each packet is
+   * stored with its primary header fields and the storage time.
+   *
+   * Every PUS_STORE_INDEX_INTERVAL packets, an entry is added to a sparse index which holds the position, the
+   * storage time of the first packet and a 32 bit mask of the APIDs within the block. A retrieval looks up the
+   * start block by time with a binary search and skips all blocks which do not contain the requested APID.
+   *
+   * The class implements the SpacePacketActionInterface, so it can be fed directly by a SpacePacket object.
+   * The retrieved packets are created with the SpacePacket header and written into a caller buffer, which can
+   * be handed over to TransferframeTm::create().
+   *
+   * The class also implements the TcActionInterface, so it can be registered at a TcRegistry for service 15:
+   * the storage can be enabled (15,1) and disabled (15,2), the packets of a sequence count range (15,7) or a
+   * time period (15,8) can be downlinked and the packets up to a storage time can be deleted (15,10). A
+   * downlink is written by generate(); if a Verification object is set, its completion is reported when the
+   * last packet was generated.
+   */
+  class PacketStore : public CCSDS::SpacePacketActionInterface, public TcActionInterface
+  {
+  public:
+    const static uint16_t AllAPIDs = 0xffff;    /**< APID filter value for retrieving packets of all APIDs */
+
+    enum SubService
+    {
+      EnableStorage = 1,
+      DisableStorage = 2,
+      DownlinkPacketRange = 7,
+      DownlinkTimePeriod = 8,
+      DeleteUntilTime = 10
+    };
+
+    /** Failure codes of the completion failure reports (1,8) */
+    enum FailureCode
+    {
+      InvalidRequest = 1,     /**< The application data of the telecommand has a wrong length */
+      UnknownStore = 2,       /**< The packet store ID does not match the one of this store */
+      DownlinkRunning = 3     /**< A downlink is requested while the previous downlink is not finished */
+    };
+
+    /**
+     * @brief State of a retrieval; the content is handled by the PacketStore
+     */
+    struct Retrieval
+    {
+      uint16_t u16_APID;
+      uint32_t u32_StartTime;
+      uint32_t u32_EndTime;
+      uint16_t u16_FirstSequenceCount;
+      uint16_t u16_LastSequenceCount;
+      uint32_t u32_RecordNr;
+      uint32_t u32_Offset;
+      bool b_Complete;
+    };
+
+  private:
+    const static uint8_t RecordHdrSize = 11;
+
+    struct IndexEntry
+    {
+      uint32_t u32_Offset;
+      uint32_t u32_Time;
+      uint32_t u32_ApidMask;
+    };
+
+    uint8_t *mpu8_Region;
+    uint32_t mu32_RegionSize;
+    uint32_t mu32_Tail;
+    uint32_t mu32_Used;
+    uint32_t mu32_FirstRecordNr;
+    uint32_t mu32_NextRecordNr;
+
+    IndexEntry maS_Index[PUS_STORE_INDEX_SIZE];
+    uint16_t mu16_IndexTail;
+    uint16_t mu16_IndexCount;
+    uint32_t mu32_IndexFirstBlock;
+
+    uint32_t mu32_Time;
+    uint8_t mu8_StoreID;
+    bool mb_StorageEnabled;
+    uint16_t mu16_OverflowErrorCount;
+    uint16_t mu16_SkippedCount;
+
+    // downlink requested by telecommand
+    Retrieval mS_Downlink;
+    uint32_t mu32_DownlinkRequestID;
+    bool mb_DownlinkAckComp;
+
+    Verification *mp_Verification;
+
+  public:
+    PacketStore(uint8_t *pu8_Region, const uint32_t u32_RegionSize, const uint8_t u8_StoreID = 0);
+
+    void clear(void);
+    void setTime(const uint32_t u32_CurrentTime);
+    void setStorageEnabled(const bool b_Enabled);
+    void setVerification(Verification *p_Verification);
+
+    int32_t store(const uint32_t u32_Time, const uint8_t u8_PacketType,
+                  const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                  const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                  const uint8_t *pu8_PacketData, const uint16_t u16_PacketDataLength);
+
+    int32_t startRetrieval(Retrieval *pS_Retrieval, const uint16_t u16_APID,
+                           const uint32_t u32_StartTime, const uint32_t u32_EndTime,
+                           const uint16_t u16_FirstSequenceCount = 0, const uint16_t u16_LastSequenceCount = 0x3fff);
+    uint32_t retrieve(Retrieval *pS_Retrieval, uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+    uint32_t deleteUntil(const uint32_t u32_Time);
+
+    bool isDownlinking(void);
+    void abortDownlink(void);
+    uint32_t generate(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+
+    uint32_t getPacketCount(void);
+    uint16_t getOverflowErrorCount(void);
+    uint16_t getSkippedCount(void);
+    void clearErrorCounters(void);
+
+    void onSpacePacketReceived(const uint8_t u8_PacketType,
+                               const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                               const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                               const uint8_t *pu8_PacketData, const uint16_t u16_PacketDataLength);
+
+    void onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                      const uint8_t u8_Service, const uint8_t u8_SubService,
+                      const uint8_t u8_SourceID,
+                      const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+
+  private:
+    void _write(uint32_t u32_Offset, const uint8_t *pu8_Data, uint32_t u32_Size);
+    void _read(uint32_t u32_Offset, uint8_t *pu8_Data, uint32_t u32_Size);
+    void _dropOldest(void);
+    int32_t _execute(const uint8_t u8_SubService, const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+    IndexEntry *_getIndexEntry(const uint32_t u32_Block);
+    static uint32_t _apidMask(const uint16_t u16_APID);
+  };
+
+}
+
+#endif // _PUS_PACKET_STORE_H_
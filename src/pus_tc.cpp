@@ -11,6 +11,9 @@
 #include <string.h>
 
 #include "pus_tc.h"
+#include "pus_verification.h"
+#include "ccsds_spacepacket.h"
+#include "ccsds_transferframe.h"
 
 
 #define DATA_FIELD_HDR_FLAGS_POS      0
@@ -26,7 +29,6 @@
 #define DATA_FIELD_HDR_SPARE_POS      4
 
 
-
 namespace PUS 
 {
 
@@ -36,7 +38,10 @@ namespace PUS
    * @param p_ActionInterface   A pointer to the implementation of the action interface
    */
   Tc::Tc(const uint8_t u8_SecHdrSize, TcActionInterface *p_ActionInterface)
-    : mp_ActionInterface{p_ActionInterface}
+    : me_ChecksumType{ChecksumType::None}
+    , mu16_ChecksumErrorCount{0}
+    , mp_ActionInterface{p_ActionInterface}
+    , mp_Verification{nullptr}
   {
     if(u8_SecHdrSize>=MinSecHdrSize)
       mu8_SecHdrSize = u8_SecHdrSize;
@@ -53,7 +58,10 @@ namespace PUS
    */
   Tc::Tc(TcActionInterface *p_ActionInterface)
     : mu8_SecHdrSize{PUS_TC_DEFAULT_SEC_HEADER_SIZE}
+    , me_ChecksumType{ChecksumType::None}
+    , mu16_ChecksumErrorCount{0}
     , mp_ActionInterface{p_ActionInterface}
+    , mp_Verification{nullptr}
   {
   }
 
@@ -70,6 +78,42 @@ namespace PUS
   }
 
 
+
+  /**
+   * @brief Sets the packet error control which is expected for received telecommands
+   *
+   * If the checksum type is ChecksumType::StandardCRC, the last two bytes of each telecommand
+   * are treated as Packet Error Control (PEC) field. Telecommands with a wrong PEC are discarded
+   * and counted as checksum errors. The PEC covers the complete packet including the primary header,
+   * so the telecommands must be processed with the process() method which takes the
+   * primary header fields.
+   *
+   * @param e_ChecksumType  The checksum algorithm (default: ChecksumType::None)
+   */
+  void Tc::setChecksumType(const enum ChecksumType e_ChecksumType)
+  {
+    me_ChecksumType = e_ChecksumType;
+  }
+
+
+
+  /**
+   * @brief Sets the verification service which sends the acceptance reports
+   *
+   * The acceptance reports are sent by process() without waiting for the action interface: telecommands
+   * with a wrong length or PEC are answered with an acceptance failure report (1,2), valid telecommands
+   * with an acceptance success report (1,1) if requested. Since the request ID of the reports is taken from
+   * the primary header, the telecommands shall be processed with the process() method which takes the
+   * primary header fields.
+   *
+   * @param p_Verification  A pointer to the verification service, or nullptr to disable the reports
+   */
+  void Tc::setVerification(Verification *p_Verification)
+  {
+    mp_Verification = p_Verification;
+  }
+
+
   
   /**
    * @brief Creates a Telecommand and writes it into the given buffer
@@ -87,10 +131,14 @@ namespace PUS
    * @param u8_SourceID           The source ID of the command
    * @param pu8_Data              Command data (parameters)
    * @param u32_DataSize          The size of the command data
-   * @param e_ChecksumType        The checksum algorithm
+   * @param e_ChecksumType        The checksum algorithm (default: ChecksumType::None); for ChecksumType::StandardCRC,
+   *                              two additional bytes are reserved at the end of the data buffer for the Packet Error
+   *                              Control (PEC) field. Since the PEC covers the primary header, which is not known here,
+   *                              the field is only a placeholder: it must be filled in with updateCRC() after the space
+   *                              packet is created. Only createPacket() and updateCRC() produce a valid PEC.
    *
    * @retval 0  No packet could be created
-   * @return The size of the created data (without header)
+   * @return The size of the created data (without header, but with PEC field)
    */
   uint32_t Tc::create(uint8_t *pu8_SecHdrBuffer, const uint32_t u32_SecHdrSize,
                       uint8_t *pu8_PacketDataBuffer, const uint32_t u32_PacketDataSize,
@@ -102,27 +150,138 @@ namespace PUS
   {
     if(!pu8_SecHdrBuffer || (u32_SecHdrSize<MinSecHdrSize))
       return 0;
-    if(!pu8_PacketDataBuffer || (u32_PacketDataSize<u32_DataSize))
+    if(!pu8_PacketDataBuffer || (u32_PacketDataSize<u32_DataSize+((e_ChecksumType==ChecksumType::StandardCRC)?CrcSize:0)))
       return 0;
     if(!pu8_Data)
       return 0;
     
-    pu8_SecHdrBuffer[DATA_FIELD_HDR_FLAGS_POS] = (uint8_t)((((uint8_t)(CcsdsSecHeaderFlag::Custom)&0x1)<<7) 
+    _create_secondary_header(pu8_SecHdrBuffer, u32_SecHdrSize,
+                             b_AckAcc, b_AckStart, b_AckProg, b_AckComp,
+                             u8_Service, u8_SubService, u8_SourceID);
+    
+    memcpy(pu8_PacketDataBuffer, pu8_Data, u32_DataSize);
+    
+    if(e_ChecksumType==ChecksumType::StandardCRC)
+    {
+      pu8_PacketDataBuffer[u32_DataSize] = 0;
+      pu8_PacketDataBuffer[u32_DataSize+1] = 0;
+      return u32_DataSize+CrcSize;
+    }
+    return u32_DataSize;
+  }
+
+
+
+  /**
+   * @brief Creates a complete Telecommand Space Packet and writes it into the given buffer
+   *
+   * In contrast to create(), the primary header of the space packet is also generated. This way, the
+   * Packet Error Control (PEC) field can be calculated while the data is copied into the buffer.
+   *
+   * @param pu8_Buffer            A pointer to the buffer where the packet shall be stored
+   * @param u32_BufferSize        The available size of the buffer
+   * @param u16_APID              The application identifier (APID) of the target application
+   * @param u16_SequenceCount     The 14-bit sequence counter, handled by the calling context
+   * @param b_AckAcc              Flag if an Acceptence Report is requested
+   * @param b_AckStart            Flag if an Execution Start Report is requested
+   * @param b_AckProg             Flag if an Execution Progress Report is requested
+   * @param b_AckComp             Flag if an Execution Complete Report is requested
+   * @param u8_Service            The service ID of the command
+   * @param u8_SubService         The Subservice ID of the command
+   * @param u8_SourceID           The source ID of the command
+   * @param pu8_Data              Command data (parameters)
+   * @param u32_DataSize          The size of the command data
+   * @param u8_SecHdrSize         The size of the data field header (at least 4)
+   * @param e_ChecksumType        The checksum algorithm
+   *
+   * @retval 0  No packet could be created
+   * @return The size of the created packet in bytes as uint32_t
+   */
+  uint32_t Tc::createPacket(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                            const uint16_t u16_APID, const uint16_t u16_SequenceCount,
+                            const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                            const uint8_t u8_Service, const uint8_t u8_SubService,
+                            const uint8_t u8_SourceID,
+                            const uint8_t *pu8_Data, const uint32_t u32_DataSize,
+                            const uint8_t u8_SecHdrSize,
+                            const enum ChecksumType e_ChecksumType)
+  {
+    uint32_t u32_CrcSize = (e_ChecksumType==ChecksumType::StandardCRC)?CrcSize:0;
+    uint32_t u32_PacketDataLength = u8_SecHdrSize+u32_DataSize+u32_CrcSize;
+    uint16_t u16_Syndrome;
+    uint8_t *pu8_Dst;
+    
+    if(!pu8_Buffer || (u8_SecHdrSize<MinSecHdrSize) || (u32_DataSize>0 && !pu8_Data))
+      return 0;
+    if((u32_PacketDataLength>0x10000UL) || (u32_BufferSize<PrimaryHdrSize+u32_PacketDataLength))
+      return 0;
+    
+    CCSDS::SpacePacket::createPrimaryHeader(pu8_Buffer, CCSDS::SpacePacket::TC, CCSDS::SpacePacket::Unsegmented,
+                                            u16_APID, u16_SequenceCount, true, u32_PacketDataLength);
+    _create_secondary_header(&pu8_Buffer[PrimaryHdrSize], u8_SecHdrSize,
+                             b_AckAcc, b_AckStart, b_AckProg, b_AckComp,
+                             u8_Service, u8_SubService, u8_SourceID);
+    
+    pu8_Dst = &pu8_Buffer[PrimaryHdrSize+u8_SecHdrSize];
+    memcpy(pu8_Dst, pu8_Data, u32_DataSize);
+    if(u32_CrcSize)
+    {
+      u16_Syndrome = calcCRC(pu8_Buffer, PrimaryHdrSize+u8_SecHdrSize+u32_DataSize);
+      pu8_Dst[u32_DataSize] = (uint8_t)(u16_Syndrome>>8);
+      pu8_Dst[u32_DataSize+1] = (uint8_t)(u16_Syndrome&0xff);
+    }
+    
+    return PrimaryHdrSize+u32_PacketDataLength;
+  }
+
+
+
+  /**
+   * @brief Calculates the Packet Error Control (PEC) of a complete packet and writes it into the last two bytes
+   *
+   * This is needed if the telecommand was created with create() and ChecksumType::StandardCRC,
+   * after the space packet has been assembled with SpacePacket::create().
+   *
+   * @param pu8_Packet      A pointer to the complete space packet (including primary header)
+   * @param u32_PacketSize  The size of the packet including the PEC field
+   *
+   * @retval  0   If the PEC was written
+   * @retval -1   If the packet is too small or pu8_Packet is nullptr
+   */
+  int32_t Tc::updateCRC(uint8_t *pu8_Packet, const uint32_t u32_PacketSize)
+  {
+    uint16_t u16_CRC;
+    
+    if(!pu8_Packet || (u32_PacketSize<PrimaryHdrSize+MinSecHdrSize+CrcSize) || (u32_PacketSize>PrimaryHdrSize+0x10000UL))
+      return -1;
+    
+    u16_CRC = calcCRC(pu8_Packet, u32_PacketSize-CrcSize);
+    pu8_Packet[u32_PacketSize-2] = (uint8_t)(u16_CRC>>8);
+    pu8_Packet[u32_PacketSize-1] = (uint8_t)(u16_CRC&0xff);
+    return 0;
+  }
+  
+  
+  
+  int32_t Tc::_create_secondary_header(uint8_t *pu8_Buffer, const uint32_t u32_SecHdrSize,
+                                       const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                                       const uint8_t u8_Service, const uint8_t u8_SubService,
+                                       const uint8_t u8_SourceID)
+  {
+    pu8_Buffer[DATA_FIELD_HDR_FLAGS_POS] = (uint8_t)((((uint8_t)(CcsdsSecHeaderFlag::Custom)&0x1)<<7) 
                                     | (uint8_t)((PacketVersion&0x7)<<DFH_PUS_VERSION_POS)
                                     | ((b_AckAcc?1:0)<<DFH_FLAG_ACK_ACC_POS) 
                                     | ((b_AckStart?1:0)<<DFH_FLAG_ACK_START_POS) 
                                     | ((b_AckProg?1:0)<<DFH_FLAG_ACK_PROG_POS) 
                                     | ((b_AckComp?1:0)<<DFH_FLAG_ACK_COMP_POS));
-    pu8_SecHdrBuffer[DATA_FIELD_HDR_SERVICE_POS] = u8_Service;
-    pu8_SecHdrBuffer[DATA_FIELD_HDR_SUBSERVICE_POS] = u8_SubService;
+    pu8_Buffer[DATA_FIELD_HDR_SERVICE_POS] = u8_Service;
+    pu8_Buffer[DATA_FIELD_HDR_SUBSERVICE_POS] = u8_SubService;
     if(u32_SecHdrSize>DATA_FIELD_HDR_SOURCEID_POS)
-      pu8_SecHdrBuffer[DATA_FIELD_HDR_SOURCEID_POS] = u8_SourceID;
+      pu8_Buffer[DATA_FIELD_HDR_SOURCEID_POS] = u8_SourceID;
     for(uint32_t i=DATA_FIELD_HDR_SPARE_POS; i<u32_SecHdrSize; i++)
-      pu8_SecHdrBuffer[i] = 0;
-    
-    memcpy(pu8_PacketDataBuffer, pu8_Data, u32_DataSize);
+      pu8_Buffer[i] = 0;
     
-    return u32_DataSize;
+    return (int32_t)u32_SecHdrSize;
   }
   
   
@@ -133,13 +292,109 @@ namespace PUS
    * The method can only handle complete telecommands.
    * With the extracted information from the data buffer, the function p_PusTcCallback is called.
    *
+   * Since the Packet Error Control (PEC) covers the primary header of the space packet, telecommands
+   * with PEC (see setChecksumType()) must be processed with the overloaded method which takes the
+   * primary header fields.
+   *
    * @param pu8_Buffer      The data buffer which is to extract
    * @param u32_BufferSize  The size of the data buffer
    *
    * @retval  0   If the buffer was extracted successfully
    * @retval -1   If fhe u32_BufferSize is 0 or the pu8_Buffer is nullptr
+   * @retval -2   If a PEC is expected, which cannot be verified without the primary header
+   * @retval -3   If the telecommand was rejected by the verification service
    */
   int32_t Tc::process(const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    return _process(nullptr, pu8_Buffer, u32_BufferSize, 0);
+  }
+
+
+
+  /**
+   * @brief The given packet data field of a space packet is processed.
+   *
+   * The parameters match the ones of SpacePacketActionInterface::onSpacePacketReceived(), so the
+   * received space packets can be forwarded directly. The primary header is rebuilt from the given
+   * fields, which allows to verify the Packet Error Control (PEC) while the packet is processed.
+   * Telecommands with a wrong PEC are discarded before the action interface is called.
+   *
+   * @param u8_PacketType       The packet type (TM or TC)
+   * @param u8_SequenceFlags    The sequence flags
+   * @param u16_APID            The application ID
+   * @param u16_SequenceCount   The sequence count of the packet
+   * @param b_SecHeader         The secondary header flag of the packet
+   * @param pu8_Buffer          The packet data field which is to extract
+   * @param u32_BufferSize      The size of the packet data field
+   *
+   * @retval  0   If the buffer was extracted successfully
+   * @retval -1   If fhe u32_BufferSize is too small or the pu8_Buffer is nullptr
+   * @retval -2   If the PEC does not match
+   * @retval -3   If the telecommand was rejected by the verification service
+   */
+  int32_t Tc::process(const uint8_t u8_PacketType,
+                      const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                      const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                      const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize)
+  {
+    uint8_t au8_PrimaryHeader[PrimaryHdrSize];
+    uint16_t u16_Syndrome = 0;
+    
+    if((u32_BufferSize==0) || (u32_BufferSize>0x10000UL))
+      return -1;
+    
+    CCSDS::SpacePacket::createPrimaryHeader(au8_PrimaryHeader, (CCSDS::SpacePacket::PacketType)(u8_PacketType&0x1),
+                                            (CCSDS::SpacePacket::SequenceFlags)(u8_SequenceFlags&0x3),
+                                            u16_APID, u16_SequenceCount, b_SecHeader, u32_BufferSize);
+    if(pu8_Buffer && (me_ChecksumType==ChecksumType::StandardCRC))
+      u16_Syndrome = calcCRC(pu8_Buffer, u32_BufferSize, calcCRC(au8_PrimaryHeader, PrimaryHdrSize));
+    return _process(au8_PrimaryHeader, pu8_Buffer, u32_BufferSize, u16_Syndrome);
+  }
+  
+  
+  
+  /**
+   * @brief The given packet data field of a space packet is processed with the checksum of the space packet parser
+   *
+   * Like the method above, but the Packet Error Control (PEC) is verified with the syndrome which was calculated
+   * while the packet was parsed (see CCSDS::SpacePacket::setCrcCalculation() and CCSDS::SpacePacket::getCrcSyndrome()),
+   * so the packet is not read again.
+   *
+   * @param u8_PacketType       The packet type (TM or TC)
+   * @param u8_SequenceFlags    The sequence flags
+   * @param u16_APID            The application ID
+   * @param u16_SequenceCount   The sequence count of the packet
+   * @param b_SecHeader         The secondary header flag of the packet
+   * @param pu8_Buffer          The packet data field which is to extract
+   * @param u32_BufferSize      The size of the packet data field
+   * @param u16_Syndrome        The CRC-16 syndrome over the complete packet including the PEC
+   *
+   * @retval  0   If the buffer was extracted successfully
+   * @retval -1   If fhe u32_BufferSize is too small or the pu8_Buffer is nullptr
+   * @retval -2   If the PEC does not match
+   * @retval -3   If the telecommand was rejected by the verification service
+   */
+  int32_t Tc::process(const uint8_t u8_PacketType,
+                      const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                      const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                      const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                      const uint16_t u16_Syndrome)
+  {
+    uint8_t au8_PrimaryHeader[PrimaryHdrSize];
+    
+    if((u32_BufferSize==0) || (u32_BufferSize>0x10000UL))
+      return -1;
+    
+    CCSDS::SpacePacket::createPrimaryHeader(au8_PrimaryHeader, (CCSDS::SpacePacket::PacketType)(u8_PacketType&0x1),
+                                            (CCSDS::SpacePacket::SequenceFlags)(u8_SequenceFlags&0x3),
+                                            u16_APID, u16_SequenceCount, b_SecHeader, u32_BufferSize);
+    return _process(au8_PrimaryHeader, pu8_Buffer, u32_BufferSize, u16_Syndrome);
+  }
+  
+  
+  
+  int32_t Tc::_process(const uint8_t *pu8_PrimaryHeader, const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                       const uint16_t u16_Syndrome)
   {
     bool b_AckAcc;
     bool b_AckStart;
@@ -148,9 +403,30 @@ namespace PUS
     uint8_t u8_Service;
     uint8_t u8_SubService;
     uint8_t u8_SourceID = 0;
+    uint32_t u32_CrcSize = (me_ChecksumType==ChecksumType::StandardCRC)?CrcSize:0;
     
-    if((u32_BufferSize<MinSecHdrSize) || (u32_BufferSize<mu8_SecHdrSize))
+    if(!pu8_Buffer || (u32_BufferSize<MinSecHdrSize) || (u32_BufferSize<mu8_SecHdrSize+u32_CrcSize))
+    {
+      if(mp_Verification && pu8_Buffer)
+        mp_Verification->reject(pu8_PrimaryHeader, AcceptanceFailureCode::InvalidLength);
       return -1;
+    }
+    
+    if(u32_CrcSize)
+    {
+      if(!pu8_PrimaryHeader)
+        return -2;
+      
+      // the syndrome over header and packet data field, including the PEC itself, is zero for a valid packet
+      if(u16_Syndrome!=0)
+      {
+        if(mu16_ChecksumErrorCount<0xffff)
+          mu16_ChecksumErrorCount++;
+        if(mp_Verification)
+          mp_Verification->reject(pu8_PrimaryHeader, AcceptanceFailureCode::IncorrectChecksum);
+        return -2;
+      }
+    }
     
     b_AckAcc   = (pu8_Buffer[DATA_FIELD_HDR_FLAGS_POS]&(1<<DFH_FLAG_ACK_ACC_POS))?true:false;
     b_AckStart = (pu8_Buffer[DATA_FIELD_HDR_FLAGS_POS]&(1<<DFH_FLAG_ACK_START_POS))?true:false;
@@ -161,39 +437,82 @@ namespace PUS
     if(mu8_SecHdrSize>=DATA_FIELD_HDR_SOURCEID_POS)
       u8_SourceID = pu8_Buffer[DATA_FIELD_HDR_SOURCEID_POS];
     
+    // the acceptance report is sent before the telecommand is handled by the application
+    if(mp_Verification && !mp_Verification->accept(pu8_PrimaryHeader, b_AckAcc, u8_Service, u8_SubService, u8_SourceID))
+      return -3;
+    
     if(nullptr!=mp_ActionInterface)
     {
       mp_ActionInterface->onTcReceived(b_AckAcc, b_AckStart, b_AckProg, b_AckComp,
                                        u8_Service, u8_SubService, u8_SourceID,
-                                       &pu8_Buffer[mu8_SecHdrSize], u32_BufferSize-mu8_SecHdrSize);
+                                       &pu8_Buffer[mu8_SecHdrSize], u32_BufferSize-mu8_SecHdrSize-u32_CrcSize);
     }
     return 0;
   }
   
   
   
-  uint16_t Tc::calcCRC(const uint8_t *pu8_Buffer, const uint16_t u16_BufferSize)
+  /**
+   * @brief Returns the number of checksum errors
+   *
+   * Checksum errors occur if a Packet Error Control (PEC) is expected and the calculated
+   * checksum of the telecommand does not match the received one.
+   *
+   * If the number of checksum errors exceeds 65535, the method returns 65535.
+   *
+   * @return Number of checksum errors as uint16_t
+   */
+  uint16_t Tc::getChecksumErrorCount(void)
+  {
+    return mu16_ChecksumErrorCount;
+  }
+  
+  
+  
+  /**
+   * @brief Clears all error counters
+   */
+  void Tc::clearErrorCounters(void)
+  {
+    mu16_ChecksumErrorCount=0;
+    return;
+  }
+  
+  
+  
+  /**
+   * @brief Calculates the Packet Error Control (PEC) checksum (CRC-16, polynom 0x1021)
+   *
+   * The PEC is the same checksum as the Frame Error Control Field, see CCSDS::Transferframe::calcCRC().
+   *
+   * @param pu8_Buffer      The data buffer
+   * @param u32_BufferSize  The size of the data buffer
+   * @param u16_Syndrome    The initial syndrome; the result of a previous call can be given to continue a calculation
+   *
+   * @return The checksum as uint16_t
+   */
+  uint16_t Tc::calcCRC(const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint16_t u16_Syndrome)
   {
-    uint16_t u16_Syndrome=0xffff;
-    uint8_t u8_Data;
+    return CCSDS::Transferframe::calcCRC(pu8_Buffer, u32_BufferSize, u16_Syndrome);
+  }
+
+
+
+  /**
+   * @brief Verifies the length and the Packet Error Control (PEC) of the telecommand
+   *
+   * @return true if the packet can be read with the getters of the view
+   */
+  bool TcView::isValid(void) const
+  {
+    if(!mpu8_Packet || (mu8_SecHdrSize<MinSecHdrSize) || (mu32_Size<(uint32_t)PrimaryHdrSize+mu8_SecHdrSize+mu8_CrcSize)
+       || (mu32_Size>PrimaryHdrSize+0x10000UL))
+      return false;
     
-    for(uint16_t i=0; i<u16_BufferSize; i++)
-    {
-      u8_Data = pu8_Buffer[i];
-      for(uint8_t j=0; j<8; j++)
-      {
-        if((u8_Data&0x80)^((u16_Syndrome&0x8000)>>8))
-        {
-          u16_Syndrome = (uint16_t)((u16_Syndrome<<1)^0x1021);
-        }
-        else
-        {
-          u16_Syndrome <<= 1;
-        }
-        u8_Data <<= 1;
-      }
-    }
-    return (u16_Syndrome);
+    // the syndrome over the packet including the PEC is zero for a valid packet
+    if(mu8_CrcSize && (Tc::calcCRC(mpu8_Packet, mu32_Size)!=0))
+      return false;
+    return true;
   }
 
 }
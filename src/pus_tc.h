@@ -27,7 +27,9 @@
 namespace PUS 
 {
   
-  
+  class Verification;
+
+
   /**
    * @brief Interface class for handling PUS tc packet actions
    */
@@ -64,6 +66,14 @@ namespace PUS
    * Beside the description of the structure of space packets, the ECSS-E-70-41A also describes the inner
    * structure of telecommand space packets. This class implements this inner struture. It handles the service
    * and the subservice as well as the acknowledges for a command.
+   *
+   * The optional Packet Error Control (PEC) field covers the complete packet including the primary header of
+   * the space packet. It is generated by createPacket() and verified by process() if a checksum type is set.
+   * If the SpacePacket parser calculates the checksum (see CCSDS::SpacePacket::setCrcCalculation()), its syndrome
+   * can be given to process(), so the packet is not read twice.
+   *
+   * If a Verification object is set, the acceptance reports (1,1) and (1,2) are sent directly after the
+   * telecommand was validated, before it is forwarded to the action interface.
    */
   class Tc
   {
@@ -105,17 +115,37 @@ namespace PUS
       OnboardOperationsProcedureService             = 18,
       EventActionService                            = 19
     };
+
+    /** Failure codes of the telecommand acceptance report (1,2) */
+    enum AcceptanceFailureCode
+    {
+      IllegalAPID                 = 0,
+      InvalidLength               = 1,
+      IncorrectChecksum           = 2,
+      IllegalPacketType           = 3,  /**< The service type is not supported */
+      IllegalPacketSubType        = 4,  /**< The service subtype is not supported */
+      IllegalApplicationData      = 5,
+      IllegalSource               = 6   /**< Mission specific: the source ID is not allowed */
+    };
         
   private:  
+    const static uint8_t PrimaryHdrSize = 6;
+    const static uint8_t CrcSize = 2;
+
     uint8_t mu8_SecHdrSize;
+    enum ChecksumType me_ChecksumType;
+    uint16_t mu16_ChecksumErrorCount;
   
     TcActionInterface *mp_ActionInterface;
+    Verification *mp_Verification;
     
   public:
     Tc(const uint8_t u8_SecdrSize = PUS_TC_DEFAULT_SEC_HEADER_SIZE, TcActionInterface *p_ActionInterface = nullptr);
     Tc(TcActionInterface *p_ActionInterface = nullptr);
     
     void setActionInterface(TcActionInterface *p_ActionInterface);
+    void setChecksumType(const enum ChecksumType e_ChecksumType);
+    void setVerification(Verification *p_Verification);
   
     static uint32_t create(uint8_t *pu8_SecHdrBuffer, const uint32_t u32_SecHdrSize,
                            uint8_t *pu8_PacketDataBuffer, const uint32_t u32_PacketDataSize,
@@ -123,19 +153,85 @@ namespace PUS
                            const uint8_t u8_Service, const uint8_t u8_SubService,
                            const uint8_t u8_SourceID,
                            const uint8_t *pu8_Data, const uint32_t u32_DataSize,
-                           const enum ChecksumType e_ChecksumType = ChecksumType::StandardCRC);
+                           const enum ChecksumType e_ChecksumType = ChecksumType::None);
+
+    static uint32_t createPacket(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                 const uint16_t u16_APID, const uint16_t u16_SequenceCount,
+                                 const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                                 const uint8_t u8_Service, const uint8_t u8_SubService,
+                                 const uint8_t u8_SourceID,
+                                 const uint8_t *pu8_Data, const uint32_t u32_DataSize,
+                                 const uint8_t u8_SecHdrSize = PUS_TC_DEFAULT_SEC_HEADER_SIZE,
+                                 const enum ChecksumType e_ChecksumType = ChecksumType::StandardCRC);
+
+    static int32_t updateCRC(uint8_t *pu8_Packet, const uint32_t u32_PacketSize);
     
     // sp processing
     int32_t process(const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+    int32_t process(const uint8_t u8_PacketType,
+                    const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                    const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                    const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize);
+    int32_t process(const uint8_t u8_PacketType,
+                    const uint8_t u8_SequenceFlags, const uint16_t u16_APID,
+                    const uint16_t u16_SequenceCount, const bool b_SecHeader,
+                    const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                    const uint16_t u16_Syndrome);
+
+    uint16_t getChecksumErrorCount(void);
+    void clearErrorCounters(void);
     
   private:
-    static int32_t _create_secondary_header(uint8_t *pu8_Buffer,
+    int32_t _process(const uint8_t *pu8_PrimaryHeader, const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                     const uint16_t u16_Syndrome);
+
+    static int32_t _create_secondary_header(uint8_t *pu8_Buffer, const uint32_t u32_SecHdrSize,
                                             const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
                                             const uint8_t u8_Service, const uint8_t u8_SubService,
-                                            const uint8_t u8_SourceID, const uint16_t u16_Spare);
+                                            const uint8_t u8_SourceID);
     
   public:
-    static uint16_t calcCRC(const uint8_t *pu8_Buffer, const uint16_t u16_BufferSize);
+    static uint16_t calcCRC(const uint8_t *pu8_Buffer, const uint32_t u32_BufferSize, const uint16_t u16_Syndrome = 0xffff);
+  };
+  
+
+
+  /**
+   * @brief View of a telecommand space packet in a buffer, as alternative to Tc::process() and the TcActionInterface
+   *
+   * The view holds a pointer to the complete packet (e.g. CCSDS::SpacePacketView::getPacket()); the fields of
+   * the data field header are decoded when they are read. isValid() verifies the length and, like Tc with
+   * ChecksumType::StandardCRC, the PEC; no verification reports are sent.
+   */
+  class TcView
+  {
+  private:
+    const static uint8_t PrimaryHdrSize = 6;
+    const static uint8_t MinSecHdrSize = 4;
+    const static uint8_t CrcSize = 2;
+
+    const uint8_t *mpu8_Packet;
+    uint32_t mu32_Size;
+    uint8_t mu8_SecHdrSize;
+    uint8_t mu8_CrcSize;
+
+  public:
+    TcView(const uint8_t *pu8_Packet, const uint32_t u32_PacketSize,
+           const uint8_t u8_SecHdrSize = PUS_TC_DEFAULT_SEC_HEADER_SIZE,
+           const enum Tc::ChecksumType e_ChecksumType = Tc::ChecksumType::None)
+      : mpu8_Packet{pu8_Packet}, mu32_Size{u32_PacketSize}, mu8_SecHdrSize{u8_SecHdrSize}
+      , mu8_CrcSize{(uint8_t)((e_ChecksumType==Tc::ChecksumType::StandardCRC)?CrcSize:0)} {}
+
+    bool isValid(void) const;
+    bool isAckAcc(void) const { return (mpu8_Packet[PrimaryHdrSize]&0x01)?true:false; }
+    bool isAckStart(void) const { return (mpu8_Packet[PrimaryHdrSize]&0x02)?true:false; }
+    bool isAckProg(void) const { return (mpu8_Packet[PrimaryHdrSize]&0x04)?true:false; }
+    bool isAckComp(void) const { return (mpu8_Packet[PrimaryHdrSize]&0x08)?true:false; }
+    uint8_t getService(void) const { return mpu8_Packet[PrimaryHdrSize+1]; }
+    uint8_t getSubService(void) const { return mpu8_Packet[PrimaryHdrSize+2]; }
+    uint8_t getSourceID(void) const { return (mu8_SecHdrSize>3)?mpu8_Packet[PrimaryHdrSize+3]:0; }
+    const uint8_t *getData(void) const { return &mpu8_Packet[PrimaryHdrSize+mu8_SecHdrSize]; }
+    uint32_t getDataSize(void) const { return mu32_Size-PrimaryHdrSize-mu8_SecHdrSize-mu8_CrcSize; }
   };
   
 }
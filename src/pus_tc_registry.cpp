@@ -0,0 +1,260 @@
+/**
+ * @file      pus_tc_registry.cpp
+ *
+ * @brief     Source file of the PUS TC registry class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "pus_tc_registry.h"
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Construct a new TcRegistry object
+   *
+   * Initially, no handlers are registered and all sources are allowed.
+   *
+   * @param p_ActionInterface   A pointer to the implementation of the action interface for rejected telecommands
+   */
+  TcRegistry::TcRegistry(TcRegistryActionInterface *p_ActionInterface)
+    : mu8_ServiceCount{0}
+    , mu16_RejectionCount{0}
+    , mp_ActionInterface{p_ActionInterface}
+  {
+    memset(mau8_ServiceRow, NoService, sizeof(mau8_ServiceRow));
+    memset(mapp_Handler, 0, sizeof(mapp_Handler));
+    memset(mau8_SourceFilter, 0xff, sizeof(mau8_SourceFilter));
+  }
+
+
+
+  /**
+   * @brief Sets the action class which is used to call the methods when a telecommand is rejected
+   *
+   * @param p_ActionInterface A pointer to the implementation of the action interface
+   */
+  void TcRegistry::setActionInterface(TcRegistryActionInterface *p_ActionInterface)
+  {
+    mp_ActionInterface = p_ActionInterface;
+  }
+
+
+
+  /**
+   * @brief Registers a handler for a service and subservice
+   *
+   * An already registered handler of the same service and subservice is replaced.
+   *
+   * @param u8_Service      The service ID
+   * @param u8_SubService   The subservice ID (must be lower than PUS_MAX_SUBSERVICES)
+   * @param p_Handler       A pointer to the handler which is called for matching telecommands
+   *
+   * @retval  0   If the handler was registered
+   * @retval -1   If the subservice is out of range, p_Handler is nullptr or the maximum number of services is reached
+   */
+  int32_t TcRegistry::registerHandler(const uint8_t u8_Service, const uint8_t u8_SubService, TcActionInterface *p_Handler)
+  {
+    if(!p_Handler || (u8_SubService>=PUS_MAX_SUBSERVICES))
+      return -1;
+
+    if(mau8_ServiceRow[u8_Service]==NoService)
+    {
+      if(mu8_ServiceCount>=PUS_MAX_SERVICES)
+        return -1;
+      mau8_ServiceRow[u8_Service] = mu8_ServiceCount++;
+    }
+    mapp_Handler[mau8_ServiceRow[u8_Service]][u8_SubService] = p_Handler;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Removes the handler of a service and subservice
+   *
+   * The table row of the service stays assigned, so the service can be registered again later.
+   *
+   * @param u8_Service      The service ID
+   * @param u8_SubService   The subservice ID
+   *
+   * @retval  0   If the handler was removed
+   * @retval -1   If no handler was registered
+   */
+  int32_t TcRegistry::unregisterHandler(const uint8_t u8_Service, const uint8_t u8_SubService)
+  {
+    if((u8_SubService>=PUS_MAX_SUBSERVICES) || (mau8_ServiceRow[u8_Service]==NoService))
+      return -1;
+    if(!mapp_Handler[mau8_ServiceRow[u8_Service]][u8_SubService])
+      return -1;
+
+    mapp_Handler[mau8_ServiceRow[u8_Service]][u8_SubService] = nullptr;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Allows or forbids telecommands of the given source
+   *
+   * @param u8_SourceID   The source ID
+   * @param b_Allowed     true if telecommands of this source shall be dispatched
+   */
+  void TcRegistry::setSourceAllowed(const uint8_t u8_SourceID, const bool b_Allowed)
+  {
+    if(b_Allowed)
+      mau8_SourceFilter[u8_SourceID>>3] |= (uint8_t)(1<<(u8_SourceID&0x7));
+    else
+      mau8_SourceFilter[u8_SourceID>>3] &= (uint8_t)~(1<<(u8_SourceID&0x7));
+  }
+
+
+
+  /**
+   * @brief Allows or forbids telecommands of all sources
+   *
+   * @param b_Allowed     true if telecommands of all sources shall be dispatched
+   */
+  void TcRegistry::setAllSourcesAllowed(const bool b_Allowed)
+  {
+    memset(mau8_SourceFilter, b_Allowed?0xff:0x00, sizeof(mau8_SourceFilter));
+  }
+
+
+
+  /**
+   * @brief Returns if telecommands of the given source are dispatched
+   *
+   * @param u8_SourceID   The source ID
+   *
+   * @return true if the source is allowed
+   */
+  bool TcRegistry::isSourceAllowed(const uint8_t u8_SourceID)
+  {
+    return (mau8_SourceFilter[u8_SourceID>>3]&(1<<(u8_SourceID&0x7)))?true:false;
+  }
+
+
+
+  /**
+   * @brief Returns if a telecommand would be dispatched to a handler
+   *
+   * This allows to verify the acceptance of a telecommand before it is processed, for example to send the
+   * acceptance report (1,1) or (1,2) before the handler is called.
+   *
+   * @param u8_Service      The service ID of the command
+   * @param u8_SubService   The subservice ID of the command
+   * @param u8_SourceID     The source ID of the command
+   * @param pe_FailureCode  If not nullptr, the reason for the rejection is written here
+   *
+   * @return true if the source is allowed and a handler is registered for the service and subservice
+   */
+  bool TcRegistry::isAccepted(const uint8_t u8_Service, const uint8_t u8_SubService, const uint8_t u8_SourceID,
+                              Tc::AcceptanceFailureCode *pe_FailureCode)
+  {
+    Tc::AcceptanceFailureCode e_FailureCode;
+    uint8_t u8_Row = mau8_ServiceRow[u8_Service];
+
+    if(!isSourceAllowed(u8_SourceID))
+      e_FailureCode = Tc::AcceptanceFailureCode::IllegalSource;
+    else if(u8_Row==NoService)
+      e_FailureCode = Tc::AcceptanceFailureCode::IllegalPacketType;
+    else if((u8_SubService>=PUS_MAX_SUBSERVICES) || !mapp_Handler[u8_Row][u8_SubService])
+      e_FailureCode = Tc::AcceptanceFailureCode::IllegalPacketSubType;
+    else
+      return true;
+
+    if(pe_FailureCode)
+      *pe_FailureCode = e_FailureCode;
+    return false;
+  }
+
+
+
+  /**
+   * @brief Checks the acceptance of a telecommand like isAccepted() and counts it if it is rejected
+   *
+   * This is used by the Verification object, which rejects the telecommand before it reaches the registry.
+   *
+   * @param u8_Service      The service ID of the command
+   * @param u8_SubService   The subservice ID of the command
+   * @param u8_SourceID     The source ID of the command
+   * @param pe_FailureCode  If not nullptr, the reason for the rejection is written here
+   *
+   * @return true if the source is allowed and a handler is registered for the service and subservice
+   */
+  bool TcRegistry::checkAcceptance(const uint8_t u8_Service, const uint8_t u8_SubService, const uint8_t u8_SourceID,
+                                   Tc::AcceptanceFailureCode *pe_FailureCode)
+  {
+    if(isAccepted(u8_Service, u8_SubService, u8_SourceID, pe_FailureCode))
+      return true;
+
+    if(mu16_RejectionCount<0xffff)
+      mu16_RejectionCount++;
+    return false;
+  }
+
+
+
+  /**
+   * @brief Returns the number of rejected telecommands
+   *
+   * If the number of rejected telecommands exceeds 65535, the method returns 65535.
+   *
+   * @return Number of rejected telecommands as uint16_t
+   */
+  uint16_t TcRegistry::getRejectionCount(void)
+  {
+    return mu16_RejectionCount;
+  }
+
+
+
+  /**
+   * @brief Clears the rejection counter
+   */
+  void TcRegistry::clearErrorCounters(void)
+  {
+    mu16_RejectionCount = 0;
+    return;
+  }
+
+
+
+  /**
+   * @brief Dispatches a received telecommand to the registered handler
+   *
+   * This method is called by the Tc object; the parameters are the ones of TcActionInterface::onTcReceived().
+   */
+  void TcRegistry::onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                                const uint8_t u8_Service, const uint8_t u8_SubService,
+                                const uint8_t u8_SourceID,
+                                const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    Tc::AcceptanceFailureCode e_FailureCode = Tc::AcceptanceFailureCode::IllegalPacketType;
+
+    if(checkAcceptance(u8_Service, u8_SubService, u8_SourceID, &e_FailureCode))
+    {
+      TcActionInterface *p_Handler = mapp_Handler[mau8_ServiceRow[u8_Service]][u8_SubService];
+      p_Handler->onTcReceived(b_AckAcc, b_AckStart, b_AckProg, b_AckComp,
+                              u8_Service, u8_SubService, u8_SourceID,
+                              pu8_Data, u32_DataSize);
+      return;
+    }
+
+    if(mp_ActionInterface)
+    {
+      mp_ActionInterface->onTcRejected(e_FailureCode,
+                                       b_AckAcc, b_AckStart, b_AckProg, b_AckComp,
+                                       u8_Service, u8_SubService, u8_SourceID,
+                                       pu8_Data, u32_DataSize);
+    }
+  }
+
+}
@@ -0,0 +1,120 @@
+/**
+ * @file      pus_tc_registry.h
+ *
+ * @brief     Include file of the PUS TC registry class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+
+#ifndef _PUS_TC_REGISTRY_H_
+#define _PUS_TC_REGISTRY_H_
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "pus_tc.h"
+
+#ifdef configPUS_MAX_SERVICES
+#define PUS_MAX_SERVICES configPUS_MAX_SERVICES
+#else
+#define PUS_MAX_SERVICES 16
+#endif
+
+#ifdef configPUS_MAX_SUBSERVICES
+#define PUS_MAX_SUBSERVICES configPUS_MAX_SUBSERVICES
+#else
+#define PUS_MAX_SUBSERVICES 32
+#endif
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Interface class for handling rejected telecommands
+   */
+  class TcRegistryActionInterface
+  {
+  public:
+    /**
+     * @brief Declaration of the action which shall be called if a telecommand could not be dispatched
+     *
+     * The implementation of this callback shall handle the rejection, for example by sending a
+     * telecommand acceptance failure report (1,2).
+     *
+     * @param e_FailureCode         The reason for the rejection
+     * @param b_AckAcc              Flag if an Acceptence Report is requested
+     * @param b_AckStart            Flag if an Execution Start Report is requested
+     * @param b_AckProg             Flag if an Execution Progress Report is requested
+     * @param b_AckComp             Flag if an Execution Complete Report is requested
+     * @param u8_Service            The service ID of the command
+     * @param u8_SubService         The Subservice ID of the command
+     * @param u8_SourceID           The source ID of the command
+     * @param pu8_Data              Command data (parameters)
+     * @param u32_DataSize          The size of the command data
+     */
+    virtual void onTcRejected(const Tc::AcceptanceFailureCode e_FailureCode,
+                              const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                              const uint8_t u8_Service, const uint8_t u8_SubService,
+                              const uint8_t u8_SourceID,
+                              const uint8_t *pu8_Data, const uint32_t u32_DataSize) = 0;
+  };
+
+
+
+  /**
+   * @brief Class for dispatching telecommands to the handler of the respective service and subservice.
+   *
+   * The registry implements the TcActionInterface, so it can be set as action interface of a Tc object.
+   * Each received telecommand is forwarded to the handler which was registered for its service and
+   * subservice. The lookup is done with two table accesses: a 256 byte table maps the service to
+   * a row of the handler table, which is then indexed by the subservice.
+   *
+   * Telecommands without a registered handler or from a source which is not allowed are forwarded
+   * to the TcRegistryActionInterface instead.
+   */
+  class TcRegistry : public TcActionInterface
+  {
+  private:
+    const static uint8_t NoService = 0xff;
+    static_assert(PUS_MAX_SERVICES<NoService, "configPUS_MAX_SERVICES must be lower than 255 (0xff marks unused services)");
+
+    uint8_t mau8_ServiceRow[256];
+    uint8_t mu8_ServiceCount;
+    TcActionInterface *mapp_Handler[PUS_MAX_SERVICES][PUS_MAX_SUBSERVICES];
+    uint8_t mau8_SourceFilter[256/8];
+    uint16_t mu16_RejectionCount;
+
+    TcRegistryActionInterface *mp_ActionInterface;
+
+  public:
+    TcRegistry(TcRegistryActionInterface *p_ActionInterface = nullptr);
+
+    void setActionInterface(TcRegistryActionInterface *p_ActionInterface);
+
+    int32_t registerHandler(const uint8_t u8_Service, const uint8_t u8_SubService, TcActionInterface *p_Handler);
+    int32_t unregisterHandler(const uint8_t u8_Service, const uint8_t u8_SubService);
+
+    void setSourceAllowed(const uint8_t u8_SourceID, const bool b_Allowed);
+    void setAllSourcesAllowed(const bool b_Allowed);
+    bool isSourceAllowed(const uint8_t u8_SourceID);
+    bool isAccepted(const uint8_t u8_Service, const uint8_t u8_SubService, const uint8_t u8_SourceID,
+                    Tc::AcceptanceFailureCode *pe_FailureCode = nullptr);
+    bool checkAcceptance(const uint8_t u8_Service, const uint8_t u8_SubService, const uint8_t u8_SourceID,
+                         Tc::AcceptanceFailureCode *pe_FailureCode = nullptr);
+
+    uint16_t getRejectionCount(void);
+    void clearErrorCounters(void);
+
+    void onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                      const uint8_t u8_Service, const uint8_t u8_SubService,
+                      const uint8_t u8_SourceID,
+                      const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+  };
+
+}
+
+#endif // _PUS_TC_REGISTRY_H_
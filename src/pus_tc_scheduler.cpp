@@ -0,0 +1,524 @@
+/**
+ * @file      pus_tc_scheduler.cpp
+ *
+ * @brief     Source file of the PUS TC scheduler class (service 11)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include "pus_tc_scheduler.h"
+
+
+#define SP_HDR_SIZE         6
+#define SP_APID(p)          ((uint16_t)(((p)[0]&0x07)<<8) | (uint16_t)(p)[1])
+#define SP_SEQCOUNT(p)      ((uint16_t)(((p)[2]&0x3f)<<8) | (uint16_t)(p)[3])
+#define SP_SIZE(p)          (((uint32_t)(p)[4]<<8 | (uint32_t)(p)[5])+SP_HDR_SIZE+1)
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Construct a new TcScheduler object
+   *
+   * The schedule is empty and the release is enabled. The wheel is synchronized to the onboard time with the
+   * first call of release().
+   *
+   * @param p_ActionInterface   A pointer to the implementation of the action interface
+   */
+  TcScheduler::TcScheduler(TcSchedulerActionInterface *p_ActionInterface)
+    : mb_ReleaseEnabled{true}
+    , mb_Resync{true}
+    , mu16_Releasing{NoEntry}
+    , mu16_OverflowErrorCount{0}
+    , mp_ActionInterface{p_ActionInterface}
+    , mp_Verification{nullptr}
+  {
+    reset(0);
+  }
+
+
+
+  /**
+   * @brief Sets the action class which is used to call the methods when an action is to be called
+   *
+   * @param p_ActionInterface A pointer to the implementation of the action interface
+   */
+  void TcScheduler::setActionInterface(TcSchedulerActionInterface *p_ActionInterface)
+  {
+    mp_ActionInterface = p_ActionInterface;
+  }
+
+
+
+  /**
+   * @brief Sets the verification service which sends the completion reports of the insert and delete telecommands
+   *
+   * @param p_Verification  A pointer to the verification service, or nullptr to disable the reports
+   */
+  void TcScheduler::setVerification(Verification *p_Verification)
+  {
+    mp_Verification = p_Verification;
+  }
+
+
+
+  /**
+   * @brief Deletes all stored telecommands and sets the current time
+   *
+   * @param u32_CurrentTime   The current onboard time
+   */
+  void TcScheduler::reset(const uint32_t u32_CurrentTime)
+  {
+    for(uint16_t i=0; i<MaxCommands; i++)
+      maS_Entry[i].u16_Next = (i+1<MaxCommands)?(uint16_t)(i+1):NoEntry;
+    memset(mau16_Wheel, 0xff, sizeof(mau16_Wheel));
+    memset(mau16_Hash, 0xff, sizeof(mau16_Hash));
+    mu16_FreeList = 0;
+    mu16_Count = 0;
+    mu16_Releasing = NoEntry;       // a telecommand which is just released is part of the new free list
+    mu32_Time = u32_CurrentTime;
+  }
+
+
+
+  /**
+   * @brief Enables or disables the release of telecommands
+   *
+   * While the release is disabled, due telecommands stay in the schedule. They are released with the
+   * next call of release() after the release is enabled again, which also synchronizes the wheel to the
+   * current time.
+   *
+   * @param b_Enabled   true if the telecommands shall be released
+   */
+  void TcScheduler::setReleaseEnabled(const bool b_Enabled)
+  {
+    if(b_Enabled && !mb_ReleaseEnabled)
+      mb_Resync = true;
+    mb_ReleaseEnabled = b_Enabled;
+  }
+
+
+
+  /**
+   * @brief Inserts a telecommand into the schedule
+   *
+   * The telecommand packet is copied into the internal pool. A release time in the past leads to
+   * a release with the next call of release().
+   *
+   * @param u32_ReleaseTime   The onboard time when the telecommand shall be released
+   * @param pu8_Packet        The complete telecommand space packet
+   * @param u16_PacketSize    The size of the telecommand space packet
+   *
+   * @retval  0   If the telecommand was inserted
+   * @retval -1   If the packet is invalid or too large
+   * @retval -2   If the schedule is full
+   */
+  int32_t TcScheduler::insert(const uint32_t u32_ReleaseTime, const uint8_t *pu8_Packet, const uint16_t u16_PacketSize)
+  {
+    uint16_t u16_Index;
+    uint16_t u16_Hash;
+
+    if(!pu8_Packet || (u16_PacketSize<=SP_HDR_SIZE) || (u16_PacketSize>MaxTcSize))
+      return -1;
+    if(mu16_FreeList==NoEntry)
+    {
+      if(mu16_OverflowErrorCount<0xffff)
+        mu16_OverflowErrorCount++;
+      return -2;
+    }
+
+    u16_Index = mu16_FreeList;
+    mu16_FreeList = maS_Entry[u16_Index].u16_Next;
+
+    maS_Entry[u16_Index].u32_ReleaseTime = u32_ReleaseTime;
+    maS_Entry[u16_Index].u16_PacketSize = u16_PacketSize;
+    memcpy(maS_Entry[u16_Index].au8_Packet, pu8_Packet, u16_PacketSize);
+
+    u16_Hash = _hash(SP_APID(pu8_Packet), SP_SEQCOUNT(pu8_Packet));
+    maS_Entry[u16_Index].u16_HashNext = mau16_Hash[u16_Hash];
+    mau16_Hash[u16_Hash] = u16_Index;
+
+    _link(u16_Index);
+    mu16_Count++;
+    return 0;
+  }
+
+
+
+  /**
+   * @brief Deletes a telecommand from the schedule
+   *
+   * @param u16_APID            The APID of the telecommand
+   * @param u16_SequenceCount   The sequence count of the telecommand
+   *
+   * @retval  0   If the telecommand was deleted
+   * @retval -1   If no matching telecommand was found
+   */
+  int32_t TcScheduler::remove(const uint16_t u16_APID, const uint16_t u16_SequenceCount)
+  {
+    uint16_t u16_Index = mau16_Hash[_hash(u16_APID, u16_SequenceCount)];
+
+    while(u16_Index!=NoEntry)
+    {
+      const uint8_t *pu8_Packet = maS_Entry[u16_Index].au8_Packet;
+      if((SP_APID(pu8_Packet)==(u16_APID&0x7ff)) && (SP_SEQCOUNT(pu8_Packet)==(u16_SequenceCount&0x3fff)))
+      {
+        _unlink(u16_Index);
+        _unhash(u16_Index);
+        _free(u16_Index);
+        return 0;
+      }
+      u16_Index = maS_Entry[u16_Index].u16_HashNext;
+    }
+    return -1;
+  }
+
+
+
+  /**
+   * @brief Releases all telecommands which are due
+   *
+   * For each released telecommand, the action interface is called. The method shall be called periodically;
+   * ticks without a telecommand are skipped, so the effort does not depend on the time since the last call.
+   * Times are compared with wrap-around, so release times must be less than 2^31 ticks in the future.
+   *
+   * A released telecommand is removed from the schedule before the action interface is called, so the
+   * callback may insert or delete telecommands or reset the schedule.
+   *
+   * @param u32_CurrentTime   The current onboard time
+   *
+   * @return The number of released telecommands
+   */
+  uint32_t TcScheduler::release(const uint32_t u32_CurrentTime)
+  {
+    uint32_t u32_Released = 0;
+    uint32_t u32_NextTime;
+    uint16_t u16_Index;
+
+    if(!mb_ReleaseEnabled)
+      return 0;
+
+    // after the construction or a disabled release, the wheel is built again for the current time;
+    // telecommands which became due in the meantime are released in this call
+    if(mb_Resync)
+    {
+      _resync(u32_CurrentTime);
+      mb_Resync = false;
+    }
+
+    while(mu16_Count && ((int32_t)(u32_CurrentTime-mu32_Time)>=0))
+    {
+      u32_NextTime = _getNextSlotTime();
+      if((int32_t)(u32_CurrentTime-u32_NextTime)<0)
+        break;
+      mu32_Time = u32_NextTime;
+
+      // move the telecommands of the higher levels down when the lower level completed a revolution
+      for(uint8_t u8_Level=1; u8_Level<WheelLevels; u8_Level++)
+      {
+        if((mu32_Time>>(WheelBits*(u8_Level-1)))&(WheelSlots-1))
+          break;
+        _cascade(u8_Level);
+      }
+
+      while(NoEntry!=(u16_Index = mau16_Wheel[mu32_Time&(WheelSlots-1)]))
+      {
+        _unlink(u16_Index);
+        _unhash(u16_Index);
+        mu16_Releasing = u16_Index;
+        if(mp_ActionInterface)
+          mp_ActionInterface->onScheduledTcReleased(maS_Entry[u16_Index].u32_ReleaseTime,
+                                                    maS_Entry[u16_Index].au8_Packet, maS_Entry[u16_Index].u16_PacketSize);
+        u32_Released++;
+        if(mu16_Releasing==NoEntry)
+          return u32_Released;          // the schedule was reset by the callback
+        mu16_Releasing = NoEntry;
+        _free(u16_Index);
+      }
+      mu32_Time++;
+    }
+
+    if((int32_t)(u32_CurrentTime-mu32_Time)>=0)
+      mu32_Time = u32_CurrentTime+1;
+    return u32_Released;
+  }
+
+
+
+  /**
+   * @brief Returns the number of stored telecommands
+   *
+   * @return Number of telecommands as uint16_t
+   */
+  uint16_t TcScheduler::getCount(void)
+  {
+    return mu16_Count;
+  }
+
+
+
+  /**
+   * @brief Returns the number of overflow errors
+   *
+   * Overflow errors occur if a telecommand is to be inserted while the schedule is full.
+   *
+   * If the number of overflow errors exceeds 65535, the method returns 65535.
+   *
+   * @return Number of overflow errors as uint16_t
+   */
+  uint16_t TcScheduler::getOverflowErrorCount(void)
+  {
+    return mu16_OverflowErrorCount;
+  }
+
+
+
+  /**
+   * @brief Clears all error counters
+   */
+  void TcScheduler::clearErrorCounters(void)
+  {
+    mu16_OverflowErrorCount = 0;
+    return;
+  }
+
+
+
+  /**
+   * @brief Handles a telecommand of service 11
+   *
+   * This method is called by the Tc object or a TcRegistry; the parameters are the ones of
+   * TcActionInterface::onTcReceived(). The application data of the subservices is:
+   *  - (11,4): N, N times (release time (4 bytes), telecommand packet)
+   *  - (11,5): N, N times (APID (2 bytes), sequence count (2 bytes), number of telecommands (2 bytes))
+   *
+   * Telecommands which can not be inserted or deleted are reported with a completion failure report (1,8)
+   * with the first FailureCode that occurred, if a Verification object is set.
+   */
+  void TcScheduler::onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                                 const uint8_t u8_Service, const uint8_t u8_SubService,
+                                 const uint8_t u8_SourceID,
+                                 const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    int32_t i32_FailureCode;
+
+    (void)b_AckAcc; (void)b_AckStart; (void)b_AckProg; (void)u8_SourceID;
+
+    if(u8_Service!=Tc::OnboardOperationsSchedulingService)
+      return;
+
+    i32_FailureCode = _execute(u8_SubService, pu8_Data, u32_DataSize);
+    if(mp_Verification)
+    {
+      if(i32_FailureCode)
+        mp_Verification->completionFailure(mp_Verification->getRequestID(), (uint8_t)i32_FailureCode);
+      else if(b_AckComp)
+        mp_Verification->completionSuccess(mp_Verification->getRequestID());
+    }
+  }
+
+
+
+  void TcScheduler::_link(const uint16_t u16_Index)
+  {
+    Entry *pS_Entry = &maS_Entry[u16_Index];
+    uint32_t u32_Time = pS_Entry->u32_ReleaseTime;
+    uint32_t u32_Delta;
+    uint8_t u8_Level = 0;
+    uint16_t u16_Slot;
+
+    if((int32_t)(u32_Time-mu32_Time)<0)
+      u32_Time = mu32_Time;
+    u32_Delta = u32_Time-mu32_Time;
+
+    while((u8_Level<WheelLevels-1) && (u32_Delta>>(WheelBits*(u8_Level+1))))
+      u8_Level++;
+    u16_Slot = (uint16_t)(u8_Level*WheelSlots + ((u32_Time>>(WheelBits*u8_Level))&(WheelSlots-1)));
+
+    pS_Entry->u16_Slot = u16_Slot;
+    pS_Entry->u16_Prev = NoEntry;
+    pS_Entry->u16_Next = mau16_Wheel[u16_Slot];
+    if(pS_Entry->u16_Next!=NoEntry)
+      maS_Entry[pS_Entry->u16_Next].u16_Prev = u16_Index;
+    mau16_Wheel[u16_Slot] = u16_Index;
+  }
+
+
+
+  void TcScheduler::_unlink(const uint16_t u16_Index)
+  {
+    Entry *pS_Entry = &maS_Entry[u16_Index];
+
+    if(pS_Entry->u16_Prev!=NoEntry)
+      maS_Entry[pS_Entry->u16_Prev].u16_Next = pS_Entry->u16_Next;
+    else
+      mau16_Wheel[pS_Entry->u16_Slot] = pS_Entry->u16_Next;
+    if(pS_Entry->u16_Next!=NoEntry)
+      maS_Entry[pS_Entry->u16_Next].u16_Prev = pS_Entry->u16_Prev;
+  }
+
+
+
+  void TcScheduler::_cascade(const uint8_t u8_Level)
+  {
+    uint16_t u16_Slot = (uint16_t)(u8_Level*WheelSlots + ((mu32_Time>>(WheelBits*u8_Level))&(WheelSlots-1)));
+    uint16_t u16_Index = mau16_Wheel[u16_Slot];
+
+    mau16_Wheel[u16_Slot] = NoEntry;
+    while(u16_Index!=NoEntry)
+    {
+      uint16_t u16_Next = maS_Entry[u16_Index].u16_Next;
+      _link(u16_Index);
+      u16_Index = u16_Next;
+    }
+  }
+
+
+
+  void TcScheduler::_resync(const uint32_t u32_CurrentTime)
+  {
+    memset(mau16_Wheel, 0xff, sizeof(mau16_Wheel));
+    mu32_Time = u32_CurrentTime;
+
+    // all stored telecommands are in the hash table
+    for(uint16_t i=0; i<MaxCommands; i++)
+      for(uint16_t u16_Index=mau16_Hash[i]; u16_Index!=NoEntry; u16_Index=maS_Entry[u16_Index].u16_HashNext)
+        _link(u16_Index);
+  }
+
+
+
+  uint32_t TcScheduler::_getNextSlotTime(void)
+  {
+    uint32_t u32_Delta = 0xffffffff;
+
+    // for each level, the first occupied slot following the current time is searched; its time is the first
+    // time from now on where the digit of the level is the slot number and all lower digits are 0
+    for(uint8_t u8_Level=0; u8_Level<WheelLevels; u8_Level++)
+    {
+      uint8_t u8_Shift = (uint8_t)(WheelBits*u8_Level);
+      uint32_t u32_Mask = (WheelBits*(u8_Level+1)>=32)?0xffffffffUL:((1UL<<(WheelBits*(u8_Level+1)))-1);
+      uint16_t u16_First = (uint16_t)((mu32_Time>>u8_Shift)&(WheelSlots-1));
+
+      if(mu32_Time&((1UL<<u8_Shift)-1))
+        u16_First++;              // the current slot of this level was already moved down
+      for(uint16_t i=0; i<WheelSlots; i++)
+      {
+        uint16_t u16_Slot = (uint16_t)((u16_First+i)&(WheelSlots-1));
+        if(mau16_Wheel[u8_Level*WheelSlots+u16_Slot]!=NoEntry)
+        {
+          uint32_t u32_SlotDelta = (((uint32_t)u16_Slot<<u8_Shift)-mu32_Time)&u32_Mask;
+          if(u32_SlotDelta<u32_Delta)
+            u32_Delta = u32_SlotDelta;
+          break;
+        }
+      }
+    }
+    return mu32_Time+u32_Delta;
+  }
+
+
+
+  void TcScheduler::_unhash(const uint16_t u16_Index)
+  {
+    const uint8_t *pu8_Packet = maS_Entry[u16_Index].au8_Packet;
+    uint16_t *pu16_Link = &mau16_Hash[_hash(SP_APID(pu8_Packet), SP_SEQCOUNT(pu8_Packet))];
+
+    while(*pu16_Link!=NoEntry)
+    {
+      if(*pu16_Link==u16_Index)
+      {
+        *pu16_Link = maS_Entry[u16_Index].u16_HashNext;
+        break;
+      }
+      pu16_Link = &maS_Entry[*pu16_Link].u16_HashNext;
+    }
+  }
+
+
+
+  void TcScheduler::_free(const uint16_t u16_Index)
+  {
+    maS_Entry[u16_Index].u16_Next = mu16_FreeList;
+    mu16_FreeList = u16_Index;
+    mu16_Count--;
+  }
+
+
+
+  int32_t TcScheduler::_execute(const uint8_t u8_SubService, const uint8_t *pu8_Data, const uint32_t u32_DataSize)
+  {
+    int32_t i32_FailureCode = 0;
+    uint32_t u32_Pos = 1;
+    uint8_t u8_N;
+
+    switch(u8_SubService)
+    {
+      case EnableRelease:
+        setReleaseEnabled(true);
+        break;
+      case DisableRelease:
+        setReleaseEnabled(false);
+        break;
+      case ResetSchedule:
+        reset(mu32_Time);
+        break;
+      case InsertTelecommands:
+        if(!pu8_Data || (u32_DataSize<1))
+          return InvalidRequest;
+        u8_N = pu8_Data[0];
+        for(uint8_t i=0; i<u8_N; i++)
+        {
+          uint32_t u32_ReleaseTime;
+          uint32_t u32_PacketSize;
+          int32_t i32_Result;
+          if(u32_Pos+ReleaseTimeSize+SP_HDR_SIZE>u32_DataSize)
+            return InvalidRequest;
+          u32_ReleaseTime = ((uint32_t)pu8_Data[u32_Pos]<<24) | ((uint32_t)pu8_Data[u32_Pos+1]<<16)
+                          | ((uint32_t)pu8_Data[u32_Pos+2]<<8) | (uint32_t)pu8_Data[u32_Pos+3];
+          u32_Pos += ReleaseTimeSize;
+          u32_PacketSize = SP_SIZE(&pu8_Data[u32_Pos]);
+          if(u32_Pos+u32_PacketSize>u32_DataSize)
+            return InvalidRequest;
+          // the following telecommands are inserted anyway; the first failure is reported
+          i32_Result = insert(u32_ReleaseTime, &pu8_Data[u32_Pos], (uint16_t)u32_PacketSize);
+          if(i32_Result && !i32_FailureCode)
+            i32_FailureCode = (i32_Result==-2)?ScheduleFull:InvalidPacket;
+          u32_Pos += u32_PacketSize;
+        }
+        break;
+      case DeleteTelecommands:
+        if(!pu8_Data || (u32_DataSize<1))
+          return InvalidRequest;
+        u8_N = pu8_Data[0];
+        if(u32_DataSize<1+6UL*u8_N)
+          return InvalidRequest;
+        for(uint8_t i=0; i<u8_N; i++, u32_Pos+=6)
+        {
+          uint16_t u16_APID = (uint16_t)(pu8_Data[u32_Pos]<<8) | pu8_Data[u32_Pos+1];
+          uint16_t u16_SequenceCount = (uint16_t)(pu8_Data[u32_Pos+2]<<8) | pu8_Data[u32_Pos+3];
+          uint16_t u16_Number = (uint16_t)(pu8_Data[u32_Pos+4]<<8) | pu8_Data[u32_Pos+5];
+          for(uint16_t j=0; j<u16_Number; j++)
+            if(remove(u16_APID, (uint16_t)((u16_SequenceCount+j)&0x3fff)) && !i32_FailureCode)
+              i32_FailureCode = UnknownTelecommand;
+        }
+        break;
+      default:
+        break;
+    }
+    return i32_FailureCode;
+  }
+
+
+
+  uint16_t TcScheduler::_hash(const uint16_t u16_APID, const uint16_t u16_SequenceCount)
+  {
+    return (uint16_t)((((uint32_t)(u16_APID&0x7ff)<<14) ^ (uint32_t)(u16_SequenceCount&0x3fff)) % PUS_SCHEDULER_MAX_COMMANDS);
+  }
+
+}
@@ -0,0 +1,192 @@
+/**
+ * @file      pus_tc_scheduler.h
+ *
+ * @brief     Include file of the PUS TC scheduler class (service 11)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+
+#ifndef _PUS_TC_SCHEDULER_H_
+#define _PUS_TC_SCHEDULER_H_
+
+/****************************************************************/
+/* Onboard Operations Scheduling Service according to           */
+/*                                                              */
+/*  ECSS-E-70-41A - Ground systems and operations -             */
+/*                  Telemetry and telecommand packet            */
+/*                  utilization, service 11                     */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - Sub-schedules and interlocks are not supported            */
+/*  - The release time is a 32 bit onboard time (e.g. the       */
+/*    coarse time of CUC) and is transferred in 4 bytes         */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "configCCSDS.h"
+#include "pus_tc.h"
+#include "pus_verification.h"
+
+#ifdef configPUS_SCHEDULER_MAX_COMMANDS
+#define PUS_SCHEDULER_MAX_COMMANDS configPUS_SCHEDULER_MAX_COMMANDS
+#else
+#define PUS_SCHEDULER_MAX_COMMANDS 64
+#endif
+
+#ifdef configPUS_SCHEDULER_MAX_TC_SIZE
+#define PUS_SCHEDULER_MAX_TC_SIZE configPUS_SCHEDULER_MAX_TC_SIZE
+#else
+#define PUS_SCHEDULER_MAX_TC_SIZE 64
+#endif
+
+#ifdef configPUS_SCHEDULER_WHEEL_BITS
+#define PUS_SCHEDULER_WHEEL_BITS configPUS_SCHEDULER_WHEEL_BITS
+#else
+#define PUS_SCHEDULER_WHEEL_BITS 8
+#endif
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Interface class for handling released telecommands
+   */
+  class TcSchedulerActionInterface
+  {
+  public:
+    /**
+     * @brief Declaration of the action which shall be called if the release time of a telecommand is reached
+     *
+     * The implementation of this callback shall forward the telecommand packet to its destination, usually
+     * by processing it with the SpacePacket object of the onboard telecommand path.
+     *
+     * @param u32_ReleaseTime   The release time of the telecommand
+     * @param pu8_Packet        The complete telecommand space packet
+     * @param u16_PacketSize    The size of the telecommand space packet
+     */
+    virtual void onScheduledTcReleased(const uint32_t u32_ReleaseTime,
+                                       const uint8_t *pu8_Packet, const uint16_t u16_PacketSize) = 0;
+  };
+
+
+
+  /**
+   * @brief Class for the onboard scheduling of time-tagged telecommands (PUS service 11).
+   *
+   * The telecommands are stored in a preallocated pool and sorted into a hierarchical timer wheel. Each level
+   * of the wheel has 2^PUS_SCHEDULER_WHEEL_BITS slots; a telecommand is placed in the lowest level which covers
+   * its release time and is moved down one level whenever the lower level completed a revolution. This way,
+   * inserting, deleting and releasing a telecommand does not depend on the number of stored telecommands.
+   * For deleting, the telecommands are also hashed by APID and sequence count.
+   *
+   * The time is a 32 bit onboard time in ticks (for example seconds). The release() method must be called
+   * periodically with the current time and releases all telecommands which are due in one batch. Ticks
+   * without a telecommand or a pending move between the levels are skipped, so the effort of release() does
+   * not depend on the time which passed since the last call. The first call after the construction and after
+   * the release was enabled again synchronizes the wheel to the given time.
+   *
+   * The scheduler implements the TcActionInterface, so it can be registered at a TcRegistry for service 11.
+   * The subservices 1 (enable release), 2 (disable release), 3 (reset), 4 (insert) and 5 (delete) are handled.
+   * If a Verification object is set, the execution of the insert and delete telecommands is confirmed with
+   * completion reports (1,7) and (1,8).
+   */
+  class TcScheduler : public TcActionInterface
+  {
+  public:
+    static const int MaxCommands = PUS_SCHEDULER_MAX_COMMANDS;   /**< Maximum number of stored telecommands */
+    static const int MaxTcSize = PUS_SCHEDULER_MAX_TC_SIZE;      /**< Maximum size of a stored telecommand packet */
+
+    enum SubService
+    {
+      EnableRelease = 1,
+      DisableRelease = 2,
+      ResetSchedule = 3,
+      InsertTelecommands = 4,
+      DeleteTelecommands = 5
+    };
+
+    /** Failure codes of the completion failure reports (1,8) */
+    enum FailureCode
+    {
+      InvalidRequest = 1,     /**< The application data of the telecommand is truncated */
+      InvalidPacket = 2,      /**< A telecommand to be inserted is invalid or larger than PUS_SCHEDULER_MAX_TC_SIZE */
+      ScheduleFull = 3,       /**< A telecommand could not be inserted because the schedule is full */
+      UnknownTelecommand = 4  /**< A telecommand to be deleted is not in the schedule */
+    };
+
+  private:
+    const static uint16_t NoEntry = 0xffff;
+    static_assert(PUS_SCHEDULER_MAX_COMMANDS<NoEntry, "configPUS_SCHEDULER_MAX_COMMANDS must be below 65535, the index 0xffff marks an unused entry");
+    const static uint8_t WheelBits = PUS_SCHEDULER_WHEEL_BITS;
+    const static uint16_t WheelSlots = (1<<PUS_SCHEDULER_WHEEL_BITS);
+    const static uint8_t WheelLevels = (32+PUS_SCHEDULER_WHEEL_BITS-1)/PUS_SCHEDULER_WHEEL_BITS;
+    const static uint8_t ReleaseTimeSize = 4;
+
+    struct Entry
+    {
+      uint32_t u32_ReleaseTime;
+      uint16_t u16_Next;        // next entry within the wheel slot or the free list
+      uint16_t u16_Prev;        // previous entry within the wheel slot
+      uint16_t u16_Slot;        // slot of the wheel (level*WheelSlots+slot)
+      uint16_t u16_HashNext;    // next entry with the same hash
+      uint16_t u16_PacketSize;
+      uint8_t au8_Packet[PUS_SCHEDULER_MAX_TC_SIZE];
+    };
+
+    Entry maS_Entry[PUS_SCHEDULER_MAX_COMMANDS];
+    uint16_t mau16_Wheel[WheelLevels*WheelSlots];
+    uint16_t mau16_Hash[PUS_SCHEDULER_MAX_COMMANDS];
+    uint16_t mu16_FreeList;
+    uint16_t mu16_Count;
+    uint32_t mu32_Time;
+    bool mb_ReleaseEnabled;
+    bool mb_Resync;
+    uint16_t mu16_Releasing;
+    uint16_t mu16_OverflowErrorCount;
+
+    TcSchedulerActionInterface *mp_ActionInterface;
+    Verification *mp_Verification;
+
+  public:
+    TcScheduler(TcSchedulerActionInterface *p_ActionInterface = nullptr);
+
+    void setActionInterface(TcSchedulerActionInterface *p_ActionInterface);
+    void setVerification(Verification *p_Verification);
+
+    void reset(const uint32_t u32_CurrentTime);
+    void setReleaseEnabled(const bool b_Enabled);
+
+    int32_t insert(const uint32_t u32_ReleaseTime, const uint8_t *pu8_Packet, const uint16_t u16_PacketSize);
+    int32_t remove(const uint16_t u16_APID, const uint16_t u16_SequenceCount);
+    uint32_t release(const uint32_t u32_CurrentTime);
+
+    uint16_t getCount(void);
+    uint16_t getOverflowErrorCount(void);
+    void clearErrorCounters(void);
+
+    void onTcReceived(const bool b_AckAcc, const bool b_AckStart, const bool b_AckProg, const bool b_AckComp,
+                      const uint8_t u8_Service, const uint8_t u8_SubService,
+                      const uint8_t u8_SourceID,
+                      const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+
+  private:
+    void _link(const uint16_t u16_Index);
+    void _unlink(const uint16_t u16_Index);
+    void _cascade(const uint8_t u8_Level);
+    void _resync(const uint32_t u32_CurrentTime);
+    uint32_t _getNextSlotTime(void);
+    void _unhash(const uint16_t u16_Index);
+    void _free(const uint16_t u16_Index);
+    int32_t _execute(const uint8_t u8_SubService, const uint8_t *pu8_Data, const uint32_t u32_DataSize);
+    static uint16_t _hash(const uint16_t u16_APID, const uint16_t u16_SequenceCount);
+  };
+
+}
+
+#endif // _PUS_TC_SCHEDULER_H_
@@ -0,0 +1,78 @@
+/**
+ * @file      pus_tm.cpp
+ *
+ * @brief     Source file of the PUS TM class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include "pus_tm.h"
+#include "ccsds_spacepacket.h"
+
+
+#define DATA_FIELD_HDR_VERSION_POS    0
+#define  DFH_PUS_VERSION_POS      4
+#define DATA_FIELD_HDR_SERVICE_POS    1
+#define DATA_FIELD_HDR_SUBSERVICE_POS 2
+
+
+namespace PUS 
+{
+  
+  /**
+   * @brief Writes the data field header of a telemetry packet into the given buffer
+   *
+   * @param pu8_Buffer      A pointer to the buffer where the header shall be stored
+   * @param u32_BufferSize  The available size of the buffer (at least SecHdrSize)
+   * @param u8_Service      The service ID of the report
+   * @param u8_SubService   The Subservice ID of the report
+   *
+   * @retval 0  No header could be created
+   * @return The size of the created header
+   */
+  uint32_t Tm::createSecondaryHeader(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                     const uint8_t u8_Service, const uint8_t u8_SubService)
+  {
+    if(!pu8_Buffer || (u32_BufferSize<SecHdrSize))
+      return 0;
+    
+    pu8_Buffer[DATA_FIELD_HDR_VERSION_POS] = (uint8_t)((PacketVersion&0x7)<<DFH_PUS_VERSION_POS);
+    pu8_Buffer[DATA_FIELD_HDR_SERVICE_POS] = u8_Service;
+    pu8_Buffer[DATA_FIELD_HDR_SUBSERVICE_POS] = u8_SubService;
+    
+    return SecHdrSize;
+  }
+  
+  
+  
+  /**
+   * @brief Creates a complete telemetry space packet and writes it into the given buffer
+   *
+   * @param pu8_Buffer          A pointer to the buffer where the packet shall be stored
+   * @param u32_BufferSize      The available size of the buffer
+   * @param u16_APID            The application identifier (APID) of the source application
+   * @param u16_SequenceCount   The 14-bit sequence counter, handled by the calling context
+   * @param u8_Service          The service ID of the report
+   * @param u8_SubService       The Subservice ID of the report
+   * @param pu8_Data            The report data
+   * @param u16_DataSize        The size of the report data
+   *
+   * @retval 0  No packet could be created
+   * @return The size of the created packet in bytes as uint32_t
+   */
+  uint32_t Tm::createPacket(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                            const uint16_t u16_APID, const uint16_t u16_SequenceCount,
+                            const uint8_t u8_Service, const uint8_t u8_SubService,
+                            const uint8_t *pu8_Data, const uint16_t u16_DataSize)
+  {
+    uint8_t au8_SecHdr[SecHdrSize];
+    
+    createSecondaryHeader(au8_SecHdr, SecHdrSize, u8_Service, u8_SubService);
+    return CCSDS::SpacePacket::create(pu8_Buffer, u32_BufferSize,
+                                      CCSDS::SpacePacket::TM, CCSDS::SpacePacket::Unsegmented, u16_APID, u16_SequenceCount,
+                                      au8_SecHdr, SecHdrSize, pu8_Data, u16_DataSize);
+  }
+  
+}
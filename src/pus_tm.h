@@ -0,0 +1,58 @@
+/**
+ * @file      pus_tm.h
+ *
+ * @brief     Include file of the PUS TM class
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+
+#ifndef _PUS_TM_H_
+#define _PUS_TM_H_
+
+/****************************************************************/
+/* PUS TM Packet according to                                   */
+/*                                                              */
+/*  ECSS-E-70-41A - Space Packet Protocol                       */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - The optional fields of the data field header (packet      */
+/*    subcounter, destination ID, time) are not supported       */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#define PUS_TM_SEC_HEADER_SIZE  3
+
+
+namespace PUS 
+{
+
+  /**
+   * @brief Class for creating telemetry packets as described in the Packet Utilization Standard (PUS), ECSS-E-70-41A.
+   *
+   * The data field header of a telemetry packet holds the service and subservice of the report. The packets
+   * are created with the primary header of SpacePacket.
+   */
+  class Tm
+  {
+    const static uint8_t PacketVersion = 1;
+    
+  public:
+    const static uint8_t SecHdrSize = PUS_TM_SEC_HEADER_SIZE;
+    
+    static uint32_t createSecondaryHeader(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                          const uint8_t u8_Service, const uint8_t u8_SubService);
+    
+    static uint32_t createPacket(uint8_t *pu8_Buffer, const uint32_t u32_BufferSize,
+                                 const uint16_t u16_APID, const uint16_t u16_SequenceCount,
+                                 const uint8_t u8_Service, const uint8_t u8_SubService,
+                                 const uint8_t *pu8_Data, const uint16_t u16_DataSize);
+  };
+  
+}
+
+#endif // _PUS_TM_H_
@@ -0,0 +1,270 @@
+/**
+ * @file      pus_verification.cpp
+ *
+ * @brief     Source file of the PUS telecommand verification class (service 1)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+#include "pus_verification.h"
+#include "ccsds_spacepacket.h"
+
+
+#define REPORT_REQUEST_ID_POS   (SP_HEADER_SIZE+PUS_TM_SEC_HEADER_SIZE)
+#define REPORT_PARAMETER_POS    (REPORT_REQUEST_ID_POS+RequestIdSize)
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Construct a new Verification object and prepares the report templates
+   *
+   * @param u16_APID            The APID of the verification reports
+   * @param p_ActionInterface   A pointer to the implementation of the action interface which sends the reports
+   */
+  Verification::Verification(const uint16_t u16_APID, VerificationActionInterface *p_ActionInterface)
+    : mu16_SequenceCount{0}
+    , mu32_RequestID{0}
+    , mp_Registry{nullptr}
+    , mp_ActionInterface{p_ActionInterface}
+  {
+    // number of bytes behind the request ID: failure code and/or step number
+    static const uint8_t au8_ParameterSize[ReportCount] = {0, 1, 0, 1, 1, 2, 0, 1};
+
+    for(uint8_t i=0; i<ReportCount; i++)
+    {
+      mau8_TemplateSize[i] = (uint8_t)(REPORT_PARAMETER_POS+au8_ParameterSize[i]);
+      CCSDS::SpacePacket::createPrimaryHeader(maau8_Template[i], CCSDS::SpacePacket::TM, CCSDS::SpacePacket::Unsegmented,
+                                              u16_APID, 0, true, mau8_TemplateSize[i]-SP_HEADER_SIZE);
+      Tm::createSecondaryHeader(&maau8_Template[i][SP_HEADER_SIZE], Tm::SecHdrSize,
+                                Tc::TelecommandVerificationService, (uint8_t)(i+1));
+      for(uint8_t j=REPORT_REQUEST_ID_POS; j<MaxTemplateSize; j++)
+        maau8_Template[i][j] = 0;
+    }
+  }
+
+
+
+  /**
+   * @brief Sets the action class which is used to send the reports
+   *
+   * @param p_ActionInterface A pointer to the implementation of the action interface
+   */
+  void Verification::setActionInterface(VerificationActionInterface *p_ActionInterface)
+  {
+    mp_ActionInterface = p_ActionInterface;
+  }
+
+
+
+  /**
+   * @brief Sets the registry which is used to check the service, subservice and source of a telecommand
+   *
+   * @param p_Registry  A pointer to the registry which dispatches the telecommands, or nullptr
+   */
+  void Verification::setRegistry(TcRegistry *p_Registry)
+  {
+    mp_Registry = p_Registry;
+  }
+
+
+
+  /**
+   * @brief Verifies the acceptance of a valid telecommand and sends the acceptance report
+   *
+   * This method is called by the Tc object after the length and the PEC of the telecommand were verified.
+   * If a registry is set and rejects the telecommand, the rejection is counted by the registry and an
+   * acceptance failure report (1,2) is sent; otherwise an acceptance success report (1,1) is sent if it was
+   * requested. The request ID of the telecommand is stored and can be read with getRequestID().
+   *
+   * @param pu8_PrimaryHeader   The primary header of the telecommand; if nullptr, the request ID is 0
+   * @param b_AckAcc            Flag if an Acceptence Report is requested
+   * @param u8_Service          The service ID of the command
+   * @param u8_SubService       The Subservice ID of the command
+   * @param u8_SourceID         The source ID of the command
+   *
+   * @return true if the telecommand was accepted and shall be executed
+   */
+  bool Verification::accept(const uint8_t *pu8_PrimaryHeader, const bool b_AckAcc,
+                            const uint8_t u8_Service, const uint8_t u8_SubService, const uint8_t u8_SourceID)
+  {
+    Tc::AcceptanceFailureCode e_FailureCode;
+
+    mu32_RequestID = _getRequestID(pu8_PrimaryHeader);
+
+    if(mp_Registry && !mp_Registry->checkAcceptance(u8_Service, u8_SubService, u8_SourceID, &e_FailureCode))
+    {
+      _send(AcceptanceFailure, mu32_RequestID, (uint8_t)e_FailureCode);
+      return false;
+    }
+    if(b_AckAcc)
+      _send(AcceptanceSuccess, mu32_RequestID);
+    return true;
+  }
+
+
+
+  /**
+   * @brief Sends an acceptance failure report (1,2)
+   *
+   * This method is called by the Tc object if the length or the PEC of a telecommand is wrong.
+   *
+   * @param pu8_PrimaryHeader   The primary header of the telecommand; if nullptr, the request ID is 0
+   * @param e_FailureCode       The reason for the rejection
+   */
+  void Verification::reject(const uint8_t *pu8_PrimaryHeader, const Tc::AcceptanceFailureCode e_FailureCode)
+  {
+    _send(AcceptanceFailure, _getRequestID(pu8_PrimaryHeader), (uint8_t)e_FailureCode);
+  }
+
+
+
+  /**
+   * @brief Returns the request ID of the last accepted telecommand
+   *
+   * The request ID consists of the packet ID (upper 16 bits) and the packet sequence control (lower 16 bits)
+   * of the telecommand. It is valid while the telecommand is handled by the action interface of the Tc object
+   * and shall be stored by the application for the execution reports.
+   *
+   * @return The request ID as uint32_t
+   */
+  uint32_t Verification::getRequestID(void)
+  {
+    return mu32_RequestID;
+  }
+
+
+
+  /**
+   * @brief Sends an execution start success report (1,3)
+   *
+   * @param u32_RequestID   The request ID of the telecommand
+   *
+   * @retval  0   If the report was sent
+   * @retval -1   If no action interface is set
+   */
+  int32_t Verification::startSuccess(const uint32_t u32_RequestID)
+  {
+    return _send(StartSuccess, u32_RequestID);
+  }
+
+
+
+  /**
+   * @brief Sends an execution start failure report (1,4)
+   *
+   * @param u32_RequestID   The request ID of the telecommand
+   * @param u8_FailureCode  The mission specific failure code
+   *
+   * @retval  0   If the report was sent
+   * @retval -1   If no action interface is set
+   */
+  int32_t Verification::startFailure(const uint32_t u32_RequestID, const uint8_t u8_FailureCode)
+  {
+    return _send(StartFailure, u32_RequestID, u8_FailureCode);
+  }
+
+
+
+  /**
+   * @brief Sends an execution progress success report (1,5)
+   *
+   * @param u32_RequestID   The request ID of the telecommand
+   * @param u8_StepNumber   The number of the completed step
+   *
+   * @retval  0   If the report was sent
+   * @retval -1   If no action interface is set
+   */
+  int32_t Verification::progressSuccess(const uint32_t u32_RequestID, const uint8_t u8_StepNumber)
+  {
+    return _send(ProgressSuccess, u32_RequestID, u8_StepNumber);
+  }
+
+
+
+  /**
+   * @brief Sends an execution progress failure report (1,6)
+   *
+   * @param u32_RequestID   The request ID of the telecommand
+   * @param u8_StepNumber   The number of the failed step
+   * @param u8_FailureCode  The mission specific failure code
+   *
+   * @retval  0   If the report was sent
+   * @retval -1   If no action interface is set
+   */
+  int32_t Verification::progressFailure(const uint32_t u32_RequestID, const uint8_t u8_StepNumber, const uint8_t u8_FailureCode)
+  {
+    return _send(ProgressFailure, u32_RequestID, u8_StepNumber, u8_FailureCode);
+  }
+
+
+
+  /**
+   * @brief Sends an execution completion success report (1,7)
+   *
+   * @param u32_RequestID   The request ID of the telecommand
+   *
+   * @retval  0   If the report was sent
+   * @retval -1   If no action interface is set
+   */
+  int32_t Verification::completionSuccess(const uint32_t u32_RequestID)
+  {
+    return _send(CompletionSuccess, u32_RequestID);
+  }
+
+
+
+  /**
+   * @brief Sends an execution completion failure report (1,8)
+   *
+   * @param u32_RequestID   The request ID of the telecommand
+   * @param u8_FailureCode  The mission specific failure code
+   *
+   * @retval  0   If the report was sent
+   * @retval -1   If no action interface is set
+   */
+  int32_t Verification::completionFailure(const uint32_t u32_RequestID, const uint8_t u8_FailureCode)
+  {
+    return _send(CompletionFailure, u32_RequestID, u8_FailureCode);
+  }
+
+
+
+  int32_t Verification::_send(const enum SubService e_SubService, const uint32_t u32_RequestID,
+                              const uint8_t u8_First, const uint8_t u8_Second)
+  {
+    uint8_t *pu8_Report = maau8_Template[e_SubService-1];
+
+    if(!mp_ActionInterface)
+      return -1;
+
+    // only the variable fields of the template are written
+    pu8_Report[2] = (uint8_t)((pu8_Report[2]&0xc0)|((mu16_SequenceCount>>8)&0x3f));
+    pu8_Report[3] = (uint8_t)(mu16_SequenceCount&0xff);
+    mu16_SequenceCount = (uint16_t)((mu16_SequenceCount+1)&0x3fff);
+
+    pu8_Report[REPORT_REQUEST_ID_POS] = (uint8_t)(u32_RequestID>>24);
+    pu8_Report[REPORT_REQUEST_ID_POS+1] = (uint8_t)(u32_RequestID>>16);
+    pu8_Report[REPORT_REQUEST_ID_POS+2] = (uint8_t)(u32_RequestID>>8);
+    pu8_Report[REPORT_REQUEST_ID_POS+3] = (uint8_t)u32_RequestID;
+    pu8_Report[REPORT_PARAMETER_POS] = u8_First;
+    pu8_Report[REPORT_PARAMETER_POS+1] = u8_Second;
+
+    mp_ActionInterface->onVerificationReport(pu8_Report, mau8_TemplateSize[e_SubService-1]);
+    return 0;
+  }
+
+
+
+  uint32_t Verification::_getRequestID(const uint8_t *pu8_PrimaryHeader)
+  {
+    if(!pu8_PrimaryHeader)
+      return 0;
+    return ((uint32_t)pu8_PrimaryHeader[0]<<24) | ((uint32_t)pu8_PrimaryHeader[1]<<16)
+         | ((uint32_t)pu8_PrimaryHeader[2]<<8) | (uint32_t)pu8_PrimaryHeader[3];
+  }
+
+}
@@ -0,0 +1,133 @@
+/**
+ * @file      pus_verification.h
+ *
+ * @brief     Include file of the PUS telecommand verification class (service 1)
+ *
+ * @author    Stefan Trippler
+ *
+ * @copyright Copyright (C) 2021-2023 Stefan Trippler.  All rights reserved.
+ */
+
+
+#ifndef _PUS_VERIFICATION_H_
+#define _PUS_VERIFICATION_H_
+
+/****************************************************************/
+/* Telecommand Verification Service according to                */
+/*                                                              */
+/*  ECSS-E-70-41A - Ground systems and operations -             */
+/*                  Telemetry and telecommand packet            */
+/*                  utilization, service 1                      */
+/*                                                              */
+/* Limitations:                                                 */
+/*  - The failure code and the step number are 8 bit values;    */
+/*    failure reports carry no additional parameters            */
+/*                                                              */
+/****************************************************************/
+
+#include <inttypes.h>
+
+#include "pus_tc.h"
+#include "pus_tm.h"
+#include "pus_tc_registry.h"
+
+
+namespace PUS
+{
+
+  /**
+   * @brief Interface class for sending verification reports
+   */
+  class VerificationActionInterface
+  {
+  public:
+    /**
+     * @brief Declaration of the action which shall be called if a verification report was created
+     *
+     * The implementation of this callback shall send the report to ground. The report is only valid
+     * during the call and has to be copied if it is sent later.
+     *
+     * @param pu8_Packet        The complete report space packet
+     * @param u16_PacketSize    The size of the packet in bytes
+     */
+    virtual void onVerificationReport(const uint8_t *pu8_Packet, const uint16_t u16_PacketSize) = 0;
+  };
+
+
+
+  /**
+   * @brief Class for generating telecommand verification reports (PUS service 1).
+   *
+   * The reports of all subservices are prepared once as templates (space packet primary header, data field
+   * header and the fixed size report data). To send a report, only the sequence count, the request ID of the
+   * telecommand and the failure code or step number are written into the template before it is handed to the
+   * VerificationActionInterface.
+   *
+   * If the object is set at a Tc object with Tc::setVerification(), the acceptance reports are created by
+   * the Tc object itself, directly after the packet was validated and before the telecommand is forwarded to
+   * the application: telecommands with a wrong length or Packet Error Control (PEC) are answered with an
+   * acceptance failure report (1,2), valid telecommands with an acceptance success report (1,1) if requested.
+   * If a TcRegistry is given, the telecommands are checked against the registered handlers and allowed
+   * sources as part of the acceptance, so rejected telecommands are answered with (1,2) and are not
+   * forwarded.
+   *
+   * The execution reports (start, progress and completion) are created by the application with the request ID
+   * which can be read with getRequestID() while the telecommand is handled. Success reports shall only be
+   * created if they were requested by the acknowledge flags of the telecommand; failure reports are always
+   * created.
+   */
+  class Verification
+  {
+  public:
+    enum SubService
+    {
+      AcceptanceSuccess = 1,
+      AcceptanceFailure = 2,
+      StartSuccess = 3,
+      StartFailure = 4,
+      ProgressSuccess = 5,
+      ProgressFailure = 6,
+      CompletionSuccess = 7,
+      CompletionFailure = 8
+    };
+
+  private:
+    const static uint8_t RequestIdSize = 4;
+    const static uint8_t ReportCount = 8;
+    const static uint8_t MaxTemplateSize = 6+PUS_TM_SEC_HEADER_SIZE+RequestIdSize+2;
+
+    uint16_t mu16_SequenceCount;
+    uint32_t mu32_RequestID;
+    uint8_t mau8_TemplateSize[ReportCount];
+    uint8_t maau8_Template[ReportCount][MaxTemplateSize];
+
+    TcRegistry *mp_Registry;
+    VerificationActionInterface *mp_ActionInterface;
+
+  public:
+    Verification(const uint16_t u16_APID, VerificationActionInterface *p_ActionInterface = nullptr);
+
+    void setActionInterface(VerificationActionInterface *p_ActionInterface);
+    void setRegistry(TcRegistry *p_Registry);
+
+    bool accept(const uint8_t *pu8_PrimaryHeader, const bool b_AckAcc,
+                const uint8_t u8_Service, const uint8_t u8_SubService, const uint8_t u8_SourceID);
+    void reject(const uint8_t *pu8_PrimaryHeader, const Tc::AcceptanceFailureCode e_FailureCode);
+    uint32_t getRequestID(void);
+
+    int32_t startSuccess(const uint32_t u32_RequestID);
+    int32_t startFailure(const uint32_t u32_RequestID, const uint8_t u8_FailureCode);
+    int32_t progressSuccess(const uint32_t u32_RequestID, const uint8_t u8_StepNumber);
+    int32_t progressFailure(const uint32_t u32_RequestID, const uint8_t u8_StepNumber, const uint8_t u8_FailureCode);
+    int32_t completionSuccess(const uint32_t u32_RequestID);
+    int32_t completionFailure(const uint32_t u32_RequestID, const uint8_t u8_FailureCode);
+
+  private:
+    int32_t _send(const enum SubService e_SubService, const uint32_t u32_RequestID,
+                  const uint8_t u8_First = 0, const uint8_t u8_Second = 0);
+    static uint32_t _getRequestID(const uint8_t *pu8_PrimaryHeader);
+  };
+
+}
+
+#endif // _PUS_VERIFICATION_H_